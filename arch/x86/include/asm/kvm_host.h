@@ -1018,6 +1018,8 @@ struct kvm_vcpu_arch {
 	} pv_eoi;
 
 	u64 msr_kvm_poll_control;
+	/* the last halt ended with the LAPIC timer pending */
+	bool halt_woken_by_timer;
 
 	/* pv related host specific info */
 	struct {
@@ -1630,6 +1632,7 @@ struct kvm_vcpu_stat {
 	u64 preemption_other;
 	u64 guest_mode;
 	u64 notify_window_exits;
+	u64 halt_poll_skipped_timer;
 };
 
 struct x86_instruction_info;
@@ -2100,6 +2100,21 @@ bool kvm_lapic_hv_timer_in_use(struct kvm_vcpu *vcpu)
 	return vcpu->arch.apic->lapic_timer.hv_timer_in_use;
 }
 
+/* Time until the software timer fires, KTIME_MAX if it is not armed. */
+ktime_t kvm_lapic_sw_timer_remaining(struct kvm_vcpu *vcpu)
+{
+	struct kvm_timer *ktimer;
+
+	if (!lapic_in_kernel(vcpu))
+		return KTIME_MAX;
+
+	ktimer = &vcpu->arch.apic->lapic_timer;
+	if (ktimer->hv_timer_in_use || !hrtimer_active(&ktimer->timer))
+		return KTIME_MAX;
+
+	return hrtimer_get_remaining(&ktimer->timer);
+}
+
 static void cancel_hv_timer(struct kvm_lapic *apic)
 {
 	WARN_ON(preemptible());
@@ -6785,11 +6785,8 @@ void kvm_mmu_slot_remove_write_access(struct kvm *kvm,
 		write_unlock(&kvm->mmu_lock);
 	}
 
-	if (tdp_mmu_enabled) {
-		read_lock(&kvm->mmu_lock);
+	if (tdp_mmu_enabled)
 		kvm_tdp_mmu_wrprot_slot(kvm, memslot, start_level);
-		read_unlock(&kvm->mmu_lock);
-	}
 }
 
 static inline bool need_topup(struct kvm_mmu_memory_cache *cache, int min)
@@ -7130,11 +7127,8 @@ void kvm_mmu_recover_huge_pages(struct kvm *kvm,
 		write_unlock(&kvm->mmu_lock);
 	}
 
-	if (tdp_mmu_enabled) {
-		read_lock(&kvm->mmu_lock);
+	if (tdp_mmu_enabled)
 		kvm_tdp_mmu_recover_huge_pages(kvm, slot);
-		read_unlock(&kvm->mmu_lock);
-	}
 }
 
 void kvm_mmu_slot_leaf_clear_dirty(struct kvm *kvm,
@@ -7150,11 +7144,8 @@ void kvm_mmu_slot_leaf_clear_dirty(struct kvm *kvm,
 		write_unlock(&kvm->mmu_lock);
 	}
 
-	if (tdp_mmu_enabled) {
-		read_lock(&kvm->mmu_lock);
+	if (tdp_mmu_enabled)
 		kvm_tdp_mmu_clear_dirty_slot(kvm, memslot);
-		read_unlock(&kvm->mmu_lock);
-	}
 
 	/*
 	 * The caller will flush the TLBs after this function returns.
@@ -1455,23 +1455,136 @@ static bool wrprot_gfn_range(struct kvm *kvm, struct kvm_mmu_page *root,
 }
 
 /*
- * Remove write access from all the SPTEs mapping GFNs in the memslot. Will
- * only affect leaf SPTEs down to min_level.
- * Returns true if an SPTE has been changed and the TLBs need to be flushed.
+ * Write-protecting, clearing the dirty bits of or recovering the huge pages
+ * of a whole memslot only needs mmu_lock for read, so the slots of large
+ * VMs, where a single walk takes seconds, are split in chunks that are
+ * walked in parallel.
  */
-bool kvm_tdp_mmu_wrprot_slot(struct kvm *kvm,
-			     const struct kvm_memory_slot *slot, int min_level)
+#define TDP_MMU_SLOT_WALK_CHUNK	(KVM_PAGES_PER_HPAGE(PG_LEVEL_1G) * 64)
+#define TDP_MMU_SLOT_WALK_MAX	16
+
+enum tdp_mmu_slot_op {
+	TDP_MMU_SLOT_WRPROT,
+	TDP_MMU_SLOT_CLEAR_DIRTY,
+	TDP_MMU_SLOT_RECOVER_HUGE,
+};
+
+struct tdp_mmu_slot_walk {
+	struct work_struct work;
+	struct kvm *kvm;
+	const struct kvm_memory_slot *slot;
+	enum tdp_mmu_slot_op op;
+	gfn_t start;
+	gfn_t end;
+	int min_level;
+	bool spte_set;
+};
+
+static void clear_dirty_gfn_range(struct kvm *kvm, struct kvm_mmu_page *root,
+				  gfn_t start, gfn_t end);
+static void recover_huge_pages_range(struct kvm *kvm,
+				     struct kvm_mmu_page *root,
+				     const struct kvm_memory_slot *slot,
+				     gfn_t start, gfn_t end);
+
+static void tdp_mmu_walk_slot_range(struct tdp_mmu_slot_walk *w)
 {
+	struct kvm *kvm = w->kvm;
 	struct kvm_mmu_page *root;
-	bool spte_set = false;
 
-	lockdep_assert_held_read(&kvm->mmu_lock);
+	read_lock(&kvm->mmu_lock);
+	for_each_valid_tdp_mmu_root_yield_safe(kvm, root, w->slot->as_id) {
+		switch (w->op) {
+		case TDP_MMU_SLOT_WRPROT:
+			w->spte_set |= wrprot_gfn_range(kvm, root, w->start,
+							w->end, w->min_level);
+			break;
+		case TDP_MMU_SLOT_CLEAR_DIRTY:
+			clear_dirty_gfn_range(kvm, root, w->start, w->end);
+			break;
+		case TDP_MMU_SLOT_RECOVER_HUGE:
+			recover_huge_pages_range(kvm, root, w->slot, w->start,
+						 w->end);
+			break;
+		}
+	}
+	read_unlock(&kvm->mmu_lock);
+}
 
-	for_each_valid_tdp_mmu_root_yield_safe(kvm, root, slot->as_id)
-		spte_set |= wrprot_gfn_range(kvm, root, slot->base_gfn,
-			     slot->base_gfn + slot->npages, min_level);
+static void tdp_mmu_walk_slot_work(struct work_struct *work)
+{
+	tdp_mmu_walk_slot_range(container_of(work, struct tdp_mmu_slot_walk,
+					     work));
+}
 
+static bool tdp_mmu_walk_slot(struct kvm *kvm,
+			      const struct kvm_memory_slot *slot,
+			      enum tdp_mmu_slot_op op, int min_level)
+{
+	struct tdp_mmu_slot_walk whole = {
+		.kvm = kvm,
+		.slot = slot,
+		.op = op,
+		.start = slot->base_gfn,
+		.end = slot->base_gfn + slot->npages,
+		.min_level = min_level,
+	};
+	struct tdp_mmu_slot_walk *w;
+	unsigned long chunk;
+	bool spte_set;
+	int nr, i;
+
+	nr = min3(slot->npages / TDP_MMU_SLOT_WALK_CHUNK,
+		  (unsigned long)TDP_MMU_SLOT_WALK_MAX,
+		  (unsigned long)num_online_cpus());
+	if (nr < 2)
+		goto serial;
+
+	w = kcalloc(nr, sizeof(*w), GFP_KERNEL_ACCOUNT);
+	if (!w)
+		goto serial;
+
+	/* chunk boundaries are 1GiB aligned so no huge SPTE straddles two */
+	chunk = round_up(DIV_ROUND_UP(slot->npages, nr),
+			 KVM_PAGES_PER_HPAGE(PG_LEVEL_1G));
+	nr = DIV_ROUND_UP(slot->npages, chunk);
+	for (i = 0; i < nr; i++) {
+		w[i] = whole;
+		if (i)
+			w[i].start = w[i - 1].end;
+		w[i].end = min(ALIGN(whole.start + (i + 1) * chunk,
+				     KVM_PAGES_PER_HPAGE(PG_LEVEL_1G)),
+			       whole.end);
+		if (i) {
+			INIT_WORK(&w[i].work, tdp_mmu_walk_slot_work);
+			queue_work(system_unbound_wq, &w[i].work);
+		}
+	}
+
+	tdp_mmu_walk_slot_range(&w[0]);
+	spte_set = w[0].spte_set;
+	for (i = 1; i < nr; i++) {
+		flush_work(&w[i].work);
+		spte_set |= w[i].spte_set;
+	}
+
+	kfree(w);
 	return spte_set;
+
+serial:
+	tdp_mmu_walk_slot_range(&whole);
+	return whole.spte_set;
+}
+
+/*
+ * Remove write access from all the SPTEs mapping GFNs in the memslot. Will
+ * only affect leaf SPTEs down to min_level.  Takes mmu_lock for read.
+ * Returns true if an SPTE has been changed and the TLBs need to be flushed.
+ */
+bool kvm_tdp_mmu_wrprot_slot(struct kvm *kvm,
+			     const struct kvm_memory_slot *slot, int min_level)
+{
+	return tdp_mmu_walk_slot(kvm, slot, TDP_MMU_SLOT_WRPROT, min_level);
 }
 
 static struct kvm_mmu_page *tdp_mmu_alloc_sp_for_split(void)
@@ -1673,17 +1786,12 @@ static void clear_dirty_gfn_range(struct kvm *kvm, struct kvm_mmu_page *root,
 
 /*
  * Clear the dirty status (D-bit or W-bit) of all the SPTEs mapping GFNs in the
- * memslot.
+ * memslot.  Takes mmu_lock for read.
  */
 void kvm_tdp_mmu_clear_dirty_slot(struct kvm *kvm,
 				  const struct kvm_memory_slot *slot)
 {
-	struct kvm_mmu_page *root;
-
-	lockdep_assert_held_read(&kvm->mmu_lock);
-	for_each_valid_tdp_mmu_root_yield_safe(kvm, root, slot->as_id)
-		clear_dirty_gfn_range(kvm, root, slot->base_gfn,
-				      slot->base_gfn + slot->npages);
+	tdp_mmu_walk_slot(kvm, slot, TDP_MMU_SLOT_CLEAR_DIRTY, 0);
 }
 
 static void clear_dirty_pt_masked(struct kvm *kvm, struct kvm_mmu_page *root,
@@ -1768,12 +1876,12 @@ static int tdp_mmu_make_huge_spte(struct kvm *kvm,
 	return -ENOENT;
 }
 
+/* Recover huge pages for the GFNs in [start, end) of the slot. */
 static void recover_huge_pages_range(struct kvm *kvm,
 				     struct kvm_mmu_page *root,
-				     const struct kvm_memory_slot *slot)
+				     const struct kvm_memory_slot *slot,
+				     gfn_t start, gfn_t end)
 {
-	gfn_t start = slot->base_gfn;
-	gfn_t end = start + slot->npages;
 	struct tdp_iter iter;
 	int max_mapping_level;
 	bool flush = false;
@@ -1830,24 +1938,21 @@ static void recover_huge_pages_range(struct kvm *kvm,
 		flush = true;
 	}
 
+	/* before the page tables replaced above can be freed */
 	if (flush)
-		kvm_flush_remote_tlbs_memslot(kvm, slot);
+		kvm_flush_remote_tlbs_range(kvm, start, end - start);
 
 	rcu_read_unlock();
 }
 
 /*
  * Recover huge page mappings within the slot by replacing non-leaf SPTEs with
- * huge SPTEs where possible.
+ * huge SPTEs where possible.  Takes mmu_lock for read.
  */
 void kvm_tdp_mmu_recover_huge_pages(struct kvm *kvm,
 				    const struct kvm_memory_slot *slot)
 {
-	struct kvm_mmu_page *root;
-
-	lockdep_assert_held_read(&kvm->mmu_lock);
-	for_each_valid_tdp_mmu_root_yield_safe(kvm, root, slot->as_id)
-		recover_huge_pages_range(kvm, root, slot);
+	tdp_mmu_walk_slot(kvm, slot, TDP_MMU_SLOT_RECOVER_HUGE, 0);
 }
 
 /*
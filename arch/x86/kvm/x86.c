@@ -289,6 +289,7 @@ const struct _kvm_stats_desc kvm_vcpu_stats_desc[] = {
 	STATS_DESC_COUNTER(VCPU, preemption_other),
 	STATS_DESC_IBOOLEAN(VCPU, guest_mode),
 	STATS_DESC_COUNTER(VCPU, notify_window_exits),
+	STATS_DESC_COUNTER(VCPU, halt_poll_skipped_timer),
 };
 
 const struct kvm_stats_header kvm_vcpu_stats_header = {
@@ -11204,10 +11205,13 @@ static inline int vcpu_block(struct kvm_vcpu *vcpu)
 			kvm_lapic_switch_to_sw_timer(vcpu);
 
 		kvm_vcpu_srcu_read_unlock(vcpu);
-		if (vcpu->arch.mp_state == KVM_MP_STATE_HALTED)
+		if (vcpu->arch.mp_state == KVM_MP_STATE_HALTED) {
 			kvm_vcpu_halt(vcpu);
-		else
+			vcpu->arch.halt_woken_by_timer =
+				kvm_cpu_has_pending_timer(vcpu);
+		} else {
 			kvm_vcpu_block(vcpu);
+		}
 		kvm_vcpu_srcu_read_lock(vcpu);
 
 		if (hv_timer)
@@ -13625,7 +13629,26 @@ bool kvm_vector_hashing_enabled(void)
 
 bool kvm_arch_no_poll(struct kvm_vcpu *vcpu)
 {
-	return (vcpu->arch.msr_kvm_poll_control & 1) == 0;
+	ktime_t remaining;
+
+	if ((vcpu->arch.msr_kvm_poll_control & 1) == 0)
+		return true;
+
+	/*
+	 * A vCPU whose last halt was ended by its own timer, and whose timer
+	 * is armed but not due within the polling window, is most likely
+	 * waiting for that timer again; polling would only burn host CPU.
+	 * Polling comes back after the first wakeup by anything else.
+	 */
+	if (!vcpu->arch.halt_woken_by_timer || !vcpu->halt_poll_ns)
+		return false;
+
+	remaining = kvm_lapic_sw_timer_remaining(vcpu);
+	if (remaining == KTIME_MAX || remaining <= vcpu->halt_poll_ns)
+		return false;
+
+	++vcpu->stat.halt_poll_skipped_timer;
+	return true;
 }
 EXPORT_SYMBOL_GPL(kvm_arch_no_poll);
 
@@ -1202,6 +1202,29 @@ static void flush_tlb_func(void *info)
 			nr_invalidate);
 }
 
+/*
+ * Has @cpu already flushed the mm of @info up to its generation, through
+ * a concurrent flush of the same mm or a context switch?  Then the IPI
+ * would find nothing to do.  Flushers of one mm racing each other, as in
+ * munmap() storms of a multi-threaded process, thereby mostly share the
+ * IPIs of whoever got to a CPU first.
+ */
+static bool tlb_gen_caught_up(int cpu, struct flush_tlb_info *info)
+{
+	struct tlb_state *ts = per_cpu_ptr(&cpu_tlbstate, cpu);
+	u16 asid;
+
+	if (!info->mm || READ_ONCE(ts->loaded_mm) != info->mm)
+		return false;
+
+	asid = READ_ONCE(ts->loaded_mm_asid);
+	if (asid >= TLB_NR_DYN_ASIDS ||
+	    READ_ONCE(ts->ctxs[asid].ctx_id) != info->mm->context.ctx_id)
+		return false;
+
+	return READ_ONCE(ts->ctxs[asid].tlb_gen) >= info->new_tlb_gen;
+}
+
 static bool should_flush_tlb(int cpu, void *data)
 {
 	struct flush_tlb_info *info = data;
@@ -1216,7 +1239,7 @@ static bool should_flush_tlb(int cpu, void *data)
 
 	/* The target mm is loaded, and the CPU is not lazy. */
 	if (per_cpu(cpu_tlbstate.loaded_mm, cpu) == info->mm)
-		return true;
+		return !tlb_gen_caught_up(cpu, info);
 
 	/* In cpumask, but not the loaded mm? Periodically remove by flushing. */
 	if (info->trim_cpumask)
@@ -1225,6 +1248,12 @@ static bool should_flush_tlb(int cpu, void *data)
 	return false;
 }
 
+/* Freed page tables must be flushed from lazy CPUs too. */
+static bool should_flush_tlb_tables(int cpu, void *data)
+{
+	return !tlb_gen_caught_up(cpu, data);
+}
+
 static bool should_trim_cpumask(struct mm_struct *mm)
 {
 	if (time_after(jiffies, READ_ONCE(mm->context.next_trim_cpumask))) {
@@ -1262,8 +1291,11 @@ STATIC_NOPV void native_flush_tlb_multi(const struct cpumask *cpumask,
 	 * up on the new contents of what used to be page tables, while
 	 * doing a speculative memory access.
 	 */
-	if (info->freed_tables || mm_in_asid_transition(info->mm))
+	if (mm_in_asid_transition(info->mm))
 		on_each_cpu_mask(cpumask, flush_tlb_func, (void *)info, true);
+	else if (info->freed_tables)
+		on_each_cpu_cond_mask(should_flush_tlb_tables, flush_tlb_func,
+				      (void *)info, 1, cpumask);
 	else
 		on_each_cpu_cond_mask(should_flush_tlb, flush_tlb_func,
 				(void *)info, 1, cpumask);
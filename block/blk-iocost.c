@@ -537,6 +537,8 @@ struct ioc_gq {
 
 	/* statistics */
 	struct iocg_pcpu_stat __percpu	*pcpu_stat;
+	/* flushes left that must walk pcpu_stat */
+	int				usage_pending;
 	struct iocg_stat		stat;
 	struct iocg_stat		last_stat;
 	u64				last_stat_abs_vusage;
@@ -714,17 +716,35 @@ static u64 cost_to_abs_cost(u64 cost, u32 hw_inuse)
 	return DIV64_U64_ROUND_UP(cost * hw_inuse, WEIGHT_ONE);
 }
 
-static void iocg_commit_bio(struct ioc_gq *iocg, struct bio *bio,
-			    u64 abs_cost, u64 cost)
+static void iocg_charge_usage(struct ioc_gq *iocg, u64 abs_cost)
 {
 	struct iocg_pcpu_stat *gcs;
 
-	bio->bi_iocost_cost = cost;
-	atomic64_add(cost, &iocg->vtime);
-
 	gcs = get_cpu_ptr(iocg->pcpu_stat);
 	local64_add(abs_cost, &gcs->abs_vusage);
 	put_cpu_ptr(gcs);
+
+	/*
+	 * Let the period timer skip the per-cpu walk for iocgs which didn't
+	 * issue anything. Only the first charge in a period writes the flag.
+	 *
+	 * There's no barrier between the add above and the read of the flag,
+	 * so a charge which sees the flag still armed while the flush is
+	 * clearing it may not be visible to that flush's walk. Arming for two
+	 * flushes makes the following period walk the counters once more and
+	 * pick it up, instead of leaving it until the iocg is charged again.
+	 */
+	if (READ_ONCE(iocg->usage_pending) != 2)
+		WRITE_ONCE(iocg->usage_pending, 2);
+}
+
+static void iocg_commit_bio(struct ioc_gq *iocg, struct bio *bio,
+			    u64 abs_cost, u64 cost)
+{
+	bio->bi_iocost_cost = cost;
+	atomic64_add(cost, &iocg->vtime);
+
+	iocg_charge_usage(iocg, abs_cost);
 }
 
 static void iocg_lock(struct ioc_gq *iocg, bool lock_ioc, unsigned long *flags)
@@ -1418,8 +1438,6 @@ static bool iocg_kick_delay(struct ioc_gq *iocg, struct ioc_now *now)
 static void iocg_incur_debt(struct ioc_gq *iocg, u64 abs_cost,
 			    struct ioc_now *now)
 {
-	struct iocg_pcpu_stat *gcs;
-
 	lockdep_assert_held(&iocg->ioc->lock);
 	lockdep_assert_held(&iocg->waitq.lock);
 	WARN_ON_ONCE(list_empty(&iocg->active_list));
@@ -1435,9 +1453,7 @@ static void iocg_incur_debt(struct ioc_gq *iocg, u64 abs_cost,
 
 	iocg->abs_vdebt += abs_cost;
 
-	gcs = get_cpu_ptr(iocg->pcpu_stat);
-	local64_add(abs_cost, &gcs->abs_vusage);
-	put_cpu_ptr(gcs);
+	iocg_charge_usage(iocg, abs_cost);
 }
 
 static void iocg_pay_debt(struct ioc_gq *iocg, u64 abs_vpay,
@@ -1705,10 +1721,20 @@ static void iocg_flush_stat_leaf(struct ioc_gq *iocg, struct ioc_now *now)
 	struct ioc *ioc = iocg->ioc;
 	u64 abs_vusage = 0;
 	u64 vusage_delta;
-	int cpu;
+	int pending, cpu;
 
 	lockdep_assert_held(&iocg->ioc->lock);
 
+	iocg->usage_delta_us = 0;
+	pending = READ_ONCE(iocg->usage_pending);
+	if (!pending)
+		goto out;
+
+	/* a charge may re-arm the flag meanwhile, don't overwrite it */
+	cmpxchg(&iocg->usage_pending, pending, pending - 1);
+	/* order the update before reading counters, see iocg_charge_usage() */
+	smp_mb();
+
 	/* collect per-cpu counters */
 	for_each_possible_cpu(cpu) {
 		abs_vusage += local64_read(
@@ -1719,7 +1745,7 @@ static void iocg_flush_stat_leaf(struct ioc_gq *iocg, struct ioc_now *now)
 
 	iocg->usage_delta_us = div64_u64(vusage_delta, ioc->vtime_base_rate);
 	iocg->stat.usage_us += iocg->usage_delta_us;
-
+out:
 	iocg_flush_stat_upward(iocg);
 }
 
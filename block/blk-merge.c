@@ -300,6 +300,48 @@ static unsigned int bio_split_alignment(struct bio *bio,
 	return lim->logical_block_size;
 }
 
+/*
+ * Fast path for bios built from page aligned buffers that haven't been
+ * advanced yet, e.g. direct IO to aligned user memory: every bvec starts at
+ * a page boundary and all but the last end at one, so as long as the virt
+ * boundary is no larger than a page there can't be any SG gaps and the bio
+ * fits if each bvec fits into a single segment.
+ */
+static bool bio_split_rw_fast(struct bio *bio, const struct queue_limits *lim,
+		unsigned *segs, unsigned max_bytes)
+{
+	struct bio_vec *bv = bio->bi_io_vec, *last = bv + bio->bi_vcnt - 1;
+	unsigned bytes = 0;
+
+	if (!bio->bi_vcnt || bio_flagged(bio, BIO_CLONED) ||
+	    bio->bi_iter.bi_idx || bio->bi_iter.bi_bvec_done)
+		return false;
+	if (bio->bi_vcnt > lim->max_segments ||
+	    bio->bi_iter.bi_size > max_bytes)
+		return false;
+	/* page aligned bvecs can still leave gaps for a larger virt boundary */
+	if (lim->virt_boundary_mask & PAGE_MASK)
+		return false;
+
+	for (; bv <= last; bv++) {
+		phys_addr_t start = bvec_phys(bv);
+
+		if (offset_in_page(bv->bv_offset) ||
+		    (bv != last && offset_in_page(bv->bv_len)) ||
+		    bv->bv_len > lim->max_segment_size ||
+		    ((start ^ (start + bv->bv_len - 1)) & ~lim->seg_boundary_mask))
+			return false;
+		bytes += bv->bv_len;
+	}
+
+	/* the bio may have been truncated */
+	if (bytes != bio->bi_iter.bi_size)
+		return false;
+
+	*segs = bio->bi_vcnt;
+	return true;
+}
+
 /**
  * bio_split_rw_at - check if and where to split a read/write bio
  * @bio:  [in] bio to be split
@@ -319,6 +361,9 @@ int bio_split_rw_at(struct bio *bio, const struct queue_limits *lim,
 	struct bvec_iter iter;
 	unsigned nsegs = 0, bytes = 0;
 
+	if (bio_split_rw_fast(bio, lim, segs, max_bytes))
+		return 0;
+
 	bio_for_each_bvec(bv, bio, iter) {
 		/*
 		 * If the queue doesn't support SG gaps and adding this
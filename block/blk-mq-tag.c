@@ -14,6 +14,147 @@
 #include "blk-mq.h"
 #include "blk-mq-sched.h"
 
+/*
+ * Per-cpu cache of free normal tags. Tags in here are still set in the
+ * sbitmap, so they are invisible to other allocators until drained. Grows
+ * by taking a batch from one sbitmap word when empty, gives half back when
+ * full, and is drained completely whenever an allocation has to wait.
+ */
+#define BLK_MQ_TAG_CACHE_SIZE	16
+
+struct blk_mq_tag_cache {
+	spinlock_t lock;
+	unsigned int nr;
+	int tags[BLK_MQ_TAG_CACHE_SIZE];
+} ____cacheline_aligned_in_smp;
+
+static unsigned int blk_mq_tag_cache_max(unsigned int depth)
+{
+	/* leave at least half of the tags in the shared bitmap */
+	return min_t(unsigned int, BLK_MQ_TAG_CACHE_SIZE,
+		     depth / (2 * num_possible_cpus()));
+}
+
+static int blk_mq_tag_cache_alloc(struct blk_mq_tags *tags, unsigned int depth,
+		unsigned int flags)
+{
+	int cpu;
+
+	if (!(flags & BLK_MQ_F_TAG_CACHE) || (flags & BLK_MQ_F_TAG_RR))
+		return 0;
+	tags->cache_max = blk_mq_tag_cache_max(depth);
+	if (tags->cache_max < 2)
+		return 0;
+
+	tags->cache = alloc_percpu(struct blk_mq_tag_cache);
+	if (!tags->cache)
+		return -ENOMEM;
+	for_each_possible_cpu(cpu)
+		spin_lock_init(&per_cpu_ptr(tags->cache, cpu)->lock);
+	return 0;
+}
+
+/*
+ * Fair sharing between multiple active queues needs every allocation to go
+ * through the bitmap, leave the cache alone once the tags are contended.
+ */
+static inline bool blk_mq_tag_use_cache(struct blk_mq_tags *tags)
+{
+	return tags->cache && READ_ONCE(tags->active_queues) <= 1;
+}
+
+static int blk_mq_tag_cache_get(struct blk_mq_tags *tags,
+		struct sbitmap_queue *bt)
+{
+	struct blk_mq_tag_cache *cache = raw_cpu_ptr(tags->cache);
+	unsigned long flags, mask;
+	unsigned int offset;
+	int tag = BLK_MQ_NO_TAG;
+
+	spin_lock_irqsave(&cache->lock, flags);
+	if (cache->nr) {
+		tag = cache->tags[--cache->nr] - tags->nr_reserved_tags;
+		goto out;
+	}
+
+	mask = __sbitmap_queue_get_batch(bt, tags->cache_max / 2 + 1, &offset);
+	if (!mask)
+		goto out;
+	tag = offset + __ffs(mask);
+	mask &= mask - 1;
+	while (mask) {
+		cache->tags[cache->nr++] = offset + __ffs(mask) +
+					   tags->nr_reserved_tags;
+		mask &= mask - 1;
+	}
+out:
+	spin_unlock_irqrestore(&cache->lock, flags);
+	return tag;
+}
+
+static bool blk_mq_tag_cache_put(struct blk_mq_tags *tags, unsigned int tag)
+{
+	struct blk_mq_tag_cache *cache;
+	unsigned long flags;
+
+	/* somebody is waiting for a tag, wake them through the sbitmap */
+	if (atomic_read(&tags->bitmap_tags.ws_active))
+		return false;
+
+	cache = raw_cpu_ptr(tags->cache);
+	spin_lock_irqsave(&cache->lock, flags);
+	if (cache->nr >= tags->cache_max) {
+		unsigned int nr = DIV_ROUND_UP(cache->nr, 2);
+
+		cache->nr -= nr;
+		sbitmap_queue_clear_batch(&tags->bitmap_tags,
+				tags->nr_reserved_tags,
+				&cache->tags[cache->nr], nr);
+	}
+	cache->tags[cache->nr++] = tag;
+	spin_unlock_irqrestore(&cache->lock, flags);
+	return true;
+}
+
+/*
+ * Return all cached tags to the sbitmap, either because an allocation is
+ * about to sleep, or because the caller needs the bitmap to reflect which
+ * tags are really in use.
+ */
+void blk_mq_tag_cache_drain(struct blk_mq_tags *tags)
+{
+	int cpu;
+
+	if (!tags->cache)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		struct blk_mq_tag_cache *cache = per_cpu_ptr(tags->cache, cpu);
+		unsigned long flags;
+
+		if (!READ_ONCE(cache->nr))
+			continue;
+		spin_lock_irqsave(&cache->lock, flags);
+		sbitmap_queue_clear_batch(&tags->bitmap_tags,
+				tags->nr_reserved_tags, cache->tags, cache->nr);
+		cache->nr = 0;
+		spin_unlock_irqrestore(&cache->lock, flags);
+	}
+}
+
+/*
+ * Called with the queue frozen, so nothing can refill the caches while the
+ * bitmap is resized. Cached tags may be beyond the new depth.
+ */
+static void blk_mq_tag_cache_resize(struct blk_mq_tags *tags,
+		unsigned int depth)
+{
+	if (!tags->cache)
+		return;
+	blk_mq_tag_cache_drain(tags);
+	tags->cache_max = max(blk_mq_tag_cache_max(depth), 1U);
+}
+
 /*
  * Recalculate wakeup batch when tag is shared by hctx.
  */
@@ -106,14 +247,21 @@ void __blk_mq_tag_idle(struct blk_mq_hw_ctx *hctx)
 static int __blk_mq_get_tag(struct blk_mq_alloc_data *data,
 			    struct sbitmap_queue *bt)
 {
+	struct blk_mq_tags *tags = blk_mq_tags_from_data(data);
+
 	if (!data->q->elevator && !(data->flags & BLK_MQ_REQ_RESERVED) &&
 			!hctx_may_queue(data->hctx, bt))
 		return BLK_MQ_NO_TAG;
 
 	if (data->shallow_depth)
 		return sbitmap_queue_get_shallow(bt, data->shallow_depth);
-	else
-		return __sbitmap_queue_get(bt);
+	if (bt == &tags->bitmap_tags && blk_mq_tag_use_cache(tags)) {
+		int tag = blk_mq_tag_cache_get(tags, bt);
+
+		if (tag != BLK_MQ_NO_TAG)
+			return tag;
+	}
+	return __sbitmap_queue_get(bt);
 }
 
 unsigned long blk_mq_get_tags(struct blk_mq_alloc_data *data, int nr_tags,
@@ -170,6 +318,10 @@ unsigned int blk_mq_get_tag(struct blk_mq_alloc_data *data)
 		 */
 		blk_mq_run_hw_queue(data->hctx, false);
 
+		/* take back whatever other CPUs are sitting on */
+		if (bt == &tags->bitmap_tags)
+			blk_mq_tag_cache_drain(tags);
+
 		/*
 		 * Retry tag allocation after running the hardware queue,
 		 * as running the queue may also have found completions.
@@ -229,6 +381,8 @@ void blk_mq_put_tag(struct blk_mq_tags *tags, struct blk_mq_ctx *ctx,
 		const int real_tag = tag - tags->nr_reserved_tags;
 
 		BUG_ON(real_tag >= tags->nr_tags);
+		if (blk_mq_tag_use_cache(tags) && blk_mq_tag_cache_put(tags, tag))
+			return;
 		sbitmap_queue_clear(&tags->bitmap_tags, real_tag, ctx->cpu);
 	} else {
 		sbitmap_queue_clear(&tags->breserved_tags, tag, ctx->cpu);
@@ -566,9 +720,13 @@ struct blk_mq_tags *blk_mq_init_tags(unsigned int total_tags,
 		goto out_free_tags;
 	if (bt_alloc(&tags->breserved_tags, reserved_tags, round_robin, node))
 		goto out_free_bitmap_tags;
+	if (blk_mq_tag_cache_alloc(tags, depth, flags))
+		goto out_free_reserved_tags;
 
 	return tags;
 
+out_free_reserved_tags:
+	sbitmap_queue_free(&tags->breserved_tags);
 out_free_bitmap_tags:
 	sbitmap_queue_free(&tags->bitmap_tags);
 out_free_tags:
@@ -578,6 +736,7 @@ struct blk_mq_tags *blk_mq_init_tags(unsigned int total_tags,
 
 void blk_mq_free_tags(struct blk_mq_tags *tags)
 {
+	free_percpu(tags->cache);
 	sbitmap_queue_free(&tags->bitmap_tags);
 	sbitmap_queue_free(&tags->breserved_tags);
 	kfree(tags);
@@ -628,6 +787,7 @@ int blk_mq_tag_update_depth(struct blk_mq_hw_ctx *hctx,
 		 * Don't need (or can't) update reserved tags here, they
 		 * remain static and should never need resizing.
 		 */
+		blk_mq_tag_cache_resize(tags, tdepth - tags->nr_reserved_tags);
 		sbitmap_queue_resize(&tags->bitmap_tags,
 				tdepth - tags->nr_reserved_tags);
 	}
@@ -639,11 +799,14 @@ void blk_mq_tag_resize_shared_tags(struct blk_mq_tag_set *set, unsigned int size
 {
 	struct blk_mq_tags *tags = set->shared_tags;
 
+	blk_mq_tag_cache_resize(tags, size - set->reserved_tags);
 	sbitmap_queue_resize(&tags->bitmap_tags, size - set->reserved_tags);
 }
 
 void blk_mq_tag_update_sched_shared_tags(struct request_queue *q)
 {
+	blk_mq_tag_cache_resize(q->sched_shared_tags,
+			q->nr_requests - q->tag_set->reserved_tags);
 	sbitmap_queue_resize(&q->sched_shared_tags->bitmap_tags,
 			     q->nr_requests - q->tag_set->reserved_tags);
 }
@@ -3623,6 +3623,8 @@ static bool blk_mq_hctx_has_requests(struct blk_mq_hw_ctx *hctx)
 		.hctx	= hctx,
 	};
 
+	/* cached free tags are still set in the bitmap */
+	blk_mq_tag_cache_drain(tags);
 	blk_mq_all_tag_iter(tags, blk_mq_has_request, &data);
 	return data.has_rq;
 }
@@ -175,6 +175,7 @@ int blk_mq_tag_update_depth(struct blk_mq_hw_ctx *hctx,
 void blk_mq_tag_resize_shared_tags(struct blk_mq_tag_set *set,
 		unsigned int size);
 void blk_mq_tag_update_sched_shared_tags(struct request_queue *q);
+void blk_mq_tag_cache_drain(struct blk_mq_tags *tags);
 
 void blk_mq_tag_wakeup_all(struct blk_mq_tags *tags, bool);
 void blk_mq_queue_tag_busy_iter(struct request_queue *q, busy_tag_iter_fn *fn,
@@ -359,8 +359,22 @@ struct bio *bio_split_zone_append(struct bio *bio,
 static inline bool bio_may_need_split(struct bio *bio,
 		const struct queue_limits *lim)
 {
-	if (lim->chunk_sectors)
-		return true;
+	if (lim->chunk_sectors) {
+		unsigned int pbs = lim->physical_block_size >> SECTOR_SHIFT;
+
+		/*
+		 * A chunk size that isn't a multiple of the physical block size
+		 * or an atomic write may further restrict the IO size, leave
+		 * those to bio_split_rw().
+		 */
+		if ((lim->chunk_sectors & (pbs - 1)) ||
+		    (bio->bi_opf & REQ_ATOMIC))
+			return true;
+		if (bio_sectors(bio) >
+		    blk_boundary_sectors_left(bio->bi_iter.bi_sector,
+					      lim->chunk_sectors))
+			return true;
+	}
 	if (bio->bi_vcnt != 1)
 		return true;
 	return bio->bi_io_vec->bv_len + bio->bi_io_vec->bv_offset >
@@ -102,6 +102,17 @@ struct deadline_data {
 	int prio_aging_expire;
 
 	spinlock_t lock;
+
+	/*
+	 * Inserted requests are staged here and only sorted into the
+	 * per-priority structures at dispatch time, so that submitters
+	 * don't contend with dispatch on ->lock.
+	 */
+	struct {
+		spinlock_t lock;
+		struct list_head at_head;
+		struct list_head at_tail;
+	} insert ____cacheline_aligned_in_smp;
 };
 
 /* Maps an I/O priority class to a deadline scheduler priority. */
@@ -451,6 +462,9 @@ static struct request *dd_dispatch_prio_aged_requests(struct deadline_data *dd,
 	return NULL;
 }
 
+static void dd_insert_staged(struct blk_mq_hw_ctx *hctx,
+			     struct list_head *free);
+
 /*
  * Called from blk_mq_run_hw_queue() -> __blk_mq_sched_dispatch_requests().
  *
@@ -465,8 +479,10 @@ static struct request *dd_dispatch_request(struct blk_mq_hw_ctx *hctx)
 	const unsigned long now = jiffies;
 	struct request *rq;
 	enum dd_prio prio;
+	LIST_HEAD(free);
 
 	spin_lock(&dd->lock);
+	dd_insert_staged(hctx, &free);
 	rq = dd_dispatch_prio_aged_requests(dd, now);
 	if (rq)
 		goto unlock;
@@ -484,6 +500,7 @@ static struct request *dd_dispatch_request(struct blk_mq_hw_ctx *hctx)
 unlock:
 	spin_unlock(&dd->lock);
 
+	blk_mq_free_requests(&free);
 	return rq;
 }
 
@@ -544,6 +561,9 @@ static void dd_exit_sched(struct elevator_queue *e)
 	struct deadline_data *dd = e->elevator_data;
 	enum dd_prio prio;
 
+	WARN_ON_ONCE(!list_empty(&dd->insert.at_head));
+	WARN_ON_ONCE(!list_empty(&dd->insert.at_tail));
+
 	for (prio = 0; prio <= DD_PRIO_MAX; prio++) {
 		struct dd_per_prio *per_prio = &dd->per_prio[prio];
 		const struct io_stats_per_prio *stats = &per_prio->stats;
@@ -602,6 +622,9 @@ static int dd_init_sched(struct request_queue *q, struct elevator_type *e)
 	dd->fifo_batch = fifo_batch;
 	dd->prio_aging_expire = prio_aging_expire;
 	spin_lock_init(&dd->lock);
+	spin_lock_init(&dd->insert.lock);
+	INIT_LIST_HEAD(&dd->insert.at_head);
+	INIT_LIST_HEAD(&dd->insert.at_tail);
 
 	/* We dispatch from request queue wide instead of hw queue */
 	blk_queue_flag_set(QUEUE_FLAG_SQ_SCHED, q);
@@ -714,6 +737,45 @@ static void dd_insert_request(struct blk_mq_hw_ctx *hctx, struct request *rq,
 	}
 }
 
+static void dd_insert_list(struct blk_mq_hw_ctx *hctx, struct list_head *list,
+			   blk_insert_t flags, struct list_head *free)
+{
+	while (!list_empty(list)) {
+		struct request *rq;
+
+		rq = list_first_entry(list, struct request, queuelist);
+		list_del_init(&rq->queuelist);
+		dd_insert_request(hctx, rq, flags, free);
+	}
+}
+
+/*
+ * Move staged requests into the sort and FIFO structures. Called with
+ * ->lock held before every dispatch decision, the FIFO expiry times are
+ * set here, which is at most one dispatch later than at submission.
+ */
+static void dd_insert_staged(struct blk_mq_hw_ctx *hctx,
+			     struct list_head *free)
+{
+	struct deadline_data *dd = hctx->queue->elevator->elevator_data;
+	LIST_HEAD(at_head);
+	LIST_HEAD(at_tail);
+
+	lockdep_assert_held(&dd->lock);
+
+	if (list_empty_careful(&dd->insert.at_head) &&
+	    list_empty_careful(&dd->insert.at_tail))
+		return;
+
+	spin_lock(&dd->insert.lock);
+	list_splice_init(&dd->insert.at_head, &at_head);
+	list_splice_init(&dd->insert.at_tail, &at_tail);
+	spin_unlock(&dd->insert.lock);
+
+	dd_insert_list(hctx, &at_head, BLK_MQ_INSERT_AT_HEAD, free);
+	dd_insert_list(hctx, &at_tail, 0, free);
+}
+
 /*
  * Called from blk_mq_insert_request() or blk_mq_dispatch_plug_list().
  */
@@ -723,19 +785,18 @@ static void dd_insert_requests(struct blk_mq_hw_ctx *hctx,
 {
 	struct request_queue *q = hctx->queue;
 	struct deadline_data *dd = q->elevator->elevator_data;
-	LIST_HEAD(free);
 
-	spin_lock(&dd->lock);
-	while (!list_empty(list)) {
-		struct request *rq;
-
-		rq = list_first_entry(list, struct request, queuelist);
-		list_del_init(&rq->queuelist);
-		dd_insert_request(hctx, rq, flags, &free);
-	}
-	spin_unlock(&dd->lock);
-
-	blk_mq_free_requests(&free);
+	/*
+	 * Both lists keep submission order; dd_insert_request() adding each
+	 * staged head request to the front of ->dispatch then yields the
+	 * same order as inserting them directly did.
+	 */
+	spin_lock(&dd->insert.lock);
+	if (flags & BLK_MQ_INSERT_AT_HEAD)
+		list_splice_tail_init(list, &dd->insert.at_head);
+	else
+		list_splice_tail_init(list, &dd->insert.at_tail);
+	spin_unlock(&dd->insert.lock);
 }
 
 /* Callback from inside blk_mq_rq_ctx_init(). */
@@ -772,6 +833,10 @@ static bool dd_has_work(struct blk_mq_hw_ctx *hctx)
 	struct deadline_data *dd = hctx->queue->elevator->elevator_data;
 	enum dd_prio prio;
 
+	if (!list_empty_careful(&dd->insert.at_head) ||
+	    !list_empty_careful(&dd->insert.at_tail))
+		return true;
+
 	for (prio = 0; prio <= DD_PRIO_MAX; prio++)
 		if (dd_has_work_for_prio(&dd->per_prio[prio]))
 			return true;
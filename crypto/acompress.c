@@ -16,6 +16,7 @@
 #include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/string.h>
+#include <linux/workqueue.h>
 #include <net/netlink.h>
 
 #include "compress.h"
@@ -341,6 +342,82 @@ static void acomp_reqchain_done(void *data, int err)
 	compl(data, err);
 }
 
+struct acomp_req_batch {
+	atomic_t pending;
+	struct completion done;
+};
+
+/*
+ * Chains may be compressed from reclaim, e.g. by zswap on swap writeout,
+ * so their requests need a workqueue with a rescuer.
+ */
+static struct workqueue_struct *acomp_wq;
+
+/* Process one request of a chain on its own, using its own chain state. */
+static void acomp_do_req_alone(struct acomp_req *req,
+			       int (*op)(struct acomp_req *req))
+{
+	struct acomp_req_chain *state = &req->chain;
+
+	state->op = op;
+	acomp_reqchain_virt(state, acomp_do_one_req(state, req));
+}
+
+static void acomp_do_req_work(struct work_struct *work)
+{
+	struct acomp_req_chain *state = container_of(work,
+					struct acomp_req_chain, work);
+	struct acomp_req_batch *batch = state->data;
+
+	acomp_do_req_alone(container_of(state, struct acomp_req, chain),
+			   state->op);
+	if (atomic_dec_and_test(&batch->pending))
+		complete(&batch->done);
+}
+
+/*
+ * A synchronous algorithm would work through a chain one request after the
+ * other on the calling CPU.  When the caller may sleep, hand all but the
+ * first request to other CPUs instead and wait for them.
+ */
+static bool acomp_req_chain_parallel(struct acomp_req *req)
+{
+	return acomp_wq && acomp_request_chained(req) &&
+	       !acomp_is_async(crypto_acomp_reqtfm(req)) &&
+	       (req->base.flags & CRYPTO_TFM_REQ_MAY_SLEEP) &&
+	       num_online_cpus() > 1;
+}
+
+static int acomp_do_req_parallel(struct acomp_req *req0,
+				 int (*op)(struct acomp_req *req))
+{
+	struct acomp_req_batch batch;
+	struct acomp_req *req;
+	int err;
+
+	atomic_set(&batch.pending, 1);
+	init_completion(&batch.done);
+
+	list_for_each_entry(req, &req0->base.list, base.list) {
+		req->chain.op = op;
+		req->chain.data = &batch;
+		INIT_WORK(&req->chain.work, acomp_do_req_work);
+		atomic_inc(&batch.pending);
+		queue_work(acomp_wq, &req->chain.work);
+	}
+
+	acomp_do_req_alone(req0, op);
+	if (!atomic_dec_and_test(&batch.pending))
+		wait_for_completion(&batch.done);
+
+	err = req0->base.err;
+	list_for_each_entry(req, &req0->base.list, base.list) {
+		if (!err)
+			err = req->base.err;
+	}
+	return err;
+}
+
 static int acomp_do_req_chain(struct acomp_req *req,
 			      int (*op)(struct acomp_req *req))
 {
@@ -352,6 +429,9 @@ static int acomp_do_req_chain(struct acomp_req *req,
 	    (!acomp_request_chained(req) && acomp_request_issg(req)))
 		return op(req);
 
+	if (acomp_req_chain_parallel(req))
+		return acomp_do_req_parallel(req, op);
+
 	acomp_save_req(req, acomp_reqchain_done);
 	state = req->base.data;
 
@@ -434,5 +514,21 @@ void crypto_unregister_acomps(struct acomp_alg *algs, int count)
 }
 EXPORT_SYMBOL_GPL(crypto_unregister_acomps);
 
+static int __init acomp_init(void)
+{
+	/* without it, chains of synchronous algorithms are run serially */
+	acomp_wq = alloc_workqueue("acomp", WQ_UNBOUND | WQ_MEM_RECLAIM, 0);
+	return 0;
+}
+
+static void __exit acomp_exit(void)
+{
+	if (acomp_wq)
+		destroy_workqueue(acomp_wq);
+}
+
+subsys_initcall(acomp_init);
+module_exit(acomp_exit);
+
 MODULE_LICENSE("GPL");
 MODULE_DESCRIPTION("Asynchronous compression type");
@@ -79,6 +79,7 @@ struct loop_device {
 struct loop_cmd {
 	struct list_head list_entry;
 	bool use_aio; /* use AIO interface to handle I/O */
+	bool nowait_failed; /* NOWAIT issue got -EAGAIN, use the worker */
 	atomic_t ref; /* only for aio */
 	long ret;
 	struct kiocb iocb;
@@ -276,6 +277,19 @@ static void lo_complete_rq(struct request *rq)
 	struct loop_cmd *cmd = blk_mq_rq_to_pdu(rq);
 	blk_status_t ret = BLK_STS_OK;
 
+	/*
+	 * NOWAIT IO issued from ->queue_rq() can still fail asynchronously
+	 * with -EAGAIN, e.g. when the backing device runs out of tags. Retry
+	 * it from the worker, which doesn't use IOCB_NOWAIT.
+	 */
+	if (cmd->ret == -EAGAIN && (cmd->iocb.ki_flags & IOCB_NOWAIT)) {
+		cmd->ret = 0;
+		cmd->nowait_failed = true;
+		blk_mq_requeue_request(rq, true);
+		return;
+	}
+	cmd->nowait_failed = false;
+
 	if (cmd->ret < 0 || cmd->ret == blk_rq_bytes(rq) ||
 	    req_op(rq) != REQ_OP_READ) {
 		if (cmd->ret < 0)
@@ -326,7 +340,7 @@ static void lo_rw_aio_complete(struct kiocb *iocb, long ret)
 }
 
 static int lo_rw_aio(struct loop_device *lo, struct loop_cmd *cmd,
-		     loff_t pos, int rw)
+		     loff_t pos, int rw, bool nowait)
 {
 	struct iov_iter iter;
 	struct req_iterator rq_iter;
@@ -382,6 +396,8 @@ static int lo_rw_aio(struct loop_device *lo, struct loop_cmd *cmd,
 	if (cmd->use_aio) {
 		cmd->iocb.ki_complete = lo_rw_aio_complete;
 		cmd->iocb.ki_flags = IOCB_DIRECT;
+		if (nowait)
+			cmd->iocb.ki_flags |= IOCB_NOWAIT;
 	} else {
 		cmd->iocb.ki_complete = NULL;
 		cmd->iocb.ki_flags = 0;
@@ -392,6 +408,13 @@ static int lo_rw_aio(struct loop_device *lo, struct loop_cmd *cmd,
 	else
 		ret = file->f_op->read_iter(&cmd->iocb, &iter);
 
+	/* nothing was issued, let the caller hand it to the worker */
+	if (ret == -EAGAIN && nowait) {
+		kfree(cmd->bvec);
+		cmd->bvec = NULL;
+		return -EAGAIN;
+	}
+
 	lo_rw_aio_do_completion(cmd);
 
 	if (ret != -EIOCBQUEUED)
@@ -419,9 +442,9 @@ static int do_req_filebacked(struct loop_device *lo, struct request *rq)
 	case REQ_OP_DISCARD:
 		return lo_fallocate(lo, rq, pos, FALLOC_FL_PUNCH_HOLE);
 	case REQ_OP_WRITE:
-		return lo_rw_aio(lo, cmd, pos, ITER_SOURCE);
+		return lo_rw_aio(lo, cmd, pos, ITER_SOURCE, false);
 	case REQ_OP_READ:
-		return lo_rw_aio(lo, cmd, pos, ITER_DEST);
+		return lo_rw_aio(lo, cmd, pos, ITER_DEST, false);
 	default:
 		WARN_ON_ONCE(1);
 		return -EIO;
@@ -1789,6 +1812,53 @@ static const struct kernel_param_ops loop_hw_qdepth_param_ops = {
 device_param_cb(hw_queue_depth, &loop_hw_qdepth_param_ops, &hw_queue_depth, 0444);
 MODULE_PARM_DESC(hw_queue_depth, "Queue depth for each hardware queue. Default: " __stringify(LOOP_DEFAULT_HW_Q_DEPTH));
 
+static unsigned int nr_hw_queues = 1;
+module_param(nr_hw_queues, uint, 0444);
+MODULE_PARM_DESC(nr_hw_queues, "Number of hardware queues. Default: 1");
+
+/*
+ * Direct IO reads and writes are first issued with IOCB_NOWAIT from the
+ * submitting context, and only handed to the per-cgroup workers if that
+ * would block. Only done when the request belongs to the submitter's
+ * cgroup, so the IO is still charged to the right one.
+ */
+static bool loop_can_issue_nowait(struct loop_device *lo, struct loop_cmd *cmd)
+{
+	struct request *rq = blk_mq_rq_from_pdu(cmd);
+	bool ret = true;
+
+	if (!cmd->use_aio || cmd->nowait_failed)
+		return false;
+	if (!(lo->lo_backing_file->f_mode & FMODE_NOWAIT))
+		return false;
+	if (op_is_write(req_op(rq)) && (lo->lo_flags & LO_FLAGS_READ_ONLY))
+		return false;
+
+#ifdef CONFIG_BLK_CGROUP
+	if (cmd->blkcg_css) {
+		rcu_read_lock();
+		ret = cmd->blkcg_css == task_css(current, io_cgrp_id);
+		rcu_read_unlock();
+	}
+#endif
+	return ret;
+}
+
+static int loop_issue_nowait(struct loop_device *lo, struct loop_cmd *cmd)
+{
+	struct request *rq = blk_mq_rq_from_pdu(cmd);
+	loff_t pos = ((loff_t) blk_rq_pos(rq) << 9) + lo->lo_offset;
+	int rw = req_op(rq) == REQ_OP_WRITE ? ITER_SOURCE : ITER_DEST;
+	unsigned int noio_flag;
+	int ret;
+
+	/* same as the workers, don't recurse into reclaim through us */
+	noio_flag = memalloc_noio_save();
+	ret = lo_rw_aio(lo, cmd, pos, rw, true);
+	memalloc_noio_restore(noio_flag);
+	return ret;
+}
+
 MODULE_DESCRIPTION("Loopback device support");
 MODULE_LICENSE("GPL");
 MODULE_ALIAS_BLOCKDEV_MAJOR(LOOP_MAJOR);
@@ -1831,6 +1901,16 @@ static blk_status_t loop_queue_rq(struct blk_mq_hw_ctx *hctx,
 #endif
 	}
 #endif
+	if (loop_can_issue_nowait(lo, cmd)) {
+		struct cgroup_subsys_state *memcg_css = cmd->memcg_css;
+
+		/* cmd may be completed already once this returns */
+		if (loop_issue_nowait(lo, cmd) != -EAGAIN) {
+			if (memcg_css)
+				css_put(memcg_css);
+			return BLK_STS_OK;
+		}
+	}
 	loop_queue_work(lo, cmd);
 
 	return BLK_STS_OK;
@@ -1976,11 +2056,13 @@ static int loop_add(int i)
 	i = err;
 
 	lo->tag_set.ops = &loop_mq_ops;
-	lo->tag_set.nr_hw_queues = 1;
+	lo->tag_set.nr_hw_queues = clamp(nr_hw_queues, 1U, nr_cpu_ids);
 	lo->tag_set.queue_depth = hw_queue_depth;
 	lo->tag_set.numa_node = NUMA_NO_NODE;
 	lo->tag_set.cmd_size = sizeof(struct loop_cmd);
-	lo->tag_set.flags = BLK_MQ_F_STACKING | BLK_MQ_F_NO_SCHED_BY_DEFAULT;
+	/* ->queue_rq() may issue IOCB_NOWAIT IO, which can still sleep */
+	lo->tag_set.flags = BLK_MQ_F_STACKING | BLK_MQ_F_NO_SCHED_BY_DEFAULT |
+		BLK_MQ_F_BLOCKING;
 	lo->tag_set.driver_data = lo;
 
 	err = blk_mq_alloc_tag_set(&lo->tag_set);
@@ -64,7 +64,8 @@
 		| UBLK_F_CMD_IOCTL_ENCODE \
 		| UBLK_F_USER_COPY \
 		| UBLK_F_ZONED \
-		| UBLK_F_USER_RECOVERY_FAIL_IO)
+		| UBLK_F_USER_RECOVERY_FAIL_IO \
+		| UBLK_F_AUTO_BUF_REG)
 
 #define UBLK_F_ALL_RECOVERY_FLAGS (UBLK_F_USER_RECOVERY \
 		| UBLK_F_USER_RECOVERY_REISSUE \
@@ -131,6 +132,12 @@ struct ublk_uring_cmd_pdu {
  */
 #define UBLK_IO_FLAG_NEED_GET_DATA 0x08
 
+/*
+ * The request's buffer has been registered into the ublk server's io_uring
+ * at ublk_io->buf_index, and has to be unregistered on commit.
+ */
+#define UBLK_IO_FLAG_AUTO_BUF_REG 0x10
+
 /* atomic RW with ubq->cancel_lock */
 #define UBLK_IO_FLAG_CANCELED	0x80000000
 
@@ -140,6 +147,9 @@ struct ublk_io {
 	unsigned int flags;
 	int res;
 
+	/* fixed buffer index for UBLK_F_AUTO_BUF_REG */
+	u16 buf_index;
+
 	struct io_uring_cmd *cmd;
 };
 
@@ -614,6 +624,11 @@ static inline bool ublk_support_user_copy(const struct ublk_queue *ubq)
 	return ubq->flags & (UBLK_F_USER_COPY | UBLK_F_SUPPORT_ZERO_COPY);
 }
 
+static inline bool ublk_support_auto_buf_reg(const struct ublk_queue *ubq)
+{
+	return ubq->flags & UBLK_F_AUTO_BUF_REG;
+}
+
 static inline bool ublk_need_map_io(const struct ublk_queue *ubq)
 {
 	return !ublk_support_user_copy(ubq);
@@ -1151,6 +1166,35 @@ static inline void __ublk_abort_rq(struct ublk_queue *ubq,
 		blk_mq_end_request(rq, BLK_STS_IOERR);
 }
 
+static void ublk_io_release(void *priv);
+
+/*
+ * Lend the request's pages to the io_uring context owning io->cmd, so
+ * that the server can issue fixed-buffer IO against them right away.
+ * The registration holds its own request reference, which is dropped
+ * by ublk_io_release() once the buffer is unregistered on commit and
+ * the last in-flight user of it has completed.
+ */
+static bool ublk_auto_buf_reg(struct ublk_queue *ubq, struct request *req,
+			      struct ublk_io *io, unsigned int issue_flags)
+{
+	int ret;
+
+	/* can't fail, the reference was just initialized */
+	ublk_get_req_ref(ubq, req);
+	ret = io_buffer_register_bvec(io->cmd, req, ublk_io_release,
+				      io->buf_index, issue_flags);
+	if (ret) {
+		pr_devel("%s: register buf failed: qid %d tag %d index %u ret %d\n",
+				__func__, ubq->q_id, req->tag, io->buf_index, ret);
+		ublk_put_req_ref(ubq, req);
+		blk_mq_end_request(req, BLK_STS_IOERR);
+		return false;
+	}
+	io->flags |= UBLK_IO_FLAG_AUTO_BUF_REG;
+	return true;
+}
+
 static void ublk_dispatch_req(struct ublk_queue *ubq,
 			      struct request *req,
 			      unsigned int issue_flags)
@@ -1227,6 +1271,9 @@ static void ublk_dispatch_req(struct ublk_queue *ubq,
 	}
 
 	ublk_init_req_ref(ubq, req);
+	if (ublk_support_auto_buf_reg(ubq) && ublk_rq_has_data(req) &&
+	    !ublk_auto_buf_reg(ubq, req, io, issue_flags))
+		return;
 	ubq_complete_io_cmd(io, UBLK_IO_RES_OK, issue_flags);
 }
 
@@ -1967,6 +2014,17 @@ static int ublk_unregister_io_buf(struct io_uring_cmd *cmd,
 	return io_buffer_unregister_bvec(cmd, index, issue_flags);
 }
 
+static int ublk_set_auto_buf_reg(struct ublk_io *io, __u64 addr)
+{
+	struct ublk_auto_buf_reg reg = ublk_addr_to_auto_buf_reg(addr);
+
+	if (reg.flags || reg.reserved0 || reg.reserved1)
+		return -EINVAL;
+
+	io->buf_index = reg.index;
+	return 0;
+}
+
 static int ublk_fetch(struct io_uring_cmd *cmd, struct ublk_queue *ubq,
 		      struct ublk_io *io, __u64 buf_addr)
 {
@@ -2000,6 +2058,11 @@ static int ublk_fetch(struct io_uring_cmd *cmd, struct ublk_queue *ubq,
 		 */
 		if (!buf_addr && !ublk_need_get_data(ubq))
 			goto out;
+	} else if (ublk_support_auto_buf_reg(ubq)) {
+		ret = ublk_set_auto_buf_reg(io, buf_addr);
+		if (ret)
+			goto out;
+		buf_addr = 0;
 	} else if (buf_addr) {
 		/* User copy requires addr to be unset */
 		ret = -EINVAL;
@@ -2024,6 +2087,7 @@ static int __ublk_ch_uring_cmd(struct io_uring_cmd *cmd,
 	unsigned tag = ub_cmd->tag;
 	int ret = -EINVAL;
 	struct request *req;
+	__u64 addr;
 
 	pr_devel("%s: received: cmd op %d queue %d tag %d result %d\n",
 			__func__, cmd->cmd_op, ub_cmd->q_id, tag,
@@ -2079,6 +2143,7 @@ static int __ublk_ch_uring_cmd(struct io_uring_cmd *cmd,
 		if (!(io->flags & UBLK_IO_FLAG_OWNED_BY_SRV))
 			goto out;
 
+		addr = ub_cmd->addr;
 		if (ublk_need_map_io(ubq)) {
 			/*
 			 * COMMIT_AND_FETCH_REQ has to provide IO buffer if
@@ -2087,6 +2152,14 @@ static int __ublk_ch_uring_cmd(struct io_uring_cmd *cmd,
 			if (!ub_cmd->addr && (!ublk_need_get_data(ubq) ||
 						req_op(req) == REQ_OP_READ))
 				goto out;
+		} else if (ublk_support_auto_buf_reg(ubq)) {
+			/*
+			 * zone append LBA can't be passed back together with
+			 * the next buffer index
+			 */
+			if (req_op(req) == REQ_OP_ZONE_APPEND)
+				goto out;
+			addr = 0;
 		} else if (req_op(req) != REQ_OP_ZONE_APPEND && ub_cmd->addr) {
 			/*
 			 * User copy requires addr to be unset when command is
@@ -2096,7 +2169,30 @@ static int __ublk_ch_uring_cmd(struct io_uring_cmd *cmd,
 			goto out;
 		}
 
-		ublk_fill_io_cmd(io, cmd, ub_cmd->addr);
+		if (ublk_support_auto_buf_reg(ubq)) {
+			u16 old_index = io->buf_index;
+
+			ret = ublk_set_auto_buf_reg(io, ub_cmd->addr);
+			if (ret)
+				goto out;
+
+			/*
+			 * Drops the registration's request reference, or
+			 * defers that until in-flight fixed-buffer IO is done.
+			 * Fails if this isn't the ring the buffer was lent to.
+			 */
+			if (io->flags & UBLK_IO_FLAG_AUTO_BUF_REG) {
+				ret = io_buffer_unregister_bvec(cmd, old_index,
+								issue_flags);
+				if (ret) {
+					io->buf_index = old_index;
+					goto out;
+				}
+				io->flags &= ~UBLK_IO_FLAG_AUTO_BUF_REG;
+			}
+		}
+
+		ublk_fill_io_cmd(io, cmd, addr);
 		ublk_commit_completion(ub, ub_cmd);
 		break;
 	case UBLK_IO_NEED_GET_DATA:
@@ -2702,6 +2798,14 @@ static int ublk_ctrl_add_dev(const struct ublksrv_ctrl_cmd *header)
 		return -EINVAL;
 	}
 
+	/* auto buffer registration lends the request pages via zero copy */
+	if ((info.flags & UBLK_F_AUTO_BUF_REG) &&
+	    !(info.flags & UBLK_F_SUPPORT_ZERO_COPY)) {
+		pr_warn("%s: UBLK_F_AUTO_BUF_REG requires zero copy\n",
+			__func__);
+		return -EINVAL;
+	}
+
 	/*
 	 * unprivileged device can't be trusted, but RECOVERY and
 	 * RECOVERY_REISSUE still may hang error handling, so can't
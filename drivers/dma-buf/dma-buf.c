@@ -995,6 +995,17 @@ struct dma_buf_attachment *dma_buf_attach(struct dma_buf *dmabuf,
 }
 EXPORT_SYMBOL_NS_GPL(dma_buf_attach, "DMA_BUF");
 
+/*
+ * Dynamic importers may ask for the mapping to be kept, since without
+ * pinning a dynamic exporter can still move the buffer.
+ */
+static bool dma_buf_importer_caches_sgt(struct dma_buf_attachment *attach)
+{
+	return IS_ENABLED(CONFIG_DMABUF_MOVE_NOTIFY) &&
+	       dma_buf_is_dynamic(attach->dmabuf) &&
+	       attach->importer_ops && attach->importer_ops->cache_sgt_mapping;
+}
+
 static void __unmap_dma_buf(struct dma_buf_attachment *attach,
 			    struct sg_table *sg_table,
 			    enum dma_data_direction direction)
@@ -1025,7 +1036,8 @@ void dma_buf_detach(struct dma_buf *dmabuf, struct dma_buf_attachment *attach)
 
 		__unmap_dma_buf(attach, attach->sgt, attach->dir);
 
-		if (dma_buf_is_dynamic(attach->dmabuf))
+		if (dma_buf_is_dynamic(attach->dmabuf) &&
+		    !dma_buf_attachment_is_dynamic(attach))
 			dmabuf->ops->unpin(attach);
 	}
 	list_del(&attach->node);
@@ -1124,7 +1136,19 @@ struct sg_table *dma_buf_map_attachment(struct dma_buf_attachment *attach,
 
 	dma_resv_assert_held(attach->dmabuf->resv);
 
-	if (attach->sgt) {
+	/*
+	 * A mapping the importer asked to cache but nobody uses any more
+	 * doesn't stand in the way of a mapping in another direction.
+	 */
+	if (attach->sgt && !attach->sgt_users &&
+	    dma_buf_importer_caches_sgt(attach) &&
+	    attach->dir != direction && attach->dir != DMA_BIDIRECTIONAL) {
+		__unmap_dma_buf(attach, attach->sgt, attach->dir);
+		attach->sgt = NULL;
+		attach->sgt_stale = false;
+	}
+
+	if (attach->sgt && !attach->sgt_stale) {
 		/*
 		 * Two mappings with different directions for the same
 		 * attachment are not allowed.
@@ -1133,6 +1157,7 @@ struct sg_table *dma_buf_map_attachment(struct dma_buf_attachment *attach,
 		    attach->dir != DMA_BIDIRECTIONAL)
 			return ERR_PTR(-EBUSY);
 
+		attach->sgt_users++;
 		return attach->sgt;
 	}
 
@@ -1152,9 +1177,13 @@ struct sg_table *dma_buf_map_attachment(struct dma_buf_attachment *attach,
 	     !IS_ENABLED(CONFIG_DMABUF_MOVE_NOTIFY))
 		attach->dmabuf->ops->unpin(attach);
 
-	if (!IS_ERR(sg_table) && attach->dmabuf->ops->cache_sgt_mapping) {
+	/* a stale mapping still in use keeps the slot until it is unmapped */
+	if (!IS_ERR(sg_table) && !attach->sgt &&
+	    (attach->dmabuf->ops->cache_sgt_mapping ||
+	     dma_buf_importer_caches_sgt(attach))) {
 		attach->sgt = sg_table;
 		attach->dir = direction;
+		attach->sgt_users = 1;
 	}
 
 #ifdef CONFIG_DMA_API_DEBUG
@@ -1215,6 +1244,7 @@ EXPORT_SYMBOL_NS_GPL(dma_buf_map_attachment_unlocked, "DMA_BUF");
  * @direction:  [in]    direction of DMA transfer
  *
  * This unmaps a DMA mapping for @attached obtained by dma_buf_map_attachment().
+ * A cached mapping is kept for the next map call unless the DMA-buf moved.
  */
 void dma_buf_unmap_attachment(struct dma_buf_attachment *attach,
 				struct sg_table *sg_table,
@@ -1227,8 +1257,13 @@ void dma_buf_unmap_attachment(struct dma_buf_attachment *attach,
 
 	dma_resv_assert_held(attach->dmabuf->resv);
 
-	if (attach->sgt == sg_table)
-		return;
+	if (attach->sgt == sg_table) {
+		if (--attach->sgt_users || !attach->sgt_stale)
+			return;
+		attach->sgt = NULL;
+		attach->sgt_stale = false;
+		direction = attach->dir;
+	}
 
 	__unmap_dma_buf(attach, sg_table, direction);
 
@@ -1269,7 +1304,8 @@ EXPORT_SYMBOL_NS_GPL(dma_buf_unmap_attachment_unlocked, "DMA_BUF");
  * @dmabuf:	[in]	buffer which is moving
  *
  * Informs all attachments that they need to destroy and recreate all their
- * mappings.
+ * mappings.  Mappings cached for dynamic importers are not handed out any
+ * more, and are released as soon as nobody uses them.
  */
 void dma_buf_move_notify(struct dma_buf *dmabuf)
 {
@@ -1277,9 +1313,19 @@ void dma_buf_move_notify(struct dma_buf *dmabuf)
 
 	dma_resv_assert_held(dmabuf->resv);
 
-	list_for_each_entry(attach, &dmabuf->attachments, node)
-		if (attach->importer_ops)
-			attach->importer_ops->move_notify(attach);
+	list_for_each_entry(attach, &dmabuf->attachments, node) {
+		if (!attach->importer_ops)
+			continue;
+
+		if (attach->sgt && !attach->sgt_users) {
+			__unmap_dma_buf(attach, attach->sgt, attach->dir);
+			attach->sgt = NULL;
+			attach->sgt_stale = false;
+		} else if (attach->sgt) {
+			attach->sgt_stale = true;
+		}
+		attach->importer_ops->move_notify(attach);
+	}
 }
 EXPORT_SYMBOL_NS_GPL(dma_buf_move_notify, "DMA_BUF");
 
@@ -209,6 +209,38 @@ ib_umem_odp_alloc_child(struct ib_umem_odp *root, unsigned long addr,
 }
 EXPORT_SYMBOL(ib_umem_odp_alloc_child);
 
+#ifdef CONFIG_HUGETLB_PAGE
+/*
+ * Page shift for an IB_ACCESS_HUGETLB region: the smallest huge page size
+ * of the hugetlb VMAs covering [addr, addr + size), so that a region
+ * backed by 1G pages is faulted and mapped in 1G pieces.  A region that
+ * is not fully covered by hugetlb VMAs, for instance because it is not
+ * mapped yet, keeps the default huge page size.
+ */
+static unsigned int ib_umem_odp_hugetlb_shift(struct mm_struct *mm,
+					      unsigned long addr, size_t size)
+{
+	unsigned long end = addr + size, next = addr;
+	unsigned int shift = UINT_MAX;
+	struct vm_area_struct *vma;
+	VMA_ITERATOR(vmi, mm, addr);
+
+	if (end <= addr)
+		return HPAGE_SHIFT;
+
+	mmap_read_lock(mm);
+	for_each_vma_range(vmi, vma, end) {
+		if (vma->vm_start > next || !is_vm_hugetlb_page(vma))
+			break;
+		shift = min(shift, huge_page_shift(hstate_vma(vma)));
+		next = vma->vm_end;
+	}
+	mmap_read_unlock(mm);
+
+	return next >= end ? shift : HPAGE_SHIFT;
+}
+#endif
+
 /**
  * ib_umem_odp_get - Create a umem_odp for a userspace va
  *
@@ -246,7 +278,8 @@ struct ib_umem_odp *ib_umem_odp_get(struct ib_device *device,
 	umem_odp->page_shift = PAGE_SHIFT;
 #ifdef CONFIG_HUGETLB_PAGE
 	if (access & IB_ACCESS_HUGETLB)
-		umem_odp->page_shift = HPAGE_SHIFT;
+		umem_odp->page_shift = ib_umem_odp_hugetlb_shift(current->mm,
+								 addr, size);
 #endif
 
 	umem_odp->tgid = get_task_pid(current->group_leader, PIDTYPE_PID);
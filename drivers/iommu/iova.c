@@ -18,6 +18,30 @@
 #define IOVA_ANCHOR	~0UL
 
 #define IOVA_RANGE_CACHE_MAX_SIZE 6	/* log of max cached IOVA range size (in pages) */
+#define IOVA_RANGE_CACHE_MAX_LIMIT 11	/* ... as raised by rcache_orders */
+
+/*
+ * Drivers that map large buffers, 256K NIC receive rings or 512K storage
+ * IOs, see their IOVAs come from the rbtree under the domain lock for
+ * every map.  Caching more orders costs two magazines per CPU per order
+ * and domain, so it is a boot-time choice.
+ */
+static unsigned int iova_rcache_orders = IOVA_RANGE_CACHE_MAX_SIZE;
+
+static int iova_rcache_orders_set(const char *val,
+				  const struct kernel_param *kp)
+{
+	return param_set_uint_minmax(val, kp, 1, IOVA_RANGE_CACHE_MAX_LIMIT);
+}
+
+static const struct kernel_param_ops iova_rcache_orders_ops = {
+	.set = iova_rcache_orders_set,
+	.get = param_get_uint,
+};
+module_param_cb(rcache_orders, &iova_rcache_orders_ops, &iova_rcache_orders,
+		0444);
+MODULE_PARM_DESC(rcache_orders,
+		 "IOVA size orders cached per CPU (default 6, up to 11)");
 
 static bool iova_rcache_insert(struct iova_domain *iovad,
 			       unsigned long pfn,
@@ -386,7 +410,7 @@ alloc_iova_fast(struct iova_domain *iovad, unsigned long size,
 	 * rounding up anything cacheable to make sure that can't happen. The
 	 * order of the unadjusted size will still match upon freeing.
 	 */
-	if (size < (1 << (IOVA_RANGE_CACHE_MAX_SIZE - 1)))
+	if (size < (1 << (iova_rcache_orders - 1)))
 		size = roundup_pow_of_two(size);
 
 	iova_pfn = iova_rcache_get(iovad, size, limit_pfn + 1);
@@ -595,7 +619,7 @@ static struct kmem_cache *iova_magazine_cache;
 
 unsigned long iova_rcache_range(void)
 {
-	return PAGE_SIZE << (IOVA_RANGE_CACHE_MAX_SIZE - 1);
+	return PAGE_SIZE << (iova_rcache_orders - 1);
 }
 
 static struct iova_magazine *iova_magazine_alloc(gfp_t flags)
@@ -715,13 +739,13 @@ int iova_domain_init_rcaches(struct iova_domain *iovad)
 	unsigned int cpu;
 	int i, ret;
 
-	iovad->rcaches = kcalloc(IOVA_RANGE_CACHE_MAX_SIZE,
+	iovad->rcaches = kcalloc(iova_rcache_orders,
 				 sizeof(struct iova_rcache),
 				 GFP_KERNEL);
 	if (!iovad->rcaches)
 		return -ENOMEM;
 
-	for (i = 0; i < IOVA_RANGE_CACHE_MAX_SIZE; ++i) {
+	for (i = 0; i < iova_rcache_orders; ++i) {
 		struct iova_cpu_rcache *cpu_rcache;
 		struct iova_rcache *rcache;
 
@@ -809,7 +833,7 @@ static bool iova_rcache_insert(struct iova_domain *iovad, unsigned long pfn,
 {
 	unsigned int log_size = order_base_2(size);
 
-	if (log_size >= IOVA_RANGE_CACHE_MAX_SIZE)
+	if (log_size >= iova_rcache_orders)
 		return false;
 
 	return __iova_rcache_insert(iovad, &iovad->rcaches[log_size], pfn);
@@ -865,7 +889,7 @@ static unsigned long iova_rcache_get(struct iova_domain *iovad,
 {
 	unsigned int log_size = order_base_2(size);
 
-	if (log_size >= IOVA_RANGE_CACHE_MAX_SIZE)
+	if (log_size >= iova_rcache_orders)
 		return 0;
 
 	return __iova_rcache_get(&iovad->rcaches[log_size], limit_pfn - size);
@@ -880,7 +904,7 @@ static void free_iova_rcaches(struct iova_domain *iovad)
 	struct iova_cpu_rcache *cpu_rcache;
 	unsigned int cpu;
 
-	for (int i = 0; i < IOVA_RANGE_CACHE_MAX_SIZE; ++i) {
+	for (int i = 0; i < iova_rcache_orders; ++i) {
 		rcache = &iovad->rcaches[i];
 		if (!rcache->cpu_rcaches)
 			break;
@@ -909,7 +933,7 @@ static void free_cpu_cached_iovas(unsigned int cpu, struct iova_domain *iovad)
 	unsigned long flags;
 	int i;
 
-	for (i = 0; i < IOVA_RANGE_CACHE_MAX_SIZE; ++i) {
+	for (i = 0; i < iova_rcache_orders; ++i) {
 		rcache = &iovad->rcaches[i];
 		cpu_rcache = per_cpu_ptr(rcache->cpu_rcaches, cpu);
 		spin_lock_irqsave(&cpu_rcache->lock, flags);
@@ -927,7 +951,7 @@ static void free_global_cached_iovas(struct iova_domain *iovad)
 	struct iova_rcache *rcache;
 	unsigned long flags;
 
-	for (int i = 0; i < IOVA_RANGE_CACHE_MAX_SIZE; ++i) {
+	for (int i = 0; i < iova_rcache_orders; ++i) {
 		rcache = &iovad->rcaches[i];
 		spin_lock_irqsave(&rcache->lock, flags);
 		while (rcache->depot) {
@@ -79,6 +79,8 @@ struct dm_crypt_io {
 	struct bio *base_bio;
 	u8 *integrity_metadata;
 	bool integrity_metadata_from_pool:1;
+	/* crypt in the context that completes or submits the bio */
+	bool no_workqueue:1;
 
 	struct work_struct work;
 
@@ -182,6 +184,8 @@ struct crypt_config {
 	unsigned int iv_size;
 	unsigned short sector_size;
 	unsigned char sector_shift;
+	/* largest bio crypted without the workqueues, 0 if disabled */
+	unsigned int inline_max_size;
 
 	union {
 		struct crypto_skcipher **tfms;
@@ -1769,6 +1773,25 @@ static void crypt_free_buffer_pages(struct crypt_config *cc, struct bio *clone)
 	}
 }
 
+/*
+ * no_read_workqueue and no_write_workqueue apply to every bio; with
+ * inline_max_bytes only the bios that small skip the workqueues, where the
+ * cost of the two hops outweighs the crypting itself.
+ */
+static bool crypt_bio_no_workqueue(struct crypt_config *cc, struct bio *bio)
+{
+	if (bio_data_dir(bio) == READ) {
+		if (test_bit(DM_CRYPT_NO_READ_WORKQUEUE, &cc->flags))
+			return true;
+	} else {
+		if (test_bit(DM_CRYPT_NO_WRITE_WORKQUEUE, &cc->flags))
+			return true;
+	}
+
+	return bio->bi_iter.bi_size &&
+	       bio->bi_iter.bi_size <= cc->inline_max_size;
+}
+
 static void crypt_io_init(struct dm_crypt_io *io, struct crypt_config *cc,
 			  struct bio *bio, sector_t sector)
 {
@@ -1781,6 +1804,7 @@ static void crypt_io_init(struct dm_crypt_io *io, struct crypt_config *cc,
 	io->ctx.r.req = NULL;
 	io->integrity_metadata = NULL;
 	io->integrity_metadata_from_pool = false;
+	io->no_workqueue = crypt_bio_no_workqueue(cc, bio);
 	atomic_set(&io->io_pending, 0);
 }
 
@@ -2020,7 +2044,7 @@ static void kcryptd_crypt_write_io_submit(struct dm_crypt_io *io, int async)
 	BUG_ON(io->ctx.iter_out.bi_size);
 
 	if ((likely(!async) && test_bit(DM_CRYPT_NO_OFFLOAD, &cc->flags)) ||
-	    test_bit(DM_CRYPT_NO_WRITE_WORKQUEUE, &cc->flags)) {
+	    io->no_workqueue) {
 		dm_submit_bio_remap(io->base_bio, clone);
 		return;
 	}
@@ -2122,8 +2146,7 @@ static void kcryptd_crypt_write_convert(struct dm_crypt_io *io)
 	}
 
 	crypt_inc_pending(io);
-	r = crypt_convert(cc, ctx,
-			  test_bit(DM_CRYPT_NO_WRITE_WORKQUEUE, &cc->flags), true);
+	r = crypt_convert(cc, ctx, io->no_workqueue, true);
 	/*
 	 * Crypto API backlogged the request, because its queue was full
 	 * and we're in softirq context, so continue from a workqueue
@@ -2191,14 +2214,12 @@ static void kcryptd_crypt_read_convert(struct dm_crypt_io *io)
 	crypt_inc_pending(io);
 
 	if (io->ctx.aead_recheck) {
-		r = crypt_convert(cc, &io->ctx,
-				  test_bit(DM_CRYPT_NO_READ_WORKQUEUE, &cc->flags), true);
+		r = crypt_convert(cc, &io->ctx, io->no_workqueue, true);
 	} else {
 		crypt_convert_init(cc, &io->ctx, io->base_bio, io->base_bio,
 				   io->sector);
 
-		r = crypt_convert(cc, &io->ctx,
-				  test_bit(DM_CRYPT_NO_READ_WORKQUEUE, &cc->flags), true);
+		r = crypt_convert(cc, &io->ctx, io->no_workqueue, true);
 	}
 	/*
 	 * Crypto API backlogged the request, because its queue was full
@@ -2288,8 +2309,7 @@ static void kcryptd_queue_crypt(struct dm_crypt_io *io)
 {
 	struct crypt_config *cc = io->cc;
 
-	if ((bio_data_dir(io->base_bio) == READ && test_bit(DM_CRYPT_NO_READ_WORKQUEUE, &cc->flags)) ||
-	    (bio_data_dir(io->base_bio) == WRITE && test_bit(DM_CRYPT_NO_WRITE_WORKQUEUE, &cc->flags))) {
+	if (io->no_workqueue) {
 		/*
 		 * in_hardirq(): Crypto API's skcipher_walk_first() refuses to work in hard IRQ context.
 		 * irqs_disabled(): the kernel may run some IO completion from the idle thread, but
@@ -3133,7 +3153,7 @@ static int crypt_ctr_optional(struct dm_target *ti, unsigned int argc, char **ar
 	struct crypt_config *cc = ti->private;
 	struct dm_arg_set as;
 	static const struct dm_arg _args[] = {
-		{0, 9, "Invalid number of feature args"},
+		{0, 10, "Invalid number of feature args"},
 	};
 	unsigned int opt_params, val;
 	const char *opt_string, *sval;
@@ -3169,6 +3189,8 @@ static int crypt_ctr_optional(struct dm_target *ti, unsigned int argc, char **ar
 			set_bit(DM_CRYPT_NO_READ_WORKQUEUE, &cc->flags);
 		else if (!strcasecmp(opt_string, "no_write_workqueue"))
 			set_bit(DM_CRYPT_NO_WRITE_WORKQUEUE, &cc->flags);
+		else if (sscanf(opt_string, "inline_max_bytes:%u%c", &val, &dummy) == 1)
+			cc->inline_max_size = val;
 		else if (sscanf(opt_string, "integrity:%u:", &val) == 1) {
 			if (val == 0 || val > MAX_TAG_SIZE) {
 				ti->error = "Invalid integrity arguments";
@@ -3581,6 +3603,7 @@ static void crypt_status(struct dm_target *ti, status_type_t type,
 		num_feature_args += test_bit(DM_CRYPT_NO_OFFLOAD, &cc->flags);
 		num_feature_args += test_bit(DM_CRYPT_NO_READ_WORKQUEUE, &cc->flags);
 		num_feature_args += test_bit(DM_CRYPT_NO_WRITE_WORKQUEUE, &cc->flags);
+		num_feature_args += !!cc->inline_max_size;
 		num_feature_args += !!cc->used_tag_size;
 		num_feature_args += cc->sector_size != (1 << SECTOR_SHIFT);
 		num_feature_args += test_bit(CRYPT_IV_LARGE_SECTORS, &cc->cipher_flags);
@@ -3599,6 +3622,8 @@ static void crypt_status(struct dm_target *ti, status_type_t type,
 				DMEMIT(" no_read_workqueue");
 			if (test_bit(DM_CRYPT_NO_WRITE_WORKQUEUE, &cc->flags))
 				DMEMIT(" no_write_workqueue");
+			if (cc->inline_max_size)
+				DMEMIT(" inline_max_bytes:%u", cc->inline_max_size);
 			if (cc->used_tag_size)
 				DMEMIT(" integrity:%u:%s", cc->used_tag_size, cc->cipher_auth);
 			if (cc->sector_size != (1 << SECTOR_SHIFT))
@@ -3621,6 +3646,8 @@ static void crypt_status(struct dm_target *ti, status_type_t type,
 		       'y' : 'n');
 		DMEMIT(",no_write_workqueue=%c", test_bit(DM_CRYPT_NO_WRITE_WORKQUEUE, &cc->flags) ?
 		       'y' : 'n');
+		if (cc->inline_max_size)
+			DMEMIT(",inline_max_bytes=%u", cc->inline_max_size);
 		DMEMIT(",iv_large_sectors=%c", test_bit(CRYPT_IV_LARGE_SECTORS, &cc->cipher_flags) ?
 		       'y' : 'n');
 
@@ -3734,7 +3761,7 @@ static void crypt_io_hints(struct dm_target *ti, struct queue_limits *limits)
 
 static struct target_type crypt_target = {
 	.name   = "crypt",
-	.version = {1, 28, 0},
+	.version = {1, 29, 0},
 	.module = THIS_MODULE,
 	.ctr    = crypt_ctr,
 	.dtr    = crypt_dtr,
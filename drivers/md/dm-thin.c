@@ -30,9 +30,10 @@
  */
 #define ENDIO_HOOK_POOL_SIZE 1024
 #define MAPPING_POOL_SIZE 1024
-#define COMMIT_PERIOD HZ
+#define COMMIT_PERIOD_MSECS 1000
 #define NO_SPACE_TIMEOUT_SECS 60
 
+static unsigned int commit_period_msecs = COMMIT_PERIOD_MSECS;
 static unsigned int no_space_timeout_secs = NO_SPACE_TIMEOUT_SECS;
 
 DECLARE_DM_KCOPYD_THROTTLE_WITH_MODULE_PARM(snapshot_copy_throttle,
@@ -2108,10 +2109,15 @@ static void process_cell_fail(struct thin_c *tc, struct dm_bio_prison_cell *cell
  * FIXME: should we also commit due to size of transaction, measured in
  * metadata blocks?
  */
+static unsigned long commit_period(void)
+{
+	return max(msecs_to_jiffies(READ_ONCE(commit_period_msecs)), 1UL);
+}
+
 static int need_commit_due_to_time(struct pool *pool)
 {
 	return !time_in_range(jiffies, pool->last_commit_jiffies,
-			      pool->last_commit_jiffies + COMMIT_PERIOD);
+			      pool->last_commit_jiffies + commit_period());
 }
 
 #define thin_pbd(node) rb_entry((node), struct dm_thin_endio_hook, rb_node)
@@ -2439,7 +2445,7 @@ static void do_waker(struct work_struct *ws)
 	struct pool *pool = container_of(to_delayed_work(ws), struct pool, waker);
 
 	wake_worker(pool);
-	queue_delayed_work(pool->wq, &pool->waker, COMMIT_PERIOD);
+	queue_delayed_work(pool->wq, &pool->waker, commit_period());
 }
 
 /*
@@ -4554,6 +4560,9 @@ static void dm_thin_exit(void)
 module_init(dm_thin_init);
 module_exit(dm_thin_exit);
 
+module_param_named(commit_period, commit_period_msecs, uint, 0644);
+MODULE_PARM_DESC(commit_period, "Longest time between metadata commits in milliseconds");
+
 module_param_named(no_space_timeout, no_space_timeout_secs, uint, 0644);
 MODULE_PARM_DESC(no_space_timeout, "Out of data space queue IO timeout in seconds");
 
@@ -30,6 +30,7 @@
 #define DM_VERITY_ENV_VAR_NAME		"DM_VERITY_ERR_BLOCK_NR"
 
 #define DM_VERITY_DEFAULT_PREFETCH_SIZE	262144
+#define DM_VERITY_READAHEAD_MAX_BYTES	(32 << 20)
 #define DM_VERITY_USE_BH_DEFAULT_BYTES	8192
 
 #define DM_VERITY_MAX_CORRUPTED_ERRS	100
@@ -762,6 +763,21 @@ static void verity_submit_prefetch(struct dm_verity *v, struct dm_verity_io *io,
 	sector_t block = io->block;
 	unsigned int n_blocks = io->n_blocks;
 	struct dm_verity_prefetch_work *pw;
+	unsigned int ra = 0;
+
+	/*
+	 * A reader that continues where the last io ended gets the hash
+	 * blocks of the data after its io prefetched too, with the window
+	 * doubling while it stays sequential.  The window is only a hint,
+	 * so racing updates from concurrent ios are harmless.
+	 */
+	if (block == READ_ONCE(v->readahead_next)) {
+		ra = max(READ_ONCE(v->readahead_blocks) * 2, n_blocks);
+		ra = min_t(unsigned int, ra, DM_VERITY_READAHEAD_MAX_BYTES >>
+					      v->data_dev_block_bits);
+	}
+	WRITE_ONCE(v->readahead_blocks, ra);
+	WRITE_ONCE(v->readahead_next, block + n_blocks);
 
 	if (v->validated_blocks) {
 		while (n_blocks && test_bit(block, v->validated_blocks)) {
@@ -775,6 +791,8 @@ static void verity_submit_prefetch(struct dm_verity *v, struct dm_verity_io *io,
 			return;
 	}
 
+	n_blocks = min_t(sector_t, n_blocks + ra, v->data_blocks - block);
+
 	pw = kmalloc(sizeof(struct dm_verity_prefetch_work),
 		GFP_NOIO | __GFP_NORETRY | __GFP_NOMEMALLOC | __GFP_NOWARN);
 
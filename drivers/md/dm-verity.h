@@ -68,6 +68,10 @@ struct dm_verity {
 
 	struct workqueue_struct *verify_wq;
 
+	/* where a sequential reader continues, and how far ahead to prefetch */
+	sector_t readahead_next;
+	unsigned int readahead_blocks;
+
 	/* starting blocks for each tree level. 0 is the lowest level. */
 	sector_t hash_level_block[DM_VERITY_MAX_LEVELS];
 
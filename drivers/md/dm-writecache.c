@@ -16,6 +16,7 @@
 #include <linux/pfn_t.h>
 #include <linux/libnvdimm.h>
 #include <linux/delay.h>
+#include <linux/list_sort.h>
 #include "dm-io-tracker.h"
 
 #define DM_MSG_PREFIX "writecache"
@@ -1940,6 +1941,31 @@ static void __writecache_writeback_ssd(struct dm_writecache *wc, struct writebac
 	}
 }
 
+static int writeback_cmp(void *priv, const struct list_head *a,
+			 const struct list_head *b)
+{
+	struct dm_writecache *wc = priv;
+	struct wc_entry *ea = container_of(a, struct wc_entry, lru);
+	struct wc_entry *eb = container_of(b, struct wc_entry, lru);
+
+	/* the list is consumed from its tail */
+	return read_original_sector(wc, ea) < read_original_sector(wc, eb);
+}
+
+/*
+ * Entries are picked in LRU order, so the runs of contiguous blocks in
+ * a writeback list land all over the origin device.  Issue them by
+ * increasing sector instead.  The list holds each sector at most once and
+ * a run is the entries that directly follow its first one in sector
+ * order, so sorting the entries keeps every run together, first entry
+ * first.
+ */
+static void writecache_sort_writeback(struct dm_writecache *wc,
+				      struct writeback_list *wbl)
+{
+	list_sort(wc, &wbl->list, writeback_cmp);
+}
+
 static void writecache_writeback(struct work_struct *work)
 {
 	struct dm_writecache *wc = container_of(work, struct dm_writecache, writeback_work);
@@ -2094,6 +2120,10 @@ static void writecache_writeback(struct work_struct *work)
 
 	wc_unlock(wc);
 
+	/* writeback_all walks the tree, which is already in sector order */
+	if (likely(!wc->writeback_all))
+		writecache_sort_writeback(wc, &wbl);
+
 	blk_start_plug(&plug);
 
 	if (WC_MODE_PMEM(wc))
@@ -982,6 +982,42 @@ static inline void r5l_add_no_space_stripe(struct r5l_log *log,
 	spin_unlock(&log->no_space_stripes_lock);
 }
 
+/*
+ * The log checksums of a stripe's pages are all over PAGE_SIZE with the same
+ * seed, so compute them a few pages at a time with crc32c_multi().
+ */
+#define R5L_CSUM_BATCH	4
+
+struct r5l_csum_batch {
+	const u8 *bufs[R5L_CSUM_BATCH];
+	u32 crcs[R5L_CSUM_BATCH];
+	int devs[R5L_CSUM_BATCH];
+	int nr;
+};
+
+static void r5l_csum_flush(struct stripe_head *sh, struct r5l_csum_batch *b)
+{
+	int i;
+
+	crc32c_multi(b->crcs, b->bufs, PAGE_SIZE, b->nr);
+	/* kmap_local_page() mappings are released in reverse order */
+	for (i = b->nr - 1; i >= 0; i--) {
+		kunmap_local(b->bufs[i]);
+		sh->dev[b->devs[i]].log_checksum = b->crcs[i];
+	}
+	b->nr = 0;
+}
+
+static void r5l_csum_add(struct r5l_log *log, struct stripe_head *sh,
+			 struct r5l_csum_batch *b, int i)
+{
+	b->devs[b->nr] = i;
+	b->crcs[b->nr] = log->uuid_checksum;
+	b->bufs[b->nr++] = kmap_local_page(sh->dev[i].page);
+	if (b->nr == R5L_CSUM_BATCH)
+		r5l_csum_flush(sh, b);
+}
+
 /*
  * running in raid5d, where reclaim could wait for raid5d too (when it flushes
  * data from log to raid disks), so we shouldn't wait for reclaim here
@@ -989,6 +1025,7 @@ static inline void r5l_add_no_space_stripe(struct r5l_log *log,
 int r5l_write_stripe(struct r5l_log *log, struct stripe_head *sh)
 {
 	struct r5conf *conf = sh->raid_conf;
+	struct r5l_csum_batch csum = { .nr = 0 };
 	int write_disks = 0;
 	int data_pages, parity_pages;
 	int reserve;
@@ -1009,8 +1046,6 @@ int r5l_write_stripe(struct r5l_log *log, struct stripe_head *sh)
 	WARN_ON(test_bit(STRIPE_R5C_CACHING, &sh->state));
 
 	for (i = 0; i < sh->disks; i++) {
-		void *addr;
-
 		if (!test_bit(R5_Wantwrite, &sh->dev[i].flags) ||
 		    test_bit(R5_InJournal, &sh->dev[i].flags))
 			continue;
@@ -1019,11 +1054,10 @@ int r5l_write_stripe(struct r5l_log *log, struct stripe_head *sh)
 		/* checksum is already calculated in last run */
 		if (test_bit(STRIPE_LOG_TRAPPED, &sh->state))
 			continue;
-		addr = kmap_local_page(sh->dev[i].page);
-		sh->dev[i].log_checksum = crc32c(log->uuid_checksum,
-						 addr, PAGE_SIZE);
-		kunmap_local(addr);
+		r5l_csum_add(log, sh, &csum, i);
 	}
+	if (csum.nr)
+		r5l_csum_flush(sh, &csum);
 	parity_pages = 1 + !!(sh->qd_idx >= 0);
 	data_pages = write_disks - parity_pages;
 
@@ -2871,6 +2905,7 @@ void r5c_finish_stripe_write_out(struct r5conf *conf,
 int r5c_cache_data(struct r5l_log *log, struct stripe_head *sh)
 {
 	struct r5conf *conf = sh->raid_conf;
+	struct r5l_csum_batch csum = { .nr = 0 };
 	int pages = 0;
 	int reserve;
 	int i;
@@ -2879,16 +2914,13 @@ int r5c_cache_data(struct r5l_log *log, struct stripe_head *sh)
 	BUG_ON(!log);
 
 	for (i = 0; i < sh->disks; i++) {
-		void *addr;
-
 		if (!test_bit(R5_Wantwrite, &sh->dev[i].flags))
 			continue;
-		addr = kmap_local_page(sh->dev[i].page);
-		sh->dev[i].log_checksum = crc32c(log->uuid_checksum,
-						 addr, PAGE_SIZE);
-		kunmap_local(addr);
+		r5l_csum_add(log, sh, &csum, i);
 		pages++;
 	}
+	if (csum.nr)
+		r5l_csum_flush(sh, &csum);
 	WARN_ON(pages == 0);
 
 	/*
@@ -426,7 +426,7 @@ static inline void remove_hash(struct stripe_head *sh)
 	pr_debug("remove_hash(), stripe %llu\n",
 		(unsigned long long)sh->sector);
 
-	hlist_del_init(&sh->hash);
+	hlist_del_init_rcu(&sh->hash);
 }
 
 static inline void insert_hash(struct r5conf *conf, struct stripe_head *sh)
@@ -436,7 +436,7 @@ static inline void insert_hash(struct r5conf *conf, struct stripe_head *sh)
 	pr_debug("insert_hash(), stripe %llu\n",
 		(unsigned long long)sh->sector);
 
-	hlist_add_head(&sh->hash, hp);
+	hlist_add_head_rcu(&sh->hash, hp);
 }
 
 /* find an idle stripe, make sure it is unhashed, and return it. */
@@ -628,6 +628,39 @@ static struct stripe_head *__find_stripe(struct r5conf *conf, sector_t sector,
 	return NULL;
 }
 
+/*
+ * Look up an active stripe without the hash lock.  The stripe cache is
+ * SLAB_TYPESAFE_BY_RCU and stripes stay hashed while inactive, so the walk
+ * may meet stripes that are being recycled for another sector or have come
+ * off the chain: only a reference taken on a stripe that still matches and
+ * is still hashed afterwards counts.  Anything else, including a stripe
+ * with no reference that has to come off an inactive list, is left to the
+ * locked lookup.
+ */
+static struct stripe_head *find_get_stripe_rcu(struct r5conf *conf,
+		sector_t sector, short generation)
+{
+	struct stripe_head *sh;
+
+	rcu_read_lock();
+	hlist_for_each_entry_rcu(sh, stripe_hash(conf, sector), hash) {
+		if (READ_ONCE(sh->sector) != sector ||
+		    READ_ONCE(sh->generation) != generation)
+			continue;
+		if (!atomic_inc_not_zero(&sh->count))
+			break;
+		rcu_read_unlock();
+
+		if (sh->sector == sector && sh->generation == generation &&
+		    !hlist_unhashed_lockless(&sh->hash))
+			return sh;
+		raid5_release_stripe(sh);
+		return NULL;
+	}
+	rcu_read_unlock();
+	return NULL;
+}
+
 static struct stripe_head *find_get_stripe(struct r5conf *conf,
 		sector_t sector, short generation, int hash)
 {
@@ -810,6 +843,18 @@ struct stripe_head *raid5_get_active_stripe(struct r5conf *conf,
 
 	pr_debug("get_stripe, sector %llu\n", (unsigned long long)sector);
 
+	/*
+	 * Random writes mostly hit stripes that are already active; those
+	 * need neither the hash lock nor the device_lock.
+	 */
+	if ((flags & R5_GAS_NOQUIESCE) || !READ_ONCE(conf->quiesce)) {
+		short generation = READ_ONCE(conf->generation) - previous;
+
+		sh = find_get_stripe_rcu(conf, sector, generation);
+		if (sh)
+			return sh;
+	}
+
 	spin_lock_irq(conf->hash_locks + hash);
 
 	for (;;) {
@@ -841,6 +886,8 @@ struct stripe_head *raid5_get_active_stripe(struct r5conf *conf,
 			if (sh) {
 				r5c_check_stripe_cache_usage(conf);
 				init_stripe(sh, sector, previous);
+				/* pairs with find_get_stripe_rcu() */
+				smp_mb__before_atomic();
 				atomic_inc(&sh->count);
 				break;
 			}
@@ -2423,7 +2470,7 @@ static int grow_stripes(struct r5conf *conf, int num)
 	conf->active_name = 0;
 	sc = kmem_cache_create(conf->cache_name[conf->active_name],
 			       struct_size_t(struct stripe_head, dev, devs),
-			       0, 0, NULL);
+			       0, SLAB_TYPESAFE_BY_RCU, NULL);
 	if (!sc)
 		return 1;
 	conf->slab_cache = sc;
@@ -2547,7 +2594,7 @@ static int resize_stripes(struct r5conf *conf, int newsize)
 	/* Step 1 */
 	sc = kmem_cache_create(conf->cache_name[1-conf->active_name],
 			       struct_size_t(struct stripe_head, dev, newsize),
-			       0, 0, NULL);
+			       0, SLAB_TYPESAFE_BY_RCU, NULL);
 	if (!sc)
 		return -ENOMEM;
 
@@ -558,9 +558,24 @@ static void sg_fill_dma(struct scatterlist *sg, dma_addr_t addr, u32 len)
 	sg_dma_len(sg) = len;
 }
 
+/* Outside of NAPI there is no per-CPU skb cache to return to, so gather
+ * the completed skbs and free them in bulk.
+ */
+static void virtnet_consume_skb(struct sk_buff *skb, bool in_napi,
+				struct sk_buff **done)
+{
+	if (in_napi) {
+		napi_consume_skb(skb, in_napi);
+		return;
+	}
+	skb->next = *done;
+	*done = skb;
+}
+
 static void __free_old_xmit(struct send_queue *sq, struct netdev_queue *txq,
 			    bool in_napi, struct virtnet_sq_free_stats *stats)
 {
+	struct sk_buff *done = NULL;
 	struct xdp_frame *frame;
 	struct sk_buff *skb;
 	unsigned int len;
@@ -574,7 +589,7 @@ static void __free_old_xmit(struct send_queue *sq, struct netdev_queue *txq,
 			pr_debug("Sent skb %p\n", skb);
 			stats->napi_packets++;
 			stats->napi_bytes += skb->len;
-			napi_consume_skb(skb, in_napi);
+			virtnet_consume_skb(skb, in_napi, &done);
 			break;
 
 		case VIRTNET_XMIT_TYPE_SKB_ORPHAN:
@@ -582,7 +597,7 @@ static void __free_old_xmit(struct send_queue *sq, struct netdev_queue *txq,
 
 			stats->packets++;
 			stats->bytes += skb->len;
-			napi_consume_skb(skb, in_napi);
+			virtnet_consume_skb(skb, in_napi, &done);
 			break;
 
 		case VIRTNET_XMIT_TYPE_XDP:
@@ -599,6 +614,8 @@ static void __free_old_xmit(struct send_queue *sq, struct netdev_queue *txq,
 			break;
 		}
 	}
+	if (done)
+		dev_consume_skb_list_any(done);
 	netdev_tx_completed_queue(txq, stats->napi_packets, stats->napi_bytes);
 }
 
@@ -43,6 +43,22 @@ static bool wq_unbound;
 module_param(wq_unbound, bool, 0644);
 MODULE_PARM_DESC(wq_unbound, "Use unbound workqueue for nvme-tcp IO context (default false)");
 
+/*
+ * Run io_work on the cpu that last processed the socket's receive path
+ * (typically the one steered to by RSS/aRFS) instead of the cpu picked
+ * from the blk-mq queue map, so that send and receive processing share
+ * the socket's cache footprint.
+ */
+static bool wq_follow_rx;
+module_param(wq_follow_rx, bool, 0644);
+MODULE_PARM_DESC(wq_follow_rx, "Run nvme-tcp IO context on the socket's receive cpu (default false)");
+
+/*
+ * Maximum number of command capsules without inline data that are
+ * coalesced into a single sendmsg call.
+ */
+#define NVME_TCP_SEND_BATCH	16
+
 /*
  * TLS handshake timeout
  */
@@ -142,6 +158,7 @@ struct nvme_tcp_queue {
 	struct socket		*sock;
 	struct work_struct	io_work;
 	int			io_cpu;
+	int			rx_cpu;
 
 	struct mutex		queue_lock;
 	struct mutex		send_mutex;
@@ -380,6 +397,23 @@ static inline void nvme_tcp_advance_req(struct nvme_tcp_request *req,
 	}
 }
 
+static inline int nvme_tcp_io_work_cpu(struct nvme_tcp_queue *queue)
+{
+	if (wq_follow_rx) {
+		int cpu = READ_ONCE(queue->rx_cpu);
+
+		if (cpu != WORK_CPU_UNBOUND && cpu_online(cpu))
+			return cpu;
+	}
+	return queue->io_cpu;
+}
+
+static inline void nvme_tcp_queue_io_work(struct nvme_tcp_queue *queue)
+{
+	queue_work_on(nvme_tcp_io_work_cpu(queue), nvme_tcp_wq,
+		      &queue->io_work);
+}
+
 static inline void nvme_tcp_send_all(struct nvme_tcp_queue *queue)
 {
 	int ret;
@@ -416,14 +450,14 @@ static inline void nvme_tcp_queue_request(struct nvme_tcp_request *req,
 	 * directly, otherwise queue io_work. Also, only do that if we
 	 * are on the same cpu, so we don't introduce contention.
 	 */
-	if (queue->io_cpu == raw_smp_processor_id() &&
+	if (nvme_tcp_io_work_cpu(queue) == raw_smp_processor_id() &&
 	    sync && empty && mutex_trylock(&queue->send_mutex)) {
 		nvme_tcp_send_all(queue);
 		mutex_unlock(&queue->send_mutex);
 	}
 
 	if (last && nvme_tcp_queue_has_pending(queue))
-		queue_work_on(queue->io_cpu, nvme_tcp_wq, &queue->io_work);
+		nvme_tcp_queue_io_work(queue);
 }
 
 static void nvme_tcp_process_req_list(struct nvme_tcp_queue *queue)
@@ -1050,8 +1084,11 @@ static void nvme_tcp_data_ready(struct sock *sk)
 	read_lock_bh(&sk->sk_callback_lock);
 	queue = sk->sk_user_data;
 	if (likely(queue && queue->rd_enabled) &&
-	    !test_bit(NVME_TCP_Q_POLLING, &queue->flags))
-		queue_work_on(queue->io_cpu, nvme_tcp_wq, &queue->io_work);
+	    !test_bit(NVME_TCP_Q_POLLING, &queue->flags)) {
+		if (wq_follow_rx)
+			WRITE_ONCE(queue->rx_cpu, raw_smp_processor_id());
+		nvme_tcp_queue_io_work(queue);
+	}
 	read_unlock_bh(&sk->sk_callback_lock);
 }
 
@@ -1063,7 +1100,7 @@ static void nvme_tcp_write_space(struct sock *sk)
 	queue = sk->sk_user_data;
 	if (likely(queue && sk_stream_is_writeable(sk))) {
 		clear_bit(SOCK_NOSPACE, &sk->sk_socket->flags);
-		queue_work_on(queue->io_cpu, nvme_tcp_wq, &queue->io_work);
+		nvme_tcp_queue_io_work(queue);
 	}
 	read_unlock_bh(&sk->sk_callback_lock);
 }
@@ -1218,6 +1255,79 @@ static int nvme_tcp_try_send_cmd_pdu(struct nvme_tcp_request *req)
 	return -EAGAIN;
 }
 
+static inline bool nvme_tcp_can_batch_cmd_pdu(struct nvme_tcp_request *req)
+{
+	return req->state == NVME_TCP_SEND_CMD_PDU && !req->offset &&
+		!nvme_tcp_has_inline_data(req);
+}
+
+/*
+ * Send the command capsule of queue->request along with those of the
+ * following requests on the send list in one sendmsg call, as long as
+ * none of them carries inline data. A request whose capsule went out
+ * entirely may complete at any time, so only the lengths recorded
+ * before sending are used to account for those afterwards.
+ */
+static int nvme_tcp_try_send_cmd_batch(struct nvme_tcp_queue *queue)
+{
+	struct nvme_tcp_request *reqs[NVME_TCP_SEND_BATCH];
+	struct bio_vec bvec[NVME_TCP_SEND_BATCH];
+	struct msghdr msg = { .msg_flags = MSG_DONTWAIT | MSG_SPLICE_PAGES, };
+	u8 hdgst = nvme_tcp_hdgst_len(queue);
+	int len = sizeof(struct nvme_tcp_cmd_pdu) + hdgst;
+	int nr = 0, sent, partial, i, ret;
+
+	reqs[nr++] = queue->request;
+	while (nr < NVME_TCP_SEND_BATCH) {
+		struct nvme_tcp_request *req = nvme_tcp_fetch_request(queue);
+
+		if (!req)
+			break;
+		if (!nvme_tcp_can_batch_cmd_pdu(req)) {
+			list_add(&req->entry, &queue->send_list);
+			break;
+		}
+		reqs[nr++] = req;
+	}
+
+	for (i = 0; i < nr; i++) {
+		struct nvme_tcp_cmd_pdu *pdu = nvme_tcp_req_cmd_pdu(reqs[i]);
+
+		if (queue->hdr_digest)
+			nvme_tcp_hdgst(queue->snd_hash, pdu, sizeof(*pdu));
+		bvec_set_virt(&bvec[i], pdu, len);
+	}
+
+	if (nvme_tcp_queue_more(queue))
+		msg.msg_flags |= MSG_MORE;
+	else
+		msg.msg_flags |= MSG_EOR;
+
+	iov_iter_bvec(&msg.msg_iter, ITER_SOURCE, bvec, nr, nr * len);
+	ret = sock_sendmsg(queue->sock, &msg);
+	if (unlikely(ret <= 0)) {
+		while (--nr > 0)
+			list_add(&reqs[nr]->entry, &queue->send_list);
+		return ret;
+	}
+
+	sent = ret / len;
+	partial = ret % len;
+
+	/* put back what wasn't sent at all, keeping the original order */
+	while (--nr >= sent + !!partial)
+		list_add(&reqs[nr]->entry, &queue->send_list);
+
+	if (partial) {
+		queue->request = reqs[sent];
+		queue->request->offset = partial;
+		return sent ? 1 : -EAGAIN;
+	}
+
+	nvme_tcp_done_send_req(queue);
+	return 1;
+}
+
 static int nvme_tcp_try_send_data_pdu(struct nvme_tcp_request *req)
 {
 	struct nvme_tcp_queue *queue = req->queue;
@@ -1299,6 +1409,12 @@ static int nvme_tcp_try_send(struct nvme_tcp_queue *queue)
 	req = queue->request;
 
 	noreclaim_flag = memalloc_noreclaim_save();
+	if (!nvme_tcp_queue_tls(queue) && nvme_tcp_can_batch_cmd_pdu(req) &&
+	    nvme_tcp_queue_has_pending(queue)) {
+		ret = nvme_tcp_try_send_cmd_batch(queue);
+		goto done;
+	}
+
 	if (req->state == NVME_TCP_SEND_CMD_PDU) {
 		ret = nvme_tcp_try_send_cmd_pdu(req);
 		if (ret <= 0)
@@ -1381,7 +1497,7 @@ static void nvme_tcp_io_work(struct work_struct *w)
 
 	} while (!time_after(jiffies, deadline)); /* quota is exhausted */
 
-	queue_work_on(queue->io_cpu, nvme_tcp_wq, &queue->io_work);
+	nvme_tcp_queue_io_work(queue);
 }
 
 static void nvme_tcp_free_crypto(struct nvme_tcp_queue *queue)
@@ -1833,6 +1949,7 @@ static int nvme_tcp_alloc_queue(struct nvme_ctrl *nctrl, int qid,
 	queue->sock->sk->sk_allocation = GFP_ATOMIC;
 	queue->sock->sk->sk_use_task_frag = false;
 	queue->io_cpu = WORK_CPU_UNBOUND;
+	queue->rx_cpu = WORK_CPU_UNBOUND;
 	queue->request = NULL;
 	queue->data_remaining = 0;
 	queue->ddgst_remaining = 0;
@@ -2740,7 +2857,7 @@ static void nvme_tcp_commit_rqs(struct blk_mq_hw_ctx *hctx)
 	struct nvme_tcp_queue *queue = hctx->driver_data;
 
 	if (!llist_empty(&queue->req_list))
-		queue_work_on(queue->io_cpu, nvme_tcp_wq, &queue->io_work);
+		nvme_tcp_queue_io_work(queue);
 }
 
 static blk_status_t nvme_tcp_queue_rq(struct blk_mq_hw_ctx *hctx,
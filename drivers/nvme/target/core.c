@@ -1910,10 +1910,14 @@ static int __init nvmet_init(void)
 	if (!nvmet_wq)
 		goto out_free_buffered_work_queue;
 
-	error = nvmet_init_discovery();
+	error = nvmet_bdev_poll_init();
 	if (error)
 		goto out_free_nvmet_work_queue;
 
+	error = nvmet_init_discovery();
+	if (error)
+		goto out_exit_bdev_poll;
+
 	error = nvmet_init_debugfs();
 	if (error)
 		goto out_exit_discovery;
@@ -1928,6 +1932,8 @@ static int __init nvmet_init(void)
 	nvmet_exit_debugfs();
 out_exit_discovery:
 	nvmet_exit_discovery();
+out_exit_bdev_poll:
+	nvmet_bdev_poll_exit();
 out_free_nvmet_work_queue:
 	destroy_workqueue(nvmet_wq);
 out_free_buffered_work_queue:
@@ -1945,6 +1951,7 @@ static void __exit nvmet_exit(void)
 	nvmet_exit_debugfs();
 	nvmet_exit_discovery();
 	ida_destroy(&cntlid_ida);
+	nvmet_bdev_poll_exit();
 	destroy_workqueue(nvmet_wq);
 	destroy_workqueue(buffered_io_wq);
 	destroy_workqueue(zbd_wq);
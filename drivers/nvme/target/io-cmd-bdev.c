@@ -10,6 +10,21 @@
 #include <linux/module.h>
 #include "nvmet.h"
 
+/*
+ * Polled IO contexts. Polled bios are queued on the context of the cpu that
+ * submitted them, and a highpri work item on that cpu spins on bio_poll()
+ * until all of them have completed. Requests are only ever completed from
+ * that work item, so the bio and request stay valid while being polled.
+ */
+struct nvmet_bdev_poll_ctx {
+	spinlock_t		lock;
+	struct list_head	list;
+	struct work_struct	work;
+};
+
+static DEFINE_PER_CPU(struct nvmet_bdev_poll_ctx, nvmet_bdev_poll_ctx);
+static struct workqueue_struct *nvmet_bdev_poll_wq;
+
 void nvmet_bdev_set_limits(struct block_device *bdev, struct nvme_id_ns *id)
 {
 	/* Logical blocks per physical block, 0's based. */
@@ -107,6 +122,15 @@ int nvmet_bdev_ns_enable(struct nvmet_ns *ns)
 	if (IS_ENABLED(CONFIG_BLK_DEV_INTEGRITY))
 		nvmet_bdev_ns_enable_integrity(ns);
 
+	ns->bdev_poll = false;
+	if (ns->use_poll) {
+		if (bdev_get_queue(ns->bdev)->limits.features & BLK_FEAT_POLL)
+			ns->bdev_poll = true;
+		else
+			pr_info("%s doesn't support polling, using interrupts\n",
+				ns->device_path);
+	}
+
 	if (bdev_is_zoned(ns->bdev)) {
 		if (!nvmet_bdev_zns_enable(ns)) {
 			nvmet_bdev_ns_disable(ns);
@@ -188,6 +212,109 @@ static void nvmet_bio_done(struct bio *bio)
 	nvmet_req_bio_put(req, bio);
 }
 
+static void nvmet_bio_poll_done(struct bio *bio)
+{
+	struct nvmet_req *req = bio->bi_private;
+
+	req->b.poll_status = bio->bi_status;
+	/* pairs with smp_load_acquire() in nvmet_bdev_poll_work() */
+	smp_store_release(&req->b.poll_done, true);
+}
+
+static void nvmet_bdev_poll_work(struct work_struct *w)
+{
+	struct nvmet_bdev_poll_ctx *ctx =
+		container_of(w, struct nvmet_bdev_poll_ctx, work);
+	unsigned long deadline = jiffies + msecs_to_jiffies(1);
+	struct nvmet_req *req, *tmp;
+	LIST_HEAD(list);
+
+	do {
+		spin_lock_irq(&ctx->lock);
+		list_splice_tail_init(&ctx->list, &list);
+		spin_unlock_irq(&ctx->lock);
+
+		list_for_each_entry_safe(req, tmp, &list, b.poll_entry) {
+			struct bio *bio = req->b.poll_bio;
+
+			if (!smp_load_acquire(&req->b.poll_done)) {
+				bio_poll(bio, NULL, BLK_POLL_NOSLEEP);
+				if (!smp_load_acquire(&req->b.poll_done))
+					continue;
+			}
+
+			list_del(&req->b.poll_entry);
+			nvmet_req_complete(req,
+				blk_to_nvme_status(req, req->b.poll_status));
+			nvmet_req_bio_put(req, bio);
+		}
+
+		if (list_empty(&list))
+			return;
+		cond_resched();
+	} while (!time_after(jiffies, deadline)); /* quota is exhausted */
+
+	/* give other work on this cpu a chance, then carry on */
+	spin_lock_irq(&ctx->lock);
+	list_splice(&list, &ctx->list);
+	spin_unlock_irq(&ctx->lock);
+	queue_work_on(raw_smp_processor_id(), nvmet_bdev_poll_wq, &ctx->work);
+}
+
+static void nvmet_bdev_submit_polled(struct nvmet_req *req, struct bio *bio)
+{
+	struct nvmet_bdev_poll_ctx *ctx;
+	unsigned long flags;
+	bool kick;
+	int cpu;
+
+	req->b.poll_bio = bio;
+	req->b.poll_done = false;
+	bio->bi_opf |= REQ_POLLED;
+	bio->bi_end_io = nvmet_bio_poll_done;
+	submit_bio(bio);
+
+	cpu = get_cpu();
+	ctx = per_cpu_ptr(&nvmet_bdev_poll_ctx, cpu);
+	/*
+	 * Transports submit from process, softirq or hardirq context.  A
+	 * non-empty list means the poll work is already queued and will
+	 * pick this request up.
+	 */
+	spin_lock_irqsave(&ctx->lock, flags);
+	kick = list_empty(&ctx->list);
+	list_add_tail(&req->b.poll_entry, &ctx->list);
+	spin_unlock_irqrestore(&ctx->lock, flags);
+	if (kick)
+		queue_work_on(cpu, nvmet_bdev_poll_wq, &ctx->work);
+	put_cpu();
+}
+
+int nvmet_bdev_poll_init(void)
+{
+	int cpu;
+
+	nvmet_bdev_poll_wq = alloc_workqueue("nvmet-poll-wq",
+			WQ_HIGHPRI | WQ_MEM_RECLAIM, 0);
+	if (!nvmet_bdev_poll_wq)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu) {
+		struct nvmet_bdev_poll_ctx *ctx =
+			per_cpu_ptr(&nvmet_bdev_poll_ctx, cpu);
+
+		spin_lock_init(&ctx->lock);
+		INIT_LIST_HEAD(&ctx->list);
+		INIT_WORK(&ctx->work, nvmet_bdev_poll_work);
+	}
+	return 0;
+}
+
+void nvmet_bdev_poll_exit(void)
+{
+	destroy_workqueue(nvmet_bdev_poll_wq);
+}
+
 #ifdef CONFIG_BLK_DEV_INTEGRITY
 static int nvmet_bdev_alloc_bip(struct nvmet_req *req, struct bio *bio,
 				struct sg_mapping_iter *miter)
@@ -331,7 +458,15 @@ static void nvmet_bdev_execute_rw(struct nvmet_req *req)
 		}
 	}
 
-	submit_bio(bio);
+	/*
+	 * Only poll requests that fit into a single bio, i.e. nothing was
+	 * chained to the bio pointing at req. Chained bios would have to be
+	 * polled individually.
+	 */
+	if (req->ns->bdev_poll && bio->bi_private == req)
+		nvmet_bdev_submit_polled(req, bio);
+	else
+		submit_bio(bio);
 	blk_finish_plug(&plug);
 }
 
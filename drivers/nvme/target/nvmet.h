@@ -111,6 +111,8 @@ struct nvmet_ns {
 	u32			anagrpid;
 
 	bool			buffered_io;
+	bool			use_poll;
+	bool			bdev_poll;
 	bool			enabled;
 	struct nvmet_subsys	*subsys;
 	const char		*device_path;
@@ -451,6 +453,11 @@ struct nvmet_req {
 	union {
 		struct {
 			struct bio      inline_bio;
+			/* polled submission, see nvmet_bdev_poll_work() */
+			struct bio		*poll_bio;
+			struct list_head	poll_entry;
+			blk_status_t		poll_status;
+			bool			poll_done;
 		} b;
 		struct {
 			bool			mpool_alloc;
@@ -702,6 +709,8 @@ u16 nvmet_bdev_flush(struct nvmet_req *req);
 u16 nvmet_file_flush(struct nvmet_req *req);
 void nvmet_ns_changed(struct nvmet_subsys *subsys, u32 nsid);
 void nvmet_bdev_ns_revalidate(struct nvmet_ns *ns);
+int nvmet_bdev_poll_init(void);
+void nvmet_bdev_poll_exit(void);
 void nvmet_file_ns_revalidate(struct nvmet_ns *ns);
 bool nvmet_ns_revalidate(struct nvmet_ns *ns);
 u16 blk_to_nvme_status(struct nvmet_req *req, blk_status_t blk_sts);
@@ -53,6 +53,12 @@ MODULE_PARM_DESC(experimental_zcopytx, "Enable Zero Copy TX;"
 /* MAX number of TX used buffers for outstanding zerocopy */
 #define VHOST_MAX_PEND 128
 #define VHOST_GOODCOPY_LEN 256
+/* Largest packet still sent by copy when zerocopy completions are slow */
+#define VHOST_GOODCOPY_MAX_LEN 0x10000
+/* Zerocopy completion latency, in busy_clock() units, considered slow */
+#define VHOST_ZCOPY_SLOW_LAT 100
+/* Cap on a single latency sample, so that one outlier can't dominate */
+#define VHOST_ZCOPY_MAX_LAT (8 * VHOST_ZCOPY_SLOW_LAT)
 
 /*
  * For transmit, used buffer len is unused; we override it to track buffer
@@ -120,6 +126,10 @@ struct vhost_net_virtqueue {
 	int batched_xdp;
 	/* an array of userspace buffers info */
 	struct ubuf_info_msgzc *ubuf_info;
+	/* busy_clock() at submission of each ubuf_info entry, replaced by
+	 * the time to completion once the lower device is done with it
+	 */
+	unsigned long *ubuf_stamp;
 	/* Reference counting for outstanding ubufs.
 	 * Protected by vq mutex. Writers must also take device mutex. */
 	struct vhost_net_ubuf_ref *ubufs;
@@ -139,6 +149,14 @@ struct vhost_net {
 	/* Number of times zerocopy TX recently failed.
 	 * Protected by tx vq lock. */
 	unsigned tx_zcopy_err;
+	/* Smallest packet sent by zerocopy, adapted to the completion
+	 * latency of the lower device. Protected by tx vq lock. */
+	unsigned tx_goodcopy_len;
+	/* Moving average of zerocopy completion latency and number of
+	 * completions seen since the last adaptation.
+	 * Protected by tx vq lock. */
+	unsigned long tx_zcopy_lat;
+	unsigned tx_zcopy_done;
 	/* Flush in progress. Protected by tx vq lock. */
 	bool tx_flush;
 	/* Private page frag cache */
@@ -272,6 +290,8 @@ static void vhost_net_clear_ubuf_info(struct vhost_net *n)
 	for (i = 0; i < VHOST_NET_VQ_MAX; ++i) {
 		kfree(n->vqs[i].ubuf_info);
 		n->vqs[i].ubuf_info = NULL;
+		kfree(n->vqs[i].ubuf_stamp);
+		n->vqs[i].ubuf_stamp = NULL;
 	}
 }
 
@@ -290,6 +310,12 @@ static int vhost_net_set_ubuf_info(struct vhost_net *n)
 				      GFP_KERNEL);
 		if  (!n->vqs[i].ubuf_info)
 			goto err;
+		n->vqs[i].ubuf_stamp =
+			kmalloc_array(UIO_MAXIOV,
+				      sizeof(*n->vqs[i].ubuf_stamp),
+				      GFP_KERNEL);
+		if (!n->vqs[i].ubuf_stamp)
+			goto err;
 	}
 	return 0;
 
@@ -315,6 +341,28 @@ static void vhost_net_vq_reset(struct vhost_net *n)
 
 }
 
+static inline unsigned long busy_clock(void)
+{
+	return local_clock() >> 10;
+}
+
+/* Zerocopy holds the guest buffer until the lower device is done with it,
+ * which for a medium sized packet can cost more than copying it. Raise the
+ * size from which zerocopy is used while completions are slow, and lower
+ * it again once they are fast or no zerocopy was done for a while.
+ */
+static void vhost_net_tx_adapt_goodcopy(struct vhost_net *net)
+{
+	if (net->tx_zcopy_done && net->tx_zcopy_lat > VHOST_ZCOPY_SLOW_LAT)
+		net->tx_goodcopy_len = min_t(unsigned, net->tx_goodcopy_len * 2,
+					     VHOST_GOODCOPY_MAX_LEN);
+	else if (net->tx_zcopy_lat <= VHOST_ZCOPY_SLOW_LAT / 2 ||
+		 !net->tx_zcopy_done)
+		net->tx_goodcopy_len = max_t(unsigned, net->tx_goodcopy_len / 2,
+					     VHOST_GOODCOPY_LEN);
+	net->tx_zcopy_done = 0;
+}
+
 static void vhost_net_tx_packet(struct vhost_net *net)
 {
 	++net->tx_packets;
@@ -322,6 +370,7 @@ static void vhost_net_tx_packet(struct vhost_net *net)
 		return;
 	net->tx_packets = 0;
 	net->tx_zcopy_err = 0;
+	vhost_net_tx_adapt_goodcopy(net);
 }
 
 static void vhost_net_tx_err(struct vhost_net *net)
@@ -329,6 +378,13 @@ static void vhost_net_tx_err(struct vhost_net *net)
 	++net->tx_zcopy_err;
 }
 
+static void vhost_net_tx_zcopy_done(struct vhost_net *net, unsigned long lat)
+{
+	/* Moving average with weight 1/8 for the new sample */
+	net->tx_zcopy_lat = net->tx_zcopy_lat - net->tx_zcopy_lat / 8 + lat / 8;
+	++net->tx_zcopy_done;
+}
+
 static bool vhost_net_tx_select_zcopy(struct vhost_net *net)
 {
 	/* TX flush waits for outstanding DMAs to be done.
@@ -363,9 +419,13 @@ static void vhost_zerocopy_signal_used(struct vhost_net *net,
 	int j = 0;
 
 	for (i = nvq->done_idx; i != nvq->upend_idx; i = (i + 1) % UIO_MAXIOV) {
-		if (vq->heads[i].len == VHOST_DMA_FAILED_LEN)
+		/* pairs with the release in vhost_zerocopy_complete() */
+		__virtio32 len = smp_load_acquire(&vq->heads[i].len);
+
+		if (len == VHOST_DMA_FAILED_LEN)
 			vhost_net_tx_err(net);
-		if (VHOST_DMA_IS_DONE(vq->heads[i].len)) {
+		if (VHOST_DMA_IS_DONE(len)) {
+			vhost_net_tx_zcopy_done(net, nvq->ubuf_stamp[i]);
 			vq->heads[i].len = VHOST_DMA_CLEAR_LEN;
 			++j;
 		} else
@@ -386,13 +446,22 @@ static void vhost_zerocopy_complete(struct sk_buff *skb,
 	struct ubuf_info_msgzc *ubuf = uarg_to_msgzc(ubuf_base);
 	struct vhost_net_ubuf_ref *ubufs = ubuf->ctx;
 	struct vhost_virtqueue *vq = ubufs->vq;
+	struct vhost_net_virtqueue *nvq =
+		container_of(vq, struct vhost_net_virtqueue, vq);
+	long lat;
 	int cnt;
 
 	rcu_read_lock_bh();
 
-	/* set len to mark this desc buffers done DMA */
-	vq->heads[ubuf->desc].len = success ?
-		VHOST_DMA_DONE_LEN : VHOST_DMA_FAILED_LEN;
+	/* local_clock() isn't synchronized between the submitting and the
+	 * completing CPU, so the difference may be negative or way off.
+	 */
+	lat = (long)(busy_clock() - nvq->ubuf_stamp[ubuf->desc]);
+	nvq->ubuf_stamp[ubuf->desc] = clamp_t(long, lat, 0,
+					      VHOST_ZCOPY_MAX_LAT);
+	/* set len to mark this desc buffers done DMA, publishing the stamp */
+	smp_store_release(&vq->heads[ubuf->desc].len, success ?
+			  VHOST_DMA_DONE_LEN : VHOST_DMA_FAILED_LEN);
 	cnt = vhost_net_ubuf_put(ubufs);
 
 	/*
@@ -412,11 +481,6 @@ static const struct ubuf_info_ops vhost_ubuf_ops = {
 	.complete = vhost_zerocopy_complete,
 };
 
-static inline unsigned long busy_clock(void)
-{
-	return local_clock() >> 10;
-}
-
 static bool vhost_can_busy_poll(unsigned long endtime)
 {
 	return likely(!need_resched() && !time_after(busy_clock(), endtime) &&
@@ -872,7 +936,7 @@ static void handle_tx_zerocopy(struct vhost_net *net, struct socket *sock)
 			break;
 		}
 
-		zcopy_used = len >= VHOST_GOODCOPY_LEN
+		zcopy_used = len >= net->tx_goodcopy_len
 			     && !vhost_exceeds_maxpend(net)
 			     && vhost_net_tx_select_zcopy(net);
 
@@ -881,6 +945,7 @@ static void handle_tx_zerocopy(struct vhost_net *net, struct socket *sock)
 			ubuf = nvq->ubuf_info + nvq->upend_idx;
 			vq->heads[nvq->upend_idx].id = cpu_to_vhost32(vq, head);
 			vq->heads[nvq->upend_idx].len = VHOST_DMA_IN_PROGRESS;
+			nvq->ubuf_stamp[nvq->upend_idx] = busy_clock();
 			ubuf->ctx = nvq->ubufs;
 			ubuf->desc = nvq->upend_idx;
 			ubuf->ubuf.ops = &vhost_ubuf_ops;
@@ -910,8 +975,10 @@ static void handle_tx_zerocopy(struct vhost_net *net, struct socket *sock)
 			bool retry = err == -EAGAIN || err == -ENOMEM || err == -ENOBUFS;
 
 			if (zcopy_used) {
-				if (vq->heads[ubuf->desc].len == VHOST_DMA_IN_PROGRESS)
+				if (vq->heads[ubuf->desc].len == VHOST_DMA_IN_PROGRESS) {
 					vhost_net_ubuf_put(ubufs);
+					nvq->ubuf_stamp[ubuf->desc] = 0;
+				}
 				if (retry)
 					nvq->upend_idx = ((unsigned)nvq->upend_idx - 1)
 						% UIO_MAXIOV;
@@ -1309,6 +1376,7 @@ static int vhost_net_open(struct inode *inode, struct file *f)
 	for (i = 0; i < VHOST_NET_VQ_MAX; i++) {
 		n->vqs[i].ubufs = NULL;
 		n->vqs[i].ubuf_info = NULL;
+		n->vqs[i].ubuf_stamp = NULL;
 		n->vqs[i].upend_idx = 0;
 		n->vqs[i].done_idx = 0;
 		n->vqs[i].batched_xdp = 0;
@@ -1537,6 +1605,9 @@ static long vhost_net_set_backend(struct vhost_net *n, unsigned index, int fd)
 
 		n->tx_packets = 0;
 		n->tx_zcopy_err = 0;
+		n->tx_goodcopy_len = VHOST_GOODCOPY_LEN;
+		n->tx_zcopy_lat = 0;
+		n->tx_zcopy_done = 0;
 		n->tx_flush = false;
 	}
 
@@ -1708,6 +1779,14 @@ static long vhost_net_ioctl(struct file *f, unsigned int ioctl,
 		return vhost_net_reset_owner(n);
 	case VHOST_SET_OWNER:
 		return vhost_net_set_owner(n);
+	case VHOST_NEW_WORKER:
+	case VHOST_FREE_WORKER:
+	case VHOST_ATTACH_VRING_WORKER:
+	case VHOST_GET_VRING_WORKER:
+		mutex_lock(&n->dev.mutex);
+		r = vhost_worker_ioctl(&n->dev, ioctl, argp);
+		mutex_unlock(&n->dev.mutex);
+		return r;
 	default:
 		mutex_lock(&n->dev.mutex);
 		r = vhost_dev_ioctl(&n->dev, ioctl, argp);
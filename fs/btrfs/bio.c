@@ -256,6 +256,118 @@ static struct btrfs_failed_bio *repair_one_sector(struct btrfs_bio *failed_bbio,
 	return fbio;
 }
 
+/*
+ * Data read bios at least this large have their checksums verified by
+ * several endio workers, each taking a chunk of the bio.
+ */
+#define BTRFS_CSUM_PARALLEL_MIN		SZ_512K
+#define BTRFS_CSUM_PARALLEL_CHUNK	SZ_128K
+#define BTRFS_CSUM_PARALLEL_MAX_CHUNKS	8
+
+struct btrfs_csum_chunk {
+	struct work_struct work;
+	struct btrfs_csum_verify *verify;
+	unsigned int index;
+};
+
+struct btrfs_csum_verify {
+	struct btrfs_bio *bbio;
+	/* one bit per sector whose checksum matched */
+	unsigned long *ok;
+	unsigned long claimed;
+	u32 chunk_len;
+	unsigned int nr_chunks;
+	struct btrfs_csum_chunk chunks[];
+};
+
+static void btrfs_verify_csum_chunk(struct btrfs_csum_verify *verify,
+				    unsigned int index)
+{
+	struct btrfs_bio *bbio = verify->bbio;
+	struct btrfs_fs_info *fs_info = bbio->fs_info;
+	u32 sectorsize = fs_info->sectorsize;
+	struct bvec_iter iter = bbio->saved_iter;
+	u32 offset = index * verify->chunk_len;
+	u32 end = min(offset + verify->chunk_len, iter.bi_size);
+	u8 csum[BTRFS_CSUM_SIZE];
+
+	if (test_and_set_bit(index, &verify->claimed))
+		return;
+
+	bio_advance_iter(&bbio->bio, &iter, offset);
+	for (; offset < end; offset += sectorsize) {
+		struct bio_vec bv = bio_iter_iovec(&bbio->bio, iter);
+		u32 sector = offset >> fs_info->sectorsize_bits;
+
+		if (!btrfs_check_sector_csum(fs_info, bv.bv_page, bv.bv_offset,
+					     csum, bbio->csum +
+					     sector * fs_info->csum_size))
+			set_bit(sector, verify->ok);
+		bio_advance_iter_single(&bbio->bio, &iter, sectorsize);
+	}
+}
+
+static void btrfs_verify_csum_work(struct work_struct *work)
+{
+	struct btrfs_csum_chunk *chunk =
+		container_of(work, struct btrfs_csum_chunk, work);
+
+	btrfs_verify_csum_chunk(chunk->verify, chunk->index);
+}
+
+/*
+ * Check the checksums of a large data read bio on several CPUs.
+ *
+ * The caller goes through all chunks itself as well, so this never waits
+ * for a worker that has not started; chunks nobody claimed by then are
+ * cancelled.  Only the pure checksum comparison is done here: the sectors
+ * it could not vouch for still go through btrfs_data_csum_ok(), which does
+ * the reporting and repair.
+ *
+ * Return: a bitmap of the sectors known to be good, or NULL.
+ */
+static unsigned long *btrfs_verify_csums_parallel(struct btrfs_bio *bbio)
+{
+	struct btrfs_fs_info *fs_info = bbio->fs_info;
+	u32 size = bbio->saved_iter.bi_size;
+	struct btrfs_csum_verify *verify;
+	unsigned long *ok;
+	unsigned int i, nr;
+
+	if (size < BTRFS_CSUM_PARALLEL_MIN || !bbio->csum ||
+	    btrfs_is_data_reloc_root(bbio->inode->root))
+		return NULL;
+
+	nr = min(DIV_ROUND_UP(size, BTRFS_CSUM_PARALLEL_CHUNK),
+		 BTRFS_CSUM_PARALLEL_MAX_CHUNKS);
+	verify = kzalloc(struct_size(verify, chunks, nr), GFP_NOFS);
+	if (!verify)
+		return NULL;
+	verify->ok = bitmap_zalloc(size >> fs_info->sectorsize_bits, GFP_NOFS);
+	if (!verify->ok) {
+		kfree(verify);
+		return NULL;
+	}
+	verify->bbio = bbio;
+	verify->chunk_len = round_up(DIV_ROUND_UP(size, nr), fs_info->sectorsize);
+	verify->nr_chunks = DIV_ROUND_UP(size, verify->chunk_len);
+
+	for (i = 1; i < verify->nr_chunks; i++) {
+		verify->chunks[i].verify = verify;
+		verify->chunks[i].index = i;
+		INIT_WORK(&verify->chunks[i].work, btrfs_verify_csum_work);
+		queue_work(fs_info->endio_workers, &verify->chunks[i].work);
+	}
+	for (i = 0; i < verify->nr_chunks; i++)
+		btrfs_verify_csum_chunk(verify, i);
+	for (i = 1; i < verify->nr_chunks; i++)
+		cancel_work_sync(&verify->chunks[i].work);
+
+	ok = verify->ok;
+	kfree(verify);
+	return ok;
+}
+
 static void btrfs_check_read_bio(struct btrfs_bio *bbio, struct btrfs_device *dev)
 {
 	struct btrfs_inode *inode = bbio->inode;
@@ -264,6 +376,7 @@ static void btrfs_check_read_bio(struct btrfs_bio *bbio, struct btrfs_device *de
 	struct bvec_iter *iter = &bbio->saved_iter;
 	blk_status_t status = bbio->bio.bi_status;
 	struct btrfs_failed_bio *fbio = NULL;
+	unsigned long *ok = NULL;
 	u32 offset = 0;
 
 	/* Read-repair requires the inode field to be set by the submitter. */
@@ -281,16 +394,23 @@ static void btrfs_check_read_bio(struct btrfs_bio *bbio, struct btrfs_device *de
 	/* Clear the I/O error. A failed repair will reset it. */
 	bbio->bio.bi_status = BLK_STS_OK;
 
+	if (!status)
+		ok = btrfs_verify_csums_parallel(bbio);
+
 	while (iter->bi_size) {
 		struct bio_vec bv = bio_iter_iovec(&bbio->bio, *iter);
+		bool verified = ok &&
+			test_bit(offset >> fs_info->sectorsize_bits, ok);
 
 		bv.bv_len = min(bv.bv_len, sectorsize);
-		if (status || !btrfs_data_csum_ok(bbio, dev, offset, &bv))
+		if (!verified &&
+		    (status || !btrfs_data_csum_ok(bbio, dev, offset, &bv)))
 			fbio = repair_one_sector(bbio, offset, &bv, fbio);
 
 		bio_advance_iter_single(&bbio->bio, iter, sectorsize);
 		offset += sectorsize;
 	}
+	bitmap_free(ok);
 
 	if (bbio->csum != bbio->csum_inline)
 		kfree(bbio->csum);
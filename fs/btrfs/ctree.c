@@ -1943,6 +1943,134 @@ static int search_leaf(struct btrfs_trans_handle *trans,
 	return ret;
 }
 
+/*
+ * Binary search of a node that is not locked.  Unlike btrfs_bin_search() this
+ * never trusts the header to stay within the buffer, since it may be read
+ * in the middle of an update.
+ */
+static int optimistic_node_slot(struct extent_buffer *eb,
+				const struct btrfs_key *key, int *slot)
+{
+	u32 low = 0;
+	u32 high = btrfs_header_nritems(eb);
+
+	if (high == 0 || high > BTRFS_NODEPTRS_PER_BLOCK(eb->fs_info))
+		return -EAGAIN;
+
+	while (low < high) {
+		struct btrfs_disk_key disk_key;
+		u32 mid = (low + high) / 2;
+		int ret;
+
+		btrfs_node_key(eb, &disk_key, mid);
+		ret = btrfs_comp_keys(&disk_key, key);
+		if (ret < 0) {
+			low = mid + 1;
+		} else if (ret > 0) {
+			high = mid;
+		} else {
+			*slot = mid;
+			return 0;
+		}
+	}
+	*slot = low;
+	return 1;
+}
+
+/*
+ * Walk down to the leaf of a read-only search without locking the nodes
+ * above it.  Each node is read under its lock sequence, and a child is only
+ * used once the parent is known to have not been write locked since the
+ * child pointer was read, neither before reading the child's own sequence.
+ * The leaf is then read locked and the parent checked once more, which
+ * leaves the path just as a locked search would: references on every level
+ * and only the leaf locked.
+ *
+ * Return -EAGAIN if any node changed, was not cached or could not be locked;
+ * the path is released and the caller falls back to a locked search.
+ */
+static int search_slot_optimistic(struct btrfs_root *root,
+				  const struct btrfs_key *key,
+				  struct btrfs_path *p)
+{
+	struct btrfs_fs_info *fs_info = root->fs_info;
+	struct btrfs_tree_parent_check check = { 0 };
+	struct extent_buffer *b;
+	struct extent_buffer *child;
+	unsigned int seq;
+	unsigned int child_seq;
+	int prev_cmp = -1;
+	int level;
+	int slot;
+	int ret;
+
+	b = btrfs_root_node(root);
+	seq = btrfs_tree_read_seq_begin(b);
+	level = btrfs_header_level(b);
+	p->nodes[level] = b;
+	if (level == 0 || rcu_access_pointer(root->node) != b ||
+	    !extent_buffer_uptodate(b))
+		goto fallback;
+
+	while (1) {
+		if (prev_cmp == 0) {
+			slot = 0;
+			ret = 0;
+		} else {
+			ret = optimistic_node_slot(b, key, &slot);
+			if (ret < 0)
+				goto fallback;
+		}
+		prev_cmp = ret;
+		if (ret && slot > 0)
+			slot--;
+		p->slots[level] = slot;
+
+		check.transid = btrfs_node_ptr_generation(b, slot);
+		btrfs_node_key_to_cpu(b, &check.first_key, slot);
+		check.has_first_key = true;
+		check.level = level - 1;
+		check.owner_root = btrfs_root_id(root);
+		child = find_extent_buffer(fs_info, btrfs_node_blockptr(b, slot));
+		if (btrfs_tree_read_seq_retry(b, seq) || !child)
+			goto fallback_child;
+		if (btrfs_buffer_uptodate(child, check.transid, 1) <= 0)
+			goto fallback_child;
+
+		if (level == 1) {
+			btrfs_maybe_reset_lockdep_class(root, child);
+			if (p->nowait) {
+				if (!btrfs_try_tree_read_lock(child))
+					goto fallback_child;
+			} else {
+				btrfs_tree_read_lock(child);
+			}
+			p->nodes[0] = child;
+			p->locks[0] = BTRFS_READ_LOCK;
+			if (btrfs_tree_read_seq_retry(b, seq) ||
+			    btrfs_header_level(child) != 0 ||
+			    btrfs_verify_level_key(child, &check))
+				goto fallback;
+			return search_leaf(NULL, root, key, p, 0, prev_cmp);
+		}
+
+		child_seq = btrfs_tree_read_seq_begin(child);
+		level--;
+		p->nodes[level] = child;
+		if (btrfs_tree_read_seq_retry(b, seq) ||
+		    btrfs_header_level(child) != level)
+			goto fallback;
+		b = child;
+		seq = child_seq;
+	}
+
+fallback_child:
+	free_extent_buffer(child);
+fallback:
+	btrfs_release_path(p);
+	return -EAGAIN;
+}
+
 /*
  * Look for a key in a tree and perform necessary modifications to preserve
  * tree invariants.
@@ -2043,6 +2171,17 @@ int btrfs_search_slot(struct btrfs_trans_handle *trans, struct btrfs_root *root,
 		}
 	}
 
+	/*
+	 * Plain searches that leave only the leaf locked can usually get there
+	 * without touching the locks of the nodes above it.
+	 */
+	if (!cow && !lowest_level && !p->keep_locks && !p->skip_locking &&
+	    !p->search_commit_root && p->reada != READA_FORWARD_ALWAYS) {
+		ret = search_slot_optimistic(root, key, p);
+		if (ret != -EAGAIN)
+			goto done;
+	}
+
 again:
 	prev_cmp = -1;
 	b = btrfs_search_slot_get_root(root, p, write_lock_level);
@@ -112,6 +112,8 @@ struct extent_buffer {
 	struct rcu_head rcu_head;
 
 	struct rw_semaphore lock;
+	/* Odd while write locked, see btrfs_tree_read_seq_begin(). */
+	unsigned int lock_seq;
 
 	/*
 	 * Pointers to all the folios of the extent buffer.
@@ -186,6 +186,8 @@ void btrfs_tree_lock_nested(struct extent_buffer *eb, enum btrfs_lock_nesting ne
 		start_ns = ktime_get_ns();
 
 	down_write_nested(&eb->lock, nest);
+	WRITE_ONCE(eb->lock_seq, eb->lock_seq + 1);
+	smp_wmb();
 	btrfs_set_eb_lock_owner(eb, current->pid);
 	trace_btrfs_tree_lock(eb, start_ns);
 }
@@ -197,6 +199,8 @@ void btrfs_tree_unlock(struct extent_buffer *eb)
 {
 	trace_btrfs_tree_unlock(eb);
 	btrfs_set_eb_lock_owner(eb, 0);
+	smp_wmb();
+	WRITE_ONCE(eb->lock_seq, eb->lock_seq + 1);
 	up_write(&eb->lock);
 }
 
@@ -190,6 +190,27 @@ static inline void btrfs_tree_read_lock(struct extent_buffer *eb)
 
 void btrfs_tree_read_unlock(struct extent_buffer *eb);
 int btrfs_try_tree_read_lock(struct extent_buffer *eb);
+
+/*
+ * Lockless reads of an extent buffer: whatever was read between
+ * btrfs_tree_read_seq_begin() and a btrfs_tree_read_seq_retry() that
+ * returns false is what the buffer held while nobody had it write locked.
+ * Data read otherwise may be torn and must not be used.
+ */
+static inline unsigned int btrfs_tree_read_seq_begin(const struct extent_buffer *eb)
+{
+	unsigned int seq = READ_ONCE(eb->lock_seq);
+
+	smp_rmb();
+	return seq;
+}
+
+static inline bool btrfs_tree_read_seq_retry(const struct extent_buffer *eb,
+					     unsigned int seq)
+{
+	smp_rmb();
+	return (seq & 1) || READ_ONCE(eb->lock_seq) != seq;
+}
 struct extent_buffer *btrfs_lock_root_node(struct btrfs_root *root);
 struct extent_buffer *btrfs_read_lock_root_node(struct btrfs_root *root);
 struct extent_buffer *btrfs_try_read_lock_root_node(struct btrfs_root *root);
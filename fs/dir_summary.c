@@ -0,0 +1,188 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Per-directory summaries of the names a directory holds.
+ *
+ * An uninterrupted getdents64() pass over a whole directory records every
+ * name it returns in a Bloom filter hung off the directory inode, and every
+ * name that becomes positive in the dcache under that directory is added
+ * from then on.  Names are never taken out again, so once such a pass has
+ * completed, a name missing from the filter cannot exist and its lookup can
+ * fail without allocating a negative dentry or calling ->lookup().
+ *
+ * Only filesystems that set FS_DIR_SUMMARY are summarised: every entry of
+ * their directories has to be created by this kernel through the dcache.
+ * Directories that are encrypted or casefolded, or whose dentries need
+ * revalidation, are left out since their names may not match byte for byte.
+ */
+#include <linux/dcache.h>
+#include <linux/fs.h>
+#include <linux/log2.h>
+#include <linux/name_bloom.h>
+#include <linux/slab.h>
+#include "internal.h"
+
+#define DIR_SUMMARY_MIN_ORDER	12
+#define DIR_SUMMARY_MAX_ORDER	18
+
+struct dir_summary {
+	struct rcu_head rcu;
+	/* the file making the current pass and where it has got to */
+	struct file *builder;
+	loff_t build_pos;
+	unsigned int nr_names;
+	unsigned int order;
+	bool complete;
+	unsigned long bits[];
+};
+
+static bool dir_summary_eligible(struct dentry *dir)
+{
+	struct inode *inode = d_inode(dir);
+
+	if (!(dir->d_sb->s_type->fs_flags & FS_DIR_SUMMARY))
+		return false;
+	if (dir->d_flags & (DCACHE_OP_HASH | DCACHE_OP_COMPARE |
+			    DCACHE_OP_REVALIDATE))
+		return false;
+	return !IS_ENCRYPTED(inode) && !IS_CASEFOLDED(inode);
+}
+
+static void dir_summary_set(struct dir_summary *s, const char *name,
+			    unsigned int len)
+{
+	name_bloom_add(s->bits, s->order, name, len);
+}
+
+static bool dir_summary_test(struct dir_summary *s, const char *name,
+			     unsigned int len)
+{
+	return name_bloom_test(s->bits, s->order, name, len);
+}
+
+static struct dir_summary *dir_summary_alloc(struct inode *inode)
+{
+	struct dir_summary *s;
+	unsigned int order;
+
+	/* one bit per byte of directory is a few dozen per name */
+	order = clamp_t(unsigned int, order_base_2(i_size_read(inode)),
+			DIR_SUMMARY_MIN_ORDER, DIR_SUMMARY_MAX_ORDER);
+	s = kzalloc(struct_size(s, bits, BITS_TO_LONGS(1U << order)),
+		    GFP_KERNEL_ACCOUNT);
+	if (s)
+		s->order = order;
+	return s;
+}
+
+/**
+ * dir_summary_begin - prepare a getdents64() call to record names
+ * @file: the directory being read
+ *
+ * A call at position 0 of a directory without a complete summary starts a
+ * new pass, and a pass is abandoned if @file was repositioned since its
+ * last call.
+ *
+ * Return: the summary to pass each returned name to, or NULL.
+ */
+struct dir_summary *dir_summary_begin(struct file *file)
+{
+	struct dentry *dir = file->f_path.dentry;
+	struct inode *inode = d_inode(dir);
+	struct dir_summary *s, *new;
+
+	if (!dir_summary_eligible(dir))
+		return NULL;
+
+	s = READ_ONCE(inode->i_dir_summary);
+	if (!s) {
+		if (file->f_pos)
+			return NULL;
+		new = dir_summary_alloc(inode);
+		if (!new)
+			return NULL;
+		s = cmpxchg(&inode->i_dir_summary, NULL, new);
+		if (s)
+			kfree(new);
+		else
+			s = new;
+	}
+	if (READ_ONCE(s->complete))
+		return NULL;
+
+	if (!file->f_pos) {
+		WRITE_ONCE(s->nr_names, 0);
+		WRITE_ONCE(s->builder, file);
+	} else if (READ_ONCE(s->builder) == file &&
+		   file->f_pos != READ_ONCE(s->build_pos)) {
+		WRITE_ONCE(s->builder, NULL);
+	}
+	return s;
+}
+
+void dir_summary_record(struct dir_summary *s, const char *name,
+			unsigned int len)
+{
+	dir_summary_set(s, name, len);
+	WRITE_ONCE(s->nr_names, READ_ONCE(s->nr_names) + 1);
+}
+
+/**
+ * dir_summary_end - finish a getdents64() call
+ * @file: the directory being read
+ * @s: what dir_summary_begin() returned
+ * @eof: the call found no more entries
+ *
+ * Marks the summary complete when @file read the whole directory in one
+ * pass; every name reached the filter either from the pass or from the
+ * dcache, whichever saw it last.
+ */
+void dir_summary_end(struct file *file, struct dir_summary *s, bool eof)
+{
+	if (!s || READ_ONCE(s->builder) != file)
+		return;
+
+	/* give up once the filter would answer too many lookups wrongly */
+	if (name_bloom_overfull(s->order, READ_ONCE(s->nr_names))) {
+		WRITE_ONCE(s->builder, NULL);
+		return;
+	}
+	if (!eof) {
+		WRITE_ONCE(s->build_pos, file->f_pos);
+		return;
+	}
+	smp_store_release(&s->complete, true);
+}
+
+/* Called before @dentry becomes positive under its current or new parent. */
+void __d_dir_summary_add(struct dentry *dentry, struct dir_summary *s)
+{
+	dir_summary_set(s, dentry->d_name.name, dentry->d_name.len);
+}
+
+/**
+ * d_dir_summary_excludes - is a name known to be missing from a directory
+ * @dir: the directory
+ * @name: the name, which the dcache did not find
+ *
+ * Return: true if @name cannot exist in @dir.
+ */
+bool d_dir_summary_excludes(struct dentry *dir, const struct qstr *name)
+{
+	struct dir_summary *s;
+	bool ret = false;
+
+	rcu_read_lock();
+	s = READ_ONCE(d_inode(dir)->i_dir_summary);
+	if (s && smp_load_acquire(&s->complete) && dir_summary_eligible(dir))
+		ret = !dir_summary_test(s, name->name, name->len);
+	rcu_read_unlock();
+	return ret;
+}
+
+void dir_summary_free(struct inode *inode)
+{
+	struct dir_summary *s = inode->i_dir_summary;
+
+	if (s)
+		kfree_rcu(s, rcu);
+}
@@ -102,7 +102,8 @@ struct z_erofs_decompressqueue {
 		struct work_struct work;
 		struct kthread_work kthread_work;
 	} u;
-	bool eio, sync;
+	/* split: one batch of a chain already cut by z_erofs_split_queue() */
+	bool eio, sync, split;
 };
 
 static inline unsigned int z_erofs_pclusterpages(struct z_erofs_pcluster *pcl)
@@ -1362,7 +1363,60 @@ static int z_erofs_decompress_pcluster(struct z_erofs_backend *be, int err)
 	return err;
 }
 
-static int z_erofs_decompress_queue(const struct z_erofs_decompressqueue *io,
+static void z_erofs_decompressqueue_work(struct work_struct *work);
+
+/*
+ * Pclusters of a chain are independent of each other, so a long chain (e.g.
+ * from a large readahead) is cut into batches; all but the first batch are
+ * handed to other workers on this node, while the caller keeps the first,
+ * which holds the folios needed earliest.
+ */
+#define Z_EROFS_DECOMPRESS_BATCH	8
+
+static void z_erofs_split_queue(struct z_erofs_decompressqueue *io)
+{
+	struct z_erofs_pcluster *pcl, *last, *next;
+	struct z_erofs_decompressqueue *q;
+	unsigned int nr = 0, nr_cpus, batch, i;
+
+	if (io->split)
+		return;
+	for (pcl = io->head; pcl != Z_EROFS_PCLUSTER_TAIL;
+	     pcl = READ_ONCE(pcl->next))
+		++nr;
+	nr_cpus = min(num_online_cpus(), nr / Z_EROFS_DECOMPRESS_BATCH);
+	if (nr_cpus < 2)
+		return;
+	batch = DIV_ROUND_UP(nr, nr_cpus);
+
+	for (last = io->head, i = 1; i < batch; ++i)
+		last = READ_ONCE(last->next);
+	next = READ_ONCE(last->next);
+	WRITE_ONCE(last->next, Z_EROFS_PCLUSTER_TAIL);
+
+	while (next != Z_EROFS_PCLUSTER_TAIL) {
+		q = kvzalloc(sizeof(*q), GFP_NOWAIT | __GFP_NOWARN);
+		if (!q) {
+			/* the caller decompresses the rest */
+			WRITE_ONCE(last->next, next);
+			return;
+		}
+		q->sb = io->sb;
+		q->eio = io->eio;
+		q->split = true;
+		q->head = next;
+		for (pcl = next, i = 1; i < batch &&
+		     READ_ONCE(pcl->next) != Z_EROFS_PCLUSTER_TAIL; ++i)
+			pcl = READ_ONCE(pcl->next);
+		next = READ_ONCE(pcl->next);
+		WRITE_ONCE(pcl->next, Z_EROFS_PCLUSTER_TAIL);
+
+		INIT_WORK(&q->u.work, z_erofs_decompressqueue_work);
+		queue_work_node(numa_node_id(), z_erofs_workqueue, &q->u.work);
+	}
+}
+
+static int z_erofs_decompress_queue(struct z_erofs_decompressqueue *io,
 				    struct page **pagepool)
 {
 	struct z_erofs_backend be = {
@@ -1375,6 +1429,7 @@ static int z_erofs_decompress_queue(const struct z_erofs_decompressqueue *io,
 	struct z_erofs_pcluster *next;
 	int err = io->eio ? -EIO : 0;
 
+	z_erofs_split_queue(io);
 	for (; be.pcl != Z_EROFS_PCLUSTER_TAIL; be.pcl = next) {
 		DBG_BUGON(!be.pcl);
 		next = READ_ONCE(be.pcl->next);
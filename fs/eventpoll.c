@@ -2090,26 +2090,36 @@ static int ep_poll(struct eventpoll *ep, struct epoll_event __user *events,
 		init_wait(&wait);
 		wait.func = ep_autoremove_wake_function;
 
-		write_lock_irq(&ep->lock);
-		/*
-		 * Barrierless variant, waitqueue_active() is called under
-		 * the same lock on wakeup ep_poll_callback() side, so it
-		 * is safe to avoid an explicit barrier.
-		 */
-		__set_current_state(TASK_INTERRUPTIBLE);
-
 		/*
 		 * Do the final check under the lock. ep_start/done_scan()
 		 * plays with two lists (->rdllist and ->ovflist) and there
 		 * is always a race when both lists are empty for short
 		 * period of time although events are pending, so lock is
 		 * important.
+		 *
+		 * The read side is enough for that, and it keeps the waiters
+		 * of an epoll instance shared by many threads from stalling
+		 * ep_poll_callback().  Writers and other waiters are kept off
+		 * ep->wq by its own lock instead.
 		 */
+		read_lock_irq(&ep->lock);
+		__set_current_state(TASK_INTERRUPTIBLE);
+
 		eavail = ep_events_available(ep);
-		if (!eavail)
+		if (!eavail) {
+			spin_lock(&ep->wq.lock);
 			__add_wait_queue_exclusive(&ep->wq, &wait);
+			spin_unlock(&ep->wq.lock);
+			/*
+			 * ep_poll_callback() checks waitqueue_active() under
+			 * the read lock as well, after a fully ordered insertion
+			 * into one of the ready lists; pairs with that.
+			 */
+			smp_mb();
+			eavail = ep_events_available(ep);
+		}
 
-		write_unlock_irq(&ep->lock);
+		read_unlock_irq(&ep->lock);
 
 		if (!eavail && ep_schedule_timeout(to))
 			timed_out = !schedule_hrtimeout_range(to, slack,
@@ -2124,7 +2134,7 @@ static int ep_poll(struct eventpoll *ep, struct epoll_event __user *events,
 		eavail = 1;
 
 		if (!list_empty_careful(&wait.entry)) {
-			write_lock_irq(&ep->lock);
+			spin_lock_irq(&ep->wq.lock);
 			/*
 			 * If the thread timed out and is not on the wait queue,
 			 * it means that the thread was woken up after its
@@ -2135,7 +2145,7 @@ static int ep_poll(struct eventpoll *ep, struct epoll_event __user *events,
 			if (timed_out)
 				eavail = list_empty(&wait.entry);
 			__remove_wait_queue(&ep->wq, &wait);
-			write_unlock_irq(&ep->lock);
+			spin_unlock_irq(&ep->wq.lock);
 		}
 	}
 }
@@ -1212,10 +1212,32 @@ static void fuse_uring_send_in_task(struct io_uring_cmd *cmd,
 	fuse_uring_send(ent, cmd, err, issue_flags);
 }
 
+/*
+ * Find a queue on the same node as @qid that has an entry waiting for a
+ * request.  This is only a hint taken without the queue locks; a queue that
+ * got busy in the meantime just queues the request.
+ */
+static struct fuse_ring_queue *fuse_uring_node_idle_queue(struct fuse_ring *ring,
+							  unsigned int qid)
+{
+	struct fuse_ring_queue *queue;
+	unsigned int cpu;
+
+	for_each_cpu_wrap(cpu, cpumask_of_node(cpu_to_node(qid)), qid + 1) {
+		if (cpu == qid || cpu >= ring->nr_queues)
+			continue;
+		queue = READ_ONCE(ring->queues[cpu]);
+		if (queue && !READ_ONCE(queue->stopped) &&
+		    !list_empty(&queue->ent_avail_queue))
+			return queue;
+	}
+	return NULL;
+}
+
 static struct fuse_ring_queue *fuse_uring_task_to_queue(struct fuse_ring *ring)
 {
 	unsigned int qid;
-	struct fuse_ring_queue *queue;
+	struct fuse_ring_queue *queue, *idle;
 
 	qid = task_cpu(current);
 
@@ -1227,6 +1249,16 @@ static struct fuse_ring_queue *fuse_uring_task_to_queue(struct fuse_ring *ring)
 	queue = ring->queues[qid];
 	WARN_ONCE(!queue, "Missing queue for qid %d\n", qid);
 
+	/*
+	 * While all entries of the local queue are in userspace, a request
+	 * is better served by an idle queue close by than by waiting.
+	 */
+	if (queue && list_empty(&queue->ent_avail_queue)) {
+		idle = fuse_uring_node_idle_queue(ring, qid);
+		if (idle)
+			queue = idle;
+	}
+
 	return queue;
 }
 
@@ -1330,6 +1330,8 @@ static int fuse_update_get_attr(struct mnt_idmap *idmap, struct inode *inode,
 {
 	struct fuse_inode *fi = get_fuse_inode(inode);
 	struct fuse_conn *fc = get_fuse_conn(inode);
+	struct kstat backing;
+	bool passthrough = false;
 	int err = 0;
 	bool sync;
 	u32 inval_mask = READ_ONCE(fi->inval_mask);
@@ -1353,6 +1355,20 @@ static int fuse_update_get_attr(struct mnt_idmap *idmap, struct inode *inode,
 	else
 		sync = time_before64(fi->i_time, get_jiffies_64());
 
+	/*
+	 * The data attributes of an inode open in passthrough mode are those of
+	 * its backing file, and the server keeps the others unchanged or
+	 * invalidates them itself.
+	 */
+	if (IS_ENABLED(CONFIG_FUSE_PASSTHROUGH) && sync && stat &&
+	    fc->passthrough_getattr &&
+	    !(flags & AT_STATX_FORCE_SYNC) &&
+	    !(request_mask & ~STATX_BASIC_STATS) &&
+	    !fuse_passthrough_getattr(inode, &backing, flags)) {
+		sync = false;
+		passthrough = true;
+	}
+
 	if (sync) {
 		forget_all_cached_acls(inode);
 		/* Try statx if BTIME is requested */
@@ -1374,6 +1390,13 @@ static int fuse_update_get_attr(struct mnt_idmap *idmap, struct inode *inode,
 			stat->btime = fi->i_btime;
 			stat->result_mask |= STATX_BTIME;
 		}
+		if (passthrough) {
+			stat->size = backing.size;
+			stat->blocks = backing.blocks;
+			stat->atime = backing.atime;
+			stat->mtime = backing.mtime;
+			stat->ctime = backing.ctime;
+		}
 	}
 
 	return err;
@@ -889,6 +889,9 @@ struct fuse_conn {
 	/** Passthrough support for read/write IO */
 	unsigned int passthrough:1;
 
+	/** Take data attributes of passthrough inodes from the backing file */
+	unsigned int passthrough_getattr:1;
+
 	/* Use pages instead of pointer for kernel I/O */
 	unsigned int use_pages_for_kvec_io:1;
 
@@ -1549,6 +1552,8 @@ struct fuse_backing *fuse_passthrough_open(struct file *file,
 					   struct inode *inode,
 					   int backing_id);
 void fuse_passthrough_release(struct fuse_file *ff, struct fuse_backing *fb);
+int fuse_passthrough_getattr(struct inode *inode, struct kstat *stat,
+			     unsigned int flags);
 
 static inline struct file *fuse_file_passthrough(struct fuse_file *ff)
 {
@@ -343,6 +343,32 @@ struct fuse_backing *fuse_passthrough_open(struct file *file,
 	return err ? ERR_PTR(err) : fb;
 }
 
+/*
+ * Get the attributes of the backing file of an inode that is open in
+ * passthrough mode.  Returns -ENOENT if the inode has no backing file.
+ */
+int fuse_passthrough_getattr(struct inode *inode, struct kstat *stat,
+			     unsigned int flags)
+{
+	struct fuse_backing *fb;
+	const struct cred *old_cred;
+	int err;
+
+	rcu_read_lock();
+	fb = fuse_backing_get(fuse_inode_backing(get_fuse_inode(inode)));
+	rcu_read_unlock();
+	if (!fb)
+		return -ENOENT;
+
+	old_cred = override_creds(fb->cred);
+	err = vfs_getattr(&fb->file->f_path, stat, STATX_BASIC_STATS,
+			  flags & AT_STATX_SYNC_TYPE);
+	revert_creds(old_cred);
+	fuse_backing_put(fb);
+
+	return err;
+}
+
 void fuse_passthrough_release(struct fuse_file *ff, struct fuse_backing *fb)
 {
 	pr_debug("%s: fb=0x%p, backing_file=0x%p\n", __func__,
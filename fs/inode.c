@@ -300,6 +300,9 @@ int inode_init_always_gfp(struct super_block *sb, struct inode *inode, gfp_t gfp
 
 #ifdef CONFIG_FSNOTIFY
 	inode->i_fsnotify_mask = 0;
+#endif
+#ifdef CONFIG_DCACHE_DIR_SUMMARY
+	inode->i_dir_summary = NULL;
 #endif
 	inode->i_flctx = NULL;
 
@@ -371,6 +374,7 @@ void __destroy_inode(struct inode *inode)
 	security_inode_free(inode);
 	fsnotify_inode_delete(inode);
 	locks_free_lock_context(inode);
+	dir_summary_free(inode);
 	if (!inode->i_nlink) {
 		WARN_ON(atomic_long_read(&inode->i_sb->s_remove_count) == 0);
 		atomic_long_dec(&inode->i_sb->s_remove_count);
@@ -227,6 +227,55 @@ extern struct dentry *__d_lookup_rcu(const struct dentry *parent,
 				const struct qstr *name, unsigned *seq);
 extern void d_genocide(struct dentry *);
 
+/*
+ * dir_summary.c
+ */
+struct dir_summary;
+#ifdef CONFIG_DCACHE_DIR_SUMMARY
+struct dir_summary *dir_summary_begin(struct file *file);
+void dir_summary_record(struct dir_summary *s, const char *name,
+			unsigned int len);
+void dir_summary_end(struct file *file, struct dir_summary *s, bool eof);
+void __d_dir_summary_add(struct dentry *dentry, struct dir_summary *s);
+bool d_dir_summary_excludes(struct dentry *dir, const struct qstr *name);
+void dir_summary_free(struct inode *inode);
+
+static inline void d_dir_summary_add(struct dentry *dentry)
+{
+	struct dir_summary *s;
+
+	if (IS_ROOT(dentry))
+		return;
+	s = READ_ONCE(dentry->d_parent->d_inode->i_dir_summary);
+	if (unlikely(s))
+		__d_dir_summary_add(dentry, s);
+}
+#else
+static inline struct dir_summary *dir_summary_begin(struct file *file)
+{
+	return NULL;
+}
+static inline void dir_summary_record(struct dir_summary *s, const char *name,
+				      unsigned int len)
+{
+}
+static inline void dir_summary_end(struct file *file, struct dir_summary *s,
+				   bool eof)
+{
+}
+static inline void d_dir_summary_add(struct dentry *dentry)
+{
+}
+static inline bool d_dir_summary_excludes(struct dentry *dir,
+					  const struct qstr *name)
+{
+	return false;
+}
+static inline void dir_summary_free(struct inode *inode)
+{
+}
+#endif
+
 /*
  * pipe.c
  */
@@ -249,7 +298,10 @@ int open_namespace(struct ns_common *ns);
  */
 
 int do_statx(int dfd, struct filename *filename, unsigned int flags,
-	     unsigned int mask, struct statx __user *buffer);
+	     unsigned int mask, struct statx __user *buffer,
+	     unsigned int lookup_flags);
+int do_statx_path(struct path *path, unsigned int flags,
+		  unsigned int mask, struct statx __user *buffer);
 int do_statx_fd(int fd, unsigned int flags, unsigned int mask,
 		struct statx __user *buffer);
 
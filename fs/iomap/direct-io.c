@@ -21,6 +21,7 @@
  * Private flags for iomap_dio, must not overlap with the public ones in
  * iomap.h:
  */
+#define IOMAP_DIO_ON_STACK	(1U << 24)
 #define IOMAP_DIO_NO_INVALIDATE	(1U << 25)
 #define IOMAP_DIO_CALLER_COMP	(1U << 26)
 #define IOMAP_DIO_INLINE_COMP	(1U << 27)
@@ -91,6 +92,12 @@ static void iomap_dio_submit_bio(const struct iomap_iter *iter,
 	}
 }
 
+static void iomap_dio_free(struct iomap_dio *dio)
+{
+	if (!(dio->flags & IOMAP_DIO_ON_STACK))
+		kfree(dio);
+}
+
 ssize_t iomap_dio_complete(struct iomap_dio *dio)
 {
 	const struct iomap_dio_ops *dops = dio->dops;
@@ -140,7 +147,7 @@ ssize_t iomap_dio_complete(struct iomap_dio *dio)
 			ret += dio->done_before;
 	}
 	trace_iomap_dio_complete(iocb, dio->error, ret);
-	kfree(dio);
+	iomap_dio_free(dio);
 	return ret;
 }
 EXPORT_SYMBOL_GPL(iomap_dio_complete);
@@ -598,10 +605,11 @@ static int iomap_dio_iter(struct iomap_iter *iter, struct iomap_dio *dio)
  * Returns -ENOTBLK In case of a page invalidation invalidation failure for
  * writes.  The callers needs to fall back to buffered I/O in this case.
  */
-struct iomap_dio *
-__iomap_dio_rw(struct kiocb *iocb, struct iov_iter *iter,
+static struct iomap_dio *
+iomap_dio_start(struct kiocb *iocb, struct iov_iter *iter,
 		const struct iomap_ops *ops, const struct iomap_dio_ops *dops,
-		unsigned int dio_flags, void *private, size_t done_before)
+		unsigned int dio_flags, void *private, size_t done_before,
+		struct iomap_dio *onstack_dio)
 {
 	struct inode *inode = file_inode(iocb->ki_filp);
 	struct iomap_iter iomi = {
@@ -622,9 +630,15 @@ __iomap_dio_rw(struct kiocb *iocb, struct iov_iter *iter,
 	if (!iomi.len)
 		return NULL;
 
-	dio = kmalloc(sizeof(*dio), GFP_KERNEL);
-	if (!dio)
-		return ERR_PTR(-ENOMEM);
+	if (onstack_dio) {
+		dio = onstack_dio;
+		dio->flags = IOMAP_DIO_ON_STACK;
+	} else {
+		dio = kmalloc(sizeof(*dio), GFP_KERNEL);
+		if (!dio)
+			return ERR_PTR(-ENOMEM);
+		dio->flags = 0;
+	}
 
 	dio->iocb = iocb;
 	atomic_set(&dio->ref, 1);
@@ -632,7 +646,6 @@ __iomap_dio_rw(struct kiocb *iocb, struct iov_iter *iter,
 	dio->i_size = i_size_read(inode);
 	dio->dops = dops;
 	dio->error = 0;
-	dio->flags = 0;
 	dio->done_before = done_before;
 
 	dio->submit.iter = iter;
@@ -806,11 +819,20 @@ __iomap_dio_rw(struct kiocb *iocb, struct iov_iter *iter,
 	return dio;
 
 out_free_dio:
-	kfree(dio);
+	iomap_dio_free(dio);
 	if (ret)
 		return ERR_PTR(ret);
 	return NULL;
 }
+
+struct iomap_dio *
+__iomap_dio_rw(struct kiocb *iocb, struct iov_iter *iter,
+		const struct iomap_ops *ops, const struct iomap_dio_ops *dops,
+		unsigned int dio_flags, void *private, size_t done_before)
+{
+	return iomap_dio_start(iocb, iter, ops, dops, dio_flags, private,
+			       done_before, NULL);
+}
 EXPORT_SYMBOL_GPL(__iomap_dio_rw);
 
 ssize_t
@@ -818,10 +840,15 @@ iomap_dio_rw(struct kiocb *iocb, struct iov_iter *iter,
 		const struct iomap_ops *ops, const struct iomap_dio_ops *dops,
 		unsigned int dio_flags, void *private, size_t done_before)
 {
-	struct iomap_dio *dio;
+	struct iomap_dio onstack_dio, *dio;
 
-	dio = __iomap_dio_rw(iocb, iter, ops, dops, dio_flags, private,
-			     done_before);
+	/*
+	 * Synchronous I/O is completed before we return, so the dio can live
+	 * on our stack instead of being allocated for every small read.
+	 */
+	dio = iomap_dio_start(iocb, iter, ops, dops, dio_flags, private,
+			      done_before,
+			      is_sync_kiocb(iocb) ? &onstack_dio : NULL);
 	if (IS_ERR_OR_NULL(dio))
 		return PTR_ERR_OR_ZERO(dio);
 	return iomap_dio_complete(dio);
@@ -450,10 +450,12 @@ void jbd2_journal_commit_transaction(journal_t *journal)
 	stats.run.rs_running = jbd2_time_diff(commit_transaction->t_start,
 					      stats.run.rs_locked);
 
-	// waits for any t_updates to finish
+	// waits for any updates to finish
 	jbd2_journal_wait_updates(journal);
 
 	commit_transaction->t_state = T_SWITCH;
+	atomic_set(&commit_transaction->t_handle_count,
+		   jbd2_journal_handle_count(journal));
 
 	J_ASSERT (atomic_read(&commit_transaction->t_outstanding_credits) <=
 			journal->j_max_transaction_buffers);
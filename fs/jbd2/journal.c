@@ -1585,6 +1585,10 @@ static journal_t *journal_init_common(struct block_device *bdev,
 	if (!journal->j_wbuf)
 		goto err_cleanup;
 
+	journal->j_handle_stats = alloc_percpu(struct jbd2_handle_stats);
+	if (!journal->j_handle_stats)
+		goto err_cleanup;
+
 	err = percpu_counter_init(&journal->j_checkpoint_jh_count, 0,
 				  GFP_KERNEL);
 	if (err)
@@ -1610,6 +1614,7 @@ static journal_t *journal_init_common(struct block_device *bdev,
 
 err_cleanup:
 	percpu_counter_destroy(&journal->j_checkpoint_jh_count);
+	free_percpu(journal->j_handle_stats);
 	kfree(journal->j_wbuf);
 	jbd2_journal_destroy_revoke(journal);
 	journal_fail_superblock(journal);
@@ -2189,6 +2194,7 @@ int jbd2_journal_destroy(journal_t *journal)
 		jbd2_journal_destroy_revoke(journal);
 	kfree(journal->j_fc_wbuf);
 	kfree(journal->j_wbuf);
+	free_percpu(journal->j_handle_stats);
 	kfree(journal);
 
 	return err;
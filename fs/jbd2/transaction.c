@@ -80,18 +80,23 @@ void jbd2_journal_free_transaction(transaction_t *transaction)
 static void jbd2_get_transaction(journal_t *journal,
 				transaction_t *transaction)
 {
+	int cpu;
+
 	transaction->t_journal = journal;
 	transaction->t_state = T_RUNNING;
 	transaction->t_start_time = ktime_get();
 	transaction->t_tid = journal->j_transaction_sequence++;
 	transaction->t_expires = jiffies + journal->j_commit_interval;
-	atomic_set(&transaction->t_updates, 0);
 	atomic_set(&transaction->t_outstanding_credits,
 		   journal->j_transaction_overhead_buffers +
 		   atomic_read(&journal->j_reserved_credits));
 	atomic_set(&transaction->t_outstanding_revokes, 0);
 	atomic_set(&transaction->t_handle_count, 0);
 	INIT_LIST_HEAD(&transaction->t_inode_list);
+	/* No handle is running without a running transaction. */
+	for_each_possible_cpu(cpu)
+		*per_cpu_ptr(journal->j_handle_stats, cpu) =
+			(struct jbd2_handle_stats) { };
 
 	/* Set up the commit timer for the new transaction. */
 	journal->j_commit_timer.expires = round_jiffies_up(transaction->t_expires);
@@ -357,7 +362,7 @@ static int start_this_handle(journal_t *journal, handle_t *handle,
 	jbd2_debug(3, "New handle %p going live.\n", handle);
 
 	/*
-	 * We need to hold j_state_lock until t_updates has been incremented,
+	 * We need to hold j_state_lock until updates have been incremented,
 	 * for proper journal barrier handling
 	 */
 repeat:
@@ -432,8 +437,8 @@ static int start_this_handle(journal_t *journal, handle_t *handle,
 	handle->h_requested_credits = blocks;
 	handle->h_revoke_credits_requested = handle->h_revoke_credits;
 	handle->h_start_jiffies = jiffies;
-	atomic_inc(&transaction->t_updates);
-	atomic_inc(&transaction->t_handle_count);
+	this_cpu_inc(journal->j_handle_stats->updates);
+	this_cpu_inc(journal->j_handle_stats->handles);
 	jbd2_debug(4, "Handle %p given %d credits (total %d, free %lu)\n",
 		  handle, blocks,
 		  atomic_read(&transaction->t_outstanding_credits),
@@ -701,7 +706,6 @@ static void stop_this_handle(handle_t *handle)
 	int revokes;
 
 	J_ASSERT(journal_current_handle() == handle);
-	J_ASSERT(atomic_read(&transaction->t_updates) > 0);
 	current->journal_info = NULL;
 	/*
 	 * Subtract necessary revoke descriptor blocks from handle credits. We
@@ -728,7 +732,16 @@ static void stop_this_handle(handle_t *handle)
 	if (handle->h_rsv_handle)
 		__jbd2_journal_unreserve_handle(handle->h_rsv_handle,
 						transaction);
-	if (atomic_dec_and_test(&transaction->t_updates))
+	/*
+	 * The credit and revoke updates above must be visible before the
+	 * commit thread can see this handle gone, as the atomic_dec() of
+	 * t_updates used to guarantee.  Whoever waits for the updates to
+	 * drain sums the counters after queueing itself, so it either sees
+	 * this one dropped or is woken.
+	 */
+	smp_mb();
+	this_cpu_dec(journal->j_handle_stats->updates);
+	if (wq_has_sleeper(&journal->j_wait_updates))
 		wake_up(&journal->j_wait_updates);
 
 	rwsem_release(&journal->j_trans_commit_map, _THIS_IP_);
@@ -810,7 +823,37 @@ int jbd2_journal_restart(handle_t *handle, int nblocks)
 EXPORT_SYMBOL(jbd2_journal_restart);
 
 /*
- * Waits for any outstanding t_updates to finish.
+ * Number of handles still running in the running transaction.  With write
+ * j_state_lock held no handle can start, so a sum taken while handles stop
+ * can only be too high, never too low.
+ */
+static int jbd2_journal_nr_updates(journal_t *journal)
+{
+	int cpu, updates = 0;
+
+	lockdep_assert_held_write(&journal->j_state_lock);
+	for_each_possible_cpu(cpu)
+		updates += per_cpu_ptr(journal->j_handle_stats, cpu)->updates;
+	return updates;
+}
+
+/*
+ * Number of handles that joined the running transaction.
+ * This is called with write j_state_lock held.
+ */
+unsigned int jbd2_journal_handle_count(journal_t *journal)
+{
+	unsigned int handles = 0;
+	int cpu;
+
+	lockdep_assert_held_write(&journal->j_state_lock);
+	for_each_possible_cpu(cpu)
+		handles += per_cpu_ptr(journal->j_handle_stats, cpu)->handles;
+	return handles;
+}
+
+/*
+ * Waits for any outstanding updates to finish.
  * This is called with write j_state_lock held.
  */
 void jbd2_journal_wait_updates(journal_t *journal)
@@ -835,7 +878,7 @@ void jbd2_journal_wait_updates(journal_t *journal)
 
 		prepare_to_wait(&journal->j_wait_updates, &wait,
 				TASK_UNINTERRUPTIBLE);
-		if (!atomic_read(&transaction->t_updates)) {
+		if (!jbd2_journal_nr_updates(journal)) {
 			finish_wait(&journal->j_wait_updates, &wait);
 			break;
 		}
@@ -871,7 +914,7 @@ void jbd2_journal_lock_updates(journal_t *journal)
 		write_lock(&journal->j_state_lock);
 	}
 
-	/* Wait until there are no running t_updates */
+	/* Wait until there are no running updates */
 	jbd2_journal_wait_updates(journal);
 
 	write_unlock(&journal->j_state_lock);
@@ -1938,7 +1981,7 @@ int jbd2_journal_stop(handle_t *handle)
 	}
 
 	/*
-	 * Once stop_this_handle() drops t_updates, the transaction could start
+	 * Once stop_this_handle() drops updates, the transaction could start
 	 * committing on us and eventually disappear.  So we must not
 	 * dereference transaction pointer again after calling
 	 * stop_this_handle().
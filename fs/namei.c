@@ -2135,6 +2135,8 @@ static const char *walk_component(struct nameidata *nd, int flags)
 	if (IS_ERR(dentry))
 		return ERR_CAST(dentry);
 	if (unlikely(!dentry)) {
+		if (d_dir_summary_excludes(nd->path.dentry, &nd->last))
+			return ERR_PTR(-ENOENT);
 		dentry = lookup_slow(&nd->last, nd->path.dentry, nd->flags);
 		if (IS_ERR(dentry))
 			return ERR_CAST(dentry);
@@ -3778,6 +3780,8 @@ static const char *open_last_lookups(struct nameidata *nd,
 	if (!(open_flag & O_CREAT)) {
 		if (WARN_ON_ONCE(nd->flags & LOOKUP_RCU))
 			return ERR_PTR(-ECHILD);
+		if (d_dir_summary_excludes(dir, &nd->last))
+			return ERR_PTR(-ENOENT);
 	} else {
 		if (nd->flags & LOOKUP_RCU) {
 			if (!try_to_unlazy(nd))
@@ -6221,6 +6221,10 @@ void __init mnt_init(void)
 	if (!mount_hashtable || !mountpoint_hashtable)
 		panic("Failed to allocate mount hash table\n");
 
+	/* read for every mountinfo and statmount(), written on (u)mount */
+	if (rwsem_enable_percpu_readers(&namespace_sem))
+		pr_warn("VFS: no per-CPU readers for namespace_sem\n");
+
 	kernfs_init();
 
 	err = sysfs_init();
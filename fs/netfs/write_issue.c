@@ -545,6 +545,40 @@ static void netfs_end_issue_write(struct netfs_io_request *wreq)
 		netfs_wake_write_collector(wreq, false);
 }
 
+/*
+ * Background writeback stops as soon as wbc->nr_to_write runs out, which
+ * under memory pressure may be only a few folios in, leaving the upload
+ * being built far smaller than the server would take.  Once per call, let
+ * it carry on far enough to fill that upload; it is still issued short if
+ * the following folios are not dirty or not contiguous.
+ *
+ * writeback_iter() stops on wbc->nr_to_write, so the extra pages are lent
+ * to it there, and netfs_writepages() takes them back when done: the
+ * caller still sees every page written against its own budget.
+ */
+#define NETFS_WB_EXTEND_MAX	SZ_8M
+
+static long netfs_extend_writeback(struct netfs_io_request *wreq,
+				   struct writeback_control *wbc,
+				   struct folio *folio)
+{
+	struct netfs_io_stream *upload = &wreq->io_streams[0];
+	struct netfs_io_subrequest *subreq = upload->construct;
+	size_t max_len;
+	long extra;
+
+	if (wbc->sync_mode != WB_SYNC_NONE || !subreq ||
+	    wbc->nr_to_write > folio_nr_pages(folio))
+		return 0;
+
+	max_len = umin(upload->sreq_max_len, NETFS_WB_EXTEND_MAX);
+	if (subreq->len >= max_len)
+		return 0;
+	extra = (max_len - subreq->len) >> PAGE_SHIFT;
+	wbc->nr_to_write += extra;
+	return extra;
+}
+
 /*
  * Write some of the pending data back to the server
  */
@@ -554,6 +588,7 @@ int netfs_writepages(struct address_space *mapping,
 	struct netfs_inode *ictx = netfs_inode(mapping->host);
 	struct netfs_io_request *wreq = NULL;
 	struct folio *folio;
+	long extended = 0;
 	int error = 0;
 
 	if (!mutex_trylock(&ictx->wb_lock)) {
@@ -594,8 +629,11 @@ int netfs_writepages(struct address_space *mapping,
 		error = netfs_write_folio(wreq, wbc, folio);
 		if (error < 0)
 			break;
+		if (!extended)
+			extended = netfs_extend_writeback(wreq, wbc, folio);
 	} while ((folio = writeback_iter(mapping, wbc, folio, &error)));
 
+	wbc->nr_to_write -= extended;
 	netfs_end_issue_write(wreq);
 
 	mutex_unlock(&ictx->wb_lock);
@@ -74,6 +74,8 @@ const struct address_space_operations nfs_dir_aops = {
 
 #define NFS_INIT_DTSIZE PAGE_SIZE
 
+static void nfs_readdir_prefetch_work(struct work_struct *work);
+
 static struct nfs_open_dir_context *
 alloc_nfs_open_dir_context(struct inode *dir)
 {
@@ -84,6 +86,7 @@ alloc_nfs_open_dir_context(struct inode *dir)
 	if (ctx != NULL) {
 		ctx->attr_gencount = nfsi->attr_gencount;
 		ctx->dtsize = NFS_INIT_DTSIZE;
+		INIT_WORK(&ctx->prefetch_work, nfs_readdir_prefetch_work);
 		spin_lock(&dir->i_lock);
 		if (list_empty(&nfsi->open_files) &&
 		    (nfsi->cache_validity & NFS_INO_DATA_INVAL_DEFER))
@@ -1076,6 +1079,96 @@ static int readdir_search_pagecache(struct nfs_readdir_descriptor *desc)
 	return res;
 }
 
+/*
+ * Fill the cache folio starting at dir_ctx->prefetch_cookie, so that the
+ * READDIR for it was sent while the reader went through the entries it
+ * already had.  The reader either finds the folio filled or waits on its
+ * lock; any failure just leaves the folio for the reader to fill.
+ */
+static void nfs_readdir_prefetch_work(struct work_struct *work)
+{
+	struct nfs_open_dir_context *dir_ctx = container_of(work,
+			struct nfs_open_dir_context, prefetch_work);
+	struct file *file = dir_ctx->prefetch_file;
+	struct inode *inode = file_inode(file);
+	__be32 *cookieverf = NFS_I(inode)->cookieverf;
+	struct nfs_readdir_descriptor *desc;
+	__be32 verf[NFS_DIR_VERIFIER_SIZE];
+
+	/* dcache priming expects the directory lock that readdir holds */
+	if (!inode_trylock_shared(inode))
+		goto out;
+	desc = kzalloc(sizeof(*desc), GFP_KERNEL);
+	if (!desc)
+		goto out_unlock;
+	desc->file = file;
+	desc->last_cookie = dir_ctx->prefetch_cookie;
+	desc->plus = dir_ctx->prefetch_plus;
+	nfs_set_dtsize(desc, dir_ctx->prefetch_dtsize);
+
+	desc->folio = nfs_readdir_folio_get_cached(desc);
+	if (desc->folio) {
+		if (nfs_readdir_folio_needs_filling(desc->folio)) {
+			trace_nfs_readdir_cache_fill(file, cookieverf,
+						     desc->last_cookie,
+						     desc->folio->index,
+						     desc->dtsize);
+			nfs_readdir_xdr_to_array(desc, cookieverf, verf,
+						 &desc->folio, 1);
+		}
+		nfs_readdir_folio_unlock_and_put_cached(desc);
+	}
+	kfree(desc);
+out_unlock:
+	inode_unlock_shared(inode);
+out:
+	spin_lock(&file->f_lock);
+	dir_ctx->prefetch_file = NULL;
+	spin_unlock(&file->f_lock);
+	fput(file);
+}
+
+/*
+ * Send the READDIR for the folio following desc->folio ahead of the
+ * reader, unless that folio is already cached or a prefetch is running.
+ */
+static void nfs_readdir_start_prefetch(struct nfs_readdir_descriptor *desc)
+{
+	struct file *file = desc->file;
+	struct nfs_open_dir_context *dir_ctx = file->private_data;
+	struct nfs_cache_array *array;
+	struct folio *folio;
+	u64 cookie;
+	bool eof;
+
+	array = kmap_local_folio(desc->folio, 0);
+	cookie = array->last_cookie;
+	eof = array->folio_is_eof;
+	kunmap_local(array);
+	if (eof || !cookie)
+		return;
+
+	folio = filemap_get_folio(file->f_mapping,
+				  nfs_readdir_folio_cookie_hash(cookie));
+	if (!IS_ERR(folio)) {
+		folio_put(folio);
+		return;
+	}
+
+	spin_lock(&file->f_lock);
+	if (dir_ctx->prefetch_file) {
+		spin_unlock(&file->f_lock);
+		return;
+	}
+	dir_ctx->prefetch_file = get_file(file);
+	dir_ctx->prefetch_cookie = cookie;
+	dir_ctx->prefetch_dtsize = desc->dtsize;
+	dir_ctx->prefetch_plus = desc->plus;
+	spin_unlock(&file->f_lock);
+
+	queue_work(nfsiod_workqueue, &dir_ctx->prefetch_work);
+}
+
 #define NFS_READDIR_CACHE_MISS_THRESHOLD (16UL)
 
 /*
@@ -1300,6 +1393,8 @@ static int nfs_readdir(struct file *file, struct dir_context *ctx)
 			break;
 
 		nfs_do_filldir(desc, nfsi->cookieverf);
+		if (!desc->eof)
+			nfs_readdir_start_prefetch(desc);
 		nfs_readdir_folio_unlock_and_put_cached(desc);
 		if (desc->folio_index == desc->folio_index_max)
 			desc->clear_cache = force_clear;
@@ -495,11 +495,12 @@ static inline const struct path *fanotify_event_path(struct fanotify_event *even
 }
 
 /*
- * Use 128 size hash table to speed up events merge.
+ * Use a hash table to speed up events merge, sized to the group's queue
+ * limit so that buckets stay short: 128 buckets minimum, then one bucket
+ * per 16 events the queue may hold, up to 4096 buckets.
  */
-#define FANOTIFY_HTABLE_BITS	(7)
-#define FANOTIFY_HTABLE_SIZE	(1 << FANOTIFY_HTABLE_BITS)
-#define FANOTIFY_HTABLE_MASK	(FANOTIFY_HTABLE_SIZE - 1)
+#define FANOTIFY_HTABLE_MIN_BITS	(7)
+#define FANOTIFY_HTABLE_MAX_BITS	(12)
 
 /*
  * Permission events and overflow event do not get merged - don't hash them.
@@ -514,7 +515,7 @@ static inline unsigned int fanotify_event_hash_bucket(
 						struct fsnotify_group *group,
 						struct fanotify_event *event)
 {
-	return event->hash & FANOTIFY_HTABLE_MASK;
+	return event->hash & ((1U << group->fanotify_data.merge_hash_bits) - 1);
 }
 
 struct fanotify_mark {
@@ -1481,18 +1481,23 @@ static struct fsnotify_event *fanotify_alloc_overflow_event(void)
 	return &oevent->fse;
 }
 
-static struct hlist_head *fanotify_alloc_merge_hash(void)
+static int fanotify_alloc_merge_hash(struct fsnotify_group *group)
 {
 	struct hlist_head *hash;
+	unsigned int bits;
 
-	hash = kmalloc(sizeof(struct hlist_head) << FANOTIFY_HTABLE_BITS,
-		       GFP_KERNEL_ACCOUNT);
+	/* signed, max_events may be below 16 or even 0 */
+	bits = clamp_t(int, order_base_2(group->max_events) - 4,
+		       FANOTIFY_HTABLE_MIN_BITS, FANOTIFY_HTABLE_MAX_BITS);
+	hash = kmalloc(sizeof(struct hlist_head) << bits, GFP_KERNEL_ACCOUNT);
 	if (!hash)
-		return NULL;
+		return -ENOMEM;
 
-	__hash_init(hash, FANOTIFY_HTABLE_SIZE);
+	__hash_init(hash, 1U << bits);
+	group->fanotify_data.merge_hash = hash;
+	group->fanotify_data.merge_hash_bits = bits;
 
-	return hash;
+	return 0;
 }
 
 /* fanotify syscalls */
@@ -1605,12 +1610,6 @@ SYSCALL_DEFINE2(fanotify_init, unsigned int, flags, unsigned int, event_f_flags)
 	group->fanotify_data.flags = flags | internal_flags;
 	group->memcg = get_mem_cgroup_from_mm(current->mm);
 
-	group->fanotify_data.merge_hash = fanotify_alloc_merge_hash();
-	if (!group->fanotify_data.merge_hash) {
-		fd = -ENOMEM;
-		goto out_destroy_group;
-	}
-
 	group->overflow_event = fanotify_alloc_overflow_event();
 	if (unlikely(!group->overflow_event)) {
 		fd = -ENOMEM;
@@ -1646,6 +1645,10 @@ SYSCALL_DEFINE2(fanotify_init, unsigned int, flags, unsigned int, event_f_flags)
 		group->max_events = fanotify_max_queued_events;
 	}
 
+	fd = fanotify_alloc_merge_hash(group);
+	if (fd)
+		goto out_destroy_group;
+
 	if (flags & FAN_UNLIMITED_MARKS) {
 		fd = -EPERM;
 		if (!capable(CAP_SYS_ADMIN))
@@ -269,6 +269,7 @@ static int ovl_copy_up_file(struct ovl_fs *ofs, struct dentry *dentry,
 	loff_t data_pos = -1;
 	loff_t hole_len;
 	bool skip_hole = false;
+	bool try_copy_range;
 	int error = 0;
 
 	ovl_path_lowerdata(dentry, &datapath);
@@ -296,6 +297,13 @@ static int ovl_copy_up_file(struct ovl_fs *ofs, struct dentry *dentry,
 	if (old_file->f_mode & FMODE_LSEEK)
 		skip_hole = true;
 
+	/*
+	 * Let an upper fs that can copy without moving the data through
+	 * the page cache (e.g. server-side copy) do so, and splice if it
+	 * turns out it cannot.
+	 */
+	try_copy_range = !!new_file->f_op->copy_file_range;
+
 	while (len) {
 		size_t this_len = OVL_COPY_UP_CHUNK_SIZE;
 		ssize_t bytes;
@@ -346,9 +354,22 @@ static int ovl_copy_up_file(struct ovl_fs *ofs, struct dentry *dentry,
 		if (error)
 			break;
 
-		bytes = do_splice_direct(old_file, &old_pos,
-					 new_file, &new_pos,
-					 this_len, SPLICE_F_MOVE);
+		bytes = 0;
+		if (try_copy_range) {
+			bytes = vfs_copy_file_range(old_file, old_pos,
+						    new_file, new_pos,
+						    this_len, 0);
+			if (bytes > 0) {
+				old_pos += bytes;
+				new_pos += bytes;
+			} else {
+				try_copy_range = false;
+			}
+		}
+		if (bytes <= 0)
+			bytes = do_splice_direct(old_file, &old_pos,
+						 new_file, &new_pos,
+						 this_len, SPLICE_F_MOVE);
 		if (bytes <= 0) {
 			error = bytes;
 			break;
@@ -1119,6 +1119,10 @@ struct dentry *ovl_lookup(struct inode *dir, struct dentry *dentry,
 			d.last = lower.layer->idx == ovl_numlower(roe);
 
 		d.layer = lower.layer;
+		/* Skip lower dirs known not to have the name, as if it was negative */
+		if (poe == OVL_I_E(dir) && d.name.name[0] != '/' &&
+		    ovl_lower_names_excludes(dir, i, &d.name))
+			continue;
 		err = ovl_lookup_layer(lower.dentry, &d, &this, false);
 		if (err)
 			goto out_put;
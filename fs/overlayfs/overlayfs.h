@@ -720,6 +720,9 @@ void ovl_cleanup_whiteouts(struct ovl_fs *ofs, struct dentry *upper,
 			   struct list_head *list);
 void ovl_cache_free(struct list_head *list);
 void ovl_dir_cache_free(struct inode *inode);
+bool ovl_lower_names_excludes(struct inode *dir, unsigned int lower,
+			      const struct qstr *name);
+void ovl_lower_names_destroy(struct inode *inode);
 int ovl_check_d_type_supported(const struct path *realpath);
 int ovl_workdir_cleanup(struct ovl_fs *ofs, struct inode *dir,
 			struct vfsmount *mnt, struct dentry *dentry, int level);
@@ -165,6 +165,7 @@ struct ovl_inode {
 		const char *lowerdata_redirect;	/* regular file */
 	};
 	const char *redirect;
+	struct ovl_lower_names *lower_names;	/* directory */
 	u64 version;
 	unsigned long flags;
 	struct inode vfs_inode;
@@ -13,6 +13,8 @@
 #include <linux/security.h>
 #include <linux/cred.h>
 #include <linux/ratelimit.h>
+#include <linux/log2.h>
+#include <linux/name_bloom.h>
 #include "overlayfs.h"
 
 struct ovl_cache_entry {
@@ -36,6 +38,26 @@ struct ovl_dir_cache {
 	struct rb_root root;
 };
 
+/*
+ * Names of the lower directories of a merged directory, one Bloom filter per
+ * entry of its lower stack, recorded the first time the merged directory is
+ * read.  Lower layers do not change while mounted, so a name missing from a
+ * filter need not be looked up in that lower directory.
+ */
+#define OVL_NAMES_MIN_ORDER		10
+#define OVL_NAMES_MAX_ORDER		16
+
+struct ovl_names_filter {
+	unsigned int order;
+	unsigned int nr_names;
+	unsigned long bits[];
+};
+
+struct ovl_lower_names {
+	unsigned int numlower;
+	struct ovl_names_filter *filter[];
+};
+
 struct ovl_readdir_data {
 	struct dir_context ctx;
 	struct dentry *dentry;
@@ -49,6 +71,7 @@ struct ovl_readdir_data {
 	bool is_upper;
 	bool d_type_supported;
 	bool in_xwhiteouts_dir;
+	struct ovl_names_filter *filter;
 };
 
 struct ovl_dir_file {
@@ -254,6 +277,93 @@ static void ovl_cache_put(struct ovl_dir_file *od, struct inode *inode)
 	}
 }
 
+static void ovl_names_filter_add(struct ovl_names_filter *filter,
+				 const char *name, unsigned int len)
+{
+	name_bloom_add(filter->bits, filter->order, name, len);
+	filter->nr_names++;
+}
+
+static bool ovl_names_filter_has(const struct ovl_names_filter *filter,
+				 const char *name, unsigned int len)
+{
+	/* A filter holding too many names is not useful. */
+	if (name_bloom_overfull(filter->order, filter->nr_names))
+		return true;
+	return name_bloom_test(filter->bits, filter->order, name, len);
+}
+
+static struct ovl_names_filter *ovl_names_filter_alloc(const struct path *realpath)
+{
+	struct inode *inode = d_inode(realpath->dentry);
+	struct ovl_names_filter *filter;
+	unsigned int order;
+
+	/* Names that do not match byte for byte cannot be filtered. */
+	if (IS_CASEFOLDED(inode) || IS_ENCRYPTED(inode) ||
+	    realpath->dentry->d_flags & (DCACHE_OP_HASH | DCACHE_OP_COMPARE))
+		return NULL;
+
+	order = clamp_t(unsigned int, order_base_2(i_size_read(inode)),
+			OVL_NAMES_MIN_ORDER, OVL_NAMES_MAX_ORDER);
+	filter = kzalloc(struct_size(filter, bits, BITS_TO_LONGS(1U << order)),
+			 GFP_KERNEL);
+	if (filter)
+		filter->order = order;
+	return filter;
+}
+
+static void ovl_lower_names_free(struct ovl_lower_names *names)
+{
+	unsigned int i;
+
+	if (!names)
+		return;
+	for (i = 0; i < names->numlower; i++)
+		kfree(names->filter[i]);
+	kfree(names);
+}
+
+static struct ovl_lower_names *ovl_lower_names_alloc(struct dentry *dentry)
+{
+	struct ovl_entry *oe = OVL_E(dentry);
+	struct ovl_lower_names *names;
+
+	if (!ovl_numlower(oe) ||
+	    smp_load_acquire(&OVL_I(d_inode(dentry))->lower_names))
+		return NULL;
+
+	names = kzalloc(struct_size(names, filter, ovl_numlower(oe)),
+			GFP_KERNEL);
+	if (names)
+		names->numlower = ovl_numlower(oe);
+	return names;
+}
+
+/**
+ * ovl_lower_names_excludes - is a name known to be missing from a lower dir
+ * @dir: the merged directory
+ * @lower: index into the lower stack of @dir
+ * @name: the name, relative to that lower directory
+ */
+bool ovl_lower_names_excludes(struct inode *dir, unsigned int lower,
+			      const struct qstr *name)
+{
+	struct ovl_lower_names *names;
+	struct ovl_names_filter *filter;
+
+	names = smp_load_acquire(&OVL_I(dir)->lower_names);
+	if (!names || lower >= names->numlower)
+		return false;
+	filter = names->filter[lower];
+	return filter && !ovl_names_filter_has(filter, name->name, name->len);
+}
+
+void ovl_lower_names_destroy(struct inode *inode)
+{
+	ovl_lower_names_free(OVL_I(inode)->lower_names);
+}
+
 static bool ovl_fill_merge(struct dir_context *ctx, const char *name,
 			  int namelen, loff_t offset, u64 ino,
 			  unsigned int d_type)
@@ -262,6 +372,8 @@ static bool ovl_fill_merge(struct dir_context *ctx, const char *name,
 		container_of(ctx, struct ovl_readdir_data, ctx);
 
 	rdd->count++;
+	if (rdd->filter)
+		ovl_names_filter_add(rdd->filter, name, namelen);
 	if (!rdd->is_lowest)
 		return ovl_cache_entry_add_rb(rdd, name, namelen, ino, d_type);
 	else
@@ -358,12 +470,19 @@ static int ovl_dir_read_merged(struct dentry *dentry, struct list_head *list,
 	};
 	int idx, next;
 	const struct ovl_layer *layer;
+	struct ovl_lower_names *names = ovl_lower_names_alloc(dentry);
+	unsigned int lower = 0;
 
 	for (idx = 0; idx != -1; idx = next) {
 		next = ovl_path_next(idx, dentry, &realpath, &layer);
 		rdd.is_upper = ovl_dentry_upper(dentry) == realpath.dentry;
 		rdd.in_xwhiteouts_dir = layer->has_xwhiteouts &&
 					ovl_dentry_has_xwhiteouts(dentry);
+		rdd.filter = NULL;
+		if (names && !rdd.is_upper) {
+			rdd.filter = ovl_names_filter_alloc(&realpath);
+			names->filter[lower++] = rdd.filter;
+		}
 
 		if (next != -1) {
 			err = ovl_dir_read(&realpath, &rdd);
@@ -380,6 +499,10 @@ static int ovl_dir_read_merged(struct dentry *dentry, struct list_head *list,
 			list_del(&rdd.middle);
 		}
 	}
+
+	if (names && (err ||
+	    cmpxchg_release(&OVL_I(d_inode(dentry))->lower_names, NULL, names)))
+		ovl_lower_names_free(names);
 	return err;
 }
 
@@ -172,6 +172,7 @@ static struct inode *ovl_alloc_inode(struct super_block *sb)
 
 	oi->cache = NULL;
 	oi->redirect = NULL;
+	oi->lower_names = NULL;
 	oi->version = 0;
 	oi->flags = 0;
 	oi->__upperdentry = NULL;
@@ -198,9 +199,10 @@ static void ovl_destroy_inode(struct inode *inode)
 
 	dput(oi->__upperdentry);
 	ovl_stack_put(ovl_lowerstack(oi->oe), ovl_numlower(oi->oe));
-	if (S_ISDIR(inode->i_mode))
+	if (S_ISDIR(inode->i_mode)) {
 		ovl_dir_cache_free(inode);
-	else
+		ovl_lower_names_destroy(inode);
+	} else
 		kfree(oi->lowerdata_redirect);
 }
 
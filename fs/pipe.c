@@ -112,34 +112,66 @@ void pipe_double_lock(struct pipe_inode_info *pipe1,
 	pipe_lock(pipe2);
 }
 
+/*
+ * Released pages are kept for the writer as long as the pipe would not hold
+ * more pages than fit in its ring, so a pipe streaming at full size stops
+ * going to the page allocator for every page it moves.  A couple of pages
+ * are always kept, which is all small writes need.  Nothing reclaims the
+ * cache of an idle pipe, so it is capped at the size of a default pipe.
+ */
+#define PIPE_MIN_TMP_PAGES	2
+#define PIPE_MAX_TMP_PAGES	PIPE_DEF_BUFFERS
+
 static struct page *anon_pipe_get_page(struct pipe_inode_info *pipe)
 {
-	for (int i = 0; i < ARRAY_SIZE(pipe->tmp_page); i++) {
-		if (pipe->tmp_page[i]) {
-			struct page *page = pipe->tmp_page[i];
-			pipe->tmp_page[i] = NULL;
-			return page;
-		}
+	struct page *page;
+
+	page = list_first_entry_or_null(&pipe->tmp_pages, struct page, lru);
+	if (page) {
+		list_del(&page->lru);
+		pipe->nr_tmp_pages--;
+		return page;
 	}
 
 	return alloc_page(GFP_HIGHUSER | __GFP_ACCOUNT);
 }
 
+static bool anon_pipe_keep_page(struct pipe_inode_info *pipe)
+{
+	unsigned int used = pipe_occupancy(pipe->head, pipe->tail);
+
+	if (pipe->nr_tmp_pages < PIPE_MIN_TMP_PAGES)
+		return true;
+	return pipe->nr_tmp_pages < PIPE_MAX_TMP_PAGES &&
+	       used + pipe->nr_tmp_pages <= pipe->max_usage;
+}
+
 static void anon_pipe_put_page(struct pipe_inode_info *pipe,
 			       struct page *page)
 {
-	if (page_count(page) == 1) {
-		for (int i = 0; i < ARRAY_SIZE(pipe->tmp_page); i++) {
-			if (!pipe->tmp_page[i]) {
-				pipe->tmp_page[i] = page;
-				return;
-			}
-		}
+	if (page_count(page) == 1 && anon_pipe_keep_page(pipe)) {
+		list_add(&page->lru, &pipe->tmp_pages);
+		pipe->nr_tmp_pages++;
+		return;
 	}
 
 	put_page(page);
 }
 
+static void anon_pipe_trim_pages(struct pipe_inode_info *pipe,
+				 unsigned int keep)
+{
+	struct page *page, *next;
+
+	list_for_each_entry_safe(page, next, &pipe->tmp_pages, lru) {
+		if (pipe->nr_tmp_pages <= keep)
+			break;
+		list_del(&page->lru);
+		pipe->nr_tmp_pages--;
+		__free_page(page);
+	}
+}
+
 static void anon_pipe_buf_release(struct pipe_inode_info *pipe,
 				  struct pipe_buffer *buf)
 {
@@ -824,6 +856,7 @@ struct pipe_inode_info *alloc_pipe_info(void)
 		pipe->ring_size = pipe_bufs;
 		pipe->nr_accounted = pipe_bufs;
 		pipe->user = user;
+		INIT_LIST_HEAD(&pipe->tmp_pages);
 		mutex_init(&pipe->mutex);
 		lock_set_cmp_fn(&pipe->mutex, pipe_lock_cmp_fn, NULL);
 		return pipe;
@@ -857,10 +890,7 @@ void free_pipe_info(struct pipe_inode_info *pipe)
 	if (pipe->watch_queue)
 		put_watch_queue(pipe->watch_queue);
 #endif
-	for (i = 0; i < ARRAY_SIZE(pipe->tmp_page); i++) {
-		if (pipe->tmp_page[i])
-			__free_page(pipe->tmp_page[i]);
-	}
+	anon_pipe_trim_pages(pipe, 0);
 	kfree(pipe->bufs);
 	kfree(pipe);
 }
@@ -1349,6 +1379,11 @@ int pipe_resize_ring(struct pipe_inode_info *pipe, unsigned int nr_slots)
 
 	spin_unlock_irq(&pipe->rd_wait.lock);
 
+	if (n + pipe->nr_tmp_pages > pipe->max_usage)
+		anon_pipe_trim_pages(pipe, max_t(unsigned int,
+				pipe->max_usage - min(n, pipe->max_usage),
+				PIPE_MIN_TMP_PAGES));
+
 	/* This might have made more room for writers */
 	wake_up_interruptible(&pipe->wr_wait);
 	return 0;
@@ -21,6 +21,9 @@
 #include <linux/unistd.h>
 #include <linux/compat.h>
 #include <linux/uaccess.h>
+#include <linux/namei.h>
+
+#include "internal.h"
 
 /*
  * Some filesystems were never converted to '->iterate_shared()'
@@ -337,6 +340,7 @@ SYSCALL_DEFINE3(getdents, unsigned int, fd,
 struct getdents_callback64 {
 	struct dir_context ctx;
 	struct linux_dirent64 __user * current_dir;
+	struct dir_summary *summary;
 	int prev_reclen;
 	int count;
 	int error;
@@ -374,6 +378,8 @@ static bool filldir64(struct dir_context *ctx, const char *name, int namlen,
 	unsafe_copy_dirent_name(dirent->d_name, name, namlen, efault_end);
 	user_write_access_end();
 
+	if (buf->summary)
+		dir_summary_record(buf->summary, name, namlen);
 	buf->prev_reclen = reclen;
 	buf->current_dir = (void __user *)dirent + reclen;
 	buf->count -= reclen;
@@ -400,6 +406,7 @@ SYSCALL_DEFINE3(getdents64, unsigned int, fd,
 	if (fd_empty(f))
 		return -EBADF;
 
+	buf.summary = dir_summary_begin(fd_file(f));
 	error = iterate_dir(fd_file(f), &buf.ctx);
 	if (error >= 0)
 		error = buf.error;
@@ -413,6 +420,190 @@ SYSCALL_DEFINE3(getdents64, unsigned int, fd,
 		else
 			error = count - buf.count;
 	}
+	dir_summary_end(fd_file(f), buf.summary, !error);
+	return error;
+}
+
+struct getdents_statx_callback {
+	struct dir_context ctx;
+	struct linux_dirent_statx __user * current_dir;
+	int prev_reclen;
+	int count;
+	int error;
+};
+
+static bool filldir_statx(struct dir_context *ctx, const char *name,
+			  int namlen, loff_t offset, u64 ino,
+			  unsigned int d_type)
+{
+	struct linux_dirent_statx __user *dirent, *prev;
+	struct getdents_statx_callback *buf =
+		container_of(ctx, struct getdents_statx_callback, ctx);
+	int reclen = ALIGN(offsetof(struct linux_dirent_statx, d_name) +
+			   namlen + 1, sizeof(u64));
+	int prev_reclen;
+
+	buf->error = verify_dirent_name(name, namlen);
+	if (unlikely(buf->error))
+		return false;
+	buf->error = -EINVAL;	/* only used if we fail.. */
+	if (reclen > buf->count)
+		return false;
+	prev_reclen = buf->prev_reclen;
+	if (prev_reclen && signal_pending(current))
+		return false;
+	dirent = buf->current_dir;
+	prev = (void __user *)dirent - prev_reclen;
+	if (!user_write_access_begin(prev, reclen + prev_reclen))
+		goto efault;
+
+	/* This might be 'dirent->d_off', but if so it will get overwritten */
+	unsafe_put_user(offset, &prev->d_off, efault_end);
+	unsafe_put_user(ino, &dirent->d_ino, efault_end);
+	unsafe_put_user(reclen, &dirent->d_reclen, efault_end);
+	unsafe_put_user(d_type, &dirent->d_type, efault_end);
+	unsafe_put_user(-EAGAIN, &dirent->d_stx_error, efault_end);
+	unsafe_copy_dirent_name(dirent->d_name, name, namlen, efault_end);
+	user_write_access_end();
+
+	buf->prev_reclen = reclen;
+	buf->current_dir = (void __user *)dirent + reclen;
+	buf->count -= reclen;
+	return true;
+
+efault_end:
+	user_write_access_end();
+efault:
+	buf->error = -EFAULT;
+	return false;
+}
+
+static int getdents_statx_entry(struct file *file, const char *name, int len,
+				unsigned int mask, unsigned int flags,
+				struct statx __user *buffer)
+{
+	struct path path;
+	int error;
+
+	if (len == 1 && name[0] == '.') {
+		path = file->f_path;
+		path_get(&path);
+	} else if (len == 2 && name[0] == '.' && name[1] == '.') {
+		/* may leave the mount, let statx() deal with it */
+		return -EAGAIN;
+	} else {
+		path.dentry = lookup_one_positive_unlocked(file_mnt_idmap(file),
+						name, file->f_path.dentry, len);
+		if (IS_ERR(path.dentry))
+			return PTR_ERR(path.dentry);
+		path.mnt = mntget(file->f_path.mnt);
+		error = follow_down(&path, 0);
+		if (error) {
+			path_put(&path);
+			return error;
+		}
+	}
+
+	error = do_statx_path(&path, flags, mask, buffer);
+	path_put(&path);
+	return error;
+}
+
+/*
+ * Fill in the attributes of the entries getdents_statx() returned, once the
+ * directory is no longer locked.  The names are read back from the user
+ * buffer, which can at worst confuse the caller about its own entries.
+ */
+static void getdents_statx_fill(struct file *file,
+				struct linux_dirent_statx __user *dirent,
+				unsigned int len, unsigned int mask,
+				unsigned int flags)
+{
+	const unsigned int hdr = offsetof(struct linux_dirent_statx, d_name);
+	char name[NAME_MAX + 1];
+
+	while (len > hdr) {
+		unsigned short reclen;
+		long namelen;
+		int error;
+
+		if (get_user(reclen, &dirent->d_reclen) ||
+		    reclen <= hdr || reclen > len)
+			break;
+		if (fatal_signal_pending(current))
+			break;
+
+		namelen = strncpy_from_user(name, dirent->d_name,
+					    min_t(unsigned int, sizeof(name),
+						  reclen - hdr));
+		if (namelen > 0 && namelen < sizeof(name) &&
+		    !memchr(name, '/', namelen))
+			error = getdents_statx_entry(file, name, namelen,
+						     mask, flags,
+						     &dirent->d_stx);
+		else
+			error = -EAGAIN;
+		if (put_user(error, &dirent->d_stx_error))
+			break;
+
+		dirent = (void __user *)dirent + reclen;
+		len -= reclen;
+		cond_resched();
+	}
+}
+
+/**
+ * sys_getdents_statx - read directory entries along with their attributes
+ * @fd: directory
+ * @dirent: buffer for struct linux_dirent_statx records
+ * @count: size of @dirent
+ * @mask: STATX_* attributes wanted, as for statx()
+ * @flags: AT_STATX_* synchronisation flags, as for statx()
+ *
+ * Works like getdents64(), and additionally fills in the attributes of every
+ * returned entry.  Filesystems that already brought the inodes in while
+ * reading the directory, such as NFS with READDIRPLUS, answer from cache.
+ *
+ * Return: the number of bytes filled in, 0 at end of directory, or a
+ * negative error.
+ */
+SYSCALL_DEFINE5(getdents_statx, unsigned int, fd,
+		struct linux_dirent_statx __user *, dirent,
+		unsigned int, count, unsigned int, mask, unsigned int, flags)
+{
+	CLASS(fd_pos, f)(fd);
+	struct getdents_statx_callback buf = {
+		.ctx.actor = filldir_statx,
+		.count = count,
+		.current_dir = dirent
+	};
+	int error;
+
+	if (flags & ~AT_STATX_SYNC_TYPE)
+		return -EINVAL;
+	if ((flags & AT_STATX_SYNC_TYPE) == AT_STATX_SYNC_TYPE)
+		return -EINVAL;
+	if (mask & STATX__RESERVED)
+		return -EINVAL;
+	if (fd_empty(f))
+		return -EBADF;
+
+	error = iterate_dir(fd_file(f), &buf.ctx);
+	if (error >= 0)
+		error = buf.error;
+	if (buf.prev_reclen) {
+		struct linux_dirent_statx __user * lastdirent;
+		typeof(lastdirent->d_off) d_off = buf.ctx.pos;
+
+		lastdirent = (void __user *) buf.current_dir - buf.prev_reclen;
+		if (put_user(d_off, &lastdirent->d_off))
+			error = -EFAULT;
+		else
+			error = count - buf.count;
+	}
+	if (error > 0)
+		getdents_statx_fill(fd_file(f), dirent, error, mask,
+				    flags | AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT);
 	return error;
 }
 
@@ -327,29 +327,43 @@ static int vfs_statx_fd(int fd, int flags, struct kstat *stat,
  * @flags: Flags to control the query
  * @stat: The result structure to fill in.
  * @request_mask: STATX_xxx flags indicating what the caller wants
+ * @lookup_flags: 0 or LOOKUP_CACHED
  *
  * This function is a wrapper around vfs_getattr().  The main difference is
  * that it uses a filename and base directory to determine the file location.
  * Additionally, the use of AT_SYMLINK_NOFOLLOW in flags will prevent a symlink
  * at the given name from being referenced.
  *
+ * With LOOKUP_CACHED the walk is done from the dcache under RCU only, and
+ * -EAGAIN is returned whenever it or the attribute fetch could block.
+ *
  * 0 will be returned on success, and a -ve error code if unsuccessful.
  */
 static int vfs_statx(int dfd, struct filename *filename, int flags,
-	      struct kstat *stat, u32 request_mask)
+	      struct kstat *stat, u32 request_mask, unsigned int lookup_flags)
 {
 	struct path path;
-	unsigned int lookup_flags = statx_lookup_flags(flags);
 	int error;
 
 	if (flags & ~(AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT | AT_EMPTY_PATH |
 		      AT_STATX_SYNC_TYPE))
 		return -EINVAL;
 
+	lookup_flags |= statx_lookup_flags(flags);
 retry:
 	error = filename_lookup(dfd, filename, lookup_flags, &path, NULL);
 	if (error)
 		return error;
+	/*
+	 * Filesystems that revalidate dentries generally go to their server
+	 * for attributes as well, unless told to use what they have cached.
+	 */
+	if ((lookup_flags & LOOKUP_CACHED) &&
+	    (path.dentry->d_flags & DCACHE_OP_REVALIDATE) &&
+	    (flags & AT_STATX_SYNC_TYPE) != AT_STATX_DONT_SYNC) {
+		path_put(&path);
+		return -EAGAIN;
+	}
 	error = vfs_statx_path(&path, flags, stat, request_mask);
 	path_put(&path);
 	if (retry_estale(error, lookup_flags)) {
@@ -369,7 +383,7 @@ int vfs_fstatat(int dfd, const char __user *filename,
 	if (!name && dfd >= 0)
 		return vfs_fstat(dfd, stat);
 
-	ret = vfs_statx(dfd, name, statx_flags, stat, STATX_BASIC_STATS);
+	ret = vfs_statx(dfd, name, statx_flags, stat, STATX_BASIC_STATS, 0);
 	putname(name);
 
 	return ret;
@@ -741,7 +755,33 @@ cp_statx(const struct kstat *stat, struct statx __user *buffer)
 }
 
 int do_statx(int dfd, struct filename *filename, unsigned int flags,
-	     unsigned int mask, struct statx __user *buffer)
+	     unsigned int mask, struct statx __user *buffer,
+	     unsigned int lookup_flags)
+{
+	struct kstat stat;
+	int error;
+
+	if (mask & STATX__RESERVED)
+		return -EINVAL;
+	if ((flags & AT_STATX_SYNC_TYPE) == AT_STATX_SYNC_TYPE)
+		return -EINVAL;
+
+	/*
+	 * STATX_CHANGE_COOKIE is kernel-only for now. Ignore requests
+	 * from userland.
+	 */
+	mask &= ~STATX_CHANGE_COOKIE;
+
+	error = vfs_statx(dfd, filename, flags, &stat, mask, lookup_flags);
+	if (error)
+		return error;
+
+	return cp_statx(&stat, buffer);
+}
+
+/* Fill in @buffer for @path as statx() would; used by getdents_statx() */
+int do_statx_path(struct path *path, unsigned int flags,
+		  unsigned int mask, struct statx __user *buffer)
 {
 	struct kstat stat;
 	int error;
@@ -757,7 +797,7 @@ int do_statx(int dfd, struct filename *filename, unsigned int flags,
 	 */
 	mask &= ~STATX_CHANGE_COOKIE;
 
-	error = vfs_statx(dfd, filename, flags, &stat, mask);
+	error = vfs_statx_path(path, flags, &stat, mask);
 	if (error)
 		return error;
 
@@ -811,7 +851,7 @@ SYSCALL_DEFINE5(statx,
 	if (!name && dfd >= 0)
 		return do_statx_fd(dfd, flags & ~AT_NO_AUTOMOUNT, mask, buffer);
 
-	ret = do_statx(dfd, name, flags, mask, buffer);
+	ret = do_statx(dfd, name, flags, mask, buffer, 0);
 	putname(name);
 
 	return ret;
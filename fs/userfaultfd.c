@@ -1989,6 +1989,54 @@ static int userfaultfd_api(struct userfaultfd_ctx *ctx,
 	goto out;
 }
 
+static int userfaultfd_batch(struct userfaultfd_ctx *ctx, unsigned long arg)
+{
+	struct uffdio_batch uffdio_batch;
+	struct uffdio_batch __user *user_uffdio_batch;
+	int (*op)(struct userfaultfd_ctx *ctx, unsigned long arg);
+	unsigned long ops, size;
+	__s64 done;
+	int ret;
+
+	user_uffdio_batch = (struct uffdio_batch __user *)arg;
+
+	if (copy_from_user(&uffdio_batch, user_uffdio_batch,
+			   /* don't copy "done" last field */
+			   sizeof(uffdio_batch) - sizeof(__s64)))
+		return -EFAULT;
+
+	switch (uffdio_batch.ioctl) {
+	case UFFDIO_COPY:
+		op = userfaultfd_copy;
+		size = sizeof(struct uffdio_copy);
+		break;
+	case UFFDIO_CONTINUE:
+		op = userfaultfd_continue;
+		size = sizeof(struct uffdio_continue);
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	ops = uffdio_batch.ops;
+	ret = 0;
+	for (done = 0; done < uffdio_batch.nr_ops; done++, ops += size) {
+		ret = op(ctx, ops);
+		if (ret)
+			break;
+		if (fatal_signal_pending(current)) {
+			ret = -EINTR;
+			done++;
+			break;
+		}
+		cond_resched();
+	}
+
+	if (unlikely(put_user(done, &user_uffdio_batch->done)))
+		return -EFAULT;
+	return ret;
+}
+
 static long userfaultfd_ioctl(struct file *file, unsigned cmd,
 			      unsigned long arg)
 {
@@ -2029,6 +2077,9 @@ static long userfaultfd_ioctl(struct file *file, unsigned cmd,
 	case UFFDIO_POISON:
 		ret = userfaultfd_poison(ctx, arg);
 		break;
+	case UFFDIO_BATCH:
+		ret = userfaultfd_batch(ctx, arg);
+		break;
 	}
 	return ret;
 }
@@ -19,6 +19,7 @@
 #include <linux/slab.h>
 #include <linux/spinlock_types.h>
 #include <linux/types.h>
+#include <linux/workqueue_types.h>
 
 /* Set this bit if source is virtual address instead of SG list. */
 #define CRYPTO_ACOMP_REQ_SRC_VIRT	0x00000002
@@ -71,6 +72,7 @@ struct acomp_req_chain {
 	size_t soff;
 	size_t doff;
 	u32 flags;
+	struct work_struct work;
 };
 
 /**
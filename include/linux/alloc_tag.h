@@ -122,10 +122,32 @@ static inline bool mem_alloc_profiling_enabled(void)
 				   &mem_alloc_profiling_key);
 }
 
+/*
+ * With vm.mem_profiling_sample_interval set to N > 1, only one in N
+ * allocations is tagged and the counters are scaled by N when read.
+ */
+DECLARE_STATIC_KEY_FALSE(mem_alloc_profiling_sampled);
+DECLARE_PER_CPU(int, alloc_tag_sample_countdown);
+extern unsigned int mem_alloc_profiling_sample_interval;
+
+static inline bool alloc_tag_sample(void)
+{
+	if (!static_branch_unlikely(&mem_alloc_profiling_sampled))
+		return true;
+
+	if (likely(this_cpu_dec_return(alloc_tag_sample_countdown) > 0))
+		return false;
+
+	this_cpu_write(alloc_tag_sample_countdown,
+		       READ_ONCE(mem_alloc_profiling_sample_interval));
+	return true;
+}
+
 static inline struct alloc_tag_counters alloc_tag_read(struct alloc_tag *tag)
 {
 	struct alloc_tag_counters v = { 0, 0 };
 	struct alloc_tag_counters *counter;
+	unsigned int scale;
 	int cpu;
 
 	for_each_possible_cpu(cpu) {
@@ -134,6 +156,12 @@ static inline struct alloc_tag_counters alloc_tag_read(struct alloc_tag *tag)
 		v.calls += counter->calls;
 	}
 
+	if (static_branch_unlikely(&mem_alloc_profiling_sampled)) {
+		scale = READ_ONCE(mem_alloc_profiling_sample_interval);
+		v.bytes *= scale;
+		v.calls *= scale;
+	}
+
 	return v;
 }
 
@@ -184,6 +212,12 @@ static inline bool alloc_tag_ref_set(union codetag_ref *ref, struct alloc_tag *t
 
 static inline void alloc_tag_add(union codetag_ref *ref, struct alloc_tag *tag, size_t bytes)
 {
+	if (!alloc_tag_sample()) {
+		/* Not sampled: leave the object untagged, freeing skips it */
+		set_codetag_empty(ref);
+		return;
+	}
+
 	if (likely(alloc_tag_ref_set(ref, tag)))
 		this_cpu_add(tag->counters->bytes, bytes);
 }
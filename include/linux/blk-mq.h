@@ -681,7 +681,13 @@ enum {
 	 */
 	BLK_MQ_F_NO_SCHED_BY_DEFAULT	= 1 << 6,
 
-	BLK_MQ_F_MAX = 1 << 7,
+	/*
+	 * Keep a small per-cpu cache of free tags in front of the sbitmap,
+	 * for high IOPS devices with fewer hardware queues than CPUs.
+	 */
+	BLK_MQ_F_TAG_CACHE	= 1 << 7,
+
+	BLK_MQ_F_MAX = 1 << 8,
 };
 
 #define BLK_MQ_MAX_DEPTH	(10240)
@@ -761,6 +767,10 @@ struct blk_mq_tags {
 	 * request pool
 	 */
 	spinlock_t lock;
+
+	/* per-cpu free tag caches, only with BLK_MQ_F_TAG_CACHE */
+	struct blk_mq_tag_cache __percpu *cache;
+	unsigned int cache_max;
 };
 
 static inline struct request *blk_mq_tag_to_rq(struct blk_mq_tags *tags,
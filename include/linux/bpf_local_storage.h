@@ -16,7 +16,10 @@
 #include <linux/bpf_mem_alloc.h>
 #include <uapi/linux/btf.h>
 
-#define BPF_LOCAL_STORAGE_CACHE_SIZE	16
+/* Maps of one storage type beyond this many share cache slots and a
+ * lookup through a shared slot may have to walk the owner's list.
+ */
+#define BPF_LOCAL_STORAGE_CACHE_SIZE	32
 
 #define bpf_rcu_lock_held()                                                    \
 	(rcu_read_lock_held() || rcu_read_lock_trace_held() ||                 \
@@ -115,8 +118,6 @@ struct bpf_local_storage {
 	container_of((_SDATA), struct bpf_local_storage_elem, sdata)
 #define SDATA(_SELEM) (&(_SELEM)->sdata)
 
-#define BPF_LOCAL_STORAGE_CACHE_SIZE	16
-
 struct bpf_local_storage_cache {
 	spinlock_t idx_lock;
 	u64 idx_usage_counts[BPF_LOCAL_STORAGE_CACHE_SIZE];
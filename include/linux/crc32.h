@@ -14,6 +14,8 @@ u32 crc32_be_arch(u32 crc, const u8 *p, size_t len);
 u32 crc32_be_base(u32 crc, const u8 *p, size_t len);
 u32 crc32c_arch(u32 crc, const u8 *p, size_t len);
 u32 crc32c_base(u32 crc, const u8 *p, size_t len);
+void crc32c_multi_base(u32 *crcs, const u8 * const *bufs, size_t len,
+		       unsigned int nr);
 
 static inline u32 crc32_le(u32 crc, const void *p, size_t len)
 {
@@ -36,6 +38,30 @@ static inline u32 crc32c(u32 crc, const void *p, size_t len)
 	return crc32c_base(crc, p, len);
 }
 
+/**
+ * crc32c_multi - Update the crc32c() values of several equally long buffers
+ * @crcs: @nr check values, each updated with the data of its buffer
+ * @bufs: @nr buffers of @len bytes each
+ * @len: length of each buffer
+ * @nr: number of buffers
+ *
+ * Gives the same results as calling crc32c() on each buffer in turn, but
+ * the generic code works on several buffers at once, which is faster for
+ * the many small blocks of per-sector or per-PDU checksums.
+ */
+static inline void crc32c_multi(u32 *crcs, const u8 * const *bufs,
+				size_t len, unsigned int nr)
+{
+	unsigned int i;
+
+	if (IS_ENABLED(CONFIG_CRC32_ARCH)) {
+		for (i = 0; i < nr; i++)
+			crcs[i] = crc32c_arch(crcs[i], bufs[i], len);
+		return;
+	}
+	crc32c_multi_base(crcs, bufs, len, nr);
+}
+
 /*
  * crc32_optimizations() returns flags that indicate which CRC32 library
  * functions are using architecture-specific optimizations.  Unlike
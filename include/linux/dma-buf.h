@@ -467,6 +467,18 @@ struct dma_buf_attach_ops {
 	 */
 	bool allow_peer2peer;
 
+	/**
+	 * @cache_sgt_mapping:
+	 *
+	 * If true the framework keeps the first mapping of a dynamic exporter
+	 * around and hands it out again to later map calls of the attachment,
+	 * instead of asking the exporter for a new one each time.  The cached
+	 * mapping is dropped again once the DMA-buf moves and every user has
+	 * unmapped it.  Only effective with CONFIG_DMABUF_MOVE_NOTIFY, as the
+	 * buffer would otherwise stay pinned for the attachment's lifetime.
+	 */
+	bool cache_sgt_mapping;
+
 	/**
 	 * @move_notify: [optional] notification that the DMA-buf is moving
 	 *
@@ -495,6 +507,8 @@ struct dma_buf_attach_ops {
  * @node: list of dma_buf_attachment, protected by dma_resv lock of the dmabuf.
  * @sgt: cached mapping.
  * @dir: direction of cached mapping.
+ * @sgt_users: number of unmatched map calls @sgt was returned by.
+ * @sgt_stale: the DMA-buf moved since @sgt was created.
  * @peer2peer: true if the importer can handle peer resources without pages.
  * @priv: exporter specific attachment data.
  * @importer_ops: importer operations for this attachment, if provided
@@ -516,6 +530,8 @@ struct dma_buf_attachment {
 	struct list_head node;
 	struct sg_table *sgt;
 	enum dma_data_direction dir;
+	unsigned int sgt_users;
+	bool sgt_stale;
 	bool peer2peer;
 	const struct dma_buf_attach_ops *importer_ops;
 	void *importer_priv;
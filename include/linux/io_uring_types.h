@@ -78,6 +78,16 @@ struct io_hash_table {
 	unsigned		hash_bits;
 };
 
+#define IO_HYBRID_POLL_BITS	3
+#define IO_HYBRID_POLL_SLOTS	(1U << IO_HYBRID_POLL_BITS)
+
+struct io_hybrid_poll_stat {
+	/* device the prediction is for, see io_hybrid_poll_key() */
+	const void		*key;
+	/* moving average of issue to completion time, in nsecs */
+	u64			lat_ns;
+};
+
 struct io_mapped_region {
 	struct page		**pages;
 	void			*ptr;
@@ -253,6 +263,7 @@ struct io_ring_ctx {
 		unsigned int		drain_disabled: 1;
 		unsigned int		compat: 1;
 		unsigned int		iowq_limits_set : 1;
+		unsigned int		lat_stats_active: 1;
 
 		struct task_struct	*submitter_task;
 		struct io_rings		*rings;
@@ -263,6 +274,9 @@ struct io_ring_ctx {
 
 		enum task_work_notify_mode	notify_method;
 		unsigned			sq_thread_idle;
+
+		/* see IORING_REGISTER_LAT_STATS */
+		struct io_lat_stats __percpu	*lat_stats;
 	} ____cacheline_aligned_in_smp;
 
 	/* submission data */
@@ -325,11 +339,6 @@ struct io_ring_ctx {
 		 * ->uring_cmd() by io_uring_cmd_insert_cancelable()
 		 */
 		struct hlist_head	cancelable_uring_cmd;
-		/*
-		 * For Hybrid IOPOLL, runtime in hybrid polling, without
-		 * scheduling time
-		 */
-		u64					hybrid_poll_time;
 	} ____cacheline_aligned_in_smp;
 
 	struct {
@@ -394,7 +403,8 @@ struct io_ring_ctx {
 	struct wait_queue_head		poll_wq;
 	struct io_restriction		restrictions;
 
-	struct io_zcrx_ifq		*ifq;
+	/* zero copy rx interface queues, indexed by zcrx_id */
+	struct xarray			zcrx_ctxs;
 
 	u32			pers_next;
 	struct xarray		personalities;
@@ -448,8 +458,12 @@ struct io_ring_ctx {
 	struct io_mapped_region		ring_region;
 	/* used for optimised request parameter and wait argument passing  */
 	struct io_mapped_region		param_region;
-	/* just one zcrx per ring for now, will move to io_zcrx_ifq eventually */
-	struct io_mapped_region		zcrx_region;
+
+	/*
+	 * For Hybrid IOPOLL, predicted completion time per device, indexed
+	 * by a hash of the device. Protected by ->uring_lock.
+	 */
+	struct io_hybrid_poll_stat	hybrid_poll[IO_HYBRID_POLL_SLOTS];
 };
 
 /*
@@ -504,6 +518,9 @@ enum {
 	REQ_F_BUF_NODE_BIT,
 	REQ_F_HAS_METADATA_BIT,
 	REQ_F_IMPORT_BUFFER_BIT,
+	REQ_F_BUF_MORE_BIT,
+	REQ_F_LINK_RES_BIT,
+	REQ_F_LAT_STATS_BIT,
 
 	/* not a real bit, just to check we're not overflowing the space */
 	__REQ_F_LAST_BIT,
@@ -593,6 +610,15 @@ enum {
 	 * For SEND_ZC, whether to import buffers (i.e. the first issue).
 	 */
 	REQ_F_IMPORT_BUFFER	= IO_REQ_FLAG(REQ_F_IMPORT_BUFFER_BIT),
+	/*
+	 * Incrementally consumed buffer was committed at selection time and
+	 * still has data left, the CQE must carry IORING_CQE_F_BUF_MORE.
+	 */
+	REQ_F_BUF_MORE		= IO_REQ_FLAG(REQ_F_BUF_MORE_BIT),
+	/* cap the length to the previous request's result, see ->link_res() */
+	REQ_F_LINK_RES		= IO_REQ_FLAG(REQ_F_LINK_RES_BIT),
+	/* ->issue_ns is valid, see IORING_REGISTER_LAT_STATS */
+	REQ_F_LAT_STATS		= IO_REQ_FLAG(REQ_F_LAT_STATS_BIT),
 };
 
 typedef void (*io_req_tw_func_t)(struct io_kiocb *req, io_tw_token_t tw);
@@ -717,6 +743,9 @@ struct io_kiocb {
 		u64			extra1;
 		u64			extra2;
 	} big_cqe;
+
+	/* submission time, valid IFF REQ_F_LAT_STATS is set */
+	u64				issue_ns;
 };
 
 struct io_overflow_cqe {
@@ -648,12 +648,6 @@ struct transaction_s
 	 */
 	struct transaction_chp_stats_s t_chp_stats;
 
-	/*
-	 * Number of outstanding updates running on this transaction
-	 * [none]
-	 */
-	atomic_t		t_updates;
-
 	/*
 	 * Number of blocks reserved for this transaction in the journal.
 	 * This is including all credits reserved when starting transaction
@@ -669,7 +663,8 @@ struct transaction_s
 	atomic_t		t_outstanding_revokes;
 
 	/*
-	 * How many handles used this transaction? [none]
+	 * How many handles used this transaction?  Filled in from
+	 * j_handle_stats once the transaction is locked. [none]
 	 */
 	atomic_t		t_handle_count;
 
@@ -735,6 +730,12 @@ enum passtype {PASS_SCAN, PASS_REVOKE, PASS_REPLAY};
 #define JBD2_FC_REPLAY_STOP	0
 #define JBD2_FC_REPLAY_CONTINUE	1
 
+/* What start_this_handle() and stop_this_handle() count on each CPU. */
+struct jbd2_handle_stats {
+	int updates;
+	unsigned int handles;
+};
+
 /**
  * struct journal_s - The journal_s type is the concrete type associated with
  *     journal_t.
@@ -882,6 +883,17 @@ struct journal_s
 	 */
 	struct percpu_counter	j_checkpoint_jh_count;
 
+	/**
+	 * @j_handle_stats:
+	 *
+	 * Per-CPU counts of the handles started on and still running in the
+	 * running transaction; only that transaction can have handles.  A
+	 * handle may stop on another CPU than it started on, so only the
+	 * sums mean anything.  Incremented under read j_state_lock and
+	 * summed under write j_state_lock.
+	 */
+	struct jbd2_handle_stats __percpu *j_handle_stats;
+
 	/**
 	 * @j_shrink_transaction:
 	 *
@@ -1522,6 +1534,7 @@ extern void	 jbd2_journal_lock_updates (journal_t *);
 extern void	 jbd2_journal_unlock_updates (journal_t *);
 
 void jbd2_journal_wait_updates(journal_t *);
+unsigned int jbd2_journal_handle_count(journal_t *);
 
 extern journal_t * jbd2_journal_init_dev(struct block_device *bdev,
 				struct block_device *fs_dev,
@@ -13,6 +13,7 @@ extern void __khugepaged_enter(struct mm_struct *mm);
 extern void __khugepaged_exit(struct mm_struct *mm);
 extern void khugepaged_enter_vma(struct vm_area_struct *vma,
 				 unsigned long vm_flags);
+extern void khugepaged_hint(struct vm_area_struct *vma, unsigned long address);
 extern void khugepaged_min_free_kbytes_update(void);
 extern bool current_is_khugepaged(void);
 #ifdef CONFIG_SHMEM
@@ -54,6 +55,11 @@ static inline int collapse_pte_mapped_thp(struct mm_struct *mm,
 	return 0;
 }
 
+static inline void khugepaged_hint(struct vm_area_struct *vma,
+				   unsigned long address)
+{
+}
+
 static inline void khugepaged_min_free_kbytes_update(void)
 {
 }
@@ -339,8 +339,20 @@ int mtree_alloc_rrange(struct maple_tree *mt, unsigned long *startp,
 		void *entry, unsigned long size, unsigned long min,
 		unsigned long max, gfp_t gfp);
 
+/*
+ * One range of a mtree_store_ranges() call: @entry for @index to @last,
+ * NULL to erase the range.
+ */
+struct maple_range {
+	unsigned long index;
+	unsigned long last;
+	void *entry;
+};
+
 int mtree_store_range(struct maple_tree *mt, unsigned long first,
 		      unsigned long last, void *entry, gfp_t gfp);
+int mtree_store_ranges(struct maple_tree *mt, const struct maple_range *ranges,
+		       unsigned int nr, gfp_t gfp);
 int mtree_store(struct maple_tree *mt, unsigned long index,
 		void *entry, gfp_t gfp);
 void *mtree_erase(struct maple_tree *mt, unsigned long index);
@@ -3629,6 +3629,8 @@ void vma_set_file(struct vm_area_struct *vma, struct file *file);
 #ifdef CONFIG_NUMA_BALANCING
 unsigned long change_prot_numa(struct vm_area_struct *vma,
 			unsigned long start, unsigned long end);
+unsigned long numa_scan_accessed(struct vm_area_struct *vma,
+			unsigned long start, unsigned long end);
 #endif
 
 struct vm_area_struct *find_extend_vma_locked(struct mm_struct *,
@@ -975,6 +975,13 @@ struct mm_struct {
 		 * allocated for the mm.
 		 */
 		atomic_t max_nr_cid;
+		/**
+		 * @mm_cid_node: Allocate node-local concurrency IDs.
+		 *
+		 * Set with PR_SET_MM_CID_MODE.  Inherited over fork, cleared
+		 * by exec.
+		 */
+		unsigned int mm_cid_node;
 		/**
 		 * @cpus_allowed_lock: Lock protecting mm cpus_allowed.
 		 *
@@ -1068,6 +1075,15 @@ struct mm_struct {
 
 		unsigned long flags; /* Must use atomic bitops to access */
 
+#ifdef CONFIG_MEMBARRIER
+		/**
+		 * @membarrier_seq: IPI round sequence numbers, indexed by the
+		 * private expedited flavor (0, MEMBARRIER_FLAG_SYNC_CORE or
+		 * MEMBARRIER_FLAG_RSEQ).  Odd while a round is in flight.
+		 */
+		unsigned long membarrier_seq[3];
+#endif
+
 #ifdef CONFIG_AIO
 		spinlock_t			ioctx_lock;
 		struct kioctx_table __rcu	*ioctx_table;
@@ -1092,6 +1108,10 @@ struct mm_struct {
 #ifdef CONFIG_MMU_NOTIFIER
 		struct mmu_notifier_subscriptions *notifier_subscriptions;
 #endif
+#ifdef CONFIG_FUTEX
+		/* buckets for private futexes, NULL for the global table */
+		struct futex_private_hash *futex_phash;
+#endif
 #if defined(CONFIG_TRANSPARENT_HUGEPAGE) && !defined(CONFIG_SPLIT_PMD_PTLOCKS)
 		pgtable_t pmd_huge_pte; /* protected by page_table_lock */
 #endif
@@ -1108,6 +1128,9 @@ struct mm_struct {
 
 		/* numa_scan_seq prevents two threads remapping PTEs. */
 		int numa_scan_seq;
+
+		/* How task_numa_work() samples accesses, PR_NUMA_SCAN_*. */
+		int numa_scan_mode;
 #endif
 		/*
 		 * An operation with batched TLB flushing is going on. Anything
@@ -416,6 +416,7 @@ enum lruvec_flags {
 
 struct lruvec;
 struct page_vma_mapped_walk;
+struct seq_file;
 
 #ifdef CONFIG_LRU_GEN
 
@@ -590,6 +591,7 @@ void lru_gen_online_memcg(struct mem_cgroup *memcg);
 void lru_gen_offline_memcg(struct mem_cgroup *memcg);
 void lru_gen_release_memcg(struct mem_cgroup *memcg);
 void lru_gen_soft_reclaim(struct mem_cgroup *memcg, int nid);
+void lru_gen_memcg_show(struct seq_file *m, struct mem_cgroup *memcg);
 
 #else /* !CONFIG_LRU_GEN */
 
@@ -630,6 +632,10 @@ static inline void lru_gen_soft_reclaim(struct mem_cgroup *memcg, int nid)
 {
 }
 
+static inline void lru_gen_memcg_show(struct seq_file *m, struct mem_cgroup *memcg)
+{
+}
+
 #endif /* CONFIG_LRU_GEN */
 
 struct lruvec {
@@ -683,14 +689,21 @@ enum zone_watermarks {
  * One per migratetype for each PAGE_ALLOC_COSTLY_ORDER. Two additional lists
  * are added for THP. One PCP list is used by GPF_MOVABLE, and the other PCP list
  * is used by GFP_UNMOVABLE and GFP_RECLAIMABLE.
+ *
+ * The mTHP orders above PAGE_ALLOC_COSTLY_ORDER up to PCP_MTHP_MAX_ORDER get
+ * two lists each as well, split the same way as the THP ones. They are only
+ * used for the orders enabled in vm.percpu_pagelist_mthp_orders.
  */
 #ifdef CONFIG_TRANSPARENT_HUGEPAGE
 #define NR_PCP_THP 2
+#define PCP_MTHP_MAX_ORDER (PAGE_ALLOC_COSTLY_ORDER + 3)
+#define NR_PCP_MTHP (2 * (PCP_MTHP_MAX_ORDER - PAGE_ALLOC_COSTLY_ORDER))
 #else
 #define NR_PCP_THP 0
+#define NR_PCP_MTHP 0
 #endif
 #define NR_LOWORDER_PCP_LISTS (MIGRATE_PCPTYPES * (PAGE_ALLOC_COSTLY_ORDER + 1))
-#define NR_PCP_LISTS (NR_LOWORDER_PCP_LISTS + NR_PCP_THP)
+#define NR_PCP_LISTS (NR_LOWORDER_PCP_LISTS + NR_PCP_MTHP + NR_PCP_THP)
 
 /*
  * Flags used in pcp->flags field.
@@ -0,0 +1,46 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Bloom filters over directory entry names.
+ *
+ * A filter is a bitmap of 1 << order bits.  Each name sets two bits, both
+ * taken from its full_name_hash(), so a name that was never added tests
+ * negative unless both of its bits happen to be set by other names.  Past
+ * NAME_BLOOM_BITS_PER_NAME bits per name, false positives become frequent
+ * enough that callers should stop trusting negative answers.
+ */
+#ifndef _LINUX_NAME_BLOOM_H
+#define _LINUX_NAME_BLOOM_H
+
+#include <linux/bitops.h>
+#include <linux/hash.h>
+#include <linux/stringhash.h>
+
+#define NAME_BLOOM_BITS_PER_NAME	8
+
+static inline void name_bloom_add(unsigned long *bits, unsigned int order,
+				  const char *name, unsigned int len)
+{
+	u32 hash = full_name_hash(NULL, name, len);
+
+	set_bit(hash & ((1U << order) - 1), bits);
+	set_bit(hash_32(hash, order), bits);
+}
+
+static inline bool name_bloom_test(const unsigned long *bits,
+				   unsigned int order, const char *name,
+				   unsigned int len)
+{
+	u32 hash = full_name_hash(NULL, name, len);
+
+	return test_bit(hash & ((1U << order) - 1), bits) &&
+	       test_bit(hash_32(hash, order), bits);
+}
+
+/* Holding @nr_names, is the filter too full to give useful answers? */
+static inline bool name_bloom_overfull(unsigned int order,
+				       unsigned int nr_names)
+{
+	return nr_names > (1U << order) / NAME_BLOOM_BITS_PER_NAME;
+}
+
+#endif /* _LINUX_NAME_BLOOM_H */
@@ -3343,7 +3343,7 @@ u16 dev_pick_tx_zero(struct net_device *dev, struct sk_buff *skb,
 		     struct net_device *sb_dev);
 
 int __dev_queue_xmit(struct sk_buff *skb, struct net_device *sb_dev);
-int __dev_direct_xmit(struct sk_buff *skb, u16 queue_id);
+int __dev_direct_xmit(struct sk_buff *skb, u16 queue_id, bool more);
 
 static inline int dev_queue_xmit(struct sk_buff *skb)
 {
@@ -3360,7 +3360,7 @@ static inline int dev_direct_xmit(struct sk_buff *skb, u16 queue_id)
 {
 	int ret;
 
-	ret = __dev_direct_xmit(skb, queue_id);
+	ret = __dev_direct_xmit(skb, queue_id, false);
 	if (!dev_xmit_complete(ret))
 		kfree_skb(skb);
 	return ret;
@@ -4109,6 +4109,9 @@ void dev_kfree_skb_any_reason(struct sk_buff *skb, enum skb_drop_reason reason);
  *
  * dev_consume_skb_any(skb) when caller doesn't know its current irq context,
  *  and consumed a packet. Used in place of consume_skb(skb)
+ *
+ * dev_consume_skb_list_any(segs) is dev_consume_skb_any() on a list of
+ *  packets linked through ->next, freeing them in bulk when it can
  */
 static inline void dev_kfree_skb_irq(struct sk_buff *skb)
 {
@@ -4130,6 +4133,8 @@ static inline void dev_consume_skb_any(struct sk_buff *skb)
 	dev_kfree_skb_any_reason(skb, SKB_CONSUMED);
 }
 
+void dev_consume_skb_list_any(struct sk_buff *segs);
+
 u32 bpf_prog_run_generic_xdp(struct sk_buff *skb, struct xdp_buff *xdp,
 			     const struct bpf_prog *xdp_prog);
 void generic_xdp_tx(struct sk_buff *skb, const struct bpf_prog *xdp_prog);
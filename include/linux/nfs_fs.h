@@ -128,6 +128,12 @@ struct nfs_open_dir_context {
 	unsigned int dtsize;
 	bool force_clear;
 	bool eof;
+	/* the READDIR sent ahead of the reader, if any */
+	struct work_struct prefetch_work;
+	struct file *prefetch_file;
+	__u64 prefetch_cookie;
+	unsigned int prefetch_dtsize;
+	bool prefetch_plus;
 	struct rcu_head rcu_head;
 };
 
@@ -14,6 +14,8 @@ enum page_walk_lock {
 	PGWALK_WRLOCK = 1,
 	/* vma is expected to be already write-locked during the walk */
 	PGWALK_WRLOCK_VERIFY = 2,
+	/* vma is expected to be already read-locked, mmap_lock may be unheld */
+	PGWALK_VMA_RDLOCK_VERIFY = 3,
 };
 
 /**
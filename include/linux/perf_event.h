@@ -676,6 +676,7 @@ struct swevent_hlist {
 struct bpf_prog;
 struct perf_cgroup;
 struct perf_buffer;
+struct perf_sample_aggr;
 
 struct pmu_event_list {
 	raw_spinlock_t		lock;
@@ -846,6 +847,7 @@ struct perf_event {
 	u64				(*clock)(void);
 	perf_overflow_handler_t		overflow_handler;
 	void				*overflow_handler_context;
+	struct perf_sample_aggr		*sample_aggr;
 	struct bpf_prog			*prog;
 	u64				bpf_cookie;
 
@@ -1118,6 +1120,8 @@ struct perf_cgroup_info {
 	u64				timestamp;
 	u64				timeoffset;
 	int				active;
+	/* enabled events of this very cgroup on this CPU */
+	int				nr_events;
 };
 
 struct perf_cgroup {
@@ -248,4 +248,5 @@ int ring_buffer_map(struct trace_buffer *buffer, int cpu,
 		    struct vm_area_struct *vma);
 int ring_buffer_unmap(struct trace_buffer *buffer, int cpu);
 int ring_buffer_map_get_reader(struct trace_buffer *buffer, int cpu);
+int ring_buffer_map_get_readers(struct trace_buffer *buffer);
 #endif /* _LINUX_RING_BUFFER_H */
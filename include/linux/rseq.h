@@ -23,6 +23,20 @@ enum rseq_event_mask {
 	RSEQ_EVENT_MIGRATE	= (1U << RSEQ_EVENT_MIGRATE_BIT),
 };
 
+/*
+ * A granted time slice extension lasts until the task schedules, at which
+ * point it is revoked and RSEQ_SLICE_EXT_GRANTED is cleared in user-space
+ * on the next return to it.  No new extension is granted in between.
+ */
+enum rseq_slice_state {
+	RSEQ_SLICE_NONE,
+	RSEQ_SLICE_GRANTED,
+	RSEQ_SLICE_REVOKED,
+};
+
+bool rseq_grant_slice_extension(void);
+bool sched_grant_slice_extension(void);
+
 static inline void rseq_set_notify_resume(struct task_struct *t)
 {
 	if (t->rseq)
@@ -72,12 +86,15 @@ static inline void rseq_fork(struct task_struct *t, unsigned long clone_flags)
 		t->rseq_len = 0;
 		t->rseq_sig = 0;
 		t->rseq_event_mask = 0;
+		t->rseq_slice_ext = 0;
 	} else {
 		t->rseq = current->rseq;
 		t->rseq_len = current->rseq_len;
 		t->rseq_sig = current->rseq_sig;
 		t->rseq_event_mask = current->rseq_event_mask;
+		t->rseq_slice_ext = current->rseq_slice_ext;
 	}
+	t->rseq_slice_state = RSEQ_SLICE_NONE;
 }
 
 static inline void rseq_execve(struct task_struct *t)
@@ -86,6 +103,8 @@ static inline void rseq_execve(struct task_struct *t)
 	t->rseq_len = 0;
 	t->rseq_sig = 0;
 	t->rseq_event_mask = 0;
+	t->rseq_slice_ext = 0;
+	t->rseq_slice_state = RSEQ_SLICE_NONE;
 }
 
 #else
@@ -113,6 +132,10 @@ static inline void rseq_fork(struct task_struct *t, unsigned long clone_flags)
 static inline void rseq_execve(struct task_struct *t)
 {
 }
+static inline bool rseq_grant_slice_extension(void)
+{
+	return false;
+}
 
 #endif
 
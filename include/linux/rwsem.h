@@ -64,20 +64,46 @@ struct rw_semaphore {
 #ifdef CONFIG_DEBUG_LOCK_ALLOC
 	struct lockdep_map	dep_map;
 #endif
+#ifdef CONFIG_RWSEM_PERCPU_READERS
+	/* set by rwsem_enable_percpu_readers() */
+	struct rwsem_pcpu	*pcpu;
+#endif
 };
 
+#ifdef CONFIG_RWSEM_PERCPU_READERS
+extern int rwsem_enable_percpu_readers(struct rw_semaphore *sem);
+extern void rwsem_free_percpu_readers(struct rw_semaphore *sem);
+extern bool rwsem_percpu_readers_held(const struct rw_semaphore *sem);
+#else
+static inline int rwsem_enable_percpu_readers(struct rw_semaphore *sem)
+{
+	return 0;
+}
+
+static inline void rwsem_free_percpu_readers(struct rw_semaphore *sem)
+{
+}
+
+static inline bool rwsem_percpu_readers_held(const struct rw_semaphore *sem)
+{
+	return false;
+}
+#endif
+
 #define RWSEM_UNLOCKED_VALUE		0UL
 #define RWSEM_WRITER_LOCKED		(1UL << 0)
 #define __RWSEM_COUNT_INIT(name)	.count = ATOMIC_LONG_INIT(RWSEM_UNLOCKED_VALUE)
 
 static inline int rwsem_is_locked(struct rw_semaphore *sem)
 {
-	return atomic_long_read(&sem->count) != RWSEM_UNLOCKED_VALUE;
+	return atomic_long_read(&sem->count) != RWSEM_UNLOCKED_VALUE ||
+	       rwsem_percpu_readers_held(sem);
 }
 
 static inline void rwsem_assert_held_nolockdep(const struct rw_semaphore *sem)
 {
-	WARN_ON(atomic_long_read(&sem->count) == RWSEM_UNLOCKED_VALUE);
+	WARN_ON(atomic_long_read(&sem->count) == RWSEM_UNLOCKED_VALUE &&
+		!rwsem_percpu_readers_held(sem));
 }
 
 static inline void rwsem_assert_held_write_nolockdep(const struct rw_semaphore *sem)
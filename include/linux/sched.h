@@ -410,6 +410,13 @@ struct sched_param {
 	int sched_priority;
 };
 
+/*
+ * Run delay histogram: bucket 0 counts waits below 1us, bucket N waits of
+ * [2^(N-1), 2^N) us, and the last one everything longer.
+ */
+#define SCHED_RUN_DELAY_BUCKETS		16
+#define SCHED_RUN_DELAY_SHIFT		10
+
 struct sched_info {
 #ifdef CONFIG_SCHED_INFO
 	/* Cumulative counters: */
@@ -426,6 +433,9 @@ struct sched_info {
 	/* Min time spent waiting on a runqueue: */
 	unsigned long long		min_run_delay;
 
+	/* Distribution of the queued-to-running delays: */
+	unsigned int			run_delay_hist[SCHED_RUN_DELAY_BUCKETS];
+
 	/* Timestamps: */
 
 	/* When did we last run on a CPU? */
@@ -1408,6 +1418,9 @@ struct task_struct {
 	 * with respect to preemption.
 	 */
 	unsigned long rseq_event_mask;
+	/* Time slice extension: enabled by prctl(), enum rseq_slice_state */
+	u8 rseq_slice_ext;
+	u8 rseq_slice_state;
 # ifdef CONFIG_DEBUG_RSEQ
 	/*
 	 * This is a place holder to save a copy of the rseq fields for
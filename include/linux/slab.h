@@ -335,6 +335,22 @@ struct kmem_cache_args {
 	 * %NULL means no constructor.
 	 */
 	void (*ctor)(void *);
+	/**
+	 * @sheaf_capacity: Enable per-cpu sheaves of given capacity.
+	 *
+	 * With a non-zero value, allocations and frees on the local node are
+	 * served from per-cpu arrays (sheaves) of up to this many objects,
+	 * backed by a per-node barn of full and empty sheaves. This trades
+	 * some memory for avoiding most slab freelist operations, and is
+	 * useful for caches with a high rate of allocs and frees, frequently
+	 * on different cpus.
+	 *
+	 * Caches with sheaves are never merged. The value is ignored when
+	 * debugging is enabled for the cache and with CONFIG_SLUB_TINY.
+	 *
+	 * %0 means no sheaves will be created.
+	 */
+	unsigned int sheaf_capacity;
 };
 
 struct kmem_cache *__kmem_cache_create_args(const char *name,
@@ -43,6 +43,9 @@ do {						\
  * flush_smp_call_function_queue() in detail.
  */
 extern void __smp_call_single_queue(int cpu, struct llist_node *node);
+extern void __smp_call_single_queue_mask(int cpu, struct llist_node *node,
+					 struct cpumask *mask);
+extern void smp_send_call_single_mask(struct cpumask *mask);
 
 /* total number of cpus in this system (may exceed NR_CPUS) */
 extern unsigned int total_cpus;
@@ -16,6 +16,7 @@ struct cred;
 struct socket;
 struct sock;
 struct sk_buff;
+struct sk_buff_head;
 struct proto_accept_arg;
 
 #define __sockaddr_check_size(size)	\
@@ -78,6 +79,13 @@ struct msghdr {
 	struct ubuf_info *msg_ubuf;
 	int (*sg_from_iter)(struct sk_buff *skb,
 			    struct iov_iter *from, size_t length);
+	/*
+	 * recvmmsg(): datagrams the protocol dequeued ahead of the entries
+	 * that will receive them, and how many more entries are left after
+	 * this one.  Only valid when MSG_BATCH is passed to ->recvmsg().
+	 */
+	struct sk_buff_head *msg_batch;
+	unsigned int	msg_batch_room;
 };
 
 struct user_msghdr {
@@ -320,7 +328,7 @@ struct ucred {
 #define MSG_MORE	0x8000	/* Sender will send more */
 #define MSG_WAITFORONE	0x10000	/* recvmmsg(): block until 1+ packets avail */
 #define MSG_SENDPAGE_NOPOLICY 0x10000 /* sendpage() internal : do no apply policy */
-#define MSG_BATCH	0x40000 /* sendmmsg(): more messages coming */
+#define MSG_BATCH	0x40000 /* sendmmsg()/recvmmsg(): more messages coming */
 #define MSG_EOF         MSG_FIN
 #define MSG_NO_SHARED_FRAGS 0x80000 /* sendpage() internal : page frags are not shared */
 #define MSG_SENDPAGE_DECRYPTED	0x100000 /* sendpage() internal : page may carry
@@ -104,6 +104,8 @@ struct io_tlb_pool {
  *		in debugfs.
  * @transient_nslabs: The total number of slots in all transient pools that
  *		are currently used across all areas.
+ * @area_contended: The number of times a search skipped an area because
+ *		another CPU held its lock. Used only for reporting in debugfs.
  */
 struct io_tlb_mem {
 	struct io_tlb_pool defpool;
@@ -122,6 +124,7 @@ struct io_tlb_mem {
 	atomic_long_t total_used;
 	atomic_long_t used_hiwater;
 	atomic_long_t transient_nslabs;
+	atomic_long_t area_contended;
 #endif
 };
 
@@ -20,6 +20,7 @@ struct __kernel_old_itimerval;
 struct kexec_segment;
 struct linux_dirent;
 struct linux_dirent64;
+struct linux_dirent_statx;
 struct list_head;
 struct mmap_arg_struct;
 struct msgbuf;
@@ -467,6 +468,10 @@ asmlinkage long sys_quotactl_fd(unsigned int fd, unsigned int cmd, qid_t id,
 asmlinkage long sys_getdents64(unsigned int fd,
 				struct linux_dirent64 __user *dirent,
 				unsigned int count);
+asmlinkage long sys_getdents_statx(unsigned int fd,
+				   struct linux_dirent_statx __user *dirent,
+				   unsigned int count, unsigned int mask,
+				   unsigned int flags);
 asmlinkage long sys_llseek(unsigned int fd, unsigned long offset_high,
 			unsigned long offset_low, loff_t __user *result,
 			unsigned int whence);
@@ -581,6 +586,9 @@ asmlinkage long sys_futex_wait(void __user *uaddr, unsigned long val, unsigned l
 asmlinkage long sys_futex_requeue(struct futex_waitv __user *waiters,
 				  unsigned int flags, int nr_wake, int nr_requeue);
 
+asmlinkage long sys_futex_wakev(struct futex_waitv __user *waiters,
+				unsigned int nr_futexes, unsigned int flags);
+
 asmlinkage long sys_nanosleep(struct __kernel_timespec __user *rqtp,
 			      struct __kernel_timespec __user *rmtp);
 asmlinkage long sys_nanosleep_time32(struct old_timespec32 __user *rqtp,
@@ -165,6 +165,8 @@ extern void add_timer_global(struct timer_list *timer);
 extern int try_to_del_timer_sync(struct timer_list *timer);
 extern int timer_delete_sync(struct timer_list *timer);
 extern int timer_delete(struct timer_list *timer);
+extern unsigned int timer_delete_many(struct timer_list **timers,
+				      unsigned int nr);
 extern int timer_shutdown_sync(struct timer_list *timer);
 extern int timer_shutdown(struct timer_list *timer);
 
@@ -29,6 +29,7 @@ struct net_hotdata {
 #ifdef CONFIG_RPS
 	struct rps_sock_flow_table __rcu *rps_sock_flow_table;
 	u32			rps_cpu_mask;
+	int			rps_balance_backlog;
 #endif
 	int			gro_normal_batch;
 	int			netdev_budget;
@@ -138,6 +138,8 @@ void tcp_time_wait(struct sock *sk, int state, int timeo);
 #define TCP_DELACK_MAX	((unsigned)(HZ/5))	/* maximal time to delay before sending an ACK */
 static_assert((1 << ATO_BITS) > TCP_DELACK_MAX);
 
+#define TCP_ACK_COALESCE_MAX	64	/* max TCP_ACK_COALESCE_SEGS value */
+
 #if HZ >= 100
 #define TCP_DELACK_MIN	((unsigned)(HZ/25))	/* minimal time to delay before sending an ACK */
 #define TCP_ATO_MIN	((unsigned)(HZ/25))
@@ -93,6 +93,8 @@ struct udp_hslot_main {
  *		(local port, local address, remote port, remote address)
  *	@mask:	number of slots in hash tables, minus 1
  *	@log:	log2(number of slots in hash table)
+ *	@lookup_gen: per (local port) slot, bumped whenever a lookup for a
+ *		     port hashing there may return a different socket
  */
 struct udp_table {
 	struct udp_hslot	*hash;
@@ -102,8 +104,29 @@ struct udp_table {
 #endif
 	unsigned int		mask;
 	unsigned int		log;
+	atomic_t		*lookup_gen;
 };
 extern struct udp_table udp_table;
+
+static inline struct udp_table *udp_get_table_prot(struct sock *sk)
+{
+	return sk->sk_prot->h.udp_table ? : sock_net(sk)->ipv4.udp_table;
+}
+
+/*
+ * Hashing, unhashing, rehashing, connecting or disconnecting @sk invalidates
+ * the per-CPU receive lookup cache for packets to its local port.  The
+ * barrier orders the change before the new generation becomes visible.
+ */
+static inline void udp_table_changed(struct udp_table *udptable,
+				     const struct sock *sk)
+{
+	unsigned int slot = udp_hashfn(sock_net(sk), udp_sk(sk)->udp_port_hash,
+				       udptable->mask);
+
+	smp_mb__before_atomic();
+	atomic_inc(&udptable->lookup_gen[slot]);
+}
 void udp_table_init(struct udp_table *, const char *);
 static inline struct udp_hslot *udp_hashslot(struct udp_table *table,
 					     const struct net *net,
@@ -389,6 +412,9 @@ int __udp_enqueue_schedule_skb(struct sock *sk, struct sk_buff *skb);
 void udp_skb_destructor(struct sock *sk, struct sk_buff *skb);
 struct sk_buff *__skb_recv_udp(struct sock *sk, unsigned int flags, int *off,
 			       int *err);
+struct sk_buff *udp_recvmsg_skb(struct sock *sk, struct msghdr *msg,
+				unsigned int flags, int *off, int *err);
+void udp_recvmsg_unbatch(struct sock *sk, struct sk_buff_head *batch);
 static inline struct sk_buff *skb_recv_udp(struct sock *sk, unsigned int flags,
 					   int *err)
 {
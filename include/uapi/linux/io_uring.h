@@ -114,6 +114,11 @@ struct io_uring_sqe {
 
 /* sqe->attr_type_mask flags */
 #define IORING_RW_ATTR_FLAG_PI	(1U << 0)
+/*
+ * Cap the length to the result of the previous request in the link chain.
+ * Carries no attribute data in attr_ptr.
+ */
+#define IORING_RW_ATTR_FLAG_LINK_RES	(1U << 1)
 /* PI attribute information */
 struct io_uring_attr_pi {
 		__u16	flags;
@@ -283,6 +288,7 @@ enum io_uring_op {
 	IORING_OP_EPOLL_WAIT,
 	IORING_OP_READV_FIXED,
 	IORING_OP_WRITEV_FIXED,
+	IORING_OP_FUTEX_WAKEV,
 
 	/* this goes last, obviously */
 	IORING_OP_LAST,
@@ -296,6 +302,16 @@ enum io_uring_op {
 #define IORING_URING_CMD_FIXED	(1U << 0)
 #define IORING_URING_CMD_MASK	IORING_URING_CMD_FIXED
 
+/*
+ * sqe->buf_index for IORING_OP_READV_FIXED and IORING_OP_WRITEV_FIXED
+ *
+ * IORING_FIXED_IOVEC_PER_BUF	sqe->addr points to an array of sqe->len
+ *				struct io_uring_fixed_iovec, each naming its
+ *				own registered buffer instead of all iovecs
+ *				sharing the buffer at sqe->buf_index.
+ */
+#define IORING_FIXED_IOVEC_PER_BUF	0xffffU
+
 
 /*
  * sqe->fsync_flags
@@ -386,12 +402,22 @@ enum io_uring_op {
  *				the starting buffer ID in cqe->flags as per
  *				usual for provided buffer usage. The buffers
  *				will be	contiguous from the starting buffer ID.
+ *				For multishot recv, sqe->len may be set to a
+ *				byte watermark: as long as the socket has data
+ *				queued, buffers keep being appended to the
+ *				same CQE until at least that many bytes have
+ *				been received.
+ *
+ * IORING_SEND_LINK_RES		Only for send, on a request that follows
+ *				another one in a link chain. A non-negative
+ *				result of the previous request caps sqe->len.
  */
 #define IORING_RECVSEND_POLL_FIRST	(1U << 0)
 #define IORING_RECV_MULTISHOT		(1U << 1)
 #define IORING_RECVSEND_FIXED_BUF	(1U << 2)
 #define IORING_SEND_ZC_REPORT_USAGE	(1U << 3)
 #define IORING_RECVSEND_BUNDLE		(1U << 4)
+#define IORING_SEND_LINK_RES		(1U << 5)
 
 /*
  * cqe.res for IORING_CQE_F_NOTIF if
@@ -654,6 +680,9 @@ enum io_uring_register_op {
 
 	IORING_REGISTER_MEM_REGION		= 34,
 
+	/* control and query per-opcode completion latency histograms */
+	IORING_REGISTER_LAT_STATS		= 35,
+
 	/* this goes last */
 	IORING_REGISTER_LAST,
 
@@ -764,6 +793,31 @@ struct io_uring_clock_register {
 	__u32	__resv[3];
 };
 
+/*
+ * Argument for IORING_REGISTER_LAT_STATS. Once enabled, the ring timestamps
+ * requests at submission and accounts their submit to complete latency per
+ * opcode. Bucket 0 counts completions under 2 usecs, bucket N counts
+ * completions in [2^N, 2^(N+1)) usecs, the last bucket is open ended.
+ */
+#define IORING_LAT_NR_BUCKETS	24
+
+enum io_uring_lat_stats_cmd {
+	IORING_LAT_STATS_ENABLE,
+	IORING_LAT_STATS_DISABLE,
+	IORING_LAT_STATS_RESET,
+	/* copy the histogram for ->opcode into ->buckets */
+	IORING_LAT_STATS_GET,
+};
+
+struct io_uring_lat_stats {
+	__u32	cmd;		/* IORING_LAT_STATS_* */
+	__u32	flags;
+	__u32	opcode;		/* IORING_OP_* for IORING_LAT_STATS_GET */
+	__u32	__resv1;
+	__u64	buckets;	/* __u64[IORING_LAT_NR_BUCKETS] */
+	__u64	__resv[2];
+};
+
 enum {
 	IORING_REGISTER_SRC_REGISTERED	= (1U << 0),
 	IORING_REGISTER_DST_REPLACE	= (1U << 1),
@@ -778,6 +832,14 @@ struct io_uring_clone_buffers {
 	__u32	pad[3];
 };
 
+/* iovec for IORING_FIXED_IOVEC_PER_BUF, addr is inside buffer buf_index */
+struct io_uring_fixed_iovec {
+	__u64	addr;
+	__u32	len;
+	__u16	buf_index;
+	__u16	resv;
+};
+
 struct io_uring_buf {
 	__u64	addr;
 	__u32	len;
@@ -817,6 +879,10 @@ struct io_uring_buf_ring {
  *			use of it will consume only as much as it needs. This
  *			requires that both the kernel and application keep
  *			track of where the current read/recv index is at.
+ *			Any opcode using buffer selection can use it, for
+ *			sends the length of the send determines how much of
+ *			the buffer is consumed, with the rest remaining at
+ *			the head for the next send.
  */
 enum io_uring_register_pbuf_ring_flags {
 	IOU_PBUF_RING_MMAP	= 1,
@@ -81,7 +81,10 @@
  *                          overhead. A process needs to register its
  *                          intent to use the private expedited command
  *                          prior to using it, otherwise this command
- *                          returns -EPERM.
+ *                          returns -EPERM. If @flags parameter is
+ *                          MEMBARRIER_CMD_FLAG_CPU, only the thread
+ *                          running on the CPU indicated by @cpu_id is
+ *                          targeted.
  * @MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED:
  *                          Register the process intent to use
  *                          MEMBARRIER_CMD_PRIVATE_EXPEDITED. Always
@@ -107,7 +110,10 @@
  *                          is returned. A process needs to register its
  *                          intent to use the private expedited sync
  *                          core command prior to using it, otherwise
- *                          this command returns -EPERM.
+ *                          this command returns -EPERM. If @flags
+ *                          parameter is MEMBARRIER_CMD_FLAG_CPU, only
+ *                          the thread running on the CPU indicated by
+ *                          @cpu_id is targeted.
  * @MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED_SYNC_CORE:
  *                          Register the process intent to use
  *                          MEMBARRIER_CMD_PRIVATE_EXPEDITED_SYNC_CORE.
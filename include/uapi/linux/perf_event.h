@@ -462,7 +462,8 @@ struct perf_event_attr {
 				inherit_thread :  1, /* children only inherit if cloned with CLONE_THREAD */
 				remove_on_exec :  1, /* event is removed from task on exec */
 				sigtrap        :  1, /* send synchronous SIGTRAP on event */
-				__reserved_1   : 26;
+				aggregate      :  1, /* count samples per callchain */
+				__reserved_1   : 25;
 
 	union {
 		__u32		wakeup_events;	  /* wakeup every n events */
@@ -1228,6 +1229,27 @@ enum perf_event_type {
 	 */
 	PERF_RECORD_AUX_OUTPUT_HW_ID		= 21,
 
+	/*
+	 * Emitted by events with attr.aggregate instead of PERF_RECORD_SAMPLE:
+	 * @count samples of thread @tid had the callchain @ips, and @period is
+	 * the sum of their sample periods, which in frequency mode is what is
+	 * proportional to the number of events.  The counts of
+	 * a callchain are emitted when it is evicted by another one hashing to
+	 * the same slot, at least once a second while the event samples, and
+	 * when the event is disabled.
+	 *
+	 * struct {
+	 *	struct perf_event_header	header;
+	 *	u32				pid, tid;
+	 *	u64				count;
+	 *	u64				period;
+	 *	u64				nr;
+	 *	u64				ips[nr];
+	 *	struct sample_id		sample_id;
+	 * };
+	 */
+	PERF_RECORD_SAMPLE_COUNT		= 22,
+
 	PERF_RECORD_MAX,			/* non-ABI */
 };
 
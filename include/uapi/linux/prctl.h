@@ -270,7 +270,8 @@ struct prctl_mm_map {
 # define PR_SCHED_CORE_CREATE		1 /* create unique core_sched cookie */
 # define PR_SCHED_CORE_SHARE_TO		2 /* push core_sched cookie to pid */
 # define PR_SCHED_CORE_SHARE_FROM	3 /* pull core_sched cookie to pid */
-# define PR_SCHED_CORE_MAX		4
+# define PR_SCHED_CORE_GET_FORCEIDLE	4 /* forced idle ns of pid's cookie */
+# define PR_SCHED_CORE_MAX		5
 # define PR_SCHED_CORE_SCOPE_THREAD		0
 # define PR_SCHED_CORE_SCOPE_THREAD_GROUP	1
 # define PR_SCHED_CORE_SCOPE_PROCESS_GROUP	2
@@ -364,4 +365,28 @@ struct prctl_mm_map {
 # define PR_TIMER_CREATE_RESTORE_IDS_ON		1
 # define PR_TIMER_CREATE_RESTORE_IDS_GET	2
 
+/* Select how NUMA balancing samples the memory accesses of this process */
+#define PR_SET_NUMA_SCAN_MODE		78
+#define PR_GET_NUMA_SCAN_MODE		79
+# define PR_NUMA_SCAN_PROT_NONE		0	/* hinting faults */
+# define PR_NUMA_SCAN_ACCESSED		1	/* page table accessed bits */
+
+/* Allow this thread to request time slice extensions through rseq */
+#define PR_SET_RSEQ_SLICE_EXTENSION	80
+#define PR_GET_RSEQ_SLICE_EXTENSION	81
+
+/* Select how the rseq concurrency IDs (mm_cid) of this process are allocated */
+#define PR_SET_MM_CID_MODE		82
+#define PR_GET_MM_CID_MODE		83
+# define PR_MM_CID_COMPACT		0	/* dense from 0 across the process */
+# define PR_MM_CID_NODE			1	/* taken from the CPU ids of the node */
+
+/*
+ * Hash the private futexes of this process into a table of its own with
+ * the given number of buckets (0 for a default), before any other thread
+ * is created.  PR_GET_FUTEX_HASH returns 0 while the global table is used.
+ */
+#define PR_SET_FUTEX_HASH		84
+#define PR_GET_FUTEX_HASH		85
+
 #endif /* _LINUX_PRCTL_H */
@@ -37,6 +37,16 @@ enum rseq_cs_flags {
 		(1U << RSEQ_CS_FLAG_NO_RESTART_ON_MIGRATE_BIT),
 };
 
+enum rseq_slice_ctrl_bit {
+	RSEQ_SLICE_EXT_REQUEST_BIT	= 0,
+	RSEQ_SLICE_EXT_GRANTED_BIT	= 1,
+};
+
+enum rseq_slice_ctrl {
+	RSEQ_SLICE_EXT_REQUEST	= (1U << RSEQ_SLICE_EXT_REQUEST_BIT),
+	RSEQ_SLICE_EXT_GRANTED	= (1U << RSEQ_SLICE_EXT_GRANTED_BIT),
+};
+
 /*
  * struct rseq_cs is aligned on 4 * 8 bytes to ensure it is always
  * contained within a single cache-line. It is usually declared as
@@ -148,6 +158,24 @@ struct rseq {
 	 */
 	__u32 mm_cid;
 
+	/*
+	 * Restartable sequences slice_ctrl field. Used by threads which
+	 * enabled time slice extensions with PR_SET_RSEQ_SLICE_EXTENSION.
+	 *
+	 * - RSEQ_SLICE_EXT_REQUEST
+	 *     Set by user-space before entering a critical section (e.g.
+	 *     when taking a user-space lock) and cleared by user-space when
+	 *     leaving it. While set, a preemption request which hits the
+	 *     thread on its way back to user-space may be deferred by a
+	 *     short, bounded amount of time.
+	 * - RSEQ_SLICE_EXT_GRANTED
+	 *     Set by the kernel when it deferred a preemption. User-space
+	 *     must then issue sched_yield() as soon as it cleared
+	 *     RSEQ_SLICE_EXT_REQUEST. The kernel clears it again once the
+	 *     thread got scheduled.
+	 */
+	__u32 slice_ctrl;
+
 	/*
 	 * Flexible array member at end of structure, after last feature field.
 	 */
@@ -188,6 +188,26 @@ struct statx {
 	/* 0x100 */
 };
 
+/*
+ * Directory entry returned by getdents_statx().
+ *
+ * The first fields have the meaning they have in getdents64()'s struct
+ * linux_dirent64.  d_stx holds the attributes of the entry itself, as
+ * statx(dirfd, d_name, AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT) would return
+ * them, if d_stx_error is 0.  Otherwise d_stx_error is a negative error
+ * number; -EAGAIN means the caller should use statx() for that entry.
+ */
+struct linux_dirent_statx {
+	__u64	d_ino;
+	__s64	d_off;
+	__u16	d_reclen;
+	__u8	d_type;
+	__u8	__d_pad;
+	__s32	d_stx_error;
+	struct statx d_stx;
+	char	d_name[];
+};
+
 /*
  * Flags to be stx_mask
  *
@@ -34,9 +34,10 @@
  */
 
 
-#define TASKSTATS_VERSION	15
+#define TASKSTATS_VERSION	16
 #define TS_COMM_LEN		32	/* should be >= TASK_COMM_LEN
 					 * in linux/sched.h */
+#define TASKSTATS_CPU_DELAY_BUCKETS	16	/* == SCHED_RUN_DELAY_BUCKETS */
 
 struct taskstats {
 
@@ -219,6 +220,12 @@ struct taskstats {
 	__u64    irq_delay_max;
 	__u64    irq_delay_min;
 	/* v15: add Delay max */
+
+	/* v16: Distribution of the delays waiting for a CPU, bucket 0
+	 * counts waits below 1us, bucket N waits of [2^(N-1), 2^N) us and
+	 * the last bucket everything longer.
+	 */
+	__u64	cpu_delay_hist[TASKSTATS_CPU_DELAY_BUCKETS];
 };
 
 
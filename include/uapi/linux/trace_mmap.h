@@ -44,5 +44,11 @@ struct trace_buffer_meta {
 };
 
 #define TRACE_MMAP_IOCTL_GET_READER		_IO('R', 0x20)
+/*
+ * Same as TRACE_MMAP_IOCTL_GET_READER for every CPU buffer of the instance
+ * that is mapped, whichever CPU's file it is issued on.  Returns the number
+ * of mapped CPU buffers.
+ */
+#define TRACE_MMAP_IOCTL_GET_READERS		_IO('R', 0x21)
 
 #endif /* _TRACE_MMAP_H_ */
@@ -211,6 +211,22 @@
  */
 #define UBLK_F_USER_RECOVERY_FAIL_IO (1ULL << 9)
 
+/*
+ * Auto buffer registration, requires UBLK_F_SUPPORT_ZERO_COPY.
+ *
+ * Before each request is delivered to the ublk server, the driver
+ * registers the request's pages as a fixed buffer in the io_uring
+ * context which issued the FETCH/COMMIT_AND_FETCH command, at the
+ * buffer index passed in `ublksrv_io_cmd.addr` (encoded as
+ * `struct ublk_auto_buf_reg`). The server can then use that index for
+ * fixed-buffer IO directly, without issuing UBLK_U_IO_REGISTER_IO_BUF.
+ *
+ * The buffer is unregistered automatically when the request is committed
+ * by UBLK_U_IO_COMMIT_AND_FETCH_REQ, which therefore has to be issued on
+ * the same io_uring context as the command that fetched the request.
+ */
+#define UBLK_F_AUTO_BUF_REG	(1ULL << 10)
+
 /* device state */
 #define UBLK_S_DEV_DEAD	0
 #define UBLK_S_DEV_LIVE	1
@@ -331,6 +347,39 @@ static inline __u32 ublksrv_get_flags(const struct ublksrv_io_desc *iod)
 	return iod->op_flags >> 8;
 }
 
+/*
+ * Passed in `ublksrv_io_cmd.addr` of FETCH/COMMIT_AND_FETCH commands when
+ * UBLK_F_AUTO_BUF_REG is enabled.
+ */
+struct ublk_auto_buf_reg {
+	/* fixed buffer index the next request's buffer is registered at */
+	__u16	index;
+
+	/* must be zero for now */
+	__u8	flags;
+	__u8	reserved0;
+	__u32	reserved1;
+};
+
+static inline __u64
+ublk_auto_buf_reg_to_addr(const struct ublk_auto_buf_reg *buf)
+{
+	return buf->index | ((__u64)buf->flags << 16) |
+		((__u64)buf->reserved0 << 24) | ((__u64)buf->reserved1 << 32);
+}
+
+static inline struct ublk_auto_buf_reg ublk_addr_to_auto_buf_reg(__u64 addr)
+{
+	struct ublk_auto_buf_reg reg = {
+		.index = (__u16)addr,
+		.flags = (__u8)(addr >> 16),
+		.reserved0 = (__u8)(addr >> 24),
+		.reserved1 = (__u32)(addr >> 32),
+	};
+
+	return reg;
+}
+
 /* issued to ublk driver via /dev/ublkcN */
 struct ublksrv_io_cmd {
 	__u16	q_id;
@@ -352,6 +401,9 @@ struct ublksrv_io_cmd {
 		 * re-used to pass back the allocated LBA for
 		 * UBLK_IO_OP_ZONE_APPEND which actually depends on
 		 * UBLK_F_USER_COPY
+		 *
+		 * With UBLK_F_AUTO_BUF_REG, it carries an encoded
+		 * `struct ublk_auto_buf_reg` instead.
 		 */
 		__u64	addr;
 		__u64	zone_append_lba;
@@ -46,6 +46,7 @@
 #define UFFD_API_IOCTLS				\
 	((__u64)1 << _UFFDIO_REGISTER |		\
 	 (__u64)1 << _UFFDIO_UNREGISTER |	\
+	 (__u64)1 << _UFFDIO_BATCH |		\
 	 (__u64)1 << _UFFDIO_API)
 #define UFFD_API_RANGE_IOCTLS			\
 	((__u64)1 << _UFFDIO_WAKE |		\
@@ -79,6 +80,7 @@
 #define _UFFDIO_WRITEPROTECT		(0x06)
 #define _UFFDIO_CONTINUE		(0x07)
 #define _UFFDIO_POISON			(0x08)
+#define _UFFDIO_BATCH			(0x09)
 #define _UFFDIO_API			(0x3F)
 
 /* userfaultfd ioctl ids */
@@ -103,6 +105,8 @@
 				      struct uffdio_continue)
 #define UFFDIO_POISON		_IOWR(UFFDIO, _UFFDIO_POISON, \
 				      struct uffdio_poison)
+#define UFFDIO_BATCH		_IOWR(UFFDIO, _UFFDIO_BATCH, \
+				      struct uffdio_batch)
 
 /* read() structure */
 struct uffd_msg {
@@ -374,6 +378,26 @@ struct uffdio_move {
 	__s64 move;
 };
 
+struct uffdio_batch {
+	/*
+	 * UFFDIO_COPY or UFFDIO_CONTINUE: "ops" points to an array of
+	 * "nr_ops" struct uffdio_copy or struct uffdio_continue, which
+	 * are processed in order exactly as if each had been passed to
+	 * its own ioctl, including the per-op mode and output field.
+	 */
+	__u64 ioctl;
+	__u64 ops;
+	__u64 nr_ops;
+
+	/*
+	 * "done" is written by the ioctl and must be at the end: the
+	 * copy_from_user will not read the last 8 bytes.  It is the
+	 * number of ops fully completed; the ioctl returns the error of
+	 * the op that stopped the batch, if any.
+	 */
+	__s64 done;
+};
+
 /*
  * Flags for the userfaultfd(2) system call itself.
  */
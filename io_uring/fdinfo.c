@@ -14,6 +14,8 @@
 #include "fdinfo.h"
 #include "cancel.h"
 #include "rsrc.h"
+#include "zcrx.h"
+#include "latency.h"
 
 #ifdef CONFIG_PROC_FS
 static __cold int io_uring_show_cred(struct seq_file *m, unsigned int id,
@@ -237,6 +239,22 @@ __cold void io_uring_show_fdinfo(struct seq_file *m, struct file *file)
 			io_uring_show_cred(m, index, cred);
 	}
 
+	if (has_lock)
+		io_zcrx_show_fdinfo(ctx, m);
+
+	if (has_lock && (ctx->flags & IORING_SETUP_HYBRID_IOPOLL)) {
+		seq_puts(m, "HybridPoll:\n");
+		for (i = 0; i < IO_HYBRID_POLL_SLOTS; i++) {
+			struct io_hybrid_poll_stat *stat = &ctx->hybrid_poll[i];
+
+			if (stat->key)
+				seq_printf(m, "%5u: lat_ns=%llu\n", i, stat->lat_ns);
+		}
+	}
+
+	if (has_lock)
+		io_lat_stats_show_fdinfo(ctx, m);
+
 	seq_puts(m, "PollList:\n");
 	for (i = 0; has_lock && i < (1U << ctx->cancel_table.hash_bits); i++) {
 		struct io_hash_bucket *hb = &ctx->cancel_table.hbs[i];
@@ -280,7 +280,7 @@ static inline bool io_acct_run_queue(struct io_wq_acct *acct)
  * Check head of free list for an available worker. If one isn't available,
  * caller must create one.
  */
-static bool io_acct_activate_free_worker(struct io_wq_acct *acct)
+static bool __io_acct_activate_free_worker(struct io_wq_acct *acct, int node)
 	__must_hold(RCU)
 {
 	struct hlist_nulls_node *n;
@@ -292,6 +292,9 @@ static bool io_acct_activate_free_worker(struct io_wq_acct *acct)
 	 * of exiting, keep trying.
 	 */
 	hlist_nulls_for_each_entry_rcu(worker, n, &acct->free_list, nulls_node) {
+		if (node != NUMA_NO_NODE &&
+		    cpu_to_node(task_cpu(worker->task)) != node)
+			continue;
 		if (!io_worker_get(worker))
 			continue;
 		/*
@@ -307,6 +310,20 @@ static bool io_acct_activate_free_worker(struct io_wq_acct *acct)
 	return false;
 }
 
+static bool io_acct_activate_free_worker(struct io_wq_acct *acct)
+	__must_hold(RCU)
+{
+	/*
+	 * Prefer an idle worker that last ran on the node of the submitter,
+	 * so the work and the data it touches stay local. Fall back to any
+	 * idle worker rather than creating a new one.
+	 */
+	if (num_online_nodes() > 1 &&
+	    __io_acct_activate_free_worker(acct, numa_node_id()))
+		return true;
+	return __io_acct_activate_free_worker(acct, NUMA_NO_NODE);
+}
+
 /*
  * We need a worker. If we find a free one, we're good. If not, and we're
  * below the max number of workers, create one.
@@ -807,7 +824,7 @@ static void create_worker_cont(struct callback_head *cb)
 	clear_bit_unlock(0, &worker->create_state);
 	wq = worker->wq;
 	acct = io_wq_get_acct(worker);
-	tsk = create_io_thread(io_wq_worker, worker, NUMA_NO_NODE);
+	tsk = create_io_thread(io_wq_worker, worker, numa_node_id());
 	if (!IS_ERR(tsk)) {
 		io_init_new_worker(wq, acct, worker, tsk);
 		io_worker_release(worker);
@@ -855,7 +872,7 @@ static bool create_io_worker(struct io_wq *wq, struct io_wq_acct *acct)
 
 	__set_current_state(TASK_RUNNING);
 
-	worker = kzalloc(sizeof(*worker), GFP_KERNEL);
+	worker = kzalloc_node(sizeof(*worker), GFP_KERNEL, numa_node_id());
 	if (!worker) {
 fail:
 		atomic_dec(&acct->nr_running);
@@ -872,7 +889,7 @@ static bool create_io_worker(struct io_wq *wq, struct io_wq_acct *acct)
 	raw_spin_lock_init(&worker->lock);
 	init_completion(&worker->ref_done);
 
-	tsk = create_io_thread(io_wq_worker, worker, NUMA_NO_NODE);
+	tsk = create_io_thread(io_wq_worker, worker, numa_node_id());
 	if (!IS_ERR(tsk)) {
 		io_init_new_worker(wq, acct, worker, tsk);
 	} else if (!io_should_retry_thread(worker, PTR_ERR(tsk))) {
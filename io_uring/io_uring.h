@@ -153,6 +153,16 @@ static inline bool io_is_compat(struct io_ring_ctx *ctx)
 	return IS_ENABLED(CONFIG_COMPAT) && unlikely(ctx->compat);
 }
 
+/* called from ->prep() of opcodes with a ->link_res() handler */
+static inline int io_req_set_link_res(struct io_kiocb *req)
+{
+	/* only makes sense for a request that follows another */
+	if (!req->ctx->submit_state.link.head)
+		return -EINVAL;
+	req->flags |= REQ_F_LINK_RES;
+	return 0;
+}
+
 static inline void io_req_task_work_add(struct io_kiocb *req)
 {
 	__io_req_task_work_add(req, 0);
@@ -201,6 +211,8 @@ static inline bool io_defer_get_uncommited_cqe(struct io_ring_ctx *ctx,
 	return io_get_cqe(ctx, cqe_ret);
 }
 
+void __io_lat_stats_record(struct io_kiocb *req);
+
 static __always_inline bool io_fill_cqe_req(struct io_ring_ctx *ctx,
 					    struct io_kiocb *req)
 {
@@ -221,6 +233,8 @@ static __always_inline bool io_fill_cqe_req(struct io_ring_ctx *ctx,
 		memset(&req->big_cqe, 0, sizeof(req->big_cqe));
 	}
 
+	if (unlikely(req->flags & REQ_F_LAT_STATS))
+		__io_lat_stats_record(req);
 	if (trace_io_uring_complete_enabled())
 		trace_io_uring_complete(req->ctx, req, cqe);
 	return true;
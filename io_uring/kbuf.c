@@ -67,6 +67,19 @@ bool io_kbuf_commit(struct io_kiocb *req,
 	return true;
 }
 
+/*
+ * Commit before the transfer is done, for cases where the buffer can't be
+ * kept reserved until completion. With incremental consumption, the part of
+ * the buffer beyond @len stays at the head for the next user, remember that
+ * so the completion can tell the application it doesn't own it yet.
+ */
+static void io_kbuf_early_commit(struct io_kiocb *req,
+				struct io_buffer_list *bl, int len, int nr)
+{
+	if (!io_kbuf_commit(req, bl, len, nr))
+		req->flags |= REQ_F_BUF_MORE;
+}
+
 static inline struct io_buffer_list *io_buffer_get_list(struct io_ring_ctx *ctx,
 							unsigned int bgid)
 {
@@ -186,7 +199,7 @@ static void __user *io_ring_buffer_select(struct io_kiocb *req, size_t *len,
 		 * the transfer completes (or if we get -EAGAIN and must poll of
 		 * retry).
 		 */
-		io_kbuf_commit(req, bl, *len, 1);
+		io_kbuf_early_commit(req, bl, *len, 1);
 		req->buf_list = NULL;
 	}
 	return ret;
@@ -317,7 +330,7 @@ int io_buffers_select(struct io_kiocb *req, struct buf_sel_arg *arg,
 		 */
 		if (ret > 0) {
 			req->flags |= REQ_F_BUFFERS_COMMIT | REQ_F_BL_NO_RECYCLE;
-			io_kbuf_commit(req, bl, arg->out_len, ret);
+			io_kbuf_early_commit(req, bl, arg->out_len, ret);
 		}
 	} else {
 		ret = io_provided_buffers_select(req, &arg->out_len, bl, arg->iovs);
@@ -374,8 +387,9 @@ unsigned int __io_put_kbufs(struct io_kiocb *req, int len, int nbufs)
 		return ret;
 	}
 
-	if (!__io_put_kbuf_ring(req, len, nbufs))
+	if (!__io_put_kbuf_ring(req, len, nbufs) || req->flags & REQ_F_BUF_MORE)
 		ret |= IORING_CQE_F_BUF_MORE;
+	req->flags &= ~REQ_F_BUF_MORE;
 	return ret;
 }
 
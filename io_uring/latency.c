@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Per-opcode submit to complete latency histograms. Buckets are log2 of
+ * the latency in usecs, kept per-cpu so that the completion side never
+ * has to share a cacheline or take a lock.
+ */
+#include <linux/kernel.h>
+#include <linux/errno.h>
+#include <linux/nospec.h>
+#include <linux/percpu.h>
+#include <linux/seq_file.h>
+#include <linux/io_uring.h>
+
+#include <uapi/linux/io_uring.h>
+
+#include "io_uring.h"
+#include "opdef.h"
+#include "latency.h"
+
+struct io_lat_stats {
+	u64	buckets[IORING_OP_LAST][IORING_LAT_NR_BUCKETS];
+};
+
+static unsigned int io_lat_bucket(u64 ns)
+{
+	u64 us = ns / NSEC_PER_USEC;
+
+	if (!us)
+		return 0;
+	return min_t(unsigned int, ilog2(us), IORING_LAT_NR_BUCKETS - 1);
+}
+
+void __io_lat_stats_record(struct io_kiocb *req)
+{
+	struct io_ring_ctx *ctx = req->ctx;
+	unsigned int bucket;
+
+	bucket = io_lat_bucket(ktime_get_ns() - req->issue_ns);
+	/* count each request once */
+	req->flags &= ~REQ_F_LAT_STATS;
+	this_cpu_inc(ctx->lat_stats->buckets[req->opcode][bucket]);
+}
+
+static void io_lat_stats_sum(struct io_ring_ctx *ctx, unsigned int opcode,
+			     u64 *buckets)
+{
+	int cpu, i;
+
+	memset(buckets, 0, sizeof(u64) * IORING_LAT_NR_BUCKETS);
+	for_each_possible_cpu(cpu) {
+		struct io_lat_stats *stats = per_cpu_ptr(ctx->lat_stats, cpu);
+
+		for (i = 0; i < IORING_LAT_NR_BUCKETS; i++)
+			buckets[i] += stats->buckets[opcode][i];
+	}
+}
+
+static void io_lat_stats_reset(struct io_ring_ctx *ctx)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		memset(per_cpu_ptr(ctx->lat_stats, cpu), 0,
+		       sizeof(struct io_lat_stats));
+}
+
+int io_register_lat_stats(struct io_ring_ctx *ctx, void __user *arg)
+{
+	struct io_uring_lat_stats reg;
+	u64 buckets[IORING_LAT_NR_BUCKETS];
+
+	lockdep_assert_held(&ctx->uring_lock);
+
+	if (copy_from_user(&reg, arg, sizeof(reg)))
+		return -EFAULT;
+	if (reg.flags || reg.__resv1 ||
+	    memchr_inv(&reg.__resv, 0, sizeof(reg.__resv)))
+		return -EINVAL;
+
+	switch (reg.cmd) {
+	case IORING_LAT_STATS_ENABLE:
+		/*
+		 * Completions may be posted without ->uring_lock held, so the
+		 * stats are never freed while the ring is alive, disabling
+		 * only stops new requests from being timestamped.
+		 */
+		if (!ctx->lat_stats) {
+			ctx->lat_stats = alloc_percpu_gfp(struct io_lat_stats,
+							  GFP_KERNEL_ACCOUNT);
+			if (!ctx->lat_stats)
+				return -ENOMEM;
+		}
+		ctx->lat_stats_active = 1;
+		return 0;
+	case IORING_LAT_STATS_DISABLE:
+		ctx->lat_stats_active = 0;
+		return 0;
+	case IORING_LAT_STATS_RESET:
+		if (ctx->lat_stats)
+			io_lat_stats_reset(ctx);
+		return 0;
+	case IORING_LAT_STATS_GET:
+		if (!ctx->lat_stats)
+			return -ENXIO;
+		if (reg.opcode >= IORING_OP_LAST)
+			return -EINVAL;
+		io_lat_stats_sum(ctx, array_index_nospec(reg.opcode, IORING_OP_LAST),
+				 buckets);
+		if (copy_to_user(u64_to_user_ptr(reg.buckets), buckets,
+				 sizeof(buckets)))
+			return -EFAULT;
+		return 0;
+	}
+	return -EINVAL;
+}
+
+void io_lat_stats_free(struct io_ring_ctx *ctx)
+{
+	free_percpu(ctx->lat_stats);
+	ctx->lat_stats = NULL;
+}
+
+void io_lat_stats_show_fdinfo(struct io_ring_ctx *ctx, struct seq_file *m)
+{
+	u64 buckets[IORING_LAT_NR_BUCKETS];
+	unsigned int op;
+	int i;
+
+	if (!ctx->lat_stats)
+		return;
+
+	seq_printf(m, "LatencyStats:\t%s\n",
+		   ctx->lat_stats_active ? "enabled" : "disabled");
+	for (op = 0; op < IORING_OP_LAST; op++) {
+		u64 total = 0;
+
+		io_lat_stats_sum(ctx, op, buckets);
+		for (i = 0; i < IORING_LAT_NR_BUCKETS; i++)
+			total += buckets[i];
+		if (!total)
+			continue;
+
+		seq_printf(m, "  %s:", io_uring_get_opcode(op));
+		for (i = 0; i < IORING_LAT_NR_BUCKETS; i++)
+			if (buckets[i])
+				seq_printf(m, " %lluus=%llu", i ? 1ULL << i : 0,
+					   buckets[i]);
+		seq_putc(m, '\n');
+	}
+}
@@ -0,0 +1,12 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#ifndef IOU_LATENCY_H
+#define IOU_LATENCY_H
+
+#include <linux/io_uring_types.h>
+
+int io_register_lat_stats(struct io_ring_ctx *ctx, void __user *arg);
+void io_lat_stats_free(struct io_ring_ctx *ctx);
+void io_lat_stats_show_fdinfo(struct io_ring_ctx *ctx, struct seq_file *m);
+
+#endif
@@ -3,6 +3,7 @@
 
 #define IORING_MAP_OFF_PARAM_REGION		0x20000000ULL
 #define IORING_MAP_OFF_ZCRX_REGION		0x30000000ULL
+#define IORING_OFF_ZCRX_SHIFT			16
 
 struct page **io_pin_pages(unsigned long ubuf, unsigned long len, int *npages);
 
@@ -77,6 +77,8 @@ struct io_sr_msg {
 	/* initialised and used only by !msg send variants */
 	u16				buf_group;
 	bool				retry;
+	/* multishot bundle recv: keep appending until this many bytes */
+	unsigned			mshot_watermark;
 	void __user			*msg_control;
 	/* used only for send zerocopy */
 	struct io_kiocb 		*notif;
@@ -394,7 +396,8 @@ static int io_sendmsg_setup(struct io_kiocb *req, const struct io_uring_sqe *sqe
 	return io_net_import_vec(req, kmsg, msg.msg_iov, msg.msg_iovlen, ITER_SOURCE);
 }
 
-#define SENDMSG_FLAGS (IORING_RECVSEND_POLL_FIRST | IORING_RECVSEND_BUNDLE)
+#define SENDMSG_FLAGS (IORING_RECVSEND_POLL_FIRST | IORING_RECVSEND_BUNDLE | \
+		       IORING_SEND_LINK_RES)
 
 int io_sendmsg_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 {
@@ -406,6 +409,15 @@ int io_sendmsg_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 	sr->flags = READ_ONCE(sqe->ioprio);
 	if (sr->flags & ~SENDMSG_FLAGS)
 		return -EINVAL;
+	if (sr->flags & IORING_SEND_LINK_RES) {
+		int ret;
+
+		if (req->opcode != IORING_OP_SEND)
+			return -EOPNOTSUPP;
+		ret = io_req_set_link_res(req);
+		if (ret)
+			return ret;
+	}
 	sr->msg_flags = READ_ONCE(sqe->msg_flags) | MSG_NOSIGNAL;
 	if (sr->msg_flags & MSG_DONTWAIT)
 		req->flags |= REQ_F_NOWAIT;
@@ -760,6 +772,7 @@ int io_recvmsg_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 
 	sr->done_io = 0;
 	sr->retry = false;
+	sr->mshot_watermark = 0;
 
 	if (unlikely(sqe->file_index || sqe->addr2))
 		return -EINVAL;
@@ -769,7 +782,8 @@ int io_recvmsg_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 	sr->flags = READ_ONCE(sqe->ioprio);
 	if (sr->flags & ~RECVMSG_FLAGS)
 		return -EINVAL;
-	sr->msg_flags = READ_ONCE(sqe->msg_flags);
+	/* MSG_BATCH is internal to recvmmsg() on the receive side */
+	sr->msg_flags = READ_ONCE(sqe->msg_flags) & ~MSG_BATCH;
 	if (sr->msg_flags & MSG_DONTWAIT)
 		req->flags |= REQ_F_NOWAIT;
 	if (sr->msg_flags & MSG_ERRQUEUE)
@@ -791,8 +805,13 @@ int io_recvmsg_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 			return -EINVAL;
 		if (sr->msg_flags & MSG_WAITALL)
 			return -EINVAL;
-		if (req->opcode == IORING_OP_RECV && sr->len)
-			return -EINVAL;
+		if (req->opcode == IORING_OP_RECV && sr->len) {
+			/* for bundles, len is the per-CQE byte watermark */
+			if (!(sr->flags & IORING_RECVSEND_BUNDLE))
+				return -EINVAL;
+			sr->mshot_watermark = sr->len;
+			sr->len = 0;
+		}
 		req->flags |= REQ_F_APOLL_MULTISHOT;
 	}
 	if (sr->flags & IORING_RECVSEND_BUNDLE) {
@@ -810,6 +829,22 @@ int io_recvmsg_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 /* bits to clear in old and inherit in new cflags on bundle retry */
 #define CQE_F_MASK	(IORING_CQE_F_SOCK_NONEMPTY|IORING_CQE_F_MORE)
 
+/*
+ * Should a bundle receive that got @ret bytes so far append more data to
+ * the same CQE? Without a watermark, a bundle is retried once if the
+ * socket has more data queued. With a watermark, keep appending buffers
+ * while data is immediately available and the watermark isn't reached.
+ */
+static bool io_recv_bundle_retry(struct io_sr_msg *sr,
+				 struct io_async_msghdr *kmsg, int ret)
+{
+	if (kmsg->msg.msg_inq <= 0 || ret <= 0)
+		return false;
+	if (sr->mshot_watermark)
+		return ret < sr->mshot_watermark;
+	return !sr->retry;
+}
+
 /*
  * Finishes io_recv and io_recvmsg.
  *
@@ -827,18 +862,22 @@ static inline bool io_recv_finish(struct io_kiocb *req, int *ret,
 		cflags |= IORING_CQE_F_SOCK_NONEMPTY;
 
 	if (sr->flags & IORING_RECVSEND_BUNDLE) {
-		cflags |= io_put_kbufs(req, *ret, io_bundle_nbufs(kmsg, *ret),
-				      issue_flags);
+		size_t this_ret = *ret - sr->done_io;
+
+		cflags |= io_put_kbufs(req, this_ret,
+				       io_bundle_nbufs(kmsg, this_ret),
+				       issue_flags);
 		if (sr->retry)
 			cflags = req->cqe.flags | (cflags & CQE_F_MASK);
 		/* bundle with no more immediate buffers, we're done */
 		if (req->flags & REQ_F_BL_EMPTY)
 			goto finish;
 		/* if more is available, retry and append to this one */
-		if (!sr->retry && kmsg->msg.msg_inq > 0 && *ret > 0) {
-			req->cqe.flags = cflags & ~CQE_F_MASK;
+		if (io_recv_bundle_retry(sr, kmsg, *ret)) {
+			if (!sr->retry)
+				req->cqe.flags = cflags & ~CQE_F_MASK;
 			sr->len = kmsg->msg.msg_inq;
-			sr->done_io += *ret;
+			sr->done_io = *ret;
 			sr->retry = true;
 			return false;
 		}
@@ -1196,9 +1235,7 @@ int io_recvzc_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 		return -EINVAL;
 
 	ifq_idx = READ_ONCE(sqe->zcrx_ifq_idx);
-	if (ifq_idx != 0)
-		return -EINVAL;
-	zc->ifq = req->ctx->ifq;
+	zc->ifq = xa_load(&req->ctx->zcrx_ctxs, ifq_idx);
 	if (!zc->ifq)
 		return -EINVAL;
 	zc->len = READ_ONCE(sqe->len);
@@ -1556,6 +1593,20 @@ void io_sendrecv_fail(struct io_kiocb *req)
 		req->cqe.flags |= IORING_CQE_F_MORE;
 }
 
+void io_send_link_res(struct io_kiocb *req, int res)
+{
+	struct io_sr_msg *sr = io_kiocb_to_cmd(req, struct io_sr_msg);
+	struct io_async_msghdr *kmsg = req->async_data;
+
+	if (res >= sr->len)
+		return;
+	sr->len = res;
+	/* see io_send_setup(), only plain buffers are imported at prep time */
+	if (!(sr->flags & IORING_RECVSEND_FIXED_BUF) &&
+	    !(req->flags & REQ_F_BUFFER_SELECT))
+		iov_iter_truncate(&kmsg->msg.msg_iter, res);
+}
+
 #define ACCEPT_FLAGS	(IORING_ACCEPT_MULTISHOT | IORING_ACCEPT_DONTWAIT | \
 			 IORING_ACCEPT_POLL_FIRST)
 
@@ -38,6 +38,7 @@ int io_recvmsg(struct io_kiocb *req, unsigned int issue_flags);
 int io_recv(struct io_kiocb *req, unsigned int issue_flags);
 
 void io_sendrecv_fail(struct io_kiocb *req);
+void io_send_link_res(struct io_kiocb *req, int res);
 
 int io_accept_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe);
 int io_accept(struct io_kiocb *req, unsigned int issue_flags);
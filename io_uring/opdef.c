@@ -569,6 +569,14 @@ const struct io_issue_def io_issue_defs[] = {
 		.prep			= io_prep_writev_fixed,
 		.issue			= io_write,
 	},
+	[IORING_OP_FUTEX_WAKEV] = {
+#if defined(CONFIG_FUTEX)
+		.prep			= io_futexv_wake_prep,
+		.issue			= io_futexv_wake,
+#else
+		.prep			= io_eopnotsupp_prep,
+#endif
+	},
 };
 
 const struct io_cold_def io_cold_defs[] = {
@@ -592,11 +600,13 @@ const struct io_cold_def io_cold_defs[] = {
 		.name			= "READ_FIXED",
 		.cleanup		= io_readv_writev_cleanup,
 		.fail			= io_rw_fail,
+		.link_res		= io_rw_link_res,
 	},
 	[IORING_OP_WRITE_FIXED] = {
 		.name			= "WRITE_FIXED",
 		.cleanup		= io_readv_writev_cleanup,
 		.fail			= io_rw_fail,
+		.link_res		= io_rw_link_res,
 	},
 	[IORING_OP_POLL_ADD] = {
 		.name			= "POLL_ADD",
@@ -660,11 +670,13 @@ const struct io_cold_def io_cold_defs[] = {
 		.name			= "READ",
 		.cleanup		= io_readv_writev_cleanup,
 		.fail			= io_rw_fail,
+		.link_res		= io_rw_link_res,
 	},
 	[IORING_OP_WRITE] = {
 		.name			= "WRITE",
 		.cleanup		= io_readv_writev_cleanup,
 		.fail			= io_rw_fail,
+		.link_res		= io_rw_link_res,
 	},
 	[IORING_OP_FADVISE] = {
 		.name			= "FADVISE",
@@ -677,6 +689,7 @@ const struct io_cold_def io_cold_defs[] = {
 #if defined(CONFIG_NET)
 		.cleanup		= io_sendmsg_recvmsg_cleanup,
 		.fail			= io_sendrecv_fail,
+		.link_res		= io_send_link_res,
 #endif
 	},
 	[IORING_OP_RECV] = {
@@ -815,6 +828,9 @@ const struct io_cold_def io_cold_defs[] = {
 		.cleanup		= io_readv_writev_cleanup,
 		.fail			= io_rw_fail,
 	},
+	[IORING_OP_FUTEX_WAKEV] = {
+		.name			= "FUTEX_WAKEV",
+	},
 };
 
 const char *io_uring_get_opcode(u8 opcode)
@@ -40,6 +40,8 @@ struct io_cold_def {
 
 	void (*cleanup)(struct io_kiocb *);
 	void (*fail)(struct io_kiocb *);
+	/* cap length to the result of the previous linked request */
+	void (*link_res)(struct io_kiocb *, int res);
 };
 
 extern const struct io_issue_def io_issue_defs[];
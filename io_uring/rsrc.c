@@ -1317,14 +1317,44 @@ int io_vec_realloc(struct iou_vec *iv, unsigned nr_entries)
 	return 0;
 }
 
-static int io_vec_fill_bvec(int ddir, struct iov_iter *iter,
+static int io_vec_fill_bvec_one(struct bio_vec *res_bvec, unsigned *bvec_idx,
 				struct io_mapped_ubuf *imu,
-				struct iovec *iovec, unsigned nr_iovs,
-				struct iou_vec *vec)
+				u64 buf_addr, size_t iov_len)
 {
 	unsigned long folio_size = 1 << imu->folio_shift;
 	unsigned long folio_mask = folio_size - 1;
 	u64 folio_addr = imu->ubuf & ~folio_mask;
+	struct bio_vec *src_bvec;
+	size_t offset;
+	int ret;
+
+	ret = validate_fixed_range(buf_addr, iov_len, imu);
+	if (unlikely(ret))
+		return ret;
+	if (unlikely(!iov_len))
+		return -EFAULT;
+
+	/* by using folio address it also accounts for bvec offset */
+	offset = buf_addr - folio_addr;
+	src_bvec = imu->bvec + (offset >> imu->folio_shift);
+	offset &= folio_mask;
+
+	for (; iov_len; offset = 0, (*bvec_idx)++, src_bvec++) {
+		size_t seg_size = min_t(size_t, iov_len,
+					folio_size - offset);
+
+		bvec_set_page(&res_bvec[*bvec_idx],
+			      src_bvec->bv_page, seg_size, offset);
+		iov_len -= seg_size;
+	}
+	return 0;
+}
+
+static int io_vec_fill_bvec(int ddir, struct iov_iter *iter,
+				struct io_mapped_ubuf *imu,
+				struct iovec *iovec, unsigned nr_iovs,
+				struct iou_vec *vec)
+{
 	struct bio_vec *res_bvec = vec->bvec;
 	size_t total_len = 0;
 	unsigned bvec_idx = 0;
@@ -1333,32 +1363,14 @@ static int io_vec_fill_bvec(int ddir, struct iov_iter *iter,
 	for (iov_idx = 0; iov_idx < nr_iovs; iov_idx++) {
 		size_t iov_len = iovec[iov_idx].iov_len;
 		u64 buf_addr = (u64)(uintptr_t)iovec[iov_idx].iov_base;
-		struct bio_vec *src_bvec;
-		size_t offset;
 		int ret;
 
-		ret = validate_fixed_range(buf_addr, iov_len, imu);
+		ret = io_vec_fill_bvec_one(res_bvec, &bvec_idx, imu,
+					   buf_addr, iov_len);
 		if (unlikely(ret))
 			return ret;
-
-		if (unlikely(!iov_len))
-			return -EFAULT;
 		if (unlikely(check_add_overflow(total_len, iov_len, &total_len)))
 			return -EOVERFLOW;
-
-		/* by using folio address it also accounts for bvec offset */
-		offset = buf_addr - folio_addr;
-		src_bvec = imu->bvec + (offset >> imu->folio_shift);
-		offset &= folio_mask;
-
-		for (; iov_len; offset = 0, bvec_idx++, src_bvec++) {
-			size_t seg_size = min_t(size_t, iov_len,
-						folio_size - offset);
-
-			bvec_set_page(&res_bvec[bvec_idx],
-				      src_bvec->bv_page, seg_size, offset);
-			iov_len -= seg_size;
-		}
 	}
 	if (total_len > MAX_RW_COUNT)
 		return -EINVAL;
@@ -1455,6 +1467,44 @@ static int io_kern_bvec_size(struct iovec *iov, unsigned nr_iovs,
 	return 0;
 }
 
+/*
+ * Make sure @vec can hold @nr_segs bvecs in front of the @nr_iovs iovecs
+ * that are kept at its tail, reallocating and moving the iovecs if needed.
+ */
+static int io_vec_reserve_bvecs(struct io_kiocb *req, struct iou_vec *vec,
+				struct iovec **iovp, unsigned nr_iovs,
+				unsigned nr_segs)
+{
+	struct iovec *iov = *iovp;
+	unsigned iovec_off;
+
+	if (sizeof(struct bio_vec) > sizeof(struct iovec)) {
+		size_t bvec_bytes;
+
+		bvec_bytes = nr_segs * sizeof(struct bio_vec);
+		nr_segs = (bvec_bytes + sizeof(*iov) - 1) / sizeof(*iov);
+		nr_segs += nr_iovs;
+	}
+
+	if (nr_segs > vec->nr) {
+		struct iou_vec tmp_vec = {};
+		int ret;
+
+		ret = io_vec_realloc(&tmp_vec, nr_segs);
+		if (ret)
+			return ret;
+
+		iovec_off = tmp_vec.nr - nr_iovs;
+		memcpy(tmp_vec.iovec + iovec_off, iov, sizeof(*iov) * nr_iovs);
+		io_vec_free(vec);
+
+		*vec = tmp_vec;
+		*iovp = vec->iovec + iovec_off;
+		req->flags |= REQ_F_NEED_CLEANUP;
+	}
+	return 0;
+}
+
 int io_import_reg_vec(int ddir, struct iov_iter *iter,
 			struct io_kiocb *req, struct iou_vec *vec,
 			unsigned nr_iovs, unsigned issue_flags)
@@ -1464,6 +1514,7 @@ int io_import_reg_vec(int ddir, struct iov_iter *iter,
 	unsigned iovec_off;
 	struct iovec *iov;
 	unsigned nr_segs;
+	int ret;
 
 	node = io_find_buf_node(req, issue_flags);
 	if (!node)
@@ -1476,43 +1527,67 @@ int io_import_reg_vec(int ddir, struct iov_iter *iter,
 	iov = vec->iovec + iovec_off;
 
 	if (imu->is_kbuf) {
-		int ret = io_kern_bvec_size(iov, nr_iovs, imu, &nr_segs);
-
+		ret = io_kern_bvec_size(iov, nr_iovs, imu, &nr_segs);
 		if (unlikely(ret))
 			return ret;
 	} else {
 		nr_segs = io_estimate_bvec_size(iov, nr_iovs, imu);
 	}
 
-	if (sizeof(struct bio_vec) > sizeof(struct iovec)) {
-		size_t bvec_bytes;
+	ret = io_vec_reserve_bvecs(req, vec, &iov, nr_iovs, nr_segs);
+	if (unlikely(ret))
+		return ret;
 
-		bvec_bytes = nr_segs * sizeof(struct bio_vec);
-		nr_segs = (bvec_bytes + sizeof(*iov) - 1) / sizeof(*iov);
-		nr_segs += nr_iovs;
-	}
+	if (imu->is_kbuf)
+		return io_vec_fill_kern_bvec(ddir, iter, imu, iov, nr_iovs, vec);
 
-	if (nr_segs > vec->nr) {
-		struct iou_vec tmp_vec = {};
-		int ret;
+	return io_vec_fill_bvec(ddir, iter, imu, iov, nr_iovs, vec);
+}
 
-		ret = io_vec_realloc(&tmp_vec, nr_segs);
-		if (ret)
-			return ret;
+/*
+ * Import a vector prepared by io_prep_reg_iovec_nodes(), where every iovec
+ * carries its own registered buffer in @nodes.
+ */
+int io_import_reg_vec_nodes(int ddir, struct iov_iter *iter,
+			    struct io_kiocb *req, struct iou_vec *vec,
+			    struct io_rsrc_node **nodes, unsigned nr_iovs)
+{
+	unsigned iovec_off = vec->nr - nr_iovs;
+	struct iovec *iov = vec->iovec + iovec_off;
+	size_t total_len = 0;
+	unsigned bvec_idx = 0;
+	unsigned nr_segs = 0;
+	unsigned i;
+	int ret;
 
-		iovec_off = tmp_vec.nr - nr_iovs;
-		memcpy(tmp_vec.iovec + iovec_off, iov, sizeof(*iov) * nr_iovs);
-		io_vec_free(vec);
+	for (i = 0; i < nr_iovs; i++) {
+		struct io_mapped_ubuf *imu = nodes[i]->buf;
 
-		*vec = tmp_vec;
-		iov = vec->iovec + iovec_off;
-		req->flags |= REQ_F_NEED_CLEANUP;
+		if (!(imu->dir & (1 << ddir)))
+			return -EFAULT;
+		nr_segs += io_estimate_bvec_size(&iov[i], 1, imu);
 	}
 
-	if (imu->is_kbuf)
-		return io_vec_fill_kern_bvec(ddir, iter, imu, iov, nr_iovs, vec);
+	ret = io_vec_reserve_bvecs(req, vec, &iov, nr_iovs, nr_segs);
+	if (unlikely(ret))
+		return ret;
 
-	return io_vec_fill_bvec(ddir, iter, imu, iov, nr_iovs, vec);
+	for (i = 0; i < nr_iovs; i++) {
+		size_t iov_len = iov[i].iov_len;
+
+		ret = io_vec_fill_bvec_one(vec->bvec, &bvec_idx, nodes[i]->buf,
+					   (u64)(uintptr_t)iov[i].iov_base,
+					   iov_len);
+		if (unlikely(ret))
+			return ret;
+		if (unlikely(check_add_overflow(total_len, iov_len, &total_len)))
+			return -EOVERFLOW;
+	}
+	if (total_len > MAX_RW_COUNT)
+		return -EINVAL;
+
+	iov_iter_bvec(iter, ddir, vec->bvec, bvec_idx, total_len);
+	return 0;
 }
 
 int io_prep_reg_iovec(struct io_kiocb *req, struct iou_vec *iv,
@@ -1540,3 +1615,74 @@ int io_prep_reg_iovec(struct io_kiocb *req, struct iou_vec *iv,
 	req->flags |= REQ_F_IMPORT_BUFFER;
 	return 0;
 }
+
+/*
+ * Prepare a vector of struct io_uring_fixed_iovec, where each entry names
+ * its own registered buffer. The buffer nodes are looked up and pinned
+ * here, the caller drops them with io_put_reg_iovec_nodes().
+ */
+int io_prep_reg_iovec_nodes(struct io_kiocb *req, struct iou_vec *iv,
+			    struct io_rsrc_node ***nodesp,
+			    const struct io_uring_fixed_iovec __user *uvec,
+			    unsigned nr_iovs)
+{
+	struct io_ring_ctx *ctx = req->ctx;
+	struct io_rsrc_node **nodes;
+	struct iovec *iov;
+	unsigned i;
+	int ret;
+
+	lockdep_assert_held(&ctx->uring_lock);
+
+	if (!nr_iovs || nr_iovs > UIO_MAXIOV)
+		return -EINVAL;
+	if (nr_iovs > iv->nr) {
+		ret = io_vec_realloc(iv, nr_iovs);
+		if (ret)
+			return ret;
+		req->flags |= REQ_F_NEED_CLEANUP;
+	}
+	nodes = kmalloc_array(nr_iovs, sizeof(*nodes), GFP_KERNEL);
+	if (!nodes)
+		return -ENOMEM;
+	*nodesp = nodes;
+	req->flags |= REQ_F_NEED_CLEANUP;
+
+	/* pad iovec to the right, same as io_prep_reg_iovec() */
+	iov = iv->iovec + iv->nr - nr_iovs;
+	for (i = 0; i < nr_iovs; i++) {
+		struct io_uring_fixed_iovec fiov;
+		struct io_rsrc_node *node;
+
+		nodes[i] = NULL;
+		if (copy_from_user(&fiov, &uvec[i], sizeof(fiov)))
+			return -EFAULT;
+		if (fiov.resv)
+			return -EINVAL;
+		node = io_rsrc_node_lookup(&ctx->buf_table, fiov.buf_index);
+		if (!node)
+			return -EFAULT;
+		/* kernel registered buffers are addressed by offset, not yet supported */
+		if (node->buf->is_kbuf)
+			return -EOPNOTSUPP;
+		io_req_assign_rsrc_node(&nodes[i], node);
+
+		iov[i].iov_base = u64_to_user_ptr(fiov.addr);
+		iov[i].iov_len = fiov.len;
+	}
+
+	req->flags |= REQ_F_IMPORT_BUFFER;
+	return 0;
+}
+
+void io_put_reg_iovec_nodes(struct io_ring_ctx *ctx,
+			    struct io_rsrc_node **nodes, unsigned nr_iovs)
+{
+	unsigned i;
+
+	lockdep_assert_held(&ctx->uring_lock);
+
+	for (i = 0; i < nr_iovs && nodes[i]; i++)
+		io_put_rsrc_node(ctx, nodes[i]);
+	kfree(nodes);
+}
@@ -68,6 +68,15 @@ int io_import_reg_vec(int ddir, struct iov_iter *iter,
 			unsigned nr_iovs, unsigned issue_flags);
 int io_prep_reg_iovec(struct io_kiocb *req, struct iou_vec *iv,
 			const struct iovec __user *uvec, size_t uvec_segs);
+int io_import_reg_vec_nodes(int ddir, struct iov_iter *iter,
+			    struct io_kiocb *req, struct iou_vec *vec,
+			    struct io_rsrc_node **nodes, unsigned nr_iovs);
+int io_prep_reg_iovec_nodes(struct io_kiocb *req, struct iou_vec *iv,
+			    struct io_rsrc_node ***nodesp,
+			    const struct io_uring_fixed_iovec __user *uvec,
+			    unsigned nr_iovs);
+void io_put_reg_iovec_nodes(struct io_ring_ctx *ctx,
+			    struct io_rsrc_node **nodes, unsigned nr_iovs);
 
 int io_register_clone_buffers(struct io_ring_ctx *ctx, void __user *arg);
 int io_sqe_buffers_unregister(struct io_ring_ctx *ctx);
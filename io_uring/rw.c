@@ -9,6 +9,7 @@
 #include <linux/fsnotify.h>
 #include <linux/poll.h>
 #include <linux/nospec.h>
+#include <linux/hash.h>
 #include <linux/compat.h>
 #include <linux/io_uring/cmd.h>
 #include <linux/indirect_call_wrapper.h>
@@ -149,6 +150,13 @@ static void io_rw_recycle(struct io_kiocb *req, unsigned int issue_flags)
 	if (unlikely(issue_flags & IO_URING_F_UNLOCKED))
 		return;
 
+	if (rw->buf_nodes) {
+		io_put_reg_iovec_nodes(req->ctx, rw->buf_nodes,
+				       rw->nr_buf_nodes);
+		rw->buf_nodes = NULL;
+		rw->nr_buf_nodes = 0;
+	}
+
 	io_alloc_cache_vec_kasan(&rw->vec);
 	if (rw->vec.nr > IO_VEC_CACHE_SOFT_CAP)
 		io_vec_free(&rw->vec);
@@ -205,6 +213,8 @@ static int io_rw_alloc_async(struct io_kiocb *req)
 	if (rw->vec.iovec)
 		req->flags |= REQ_F_NEED_CLEANUP;
 	rw->bytes_done = 0;
+	rw->buf_nodes = NULL;
+	rw->nr_buf_nodes = 0;
 	return 0;
 }
 
@@ -287,6 +297,15 @@ static int __io_prep_rw(struct io_kiocb *req, const struct io_uring_sqe *sqe,
 	rw->flags = READ_ONCE(sqe->rw_flags);
 
 	attr_type_mask = READ_ONCE(sqe->attr_type_mask);
+	if (attr_type_mask & IORING_RW_ATTR_FLAG_LINK_RES) {
+		if (!io_cold_defs[req->opcode].link_res)
+			return -EOPNOTSUPP;
+		ret = io_req_set_link_res(req);
+		if (ret)
+			return ret;
+		/* has no data in attr_ptr */
+		attr_type_mask &= ~IORING_RW_ATTR_FLAG_LINK_RES;
+	}
 	if (attr_type_mask) {
 		u64 attr_ptr;
 
@@ -392,8 +411,12 @@ static int io_rw_import_reg_vec(struct io_kiocb *req,
 	unsigned uvec_segs = rw->len;
 	int ret;
 
-	ret = io_import_reg_vec(ddir, &io->iter, req, &io->vec,
-				uvec_segs, issue_flags);
+	if (io->buf_nodes)
+		ret = io_import_reg_vec_nodes(ddir, &io->iter, req, &io->vec,
+					      io->buf_nodes, uvec_segs);
+	else
+		ret = io_import_reg_vec(ddir, &io->iter, req, &io->vec,
+					uvec_segs, issue_flags);
 	if (unlikely(ret))
 		return ret;
 	iov_iter_save_state(&io->iter, &io->iter_state);
@@ -407,6 +430,13 @@ static int io_rw_prep_reg_vec(struct io_kiocb *req)
 	struct io_async_rw *io = req->async_data;
 	const struct iovec __user *uvec;
 
+	if (req->buf_index == IORING_FIXED_IOVEC_PER_BUF) {
+		io->nr_buf_nodes = rw->len;
+		return io_prep_reg_iovec_nodes(req, &io->vec, &io->buf_nodes,
+					       u64_to_user_ptr(rw->addr),
+					       rw->len);
+	}
+
 	uvec = u64_to_user_ptr(rw->addr);
 	return io_prep_reg_iovec(req, &io->vec, uvec, rw->len);
 }
@@ -1231,6 +1261,25 @@ void io_rw_fail(struct io_kiocb *req)
 	io_req_set_res(req, res, req->cqe.flags);
 }
 
+void io_rw_link_res(struct io_kiocb *req, int res)
+{
+	struct io_rw *rw = io_kiocb_to_cmd(req, struct io_rw);
+	struct io_async_rw *io = req->async_data;
+
+	if (res >= rw->len)
+		return;
+	rw->len = res;
+	/*
+	 * Fixed and provided buffers are imported at issue time from
+	 * ->len, plain buffers have already been imported at prep time.
+	 */
+	if (!(req->flags & REQ_F_BUFFER_SELECT) &&
+	    (req->opcode == IORING_OP_READ || req->opcode == IORING_OP_WRITE)) {
+		iov_iter_truncate(&io->iter, res);
+		iov_iter_save_state(&io->iter, &io->iter_state);
+	}
+}
+
 static int io_uring_classic_poll(struct io_kiocb *req, struct io_comp_batch *iob,
 				unsigned int poll_flags)
 {
@@ -1248,21 +1297,55 @@ static int io_uring_classic_poll(struct io_kiocb *req, struct io_comp_batch *iob
 	}
 }
 
-static u64 io_hybrid_iopoll_delay(struct io_ring_ctx *ctx, struct io_kiocb *req)
+/*
+ * Completion times are tracked per device, a ring may well be polling a mix
+ * of devices with very different latencies. For block device files that's
+ * the device itself, for files on a filesystem the superblock.
+ */
+static struct io_hybrid_poll_stat *io_hybrid_poll_stat(struct io_ring_ctx *ctx,
+							struct io_kiocb *req)
+{
+	struct inode *inode = file_inode(req->file);
+	struct io_hybrid_poll_stat *stat;
+	const void *key;
+
+	if (S_ISBLK(inode->i_mode))
+		key = req->file->f_mapping->host;
+	else
+		key = inode->i_sb;
+
+	stat = &ctx->hybrid_poll[hash_ptr(key, IO_HYBRID_POLL_BITS)];
+	if (stat->key != key) {
+		stat->key = key;
+		stat->lat_ns = 0;
+	}
+	return stat;
+}
+
+static u64 io_hybrid_iopoll_delay(struct io_kiocb *req,
+				  struct io_hybrid_poll_stat *stat)
 {
 	struct hrtimer_sleeper timer;
 	enum hrtimer_mode mode;
+	u64 sleep_time, elapsed;
 	ktime_t kt;
-	u64 sleep_time;
 
 	if (req->flags & REQ_F_IOPOLL_STATE)
 		return 0;
 
-	if (ctx->hybrid_poll_time == LLONG_MAX)
+	/* nothing learned yet for this device, just poll */
+	if (!stat->lat_ns)
 		return 0;
 
-	/* Using half the running time to do schedule */
-	sleep_time = ctx->hybrid_poll_time / 2;
+	/*
+	 * Sleep until half of the predicted completion time has passed since
+	 * issue, accounting for the time the request already spent waiting
+	 * to be polled.
+	 */
+	elapsed = ktime_get_ns() - req->iopoll_start;
+	if (elapsed >= stat->lat_ns / 2)
+		return 0;
+	sleep_time = stat->lat_ns / 2 - elapsed;
 
 	kt = ktime_set(0, sleep_time);
 	req->flags |= REQ_F_IOPOLL_STATE;
@@ -1285,21 +1368,25 @@ static u64 io_hybrid_iopoll_delay(struct io_ring_ctx *ctx, struct io_kiocb *req)
 static int io_uring_hybrid_poll(struct io_kiocb *req,
 				struct io_comp_batch *iob, unsigned int poll_flags)
 {
-	struct io_ring_ctx *ctx = req->ctx;
-	u64 runtime, sleep_time;
+	struct io_hybrid_poll_stat *stat = io_hybrid_poll_stat(req->ctx, req);
+	u64 lat;
 	int ret;
 
-	sleep_time = io_hybrid_iopoll_delay(ctx, req);
+	io_hybrid_iopoll_delay(req, stat);
 	ret = io_uring_classic_poll(req, iob, poll_flags);
-	runtime = ktime_get_ns() - req->iopoll_start - sleep_time;
+	if (ret <= 0)
+		return ret;
 
 	/*
-	 * Use minimum sleep time if we're polling devices with different
-	 * latencies. We could get more completions from the faster ones.
+	 * The device completed something, use the time since issue as a
+	 * sample of its completion latency. Keep a moving average rather
+	 * than the minimum, so the prediction follows load changes both ways.
 	 */
-	if (ctx->hybrid_poll_time > runtime)
-		ctx->hybrid_poll_time = runtime;
-
+	lat = ktime_get_ns() - req->iopoll_start;
+	if (stat->lat_ns)
+		stat->lat_ns = stat->lat_ns - (stat->lat_ns >> 3) + (lat >> 3);
+	else
+		stat->lat_ns = lat;
 	return ret;
 }
 
@@ -11,6 +11,9 @@ struct io_meta_state {
 struct io_async_rw {
 	struct iou_vec			vec;
 	size_t				bytes_done;
+	/* per-iovec buffers for IORING_FIXED_IOVEC_PER_BUF */
+	struct io_rsrc_node		**buf_nodes;
+	unsigned			nr_buf_nodes;
 
 	struct_group(clear,
 		struct iov_iter			iter;
@@ -44,6 +47,7 @@ int io_read_fixed(struct io_kiocb *req, unsigned int issue_flags);
 int io_write_fixed(struct io_kiocb *req, unsigned int issue_flags);
 void io_readv_writev_cleanup(struct io_kiocb *req);
 void io_rw_fail(struct io_kiocb *req);
+void io_rw_link_res(struct io_kiocb *req, int res);
 void io_req_rw_complete(struct io_kiocb *req, io_tw_token_t tw);
 int io_read_mshot_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe);
 int io_read_mshot(struct io_kiocb *req, unsigned int issue_flags);
@@ -257,6 +257,20 @@ static void io_sq_update_worktime(struct io_sq_data *sqd, struct rusage *start)
 	sqd->work_time += end.ru_stime.tv_usec + end.ru_stime.tv_sec * 1000000;
 }
 
+/*
+ * A ring that just did work keeps the thread busy for its own idle period,
+ * not the largest one of all rings sharing the thread. That way a ring with
+ * a long sq_thread_idle that has gone quiet doesn't keep the thread spinning
+ * on behalf of a busy ring that asked for a short one.
+ */
+static unsigned long io_sq_ctx_idle_timeout(struct io_ring_ctx *ctx,
+					    unsigned long timeout)
+{
+	unsigned long ctx_timeout = jiffies + ctx->sq_thread_idle;
+
+	return time_after(ctx_timeout, timeout) ? ctx_timeout : timeout;
+}
+
 static int io_sq_thread(void *data)
 {
 	struct llist_node *retry_list = NULL;
@@ -311,21 +325,29 @@ static int io_sq_thread(void *data)
 		list_for_each_entry(ctx, &sqd->ctx_list, sqd_list) {
 			int ret = __io_sq_thread(ctx, cap_entries);
 
-			if (!sqt_spin && (ret > 0 || !wq_list_empty(&ctx->iopoll_list)))
+			if (ret > 0 || !wq_list_empty(&ctx->iopoll_list)) {
 				sqt_spin = true;
+				timeout = io_sq_ctx_idle_timeout(ctx, timeout);
+			}
 		}
-		if (io_sq_tw(&retry_list, IORING_TW_CAP_ENTRIES_VALUE))
+		/*
+		 * Rotate the ring list, so that the capped submission budget
+		 * isn't always handed out to the same ring first.
+		 */
+		if (cap_entries)
+			list_rotate_left(&sqd->ctx_list);
+		if (io_sq_tw(&retry_list, IORING_TW_CAP_ENTRIES_VALUE)) {
 			sqt_spin = true;
+			timeout = jiffies + sqd->sq_thread_idle;
+		}
 
 		list_for_each_entry(ctx, &sqd->ctx_list, sqd_list)
 			if (io_napi(ctx))
 				io_napi_sqpoll_busy_poll(ctx);
 
 		if (sqt_spin || !time_after(jiffies, timeout)) {
-			if (sqt_spin) {
+			if (sqt_spin)
 				io_sq_update_worktime(sqd, &start);
-				timeout = jiffies + sqd->sq_thread_idle;
-			}
 			if (unlikely(need_resched())) {
 				mutex_unlock(&sqd->lock);
 				cond_resched();
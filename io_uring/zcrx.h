@@ -7,6 +7,8 @@
 #include <net/page_pool/types.h>
 #include <net/net_trackers.h>
 
+struct seq_file;
+
 struct io_zcrx_area {
 	struct net_iov_area	nia;
 	struct io_zcrx_ifq	*ifq;
@@ -32,6 +34,13 @@ struct io_zcrx_ifq {
 	struct io_uring_zcrx_rqe	*rqes;
 	u32				cached_rq_head;
 	u32				rq_entries;
+	struct io_mapped_region		region;
+	u32				id;
+
+	/* refill statistics, reported through fdinfo */
+	u64				rq_refilled;
+	u64				rq_invalid;
+	u64				rq_empty;
 
 	u32				if_rxq;
 	struct device			*dev;
@@ -49,6 +58,9 @@ void io_shutdown_zcrx_ifqs(struct io_ring_ctx *ctx);
 int io_zcrx_recv(struct io_kiocb *req, struct io_zcrx_ifq *ifq,
 		 struct socket *sock, unsigned int flags,
 		 unsigned issue_flags, unsigned int *len);
+struct io_mapped_region *io_zcrx_get_region(struct io_ring_ctx *ctx,
+					    unsigned int id);
+void io_zcrx_show_fdinfo(struct io_ring_ctx *ctx, struct seq_file *m);
 #else
 static inline int io_register_zcrx_ifq(struct io_ring_ctx *ctx,
 					struct io_uring_zcrx_ifq_reg __user *arg)
@@ -67,6 +79,15 @@ static inline int io_zcrx_recv(struct io_kiocb *req, struct io_zcrx_ifq *ifq,
 {
 	return -EOPNOTSUPP;
 }
+static inline struct io_mapped_region *io_zcrx_get_region(struct io_ring_ctx *ctx,
+							  unsigned int id)
+{
+	return NULL;
+}
+static inline void io_zcrx_show_fdinfo(struct io_ring_ctx *ctx,
+				       struct seq_file *m)
+{
+}
 #endif
 
 int io_recvzc(struct io_kiocb *req, unsigned int issue_flags);
@@ -320,14 +320,19 @@ static void bpf_lru_list_push_free(struct bpf_lru_list *l,
 	raw_spin_unlock_irqrestore(&l->lock, flags);
 }
 
-static void bpf_lru_list_pop_free_to_local(struct bpf_lru *lru,
-					   struct bpf_lru_locallist *loc_l)
+/* Returns false, without doing anything, if @trylock and the lock is busy. */
+static bool bpf_lru_list_pop_free_to_local(struct bpf_lru *lru,
+					   struct bpf_lru_locallist *loc_l,
+					   bool trylock)
 {
 	struct bpf_lru_list *l = &lru->common_lru.lru_list;
 	struct bpf_lru_node *node, *tmp_node;
 	unsigned int nfree = 0;
 
-	raw_spin_lock(&l->lock);
+	if (!trylock)
+		raw_spin_lock(&l->lock);
+	else if (!raw_spin_trylock(&l->lock))
+		return false;
 
 	__local_list_flush(l, loc_l);
 
@@ -347,6 +352,7 @@ static void bpf_lru_list_pop_free_to_local(struct bpf_lru *lru,
 				      BPF_LRU_LOCAL_LIST_T_FREE);
 
 	raw_spin_unlock(&l->lock);
+	return true;
 }
 
 static void __local_list_add_pending(struct bpf_lru *lru,
@@ -377,7 +383,8 @@ __local_list_pop_free(struct bpf_lru_locallist *loc_l)
 }
 
 static struct bpf_lru_node *
-__local_list_pop_pending(struct bpf_lru *lru, struct bpf_lru_locallist *loc_l)
+__local_list_pop_pending(struct bpf_lru *lru, struct bpf_lru_locallist *loc_l,
+			 bool may_force)
 {
 	struct bpf_lru_node *node;
 	bool force = false;
@@ -393,7 +400,7 @@ __local_list_pop_pending(struct bpf_lru *lru, struct bpf_lru_locallist *loc_l)
 		}
 	}
 
-	if (!force) {
+	if (!force && may_force) {
 		force = true;
 		goto ignore_ref;
 	}
@@ -433,6 +440,30 @@ static struct bpf_lru_node *bpf_percpu_lru_pop_free(struct bpf_lru *lru,
 	return node;
 }
 
+/*
+ * Once the map is full, refilling the local free list from the global list
+ * means evicting anyway.  Rather than queue up on the global lock behind
+ * every other CPU, recycle the oldest unreferenced node this CPU added
+ * itself while that lock is busy.
+ */
+static struct bpf_lru_node *
+bpf_common_lru_refill_local(struct bpf_lru *lru,
+			    struct bpf_lru_locallist *loc_l)
+{
+	struct bpf_lru_list *l = &lru->common_lru.lru_list;
+	struct bpf_lru_node *node = NULL;
+
+	if (!bpf_lru_list_pop_free_to_local(lru, loc_l, true)) {
+		if (list_empty(&l->lists[BPF_LRU_LIST_T_FREE]))
+			node = __local_list_pop_pending(lru, loc_l, false);
+		if (node)
+			return node;
+		bpf_lru_list_pop_free_to_local(lru, loc_l, false);
+	}
+
+	return __local_list_pop_free(loc_l);
+}
+
 static struct bpf_lru_node *bpf_common_lru_pop_free(struct bpf_lru *lru,
 						    u32 hash)
 {
@@ -448,10 +479,8 @@ static struct bpf_lru_node *bpf_common_lru_pop_free(struct bpf_lru *lru,
 	raw_spin_lock_irqsave(&loc_l->lock, flags);
 
 	node = __local_list_pop_free(loc_l);
-	if (!node) {
-		bpf_lru_list_pop_free_to_local(lru, loc_l);
-		node = __local_list_pop_free(loc_l);
-	}
+	if (!node)
+		node = bpf_common_lru_refill_local(lru, loc_l);
 
 	if (node)
 		__local_list_add_pending(lru, loc_l, cpu, node, hash);
@@ -478,7 +507,7 @@ static struct bpf_lru_node *bpf_common_lru_pop_free(struct bpf_lru *lru,
 
 		node = __local_list_pop_free(steal_loc_l);
 		if (!node)
-			node = __local_list_pop_pending(lru, steal_loc_l);
+			node = __local_list_pop_pending(lru, steal_loc_l, true);
 
 		raw_spin_unlock_irqrestore(&steal_loc_l->lock, flags);
 
@@ -0,0 +1,428 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Open-addressing hash map for read-mostly lookups.
+ *
+ * Keys and values live inline in buckets of FLAT_HASH_SLOTS slots, and each
+ * bucket starts with one tag byte per slot, taken from the key's hash.  A
+ * lookup loads the tags of the key's bucket, compares them all at once as a
+ * word and only touches the slots whose tag matches, so a hit usually costs
+ * the cache line holding the tags and the one holding the key.  A key that
+ * does not fit its bucket goes to the next bucket with a free slot, and
+ * lookups stop probing at the first bucket that has a slot never used, or
+ * once they went past the farthest any key was ever placed from its home
+ * bucket.  The latter bounds misses once deletes have left tombstones in
+ * every bucket.
+ *
+ * Lookups take no locks: every bucket has a seqcount that writers bump
+ * around rewriting a slot, and a slot being rewritten is marked deleted
+ * first so that readers skip it.  Writers are serialised by one map lock,
+ * so update-heavy tables are better served by BPF_MAP_TYPE_HASH.  As with
+ * preallocated hash maps, a value returned to a program may be reused for
+ * another key once its own is deleted, and values are updated in place.
+ */
+#include <linux/bpf.h>
+#include <linux/btf_ids.h>
+#include <linux/err.h>
+#include <linux/hash.h>
+#include <linux/jhash.h>
+#include <linux/random.h>
+#include <linux/seqlock.h>
+#include <asm/rqspinlock.h>
+
+#define FLAT_HASH_CREATE_FLAG_MASK \
+	(BPF_F_NUMA_NODE | BPF_F_ZERO_SEED | BPF_F_ACCESS_MASK)
+
+#define FLAT_HASH_SLOTS		8
+#define FLAT_HASH_TAG_EMPTY	0x00
+#define FLAT_HASH_TAG_DELETED	0x01
+/* live slots have the top bit set and seven bits of the hash below it */
+#define FLAT_HASH_TAG_LIVE	0x80
+
+#define FLAT_HASH_ONES		0x0101010101010101ULL
+#define FLAT_HASH_HIGHS		0x8080808080808080ULL
+
+struct flat_hash_bucket {
+	seqcount_t seq;
+	union {
+		u8 tag[FLAT_HASH_SLOTS];
+		u64 tags;
+	};
+	/* FLAT_HASH_SLOTS slots of elem_size bytes each, key first */
+	char slots[];
+};
+
+struct bpf_flat_hash {
+	struct bpf_map map;
+	rqspinlock_t lock;
+	void *buckets;
+	u32 n_buckets;
+	u32 bucket_size;
+	u32 elem_size;
+	u32 key_size;	/* key_size rounded up to 8 bytes */
+	u32 count;
+	u32 max_probe;	/* farthest a key went from its home bucket */
+	u32 hash_seed;
+};
+
+static struct bpf_flat_hash *flat_hash_of(const struct bpf_map *map)
+{
+	return container_of(map, struct bpf_flat_hash, map);
+}
+
+static u32 flat_hash_hash(const struct bpf_flat_hash *fh, const void *key)
+{
+	u32 key_size = fh->map.key_size;
+
+	if (likely(key_size % 4 == 0))
+		return jhash2(key, key_size / 4, fh->hash_seed);
+	return jhash(key, key_size, fh->hash_seed);
+}
+
+static u8 flat_hash_tag(u32 hash)
+{
+	return FLAT_HASH_TAG_LIVE | hash_32(hash, 7);
+}
+
+static struct flat_hash_bucket *flat_hash_bucket(const struct bpf_flat_hash *fh,
+						 u32 idx)
+{
+	return fh->buckets + (size_t)idx * fh->bucket_size;
+}
+
+static void *flat_hash_slot(const struct bpf_flat_hash *fh,
+			    struct flat_hash_bucket *b, unsigned int slot)
+{
+	return b->slots + slot * fh->elem_size;
+}
+
+/* Bytes of @x that are zero have their top bit set, plus maybe a few more. */
+static u64 flat_hash_zero_bytes(u64 x)
+{
+	return (x - FLAT_HASH_ONES) & ~x & FLAT_HASH_HIGHS;
+}
+
+static unsigned int flat_hash_bit_to_slot(unsigned int bit)
+{
+#ifdef __BIG_ENDIAN
+	return FLAT_HASH_SLOTS - 1 - bit / 8;
+#else
+	return bit / 8;
+#endif
+}
+
+static void *flat_hash_match(const struct bpf_flat_hash *fh,
+			     struct flat_hash_bucket *b, u64 tags, u8 tag,
+			     const void *key)
+{
+	u64 match = flat_hash_zero_bytes(tags ^ (FLAT_HASH_ONES * tag));
+	unsigned int slot;
+	void *elem;
+
+	while (match) {
+		slot = flat_hash_bit_to_slot(__ffs64(match));
+		match &= match - 1;
+
+		if (READ_ONCE(b->tag[slot]) != tag)
+			continue;
+		elem = flat_hash_slot(fh, b, slot);
+		if (!memcmp(elem, key, fh->map.key_size))
+			return elem;
+	}
+	return NULL;
+}
+
+/*
+ * Find the slot holding @key.  Safe against concurrent writers: a bucket is
+ * searched again if a slot of it was rewritten meanwhile, which only a
+ * writer that got past its seqcount can cause, so this never waits on a
+ * writer that it interrupted.
+ */
+static void *flat_hash_find(const struct bpf_flat_hash *fh, const void *key,
+			    u32 hash, struct flat_hash_bucket **bp)
+{
+	u32 mask = fh->n_buckets - 1, idx = hash & mask, n;
+	u32 max_probe = READ_ONCE(fh->max_probe);
+	u8 tag = flat_hash_tag(hash);
+	struct flat_hash_bucket *b;
+	unsigned int seq;
+	void *elem;
+	u64 tags;
+
+	for (n = 0; n <= max_probe; n++, idx = (idx + 1) & mask) {
+		b = flat_hash_bucket(fh, idx);
+		do {
+			seq = raw_read_seqcount(&b->seq);
+			tags = READ_ONCE(b->tags);
+			/* pairs with smp_store_release() of a live tag */
+			smp_rmb();
+			elem = flat_hash_match(fh, b, tags, tag, key);
+		} while (read_seqcount_retry(&b->seq, seq));
+
+		if (elem) {
+			if (bp)
+				*bp = b;
+			return elem;
+		}
+		/* nothing was ever pushed past a bucket that was never full */
+		if (flat_hash_zero_bytes(tags))
+			break;
+	}
+	return NULL;
+}
+
+static void *flat_hash_lookup_elem(struct bpf_map *map, void *key)
+{
+	struct bpf_flat_hash *fh = flat_hash_of(map);
+	void *elem;
+
+	elem = flat_hash_find(fh, key, flat_hash_hash(fh, key), NULL);
+	return elem ? elem + fh->key_size : NULL;
+}
+
+static int flat_hash_lock(struct bpf_flat_hash *fh, unsigned long *pflags)
+{
+	unsigned long flags;
+	int ret;
+
+	ret = raw_res_spin_lock_irqsave(&fh->lock, flags);
+	if (ret)
+		return ret;
+	*pflags = flags;
+	return 0;
+}
+
+static void flat_hash_unlock(struct bpf_flat_hash *fh, unsigned long flags)
+{
+	raw_res_spin_unlock_irqrestore(&fh->lock, flags);
+}
+
+/* Called with the map lock held, once @key is known to be missing. */
+static int flat_hash_insert(struct bpf_flat_hash *fh, void *key, void *value,
+			    u32 hash)
+{
+	u32 mask = fh->n_buckets - 1, idx = hash & mask, n;
+	struct flat_hash_bucket *b;
+	unsigned int slot;
+	void *elem;
+
+	if (fh->count >= fh->map.max_entries)
+		return -E2BIG;
+
+	for (n = 0; n < fh->n_buckets; n++, idx = (idx + 1) & mask) {
+		b = flat_hash_bucket(fh, idx);
+		for (slot = 0; slot < FLAT_HASH_SLOTS; slot++) {
+			if (!(b->tag[slot] & FLAT_HASH_TAG_LIVE))
+				goto found;
+		}
+	}
+	return -E2BIG;
+
+found:
+	/* store_release of the tag below orders this before it */
+	if (n > fh->max_probe)
+		WRITE_ONCE(fh->max_probe, n);
+	elem = flat_hash_slot(fh, b, slot);
+	WRITE_ONCE(b->tag[slot], FLAT_HASH_TAG_DELETED);
+	write_seqcount_begin(&b->seq);
+	memcpy(elem, key, fh->map.key_size);
+	copy_map_value(&fh->map, elem + fh->key_size, value);
+	write_seqcount_end(&b->seq);
+	smp_store_release(&b->tag[slot], flat_hash_tag(hash));
+	fh->count++;
+	return 0;
+}
+
+static long flat_hash_update_elem(struct bpf_map *map, void *key, void *value,
+				  u64 map_flags)
+{
+	struct bpf_flat_hash *fh = flat_hash_of(map);
+	u32 hash = flat_hash_hash(fh, key);
+	struct flat_hash_bucket *b;
+	unsigned long flags;
+	void *elem;
+	int ret;
+
+	if (unlikely(map_flags > BPF_EXIST))
+		return -EINVAL;
+
+	ret = flat_hash_lock(fh, &flags);
+	if (ret)
+		return ret;
+
+	elem = flat_hash_find(fh, key, hash, &b);
+	if (elem) {
+		ret = -EEXIST;
+		if (map_flags == BPF_NOEXIST)
+			goto unlock;
+		write_seqcount_begin(&b->seq);
+		copy_map_value(map, elem + fh->key_size, value);
+		write_seqcount_end(&b->seq);
+		ret = 0;
+	} else {
+		ret = -ENOENT;
+		if (map_flags == BPF_EXIST)
+			goto unlock;
+		ret = flat_hash_insert(fh, key, value, hash);
+	}
+unlock:
+	flat_hash_unlock(fh, flags);
+	return ret;
+}
+
+static long flat_hash_delete_elem(struct bpf_map *map, void *key)
+{
+	struct bpf_flat_hash *fh = flat_hash_of(map);
+	struct flat_hash_bucket *b;
+	unsigned long flags;
+	unsigned int slot;
+	void *elem;
+	int ret;
+
+	ret = flat_hash_lock(fh, &flags);
+	if (ret)
+		return ret;
+
+	elem = flat_hash_find(fh, key, flat_hash_hash(fh, key), &b);
+	if (!elem) {
+		ret = -ENOENT;
+		goto unlock;
+	}
+	slot = (elem - (void *)b->slots) / fh->elem_size;
+	/*
+	 * A bucket that still has a never used slot was never full, so no
+	 * probe goes past it and the slot can become unused again.
+	 */
+	WRITE_ONCE(b->tag[slot], flat_hash_zero_bytes(b->tags) ?
+				 FLAT_HASH_TAG_EMPTY : FLAT_HASH_TAG_DELETED);
+	fh->count--;
+unlock:
+	flat_hash_unlock(fh, flags);
+	return ret;
+}
+
+static int flat_hash_get_next_key(struct bpf_map *map, void *key,
+				  void *next_key)
+{
+	struct bpf_flat_hash *fh = flat_hash_of(map);
+	u32 nr_slots = fh->n_buckets * FLAT_HASH_SLOTS;
+	struct flat_hash_bucket *b;
+	unsigned int seq, slot;
+	bool live;
+	u32 i = 0;
+	void *elem;
+
+	if (key) {
+		elem = flat_hash_find(fh, key, flat_hash_hash(fh, key), &b);
+		if (elem)
+			i = ((void *)b - fh->buckets) / fh->bucket_size *
+			    FLAT_HASH_SLOTS +
+			    (elem - (void *)b->slots) / fh->elem_size + 1;
+	}
+
+	for (; i < nr_slots; i++) {
+		b = flat_hash_bucket(fh, i / FLAT_HASH_SLOTS);
+		slot = i % FLAT_HASH_SLOTS;
+		do {
+			seq = raw_read_seqcount(&b->seq);
+			live = READ_ONCE(b->tag[slot]) & FLAT_HASH_TAG_LIVE;
+			smp_rmb();
+			if (live)
+				memcpy(next_key, flat_hash_slot(fh, b, slot),
+				       map->key_size);
+		} while (read_seqcount_retry(&b->seq, seq));
+		if (live)
+			return 0;
+	}
+	return -ENOENT;
+}
+
+static int flat_hash_alloc_check(union bpf_attr *attr)
+{
+	if (attr->key_size == 0 || attr->value_size == 0 ||
+	    attr->max_entries == 0 ||
+	    attr->map_flags & ~FLAT_HASH_CREATE_FLAG_MASK ||
+	    !bpf_map_flags_access_ok(attr->map_flags))
+		return -EINVAL;
+
+	if (attr->key_size > MAX_BPF_STACK ||
+	    attr->value_size > KMALLOC_MAX_SIZE ||
+	    DIV_ROUND_UP(attr->max_entries, FLAT_HASH_SLOTS - 1) >
+	    U32_MAX / FLAT_HASH_SLOTS / 2)
+		return -E2BIG;
+
+	return 0;
+}
+
+static struct bpf_map *flat_hash_alloc(union bpf_attr *attr)
+{
+	int numa_node = bpf_map_attr_numa_node(attr);
+	struct bpf_flat_hash *fh;
+	struct flat_hash_bucket *b;
+	u64 size;
+	u32 i;
+
+	fh = bpf_map_area_alloc(sizeof(*fh), numa_node);
+	if (!fh)
+		return ERR_PTR(-ENOMEM);
+
+	bpf_map_init_from_attr(&fh->map, attr);
+	raw_res_spin_lock_init(&fh->lock);
+
+	fh->key_size = round_up(attr->key_size, 8);
+	fh->elem_size = fh->key_size + round_up(attr->value_size, 8);
+	fh->bucket_size = round_up(sizeof(*b) + FLAT_HASH_SLOTS * fh->elem_size,
+				   L1_CACHE_BYTES);
+	/* keep a slot per bucket spare so that most probes stop at home */
+	fh->n_buckets = roundup_pow_of_two(DIV_ROUND_UP(attr->max_entries,
+							FLAT_HASH_SLOTS - 1));
+
+	size = (u64)fh->n_buckets * fh->bucket_size;
+	fh->buckets = bpf_map_area_alloc(size, numa_node);
+	if (!fh->buckets) {
+		bpf_map_area_free(fh);
+		return ERR_PTR(-ENOMEM);
+	}
+
+	for (i = 0; i < fh->n_buckets; i++) {
+		b = flat_hash_bucket(fh, i);
+		seqcount_init(&b->seq);
+		cond_resched();
+	}
+
+	if (!(attr->map_flags & BPF_F_ZERO_SEED))
+		fh->hash_seed = get_random_u32();
+
+	return &fh->map;
+}
+
+static void flat_hash_free(struct bpf_map *map)
+{
+	struct bpf_flat_hash *fh = flat_hash_of(map);
+
+	bpf_map_area_free(fh->buckets);
+	bpf_map_area_free(fh);
+}
+
+static u64 flat_hash_mem_usage(const struct bpf_map *map)
+{
+	struct bpf_flat_hash *fh = flat_hash_of(map);
+
+	return sizeof(*fh) + (u64)fh->n_buckets * fh->bucket_size;
+}
+
+BTF_ID_LIST_SINGLE(flat_hash_map_btf_ids, struct, bpf_flat_hash)
+const struct bpf_map_ops flat_hash_map_ops = {
+	.map_meta_equal = bpf_map_meta_equal,
+	.map_alloc_check = flat_hash_alloc_check,
+	.map_alloc = flat_hash_alloc,
+	.map_free = flat_hash_free,
+	.map_get_next_key = flat_hash_get_next_key,
+	.map_lookup_elem = flat_hash_lookup_elem,
+	.map_update_elem = flat_hash_update_elem,
+	.map_delete_elem = flat_hash_delete_elem,
+	.map_lookup_batch = generic_map_lookup_batch,
+	.map_update_batch = generic_map_update_batch,
+	.map_delete_batch = generic_map_delete_batch,
+	.map_mem_usage = flat_hash_mem_usage,
+	.map_btf_id = &flat_hash_map_btf_ids[0],
+};
@@ -9,6 +9,7 @@
 #include <linux/rculist_nulls.h>
 #include <linux/rcupdate_wait.h>
 #include <linux/random.h>
+#include <linux/sizes.h>
 #include <uapi/linux/btf.h>
 #include <linux/rcupdate_trace.h>
 #include <linux/btf_ids.h>
@@ -85,6 +86,9 @@ struct bucket {
 #define HASHTAB_MAP_LOCK_COUNT 8
 #define HASHTAB_MAP_LOCK_MASK (HASHTAB_MAP_LOCK_COUNT - 1)
 
+/* Bytes of entries a batch op gathers from buckets before copying out. */
+#define HTAB_BATCH_BUF_SIZE	SZ_64K
+
 struct bpf_htab {
 	struct bpf_map map;
 	struct bpf_mem_alloc ma;
@@ -1672,6 +1676,17 @@ static int htab_lru_percpu_map_lookup_and_delete_elem(struct bpf_map *map,
 						 flags);
 }
 
+static int htab_batch_copy_out(void __user *ukeys, void __user *uvalues,
+			       const void *keys, const void *values, u32 total,
+			       u32 cnt, u32 key_size, u32 value_size)
+{
+	if (copy_to_user(ukeys + total * key_size, keys, key_size * cnt) ||
+	    copy_to_user(uvalues + total * value_size, values,
+			 value_size * cnt))
+		return -EFAULT;
+	return 0;
+}
+
 static int
 __htab_map_lookup_and_delete_batch(struct bpf_map *map,
 				   const union bpf_attr *attr,
@@ -1680,7 +1695,7 @@ __htab_map_lookup_and_delete_batch(struct bpf_map *map,
 				   bool is_percpu)
 {
 	struct bpf_htab *htab = container_of(map, struct bpf_htab, map);
-	u32 bucket_cnt, total, key_size, value_size, roundup_key_size;
+	u32 bucket_cnt, total, filled, key_size, value_size, roundup_key_size;
 	void *keys = NULL, *values = NULL, *value, *dst_key, *dst_val;
 	void __user *uvalues = u64_to_user_ptr(attr->batch.values);
 	void __user *ukeys = u64_to_user_ptr(attr->batch.keys);
@@ -1726,10 +1741,14 @@ __htab_map_lookup_and_delete_batch(struct bpf_map *map,
 	if (is_percpu)
 		value_size = size * num_possible_cpus();
 	total = 0;
+	filled = 0;
 	/* while experimenting with hash tables with sizes ranging from 10 to
 	 * 1000, it was observed that a bucket can have up to 5 entries.
+	 * Room for many buckets saves two copy_to_user() calls per bucket.
 	 */
-	bucket_size = 5;
+	bucket_size = min(max_count,
+			  HTAB_BATCH_BUF_SIZE / (key_size + value_size));
+	bucket_size = max(bucket_size, 5U);
 
 alloc:
 	/* We cannot do copy_from_user or copy_to_user inside
@@ -1746,8 +1765,8 @@ __htab_map_lookup_and_delete_batch(struct bpf_map *map,
 	bpf_disable_instrumentation();
 	rcu_read_lock();
 again_nocopy:
-	dst_key = keys;
-	dst_val = values;
+	dst_key = keys + filled * key_size;
+	dst_val = values + filled * value_size;
 	b = &htab->buckets[batch];
 	head = &b->head;
 	/* do not grab the lock unless need it (bucket_cnt > 0). */
@@ -1769,8 +1788,8 @@ __htab_map_lookup_and_delete_batch(struct bpf_map *map,
 		goto again_nocopy;
 	}
 
-	if (bucket_cnt > (max_count - total)) {
-		if (total == 0)
+	if (bucket_cnt > (max_count - total - filled)) {
+		if (total + filled == 0)
 			ret = -ENOSPC;
 		/* Note that since bucket_cnt > 0 here, it is implicit
 		 * that the locked was grabbed, so release it.
@@ -1781,14 +1800,25 @@ __htab_map_lookup_and_delete_batch(struct bpf_map *map,
 		goto after_loop;
 	}
 
-	if (bucket_cnt > bucket_size) {
-		bucket_size = bucket_cnt;
+	if (bucket_cnt > bucket_size - filled) {
 		/* Note that since bucket_cnt > 0 here, it is implicit
 		 * that the locked was grabbed, so release it.
 		 */
 		htab_unlock_bucket(b, flags);
 		rcu_read_unlock();
 		bpf_enable_instrumentation();
+		if (filled) {
+			/* make room and retry this bucket */
+			ret = htab_batch_copy_out(ukeys, uvalues, keys, values,
+						  total, filled, key_size,
+						  value_size);
+			if (ret)
+				goto out;
+			total += filled;
+			filled = 0;
+			goto again;
+		}
+		bucket_size = bucket_cnt;
 		kvfree(keys);
 		kvfree(values);
 		goto alloc;
@@ -1851,6 +1881,7 @@ __htab_map_lookup_and_delete_batch(struct bpf_map *map,
 
 	htab_unlock_bucket(b, flags);
 	locked = false;
+	filled += bucket_cnt;
 
 	while (node_to_free) {
 		l = node_to_free;
@@ -1862,35 +1893,24 @@ __htab_map_lookup_and_delete_batch(struct bpf_map *map,
 	}
 
 next_batch:
-	/* If we are not copying data, we can go to next bucket and avoid
-	 * unlocking the rcu.
+	/* The copied entries stay in the buffer until it runs out of room,
+	 * so we can go to next bucket and avoid unlocking the rcu.
 	 */
-	if (!bucket_cnt && (batch + 1 < htab->n_buckets)) {
-		batch++;
+	batch++;
+	if (batch < htab->n_buckets)
 		goto again_nocopy;
-	}
 
 	rcu_read_unlock();
 	bpf_enable_instrumentation();
-	if (bucket_cnt && (copy_to_user(ukeys + total * key_size, keys,
-	    key_size * bucket_cnt) ||
-	    copy_to_user(uvalues + total * value_size, values,
-	    value_size * bucket_cnt))) {
-		ret = -EFAULT;
-		goto after_loop;
-	}
-
-	total += bucket_cnt;
-	batch++;
-	if (batch >= htab->n_buckets) {
-		ret = -ENOENT;
-		goto after_loop;
-	}
-	goto again;
+	ret = -ENOENT;
 
 after_loop:
+	if (filled && htab_batch_copy_out(ukeys, uvalues, keys, values, total,
+					  filled, key_size, value_size))
+		ret = -EFAULT;
 	if (ret == -EFAULT)
 		goto out;
+	total += filled;
 
 	/* copy # of entries and next batch */
 	ubatch = u64_to_user_ptr(attr->batch.out_batch);
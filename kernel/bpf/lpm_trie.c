@@ -21,6 +21,9 @@
 /* Intermediate node */
 #define LPM_TREE_NODE_FLAG_IM BIT(0)
 
+/* Lookups start from an index on the first byte of the key. */
+#define LPM_INDEX_BITS	8
+
 struct lpm_trie_node;
 
 struct lpm_trie_node {
@@ -30,6 +33,14 @@ struct lpm_trie_node {
 	u8				data[];
 };
 
+/* What a lookup learns from the nodes shorter than LPM_INDEX_BITS. */
+struct lpm_trie_index {
+	/* the first node the lookup has to look at */
+	struct lpm_trie_node __rcu	*node;
+	/* the best match among the nodes before it */
+	struct lpm_trie_node __rcu	*found;
+};
+
 struct lpm_trie {
 	struct bpf_map			map;
 	struct lpm_trie_node __rcu	*root;
@@ -38,6 +49,7 @@ struct lpm_trie {
 	size_t				max_prefixlen;
 	size_t				data_size;
 	rqspinlock_t			lock;
+	struct lpm_trie_index		index[1 << LPM_INDEX_BITS];
 };
 
 /* This trie implements a longest prefix match algorithm that can be used to
@@ -149,6 +161,13 @@ struct lpm_trie {
  * is a child that can be used to become more specific, the trie is traversed
  * downwards. The last node in the traversal that is a non-intermediate one is
  * returned.
+ *
+ * The part of that traversal that only looks at the first byte of the key is
+ * the same for all keys starting with that byte, so it is done in advance for
+ * each possible byte and kept in @index.  Lookups of keys with a prefix length
+ * of at least LPM_INDEX_BITS start from there.  An update changes a single
+ * child (or root) pointer, and only the index entries whose traversal can go
+ * through that pointer are recomputed, before any node is freed.
  */
 
 static inline int extract_bit(const u8 *data, size_t index)
@@ -240,14 +259,24 @@ static void *trie_lookup_elem(struct bpf_map *map, void *_key)
 	struct lpm_trie *trie = container_of(map, struct lpm_trie, map);
 	struct lpm_trie_node *node, *found = NULL;
 	struct bpf_lpm_trie_key_u8 *key = _key;
+	struct lpm_trie_index *index;
 
 	if (key->prefixlen > trie->max_prefixlen)
 		return NULL;
 
-	/* Start walking the trie from the root node ... */
+	/* Start walking the trie from the index or the root node ... */
+	if (key->prefixlen >= LPM_INDEX_BITS) {
+		index = &trie->index[key->data[0]];
+		found = rcu_dereference_check(index->found,
+					      rcu_read_lock_bh_held());
+		node = rcu_dereference_check(index->node,
+					     rcu_read_lock_bh_held());
+	} else {
+		node = rcu_dereference_check(trie->root,
+					     rcu_read_lock_bh_held());
+	}
 
-	for (node = rcu_dereference_check(trie->root, rcu_read_lock_bh_held());
-	     node;) {
+	while (node) {
 		unsigned int next_bit;
 		size_t matchlen;
 
@@ -308,6 +337,40 @@ static struct lpm_trie_node *lpm_trie_node_alloc(struct lpm_trie *trie,
 	return node;
 }
 
+/*
+ * Recompute the index entries for keys whose first @bits bits are those of
+ * @key, i.e. every entry whose traversal can pass through a child pointer
+ * reached after matching @bits bits.  Called with the trie lock held.
+ */
+static void trie_update_index(struct lpm_trie *trie,
+			      const struct bpf_lpm_trie_key_u8 *key,
+			      size_t bits)
+{
+	unsigned int first, i, nr, shift, next_bit;
+	struct lpm_trie_node *node, *found;
+
+	bits = min_t(size_t, bits, LPM_INDEX_BITS);
+	nr = 1U << (LPM_INDEX_BITS - bits);
+	first = key->data[0] & ~(nr - 1);
+
+	for (i = first; i < first + nr; i++) {
+		found = NULL;
+		node = rcu_dereference(trie->root);
+		while (node && node->prefixlen < LPM_INDEX_BITS) {
+			/* stop at a mismatch, the lookup will find it too */
+			shift = LPM_INDEX_BITS - node->prefixlen;
+			if ((node->data[0] ^ i) >> shift)
+				break;
+			if (!(node->flags & LPM_TREE_NODE_FLAG_IM))
+				found = node;
+			next_bit = (i >> (shift - 1)) & 1;
+			node = rcu_dereference(node->child[next_bit]);
+		}
+		rcu_assign_pointer(trie->index[i].found, found);
+		rcu_assign_pointer(trie->index[i].node, node);
+	}
+}
+
 static int trie_check_add_elem(struct lpm_trie *trie, u64 flags)
 {
 	if (flags == BPF_EXIST)
@@ -329,7 +392,7 @@ static long trie_update_elem(struct bpf_map *map,
 	struct bpf_lpm_trie_key_u8 *key = _key;
 	unsigned long irq_flags;
 	unsigned int next_bit;
-	size_t matchlen = 0;
+	size_t matchlen = 0, slot_bits = 0;
 	int ret = 0;
 
 	if (unlikely(flags > BPF_EXIST))
@@ -368,6 +431,7 @@ static long trie_update_elem(struct bpf_map *map,
 
 		next_bit = extract_bit(key->data, node->prefixlen);
 		slot = &node->child[next_bit];
+		slot_bits = node->prefixlen + 1;
 	}
 
 	/* If the slot is empty (a free child pointer or an empty root),
@@ -444,6 +508,8 @@ static long trie_update_elem(struct bpf_map *map,
 	rcu_assign_pointer(*slot, im_node);
 
 out:
+	if (!ret)
+		trie_update_index(trie, key, slot_bits);
 	raw_res_spin_unlock_irqrestore(&trie->lock, irq_flags);
 out_free:
 	if (ret)
@@ -461,6 +527,7 @@ static long trie_delete_elem(struct bpf_map *map, void *_key)
 	struct bpf_lpm_trie_key_u8 *key = _key;
 	struct lpm_trie_node __rcu **trim, **trim2;
 	struct lpm_trie_node *node, *parent;
+	size_t trim_bits = 0, trim2_bits = 0;
 	unsigned long irq_flags;
 	unsigned int next_bit;
 	size_t matchlen = 0;
@@ -491,8 +558,10 @@ static long trie_delete_elem(struct bpf_map *map, void *_key)
 
 		parent = node;
 		trim2 = trim;
+		trim2_bits = trim_bits;
 		next_bit = extract_bit(key->data, node->prefixlen);
 		trim = &node->child[next_bit];
+		trim_bits = node->prefixlen + 1;
 	}
 
 	if (!node || node->prefixlen != key->prefixlen ||
@@ -510,6 +579,7 @@ static long trie_delete_elem(struct bpf_map *map, void *_key)
 	if (rcu_access_pointer(node->child[0]) &&
 	    rcu_access_pointer(node->child[1])) {
 		node->flags |= LPM_TREE_NODE_FLAG_IM;
+		trie_update_index(trie, key, trim_bits);
 		goto out;
 	}
 
@@ -528,6 +598,7 @@ static long trie_delete_elem(struct bpf_map *map, void *_key)
 		else
 			rcu_assign_pointer(
 				*trim2, rcu_access_pointer(parent->child[0]));
+		trie_update_index(trie, key, trim2_bits);
 		free_parent = parent;
 		free_node = node;
 		goto out;
@@ -543,6 +614,7 @@ static long trie_delete_elem(struct bpf_map *map, void *_key)
 		rcu_assign_pointer(*trim, rcu_access_pointer(node->child[1]));
 	else
 		RCU_INIT_POINTER(*trim, NULL);
+	trie_update_index(trie, key, trim_bits);
 	free_node = node;
 
 out:
@@ -424,16 +424,26 @@ static void *__bpf_ringbuf_reserve(struct bpf_ringbuf *rb, u64 size)
 	prod_pos = rb->producer_pos;
 	new_prod_pos = prod_pos + len;
 
-	while (pend_pos < prod_pos) {
-		hdr = (void *)rb->data + (pend_pos & rb->mask);
-		hdr_len = READ_ONCE(hdr->len);
-		if (hdr_len & BPF_RINGBUF_BUSY_BIT)
-			break;
-		tmp_size = hdr_len & ~BPF_RINGBUF_DISCARD_BIT;
-		tmp_size = round_up(tmp_size + BPF_RINGBUF_HDR_SZ, 8);
-		pend_pos += tmp_size;
+	/*
+	 * Walking past committed records reads headers other CPUs just
+	 * wrote, all under the lock, so only walk while the oldest record
+	 * we know of might still be pending and in the way.  The walk then
+	 * goes as far as the reserve needs, or up to the first record still
+	 * busy, so a reserve never fails on a stale pending_pos.
+	 */
+	if (new_prod_pos - pend_pos > rb->mask) {
+		while (pend_pos < prod_pos &&
+		       new_prod_pos - pend_pos > rb->mask) {
+			hdr = (void *)rb->data + (pend_pos & rb->mask);
+			hdr_len = READ_ONCE(hdr->len);
+			if (hdr_len & BPF_RINGBUF_BUSY_BIT)
+				break;
+			tmp_size = hdr_len & ~BPF_RINGBUF_DISCARD_BIT;
+			tmp_size = round_up(tmp_size + BPF_RINGBUF_HDR_SZ, 8);
+			pend_pos += tmp_size;
+		}
+		rb->pending_pos = pend_pos;
 	}
-	rb->pending_pos = pend_pos;
 
 	/* check for out of ringbuf space:
 	 * - by ensuring producer position doesn't advance more than
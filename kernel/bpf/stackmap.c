@@ -9,6 +9,7 @@
 #include <linux/perf_event.h>
 #include <linux/btf_ids.h>
 #include <linux/buildid.h>
+#include <linux/hash.h>
 #include "percpu_freelist.h"
 #include "mmap_unlock_work.h"
 
@@ -124,10 +125,85 @@ static struct bpf_map *stack_map_alloc(union bpf_attr *attr)
 	return ERR_PTR(err);
 }
 
+/*
+ * Build IDs parsed recently on this CPU, keyed by the mapped file.  The
+ * inode pointer alone could be reused by another file, so the number,
+ * generation and mtime have to match as well.
+ */
+#define BUILD_ID_CACHE_BITS	4
+
+struct build_id_cache_entry {
+	const struct inode *inode;	/* compared, never dereferenced */
+	unsigned long ino;
+	u32 generation;
+	struct timespec64 mtime;
+	unsigned char build_id[BUILD_ID_SIZE_MAX];
+};
+
+struct build_id_cache {
+	/* an NMI finding the cache in use on its CPU goes without it */
+	int busy;
+	struct build_id_cache_entry ent[1 << BUILD_ID_CACHE_BITS];
+};
+
+static DEFINE_PER_CPU(struct build_id_cache, build_id_cache);
+
+/* Must be paired with build_id_cache_put(), even if it returned NULL. */
+static struct build_id_cache_entry *
+build_id_cache_get(const struct inode *inode)
+{
+	preempt_disable();
+	if (this_cpu_inc_return(build_id_cache.busy) != 1)
+		return NULL;
+	return this_cpu_ptr(&build_id_cache.ent[hash_ptr(inode,
+							 BUILD_ID_CACHE_BITS)]);
+}
+
+static void build_id_cache_put(void)
+{
+	this_cpu_dec(build_id_cache.busy);
+	preempt_enable();
+}
+
 static int fetch_build_id(struct vm_area_struct *vma, unsigned char *build_id, bool may_fault)
 {
-	return may_fault ? build_id_parse(vma, build_id, NULL)
-			 : build_id_parse_nofault(vma, build_id, NULL);
+	struct build_id_cache_entry *e;
+	struct timespec64 mtime;
+	struct inode *inode;
+	bool hit = false;
+	int ret;
+
+	if (!vma->vm_file)
+		return -EINVAL;
+	inode = file_inode(vma->vm_file);
+	mtime = inode_get_mtime(inode);
+
+	e = build_id_cache_get(inode);
+	if (e && e->inode == inode && e->ino == inode->i_ino &&
+	    e->generation == inode->i_generation &&
+	    timespec64_equal(&e->mtime, &mtime)) {
+		memcpy(build_id, e->build_id, BUILD_ID_SIZE_MAX);
+		hit = true;
+	}
+	build_id_cache_put();
+	if (hit)
+		return 0;
+
+	ret = may_fault ? build_id_parse(vma, build_id, NULL)
+			: build_id_parse_nofault(vma, build_id, NULL);
+	if (ret)
+		return ret;
+
+	e = build_id_cache_get(inode);
+	if (e) {
+		e->inode = inode;
+		e->ino = inode->i_ino;
+		e->generation = inode->i_generation;
+		e->mtime = mtime;
+		memcpy(e->build_id, build_id, BUILD_ID_SIZE_MAX);
+	}
+	build_id_cache_put();
+	return 0;
 }
 
 /*
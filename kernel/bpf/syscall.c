@@ -1457,6 +1457,7 @@ static int map_create(union bpf_attr *attr, bool kernel)
 	case BPF_MAP_TYPE_STRUCT_OPS:
 	case BPF_MAP_TYPE_CPUMAP:
 	case BPF_MAP_TYPE_ARENA:
+	case BPF_MAP_TYPE_FLAT_HASH:
 		if (!bpf_token_capable(token, CAP_BPF))
 			goto put_token;
 		break;
@@ -353,7 +353,8 @@ static void bpf_tramp_image_put(struct bpf_tramp_image *im)
 	call_rcu_tasks_trace(&im->rcu, __bpf_tramp_image_put_rcu_tasks);
 }
 
-static struct bpf_tramp_image *bpf_tramp_image_alloc(u64 key, int size)
+static struct bpf_tramp_image *bpf_tramp_image_alloc(u64 key, int size,
+						     u32 flags)
 {
 	struct bpf_tramp_image *im;
 	struct bpf_ksym *ksym;
@@ -374,9 +375,15 @@ static struct bpf_tramp_image *bpf_tramp_image_alloc(u64 key, int size)
 	if (!image)
 		goto out_uncharge;
 
-	err = percpu_ref_init(&im->pcref, __bpf_tramp_image_release, 0, GFP_KERNEL);
-	if (err)
-		goto out_free_image;
+	/* Only a trampoline calling the original function takes the ref,
+	 * skip the per-cpu counter for the others.
+	 */
+	if (flags & BPF_TRAMP_F_CALL_ORIG) {
+		err = percpu_ref_init(&im->pcref, __bpf_tramp_image_release, 0,
+				      GFP_KERNEL);
+		if (err)
+			goto out_free_image;
+	}
 
 	ksym = &im->ksym;
 	INIT_LIST_HEAD_RCU(&ksym->lnode);
@@ -449,7 +456,7 @@ static int bpf_trampoline_update(struct bpf_trampoline *tr, bool lock_direct_mut
 		goto out;
 	}
 
-	im = bpf_tramp_image_alloc(tr->key, size);
+	im = bpf_tramp_image_alloc(tr->key, size, tr->flags);
 	if (IS_ERR(im)) {
 		err = PTR_ERR(im);
 		goto out;
@@ -18164,21 +18164,20 @@ static bool check_ids(u32 old_id, u32 cur_id, struct bpf_idmap *idmap)
 	if (old_id == 0) /* cur_id == 0 as well */
 		return true;
 
-	for (i = 0; i < BPF_ID_MAP_SIZE; i++) {
-		if (!map[i].old) {
-			/* Reached an empty slot; haven't seen this id before */
-			map[i].old = old_id;
-			map[i].cur = cur_id;
-			return true;
-		}
+	for (i = 0; i < idmap->cnt; i++) {
 		if (map[i].old == old_id)
 			return map[i].cur == cur_id;
 		if (map[i].cur == cur_id)
 			return false;
 	}
 	/* We ran out of idmap slots, which should be impossible */
-	WARN_ON_ONCE(1);
-	return false;
+	if (WARN_ON_ONCE(i == BPF_ID_MAP_SIZE))
+		return false;
+	/* Haven't seen this id before */
+	map[i].old = old_id;
+	map[i].cur = cur_id;
+	idmap->cnt++;
+	return true;
 }
 
 /* Similar to check_ids(), but allocate a unique temporary ID
@@ -18698,8 +18697,9 @@ static bool func_states_equal(struct bpf_verifier_env *env, struct bpf_func_stat
 
 static void reset_idmap_scratch(struct bpf_verifier_env *env)
 {
+	/* only the first ->cnt pairs are ever looked at */
 	env->idmap_scratch.tmp_id_gen = env->id_gen;
-	memset(&env->idmap_scratch.map, 0, sizeof(env->idmap_scratch.map));
+	env->idmap_scratch.cnt = 0;
 }
 
 static bool states_equal(struct bpf_verifier_env *env,
@@ -19978,6 +19978,7 @@ static int check_map_prog_compatibility(struct bpf_verifier_env *env,
 		case BPF_MAP_TYPE_QUEUE:
 		case BPF_MAP_TYPE_STACK:
 		case BPF_MAP_TYPE_ARENA:
+		case BPF_MAP_TYPE_FLAT_HASH:
 			break;
 		default:
 			verbose(env,
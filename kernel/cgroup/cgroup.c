@@ -43,6 +43,7 @@
 #include <linux/rcupdate.h>
 #include <linux/sched.h>
 #include <linux/sched/task.h>
+#include <linux/sizes.h>
 #include <linux/slab.h>
 #include <linux/spinlock.h>
 #include <linux/percpu-rwsem.h>
@@ -69,6 +70,13 @@
 /* let's not notify more than 100 times per second */
 #define CGROUP_FILE_NOTIFY_MIN_INTV	DIV_ROUND_UP(HZ, 100)
 
+/*
+ * cgroup.procs and cgroup.threads take a list of PIDs in one write.  Have
+ * kernfs hand it over in a single buffer rather than in PAGE_SIZE chunks,
+ * which could cut a PID in two.  Longer writes fail with -E2BIG.
+ */
+#define CGROUP_PROCS_WRITE_MAX		SZ_64K
+
 /*
  * To avoid confusing the compiler (and generating warnings) with code
  * that attempts to access what would be a 0-element array (i.e. sized
@@ -2960,33 +2968,17 @@ int cgroup_attach_task(struct cgroup *dst_cgrp, struct task_struct *leader,
 	return ret;
 }
 
-struct task_struct *cgroup_procs_write_start(char *buf, bool threadgroup,
-					     bool *threadgroup_locked)
+/* Look up the task to migrate for @pid, called with the attach lock held. */
+static struct task_struct *cgroup_procs_get_task(pid_t pid, bool threadgroup)
 {
 	struct task_struct *tsk;
-	pid_t pid;
-
-	if (kstrtoint(strstrip(buf), 0, &pid) || pid < 0)
-		return ERR_PTR(-EINVAL);
-
-	/*
-	 * If we migrate a single thread, we don't care about threadgroup
-	 * stability. If the thread is `current`, it won't exit(2) under our
-	 * hands or change PID through exec(2). We exclude
-	 * cgroup_update_dfl_csses and other cgroup_{proc,thread}s_write
-	 * callers by cgroup_mutex.
-	 * Therefore, we can skip the global lock.
-	 */
-	lockdep_assert_held(&cgroup_mutex);
-	*threadgroup_locked = pid || threadgroup;
-	cgroup_attach_lock(*threadgroup_locked);
 
 	rcu_read_lock();
 	if (pid) {
 		tsk = find_task_by_vpid(pid);
 		if (!tsk) {
 			tsk = ERR_PTR(-ESRCH);
-			goto out_unlock_threadgroup;
+			goto out_unlock_rcu;
 		}
 	} else {
 		tsk = current;
@@ -3003,33 +2995,62 @@ struct task_struct *cgroup_procs_write_start(char *buf, bool threadgroup,
 	 */
 	if (tsk->no_cgroup_migration || (tsk->flags & PF_NO_SETAFFINITY)) {
 		tsk = ERR_PTR(-EINVAL);
-		goto out_unlock_threadgroup;
+		goto out_unlock_rcu;
 	}
 
 	get_task_struct(tsk);
-	goto out_unlock_rcu;
-
-out_unlock_threadgroup:
-	cgroup_attach_unlock(*threadgroup_locked);
-	*threadgroup_locked = false;
 out_unlock_rcu:
 	rcu_read_unlock();
 	return tsk;
 }
 
-void cgroup_procs_write_finish(struct task_struct *task, bool threadgroup_locked)
+struct task_struct *cgroup_procs_write_start(char *buf, bool threadgroup,
+					     bool *threadgroup_locked)
+{
+	struct task_struct *tsk;
+	pid_t pid;
+
+	if (kstrtoint(strstrip(buf), 0, &pid) || pid < 0)
+		return ERR_PTR(-EINVAL);
+
+	/*
+	 * If we migrate a single thread, we don't care about threadgroup
+	 * stability. If the thread is `current`, it won't exit(2) under our
+	 * hands or change PID through exec(2). We exclude
+	 * cgroup_update_dfl_csses and other cgroup_{proc,thread}s_write
+	 * callers by cgroup_mutex.
+	 * Therefore, we can skip the global lock.
+	 */
+	lockdep_assert_held(&cgroup_mutex);
+	*threadgroup_locked = pid || threadgroup;
+	cgroup_attach_lock(*threadgroup_locked);
+
+	tsk = cgroup_procs_get_task(pid, threadgroup);
+	if (IS_ERR(tsk)) {
+		cgroup_attach_unlock(*threadgroup_locked);
+		*threadgroup_locked = false;
+	}
+	return tsk;
+}
+
+static void cgroup_post_attach(void)
 {
 	struct cgroup_subsys *ss;
 	int ssid;
 
+	for_each_subsys(ss, ssid)
+		if (ss->post_attach)
+			ss->post_attach();
+}
+
+void cgroup_procs_write_finish(struct task_struct *task, bool threadgroup_locked)
+{
 	/* release reference from cgroup_procs_write_start() */
 	put_task_struct(task);
 
 	cgroup_attach_unlock(threadgroup_locked);
 
-	for_each_subsys(ss, ssid)
-		if (ss->post_attach)
-			ss->post_attach();
+	cgroup_post_attach();
 }
 
 static void cgroup_print_ss_mask(struct seq_file *seq, u16 ss_mask)
@@ -5226,24 +5247,14 @@ static int cgroup_attach_permissions(struct cgroup *src_cgrp,
 	return ret;
 }
 
-static ssize_t __cgroup_procs_write(struct kernfs_open_file *of, char *buf,
-				    bool threadgroup)
+static int cgroup_procs_attach(struct kernfs_open_file *of,
+			       struct cgroup *dst_cgrp,
+			       struct task_struct *task, bool threadgroup)
 {
 	struct cgroup_file_ctx *ctx = of->priv;
-	struct cgroup *src_cgrp, *dst_cgrp;
-	struct task_struct *task;
 	const struct cred *saved_cred;
-	ssize_t ret;
-	bool threadgroup_locked;
-
-	dst_cgrp = cgroup_kn_lock_live(of->kn, false);
-	if (!dst_cgrp)
-		return -ENODEV;
-
-	task = cgroup_procs_write_start(buf, threadgroup, &threadgroup_locked);
-	ret = PTR_ERR_OR_ZERO(task);
-	if (ret)
-		goto out_unlock;
+	struct cgroup *src_cgrp;
+	int ret;
 
 	/* find the source cgroup */
 	spin_lock_irq(&css_set_lock);
@@ -5261,11 +5272,84 @@ static ssize_t __cgroup_procs_write(struct kernfs_open_file *of, char *buf,
 					threadgroup, ctx->ns);
 	revert_creds(saved_cred);
 	if (ret)
-		goto out_finish;
+		return ret;
 
-	ret = cgroup_attach_task(dst_cgrp, task, threadgroup);
+	return cgroup_attach_task(dst_cgrp, task, threadgroup);
+}
+
+/*
+ * Migrate every task of a whitespace-separated list of PIDs while holding
+ * the attach locks once, instead of dropping and retaking them, and with
+ * them cgroup_threadgroup_rwsem, for each one.  Stops at the first error;
+ * the tasks before it stay migrated.  Like a short write, the number of
+ * bytes of @start up to the failing PID is then returned, so that the
+ * caller can tell where to resume.  The error itself is only returned if
+ * no task was migrated.
+ */
+static ssize_t cgroup_procs_attach_list(struct kernfs_open_file *of,
+					struct cgroup *dst_cgrp, char *start,
+					char *buf, bool threadgroup)
+{
+	struct task_struct *task;
+	char *pidstr;
+	bool migrated = false;
+	int ret = 0;
+	pid_t pid;
+
+	cgroup_attach_lock(true);
+	while (!ret && (pidstr = strsep(&buf, " \t\n"))) {
+		if (!*pidstr)
+			continue;
+		if (kstrtoint(pidstr, 0, &pid) || pid < 0) {
+			ret = -EINVAL;
+			break;
+		}
+
+		task = cgroup_procs_get_task(pid, threadgroup);
+		if (IS_ERR(task)) {
+			ret = PTR_ERR(task);
+			break;
+		}
+		ret = cgroup_procs_attach(of, dst_cgrp, task, threadgroup);
+		put_task_struct(task);
+		if (!ret)
+			migrated = true;
+	}
+	cgroup_attach_unlock(true);
+
+	cgroup_post_attach();
+	if (ret && migrated)
+		return pidstr - start;
+	return ret;
+}
+
+static ssize_t __cgroup_procs_write(struct kernfs_open_file *of, char *buf,
+				    bool threadgroup)
+{
+	struct cgroup *dst_cgrp;
+	struct task_struct *task;
+	char *start = buf;
+	ssize_t ret;
+	bool threadgroup_locked;
+
+	dst_cgrp = cgroup_kn_lock_live(of->kn, false);
+	if (!dst_cgrp)
+		return -ENODEV;
+
+	buf = strstrip(buf);
+	if (strpbrk(buf, " \t\n")) {
+		ret = cgroup_procs_attach_list(of, dst_cgrp, start, buf,
+					       threadgroup);
+		goto out_unlock;
+	}
+
+	task = cgroup_procs_write_start(buf, threadgroup, &threadgroup_locked);
+	ret = PTR_ERR_OR_ZERO(task);
+	if (ret)
+		goto out_unlock;
+
+	ret = cgroup_procs_attach(of, dst_cgrp, task, threadgroup);
 
-out_finish:
 	cgroup_procs_write_finish(task, threadgroup_locked);
 out_unlock:
 	cgroup_kn_unlock(of->kn);
@@ -5307,6 +5391,7 @@ static struct cftype cgroup_base_files[] = {
 		.seq_next = cgroup_procs_next,
 		.seq_show = cgroup_procs_show,
 		.write = cgroup_procs_write,
+		.max_write_len = CGROUP_PROCS_WRITE_MAX,
 	},
 	{
 		.name = "cgroup.threads",
@@ -5316,6 +5401,7 @@ static struct cftype cgroup_base_files[] = {
 		.seq_next = cgroup_procs_next,
 		.seq_show = cgroup_procs_show,
 		.write = cgroup_threads_write,
+		.max_write_len = CGROUP_PROCS_WRITE_MAX,
 	},
 	{
 		.name = "cgroup.controllers",
@@ -137,6 +137,9 @@ int delayacct_add_tsk(struct taskstats *d, struct task_struct *tsk)
 	unsigned long long t2, t3;
 	unsigned long flags, t1;
 	s64 tmp;
+	int i;
+
+	BUILD_BUG_ON(TASKSTATS_CPU_DELAY_BUCKETS != SCHED_RUN_DELAY_BUCKETS);
 
 	task_cputime(tsk, &utime, &stime);
 	tmp = (s64)d->cpu_run_real_total;
@@ -161,6 +164,8 @@ int delayacct_add_tsk(struct taskstats *d, struct task_struct *tsk)
 
 	d->cpu_delay_max = tsk->sched_info.max_run_delay;
 	d->cpu_delay_min = tsk->sched_info.min_run_delay;
+	for (i = 0; i < TASKSTATS_CPU_DELAY_BUCKETS; i++)
+		d->cpu_delay_hist[i] += tsk->sched_info.run_delay_hist[i];
 	tmp = (s64)d->cpu_delay_total + t2;
 	d->cpu_delay_total = (tmp < (s64)d->cpu_delay_total) ? 0 : tmp;
 	tmp = (s64)d->cpu_run_virtual_total + t3;
@@ -966,6 +966,11 @@ static void dec_used(struct io_tlb_mem *mem, unsigned int nslots)
 	atomic_long_sub(nslots, &mem->total_used);
 }
 
+static void inc_area_contended(struct io_tlb_mem *mem)
+{
+	atomic_long_inc(&mem->area_contended);
+}
+
 #else /* !CONFIG_DEBUG_FS */
 static void inc_used_and_hiwater(struct io_tlb_mem *mem, unsigned int nslots)
 {
@@ -973,6 +978,9 @@ static void inc_used_and_hiwater(struct io_tlb_mem *mem, unsigned int nslots)
 static void dec_used(struct io_tlb_mem *mem, unsigned int nslots)
 {
 }
+static void inc_area_contended(struct io_tlb_mem *mem)
+{
+}
 #endif /* CONFIG_DEBUG_FS */
 
 #ifdef CONFIG_SWIOTLB_DYNAMIC
@@ -1006,16 +1014,18 @@ static void dec_transient_used(struct io_tlb_mem *mem, unsigned int nslots)
  * @alloc_size: Total requested size of the bounce buffer,
  *		including initial alignment padding.
  * @alloc_align_mask:	Required alignment of the allocated buffer.
+ * @trylock:	Give up instead of waiting if the area lock is held.
  *
  * Find a suitable sequence of IO TLB entries for the request and allocate
  * a buffer from the given IO TLB memory area.
  * This function takes care of locking.
  *
- * Return: Index of the first allocated slot, or -1 on error.
+ * Return: Index of the first allocated slot, -EBUSY if @trylock is set and
+ * the area is locked, or -1 on error.
  */
 static int swiotlb_search_pool_area(struct device *dev, struct io_tlb_pool *pool,
 		int area_index, phys_addr_t orig_addr, size_t alloc_size,
-		unsigned int alloc_align_mask)
+		unsigned int alloc_align_mask, bool trylock)
 {
 	struct io_tlb_area *area = pool->areas + area_index;
 	unsigned long boundary_mask = dma_get_seg_boundary(dev);
@@ -1058,7 +1068,12 @@ static int swiotlb_search_pool_area(struct device *dev, struct io_tlb_pool *pool
 	 */
 	stride = get_max_slots(max(alloc_align_mask, iotlb_align_mask));
 
-	spin_lock_irqsave(&area->lock, flags);
+	if (!trylock) {
+		spin_lock_irqsave(&area->lock, flags);
+	} else if (!spin_trylock_irqsave(&area->lock, flags)) {
+		inc_area_contended(dev->dma_io_tlb_mem);
+		return -EBUSY;
+	}
 	if (unlikely(nslots > pool->area_nslabs - area->used))
 		goto not_found;
 
@@ -1131,21 +1146,24 @@ static int swiotlb_search_pool_area(struct device *dev, struct io_tlb_pool *pool
  * @alloc_size: Total requested size of the bounce buffer,
  *		including initial alignment padding.
  * @alloc_align_mask:	Required alignment of the allocated buffer.
+ * @trylock:	Skip areas whose lock is held.
  * @retpool:	Used memory pool, updated on return.
  *
  * Search one memory area in all pools for a sequence of slots that match the
  * allocation constraints.
  *
- * Return: Index of the first allocated slot, or -1 on error.
+ * Return: Index of the first allocated slot, -EBUSY if @trylock is set and
+ * an area was skipped, or -1 on error.
  */
 static int swiotlb_search_area(struct device *dev, int start_cpu,
 		int cpu_offset, phys_addr_t orig_addr, size_t alloc_size,
-		unsigned int alloc_align_mask, struct io_tlb_pool **retpool)
+		unsigned int alloc_align_mask, bool trylock,
+		struct io_tlb_pool **retpool)
 {
 	struct io_tlb_mem *mem = dev->dma_io_tlb_mem;
 	struct io_tlb_pool *pool;
 	int area_index;
-	int index = -1;
+	int index, ret = -1;
 
 	rcu_read_lock();
 	list_for_each_entry_rcu(pool, &mem->pools, node) {
@@ -1154,14 +1172,17 @@ static int swiotlb_search_area(struct device *dev, int start_cpu,
 		area_index = (start_cpu + cpu_offset) & (pool->nareas - 1);
 		index = swiotlb_search_pool_area(dev, pool, area_index,
 						 orig_addr, alloc_size,
-						 alloc_align_mask);
+						 alloc_align_mask, trylock);
 		if (index >= 0) {
 			*retpool = pool;
+			ret = index;
 			break;
 		}
+		if (index == -EBUSY)
+			ret = -EBUSY;
 	}
 	rcu_read_unlock();
-	return index;
+	return ret;
 }
 
 /**
@@ -1187,16 +1208,29 @@ static int swiotlb_find_slots(struct device *dev, phys_addr_t orig_addr,
 	unsigned long nslabs;
 	unsigned long flags;
 	u64 phys_limit;
+	bool skipped = false;
 	int cpu, i;
 	int index;
 
 	if (alloc_size > IO_TLB_SEGSIZE * IO_TLB_SIZE)
 		return -1;
 
+	/*
+	 * Rather than spinning on the local area while another CPU holds it,
+	 * first try the areas that nobody is searching right now.
+	 */
 	cpu = raw_smp_processor_id();
 	for (i = 0; i < default_nareas; ++i) {
 		index = swiotlb_search_area(dev, cpu, i, orig_addr, alloc_size,
-					    alloc_align_mask, &pool);
+					    alloc_align_mask, true, &pool);
+		if (index >= 0)
+			goto found;
+		if (index == -EBUSY)
+			skipped = true;
+	}
+	for (i = 0; skipped && i < default_nareas; ++i) {
+		index = swiotlb_search_area(dev, cpu, i, orig_addr, alloc_size,
+					    alloc_align_mask, false, &pool);
 		if (index >= 0)
 			goto found;
 	}
@@ -1214,7 +1248,7 @@ static int swiotlb_find_slots(struct device *dev, phys_addr_t orig_addr,
 		return -1;
 
 	index = swiotlb_search_pool_area(dev, pool, 0, orig_addr,
-					 alloc_size, alloc_align_mask);
+					 alloc_size, alloc_align_mask, false);
 	if (index < 0) {
 		swiotlb_dyn_free(&pool->rcu);
 		return -1;
@@ -1259,20 +1293,31 @@ static int swiotlb_find_slots(struct device *dev, phys_addr_t orig_addr,
 		struct io_tlb_pool **retpool)
 {
 	struct io_tlb_pool *pool;
+	bool trylock, skipped;
 	int start, i;
 	int index;
 
 	*retpool = pool = &dev->dma_io_tlb_mem->defpool;
-	i = start = raw_smp_processor_id() & (pool->nareas - 1);
-	do {
-		index = swiotlb_search_pool_area(dev, pool, i, orig_addr,
-						 alloc_size, alloc_align_mask);
-		if (index >= 0)
-			return index;
-		if (++i >= pool->nareas)
-			i = 0;
-	} while (i != start);
-	return -1;
+	start = raw_smp_processor_id() & (pool->nareas - 1);
+
+	/* Skip busy areas first, then wait for them if nothing else fits. */
+	for (trylock = true; ; trylock = false) {
+		skipped = false;
+		i = start;
+		do {
+			index = swiotlb_search_pool_area(dev, pool, i,
+					orig_addr, alloc_size,
+					alloc_align_mask, trylock);
+			if (index >= 0)
+				return index;
+			if (index == -EBUSY)
+				skipped = true;
+			if (++i >= pool->nareas)
+				i = 0;
+		} while (i != start);
+		if (!trylock || !skipped)
+			return -1;
+	}
 }
 
 #endif /* CONFIG_SWIOTLB_DYNAMIC */
@@ -1707,9 +1752,19 @@ static int io_tlb_hiwater_set(void *data, u64 val)
 	return 0;
 }
 
+static int io_tlb_area_contended_get(void *data, u64 *val)
+{
+	struct io_tlb_mem *mem = data;
+
+	*val = atomic_long_read(&mem->area_contended);
+	return 0;
+}
+
 DEFINE_DEBUGFS_ATTRIBUTE(fops_io_tlb_used, io_tlb_used_get, NULL, "%llu\n");
 DEFINE_DEBUGFS_ATTRIBUTE(fops_io_tlb_hiwater, io_tlb_hiwater_get,
 				io_tlb_hiwater_set, "%llu\n");
+DEFINE_DEBUGFS_ATTRIBUTE(fops_io_tlb_area_contended, io_tlb_area_contended_get,
+			 NULL, "%llu\n");
 
 static void swiotlb_create_debugfs_files(struct io_tlb_mem *mem,
 					 const char *dirname)
@@ -1723,6 +1778,8 @@ static void swiotlb_create_debugfs_files(struct io_tlb_mem *mem,
 			&fops_io_tlb_used);
 	debugfs_create_file("io_tlb_used_hiwater", 0600, mem->debugfs, mem,
 			&fops_io_tlb_hiwater);
+	debugfs_create_file("io_tlb_area_contended", 0400, mem->debugfs, mem,
+			&fops_io_tlb_area_contended);
 #ifdef CONFIG_SWIOTLB_DYNAMIC
 	debugfs_create_file("io_tlb_transient_nslabs", 0400, mem->debugfs,
 			    mem, &fops_io_tlb_transient_used);
@@ -56,6 +56,7 @@
 #include <linux/buildid.h>
 #include <linux/task_work.h>
 #include <linux/percpu-rwsem.h>
+#include <linux/jhash.h>
 
 #include "internal.h"
 
@@ -791,6 +792,9 @@ static void perf_ctx_enable(struct perf_event_context *ctx, bool cgroup)
 
 static void ctx_sched_out(struct perf_event_context *ctx, struct pmu *pmu, enum event_type_t event_type);
 static void ctx_sched_in(struct perf_event_context *ctx, struct pmu *pmu, enum event_type_t event_type);
+static inline void __ctx_time_update(struct perf_cpu_context *cpuctx,
+				     struct perf_event_context *ctx, bool final);
+static void perf_aggr_flush(struct perf_event *event);
 
 #ifdef CONFIG_CGROUP_PERF
 
@@ -923,6 +927,22 @@ perf_cgroup_set_timestamp(struct perf_cpu_context *cpuctx)
 	}
 }
 
+/*
+ * Whether an event on this CPU counts for tasks in @cgrp, which is the case
+ * for events of @cgrp and of its ancestors.
+ */
+static bool perf_cgroup_has_events(struct perf_cgroup *cgrp)
+{
+	struct cgroup_subsys_state *css;
+
+	for (css = &cgrp->css; css; css = css->parent) {
+		cgrp = container_of(css, struct perf_cgroup, css);
+		if (this_cpu_ptr(cgrp->info)->nr_events)
+			return true;
+	}
+	return false;
+}
+
 /*
  * reschedule events based on the cgroup constraint of task.
  */
@@ -945,6 +965,22 @@ static void perf_cgroup_switch(struct task_struct *task)
 		return;
 
 	perf_ctx_lock(cpuctx, cpuctx->task_ctx);
+
+	/*
+	 * When no event here counts for either cgroup, the switch changes
+	 * nothing on the PMU: only hand the cgroup time over, the way
+	 * ctx_sched_out() and ctx_sched_in() would.
+	 */
+	if (!perf_cgroup_has_events(cpuctx->cgrp) &&
+	    !perf_cgroup_has_events(cgrp)) {
+		__ctx_time_update(cpuctx, &cpuctx->ctx, true);
+		cpuctx->cgrp = cgrp;
+		if (cpuctx->ctx.is_active & EVENT_TIME)
+			perf_cgroup_set_timestamp(cpuctx);
+		perf_ctx_unlock(cpuctx, cpuctx->task_ctx);
+		return;
+	}
+
 	perf_ctx_disable(&cpuctx->ctx, true);
 
 	ctx_sched_out(&cpuctx->ctx, NULL, EVENT_ALL|EVENT_CGROUP);
@@ -1051,6 +1087,7 @@ perf_cgroup_event_enable(struct perf_event *event, struct perf_event_context *ct
 		return;
 
 	event->pmu_ctx->nr_cgroups++;
+	per_cpu_ptr(event->cgrp->info, event->cpu)->nr_events++;
 
 	/*
 	 * Because cgroup events are always per-cpu events,
@@ -1073,6 +1110,7 @@ perf_cgroup_event_disable(struct perf_event *event, struct perf_event_context *c
 		return;
 
 	event->pmu_ctx->nr_cgroups--;
+	per_cpu_ptr(event->cgrp->info, event->cpu)->nr_events--;
 
 	/*
 	 * Because cgroup events are always per-cpu events,
@@ -2483,6 +2521,8 @@ __perf_remove_from_context(struct perf_event *event,
 	}
 	event_sched_out(event, ctx);
 	perf_event_set_state(event, min(event->state, state));
+	/* on close and on child exit, before the counts are freed */
+	perf_aggr_flush(event);
 	if (flags & DETACH_GROUP)
 		perf_group_detach(event);
 	if (flags & DETACH_CHILD)
@@ -2568,6 +2608,8 @@ static void __perf_event_disable(struct perf_event *event,
 	perf_cgroup_event_disable(event, ctx);
 
 	perf_pmu_enable(event->pmu_ctx->pmu);
+
+	perf_aggr_flush(event);
 }
 
 /*
@@ -5525,6 +5567,7 @@ static void __free_event(struct perf_event *event)
 		put_callchain_buffers();
 
 	kfree(event->addr_filter_ranges);
+	kvfree(event->sample_aggr);
 
 	if (event->attach_state & PERF_ATTACH_EXCLUSIVE)
 		exclusive_event_destroy(event);
@@ -8389,6 +8432,199 @@ perf_event_output(struct perf_event *event,
 	return __perf_event_output(event, data, regs, perf_output_begin);
 }
 
+/*
+ * Sample aggregation, attr.aggregate: instead of a PERF_RECORD_SAMPLE per
+ * sample, count the samples of each (tid, callchain) in a small direct
+ * mapped table and emit PERF_RECORD_SAMPLE_COUNT records with the counts.
+ * The table belongs to the event and is only used from its overflow
+ * handler, busy keeps out the rare flush from elsewhere.
+ */
+#define PERF_AGGR_SLOTS		64
+#define PERF_AGGR_FLUSH_NS	NSEC_PER_SEC
+
+struct perf_aggr_slot {
+	u64				count;
+	u64				period;
+	u32				hash;
+	u32				pid;
+	u32				tid;
+	u32				nr;
+	u64				ips[];
+};
+
+struct perf_sample_aggr {
+	atomic_t			busy;
+	u32				max_nr;
+	size_t				slot_size;
+	u64				last_flush;
+	char				slots[];
+};
+
+struct perf_sample_count_event {
+	struct perf_event_header	header;
+	u32				pid;
+	u32				tid;
+	u64				count;
+	u64				period;
+	u64				nr;
+};
+
+static struct perf_aggr_slot *perf_aggr_slot(struct perf_sample_aggr *aggr,
+					     u32 hash)
+{
+	return (void *)aggr->slots + (hash % PERF_AGGR_SLOTS) * aggr->slot_size;
+}
+
+static void perf_aggr_emit(struct perf_event *event,
+			   struct perf_aggr_slot *slot)
+{
+	struct perf_sample_count_event rec = {
+		.header = {
+			.type = PERF_RECORD_SAMPLE_COUNT,
+			.misc = 0,
+			.size = sizeof(rec) + slot->nr * sizeof(u64),
+		},
+		.pid	= slot->pid,
+		.tid	= slot->tid,
+		.count	= slot->count,
+		.period	= slot->period,
+		.nr	= slot->nr,
+	};
+	struct perf_output_handle handle;
+	struct perf_sample_data sample;
+
+	slot->count = 0;
+	slot->period = 0;
+
+	perf_event_header__init_id(&rec.header, &sample, event);
+	if (perf_output_begin(&handle, &sample, event, rec.header.size))
+		return;
+
+	perf_output_put(&handle, rec);
+	__output_copy(&handle, slot->ips, slot->nr * sizeof(u64));
+	perf_event__output_id_sample(event, &handle, &sample);
+
+	perf_output_end(&handle);
+}
+
+static void __perf_aggr_flush(struct perf_event *event,
+			      struct perf_sample_aggr *aggr)
+{
+	struct perf_aggr_slot *slot;
+	int i;
+
+	for (i = 0; i < PERF_AGGR_SLOTS; i++) {
+		slot = perf_aggr_slot(aggr, i);
+		if (slot->count)
+			perf_aggr_emit(event, slot);
+	}
+}
+
+static void perf_aggr_flush(struct perf_event *event)
+{
+	struct perf_sample_aggr *aggr = event->sample_aggr;
+
+	if (!aggr || atomic_cmpxchg_acquire(&aggr->busy, 0, 1))
+		return;
+
+	__perf_aggr_flush(event, aggr);
+	atomic_set_release(&aggr->busy, 0);
+}
+
+static void
+perf_event_output_aggregate(struct perf_event *event,
+			    struct perf_sample_data *data,
+			    struct pt_regs *regs)
+{
+	struct perf_sample_aggr *aggr = event->sample_aggr;
+	struct perf_callchain_entry *callchain;
+	struct perf_aggr_slot *slot;
+	u32 hash;
+	u64 now;
+
+	if (atomic_cmpxchg_acquire(&aggr->busy, 0, 1))
+		goto output;
+
+	/* protect the callchain buffers */
+	rcu_read_lock();
+	perf_prepare_sample(data, event, regs);
+	callchain = data->callchain;
+	if (unlikely(callchain->nr > aggr->max_nr)) {
+		rcu_read_unlock();
+		atomic_set_release(&aggr->busy, 0);
+		goto output;
+	}
+
+	hash = jhash2((u32 *)callchain->ip, callchain->nr * 2,
+		      data->tid_entry.tid);
+	slot = perf_aggr_slot(aggr, hash);
+	if (slot->count && slot->hash == hash &&
+	    slot->pid == data->tid_entry.pid &&
+	    slot->tid == data->tid_entry.tid && slot->nr == callchain->nr &&
+	    !memcmp(slot->ips, callchain->ip, callchain->nr * sizeof(u64))) {
+		slot->count++;
+		slot->period += data->period;
+	} else {
+		if (slot->count)
+			perf_aggr_emit(event, slot);
+		slot->hash = hash;
+		slot->pid = data->tid_entry.pid;
+		slot->tid = data->tid_entry.tid;
+		slot->nr = callchain->nr;
+		memcpy(slot->ips, callchain->ip, callchain->nr * sizeof(u64));
+		slot->count = 1;
+		slot->period = data->period;
+	}
+	rcu_read_unlock();
+
+	now = local_clock();
+	if (now - aggr->last_flush >= PERF_AGGR_FLUSH_NS) {
+		__perf_aggr_flush(event, aggr);
+		aggr->last_flush = now;
+	}
+
+	atomic_set_release(&aggr->busy, 0);
+	return;
+
+output:
+	/* nested in a flush, or a callchain too deep to fit: emit as is */
+	perf_event_output_forward(event, data, regs);
+}
+
+static int perf_aggr_init(struct perf_event *event)
+{
+	struct perf_event_attr *attr = &event->attr;
+	struct perf_sample_aggr *aggr;
+	size_t slot_size;
+	u32 max_nr;
+
+	if (!is_sampling_event(event) || is_write_backward(event))
+		return -EINVAL;
+	if ((attr->sample_type & (PERF_SAMPLE_CALLCHAIN | PERF_SAMPLE_TID)) !=
+	    (PERF_SAMPLE_CALLCHAIN | PERF_SAMPLE_TID))
+		return -EINVAL;
+
+	/*
+	 * perf_callchain() stores at most sample_max_stack entries plus one
+	 * context marker for each of the kernel and user parts it records.
+	 * Size the slots for that rather than for the system-wide limits, so
+	 * that a small sample_max_stack buys a small table.
+	 */
+	max_nr = attr->sample_max_stack + !attr->exclude_callchain_kernel +
+		 !attr->exclude_callchain_user;
+	slot_size = struct_size_t(struct perf_aggr_slot, ips, max_nr);
+	aggr = kvzalloc(struct_size(aggr, slots, PERF_AGGR_SLOTS * slot_size),
+			GFP_KERNEL_ACCOUNT);
+	if (!aggr)
+		return -ENOMEM;
+
+	aggr->max_nr = max_nr;
+	aggr->slot_size = slot_size;
+	aggr->last_flush = local_clock();
+	event->sample_aggr = aggr;
+	return 0;
+}
+
 /*
  * read event_id
  */
@@ -12637,6 +12873,9 @@ perf_event_alloc(struct perf_event_attr *attr, int cpu,
 	if (overflow_handler) {
 		event->overflow_handler	= overflow_handler;
 		event->overflow_handler_context = context;
+	} else if (attr->aggregate) {
+		event->overflow_handler = perf_event_output_aggregate;
+		event->overflow_handler_context = NULL;
 	} else if (is_write_backward(event)){
 		event->overflow_handler = perf_event_output_backward;
 		event->overflow_handler_context = NULL;
@@ -12647,6 +12886,12 @@ perf_event_alloc(struct perf_event_attr *attr, int cpu,
 
 	perf_event__state_init(event);
 
+	if (attr->aggregate) {
+		err = perf_aggr_init(event);
+		if (err)
+			return ERR_PTR(err);
+	}
+
 	pmu = NULL;
 
 	hwc = &event->hw;
@@ -85,6 +85,20 @@
  */
 static unsigned int oops_limit = 10000;
 
+/*
+ * An exiting task whose address space has at least this many resident pages
+ * leaves the teardown to a worker, so that its parent and whoever waits for
+ * it to be reaped are not held up for the whole time.  0 disables this.
+ *
+ * Note that this changes what waitpid() returning guarantees: the worker
+ * may still hold the executable and the mapped files, and the memory is
+ * still charged, for a while after the task was reaped.  Writing to the
+ * executable can then fail with ETXTBSY and unmounting the filesystem
+ * with EBUSY, so only enable this where nothing relies on those being
+ * released by the time the parent's wait returns.
+ */
+static unsigned long exit_mm_async_pages;
+
 #ifdef CONFIG_SYSCTL
 static const struct ctl_table kern_exit_table[] = {
 	{
@@ -94,6 +108,13 @@ static const struct ctl_table kern_exit_table[] = {
 		.mode           = 0644,
 		.proc_handler   = proc_douintvec,
 	},
+	{
+		.procname       = "exit_mm_async_pages",
+		.data           = &exit_mm_async_pages,
+		.maxlen         = sizeof(exit_mm_async_pages),
+		.mode           = 0644,
+		.proc_handler   = proc_doulongvec_minmax,
+	},
 };
 
 static __init int kernel_exit_sysctls_init(void)
@@ -551,6 +572,21 @@ void mm_update_next_owner(struct mm_struct *mm)
 }
 #endif /* CONFIG_MEMCG */
 
+static void exit_mmput(struct mm_struct *mm)
+{
+#ifdef CONFIG_MMU
+	unsigned long async_pages = READ_ONCE(exit_mm_async_pages);
+
+	/* the oom_reaper already takes care of the memory of OOM victims */
+	if (async_pages && !test_thread_flag(TIF_MEMDIE) &&
+	    get_mm_rss(mm) >= async_pages) {
+		mmput_async(mm);
+		return;
+	}
+#endif
+	mmput(mm);
+}
+
 /*
  * Turn us into a lazy TLB process if we
  * aren't already..
@@ -586,7 +622,7 @@ static void exit_mm(void)
 	task_unlock(current);
 	mmap_read_unlock(mm);
 	mm_update_next_owner(mm);
-	mmput(mm);
+	exit_mmput(mm);
 	if (test_thread_flag(TIF_MEMDIE))
 		exit_oom_victim();
 }
@@ -38,6 +38,7 @@
 #include <linux/plist.h>
 #include <linux/memblock.h>
 #include <linux/fault-inject.h>
+#include <linux/prctl.h>
 #include <linux/slab.h>
 
 #include "futex.h"
@@ -55,6 +56,19 @@ static struct {
 #define futex_queues   (__futex_data.queues)
 #define futex_hashmask (__futex_data.hashmask)
 
+/*
+ * A process can ask for its private futexes to be hashed into buckets of
+ * its own, allocated on the node it runs on, instead of sharing the global
+ * table with everybody else.  The buckets live as long as the mm.
+ */
+struct futex_private_hash {
+	unsigned long			hashmask;
+	struct futex_hash_bucket	queues[];
+};
+
+#define FUTEX_PRIVATE_HASH_MIN	16
+#define FUTEX_PRIVATE_HASH_MAX	(1UL << 16)
+
 
 /*
  * Fault injections for futexes.
@@ -118,10 +132,91 @@ struct futex_hash_bucket *futex_hash(union futex_key *key)
 {
 	u32 hash = jhash2((u32 *)key, offsetof(typeof(*key), both.offset) / 4,
 			  key->both.offset);
+	struct futex_private_hash *fph;
+
+	if (!(key->both.offset & (FUT_OFF_INODE | FUT_OFF_MMSHARED))) {
+		fph = READ_ONCE(key->private.mm->futex_phash);
+		if (fph)
+			return &fph->queues[hash & fph->hashmask];
+	}
 
 	return &futex_queues[hash & futex_hashmask];
 }
 
+static int futex_private_hash_set(unsigned long slots)
+{
+	struct mm_struct *mm = current->mm;
+	struct futex_private_hash *fph;
+	unsigned long i;
+
+	if (!slots)
+		slots = 4 * num_online_cpus();
+	slots = roundup_pow_of_two(clamp_t(unsigned long, slots,
+					   FUTEX_PRIVATE_HASH_MIN,
+					   FUTEX_PRIVATE_HASH_MAX));
+
+	/*
+	 * Futexes already queued in the global table would be missed by
+	 * wakers looking in the new one, so only a process that cannot have
+	 * any waiters yet may switch: no other thread or CLONE_VM child, and
+	 * no io_uring that could have a futex wait pending.
+	 */
+	if (READ_ONCE(mm->futex_phash))
+		return -EBUSY;
+	if (atomic_read(&mm->mm_users) > 1)
+		return -EBUSY;
+#ifdef CONFIG_IO_URING
+	if (current->io_uring)
+		return -EBUSY;
+#endif
+
+	fph = kvzalloc_node(struct_size(fph, queues, slots),
+			    GFP_KERNEL_ACCOUNT, numa_node_id());
+	if (!fph)
+		return -ENOMEM;
+	for (i = 0; i < slots; i++) {
+		atomic_set(&fph->queues[i].waiters, 0);
+		plist_head_init(&fph->queues[i].chain);
+		spin_lock_init(&fph->queues[i].lock);
+	}
+	fph->hashmask = slots - 1;
+
+	if (cmpxchg(&mm->futex_phash, NULL, fph)) {
+		kvfree(fph);
+		return -EBUSY;
+	}
+	return 0;
+}
+
+int futex_hash_prctl(int option, unsigned long arg2)
+{
+	struct futex_private_hash *fph;
+
+	if (!current->mm)
+		return -EINVAL;
+
+	switch (option) {
+	case PR_SET_FUTEX_HASH:
+		return futex_private_hash_set(arg2);
+	case PR_GET_FUTEX_HASH:
+		fph = READ_ONCE(current->mm->futex_phash);
+		return fph ? fph->hashmask + 1 : 0;
+	}
+	return -EINVAL;
+}
+
+void futex_mm_init(struct mm_struct *mm)
+{
+	mm->futex_phash = NULL;
+}
+
+void futex_mm_free(struct mm_struct *mm)
+{
+	kvfree(mm->futex_phash);
+	/* the mm itself lives on until the last mmdrop() */
+	mm->futex_phash = NULL;
+}
+
 
 /**
  * futex_setup_timer - set up the sleeping hrtimer.
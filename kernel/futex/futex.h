@@ -436,6 +436,12 @@ extern int futex_wait_multiple(struct futex_vector *vs, unsigned int count,
 
 extern int futex_wake(u32 __user *uaddr, unsigned int flags, int nr_wake, u32 bitset);
 
+extern int futex_parse_wakev(struct futex_waitv *ws,
+			     struct futex_waitv __user *uwaitv,
+			     unsigned int nr_futexes);
+
+extern int futex_wake_multiple(struct futex_waitv *ws, unsigned int count);
+
 extern int futex_wake_op(u32 __user *uaddr1, unsigned int flags,
 			 u32 __user *uaddr2, int nr_wake, int nr_wake2, int op);
 
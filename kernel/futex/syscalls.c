@@ -224,6 +224,37 @@ int futex_parse_waitv(struct futex_vector *futexv,
 	return 0;
 }
 
+/**
+ * futex_parse_wakev - Copy in and check a list of futexes to wake
+ * @ws:		Kernel side list to be filled
+ * @uwaitv:	Userspace list, each val being the number of waiters to wake
+ * @nr_futexes:	Length of the list
+ *
+ * The flags of each entry are converted to FLAGS_* on the way.
+ *
+ * Return: Error code on failure, 0 on success
+ */
+int futex_parse_wakev(struct futex_waitv *ws,
+		      struct futex_waitv __user *uwaitv,
+		      unsigned int nr_futexes)
+{
+	unsigned int i;
+
+	if (copy_from_user(ws, uwaitv, nr_futexes * sizeof(*ws)))
+		return -EFAULT;
+
+	for (i = 0; i < nr_futexes; i++) {
+		if ((ws[i].flags & ~FUTEX2_VALID_MASK) || ws[i].__reserved)
+			return -EINVAL;
+
+		ws[i].flags = futex2_to_flags(ws[i].flags);
+		if (!futex_flags_valid(ws[i].flags))
+			return -EINVAL;
+	}
+
+	return 0;
+}
+
 static int futex2_setup_timeout(struct __kernel_timespec __user *timeout,
 				clockid_t clockid, struct hrtimer_sleeper *to)
 {
@@ -324,6 +355,44 @@ SYSCALL_DEFINE5(futex_waitv, struct futex_waitv __user *, waiters,
 	return ret;
 }
 
+/**
+ * sys_futex_wakev - Wake waiters on a list of futexes
+ * @waiters:	List of futexes to wake; the val of each is the number of
+ *		waiters to wake on it
+ * @nr_futexes:	Length of the list
+ * @flags:	No flags are defined yet
+ *
+ * Does a futex_wake() of every futex in the list, with individual flags for
+ * each, but schedules all the woken tasks only after the last hash bucket
+ * lock was dropped.
+ *
+ * Returns the total number of woken waiters, or the error of the first futex
+ * that could not be woken; the futexes before it have been woken anyway.
+ */
+SYSCALL_DEFINE3(futex_wakev, struct futex_waitv __user *, waiters,
+		unsigned int, nr_futexes, unsigned int, flags)
+{
+	struct futex_waitv *ws;
+	int ret;
+
+	if (flags)
+		return -EINVAL;
+
+	if (!nr_futexes || nr_futexes > FUTEX_WAITV_MAX || !waiters)
+		return -EINVAL;
+
+	ws = kmalloc_array(nr_futexes, sizeof(*ws), GFP_KERNEL);
+	if (!ws)
+		return -ENOMEM;
+
+	ret = futex_parse_wakev(ws, waiters, nr_futexes);
+	if (!ret)
+		ret = futex_wake_multiple(ws, nr_futexes);
+
+	kfree(ws);
+	return ret;
+}
+
 /*
  * sys_futex_wake - Wake a number of futexes
  * @uaddr:	Address of the futex(es) to wake
@@ -152,12 +152,12 @@ void futex_wake_mark(struct wake_q_head *wake_q, struct futex_q *q)
 /*
  * Wake up waiters matching bitset queued on this futex (uaddr).
  */
-int futex_wake(u32 __user *uaddr, unsigned int flags, int nr_wake, u32 bitset)
+static int __futex_wake(u32 __user *uaddr, unsigned int flags, int nr_wake,
+			u32 bitset, struct wake_q_head *wake_q)
 {
 	struct futex_hash_bucket *hb;
 	struct futex_q *this, *next;
 	union futex_key key = FUTEX_KEY_INIT;
-	DEFINE_WAKE_Q(wake_q);
 	int ret;
 
 	if (!bitset)
@@ -189,17 +189,57 @@ int futex_wake(u32 __user *uaddr, unsigned int flags, int nr_wake, u32 bitset)
 			if (!(this->bitset & bitset))
 				continue;
 
-			this->wake(&wake_q, this);
+			this->wake(wake_q, this);
 			if (++ret >= nr_wake)
 				break;
 		}
 	}
 
 	spin_unlock(&hb->lock);
+	return ret;
+}
+
+int futex_wake(u32 __user *uaddr, unsigned int flags, int nr_wake, u32 bitset)
+{
+	DEFINE_WAKE_Q(wake_q);
+	int ret;
+
+	ret = __futex_wake(uaddr, flags, nr_wake, bitset, &wake_q);
 	wake_up_q(&wake_q);
 	return ret;
 }
 
+/**
+ * futex_wake_multiple - Wake waiters on a list of futexes
+ * @ws:		List of futexes, as returned by futex_parse_wakev()
+ * @count:	Length of @ws
+ *
+ * Wakes up to @ws[i].val waiters on each futex.  The woken tasks are only
+ * scheduled once the last hash bucket lock has been dropped.
+ *
+ * Return: The total number of woken waiters, or the error of the first
+ * futex that failed; the futexes before it have been woken nonetheless.
+ */
+int futex_wake_multiple(struct futex_waitv *ws, unsigned int count)
+{
+	DEFINE_WAKE_Q(wake_q);
+	int ret = 0, woken = 0;
+	unsigned int i;
+
+	for (i = 0; i < count; i++) {
+		ret = __futex_wake(u64_to_user_ptr(ws[i].uaddr),
+				   FLAGS_STRICT | ws[i].flags,
+				   min_t(u64, ws[i].val, INT_MAX),
+				   FUTEX_BITSET_MATCH_ANY, &wake_q);
+		if (ret < 0)
+			break;
+		woken += ret;
+	}
+
+	wake_up_q(&wake_q);
+	return ret < 0 ? ret : woken;
+}
+
 static int futex_atomic_op_inuser(unsigned int encoded_op, u32 __user *uaddr)
 {
 	unsigned int op =	  (encoded_op & 0x70000000) >> 28;
@@ -11,7 +11,7 @@
  *          Peter Zijlstra <peterz@infradead.org>
  */
 
-#ifndef _GEN_PV_LOCK_SLOWPATH
+#if !defined(_GEN_PV_LOCK_SLOWPATH) && !defined(_GEN_CNA_LOCK_SLOWPATH)
 
 #include <linux/smp.h>
 #include <linux/bug.h>
@@ -20,6 +20,7 @@
 #include <linux/hardirq.h>
 #include <linux/mutex.h>
 #include <linux/prefetch.h>
+#include <linux/jump_label.h>
 #include <asm/byteorder.h>
 #include <asm/qspinlock.h>
 #include <trace/events/lock.h>
@@ -100,11 +101,43 @@ static __always_inline u32  __pv_wait_head_or_lock(struct qspinlock *lock,
 #define pv_kick_node		__pv_kick_node
 #define pv_wait_head_or_lock	__pv_wait_head_or_lock
 
+/*
+ * Queue ordering hooks, plain MCS unless generating the NUMA-aware code.
+ */
+static __always_inline void __mcs_init_node(struct mcs_spinlock *node,
+					    u32 tail) { }
+static __always_inline void __mcs_order_queue(struct mcs_spinlock *node,
+					      struct mcs_spinlock **pnext) { }
+static __always_inline bool __mcs_try_clear_tail(struct qspinlock *lock,
+						 u32 val,
+						 struct mcs_spinlock *node)
+{
+	return atomic_try_cmpxchg_relaxed(&lock->val, &val, _Q_LOCKED_VAL);
+}
+static __always_inline void __mcs_pass_lock(struct mcs_spinlock *node,
+					    struct mcs_spinlock *next)
+{
+	arch_mcs_spin_unlock_contended(&next->locked);
+}
+
+#define mcs_init_node		__mcs_init_node
+#define mcs_order_queue		__mcs_order_queue
+#define mcs_try_clear_tail	__mcs_try_clear_tail
+#define mcs_pass_lock		__mcs_pass_lock
+
+#ifdef CONFIG_NUMA_AWARE_SPINLOCKS
+static DEFINE_STATIC_KEY_FALSE(numa_spinlock_key);
+void __cna_queued_spin_lock_slowpath(struct qspinlock *lock, u32 val);
+#define cna_enabled()	static_branch_unlikely(&numa_spinlock_key)
+#else
+#define cna_enabled()	false
+#endif
+
 #ifdef CONFIG_PARAVIRT_SPINLOCKS
 #define queued_spin_lock_slowpath	native_queued_spin_lock_slowpath
 #endif
 
-#endif /* _GEN_PV_LOCK_SLOWPATH */
+#endif /* !_GEN_PV_LOCK_SLOWPATH && !_GEN_CNA_LOCK_SLOWPATH */
 
 /**
  * queued_spin_lock_slowpath - acquire the queued spinlock
@@ -138,6 +171,11 @@ void __lockfunc queued_spin_lock_slowpath(struct qspinlock *lock, u32 val)
 	if (pv_enabled())
 		goto pv_queue;
 
+	if (cna_enabled()) {
+		__cna_queued_spin_lock_slowpath(lock, val);
+		return;
+	}
+
 	if (virt_spin_lock(lock))
 		return;
 
@@ -251,6 +289,7 @@ void __lockfunc queued_spin_lock_slowpath(struct qspinlock *lock, u32 val)
 	node->locked = 0;
 	node->next = NULL;
 	pv_init_node(node);
+	mcs_init_node(node, tail);
 
 	/*
 	 * We touched a (possibly) cold cacheline in the per-cpu queue node;
@@ -301,6 +340,9 @@ void __lockfunc queued_spin_lock_slowpath(struct qspinlock *lock, u32 val)
 			prefetchw(next);
 	}
 
+	/* The NUMA-aware code may reorder the waiters behind us. */
+	mcs_order_queue(node, &next);
+
 	/*
 	 * we're at the head of the waitqueue, wait for the owner & pending to
 	 * go away.
@@ -350,7 +392,7 @@ void __lockfunc queued_spin_lock_slowpath(struct qspinlock *lock, u32 val)
 	 *       PENDING will make the uncontended transition fail.
 	 */
 	if ((val & _Q_TAIL_MASK) == tail) {
-		if (atomic_try_cmpxchg_relaxed(&lock->val, &val, _Q_LOCKED_VAL))
+		if (mcs_try_clear_tail(lock, val, node))
 			goto release; /* No contention */
 	}
 
@@ -367,7 +409,7 @@ void __lockfunc queued_spin_lock_slowpath(struct qspinlock *lock, u32 val)
 	if (!next)
 		next = smp_cond_load_relaxed(&node->next, (VAL));
 
-	arch_mcs_spin_unlock_contended(&next->locked);
+	mcs_pass_lock(node, next);
 	pv_kick_node(lock, next);
 
 release:
@@ -380,10 +422,50 @@ void __lockfunc queued_spin_lock_slowpath(struct qspinlock *lock, u32 val)
 }
 EXPORT_SYMBOL(queued_spin_lock_slowpath);
 
+/*
+ * Generate the NUMA-aware code for queued_spin_lock_slowpath().
+ */
+#if !defined(_GEN_PV_LOCK_SLOWPATH) && !defined(_GEN_CNA_LOCK_SLOWPATH) && \
+	defined(CONFIG_NUMA_AWARE_SPINLOCKS)
+#define _GEN_CNA_LOCK_SLOWPATH
+
+#undef  cna_enabled
+#define cna_enabled()	false
+
+#undef mcs_init_node
+#undef mcs_order_queue
+#undef mcs_try_clear_tail
+#undef mcs_pass_lock
+
+#define mcs_init_node		cna_init_node
+#define mcs_order_queue		cna_order_queue
+#define mcs_try_clear_tail	cna_try_clear_tail
+#define mcs_pass_lock		cna_pass_lock
+
+#undef  queued_spin_lock_slowpath
+#define queued_spin_lock_slowpath	__cna_queued_spin_lock_slowpath
+
+#include "qspinlock_cna.h"
+#include "qspinlock.c"
+
+#undef mcs_init_node
+#undef mcs_order_queue
+#undef mcs_try_clear_tail
+#undef mcs_pass_lock
+
+#define mcs_init_node		__mcs_init_node
+#define mcs_order_queue		__mcs_order_queue
+#define mcs_try_clear_tail	__mcs_try_clear_tail
+#define mcs_pass_lock		__mcs_pass_lock
+
+#undef _GEN_CNA_LOCK_SLOWPATH
+#endif
+
 /*
  * Generate the paravirt code for queued_spin_unlock_slowpath().
  */
-#if !defined(_GEN_PV_LOCK_SLOWPATH) && defined(CONFIG_PARAVIRT_SPINLOCKS)
+#if !defined(_GEN_PV_LOCK_SLOWPATH) && !defined(_GEN_CNA_LOCK_SLOWPATH) && \
+	defined(CONFIG_PARAVIRT_SPINLOCKS)
 #define _GEN_PV_LOCK_SLOWPATH
 
 #undef  pv_enabled
@@ -0,0 +1,175 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _GEN_CNA_LOCK_SLOWPATH
+#error "do not include this file"
+#endif
+
+#include <linux/topology.h>
+
+/*
+ * Implement a NUMA-aware version of the MCS queue (CNA, compact NUMA-aware
+ * lock), after "Compact NUMA-aware Locks" by Dice and Kogan, EuroSys 2019.
+ *
+ * The head of the queue, while it waits for the owner, looks for the first
+ * waiter running on its own node and moves the waiters in front of that one
+ * to a secondary queue.  The lock thereby stays on one node for as long as
+ * there are waiters there, and its cache lines stay with it.  The secondary
+ * queue goes back in front of the main queue when there is no waiter left on
+ * the current node, or after CNA_INTRA_NODE_THRESHOLD consecutive hand-overs
+ * within a node so that the other nodes are not starved.
+ *
+ * The secondary queue is a circular list through mcs.next, its tail pointing
+ * back at its head.  Only the head of the main queue knows about it: the
+ * value it was handed in mcs.locked is the encoded tail of the secondary
+ * queue, or 1 if that is empty.  Encoded tails are never 0 or 1.
+ *
+ * Enabled with numa_spinlock=on on the kernel command line.
+ */
+
+struct cna_node {
+	struct mcs_spinlock	mcs;
+	u16			numa_node;
+	u32			encoded_tail;
+	/* consecutive hand-overs within the node */
+	u32			intra_count;
+};
+
+#define CNA_INTRA_NODE_THRESHOLD	(1U << 16)
+
+static bool numa_spinlock __initdata;
+
+static __init int parse_numa_spinlock(char *arg)
+{
+	if (!arg)
+		return -EINVAL;
+	if (!strcmp(arg, "on"))
+		numa_spinlock = true;
+	else if (strcmp(arg, "off"))
+		return -EINVAL;
+	return 0;
+}
+early_param("numa_spinlock", parse_numa_spinlock);
+
+/*
+ * Switch before the secondary CPUs come up, so that no CPU can be queued
+ * with one flavour of the slowpath while another uses the other.
+ */
+static __init int cna_init(void)
+{
+	BUILD_BUG_ON(sizeof(struct cna_node) > sizeof(struct qnode));
+
+	if (numa_spinlock && nr_node_ids > 1)
+		static_branch_enable(&numa_spinlock_key);
+	return 0;
+}
+early_initcall(cna_init);
+
+static __always_inline struct cna_node *cna_decode(u32 encoded_tail)
+{
+	return (struct cna_node *)decode_tail(encoded_tail, qnodes);
+}
+
+static __always_inline void cna_init_node(struct mcs_spinlock *node, u32 tail)
+{
+	struct cna_node *cn = (struct cna_node *)node;
+
+	cn->numa_node = numa_node_id();
+	cn->encoded_tail = tail;
+	cn->intra_count = 0;
+}
+
+/*
+ * Called by the head of the main queue before it waits for the owner.  Only
+ * waiters that already have a successor are moved, so the tail of the main
+ * queue, which other CPUs may link behind, is never touched.
+ */
+static void cna_order_queue(struct mcs_spinlock *node,
+			    struct mcs_spinlock **pnext)
+{
+	struct cna_node *cn = (struct cna_node *)node;
+	struct mcs_spinlock *first, *last, *local;
+	struct cna_node *sec_tail;
+
+	if (cn->intra_count >= CNA_INTRA_NODE_THRESHOLD)
+		return;
+
+	first = READ_ONCE(node->next);
+	if (!first || ((struct cna_node *)first)->numa_node == cn->numa_node)
+		return;
+
+	for (last = first; (local = READ_ONCE(last->next)); last = local) {
+		if (((struct cna_node *)local)->numa_node == cn->numa_node)
+			break;
+	}
+	if (!local)
+		return;
+
+	/* Append first..last to the secondary queue. */
+	if ((u32)node->locked > 1) {
+		sec_tail = cna_decode(node->locked);
+		last->next = sec_tail->mcs.next;
+		sec_tail->mcs.next = first;
+	} else {
+		last->next = first;
+	}
+	node->locked = ((struct cna_node *)last)->encoded_tail;
+
+	WRITE_ONCE(node->next, local);
+	*pnext = local;
+}
+
+/*
+ * The head is the last one in the main queue: if there is a secondary queue,
+ * it becomes the main queue, and its head gets the MCS lock.
+ */
+static __always_inline bool cna_try_clear_tail(struct qspinlock *lock, u32 val,
+					       struct mcs_spinlock *node)
+{
+	struct mcs_spinlock *sec_head;
+	struct cna_node *sec_tail;
+	u32 new;
+
+	if ((u32)node->locked <= 1)
+		return atomic_try_cmpxchg_relaxed(&lock->val, &val,
+						  _Q_LOCKED_VAL);
+
+	sec_tail = cna_decode(node->locked);
+	sec_head = sec_tail->mcs.next;
+
+	/* break the cycle before a new waiter can link behind the tail */
+	sec_tail->mcs.next = NULL;
+	new = sec_tail->encoded_tail | _Q_LOCKED_VAL;
+	if (atomic_try_cmpxchg_release(&lock->val, &val, new)) {
+		((struct cna_node *)sec_head)->intra_count = 0;
+		arch_mcs_spin_unlock_contended(&sec_head->locked);
+		return true;
+	}
+	sec_tail->mcs.next = sec_head;
+	return false;
+}
+
+static __always_inline void cna_pass_lock(struct mcs_spinlock *node,
+					  struct mcs_spinlock *next)
+{
+	struct cna_node *cn = (struct cna_node *)node;
+	struct cna_node *cnext = (struct cna_node *)next;
+	struct cna_node *sec_tail;
+	u32 val = 1;
+
+	if (cnext->numa_node == cn->numa_node &&
+	    cn->intra_count < CNA_INTRA_NODE_THRESHOLD) {
+		/* stay on the node, the secondary queue goes along */
+		cnext->intra_count = cn->intra_count + 1;
+		if ((u32)node->locked > 1)
+			val = node->locked;
+	} else if ((u32)node->locked > 1) {
+		/* put the secondary queue in front of @next */
+		sec_tail = cna_decode(node->locked);
+		next = sec_tail->mcs.next;
+		sec_tail->mcs.next = &cnext->mcs;
+		((struct cna_node *)next)->intra_count = 0;
+	} else {
+		cnext->intra_count = 0;
+	}
+
+	smp_store_release(&next->locked, val);
+}
@@ -27,6 +27,9 @@
 #include <linux/export.h>
 #include <linux/rwsem.h>
 #include <linux/atomic.h>
+#include <linux/percpu.h>
+#include <linux/rcuwait.h>
+#include <linux/slab.h>
 #include <trace/events/lock.h>
 
 #ifndef CONFIG_PREEMPT_RT
@@ -325,6 +328,9 @@ void __init_rwsem(struct rw_semaphore *sem, const char *name,
 #ifdef CONFIG_RWSEM_SPIN_ON_OWNER
 	osq_lock_init(&sem->osq);
 #endif
+#ifdef CONFIG_RWSEM_PERCPU_READERS
+	sem->pcpu = NULL;
+#endif
 }
 EXPORT_SYMBOL(__init_rwsem);
 
@@ -1235,6 +1241,273 @@ static struct rw_semaphore *rwsem_downgrade_wake(struct rw_semaphore *sem)
 	return sem;
 }
 
+static void __rwsem_up_read(struct rw_semaphore *sem);
+static void __rwsem_up_write(struct rw_semaphore *sem);
+
+#ifdef CONFIG_RWSEM_PERCPU_READERS
+/*
+ * Per-CPU reader mode.
+ *
+ * An rwsem that rwsem_enable_percpu_readers() was called on counts its
+ * readers in per-CPU counters for as long as writers are rare, so that
+ * readers do not all dirty the cacheline holding sem->count.  A writer
+ * takes sem->count as usual, then sets ->block and waits for the per-CPU
+ * counts to drain; readers that see ->block back out and queue on
+ * sem->count behind it.  Unlike percpu_rw_semaphore this costs readers a
+ * full barrier, but the writer does not wait for an RCU grace period.
+ *
+ * The mode only changes while the write lock is held, so it cannot change
+ * while a reader holds the lock either: up_read() can tell from ->active
+ * where its reader was counted, and a reader that got the lock through
+ * sem->count while ->active is set moves itself to the per-CPU counts.
+ */
+struct rwsem_pcpu {
+	unsigned int __percpu *readers;
+	struct rcuwait writer;
+	bool active;
+	bool block;
+	/* write lock acquisitions counted since ->window */
+	unsigned int writes;
+	unsigned long window;
+};
+
+/*
+ * Leave per-CPU mode when there are more than RWSEM_PCPU_MAX_WRITES write
+ * locks within RWSEM_PCPU_WINDOW; each of them has to sum all the counts.
+ */
+#define RWSEM_PCPU_WINDOW	HZ
+#define RWSEM_PCPU_MAX_WRITES	8
+
+static unsigned int rwsem_pcpu_sum(struct rwsem_pcpu *p)
+{
+	unsigned int sum = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		sum += per_cpu(*p->readers, cpu);
+	return sum;
+}
+
+static void rwsem_pcpu_read_release(struct rwsem_pcpu *p)
+{
+	smp_mb(); /* B matches C */
+	this_cpu_dec(*p->readers);
+
+	/*
+	 * As in percpu_up_read(), the full barrier in rcuwait_wake_up()
+	 * orders the decrement before the check for a waiting writer,
+	 * which sets ->block and sums the counts after D. Testing ->block
+	 * here without that barrier could miss the writer for good.
+	 */
+	rcuwait_wake_up(&p->writer);
+}
+
+static bool rwsem_pcpu_read_trylock(struct rw_semaphore *sem)
+{
+	struct rwsem_pcpu *p = READ_ONCE(sem->pcpu);
+
+	if (!p || !READ_ONCE(p->active))
+		return false;
+
+	this_cpu_inc(*p->readers);
+	smp_mb(); /* A matches D */
+	if (likely(!smp_load_acquire(&p->block) && READ_ONCE(p->active)))
+		return true;
+
+	rwsem_pcpu_read_release(p);
+	return false;
+}
+
+/* Called with a read lock taken through sem->count. */
+static void rwsem_pcpu_read_convert(struct rw_semaphore *sem)
+{
+	struct rwsem_pcpu *p = READ_ONCE(sem->pcpu);
+
+	if (!p || !READ_ONCE(p->active))
+		return;
+
+	/* ordered before the release of sem->count; pairs with D */
+	this_cpu_inc(*p->readers);
+	__rwsem_up_read(sem);
+}
+
+static bool rwsem_pcpu_read_unlock(struct rw_semaphore *sem)
+{
+	struct rwsem_pcpu *p = READ_ONCE(sem->pcpu);
+
+	if (!p || !READ_ONCE(p->active))
+		return false;
+
+	rwsem_pcpu_read_release(p);
+	return true;
+}
+
+/*
+ * Called once the write lock on sem->count is held.  If a fatal signal
+ * interrupts the wait for the per-CPU readers, the write lock is dropped
+ * again.
+ */
+static int rwsem_pcpu_write_lock(struct rw_semaphore *sem, int state)
+{
+	struct rwsem_pcpu *p = sem->pcpu;
+	int ret;
+
+	if (!p || !p->active)
+		return 0;
+
+	WRITE_ONCE(p->block, true);
+	smp_mb(); /* D matches A */
+
+	/* C matches B */
+	ret = rcuwait_wait_event(&p->writer, !rwsem_pcpu_sum(p), state);
+	if (ret) {
+		smp_store_release(&p->block, false);
+		__rwsem_up_write(sem);
+	}
+	return ret;
+}
+
+static bool rwsem_pcpu_write_trylock(struct rw_semaphore *sem)
+{
+	struct rwsem_pcpu *p = sem->pcpu;
+
+	if (!p || !p->active)
+		return true;
+
+	WRITE_ONCE(p->block, true);
+	smp_mb(); /* D matches A */
+	if (!rwsem_pcpu_sum(p))
+		return true;
+
+	smp_store_release(&p->block, false);
+	__rwsem_up_write(sem);
+	return false;
+}
+
+/*
+ * Called with the write lock held before it is dropped or downgraded,
+ * this is where the mode changes.  Readers that see ->active set must
+ * also see ->block until the lock is released, hence the order of the
+ * stores.
+ *
+ * Return: true if @downgrade and the read lock is now held per CPU.
+ */
+static bool rwsem_pcpu_write_unlock(struct rw_semaphore *sem, bool downgrade)
+{
+	struct rwsem_pcpu *p = sem->pcpu;
+	bool active;
+
+	if (!p)
+		return false;
+
+	if (time_after(jiffies, p->window + RWSEM_PCPU_WINDOW)) {
+		active = p->writes <= RWSEM_PCPU_MAX_WRITES;
+		p->window = jiffies;
+		p->writes = 0;
+	} else {
+		active = p->active;
+	}
+	if (++p->writes > RWSEM_PCPU_MAX_WRITES)
+		active = false;
+
+	if (active && !p->active) {
+		WRITE_ONCE(p->block, true);
+		smp_wmb();
+	}
+	WRITE_ONCE(p->active, active);
+
+	if (active && downgrade)
+		this_cpu_inc(*p->readers);
+	smp_store_release(&p->block, false);
+	return active && downgrade;
+}
+
+/**
+ * rwsem_enable_percpu_readers - count the readers of an rwsem per CPU
+ * @sem: the semaphore, read-mostly
+ *
+ * Switches @sem to per-CPU reader counts while writers are rare, see
+ * above.  The counts must be freed with rwsem_free_percpu_readers()
+ * before @sem goes away.  May sleep.
+ *
+ * Return: 0 or -ENOMEM.
+ */
+int rwsem_enable_percpu_readers(struct rw_semaphore *sem)
+{
+	struct rwsem_pcpu *p;
+
+	p = kzalloc(sizeof(*p), GFP_KERNEL);
+	if (!p)
+		return -ENOMEM;
+	p->readers = alloc_percpu(unsigned int);
+	if (!p->readers) {
+		kfree(p);
+		return -ENOMEM;
+	}
+	rcuwait_init(&p->writer);
+	p->active = true;
+	p->block = true;
+	p->window = jiffies;
+
+	down_write(sem);
+	if (WARN_ON_ONCE(sem->pcpu)) {
+		up_write(sem);
+		free_percpu(p->readers);
+		kfree(p);
+		return 0;
+	}
+	/* published with ->block set, up_write() clears it */
+	smp_store_release(&sem->pcpu, p);
+	up_write(sem);
+	return 0;
+}
+EXPORT_SYMBOL_GPL(rwsem_enable_percpu_readers);
+
+/* Must not race with any other use of @sem. */
+void rwsem_free_percpu_readers(struct rw_semaphore *sem)
+{
+	struct rwsem_pcpu *p = sem->pcpu;
+
+	if (!p)
+		return;
+	sem->pcpu = NULL;
+	free_percpu(p->readers);
+	kfree(p);
+}
+EXPORT_SYMBOL_GPL(rwsem_free_percpu_readers);
+
+bool rwsem_percpu_readers_held(const struct rw_semaphore *sem)
+{
+	struct rwsem_pcpu *p = READ_ONCE(sem->pcpu);
+
+	return p && READ_ONCE(p->active) && rwsem_pcpu_sum(p);
+}
+EXPORT_SYMBOL_GPL(rwsem_percpu_readers_held);
+#else
+static inline bool rwsem_pcpu_read_trylock(struct rw_semaphore *sem)
+{
+	return false;
+}
+static inline void rwsem_pcpu_read_convert(struct rw_semaphore *sem) { }
+static inline bool rwsem_pcpu_read_unlock(struct rw_semaphore *sem)
+{
+	return false;
+}
+static inline int rwsem_pcpu_write_lock(struct rw_semaphore *sem, int state)
+{
+	return 0;
+}
+static inline bool rwsem_pcpu_write_trylock(struct rw_semaphore *sem)
+{
+	return true;
+}
+static inline bool rwsem_pcpu_write_unlock(struct rw_semaphore *sem,
+					   bool downgrade)
+{
+	return false;
+}
+#endif /* CONFIG_RWSEM_PERCPU_READERS */
+
 /*
  * lock for reading
  */
@@ -1243,6 +1516,9 @@ static __always_inline int __down_read_common(struct rw_semaphore *sem, int stat
 	int ret = 0;
 	long count;
 
+	if (rwsem_pcpu_read_trylock(sem))
+		return 0;
+
 	preempt_disable();
 	if (!rwsem_read_trylock(sem, &count)) {
 		if (IS_ERR(rwsem_down_read_slowpath(sem, count, state))) {
@@ -1251,6 +1527,7 @@ static __always_inline int __down_read_common(struct rw_semaphore *sem, int stat
 		}
 		DEBUG_RWSEMS_WARN_ON(!is_rwsem_reader_owned(sem), sem);
 	}
+	rwsem_pcpu_read_convert(sem);
 out:
 	preempt_enable();
 	return ret;
@@ -1278,12 +1555,16 @@ static inline int __down_read_trylock(struct rw_semaphore *sem)
 
 	DEBUG_RWSEMS_WARN_ON(sem->magic != sem, sem);
 
+	if (rwsem_pcpu_read_trylock(sem))
+		return 1;
+
 	preempt_disable();
 	tmp = atomic_long_read(&sem->count);
 	while (!(tmp & RWSEM_READ_FAILED_MASK)) {
 		if (atomic_long_try_cmpxchg_acquire(&sem->count, &tmp,
 						    tmp + RWSEM_READER_BIAS)) {
 			rwsem_set_reader_owned(sem);
+			rwsem_pcpu_read_convert(sem);
 			ret = 1;
 			break;
 		}
@@ -1305,6 +1586,8 @@ static __always_inline int __down_write_common(struct rw_semaphore *sem, int sta
 			ret = -EINTR;
 	}
 	preempt_enable();
+	if (!ret)
+		ret = rwsem_pcpu_write_lock(sem, state);
 	return ret;
 }
 
@@ -1327,17 +1610,16 @@ static inline int __down_write_trylock(struct rw_semaphore *sem)
 	ret = rwsem_write_trylock(sem);
 	preempt_enable();
 
-	return ret;
+	return ret && rwsem_pcpu_write_trylock(sem);
 }
 
 /*
  * unlock after reading
  */
-static inline void __up_read(struct rw_semaphore *sem)
+static void __rwsem_up_read(struct rw_semaphore *sem)
 {
 	long tmp;
 
-	DEBUG_RWSEMS_WARN_ON(sem->magic != sem, sem);
 	DEBUG_RWSEMS_WARN_ON(!is_rwsem_reader_owned(sem), sem);
 
 	preempt_disable();
@@ -1352,14 +1634,21 @@ static inline void __up_read(struct rw_semaphore *sem)
 	preempt_enable();
 }
 
+static inline void __up_read(struct rw_semaphore *sem)
+{
+	DEBUG_RWSEMS_WARN_ON(sem->magic != sem, sem);
+
+	if (!rwsem_pcpu_read_unlock(sem))
+		__rwsem_up_read(sem);
+}
+
 /*
  * unlock after writing
  */
-static inline void __up_write(struct rw_semaphore *sem)
+static void __rwsem_up_write(struct rw_semaphore *sem)
 {
 	long tmp;
 
-	DEBUG_RWSEMS_WARN_ON(sem->magic != sem, sem);
 	/*
 	 * sem->owner may differ from current if the ownership is transferred
 	 * to an anonymous writer by setting the RWSEM_NONSPINNABLE bits.
@@ -1375,6 +1664,14 @@ static inline void __up_write(struct rw_semaphore *sem)
 	preempt_enable();
 }
 
+static inline void __up_write(struct rw_semaphore *sem)
+{
+	DEBUG_RWSEMS_WARN_ON(sem->magic != sem, sem);
+
+	rwsem_pcpu_write_unlock(sem, false);
+	__rwsem_up_write(sem);
+}
+
 /*
  * downgrade write lock to read lock
  */
@@ -1390,6 +1687,10 @@ static inline void __downgrade_write(struct rw_semaphore *sem)
 	 * write side. As such, rely on RELEASE semantics.
 	 */
 	DEBUG_RWSEMS_WARN_ON(rwsem_owner(sem) != current, sem);
+	if (rwsem_pcpu_write_unlock(sem, true)) {
+		__rwsem_up_write(sem);
+		return;
+	}
 	preempt_disable();
 	tmp = atomic_long_fetch_add_release(
 		-RWSEM_WRITER_LOCKED+RWSEM_READER_BIAS, &sem->count);
@@ -1140,17 +1140,32 @@ static const struct kernel_symbol *resolve_symbol(struct module *mod,
 		.gplok	= !(mod->taints & (1 << TAINT_PROPRIETARY_MODULE)),
 		.warn	= true,
 	};
+	bool locked = false;
+	bool found;
 	int err;
 
 	/*
-	 * The module_mutex should not be a heavily contended lock;
-	 * if we get the occasional sleep here, we'll go an extra iteration
-	 * in the wait_event_interruptible(), which is harmless.
+	 * Most symbols come from vmlinux, which never goes away and takes no
+	 * reference, so look for them without module_mutex first: modules
+	 * loaded in parallel would otherwise take turns on it for every
+	 * undefined symbol.
 	 */
-	sched_annotate_sleep();
-	mutex_lock(&module_mutex);
-	if (!find_symbol(&fsa))
-		goto unlock;
+	scoped_guard(rcu)
+		found = find_symbol(&fsa);
+
+	if (!found || fsa.owner) {
+		/*
+		 * The module_mutex should not be a heavily contended lock;
+		 * if we get the occasional sleep here, we'll go an extra
+		 * iteration in the wait_event_interruptible(), which is
+		 * harmless.
+		 */
+		sched_annotate_sleep();
+		mutex_lock(&module_mutex);
+		locked = true;
+		if (!find_symbol(&fsa))
+			goto unlock;
+	}
 
 	if (fsa.license == GPL_ONLY)
 		mod->using_gplonly_symbols = true;
@@ -1181,7 +1196,8 @@ static const struct kernel_symbol *resolve_symbol(struct module *mod,
 	/* We must make copy under the lock if we failed to get ref. */
 	strscpy(ownername, module_name(fsa.owner), MODULE_NAME_LEN);
 unlock:
-	mutex_unlock(&module_mutex);
+	if (locked)
+		mutex_unlock(&module_mutex);
 	return fsa.sym;
 }
 
@@ -27,12 +27,14 @@ int devkmsg_sysctl_set_loglvl(const struct ctl_table *table, int write,
  * legacy printer thread. The only exception is on panic, after the
  * nbcon consoles have had their chance to print the panic messages
  * first.
+ *
+ * This is always the case with PREEMPT_RT. Other kernels can ask for it
+ * with "printk.legacy_kthread" on the command line.
  */
-#ifdef CONFIG_PREEMPT_RT
-# define force_legacy_kthread()	(true)
-#else
-# define force_legacy_kthread()	(false)
-#endif
+extern bool printk_legacy_kthread_forced;
+
+#define force_legacy_kthread()	\
+	(IS_ENABLED(CONFIG_PREEMPT_RT) || printk_legacy_kthread_forced)
 
 #ifdef CONFIG_PRINTK
 
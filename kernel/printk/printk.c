@@ -489,6 +489,27 @@ bool have_boot_console;
 /* See printk_legacy_allow_panic_sync() for details. */
 bool legacy_allow_panic_sync;
 
+/* See force_legacy_kthread() for details. */
+bool printk_legacy_kthread_forced __ro_after_init;
+
+/*
+ * Moving legacy console output into the "pr/legacy" thread keeps slow
+ * consoles, such as serial ports during a message storm, from stalling
+ * whichever context happened to call printk().  The price is that the
+ * messages show up later: until the thread is started by an early
+ * initcall, legacy consoles stay silent unless the system panics.
+ */
+static int __init printk_legacy_kthread_setup(char *str)
+{
+	/* A bare "printk.legacy_kthread" turns it on. */
+	if (!str || !*str) {
+		printk_legacy_kthread_forced = true;
+		return 0;
+	}
+	return kstrtobool(str, &printk_legacy_kthread_forced);
+}
+early_param("printk.legacy_kthread", printk_legacy_kthread_setup);
+
 #ifdef CONFIG_PRINTK
 DECLARE_WAIT_QUEUE_HEAD(log_wait);
 static DECLARE_WAIT_QUEUE_HEAD(legacy_wait);
@@ -107,6 +107,11 @@ static bool use_softirq = !IS_ENABLED(CONFIG_PREEMPT_RT);
 #ifndef CONFIG_PREEMPT_RT
 module_param(use_softirq, bool, 0444);
 #endif
+/* With RCU_SOFTIRQ, move a CPU's callback flood to its rcuc kthread. */
+static bool rcu_flood_offload;
+#ifndef CONFIG_PREEMPT_RT
+module_param(rcu_flood_offload, bool, 0444);
+#endif
 /* Control rcu_node-tree auto-balancing at boot time. */
 static bool rcu_fanout_exact;
 module_param(rcu_fanout_exact, bool, 0444);
@@ -150,6 +155,7 @@ static int rcu_scheduler_fully_active __read_mostly;
 static void rcu_report_qs_rnp(unsigned long mask, struct rcu_node *rnp,
 			      unsigned long gps, unsigned long flags);
 static void invoke_rcu_core(void);
+static void invoke_rcu_core_kthread(void);
 static void rcu_report_exp_rdp(struct rcu_data *rdp);
 static void sync_sched_exp_online_cleanup(int cpu);
 static void check_cb_ovld_locked(struct rcu_data *rdp, struct rcu_node *rnp);
@@ -2613,6 +2619,10 @@ static void rcu_do_batch(struct rcu_data *rdp)
 	if (rdp->blimit >= DEFAULT_MAX_RCU_BLIMIT && count <= qlowmark)
 		rdp->blimit = blimit;
 
+	/* Hand RCU core processing back to RCU_SOFTIRQ after a flood. */
+	if (rdp->rcu_cpu_flood && count <= qlowmark)
+		WRITE_ONCE(rdp->rcu_cpu_flood, 0);
+
 	/* Reset ->qlen_last_fqs_check trigger if enough CBs have drained. */
 	if (count == 0 && rdp->qlen_last_fqs_check != 0) {
 		rdp->qlen_last_fqs_check = 0;
@@ -2821,12 +2831,25 @@ static __latent_entropy void rcu_core(void)
 	/* If there are callbacks ready, invoke them. */
 	if (!rcu_rdp_is_offloaded(rdp) && rcu_segcblist_ready_cbs(&rdp->cblist) &&
 	    likely(READ_ONCE(rcu_scheduler_fully_active))) {
+		/*
+		 * Invoking a flood of callbacks from softirq stalls everything
+		 * else on this CPU for milliseconds at a time, invoke them from
+		 * the preemptible rcuc kthread until the flood has drained.
+		 */
+		if (rcu_flood_offload && in_serving_softirq() &&
+		    rdp->rcu_cpu_kthread_task &&
+		    rcu_segcblist_n_cbs(&rdp->cblist) > qhimark) {
+			WRITE_ONCE(rdp->rcu_cpu_flood, 1);
+			invoke_rcu_core_kthread();
+			goto out;
+		}
 		rcu_do_batch(rdp);
 		/* Re-invoke RCU core processing if there are callbacks remaining. */
 		if (rcu_segcblist_ready_cbs(&rdp->cblist))
 			invoke_rcu_core();
 	}
 
+out:
 	/* Do any needed deferred wakeups of rcuo kthreads. */
 	do_nocb_deferred_wakeup(rdp);
 	trace_rcu_utilization(TPS("End RCU core"));
@@ -2871,7 +2894,7 @@ static void invoke_rcu_core(void)
 {
 	if (!cpu_online(smp_processor_id()))
 		return;
-	if (use_softirq)
+	if (use_softirq && !__this_cpu_read(rcu_data.rcu_cpu_flood))
 		raise_softirq(RCU_SOFTIRQ);
 	else
 		invoke_rcu_core_kthread();
@@ -2943,7 +2966,7 @@ static int __init rcu_spawn_core_kthreads(void)
 
 	for_each_possible_cpu(cpu)
 		per_cpu(rcu_data.rcu_cpu_has_work, cpu) = 0;
-	if (use_softirq)
+	if (use_softirq && !rcu_flood_offload)
 		return 0;
 	WARN_ONCE(smpboot_register_percpu_thread(&rcu_cpu_thread_spec),
 		  "%s: Could not start rcuc kthread, OOM is now expected behavior\n", __func__);
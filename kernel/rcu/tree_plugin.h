@@ -1032,8 +1032,11 @@ static void rcu_cpu_kthread_setup(unsigned int cpu)
 #ifdef CONFIG_RCU_BOOST
 	struct sched_param sp;
 
-	sp.sched_priority = kthread_prio;
-	sched_setscheduler_nocheck(current, SCHED_FIFO, &sp);
+	/* Callback floods are moved here to stay out of everyone's way. */
+	if (!use_softirq) {
+		sp.sched_priority = kthread_prio;
+		sched_setscheduler_nocheck(current, SCHED_FIFO, &sp);
+	}
 #endif /* #ifdef CONFIG_RCU_BOOST */
 
 	WRITE_ONCE(rdp->rcuc_activity, jiffies);
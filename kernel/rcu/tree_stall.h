@@ -403,7 +403,7 @@ static bool rcu_is_rcuc_kthread_starving(struct rcu_data *rdp, unsigned long *jp
 	unsigned long j;
 
 	rcuc = rdp->rcu_cpu_kthread_task;
-	if (!rcuc)
+	if (!rcuc || (use_softirq && !READ_ONCE(rdp->rcu_cpu_flood)))
 		return false;
 
 	cpu = task_cpu(rcuc);
@@ -410,6 +410,48 @@ static int rseq_ip_fixup(struct pt_regs *regs)
 	return 0;
 }
 
+/*
+ * Called on the way back to user-space when a reschedule is pending.  If
+ * the thread asked for it through rseq->slice_ctrl, let it run on for a
+ * bounded amount of time instead, so that it can leave the critical
+ * section it is in before it gets preempted.
+ *
+ * Return: true if the reschedule was deferred.
+ */
+bool rseq_grant_slice_extension(void)
+{
+	struct task_struct *t = current;
+	u32 ctrl;
+
+	if (!t->rseq_slice_ext || !t->rseq)
+		return false;
+	if (get_user(ctrl, &t->rseq->slice_ctrl))
+		return false;
+	if (!(ctrl & RSEQ_SLICE_EXT_REQUEST))
+		return false;
+	if (!sched_grant_slice_extension())
+		return false;
+	/*
+	 * Should the extension already have been revoked at this point, the
+	 * notify resume handler clears the bit again before returning.
+	 */
+	if (put_user(ctrl | RSEQ_SLICE_EXT_GRANTED, &t->rseq->slice_ctrl))
+		force_sig(SIGSEGV);
+	return true;
+}
+
+static int rseq_clear_slice_grant(struct task_struct *t)
+{
+	u32 ctrl;
+
+	t->rseq_slice_state = RSEQ_SLICE_NONE;
+	if (get_user(ctrl, &t->rseq->slice_ctrl))
+		return -EFAULT;
+	if (!(ctrl & RSEQ_SLICE_EXT_GRANTED))
+		return 0;
+	return put_user(ctrl & ~RSEQ_SLICE_EXT_GRANTED, &t->rseq->slice_ctrl);
+}
+
 /*
  * This resume handler must always be executed between any of:
  * - preemption,
@@ -441,6 +483,9 @@ void __rseq_handle_notify_resume(struct ksignal *ksig, struct pt_regs *regs)
 	}
 	if (unlikely(rseq_update_cpu_node_id(t)))
 		goto error;
+	if (unlikely(t->rseq_slice_state == RSEQ_SLICE_REVOKED) &&
+	    rseq_clear_slice_grant(t))
+		goto error;
 	return;
 
 error:
@@ -493,6 +538,7 @@ SYSCALL_DEFINE4(rseq, struct rseq __user *, rseq, u32, rseq_len,
 		current->rseq = NULL;
 		current->rseq_sig = 0;
 		current->rseq_len = 0;
+		current->rseq_slice_ext = 0;
 		return 0;
 	}
 
@@ -934,6 +934,92 @@ static inline void hrtick_rq_init(struct rq *rq)
 }
 #endif	/* CONFIG_SCHED_HRTICK */
 
+#ifdef CONFIG_RSEQ
+/*
+ * Upper bound of an rseq time slice extension, 0 disables them.  This is
+ * a hard limit on the latency a task can add to a preemption it was told
+ * about, so keep it well below the scheduler tick.
+ */
+static unsigned int sysctl_sched_rseq_slice_ns = 30 * NSEC_PER_USEC;
+static const unsigned int sysctl_sched_rseq_slice_max_ns = 100 * NSEC_PER_USEC;
+
+static enum hrtimer_restart slice_ext_timer(struct hrtimer *timer)
+{
+	struct rq *rq = container_of(timer, struct rq, slice_ext_timer);
+	struct rq_flags rf;
+
+	WARN_ON_ONCE(cpu_of(rq) != smp_processor_id());
+
+	rq_lock(rq, &rf);
+	if (rq->curr->rseq_slice_state == RSEQ_SLICE_GRANTED)
+		resched_curr(rq);
+	rq_unlock(rq, &rf);
+
+	return HRTIMER_NORESTART;
+}
+
+/*
+ * Defer the reschedule pending for current on its way back to user-space.
+ * The extension ends when the task schedules, voluntarily or because the
+ * budget timer expired, and a task gets at most one extension per stint.
+ */
+bool sched_grant_slice_extension(void)
+{
+	unsigned int budget = READ_ONCE(sysctl_sched_rseq_slice_ns);
+	struct task_struct *curr = current;
+	struct rq *rq;
+
+	if (!budget || curr->rseq_slice_state != RSEQ_SLICE_NONE)
+		return false;
+
+	guard(irqsave)();
+	if (!(read_task_thread_flags(curr) &
+	      (_TIF_NEED_RESCHED | _TIF_NEED_RESCHED_LAZY)))
+		return false;
+
+	rq = this_rq();
+	/*
+	 * Only fair tasks get extensions, and never at the expense of an RT or
+	 * deadline task which is waiting for the CPU.
+	 */
+	if (curr->sched_class != &fair_sched_class ||
+	    rq->rt.rt_nr_running || rq->dl.dl_nr_running)
+		return false;
+
+	curr->rseq_slice_state = RSEQ_SLICE_GRANTED;
+	clear_tsk_need_resched(curr);
+	clear_preempt_need_resched();
+	hrtimer_start(&rq->slice_ext_timer, ns_to_ktime(budget),
+		      HRTIMER_MODE_REL_PINNED_HARD);
+
+	return true;
+}
+
+static inline void slice_ext_revoke(struct rq *rq, struct task_struct *prev)
+{
+	if (likely(prev->rseq_slice_state != RSEQ_SLICE_GRANTED))
+		return;
+
+	hrtimer_try_to_cancel(&rq->slice_ext_timer);
+	prev->rseq_slice_state = RSEQ_SLICE_REVOKED;
+	rseq_set_notify_resume(prev);
+}
+
+static void slice_ext_rq_init(struct rq *rq)
+{
+	hrtimer_setup(&rq->slice_ext_timer, slice_ext_timer, CLOCK_MONOTONIC,
+		      HRTIMER_MODE_REL_HARD);
+}
+#else	/* CONFIG_RSEQ */
+static inline void slice_ext_revoke(struct rq *rq, struct task_struct *prev)
+{
+}
+
+static inline void slice_ext_rq_init(struct rq *rq)
+{
+}
+#endif	/* CONFIG_RSEQ */
+
 /*
  * try_cmpxchg based fetch_or() macro so it works for different integer types:
  */
@@ -1060,13 +1146,70 @@ void wake_q_add_safe(struct wake_q_head *head, struct task_struct *task)
 		put_task_struct(task);
 }
 
+#ifdef CONFIG_SMP
+/*
+ * While a CPU works through a wake_q, remote wakeups queued on other CPUs'
+ * wake_lists only record the target here; ttwu_batch_end() then kicks all
+ * of them at once, which the hardware can often do with a single multicast
+ * IPI.  The deferral is bounded by the wake_q being processed, so it also
+ * covers wakeups done from interrupts that hit the CPU meanwhile.
+ */
+static DEFINE_PER_CPU(unsigned int, ttwu_batch_depth);
+static DEFINE_PER_CPU(cpumask_var_t, ttwu_batch_mask);
+
+/*
+ * The batch runs with preemption disabled; flush it and allow preemption
+ * this often so that a long wake_q doesn't delay the waker's rescheduling.
+ */
+#define TTWU_BATCH_MAX		32
+
+static void ttwu_batch_begin(void)
+{
+	preempt_disable();
+	__this_cpu_inc(ttwu_batch_depth);
+}
+
+static void ttwu_batch_end(void)
+{
+	struct cpumask *mask = this_cpu_cpumask_var_ptr(ttwu_batch_mask);
+	unsigned long flags;
+
+	/* Keep interrupts from adding to the mask while it is being sent. */
+	local_irq_save(flags);
+	if (!__this_cpu_dec_return(ttwu_batch_depth) && !cpumask_empty(mask))
+		smp_send_call_single_mask(mask);
+	local_irq_restore(flags);
+	preempt_enable();
+}
+
+static inline bool ttwu_batching(void)
+{
+	return sched_feat(TTWU_BATCH) && __this_cpu_read(ttwu_batch_depth);
+}
+#else
+#define TTWU_BATCH_MAX		UINT_MAX
+static inline void ttwu_batch_begin(void) { }
+static inline void ttwu_batch_end(void) { }
+#endif
+
 void wake_up_q(struct wake_q_head *head)
 {
 	struct wake_q_node *node = head->first;
+	unsigned int nr = 0;
 
+	if (node == WAKE_Q_TAIL)
+		return;
+
+	ttwu_batch_begin();
 	while (node != WAKE_Q_TAIL) {
 		struct task_struct *task;
 
+		if (++nr > TTWU_BATCH_MAX) {
+			ttwu_batch_end();
+			ttwu_batch_begin();
+			nr = 1;
+		}
+
 		task = container_of(node, struct task_struct, wake_q);
 		node = node->next;
 		/* pairs with cmpxchg_relaxed() in __wake_q_add() */
@@ -1080,6 +1223,7 @@ void wake_up_q(struct wake_q_head *head)
 		wake_up_process(task);
 		put_task_struct(task);
 	}
+	ttwu_batch_end();
 }
 
 /*
@@ -3877,7 +4021,11 @@ static void __ttwu_queue_wakelist(struct task_struct *p, int cpu, int wake_flags
 	p->sched_remote_wakeup = !!(wake_flags & WF_MIGRATED);
 
 	WRITE_ONCE(rq->ttwu_pending, 1);
-	__smp_call_single_queue(cpu, &p->wake_entry.llist);
+	if (ttwu_batching())
+		__smp_call_single_queue_mask(cpu, &p->wake_entry.llist,
+					     this_cpu_cpumask_var_ptr(ttwu_batch_mask));
+	else
+		__smp_call_single_queue(cpu, &p->wake_entry.llist);
 }
 
 void wake_up_if_idle(int cpu)
@@ -4699,6 +4847,17 @@ static const struct ctl_table sched_core_sysctls[] = {
 		.extra2		= SYSCTL_FOUR,
 	},
 #endif /* CONFIG_NUMA_BALANCING */
+#ifdef CONFIG_RSEQ
+	{
+		.procname	= "sched_rseq_slice_ns",
+		.data		= &sysctl_sched_rseq_slice_ns,
+		.maxlen		= sizeof(unsigned int),
+		.mode		= 0644,
+		.proc_handler	= proc_douintvec_minmax,
+		.extra1		= SYSCTL_ZERO,
+		.extra2		= (void *)&sysctl_sched_rseq_slice_max_ns,
+	},
+#endif /* CONFIG_RSEQ */
 };
 static int __init sched_core_sysctl_init(void)
 {
@@ -6667,6 +6826,7 @@ static void __sched notrace __schedule(int sched_mode)
 
 	if (sched_feat(HRTICK) || sched_feat(HRTICK_DL))
 		hrtick_clear(rq);
+	slice_ext_revoke(rq, prev);
 
 	local_irq_disable();
 	rcu_note_context_switch(preempt);
@@ -8666,6 +8826,7 @@ void __init sched_init(void)
 #endif
 #endif /* CONFIG_SMP */
 		hrtick_rq_init(rq);
+		slice_ext_rq_init(rq);
 		atomic_set(&rq->nr_iowait, 0);
 		fair_server_init(rq);
 
@@ -8682,6 +8843,10 @@ void __init sched_init(void)
 		rq->core_cookie = 0UL;
 #endif
 		zalloc_cpumask_var_node(&rq->scratch_mask, GFP_KERNEL, cpu_to_node(i));
+#ifdef CONFIG_SMP
+		zalloc_cpumask_var_node(&per_cpu(ttwu_batch_mask, i), GFP_KERNEL,
+					cpu_to_node(i));
+#endif
 	}
 
 	set_load_weight(&init_task, false);
@@ -8969,6 +9134,9 @@ static void sched_free_group(struct task_group *tg)
 	free_fair_sched_group(tg);
 	free_rt_sched_group(tg);
 	autogroup_free(tg);
+#ifdef CONFIG_SCHED_INFO
+	free_percpu(tg->run_delay_hist);
+#endif
 	kmem_cache_free(task_group_cache, tg);
 }
 
@@ -9003,6 +9171,12 @@ struct task_group *sched_create_group(struct task_group *parent)
 	if (!alloc_rt_sched_group(tg, parent))
 		goto err;
 
+#ifdef CONFIG_SCHED_INFO
+	tg->run_delay_hist = alloc_percpu(struct sched_run_delay_hist);
+	if (!tg->run_delay_hist)
+		goto err;
+#endif
+
 	scx_group_set_weight(tg, CGROUP_WEIGHT_DFL);
 	alloc_uclamp_sched_group(tg, parent);
 
@@ -9911,6 +10085,32 @@ static int cpu_extra_stat_show(struct seq_file *sf,
 			   "burst_usec %llu\n",
 			   cfs_b->nr_periods, cfs_b->nr_throttled,
 			   throttled_usec, cfs_b->nr_burst, burst_usec);
+		seq_printf(sf, "throttled_lt_1ms %u\n"
+			   "throttled_lt_10ms %u\n"
+			   "throttled_lt_100ms %u\n"
+			   "throttled_ge_100ms %u\n",
+			   cfs_b->throttled_hist[0], cfs_b->throttled_hist[1],
+			   cfs_b->throttled_hist[2], cfs_b->throttled_hist[3]);
+	}
+#endif
+#ifdef CONFIG_SCHED_INFO
+	{
+		struct task_group *tg = css_tg(css);
+		u64 nr[SCHED_RUN_DELAY_BUCKETS] = { };
+		int cpu, i;
+
+		if (!tg->run_delay_hist || !sched_info_on())
+			return 0;
+
+		for_each_possible_cpu(cpu) {
+			for (i = 0; i < SCHED_RUN_DELAY_BUCKETS; i++)
+				nr[i] += per_cpu_ptr(tg->run_delay_hist, cpu)->nr[i];
+		}
+
+		seq_puts(sf, "run_delay_hist");
+		for (i = 0; i < SCHED_RUN_DELAY_BUCKETS; i++)
+			seq_printf(sf, " %llu", nr[i]);
+		seq_putc(sf, '\n');
 	}
 #endif
 	return 0;
@@ -10446,6 +10646,13 @@ void sched_mm_cid_migrate_to(struct rq *dst_rq, struct task_struct *t)
 			 !mm_cid_is_unset(READ_ONCE(dst_pcpu_cid->recent_cid));
 	if (dst_cid_is_set && atomic_read(&mm->mm_users) >= READ_ONCE(mm->nr_cpus_allowed))
 		return;
+	/*
+	 * With node-local cids, a cid of the source node stays with the
+	 * source CPU, the destination allocates one of its own node.
+	 */
+	if (READ_ONCE(mm->mm_cid_node) &&
+	    cpu_to_node(src_cpu) != cpu_to_node(cpu_of(dst_rq)))
+		return;
 	src_pcpu_cid = per_cpu_ptr(mm->pcpu_cid, src_cpu);
 	src_rq = cpu_rq(src_cpu);
 	src_cid = __sched_mm_cid_migrate_from_fetch_cid(src_rq, t, src_pcpu_cid);
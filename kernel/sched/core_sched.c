@@ -6,6 +6,8 @@
  */
 struct sched_core_cookie {
 	refcount_t refcnt;
+	/* SMT sibling time forced idle by tasks with this cookie (ns) */
+	atomic64_t forceidle_sum;
 };
 
 static unsigned long sched_core_alloc_cookie(void)
@@ -15,6 +17,7 @@ static unsigned long sched_core_alloc_cookie(void)
 		return 0;
 
 	refcount_set(&ck->refcnt, 1);
+	atomic64_set(&ck->forceidle_sum, 0);
 	sched_core_get();
 
 	return (unsigned long)ck;
@@ -142,7 +145,8 @@ int sched_core_share_pid(unsigned int cmd, pid_t pid, enum pid_type type,
 	BUILD_BUG_ON(PR_SCHED_CORE_SCOPE_PROCESS_GROUP != PIDTYPE_PGID);
 
 	if (type > PIDTYPE_PGID || cmd >= PR_SCHED_CORE_MAX || pid < 0 ||
-	    (cmd != PR_SCHED_CORE_GET && uaddr))
+	    (cmd != PR_SCHED_CORE_GET && cmd != PR_SCHED_CORE_GET_FORCEIDLE &&
+	     uaddr))
 		return -EINVAL;
 
 	rcu_read_lock();
@@ -181,6 +185,20 @@ int sched_core_share_pid(unsigned int cmd, pid_t pid, enum pid_type type,
 		err = put_user(id, (u64 __user *)uaddr);
 		goto out;
 
+	case PR_SCHED_CORE_GET_FORCEIDLE:
+		if (type != PIDTYPE_PID || uaddr & 7) {
+			err = -EINVAL;
+			goto out;
+		}
+		cookie = sched_core_clone_cookie(task);
+		if (cookie) {
+			struct sched_core_cookie *ck = (void *)cookie;
+
+			id = atomic64_read(&ck->forceidle_sum);
+		}
+		err = put_user(id, (u64 __user *)uaddr);
+		goto out;
+
 	case PR_SCHED_CORE_CREATE:
 		cookie = sched_core_alloc_cookie();
 		if (!cookie) {
@@ -283,6 +301,11 @@ void __sched_core_account_forceidle(struct rq *rq)
 		 * if it comes from our SMT sibling.
 		 */
 		__account_forceidle_time(p, delta);
+		if (p->core_cookie) {
+			struct sched_core_cookie *ck = (void *)p->core_cookie;
+
+			atomic64_add(delta, &ck->forceidle_sum);
+		}
 	}
 }
 
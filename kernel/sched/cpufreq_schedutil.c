@@ -394,6 +394,20 @@ static inline void ignore_dl_rate_limit(struct sugov_cpu *sg_cpu)
 		sg_cpu->sg_policy->need_freq_update = true;
 }
 
+/*
+ * Make sugov_should_update_freq() ignore the rate limit when a waking task's
+ * estimated utilization has pushed the CPU's above what the current request
+ * was computed for, so the frequency ramps up before the task runs rather
+ * than after.
+ */
+static inline void ignore_util_est_rate_limit(struct sugov_cpu *sg_cpu,
+					      unsigned int flags)
+{
+	if ((flags & SCHED_CPUFREQ_UTIL_EST) &&
+	    cpu_util_cfs_boost(sg_cpu->cpu) > sg_cpu->util)
+		sg_cpu->sg_policy->need_freq_update = true;
+}
+
 static inline bool sugov_update_single_common(struct sugov_cpu *sg_cpu,
 					      u64 time, unsigned long max_cap,
 					      unsigned int flags)
@@ -404,6 +418,7 @@ static inline bool sugov_update_single_common(struct sugov_cpu *sg_cpu,
 	sg_cpu->last_update = time;
 
 	ignore_dl_rate_limit(sg_cpu);
+	ignore_util_est_rate_limit(sg_cpu, flags);
 
 	if (!sugov_should_update_freq(sg_cpu->sg_policy, time))
 		return false;
@@ -521,6 +536,7 @@ sugov_update_shared(struct update_util_data *hook, u64 time, unsigned int flags)
 	sg_cpu->last_update = time;
 
 	ignore_dl_rate_limit(sg_cpu);
+	ignore_util_est_rate_limit(sg_cpu, flags);
 
 	if (sugov_should_update_freq(sg_policy, time)) {
 		next_f = sugov_next_freq_shared(sg_cpu, time);
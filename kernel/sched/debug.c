@@ -1242,6 +1242,17 @@ void proc_sched_show_task(struct task_struct *p, struct pid_namespace *ns,
 	__PS("nr_voluntary_switches", p->nvcsw);
 	__PS("nr_involuntary_switches", p->nivcsw);
 
+#ifdef CONFIG_SCHED_INFO
+	if (sched_info_on()) {
+		int i;
+
+		SEQ_printf(m, "%-45s:", "sched_info.run_delay_hist");
+		for (i = 0; i < SCHED_RUN_DELAY_BUCKETS; i++)
+			SEQ_printf(m, " %u", p->sched_info.run_delay_hist[i]);
+		SEQ_printf(m, "\n");
+	}
+#endif
+
 	P(se.load.weight);
 #ifdef CONFIG_SMP
 	P(se.avg.load_sum);
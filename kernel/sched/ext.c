@@ -1118,8 +1118,52 @@ static void scx_kf_disallow(u32 mask)
 	current->scx.kf_mask &= ~mask;
 }
 
+/*
+ * Per-operation cost of the BPF scheduler, collected while enabled through
+ * /sys/kernel/sched_ext/root/op_stats. Latencies go into log2 buckets, the
+ * first covering up to 64ns and the last everything from 1ms up.
+ */
+#define SCX_OP_LAT_SHIFT	6
+#define SCX_OP_LAT_BUCKETS	16
+
+struct scx_op_stats {
+	u64			nr;
+	u64			nsecs;
+	u64			lat[SCX_OP_LAT_BUCKETS];
+};
+
+static DEFINE_STATIC_KEY_FALSE(scx_op_stats_enabled);
+static DEFINE_PER_CPU(struct scx_op_stats [SCX_OPI_END], scx_op_stats_cpu);
+
+static __always_inline u64 scx_op_stats_begin(void)
+{
+	if (static_branch_unlikely(&scx_op_stats_enabled))
+		return local_clock();
+	return 0;
+}
+
+/* @idx is constant, always inline to cull the ops that aren't tracked */
+static __always_inline void scx_op_stats_end(int idx, u64 start)
+{
+	u64 delta;
+	int bucket;
+
+	if (idx >= SCX_OPI_END || !start)
+		return;
+
+	delta = local_clock() - start;
+	bucket = clamp_t(int, fls64(delta) - SCX_OP_LAT_SHIFT, 0,
+			 SCX_OP_LAT_BUCKETS - 1);
+
+	/* some ops may sleep, stick to preemption safe updates */
+	this_cpu_inc(scx_op_stats_cpu[idx].nr);
+	this_cpu_add(scx_op_stats_cpu[idx].nsecs, delta);
+	this_cpu_inc(scx_op_stats_cpu[idx].lat[bucket]);
+}
+
 #define SCX_CALL_OP(mask, op, args...)						\
 do {										\
+	u64 __start = scx_op_stats_begin();					\
 	if (mask) {								\
 		scx_kf_allow(mask);						\
 		scx_ops.op(args);						\
@@ -1127,11 +1171,13 @@ do {										\
 	} else {								\
 		scx_ops.op(args);						\
 	}									\
+	scx_op_stats_end(SCX_OP_IDX(op), __start);				\
 } while (0)
 
 #define SCX_CALL_OP_RET(mask, op, args...)					\
 ({										\
 	__typeof__(scx_ops.op(args)) __ret;					\
+	u64 __start = scx_op_stats_begin();					\
 	if (mask) {								\
 		scx_kf_allow(mask);						\
 		__ret = scx_ops.op(args);					\
@@ -1139,6 +1185,7 @@ do {										\
 	} else {								\
 		__ret = scx_ops.op(args);					\
 	}									\
+	scx_op_stats_end(SCX_OP_IDX(op), __start);				\
 	__ret;									\
 })
 
@@ -4382,9 +4429,129 @@ static ssize_t scx_attr_events_show(struct kobject *kobj,
 }
 SCX_ATTR(events);
 
+#define SCX_OP_NAME(op)		[SCX_OP_IDX(op)] = #op
+
+static const char *scx_op_names[SCX_OPI_END] = {
+	SCX_OP_NAME(select_cpu),
+	SCX_OP_NAME(enqueue),
+	SCX_OP_NAME(dequeue),
+	SCX_OP_NAME(dispatch),
+	SCX_OP_NAME(tick),
+	SCX_OP_NAME(runnable),
+	SCX_OP_NAME(running),
+	SCX_OP_NAME(stopping),
+	SCX_OP_NAME(quiescent),
+	SCX_OP_NAME(yield),
+	SCX_OP_NAME(core_sched_before),
+	SCX_OP_NAME(set_weight),
+	SCX_OP_NAME(set_cpumask),
+	SCX_OP_NAME(update_idle),
+	SCX_OP_NAME(cpu_acquire),
+	SCX_OP_NAME(cpu_release),
+	SCX_OP_NAME(init_task),
+	SCX_OP_NAME(exit_task),
+	SCX_OP_NAME(enable),
+	SCX_OP_NAME(disable),
+	SCX_OP_NAME(dump),
+	SCX_OP_NAME(dump_cpu),
+	SCX_OP_NAME(dump_task),
+#ifdef CONFIG_EXT_GROUP_SCHED
+	SCX_OP_NAME(cgroup_init),
+	SCX_OP_NAME(cgroup_exit),
+	SCX_OP_NAME(cgroup_prep_move),
+	SCX_OP_NAME(cgroup_move),
+	SCX_OP_NAME(cgroup_cancel_move),
+	SCX_OP_NAME(cgroup_set_weight),
+#endif
+	SCX_OP_NAME(cpu_online),
+	SCX_OP_NAME(cpu_offline),
+};
+
+/* upper bound of the latency below which @pct percent of the calls finished */
+static u64 scx_op_stats_pct(const struct scx_op_stats *st, unsigned int pct)
+{
+	u64 target = div_u64(st->nr * pct + 99, 100), sum = 0;
+	int bucket;
+
+	for (bucket = 0; bucket < SCX_OP_LAT_BUCKETS - 1; bucket++) {
+		sum += st->lat[bucket];
+		if (sum >= target)
+			break;
+	}
+
+	return 1ULL << (bucket + SCX_OP_LAT_SHIFT);
+}
+
+static void scx_op_stats_reset(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		memset(per_cpu_ptr(scx_op_stats_cpu, cpu), 0,
+		       sizeof(scx_op_stats_cpu));
+}
+
+static ssize_t scx_attr_op_stats_show(struct kobject *kobj,
+				      struct kobj_attribute *ka, char *buf)
+{
+	struct scx_op_stats st;
+	int idx, cpu, bucket, at = 0;
+
+	for (idx = 0; idx < SCX_OPI_END; idx++) {
+		if (!scx_op_names[idx])
+			continue;
+
+		memset(&st, 0, sizeof(st));
+		for_each_possible_cpu(cpu) {
+			struct scx_op_stats *pcpu = &per_cpu(scx_op_stats_cpu, cpu)[idx];
+
+			st.nr += READ_ONCE(pcpu->nr);
+			st.nsecs += READ_ONCE(pcpu->nsecs);
+			for (bucket = 0; bucket < SCX_OP_LAT_BUCKETS; bucket++)
+				st.lat[bucket] += READ_ONCE(pcpu->lat[bucket]);
+		}
+		if (!st.nr)
+			continue;
+
+		at += sysfs_emit_at(buf, at, "%s nr %llu avg_ns %llu p50_ns %llu p99_ns %llu\n",
+				    scx_op_names[idx], st.nr, div64_u64(st.nsecs, st.nr),
+				    scx_op_stats_pct(&st, 50), scx_op_stats_pct(&st, 99));
+	}
+
+	return at;
+}
+
+/* writing 1 clears the counters and starts collecting, 0 stops */
+static ssize_t scx_attr_op_stats_store(struct kobject *kobj,
+				       struct kobj_attribute *ka,
+				       const char *buf, size_t count)
+{
+	bool enable;
+	int ret;
+
+	ret = kstrtobool(buf, &enable);
+	if (ret)
+		return ret;
+
+	if (enable) {
+		static_branch_disable(&scx_op_stats_enabled);
+		scx_op_stats_reset();
+		static_branch_enable(&scx_op_stats_enabled);
+	} else {
+		static_branch_disable(&scx_op_stats_enabled);
+	}
+
+	return count;
+}
+
+static struct kobj_attribute scx_attr_op_stats = __ATTR(op_stats, 0644,
+							  scx_attr_op_stats_show,
+							  scx_attr_op_stats_store);
+
 static struct attribute *scx_sched_attrs[] = {
 	&scx_attr_ops.attr,
 	&scx_attr_events.attr,
+	&scx_attr_op_stats.attr,
 	NULL,
 };
 ATTRIBUTE_GROUPS(scx_sched);
@@ -5285,6 +5452,10 @@ static int scx_ops_enable(struct sched_ext_ops *ops, struct bpf_link *link)
 		goto err_unlock;
 	}
 
+	/* op_stats describe the scheduler being loaded, start from scratch */
+	static_branch_disable(&scx_op_stats_enabled);
+	scx_op_stats_reset();
+
 	scx_root_kobj = kzalloc(sizeof(*scx_root_kobj), GFP_KERNEL);
 	if (!scx_root_kobj) {
 		ret = -ENOMEM;
@@ -6390,6 +6561,64 @@ __bpf_kfunc bool scx_bpf_dsq_move_to_local(u64 dsq_id)
 	}
 }
 
+static bool consume_user_dsq(struct scx_dsp_ctx *dspc, u64 dsq_id)
+{
+	struct scx_dispatch_q *dsq = find_user_dsq(dsq_id);
+
+	if (!dsq || !consume_dispatch_q(dspc->rq, dsq))
+		return false;
+
+	/* see scx_bpf_dsq_move_to_local() */
+	dspc->nr_tasks++;
+	return true;
+}
+
+/**
+ * scx_bpf_dsq_move_to_local_llc - move a task from a per-LLC sharded DSQ to the
+ * current CPU's local DSQ
+ * @dsq_base: base ID of the sharded DSQ
+ *
+ * A sharded DSQ is a set of user DSQs, one per LLC, with IDs @dsq_base plus
+ * scx_bpf_cpu_llc_id() of the LLC's CPUs. Inserting into the shard of the
+ * target CPU's LLC keeps a shared queue's lock and cachelines within one LLC.
+ *
+ * Move a task from the current CPU's shard, or failing that steal one from
+ * the other shards, those on the same NUMA node first. Shards that haven't
+ * been created are skipped. Can only be called from ops.dispatch(), see
+ * scx_bpf_dsq_move_to_local() for the rest of the semantics.
+ *
+ * Returns %true if a task has been moved, %false if all shards are empty.
+ */
+__bpf_kfunc bool scx_bpf_dsq_move_to_local_llc(u64 dsq_base)
+{
+	struct scx_dsp_ctx *dspc = this_cpu_ptr(scx_dsp_ctx);
+	int this_cpu, this_llc, cpu, pass;
+
+	if (!scx_kf_allowed(SCX_KF_DISPATCH))
+		return false;
+
+	flush_dispatch_buf(dspc->rq);
+
+	this_cpu = cpu_of(dspc->rq);
+	this_llc = per_cpu(sd_llc_id, this_cpu);
+	if (consume_user_dsq(dspc, dsq_base + this_llc))
+		return true;
+
+	for (pass = 0; pass < 2; pass++) {
+		for_each_cpu_wrap(cpu, cpu_online_mask, this_cpu + 1) {
+			/* visit each LLC once, through its first CPU */
+			if (per_cpu(sd_llc_id, cpu) != cpu || cpu == this_llc)
+				continue;
+			if ((cpu_to_node(cpu) == cpu_to_node(this_cpu)) == pass)
+				continue;
+			if (consume_user_dsq(dspc, dsq_base + cpu))
+				return true;
+		}
+	}
+
+	return false;
+}
+
 /* for backward compatibility, will be removed in v6.15 */
 __bpf_kfunc bool scx_bpf_consume(u64 dsq_id)
 {
@@ -6531,6 +6760,7 @@ BTF_KFUNCS_START(scx_kfunc_ids_dispatch)
 BTF_ID_FLAGS(func, scx_bpf_dispatch_nr_slots)
 BTF_ID_FLAGS(func, scx_bpf_dispatch_cancel)
 BTF_ID_FLAGS(func, scx_bpf_dsq_move_to_local)
+BTF_ID_FLAGS(func, scx_bpf_dsq_move_to_local_llc)
 BTF_ID_FLAGS(func, scx_bpf_consume)
 BTF_ID_FLAGS(func, scx_bpf_dsq_move_set_slice)
 BTF_ID_FLAGS(func, scx_bpf_dsq_move_set_vtime)
@@ -7167,6 +7397,22 @@ __bpf_kfunc struct rq *scx_bpf_cpu_rq(s32 cpu)
 	return cpu_rq(cpu);
 }
 
+/**
+ * scx_bpf_cpu_llc_id - Return the ID of the LLC @cpu belongs to
+ * @cpu: target CPU
+ *
+ * The ID is the lowest numbered CPU sharing the LLC with @cpu and may change
+ * across CPU hotplug and sched domain rebuilds. Returns -EINVAL and triggers
+ * an error if @cpu is invalid.
+ */
+__bpf_kfunc s32 scx_bpf_cpu_llc_id(s32 cpu)
+{
+	if (!ops_cpu_valid(cpu, NULL))
+		return -EINVAL;
+
+	return per_cpu(sd_llc_id, cpu);
+}
+
 /**
  * scx_bpf_task_cgroup - Return the sched cgroup of a task
  * @p: task of interest
@@ -7323,6 +7569,7 @@ BTF_ID_FLAGS(func, scx_bpf_pick_any_cpu, KF_RCU)
 BTF_ID_FLAGS(func, scx_bpf_task_running, KF_RCU)
 BTF_ID_FLAGS(func, scx_bpf_task_cpu, KF_RCU)
 BTF_ID_FLAGS(func, scx_bpf_cpu_rq)
+BTF_ID_FLAGS(func, scx_bpf_cpu_llc_id)
 #ifdef CONFIG_CGROUP_SCHED
 BTF_ID_FLAGS(func, scx_bpf_task_cgroup, KF_RCU | KF_ACQUIRE)
 #endif
@@ -53,6 +53,7 @@
 #include <asm/switch_to.h>
 
 #include <uapi/linux/sched/types.h>
+#include <uapi/linux/prctl.h>
 
 #include "sched.h"
 #include "stats.h"
@@ -3482,7 +3483,10 @@ static void task_numa_work(struct callback_head *work)
 			start = max(start, vma->vm_start);
 			end = ALIGN(start + (pages << PAGE_SHIFT), HPAGE_SIZE);
 			end = min(end, vma->vm_end);
-			nr_pte_updates = change_prot_numa(vma, start, end);
+			if (READ_ONCE(mm->numa_scan_mode) == PR_NUMA_SCAN_ACCESSED)
+				nr_pte_updates = numa_scan_accessed(vma, start, end);
+			else
+				nr_pte_updates = change_prot_numa(vma, start, end);
 
 			/*
 			 * Try to scan sysctl_numa_balancing_size worth of
@@ -5762,6 +5766,41 @@ static int __assign_cfs_rq_runtime(struct cfs_bandwidth *cfs_b,
 	return cfs_rq->runtime_remaining > 0;
 }
 
+/*
+ * Bounds of the per-cfs_rq slice, relative to sched_cfs_bandwidth_slice().
+ */
+#define CFS_SLICE_MAX_SCALE	4
+#define CFS_SLICE_MIN_SCALE	4
+
+/*
+ * Size the next slice handed to @cfs_rq.  A cfs_rq that comes back for more
+ * within the same period gets a larger one, so busy CPUs take cfs_b->lock
+ * less often; one that returned slack on going idle got a smaller one (see
+ * __return_cfs_rq_runtime()), so less quota sits unused on idle CPUs while
+ * others throttle.  A grown slice never takes more than half of what is
+ * left in the pool.
+ */
+static u64 cfs_rq_runtime_slice(struct cfs_bandwidth *cfs_b,
+				struct cfs_rq *cfs_rq)
+{
+	u64 base = sched_cfs_bandwidth_slice();
+	u64 slice = cfs_rq->runtime_slice ?: base;
+
+	lockdep_assert_held(&cfs_b->lock);
+
+	if (cfs_rq->runtime_period == cfs_b->nr_periods)
+		slice *= 2;
+	slice = clamp(slice, base / CFS_SLICE_MIN_SCALE,
+		      base * CFS_SLICE_MAX_SCALE);
+	cfs_rq->runtime_period = cfs_b->nr_periods;
+	cfs_rq->runtime_slice = slice;
+
+	if (cfs_b->quota != RUNTIME_INF && slice > base)
+		slice = max(base, min(slice, cfs_b->runtime / 2));
+
+	return slice;
+}
+
 /* returns 0 on failure to allocate runtime */
 static int assign_cfs_rq_runtime(struct cfs_rq *cfs_rq)
 {
@@ -5769,7 +5808,8 @@ static int assign_cfs_rq_runtime(struct cfs_rq *cfs_rq)
 	int ret;
 
 	raw_spin_lock(&cfs_b->lock);
-	ret = __assign_cfs_rq_runtime(cfs_b, cfs_rq, sched_cfs_bandwidth_slice());
+	ret = __assign_cfs_rq_runtime(cfs_b, cfs_rq,
+				      cfs_rq_runtime_slice(cfs_b, cfs_rq));
 	raw_spin_unlock(&cfs_b->lock);
 
 	return ret;
@@ -5984,6 +6024,19 @@ static bool throttle_cfs_rq(struct cfs_rq *cfs_rq)
 	return true;
 }
 
+static unsigned int cfs_throttle_hist_bucket(u64 throttled)
+{
+	unsigned int bucket = 0;
+	u64 limit = NSEC_PER_MSEC;
+
+	while (bucket < CFS_THROTTLE_HIST_BUCKETS - 1 && throttled >= limit) {
+		limit *= 10;
+		bucket++;
+	}
+
+	return bucket;
+}
+
 void unthrottle_cfs_rq(struct cfs_rq *cfs_rq)
 {
 	struct rq *rq = rq_of(cfs_rq);
@@ -6000,7 +6053,10 @@ void unthrottle_cfs_rq(struct cfs_rq *cfs_rq)
 
 	raw_spin_lock(&cfs_b->lock);
 	if (cfs_rq->throttled_clock) {
-		cfs_b->throttled_time += rq_clock(rq) - cfs_rq->throttled_clock;
+		u64 throttled = rq_clock(rq) - cfs_rq->throttled_clock;
+
+		cfs_b->throttled_time += throttled;
+		cfs_b->throttled_hist[cfs_throttle_hist_bucket(throttled)]++;
 		cfs_rq->throttled_clock = 0;
 	}
 	list_del_rcu(&cfs_rq->throttled_list);
@@ -6360,6 +6416,10 @@ static void __return_cfs_rq_runtime(struct cfs_rq *cfs_rq)
 	if (slack_runtime <= 0)
 		return;
 
+	/* Most of the last slice went unused, hand out less next time. */
+	if (cfs_rq->runtime_slice && slack_runtime > cfs_rq->runtime_slice / 2)
+		cfs_rq->runtime_slice /= 2;
+
 	raw_spin_lock(&cfs_b->lock);
 	if (cfs_b->quota != RUNTIME_INF) {
 		cfs_b->runtime += slack_runtime;
@@ -6933,6 +6993,7 @@ enqueue_task_fair(struct rq *rq, struct task_struct *p, int flags)
 	int h_nr_runnable = 1;
 	int task_new = !(flags & ENQUEUE_WAKEUP);
 	int rq_h_nr_queued = rq->cfs.h_nr_queued;
+	unsigned int cpufreq_flags = 0;
 	u64 slice = 0;
 
 	/*
@@ -6953,9 +7014,18 @@ enqueue_task_fair(struct rq *rq, struct task_struct *p, int flags)
 	 * If in_iowait is set, the code below may not trigger any cpufreq
 	 * utilization updates, so do it here explicitly with the IOWAIT flag
 	 * passed.
+	 *
+	 * Likewise tell schedutil about the estimated utilization of a
+	 * waking task, which it may otherwise only act on a rate limit
+	 * period later, after the task has run its burst at the old
+	 * frequency.
 	 */
 	if (p->in_iowait)
-		cpufreq_update_util(rq, SCHED_CPUFREQ_IOWAIT);
+		cpufreq_flags |= SCHED_CPUFREQ_IOWAIT;
+	if (sched_feat(UTIL_EST) && !task_new && _task_util_est(p))
+		cpufreq_flags |= SCHED_CPUFREQ_UTIL_EST;
+	if (cpufreq_flags)
+		cpufreq_update_util(rq, cpufreq_flags);
 
 	if (task_new && se->sched_delayed)
 		h_nr_runnable = 0;
@@ -7203,6 +7273,7 @@ static bool dequeue_task_fair(struct rq *rq, struct task_struct *p, int flags)
 /* Working cpumask for: sched_balance_rq(), sched_balance_newidle(). */
 static DEFINE_PER_CPU(cpumask_var_t, load_balance_mask);
 static DEFINE_PER_CPU(cpumask_var_t, select_rq_mask);
+static DEFINE_PER_CPU(cpumask_var_t, select_idle_mask);
 static DEFINE_PER_CPU(cpumask_var_t, should_we_balance_tmpmask);
 
 #ifdef CONFIG_NO_HZ_COMMON
@@ -7411,11 +7482,49 @@ wake_affine_weight(struct sched_domain *sd, struct task_struct *p,
 	return this_eff_load < prev_eff_load ? this_cpu : nr_cpumask_bits;
 }
 
+#ifdef CONFIG_CPUSETS
+/*
+ * The memory of a task whose cpuset.mems does not span all memory nodes
+ * lives on the nodes it is allowed, whether or not NUMA balancing has seen
+ * any of its faults (it doesn't scan MPOL_BIND memory at all).  Moving the
+ * task from such a node to one outside the set degrades its locality (1),
+ * moving it back improves it (-1).
+ */
+static int task_mems_locality(struct task_struct *p, int src_nid, int dst_nid)
+{
+	bool src_in, dst_in;
+
+	if (!sched_feat(MEMS_LOCALITY) || src_nid == dst_nid)
+		return 0;
+
+	if (nodes_subset(node_states[N_MEMORY], p->mems_allowed))
+		return 0;
+
+	src_in = node_isset(src_nid, p->mems_allowed);
+	dst_in = node_isset(dst_nid, p->mems_allowed);
+	if (src_in == dst_in)
+		return 0;
+
+	return dst_in ? -1 : 1;
+}
+#else
+static inline int task_mems_locality(struct task_struct *p, int src_nid,
+				     int dst_nid)
+{
+	return 0;
+}
+#endif
+
 static int wake_affine(struct sched_domain *sd, struct task_struct *p,
 		       int this_cpu, int prev_cpu, int sync)
 {
 	int target = nr_cpumask_bits;
 
+	/* Don't pull the wakee away from the nodes its memory is bound to. */
+	if ((sd->flags & SD_NUMA) &&
+	    task_mems_locality(p, cpu_to_node(prev_cpu), cpu_to_node(this_cpu)) > 0)
+		return prev_cpu;
+
 	if (sched_feat(WA_IDLE))
 		target = wake_affine_idle(this_cpu, prev_cpu, sync);
 
@@ -7658,7 +7767,8 @@ static int select_idle_smt(struct task_struct *p, struct sched_domain *sd, int t
 		 */
 		if (!cpumask_test_cpu(cpu, sched_domain_span(sd)))
 			continue;
-		if (available_idle_cpu(cpu) || sched_idle_cpu(cpu))
+		if ((available_idle_cpu(cpu) || sched_idle_cpu(cpu)) &&
+		    sched_cpu_cookie_match(cpu_rq(cpu), p))
 			return cpu;
 	}
 
@@ -7688,6 +7798,66 @@ static inline int select_idle_smt(struct task_struct *p, struct sched_domain *sd
 
 #endif /* CONFIG_SCHED_SMT */
 
+/*
+ * Called when @rq switches to its idle task.  The bit is only set here; it is
+ * cleared by whichever wakeup claims the CPU, or finds it busy, in
+ * select_idle_from_mask(), so a CPU going in and out of idle without being
+ * picked by a wakeup does not keep bouncing the mask's cache line.
+ */
+void update_idle_cpu_mask(struct rq *rq)
+{
+	struct sched_domain_shared *sds;
+	int cpu = cpu_of(rq);
+
+	rcu_read_lock();
+	sds = rcu_dereference(per_cpu(sd_llc_shared, cpu));
+	if (sds && !cpumask_test_cpu(cpu, sds_idle_cpus(sds)))
+		cpumask_set_cpu(cpu, sds_idle_cpus(sds));
+	rcu_read_unlock();
+}
+
+/*
+ * Look for an idle core (@has_idle_core) or an idle CPU among the CPUs of
+ * @cpus that the LLC idle mask marks as idle.  This costs a few bitmap
+ * operations instead of touching the runqueue of every CPU in the LLC; CPUs
+ * that turn out to be busy are dropped from the mask on the way.
+ */
+static int select_idle_from_mask(struct task_struct *p,
+				 struct sched_domain_shared *sds,
+				 struct cpumask *cpus, bool has_idle_core,
+				 int target, int *idle_cpu)
+{
+	struct cpumask *idle = this_cpu_cpumask_var_ptr(select_idle_mask);
+	int i, cpu;
+
+	if (!cpumask_and(idle, cpus, sds_idle_cpus(sds)))
+		return -1;
+
+	for_each_cpu_wrap(cpu, idle, target + 1) {
+		if (has_idle_core) {
+			i = select_idle_core(p, cpu, idle, idle_cpu);
+			if ((unsigned int)i < nr_cpumask_bits) {
+				cpumask_clear_cpu(i, sds_idle_cpus(sds));
+				return i;
+			}
+			continue;
+		}
+
+		i = __select_idle_cpu(cpu, p);
+		if ((unsigned int)i < nr_cpumask_bits) {
+			cpumask_clear_cpu(i, sds_idle_cpus(sds));
+			return i;
+		}
+		if (!available_idle_cpu(cpu))
+			cpumask_clear_cpu(cpu, sds_idle_cpus(sds));
+	}
+
+	if ((unsigned int)*idle_cpu < nr_cpumask_bits)
+		cpumask_clear_cpu(*idle_cpu, sds_idle_cpus(sds));
+
+	return -1;
+}
+
 /*
  * Scan the LLC domain for idle CPUs; this is dynamically regulated by
  * comparing the average scan cost (tracked in sd->avg_scan_cost) against the
@@ -7700,18 +7870,41 @@ static int select_idle_cpu(struct task_struct *p, struct sched_domain *sd, bool
 	struct sched_domain_shared *sd_share;
 
 	cpumask_and(cpus, sched_domain_span(sd), p->cpus_ptr);
+	sd_share = rcu_dereference(per_cpu(sd_llc_shared, target));
 
-	if (sched_feat(SIS_UTIL)) {
-		sd_share = rcu_dereference(per_cpu(sd_llc_shared, target));
-		if (sd_share) {
-			/* because !--nr is the condition to stop scan */
-			nr = READ_ONCE(sd_share->nr_idle_scan) + 1;
-			/* overloaded LLC is unlikely to have idle cpu/core */
-			if (nr == 1)
-				return -1;
+	/*
+	 * The mask lookup ignores cluster locality, leave that to the scan
+	 * below.
+	 */
+	if (sched_feat(SIS_IDLE_MASK) && sd_share &&
+	    !(static_branch_unlikely(&sched_cluster_active) &&
+	      (sd->groups->flags & SD_CLUSTER))) {
+		i = select_idle_from_mask(p, sd_share, cpus, has_idle_core,
+					  target, &idle_cpu);
+		if ((unsigned int)i < nr_cpumask_bits)
+			return i;
+
+		/*
+		 * Every CPU of an idle core would be in the mask, so there
+		 * is none left; an idle SMT sibling found on the way will do.
+		 * Otherwise scan for sched_idle CPUs and those the mask missed.
+		 */
+		if (has_idle_core) {
+			set_idle_cores(target, false);
+			if ((unsigned int)idle_cpu < nr_cpumask_bits)
+				return idle_cpu;
+			has_idle_core = false;
 		}
 	}
 
+	if (sched_feat(SIS_UTIL) && sd_share) {
+		/* because !--nr is the condition to stop scan */
+		nr = READ_ONCE(sd_share->nr_idle_scan) + 1;
+		/* overloaded LLC is unlikely to have idle cpu/core */
+		if (nr == 1)
+			return -1;
+	}
+
 	if (static_branch_unlikely(&sched_cluster_active)) {
 		struct sched_group *sg = sd->groups;
 
@@ -7852,6 +8045,7 @@ static int select_idle_sibling(struct task_struct *p, int prev, int target)
 	lockdep_assert_irqs_disabled();
 
 	if ((available_idle_cpu(target) || sched_idle_cpu(target)) &&
+	    sched_core_cookie_match(cpu_rq(target), p) &&
 	    asym_fits_cpu(task_util, util_min, util_max, target))
 		return target;
 
@@ -7860,6 +8054,7 @@ static int select_idle_sibling(struct task_struct *p, int prev, int target)
 	 */
 	if (prev != target && cpus_share_cache(prev, target) &&
 	    (available_idle_cpu(prev) || sched_idle_cpu(prev)) &&
+	    sched_core_cookie_match(cpu_rq(prev), p) &&
 	    asym_fits_cpu(task_util, util_min, util_max, prev)) {
 
 		if (!static_branch_unlikely(&sched_cluster_active) ||
@@ -7892,6 +8087,7 @@ static int select_idle_sibling(struct task_struct *p, int prev, int target)
 	    recent_used_cpu != target &&
 	    cpus_share_cache(recent_used_cpu, target) &&
 	    (available_idle_cpu(recent_used_cpu) || sched_idle_cpu(recent_used_cpu)) &&
+	    sched_core_cookie_match(cpu_rq(recent_used_cpu), p) &&
 	    cpumask_test_cpu(recent_used_cpu, p->cpus_ptr) &&
 	    asym_fits_cpu(task_util, util_min, util_max, recent_used_cpu)) {
 
@@ -7930,7 +8126,13 @@ static int select_idle_sibling(struct task_struct *p, int prev, int target)
 	if (sched_smt_active()) {
 		has_idle_core = test_idle_cores(target);
 
-		if (!has_idle_core && cpus_share_cache(prev, target)) {
+		/*
+		 * With core scheduling, an idle sibling of a core already
+		 * running @p's cookie beats an idle core: it pairs @p up and
+		 * leaves the idle core to other cookies.
+		 */
+		if ((!has_idle_core || sched_core_cookie_paired(cpu_rq(prev), p)) &&
+		    cpus_share_cache(prev, target)) {
 			i = select_idle_smt(p, sd, prev);
 			if ((unsigned int)i < nr_cpumask_bits)
 				return i;
@@ -9249,12 +9451,33 @@ struct lb_env {
 	struct list_head	tasks;
 };
 
+/*
+ * Cap on how far a task's cache footprint extends its hot window, in units of
+ * sysctl_sched_migration_cost.
+ */
+#define LLC_FOOTPRINT_MAX_SCALE	8
+
+/*
+ * Rough estimate of how much of the (source) LLC a task has warmed up, in
+ * nanoseconds of runtime: the length of its last stint on the CPU.  A task
+ * that ran for long just before it was preempted likely left a large
+ * working set behind, one that only wakes up for a few microseconds likely
+ * did not.
+ */
+static u64 task_llc_footprint(struct task_struct *p)
+{
+	u64 footprint = p->se.sum_exec_runtime - p->se.prev_sum_exec_runtime;
+
+	return min_t(u64, footprint,
+		     LLC_FOOTPRINT_MAX_SCALE * sysctl_sched_migration_cost);
+}
+
 /*
  * Is this task likely cache-hot:
  */
 static int task_hot(struct task_struct *p, struct lb_env *env)
 {
-	s64 delta;
+	s64 delta, hot_time;
 
 	lockdep_assert_rq_held(env->src_rq);
 
@@ -9289,8 +9512,17 @@ static int task_hot(struct task_struct *p, struct lb_env *env)
 		return 0;
 
 	delta = rq_clock_task(env->src_rq) - p->se.exec_start;
+	hot_time = sysctl_sched_migration_cost;
+
+	/*
+	 * Leaving the LLC throws away whatever the task built up in it, so
+	 * keep tasks with a large footprint hot for longer; can_migrate_task()
+	 * then picks tasks with a small one first.
+	 */
+	if (sched_feat(CACHE_HOT_FOOTPRINT) && !(env->sd->flags & SD_SHARE_LLC))
+		hot_time += task_llc_footprint(p);
 
-	return delta < (s64)sysctl_sched_migration_cost;
+	return delta < hot_time;
 }
 
 #ifdef CONFIG_NUMA_BALANCING
@@ -9304,11 +9536,12 @@ static long migrate_degrades_locality(struct task_struct *p, struct lb_env *env)
 	struct numa_group *numa_group = rcu_dereference(p->numa_group);
 	unsigned long src_weight, dst_weight;
 	int src_nid, dst_nid, dist;
+	long mems;
 
 	if (!static_branch_likely(&sched_numa_balancing))
 		return 0;
 
-	if (!p->numa_faults || !(env->sd->flags & SD_NUMA))
+	if (!(env->sd->flags & SD_NUMA))
 		return 0;
 
 	src_nid = cpu_to_node(env->src_cpu);
@@ -9317,6 +9550,18 @@ static long migrate_degrades_locality(struct task_struct *p, struct lb_env *env)
 	if (src_nid == dst_nid)
 		return 0;
 
+	/*
+	 * Memory bound by cpuset.mems trumps the fault statistics, which the
+	 * task may not have at all.  This stays a soft preference: it only
+	 * makes the task cache hot, see can_migrate_task().
+	 */
+	mems = task_mems_locality(p, src_nid, dst_nid);
+	if (mems)
+		return mems;
+
+	if (!p->numa_faults)
+		return 0;
+
 	/* Migrating away from the preferred node is always bad. */
 	if (src_nid == p->numa_preferred_nid) {
 		if (env->src_rq->nr_running > env->src_rq->nr_preferred_running)
@@ -13708,6 +13953,7 @@ __init void init_sched_fair_class(void)
 	for_each_possible_cpu(i) {
 		zalloc_cpumask_var_node(&per_cpu(load_balance_mask, i), GFP_KERNEL, cpu_to_node(i));
 		zalloc_cpumask_var_node(&per_cpu(select_rq_mask,    i), GFP_KERNEL, cpu_to_node(i));
+		zalloc_cpumask_var_node(&per_cpu(select_idle_mask,  i), GFP_KERNEL, cpu_to_node(i));
 		zalloc_cpumask_var_node(&per_cpu(should_we_balance_tmpmask, i),
 					GFP_KERNEL, cpu_to_node(i));
 
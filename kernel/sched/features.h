@@ -46,6 +46,12 @@ SCHED_FEAT(PICK_BUDDY, true)
  */
 SCHED_FEAT(CACHE_HOT_BUDDY, true)
 
+/*
+ * Consider tasks that ran for long before being preempted cache hot for
+ * longer when balancing across LLCs.
+ */
+SCHED_FEAT(CACHE_HOT_FOOTPRINT, true)
+
 /*
  * Delay dequeueing tasks until they get selected or woken.
  *
@@ -82,11 +88,21 @@ SCHED_FEAT(TTWU_QUEUE, false)
 SCHED_FEAT(TTWU_QUEUE, true)
 #endif
 
+/*
+ * Send the wake_list IPIs of wake_up_q() once, for all targets, at the end.
+ */
+SCHED_FEAT(TTWU_BATCH, true)
+
 /*
  * When doing wakeups, attempt to limit superfluous scans of the LLC domain.
  */
 SCHED_FEAT(SIS_UTIL, true)
 
+/*
+ * Look up idle CPUs in the LLC idle mask before scanning the LLC.
+ */
+SCHED_FEAT(SIS_IDLE_MASK, true)
+
 /*
  * Issue a WARN when we do multiple update_rq_clock() calls
  * in a single rq->lock section. Default disabled because the
@@ -115,6 +131,12 @@ SCHED_FEAT(WA_IDLE, true)
 SCHED_FEAT(WA_WEIGHT, true)
 SCHED_FEAT(WA_BIAS, true)
 
+/*
+ * Keep tasks whose cpuset restricts their memory to a subset of the nodes
+ * on those nodes, both at wakeup and in the load balancer.
+ */
+SCHED_FEAT(MEMS_LOCALITY, true)
+
 /*
  * UtilEstimation. Use estimated CPU utilization.
  */
@@ -71,6 +71,99 @@ static noinline int __cpuidle cpu_idle_poll(void)
 	return 1;
 }
 
+/*
+ * Adaptive poll before entering the idle loop proper.  Each CPU spins for
+ * up to idle_poll_ns with the polling bit set, so that a wakeup arriving
+ * within that window neither pays for an IPI nor for a C-state exit.  The
+ * window is learned from the length of the previous idle periods, the same
+ * way the haltpoll governor does for guests: it grows while CPUs go idle
+ * for less than sysctl_sched_idle_poll_ns, and shrinks once the gaps get
+ * longer than that, so a CPU which is really idle does not keep spinning.
+ */
+#define IDLE_POLL_GROW_START_NS		(10 * NSEC_PER_USEC)
+#define IDLE_POLL_RELAX_COUNT		200
+
+static unsigned int sysctl_sched_idle_poll_ns;
+static DEFINE_PER_CPU(unsigned int, idle_poll_ns);
+/* keeps the local_clock() reads out of do_idle() while polling is off */
+static DEFINE_STATIC_KEY_FALSE(sched_idle_poll_key);
+
+#ifdef CONFIG_SYSCTL
+static int sched_idle_poll_handler(const struct ctl_table *table, int write,
+				   void *buffer, size_t *lenp, loff_t *ppos)
+{
+	int ret;
+
+	ret = proc_douintvec_minmax(table, write, buffer, lenp, ppos);
+	if (ret || !write)
+		return ret;
+
+	if (READ_ONCE(sysctl_sched_idle_poll_ns))
+		static_branch_enable(&sched_idle_poll_key);
+	else
+		static_branch_disable(&sched_idle_poll_key);
+	return 0;
+}
+
+static const struct ctl_table sched_idle_sysctls[] = {
+	{
+		.procname	= "sched_idle_poll_ns",
+		.data		= &sysctl_sched_idle_poll_ns,
+		.maxlen		= sizeof(unsigned int),
+		.mode		= 0644,
+		.proc_handler	= sched_idle_poll_handler,
+		.extra1		= SYSCTL_ZERO,
+		.extra2		= SYSCTL_INT_MAX,
+	},
+};
+
+static int __init sched_idle_sysctl_init(void)
+{
+	register_sysctl_init("kernel", sched_idle_sysctls);
+	return 0;
+}
+late_initcall(sched_idle_sysctl_init);
+#endif
+
+static void idle_poll(void)
+{
+	unsigned int budget = __this_cpu_read(idle_poll_ns);
+	unsigned int loop = 0;
+	u64 start;
+
+	if (!budget || cpu_idle_force_poll)
+		return;
+
+	start = local_clock();
+	while (!need_resched()) {
+		cpu_relax();
+		if (++loop < IDLE_POLL_RELAX_COUNT)
+			continue;
+		loop = 0;
+		if (local_clock() - start > budget)
+			break;
+	}
+}
+
+static void idle_poll_update(u64 idle_ns)
+{
+	unsigned int max = READ_ONCE(sysctl_sched_idle_poll_ns);
+	unsigned int poll = __this_cpu_read(idle_poll_ns);
+
+	if (!max) {
+		poll = 0;
+	} else if (idle_ns <= poll) {
+		/* The wakeup was caught: keep the window. */
+		return;
+	} else if (idle_ns <= max) {
+		poll = poll ? min(poll * 2, max) :
+			      min_t(unsigned int, IDLE_POLL_GROW_START_NS, max);
+	} else {
+		poll /= 2;
+	}
+	__this_cpu_write(idle_poll_ns, poll);
+}
+
 /* Weak implementations for optional arch specific functions */
 void __weak arch_cpu_idle_prepare(void) { }
 void __weak arch_cpu_idle_enter(void) { }
@@ -252,6 +345,8 @@ static void cpuidle_idle_call(void)
 static void do_idle(void)
 {
 	int cpu = smp_processor_id();
+	bool poll = static_branch_unlikely(&sched_idle_poll_key);
+	u64 idle_start = 0;
 
 	/*
 	 * Check if we need to update blocked load
@@ -270,6 +365,12 @@ static void do_idle(void)
 	__current_set_polling();
 	tick_nohz_idle_enter();
 
+	if (poll) {
+		idle_start = local_clock();
+		if (!cpu_is_offline(cpu))
+			idle_poll();
+	}
+
 	while (!need_resched()) {
 
 		/*
@@ -335,6 +436,8 @@ static void do_idle(void)
 	 * an IPI to fold the state for us.
 	 */
 	preempt_set_need_resched();
+	if (poll)
+		idle_poll_update(local_clock() - idle_start);
 	tick_nohz_idle_exit();
 	__current_clr_polling();
 
@@ -458,6 +561,7 @@ static void put_prev_task_idle(struct rq *rq, struct task_struct *prev, struct t
 static void set_next_task_idle(struct rq *rq, struct task_struct *next, bool first)
 {
 	update_idle_core(rq);
+	update_idle_cpu_mask(rq);
 	scx_update_idle(rq, true, true);
 	schedstat_inc(rq->sched_goidle);
 	next->se.exec_start = rq_clock_task(rq);
@@ -165,6 +165,42 @@
 static DEFINE_MUTEX(membarrier_ipi_mutex);
 #define SERIALIZE_IPI() guard(mutex)(&membarrier_ipi_mutex)
 
+/*
+ * Concurrent private expedited membarriers on the same mm are serialized on
+ * membarrier_ipi_mutex anyway, so a caller finding that a whole IPI round
+ * started and completed after it entered the system call can return without
+ * sending its own.  The per-mm, per-flavor sequence number works like the
+ * RCU grace-period sequence: odd while a round is in flight, the snapshot
+ * taken on entry names the end of the first round started after it.
+ */
+static unsigned long membarrier_seq_snap(struct mm_struct *mm, int flags)
+{
+	return (READ_ONCE(mm->membarrier_seq[flags]) + 3) & ~1UL;
+}
+
+static bool membarrier_seq_done(struct mm_struct *mm, int flags,
+				unsigned long snap)
+{
+	lockdep_assert_held(&membarrier_ipi_mutex);
+	return ULONG_CMP_GE(READ_ONCE(mm->membarrier_seq[flags]), snap);
+}
+
+static void membarrier_seq_start(struct mm_struct *mm, int flags)
+{
+	WRITE_ONCE(mm->membarrier_seq[flags], mm->membarrier_seq[flags] + 1);
+	/*
+	 * Order the start of the round before looking at rq->curr: a caller
+	 * which took its snapshot before the increment has its stores made
+	 * visible by this round.
+	 */
+	smp_mb();
+}
+
+static void membarrier_seq_end(struct mm_struct *mm, int flags)
+{
+	WRITE_ONCE(mm->membarrier_seq[flags], mm->membarrier_seq[flags] + 1);
+}
+
 static void ipi_mb(void *info)
 {
 	smp_mb();	/* IPIs should be serializing but paranoid. */
@@ -316,6 +352,10 @@ static int membarrier_private_expedited(int flags, int cpu_id)
 	cpumask_var_t tmpmask;
 	struct mm_struct *mm = current->mm;
 	smp_call_func_t ipi_func = ipi_mb;
+	unsigned long snap = 0;
+
+	BUILD_BUG_ON(MEMBARRIER_FLAG_SYNC_CORE >= ARRAY_SIZE(mm->membarrier_seq) ||
+		     MEMBARRIER_FLAG_RSEQ >= ARRAY_SIZE(mm->membarrier_seq));
 
 	if (flags == MEMBARRIER_FLAG_SYNC_CORE) {
 		if (!IS_ENABLED(CONFIG_ARCH_HAS_MEMBARRIER_SYNC_CORE))
@@ -353,12 +393,21 @@ static int membarrier_private_expedited(int flags, int cpu_id)
 	 */
 	smp_mb();	/* system call entry is not a mb. */
 
-	if (cpu_id < 0 && !zalloc_cpumask_var(&tmpmask, GFP_KERNEL))
-		return -ENOMEM;
+	if (cpu_id < 0) {
+		snap = membarrier_seq_snap(mm, flags);
+		if (!zalloc_cpumask_var(&tmpmask, GFP_KERNEL))
+			return -ENOMEM;
+	}
 
 	SERIALIZE_IPI();
 	cpus_read_lock();
 
+	if (cpu_id < 0) {
+		if (membarrier_seq_done(mm, flags, snap))
+			goto out;
+		membarrier_seq_start(mm, flags);
+	}
+
 	if (cpu_id >= 0) {
 		struct task_struct *p;
 
@@ -416,6 +465,7 @@ static int membarrier_private_expedited(int flags, int cpu_id)
 		} else {
 			on_each_cpu_mask(tmpmask, ipi_func, NULL, true);
 		}
+		membarrier_seq_end(mm, flags);
 	}
 
 out:
@@ -589,14 +639,14 @@ static int membarrier_get_registrations(void)
 /**
  * sys_membarrier - issue memory barriers on a set of threads
  * @cmd:    Takes command values defined in enum membarrier_cmd.
- * @flags:  Currently needs to be 0 for all commands other than
- *          MEMBARRIER_CMD_PRIVATE_EXPEDITED_RSEQ: in the latter
- *          case it can be MEMBARRIER_CMD_FLAG_CPU, indicating that @cpu_id
- *          contains the CPU on which to interrupt (= restart)
- *          the RSEQ critical section.
+ * @flags:  Currently needs to be 0 for all commands other than the
+ *          MEMBARRIER_CMD_PRIVATE_EXPEDITED* ones: for those it can be
+ *          MEMBARRIER_CMD_FLAG_CPU, indicating that @cpu_id contains the
+ *          only CPU on which to issue the barrier (or interrupt, i.e.
+ *          restart, the RSEQ critical section).
  * @cpu_id: if @flags == MEMBARRIER_CMD_FLAG_CPU, indicates the cpu on which
- *          RSEQ CS should be interrupted (@cmd must be
- *          MEMBARRIER_CMD_PRIVATE_EXPEDITED_RSEQ).
+ *          the barrier should be issued (@cmd must be one of the
+ *          MEMBARRIER_CMD_PRIVATE_EXPEDITED* commands).
  *
  * If this system call is not implemented, -ENOSYS is returned. If the
  * command specified does not exist, not available on the running
@@ -625,6 +675,8 @@ static int membarrier_get_registrations(void)
 SYSCALL_DEFINE3(membarrier, int, cmd, unsigned int, flags, int, cpu_id)
 {
 	switch (cmd) {
+	case MEMBARRIER_CMD_PRIVATE_EXPEDITED:
+	case MEMBARRIER_CMD_PRIVATE_EXPEDITED_SYNC_CORE:
 	case MEMBARRIER_CMD_PRIVATE_EXPEDITED_RSEQ:
 		if (unlikely(flags && flags != MEMBARRIER_CMD_FLAG_CPU))
 			return -EINVAL;
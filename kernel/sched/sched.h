@@ -401,6 +401,8 @@ static inline bool dl_server_active(struct sched_dl_entity *dl_se)
 
 extern struct list_head task_groups;
 
+#define CFS_THROTTLE_HIST_BUCKETS	4
+
 struct cfs_bandwidth {
 #ifdef CONFIG_CFS_BANDWIDTH
 	raw_spinlock_t		lock;
@@ -424,6 +426,8 @@ struct cfs_bandwidth {
 	int			nr_burst;
 	u64			throttled_time;
 	u64			burst_time;
+	/* throttle episodes shorter than 1ms, 10ms, 100ms, and longer */
+	unsigned int		throttled_hist[CFS_THROTTLE_HIST_BUCKETS];
 #endif
 };
 
@@ -486,6 +490,14 @@ struct task_group {
 	struct uclamp_se	uclamp[UCLAMP_CNT];
 #endif
 
+#ifdef CONFIG_SCHED_INFO
+	/* Run delays of the tasks in this group and its descendants */
+	struct sched_run_delay_hist __percpu *run_delay_hist;
+#endif
+};
+
+struct sched_run_delay_hist {
+	u64			nr[SCHED_RUN_DELAY_BUCKETS];
 };
 
 #ifdef CONFIG_GROUP_SCHED_WEIGHT
@@ -722,6 +734,8 @@ struct cfs_rq {
 #ifdef CONFIG_CFS_BANDWIDTH
 	int			runtime_enabled;
 	s64			runtime_remaining;
+	u64			runtime_slice;
+	int			runtime_period;
 
 	u64			throttled_pelt_idle;
 #ifndef CONFIG_64BIT
@@ -1247,6 +1261,10 @@ struct rq {
 	ktime_t			hrtick_time;
 #endif
 
+#ifdef CONFIG_RSEQ
+	struct hrtimer		slice_ext_timer;
+#endif
+
 #ifdef CONFIG_SCHEDSTATS
 	/* latency stats */
 	struct sched_info	rq_sched_info;
@@ -1430,6 +1448,17 @@ static inline bool sched_core_cookie_match(struct rq *rq, struct task_struct *p)
 	return idle_core || rq->core->core_cookie == p->core_cookie;
 }
 
+/*
+ * Whether the core of @rq is running @p's (non-zero) cookie, i.e. whether an
+ * idle SMT sibling there would pair @p with its own kind instead of forcing
+ * someone idle.
+ */
+static inline bool sched_core_cookie_paired(struct rq *rq, struct task_struct *p)
+{
+	return sched_core_enabled(rq) && p->core_cookie &&
+	       rq->core->core_cookie == p->core_cookie;
+}
+
 static inline bool sched_group_cookie_match(struct rq *rq,
 					    struct task_struct *p,
 					    struct sched_group *group)
@@ -1490,6 +1519,11 @@ static inline bool sched_core_cookie_match(struct rq *rq, struct task_struct *p)
 	return true;
 }
 
+static inline bool sched_core_cookie_paired(struct rq *rq, struct task_struct *p)
+{
+	return false;
+}
+
 static inline bool sched_group_cookie_match(struct rq *rq,
 					    struct task_struct *p,
 					    struct sched_group *group)
@@ -1559,6 +1593,12 @@ static inline void update_idle_core(struct rq *rq)
 static inline void update_idle_core(struct rq *rq) { }
 #endif
 
+#ifdef CONFIG_SMP
+extern void update_idle_cpu_mask(struct rq *rq);
+#else
+static inline void update_idle_cpu_mask(struct rq *rq) { }
+#endif
+
 #ifdef CONFIG_FAIR_GROUP_SCHED
 
 static inline struct task_struct *task_of(struct sched_entity *se)
@@ -3652,12 +3692,44 @@ static inline void mm_cid_put(struct mm_struct *mm)
 	__mm_cid_put(mm, mm_cid_clear_lazy_put(cid));
 }
 
+/*
+ * In node mode the concurrency IDs handed out on a node are the ids of the
+ * CPUs of that node, lowest first, so user-space can back each cid with
+ * memory of the node cpu_to_node(cid) and still keep the ids in use within
+ * a node compact.  Only when all of them are held (lazily, by CPUs of other
+ * nodes the threads migrated from) does allocation fall back to the
+ * compact scheme.
+ */
+static inline int __mm_cid_try_get_node(struct mm_struct *mm)
+{
+	const struct cpumask *nodemask = cpumask_of_node(numa_node_id());
+	struct cpumask *cidmask = mm_cidmask(mm);
+	int cid;
+
+	cid = __this_cpu_read(mm->pcpu_cid->recent_cid);
+	if (!mm_cid_is_unset(cid) && cpumask_test_cpu(cid, nodemask) &&
+	    !cpumask_test_and_set_cpu(cid, cidmask))
+		return cid;
+
+	for_each_cpu_andnot(cid, nodemask, cidmask) {
+		if (!cpumask_test_and_set_cpu(cid, cidmask))
+			return cid;
+	}
+	return -1;
+}
+
 static inline int __mm_cid_try_get(struct task_struct *t, struct mm_struct *mm)
 {
 	struct cpumask *cidmask = mm_cidmask(mm);
 	struct mm_cid __percpu *pcpu_cid = mm->pcpu_cid;
 	int cid, max_nr_cid, allowed_max_nr_cid;
 
+	if (READ_ONCE(mm->mm_cid_node)) {
+		cid = __mm_cid_try_get_node(mm);
+		if (cid >= 0)
+			return cid;
+	}
+
 	/*
 	 * After shrinking the number of threads or reducing the number
 	 * of allowed cpus, reduce the value of max_nr_cid so expansion
@@ -255,6 +255,31 @@ static inline void sched_info_dequeue(struct rq *rq, struct task_struct *t)
 	rq_sched_info_dequeue(rq, delta);
 }
 
+static inline unsigned int sched_run_delay_bucket(unsigned long long delta)
+{
+	delta >>= SCHED_RUN_DELAY_SHIFT;
+	if (!delta)
+		return 0;
+	return min_t(unsigned int, ilog2(delta) + 1, SCHED_RUN_DELAY_BUCKETS - 1);
+}
+
+/*
+ * The root group is left out, the system wide distribution is the sum of
+ * its children's and of the root tasks' own.
+ */
+static inline void sched_info_account_hist(struct task_struct *t,
+					   unsigned long long delta)
+{
+	unsigned int bucket = sched_run_delay_bucket(delta);
+#ifdef CONFIG_CGROUP_SCHED
+	struct task_group *tg;
+
+	for (tg = task_group(t); tg != &root_task_group; tg = tg->parent)
+		this_cpu_inc(tg->run_delay_hist->nr[bucket]);
+#endif
+	t->sched_info.run_delay_hist[bucket]++;
+}
+
 /*
  * Called when a task finally hits the CPU.  We can now calculate how
  * long it was waiting to run.  We also note when it began so that we
@@ -277,6 +302,7 @@ static void sched_info_arrive(struct rq *rq, struct task_struct *t)
 		t->sched_info.max_run_delay = delta;
 	if (delta && (!t->sched_info.min_run_delay || delta < t->sched_info.min_run_delay))
 		t->sched_info.min_run_delay = delta;
+	sched_info_account_hist(t, delta);
 
 	rq_sched_info_arrive(rq, delta);
 }
@@ -375,7 +375,8 @@ static __always_inline void csd_unlock(call_single_data_t *csd)
 
 static DEFINE_PER_CPU_SHARED_ALIGNED(call_single_data_t, csd_data);
 
-void __smp_call_single_queue(int cpu, struct llist_node *node)
+static __always_inline void
+trace_csd_queue_node(int cpu, struct llist_node *node)
 {
 	/*
 	 * We have to check the type of the CSD before queueing it, because
@@ -394,6 +395,11 @@ void __smp_call_single_queue(int cpu, struct llist_node *node)
 
 		trace_csd_queue_cpu(cpu, _RET_IP_, func, csd);
 	}
+}
+
+void __smp_call_single_queue(int cpu, struct llist_node *node)
+{
+	trace_csd_queue_node(cpu, node);
 
 	/*
 	 * The list addition should be visible to the target CPU when it pops
@@ -411,6 +417,51 @@ void __smp_call_single_queue(int cpu, struct llist_node *node)
 		send_call_function_single_ipi(cpu);
 }
 
+/*
+ * Like __smp_call_single_queue(), but rather than sending the IPI right away
+ * record @cpu in @mask, for smp_send_call_single_mask() to send one IPI for
+ * a whole batch of entries.  Until then the entry may sit unnoticed on the
+ * target, and so may anything queued behind it; the caller must send the
+ * batch promptly and from the same CPU context.
+ */
+void __smp_call_single_queue_mask(int cpu, struct llist_node *node,
+				  struct cpumask *mask)
+{
+	trace_csd_queue_node(cpu, node);
+
+	if (llist_add(node, &per_cpu(call_single_queue, cpu)))
+		__cpumask_set_cpu(cpu, mask);
+}
+
+/*
+ * Kick the CPUs recorded by __smp_call_single_queue_mask(), with a single
+ * multicast IPI where the architecture has one, and clear @mask.
+ */
+void smp_send_call_single_mask(struct cpumask *mask)
+{
+	int cpu, last_cpu = -1;
+	unsigned int nr_cpus = 0;
+
+	for_each_cpu(cpu, mask) {
+		if (!call_function_single_prep_ipi(cpu)) {
+			__cpumask_clear_cpu(cpu, mask);
+			continue;
+		}
+		nr_cpus++;
+		last_cpu = cpu;
+	}
+
+	if (nr_cpus == 1) {
+		trace_ipi_send_cpu(last_cpu, _RET_IP_,
+				   generic_smp_call_function_single_interrupt);
+		arch_send_call_function_single_ipi(last_cpu);
+	} else if (nr_cpus > 1) {
+		send_call_function_ipi_mask(mask);
+	}
+
+	cpumask_clear(mask);
+}
+
 /*
  * Insert a previously allocated call_single_data_t element
  * for execution on the given CPU. data must already have
@@ -45,6 +45,7 @@
 #include <linux/version.h>
 #include <linux/ctype.h>
 #include <linux/syscall_user_dispatch.h>
+#include <linux/futex.h>
 
 #include <linux/compat.h>
 #include <linux/syscalls.h>
@@ -2820,6 +2821,65 @@ SYSCALL_DEFINE5(prctl, int, option, unsigned long, arg2, unsigned long, arg3,
 			return -EINVAL;
 		error = posixtimer_create_prctl(arg2);
 		break;
+#ifdef CONFIG_NUMA_BALANCING
+	case PR_SET_NUMA_SCAN_MODE:
+		if (arg3 || arg4 || arg5)
+			return -EINVAL;
+		if (arg2 != PR_NUMA_SCAN_PROT_NONE && arg2 != PR_NUMA_SCAN_ACCESSED)
+			return -EINVAL;
+		if (!me->mm)
+			return -EINVAL;
+		WRITE_ONCE(me->mm->numa_scan_mode, arg2);
+		break;
+	case PR_GET_NUMA_SCAN_MODE:
+		if (arg2 || arg3 || arg4 || arg5)
+			return -EINVAL;
+		if (!me->mm)
+			return -EINVAL;
+		error = READ_ONCE(me->mm->numa_scan_mode);
+		break;
+#endif
+#ifdef CONFIG_SCHED_MM_CID
+	case PR_SET_MM_CID_MODE:
+		if (arg3 || arg4 || arg5)
+			return -EINVAL;
+		if (arg2 != PR_MM_CID_COMPACT && arg2 != PR_MM_CID_NODE)
+			return -EINVAL;
+		if (!me->mm)
+			return -EINVAL;
+		WRITE_ONCE(me->mm->mm_cid_node, arg2 == PR_MM_CID_NODE);
+		break;
+	case PR_GET_MM_CID_MODE:
+		if (arg2 || arg3 || arg4 || arg5)
+			return -EINVAL;
+		if (!me->mm)
+			return -EINVAL;
+		error = READ_ONCE(me->mm->mm_cid_node) ? PR_MM_CID_NODE :
+							 PR_MM_CID_COMPACT;
+		break;
+#endif
+	case PR_SET_FUTEX_HASH:
+		if (arg3 || arg4 || arg5)
+			return -EINVAL;
+		error = futex_hash_prctl(option, arg2);
+		break;
+	case PR_GET_FUTEX_HASH:
+		if (arg2 || arg3 || arg4 || arg5)
+			return -EINVAL;
+		error = futex_hash_prctl(option, 0);
+		break;
+#ifdef CONFIG_RSEQ
+	case PR_SET_RSEQ_SLICE_EXTENSION:
+		if (arg2 > 1 || arg3 || arg4 || arg5)
+			return -EINVAL;
+		me->rseq_slice_ext = arg2;
+		break;
+	case PR_GET_RSEQ_SLICE_EXTENSION:
+		if (arg2 || arg3 || arg4 || arg5)
+			return -EINVAL;
+		error = me->rseq_slice_ext;
+		break;
+#endif
 	default:
 		trace_task_prctl_unknown(option, arg2, arg3, arg4, arg5);
 		error = -EINVAL;
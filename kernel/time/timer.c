@@ -1077,13 +1077,30 @@ __mod_timer(struct timer_list *timer, unsigned long expires, unsigned int option
 		 * larger granularity than you would get from adding a new
 		 * timer with this expiry.
 		 */
-		long diff = timer->expires - expires;
+		unsigned long old = READ_ONCE(timer->expires);
+		long diff = old - expires;
 
 		if (!diff)
 			return 1;
 		if (options & MOD_TIMER_REDUCE && diff <= 0)
 			return 1;
 
+		/*
+		 * Pushing out the expiry of a timer queued on this CPU, as
+		 * networking does on every packet, doesn't need the base lock:
+		 * the timer is left in its bucket and expire_timers() requeues
+		 * it when the bucket expires before the new expiry time.  The
+		 * fully ordered cmpxchg pairs with the barrier there; if the
+		 * timer was dequeued meanwhile, take the slow path to queue
+		 * it again.
+		 */
+		if (diff < 0 && !(options & MOD_TIMER_REDUCE) &&
+		    (READ_ONCE(timer->flags) & TIMER_BASEMASK) ==
+		    raw_smp_processor_id() &&
+		    try_cmpxchg(&timer->expires, &old, expires) &&
+		    timer_pending(timer))
+			return 1;
+
 		/*
 		 * We lock timer base and calculate the bucket index right
 		 * here. If the timer ends up in the same bucket, then we
@@ -1115,7 +1132,7 @@ __mod_timer(struct timer_list *timer, unsigned long expires, unsigned int option
 		 * timer. If it matches set the expiry to the new value so a
 		 * subsequent call will exit in the expires check above.
 		 */
-		if (idx == timer_get_idx(timer)) {
+		if (timer_pending(timer) && idx == timer_get_idx(timer)) {
 			if (!(options & MOD_TIMER_REDUCE))
 				timer->expires = expires;
 			else if (time_after(timer->expires, expires))
@@ -1449,6 +1466,56 @@ int timer_delete(struct timer_list *timer)
 }
 EXPORT_SYMBOL(timer_delete);
 
+/* Timers deactivated per acquisition of a base lock by timer_delete_many() */
+#define TIMER_DELETE_BATCH	32
+
+/**
+ * timer_delete_many - Deactivate a batch of timers
+ * @timers:	Array of timers, entries may be NULL
+ * @nr:		Number of entries in @timers
+ *
+ * Same as timer_delete() on each of @timers, but consecutive timers on the
+ * same timer base are deactivated under a single acquisition of its lock.
+ * Tearing down many connections with several timers each then takes far
+ * fewer lock round trips.
+ *
+ * Return: The number of timers which were pending and got deactivated.
+ */
+unsigned int timer_delete_many(struct timer_list **timers, unsigned int nr)
+{
+	struct timer_base *base = NULL;
+	unsigned int i, held = 0, ret = 0;
+	unsigned long flags;
+
+	for (i = 0; i < nr; i++) {
+		struct timer_list *timer = timers[i];
+		u32 tf;
+
+		if (!timer)
+			continue;
+		debug_assert_init(timer);
+		if (!timer_pending(timer))
+			continue;
+
+		/* A timer on a locked base cannot move away from it. */
+		tf = READ_ONCE(timer->flags);
+		if (!base || held >= TIMER_DELETE_BATCH ||
+		    (tf & TIMER_MIGRATING) || get_timer_base(tf) != base) {
+			if (base)
+				raw_spin_unlock_irqrestore(&base->lock, flags);
+			base = lock_timer_base(timer, &flags);
+			held = 0;
+		}
+		ret += detach_if_pending(timer, base, true);
+		held++;
+	}
+	if (base)
+		raw_spin_unlock_irqrestore(&base->lock, flags);
+
+	return ret;
+}
+EXPORT_SYMBOL(timer_delete_many);
+
 /**
  * timer_shutdown - Deactivate a timer and prevent rearming
  * @timer:	The timer to be deactivated
@@ -1819,9 +1886,22 @@ static void expire_timers(struct timer_base *base, struct hlist_head *head)
 
 		timer = hlist_entry(head->first, struct timer_list, entry);
 
-		base->running_timer = timer;
 		detach_timer(timer, true);
 
+		/*
+		 * The expiry may have been pushed out locklessly after the
+		 * timer was queued, see __mod_timer().  Either that sees the
+		 * timer dequeued, or this sees the new expiry.
+		 */
+		smp_mb();
+		if (time_after(READ_ONCE(timer->expires), baseclk)) {
+			debug_timer_activate(timer);
+			internal_add_timer(base, timer);
+			continue;
+		}
+
+		base->running_timer = timer;
+
 		fn = timer->function;
 
 		if (WARN_ON_ONCE(!fn)) {
@@ -69,7 +69,7 @@
 
 /* hash bits for specific function selection */
 #define FTRACE_HASH_DEFAULT_BITS 10
-#define FTRACE_HASH_MAX_BITS 12
+#define FTRACE_HASH_MAX_BITS 14
 
 #ifdef CONFIG_DYNAMIC_FTRACE
 #define INIT_OPS_HASH(opsname)	\
@@ -1302,6 +1302,17 @@ void ftrace_free_filter(struct ftrace_ops *ops)
 }
 EXPORT_SYMBOL_GPL(ftrace_free_filter);
 
+/*
+ * Buckets for a hash of @count entries: around half the count (max bit of
+ * it), at least @min_bits and without allocating too much.
+ */
+static int ftrace_hash_bits(unsigned long count, int min_bits)
+{
+	int bits = fls_long(count / 2);
+
+	return clamp(bits, min_bits, FTRACE_HASH_MAX_BITS);
+}
+
 static struct ftrace_hash *alloc_ftrace_hash(int size_bits)
 {
 	struct ftrace_hash *hash;
@@ -1409,19 +1420,17 @@ static struct ftrace_hash *__move_hash(struct ftrace_hash *src, int size)
 	int bits = 0;
 	int i;
 
+	bits = ftrace_hash_bits(size, 0);
+
 	/*
-	 * Use around half the size (max bit of it), but
-	 * a minimum of 2 is fine (as size of 0 or 1 both give 1 for bits).
+	 * The largest tables are high order allocations: rather than fail
+	 * the update, settle for longer chains.
 	 */
-	bits = fls(size / 2);
-
-	/* Don't allocate too much */
-	if (bits > FTRACE_HASH_MAX_BITS)
-		bits = FTRACE_HASH_MAX_BITS;
-
-	new_hash = alloc_ftrace_hash(bits);
-	if (!new_hash)
-		return NULL;
+	while (!(new_hash = alloc_ftrace_hash(bits))) {
+		if (bits <= FTRACE_HASH_DEFAULT_BITS)
+			return NULL;
+		bits--;
+	}
 
 	new_hash->flags = src->flags;
 
@@ -5803,6 +5812,8 @@ ftrace_set_hash(struct ftrace_ops *ops, unsigned char *buf, int len,
 {
 	struct ftrace_hash **orig_hash;
 	struct ftrace_hash *hash;
+	unsigned long count = 0;
+	int size_bits;
 	int ret;
 
 	if (unlikely(ftrace_disabled))
@@ -5815,10 +5826,27 @@ ftrace_set_hash(struct ftrace_ops *ops, unsigned char *buf, int len,
 	else
 		orig_hash = &ops->func_hash->notrace_hash;
 
+	/*
+	 * Size the working hash for what it is going to hold, so that adding
+	 * tens of thousands of addresses in one go does not walk ever longer
+	 * chains of a default sized table.
+	 */
+	if (!reset && *orig_hash)
+		count = (*orig_hash)->count;
+	if (ips && !remove)
+		count += cnt;
+	size_bits = ftrace_hash_bits(count, FTRACE_HASH_DEFAULT_BITS);
+
 	if (reset)
-		hash = alloc_ftrace_hash(FTRACE_HASH_DEFAULT_BITS);
+		hash = alloc_ftrace_hash(size_bits);
 	else
-		hash = alloc_and_copy_ftrace_hash(FTRACE_HASH_DEFAULT_BITS, *orig_hash);
+		hash = alloc_and_copy_ftrace_hash(size_bits, *orig_hash);
+	/* a big table is only worth having if it comes easily */
+	if (!hash && size_bits > FTRACE_HASH_DEFAULT_BITS) {
+		size_bits = FTRACE_HASH_DEFAULT_BITS;
+		hash = alloc_and_copy_ftrace_hash(size_bits,
+						  reset ? NULL : *orig_hash);
+	}
 
 	if (!hash) {
 		ret = -ENOMEM;
@@ -7330,6 +7330,32 @@ int ring_buffer_map_get_reader(struct trace_buffer *buffer, int cpu)
 	return 0;
 }
 
+/**
+ * ring_buffer_map_get_readers - hand out a new reader page on all mapped CPUs
+ * @buffer: The ring buffer
+ *
+ * Does ring_buffer_map_get_reader() on every CPU buffer that is mapped to
+ * user space, for a consumer that maps all of them and would otherwise need
+ * one call per CPU.  Each meta-page tells whether its reader page changed.
+ *
+ * Returns the number of mapped CPU buffers, or -ENODEV if there is none.
+ */
+int ring_buffer_map_get_readers(struct trace_buffer *buffer)
+{
+	int cpu, ret, nr = 0;
+
+	for_each_buffer_cpu(buffer, cpu) {
+		ret = ring_buffer_map_get_reader(buffer, cpu);
+		if (ret == -ENODEV)
+			continue;
+		if (ret)
+			return ret;
+		nr++;
+	}
+
+	return nr ? nr : -ENODEV;
+}
+
 /*
  * We only allocate new buffers, never free them if the CPU goes down.
  * If we were to free the buffer, then the user would lose any trace that was in
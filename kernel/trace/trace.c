@@ -5582,7 +5582,7 @@ static const char readme_msg[] =
 	"\t            [:size=#entries]\n"
 	"\t            [:pause][:continue][:clear]\n"
 	"\t            [:name=histname1]\n"
-	"\t            [:nohitcount]\n"
+	"\t            [:nohitcount][:percpu]\n"
 	"\t            [:<handler>.<action>]\n"
 	"\t            [if <filter>]\n\n"
 	"\t    Note, special fields can be used as well:\n"
@@ -5641,6 +5641,9 @@ static const char readme_msg[] =
 	"\t    unchanged.\n\n"
 	"\t    The 'nohitcount' (or NOHC) parameter will suppress display of\n"
 	"\t    raw hitcount in the histogram.\n\n"
+	"\t    The 'percpu' parameter keeps the sums of each entry per CPU\n"
+	"\t    and adds them up when the histogram is read, for events that\n"
+	"\t    hit the same entries from many CPUs at a high rate.\n\n"
 	"\t    The enable_hist and disable_hist triggers can be used to\n"
 	"\t    have one event conditionally start and stop another event's\n"
 	"\t    already-attached hist trigger.  The syntax is analogous to\n"
@@ -8413,18 +8416,26 @@ static long tracing_buffers_ioctl(struct file *file, unsigned int cmd, unsigned
 	struct trace_iterator *iter = &info->iter;
 	int err;
 
-	if (cmd == TRACE_MMAP_IOCTL_GET_READER) {
+	if (cmd == TRACE_MMAP_IOCTL_GET_READER ||
+	    cmd == TRACE_MMAP_IOCTL_GET_READERS) {
+		struct trace_buffer *buffer = iter->array_buffer->buffer;
+		bool all = cmd == TRACE_MMAP_IOCTL_GET_READERS;
+
 		if (!(file->f_flags & O_NONBLOCK)) {
-			err = ring_buffer_wait(iter->array_buffer->buffer,
-					       iter->cpu_file,
+			/* GET_READERS waits for data on any CPU */
+			err = ring_buffer_wait(buffer,
+					       all ? RING_BUFFER_ALL_CPUS :
+						     iter->cpu_file,
 					       iter->tr->buffer_percent,
 					       NULL, NULL);
 			if (err)
 				return err;
 		}
 
-		return ring_buffer_map_get_reader(iter->array_buffer->buffer,
-						  iter->cpu_file);
+		if (all)
+			return ring_buffer_map_get_readers(buffer);
+
+		return ring_buffer_map_get_reader(buffer, iter->cpu_file);
 	} else if (cmd) {
 		return -ENOTTY;
 	}
@@ -525,6 +525,7 @@ struct hist_trigger_attrs {
 	bool		clear;
 	bool		ts_in_usecs;
 	bool		no_hitcount;
+	bool		percpu;
 	unsigned int	map_bits;
 
 	char		*assignment_str[TRACING_MAP_VARS_MAX];
@@ -1550,6 +1551,8 @@ parse_hist_trigger_attrs(struct trace_array *tr, char *trigger_str)
 		} else if (strcmp(str, "nohitcount") == 0 ||
 			   strcmp(str, "NOHC") == 0)
 			attrs->no_hitcount = true;
+		else if (strcmp(str, "percpu") == 0)
+			attrs->percpu = true;
 		else if (strcmp(str, "pause") == 0)
 			attrs->pause = true;
 		else if ((strcmp(str, "cont") == 0) ||
@@ -5122,6 +5125,7 @@ create_hist_data(unsigned int map_bits,
 		hist_data->map = NULL;
 		goto free;
 	}
+	hist_data->map->percpu_sums = attrs->percpu;
 
 	ret = create_tracing_map_fields(hist_data);
 	if (ret)
@@ -5588,8 +5592,8 @@ static void hist_trigger_show(struct seq_file *m,
 	track_data_snapshot_print(m, hist_data);
 
 	seq_printf(m, "\nTotals:\n    Hits: %llu\n    Entries: %u\n    Dropped: %llu\n",
-		   (u64)atomic64_read(&hist_data->map->hits),
-		   n_entries, (u64)atomic64_read(&hist_data->map->drops));
+		   tracing_map_hits(hist_data->map),
+		   n_entries, tracing_map_drops(hist_data->map));
 }
 
 struct hist_file_data {
@@ -5607,7 +5611,7 @@ static u64 get_hist_hit_count(struct trace_event_file *event_file)
 	list_for_each_entry(data, &event_file->triggers, list) {
 		if (data->cmd_ops->trigger_type == ETT_EVENT_HIST) {
 			hist_data = data->private_data;
-			ret += atomic64_read(&hist_data->map->hits);
+			ret += tracing_map_hits(hist_data->map);
 		}
 	}
 	return ret;
@@ -6137,6 +6141,8 @@ static int event_hist_trigger_print(struct seq_file *m,
 		seq_printf(m, ":clock=%s", hist_data->attrs->clock);
 	if (hist_data->attrs->no_hitcount)
 		seq_puts(m, ":nohitcount");
+	if (hist_data->attrs->percpu)
+		seq_puts(m, ":percpu");
 
 	print_actions_spec(m, hist_data);
 
@@ -16,6 +16,7 @@
 #include <linux/slab.h>
 #include <linux/sort.h>
 #include <linux/kmemleak.h>
+#include <asm/local64.h>
 
 #include "tracing_map.h"
 #include "trace.h"
@@ -35,10 +36,19 @@
  * Add n to sum i associated with the specified tracing_map_elt
  * instance.  The index i is the index returned by the call to
  * tracing_map_add_sum_field() when the tracing map was set up.
+ *
+ * For a map with percpu_sums, n goes to this CPU's part of the sum, so
+ * that events hitting the same elt on many CPUs do not all update the
+ * same cache line.  The parts are local64_t because hist triggers may
+ * fire from NMI, where a plain this_cpu_add() on a u64 isn't safe on
+ * 32-bit architectures.
  */
 void tracing_map_update_sum(struct tracing_map_elt *elt, unsigned int i, u64 n)
 {
-	atomic64_add(n, &elt->fields[i].sum);
+	if (elt->sums)
+		local64_add(n, this_cpu_ptr(elt->sums) + i);
+	else
+		atomic64_add(n, &elt->fields[i].sum);
 }
 
 /**
@@ -55,7 +65,46 @@ void tracing_map_update_sum(struct tracing_map_elt *elt, unsigned int i, u64 n)
  */
 u64 tracing_map_read_sum(struct tracing_map_elt *elt, unsigned int i)
 {
-	return (u64)atomic64_read(&elt->fields[i].sum);
+	u64 sum = (u64)atomic64_read(&elt->fields[i].sum);
+	int cpu;
+
+	if (elt->sums) {
+		for_each_possible_cpu(cpu)
+			sum += local64_read(per_cpu_ptr(elt->sums, cpu) + i);
+	}
+	return sum;
+}
+
+static u64 tracing_map_read_percpu(local64_t __percpu *counter)
+{
+	u64 sum = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		sum += local64_read(per_cpu_ptr(counter, cpu));
+	return sum;
+}
+
+/**
+ * tracing_map_hits - Return the number of successful inserts and lookups
+ * @map: The tracing_map
+ *
+ * Return: The number of times tracing_map_insert() found or added an elt.
+ */
+u64 tracing_map_hits(struct tracing_map *map)
+{
+	return tracing_map_read_percpu(map->hits);
+}
+
+/**
+ * tracing_map_drops - Return the number of failed inserts
+ * @map: The tracing_map
+ *
+ * Return: The number of times tracing_map_insert() found the map full.
+ */
+u64 tracing_map_drops(struct tracing_map *map)
+{
+	return tracing_map_read_percpu(map->drops);
 }
 
 /**
@@ -358,11 +407,18 @@ static struct tracing_map_array *tracing_map_array_alloc(unsigned int n_elts,
 static void tracing_map_elt_clear(struct tracing_map_elt *elt)
 {
 	unsigned i;
+	int cpu;
 
 	for (i = 0; i < elt->map->n_fields; i++)
 		if (elt->fields[i].cmp_fn == tracing_map_cmp_atomic64)
 			atomic64_set(&elt->fields[i].sum, 0);
 
+	if (elt->sums) {
+		for_each_possible_cpu(cpu)
+			for (i = 0; i < elt->map->n_fields; i++)
+				local64_set(per_cpu_ptr(elt->sums, cpu) + i, 0);
+	}
+
 	for (i = 0; i < elt->map->n_vars; i++) {
 		atomic64_set(&elt->vars[i], 0);
 		elt->var_set[i] = false;
@@ -396,6 +452,7 @@ static void tracing_map_elt_free(struct tracing_map_elt *elt)
 	kfree(elt->fields);
 	kfree(elt->vars);
 	kfree(elt->var_set);
+	free_percpu(elt->sums);
 	kfree(elt->key);
 	kfree(elt);
 }
@@ -435,6 +492,15 @@ static struct tracing_map_elt *tracing_map_elt_alloc(struct tracing_map *map)
 		goto free;
 	}
 
+	if (map->percpu_sums) {
+		elt->sums = __alloc_percpu(map->n_fields * sizeof(local64_t),
+					   __alignof__(local64_t));
+		if (!elt->sums) {
+			err = -ENOMEM;
+			goto free;
+		}
+	}
+
 	tracing_map_elt_init_fields(elt);
 
 	if (map->ops && map->ops->elt_alloc) {
@@ -535,7 +601,7 @@ __tracing_map_insert(struct tracing_map *map, void *key, bool lookup_only)
 			if (val &&
 			    keys_match(key, val->key, map->key_size)) {
 				if (!lookup_only)
-					atomic64_inc(&map->hits);
+					local64_inc(this_cpu_ptr(map->hits));
 				return val;
 			} else if (unlikely(!val)) {
 				/*
@@ -552,7 +618,7 @@ __tracing_map_insert(struct tracing_map *map, void *key, bool lookup_only)
 
 				dup_try++;
 				if (dup_try > map->map_size) {
-					atomic64_inc(&map->drops);
+					local64_inc(this_cpu_ptr(map->drops));
 					break;
 				}
 				continue;
@@ -568,7 +634,7 @@ __tracing_map_insert(struct tracing_map *map, void *key, bool lookup_only)
 
 				elt = get_free_elt(map);
 				if (!elt) {
-					atomic64_inc(&map->drops);
+					local64_inc(this_cpu_ptr(map->drops));
 					entry->key = 0;
 					break;
 				}
@@ -580,7 +646,7 @@ __tracing_map_insert(struct tracing_map *map, void *key, bool lookup_only)
 				 */
 				smp_wmb();
 				WRITE_ONCE(entry->val, elt);
-				atomic64_inc(&map->hits);
+				local64_inc(this_cpu_ptr(map->hits));
 
 				return entry->val;
 			} else {
@@ -681,6 +747,8 @@ void tracing_map_destroy(struct tracing_map *map)
 	tracing_map_free_elts(map);
 
 	tracing_map_array_free(map->map);
+	free_percpu(map->hits);
+	free_percpu(map->drops);
 	kfree(map);
 }
 
@@ -698,10 +766,13 @@ void tracing_map_destroy(struct tracing_map *map)
 void tracing_map_clear(struct tracing_map *map)
 {
 	unsigned int i;
+	int cpu;
 
 	atomic_set(&map->next_elt, 0);
-	atomic64_set(&map->hits, 0);
-	atomic64_set(&map->drops, 0);
+	for_each_possible_cpu(cpu) {
+		local64_set(per_cpu_ptr(map->hits, cpu), 0);
+		local64_set(per_cpu_ptr(map->drops, cpu), 0);
+	}
 
 	tracing_map_array_clear(map->map);
 
@@ -795,6 +866,11 @@ struct tracing_map *tracing_map_create(unsigned int map_bits,
 	if (!map->map)
 		goto free;
 
+	map->hits = alloc_percpu(local64_t);
+	map->drops = alloc_percpu(local64_t);
+	if (!map->hits || !map->drops)
+		goto free;
+
 	map->key_size = key_size;
 	for (i = 0; i < TRACING_MAP_KEYS_MAX; i++)
 		map->key_idx[i] = -1;
@@ -873,10 +949,21 @@ static int cmp_entries_sum(const void *A, const void *B)
 	field = &elt_a->fields[sort_key->field_idx];
 	cmp_fn = field->cmp_fn;
 
-	val_a = &elt_a->fields[sort_key->field_idx].sum;
-	val_b = &elt_b->fields[sort_key->field_idx].sum;
+	if (elt_a->sums) {
+		/* merge the per-CPU parts to compare */
+		u64 sum_a, sum_b;
 
-	ret = cmp_fn(val_a, val_b);
+		sum_a = tracing_map_read_sum((struct tracing_map_elt *)elt_a,
+					     sort_key->field_idx);
+		sum_b = tracing_map_read_sum((struct tracing_map_elt *)elt_b,
+					     sort_key->field_idx);
+		ret = (sum_a > sum_b) ? 1 : ((sum_a < sum_b) ? -1 : 0);
+	} else {
+		val_a = &elt_a->fields[sort_key->field_idx].sum;
+		val_b = &elt_b->fields[sort_key->field_idx].sum;
+
+		ret = cmp_fn(val_a, val_b);
+	}
 	if (sort_key->descending)
 		ret = -ret;
 
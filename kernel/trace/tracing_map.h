@@ -140,6 +140,8 @@ struct tracing_map_elt {
 	struct tracing_map_field	*fields;
 	atomic64_t			*vars;
 	bool				*var_set;
+	/* per-CPU parts of the sum fields, for maps with percpu_sums */
+	local64_t __percpu		*sums;
 	void				*key;
 	void				*private_data;
 };
@@ -196,8 +198,10 @@ struct tracing_map {
 	unsigned int			n_keys;
 	struct tracing_map_sort_key	sort_key;
 	unsigned int			n_vars;
-	atomic64_t			hits;
-	atomic64_t			drops;
+	/* set before tracing_map_init() to count sums per CPU */
+	bool				percpu_sums;
+	local64_t __percpu		*hits;
+	local64_t __percpu		*drops;
 };
 
 /**
@@ -269,6 +273,8 @@ extern void tracing_map_set_var(struct tracing_map_elt *elt,
 				unsigned int i, u64 n);
 extern bool tracing_map_var_set(struct tracing_map_elt *elt, unsigned int i);
 extern u64 tracing_map_read_sum(struct tracing_map_elt *elt, unsigned int i);
+extern u64 tracing_map_hits(struct tracing_map *map);
+extern u64 tracing_map_drops(struct tracing_map *map);
 extern u64 tracing_map_read_var(struct tracing_map_elt *elt, unsigned int i);
 extern u64 tracing_map_read_var_once(struct tracing_map_elt *elt, unsigned int i);
 
@@ -243,6 +243,8 @@ enum pool_workqueue_stats {
 	PWQ_STAT_REPATRIATED,	/* unbound workers brought back into scope */
 	PWQ_STAT_MAYDAY,	/* maydays to rescuer */
 	PWQ_STAT_RESCUED,	/* linked work items executed by rescuer */
+	PWQ_STAT_BACKLOGGED,	/* queued behind a stalled worklist */
+	PWQ_STAT_STEERED,	/* moved here from a backlogged sibling pool */
 
 	PWQ_NR_STATS,
 };
@@ -422,6 +424,14 @@ static unsigned int wq_cpu_intensive_warning_thresh = 4;
 module_param_named(cpu_intensive_warning_thresh, wq_cpu_intensive_warning_thresh, uint, 0644);
 #endif
 
+/*
+ * An unbound pool whose worklist hasn't started a work item for longer than
+ * this is backlogged, and new work items that would go there are queued on
+ * an idle pool of another pod in the same node instead.  0 disables.
+ */
+static unsigned int wq_unbound_steer_thresh_ms;
+module_param_named(unbound_steer_thresh_ms, wq_unbound_steer_thresh_ms, uint, 0644);
+
 /* see the comment above the definition of WQ_POWER_EFFICIENT */
 static bool wq_power_efficient = IS_ENABLED(CONFIG_WQ_POWER_EFFICIENT_DEFAULT);
 module_param_named(power_efficient, wq_power_efficient, bool, 0444);
@@ -2232,11 +2242,72 @@ static int wq_select_unbound_cpu(int cpu)
 	return new_cpu;
 }
 
+static bool unbound_pool_backlogged(struct worker_pool *pool,
+				    unsigned long thresh)
+{
+	return !list_empty(&pool->worklist) &&
+	       time_after(jiffies, READ_ONCE(pool->watchdog_ts) + thresh);
+}
+
+static bool unbound_pwq_can_steer(struct pool_workqueue *pwq,
+				  struct worker_pool *pool)
+{
+	struct worker_pool *sibling = pwq->pool;
+
+	return sibling != pool && sibling->node == pool->node &&
+	       READ_ONCE(pwq->refcnt) && list_empty(&sibling->worklist) &&
+	       READ_ONCE(sibling->nr_idle);
+}
+
+/*
+ * If the pool of *@pwqp is backlogged, look for a pwq of @wq on an idle pool
+ * in the same node and switch *@pwqp to it.  Called under RCU.  Returns the
+ * stat to account on the pwq, or PWQ_NR_STATS.
+ *
+ * Only the pwqs installed for the current attrs are considered: @wq->pwqs
+ * also has the ones an earlier apply_workqueue_attrs() replaced, which may
+ * be dying.  An installed pwq cannot die without being replaced first, so
+ * the retry in __queue_work() still makes progress.
+ */
+static enum pool_workqueue_stats unbound_pwq_steer(struct workqueue_struct *wq,
+						   struct pool_workqueue **pwqp)
+{
+	struct worker_pool *pool = (*pwqp)->pool;
+	unsigned int thresh_ms = READ_ONCE(wq_unbound_steer_thresh_ms);
+	struct pool_workqueue *pwq;
+	int cpu;
+
+	if (!thresh_ms || (wq->flags & __WQ_ORDERED) ||
+	    wq->unbound_attrs->affn_strict)
+		return PWQ_NR_STATS;
+
+	if (!unbound_pool_backlogged(pool, msecs_to_jiffies(thresh_ms)))
+		return PWQ_NR_STATS;
+
+	if (pool->node != NUMA_NO_NODE) {
+		for_each_cpu(cpu, cpumask_of_node(pool->node)) {
+			pwq = unbound_pwq(wq, cpu);
+			if (unbound_pwq_can_steer(pwq, pool)) {
+				*pwqp = pwq;
+				return PWQ_STAT_STEERED;
+			}
+		}
+	}
+
+	pwq = unbound_pwq(wq, -1);
+	if (unbound_pwq_can_steer(pwq, pool)) {
+		*pwqp = pwq;
+		return PWQ_STAT_STEERED;
+	}
+	return PWQ_STAT_BACKLOGGED;
+}
+
 static void __queue_work(int cpu, struct workqueue_struct *wq,
 			 struct work_struct *work)
 {
-	struct pool_workqueue *pwq;
+	struct pool_workqueue *pwq, *stat_pwq;
 	struct worker_pool *last_pool, *pool;
+	enum pool_workqueue_stats stat = PWQ_NR_STATS;
 	unsigned int work_flags;
 	unsigned int req_cpu = cpu;
 
@@ -2269,6 +2340,9 @@ static void __queue_work(int cpu, struct workqueue_struct *wq,
 	}
 
 	pwq = rcu_dereference(*per_cpu_ptr(wq->cpu_pwq, cpu));
+	if (req_cpu == WORK_CPU_UNBOUND && (wq->flags & WQ_UNBOUND))
+		stat = unbound_pwq_steer(wq, &pwq);
+	stat_pwq = pwq;
 	pool = pwq->pool;
 
 	/*
@@ -2327,6 +2401,8 @@ static void __queue_work(int cpu, struct workqueue_struct *wq,
 
 	pwq->nr_in_flight[pwq->work_color]++;
 	work_flags = work_color_to_flags(pwq->work_color);
+	if (stat != PWQ_NR_STATS && pwq == stat_pwq)
+		pwq->stats[stat]++;
 
 	/*
 	 * Limit the number of concurrently active work items to max_active.
@@ -33,6 +33,13 @@ EXPORT_SYMBOL(mem_alloc_profiling_key);
 
 DEFINE_STATIC_KEY_FALSE(mem_profiling_compressed);
 
+DEFINE_STATIC_KEY_FALSE(mem_alloc_profiling_sampled);
+EXPORT_SYMBOL(mem_alloc_profiling_sampled);
+DEFINE_PER_CPU(int, alloc_tag_sample_countdown);
+EXPORT_SYMBOL(alloc_tag_sample_countdown);
+unsigned int mem_alloc_profiling_sample_interval = 1;
+EXPORT_SYMBOL(mem_alloc_profiling_sample_interval);
+
 struct alloc_tag_kernel_section kernel_tags = { NULL, 0 };
 unsigned long alloc_tag_ref_mask;
 int alloc_tag_ref_offs;
@@ -175,7 +182,12 @@ void pgalloc_tag_split(struct folio *folio, int old_order, int new_order)
 		return;
 
 	tag = __pgalloc_tag_get(&folio->page);
-	if (!tag)
+	/*
+	 * An untagged folio leaves its new parts untagged too.  Debug builds
+	 * must still mark them empty, or freeing them warns about a missing
+	 * tag when the folio was left out by sampling.
+	 */
+	if (!tag && !IS_ENABLED(CONFIG_MEM_ALLOC_PROFILING_DEBUG))
 		return;
 
 	for (i = nr_pages; i < (1 << old_order); i += nr_pages) {
@@ -184,7 +196,10 @@ void pgalloc_tag_split(struct folio *folio, int old_order, int new_order)
 
 		if (get_page_tag_ref(folio_page(folio, i), &ref, &handle)) {
 			/* Set new reference to point to the original tag */
-			alloc_tag_ref_set(&ref, tag);
+			if (tag)
+				alloc_tag_ref_set(&ref, tag);
+			else
+				set_codetag_empty(&ref);
 			update_page_tag_ref(handle, &ref);
 			put_page_tag_ref(handle);
 		}
@@ -724,6 +739,31 @@ struct page_ext_operations page_alloc_tagging_ops = {
 EXPORT_SYMBOL(page_alloc_tagging_ops);
 
 #ifdef CONFIG_SYSCTL
+static DEFINE_MUTEX(mem_profiling_sample_lock);
+
+static int proc_mem_profiling_sample_interval(const struct ctl_table *table,
+		int write, void *buffer, size_t *lenp, loff_t *ppos)
+{
+	int ret;
+
+	mutex_lock(&mem_profiling_sample_lock);
+	ret = proc_douintvec_minmax(table, write, buffer, lenp, ppos);
+	if (!ret && write) {
+		/*
+		 * Counters are scaled by the current interval when read, so
+		 * allocations still outstanding from before a change are
+		 * mis-scaled until freed; the totals converge after that.
+		 */
+		if (mem_alloc_profiling_sample_interval > 1)
+			static_branch_enable(&mem_alloc_profiling_sampled);
+		else
+			static_branch_disable(&mem_alloc_profiling_sampled);
+	}
+	mutex_unlock(&mem_profiling_sample_lock);
+
+	return ret;
+}
+
 static struct ctl_table memory_allocation_profiling_sysctls[] = {
 	{
 		.procname	= "mem_profiling",
@@ -735,6 +775,15 @@ static struct ctl_table memory_allocation_profiling_sysctls[] = {
 #endif
 		.proc_handler	= proc_do_static_key,
 	},
+	{
+		.procname	= "mem_profiling_sample_interval",
+		.data		= &mem_alloc_profiling_sample_interval,
+		.maxlen		= sizeof(mem_alloc_profiling_sample_interval),
+		.mode		= 0644,
+		.proc_handler	= proc_mem_profiling_sample_interval,
+		.extra1		= SYSCTL_ONE,
+		.extra2		= SYSCTL_INT_MAX,
+	},
 };
 
 static void __init sysctl_init(void)
@@ -53,6 +53,38 @@ u32 crc32c_base(u32 crc, const u8 *p, size_t len)
 }
 EXPORT_SYMBOL(crc32c_base);
 
+/*
+ * The table-driven loop is bound by the latency of one lookup feeding the
+ * next.  Four independent streams keep that many lookups in flight.
+ */
+void crc32c_multi_base(u32 *crcs, const u8 * const *bufs, size_t len,
+		       unsigned int nr)
+{
+	unsigned int i = 0;
+	size_t j;
+
+	for (; i + 4 <= nr; i += 4) {
+		const u8 *p0 = bufs[i], *p1 = bufs[i + 1];
+		const u8 *p2 = bufs[i + 2], *p3 = bufs[i + 3];
+		u32 c0 = crcs[i], c1 = crcs[i + 1];
+		u32 c2 = crcs[i + 2], c3 = crcs[i + 3];
+
+		for (j = 0; j < len; j++) {
+			c0 = (c0 >> 8) ^ crc32ctable_le[(c0 & 255) ^ p0[j]];
+			c1 = (c1 >> 8) ^ crc32ctable_le[(c1 & 255) ^ p1[j]];
+			c2 = (c2 >> 8) ^ crc32ctable_le[(c2 & 255) ^ p2[j]];
+			c3 = (c3 >> 8) ^ crc32ctable_le[(c3 & 255) ^ p3[j]];
+		}
+		crcs[i] = c0;
+		crcs[i + 1] = c1;
+		crcs[i + 2] = c2;
+		crcs[i + 3] = c3;
+	}
+	for (; i < nr; i++)
+		crcs[i] = crc32c_base(crcs[i], bufs[i], len);
+}
+EXPORT_SYMBOL(crc32c_multi_base);
+
 /*
  * This multiplies the polynomials x and y modulo the given modulus.
  * This follows the "little-endian" CRC convention that the lsbit
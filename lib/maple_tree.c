@@ -6329,6 +6329,64 @@ int mtree_store_range(struct maple_tree *mt, unsigned long index,
 }
 EXPORT_SYMBOL(mtree_store_range);
 
+/**
+ * mtree_store_ranges() - Store entries at many ranges in one operation.
+ * @mt: The maple tree
+ * @ranges: The ranges and their entries, sorted by index
+ * @nr: The number of ranges
+ * @gfp: The GFP_FLAGS to use for allocations
+ *
+ * Stores each entry as mtree_store_range() would, a %NULL entry erasing its
+ * range, under one hold of the tree lock.  The ranges must be in ascending
+ * order and must not overlap: every store then starts from the leaf the
+ * previous one ended in rather than from the root, so populating (or
+ * tearing down) many neighbouring ranges costs one walk per leaf instead of
+ * one per range.
+ *
+ * Return: 0 on success, -EINVAL on invalid request, -ENOMEM if memory could not
+ * be allocated.  On error, the ranges before the failing one have been stored.
+ */
+int mtree_store_ranges(struct maple_tree *mt, const struct maple_range *ranges,
+		       unsigned int nr, gfp_t gfp)
+{
+	MA_STATE(mas, mt, 0, 0);
+	unsigned int i;
+	int ret = 0;
+
+	for (i = 0; i < nr; i++) {
+		if (WARN_ON_ONCE(xa_is_advanced(ranges[i].entry)))
+			return -EINVAL;
+		if (ranges[i].index > ranges[i].last)
+			return -EINVAL;
+		if (i && ranges[i].index <= ranges[i - 1].last)
+			return -EINVAL;
+	}
+
+	mtree_lock(mt);
+	for (i = 0; i < nr; i++) {
+		trace_ma_write(__func__, &mas, 0, ranges[i].entry);
+		/*
+		 * The state points at what was stored last, which lies below
+		 * this range: keep walking from there while the range starts
+		 * in the same node, mas_wr_prealloc_setup() restarts from the
+		 * root when it does not end there.
+		 */
+		if (mas_is_active(&mas) && ranges[i].index <= mas.max) {
+			mas.index = ranges[i].index;
+			mas.last = ranges[i].last;
+		} else {
+			mas_set_range(&mas, ranges[i].index, ranges[i].last);
+		}
+		ret = mas_store_gfp(&mas, ranges[i].entry, gfp);
+		if (ret)
+			break;
+	}
+	mtree_unlock(mt);
+
+	return ret;
+}
+EXPORT_SYMBOL(mtree_store_ranges);
+
 /**
  * mtree_store() - Store an entry at a given index.
  * @mt: The maple tree
@@ -15,6 +15,7 @@
 #include <linux/kernel.h>
 #include <linux/init.h>
 #include <linux/log2.h>
+#include <linux/memblock.h>
 #include <linux/sched.h>
 #include <linux/rculist.h>
 #include <linux/slab.h>
@@ -28,6 +29,10 @@
 
 #define HASH_DEFAULT_SIZE	64UL
 #define HASH_MIN_SIZE		4U
+/* Old buckets rehashed per run of the deferred worker. */
+#define RHT_REHASH_BATCH	1024U
+/* Bucket arrays at least this large are spread over the memory nodes. */
+#define RHT_INTERLEAVE_MIN	(64 * PAGE_SIZE)
 
 union nested_table {
 	union nested_table __rcu *table;
@@ -174,18 +179,60 @@ static struct bucket_table *nested_bucket_table_alloc(struct rhashtable *ht,
 	return tbl;
 }
 
+/*
+ * Lookups hit the buckets of a large table from every node alike, so with
+ * hashdist its pages are taken round-robin from the memory nodes, the way
+ * alloc_large_system_hash() spreads the boot-time hashes.  vfree() drops
+ * the pages again.
+ */
+static void *bucket_table_alloc_interleaved(size_t size, gfp_t gfp)
+{
+	unsigned int nr_pages = DIV_ROUND_UP(size, PAGE_SIZE);
+	int nid = numa_node_id();
+	struct page **pages;
+	unsigned int i;
+	void *addr;
+
+	pages = kvmalloc_array_noprof(nr_pages, sizeof(*pages), gfp);
+	if (!pages)
+		return NULL;
+
+	for (i = 0; i < nr_pages; i++) {
+		nid = next_node_in(nid, node_states[N_MEMORY]);
+		pages[i] = alloc_pages_node_noprof(nid, gfp | __GFP_ZERO, 0);
+		if (!pages[i])
+			goto free;
+	}
+
+	addr = vmap(pages, nr_pages, VM_MAP | VM_MAP_PUT_PAGES, PAGE_KERNEL);
+	if (addr)
+		return addr;
+free:
+	while (i--)
+		__free_page(pages[i]);
+	kvfree(pages);
+	return NULL;
+}
+
 static struct bucket_table *bucket_table_alloc(struct rhashtable *ht,
 					       size_t nbuckets,
 					       gfp_t gfp)
 {
 	struct bucket_table *tbl = NULL;
-	size_t size;
+	size_t size, bytes;
 	int i;
 	static struct lock_class_key __key;
 
-	tbl = alloc_hooks_tag(ht->alloc_tag,
-			kvmalloc_node_noprof(struct_size(tbl, buckets, nbuckets),
-					     gfp|__GFP_ZERO, NUMA_NO_NODE));
+	bytes = struct_size(tbl, buckets, nbuckets);
+	if (hashdist && bytes >= RHT_INTERLEAVE_MIN &&
+	    gfpflags_allow_blocking(gfp))
+		tbl = alloc_hooks_tag(ht->alloc_tag,
+			bucket_table_alloc_interleaved(bytes,
+						       gfp | __GFP_NOWARN));
+	if (!tbl)
+		tbl = alloc_hooks_tag(ht->alloc_tag,
+			kvmalloc_node_noprof(bytes, gfp|__GFP_ZERO,
+					     NUMA_NO_NODE));
 
 	size = nbuckets;
 
@@ -321,19 +368,30 @@ static int rhashtable_rehash_table(struct rhashtable *ht)
 	struct bucket_table *old_tbl = rht_dereference(ht->tbl, ht);
 	struct bucket_table *new_tbl;
 	struct rhashtable_walker *walker;
-	unsigned int old_hash;
+	unsigned int old_hash, end;
 	int err;
 
 	new_tbl = rht_dereference(old_tbl->future_tbl, ht);
 	if (!new_tbl)
 		return 0;
 
-	for (old_hash = 0; old_hash < old_tbl->size; old_hash++) {
+	/*
+	 * Move a bounded number of buckets per run, so that a huge table
+	 * does not keep ht->mutex and the worker for the whole rehash.
+	 * Insertions go to the new table, emptied buckets stay empty.
+	 */
+	end = min(old_tbl->size, old_tbl->rehash + RHT_REHASH_BATCH);
+	for (old_hash = old_tbl->rehash; old_hash < end; old_hash++) {
 		err = rhashtable_rehash_chain(ht, old_hash);
-		if (err)
+		if (err) {
+			old_tbl->rehash = old_hash;
 			return err;
+		}
 		cond_resched();
 	}
+	old_tbl->rehash = end;
+	if (end < old_tbl->size)
+		return -EAGAIN;
 
 	/* Publish the new table pointer. */
 	rcu_assign_pointer(ht->tbl, new_tbl);
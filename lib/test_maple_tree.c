@@ -48,6 +48,7 @@ atomic_t maple_tree_tests_passed;
 /* #define BENCH_FORK */
 /* #define BENCH_MAS_FOR_EACH */
 /* #define BENCH_MAS_PREV */
+/* #define BENCH_STORE_RANGES */
 
 #ifdef __KERNEL__
 #define mt_set_non_kernel(x)		do {} while (0)
@@ -1387,6 +1388,49 @@ static noinline void __init check_prev_entry(struct maple_tree *mt)
 	mas_unlock(&mas);
 }
 
+static noinline void __init check_store_ranges(struct maple_tree *mt)
+{
+	struct maple_range *ranges;
+	unsigned long i, nr = 1000;
+
+	ranges = kmalloc_array(nr, sizeof(*ranges), GFP_KERNEL);
+	MT_BUG_ON(mt, !ranges);
+
+	for (i = 0; i < nr; i++) {
+		ranges[i].index = i * 10;
+		ranges[i].last = i * 10 + 5;
+		ranges[i].entry = xa_mk_value(i);
+	}
+	MT_BUG_ON(mt, mtree_store_ranges(mt, ranges, nr, GFP_KERNEL));
+	mt_validate(mt);
+	for (i = 0; i < nr; i++) {
+		MT_BUG_ON(mt, mtree_load(mt, i * 10) != xa_mk_value(i));
+		MT_BUG_ON(mt, mtree_load(mt, i * 10 + 5) != xa_mk_value(i));
+		MT_BUG_ON(mt, mtree_load(mt, i * 10 + 6) != NULL);
+	}
+
+	/* Erase every other range, and grow the rest over the gaps. */
+	for (i = 0; i < nr; i++) {
+		ranges[i].index = i * 10;
+		ranges[i].last = i * 10 + 9;
+		ranges[i].entry = i % 2 ? NULL : xa_mk_value(i);
+	}
+	MT_BUG_ON(mt, mtree_store_ranges(mt, ranges, nr, GFP_KERNEL));
+	mt_validate(mt);
+	for (i = 0; i < nr; i++) {
+		MT_BUG_ON(mt, mtree_load(mt, i * 10 + 7) !=
+			  (i % 2 ? NULL : xa_mk_value(i)));
+	}
+
+	/* Overlapping or unsorted ranges are refused before any store. */
+	ranges[1].index = ranges[0].last;
+	MT_BUG_ON(mt, mtree_store_ranges(mt, ranges, nr, GFP_KERNEL) !=
+		  -EINVAL);
+	MT_BUG_ON(mt, mtree_load(mt, 9) != xa_mk_value(0));
+
+	kfree(ranges);
+}
+
 static noinline void __init check_store_null(struct maple_tree *mt)
 {
 	MA_STATE(mas, mt, 0, ULONG_MAX);
@@ -1878,6 +1922,30 @@ static noinline void __init bench_load(struct maple_tree *mt)
 }
 #endif
 
+#if defined(BENCH_STORE_RANGES)
+static noinline void __init bench_store_ranges(struct maple_tree *mt)
+{
+	int i, j, nr = 4096, count = 2000;
+	struct maple_range *ranges;
+
+	ranges = kmalloc_array(nr, sizeof(*ranges), GFP_KERNEL);
+	for (i = 0; i < nr; i++) {
+		ranges[i].index = i * 16;
+		ranges[i].last = i * 16 + 7;
+	}
+
+	for (i = 0; i < count; i++) {
+		for (j = 0; j < nr; j++)
+			ranges[j].entry = xa_mk_value(j);
+		mtree_store_ranges(mt, ranges, nr, GFP_KERNEL);
+		for (j = 0; j < nr; j++)
+			ranges[j].entry = NULL;
+		mtree_store_ranges(mt, ranges, nr, GFP_KERNEL);
+	}
+	kfree(ranges);
+}
+#endif
+
 #if defined(BENCH_MT_FOR_EACH)
 static noinline void __init bench_mt_for_each(struct maple_tree *mt)
 {
@@ -3847,6 +3915,13 @@ static int __init maple_tree_seed(void)
 	mtree_destroy(&tree);
 	goto skip;
 #endif
+#if defined(BENCH_STORE_RANGES)
+#define BENCH
+	mt_init_flags(&tree, MT_FLAGS_ALLOC_RANGE);
+	bench_store_ranges(&tree);
+	mtree_destroy(&tree);
+	goto skip;
+#endif
 
 	mt_init_flags(&tree, MT_FLAGS_ALLOC_RANGE);
 	check_deficient_node(&tree);
@@ -3856,6 +3931,10 @@ static int __init maple_tree_seed(void)
 	check_store_null(&tree);
 	mtree_destroy(&tree);
 
+	mt_init_flags(&tree, MT_FLAGS_ALLOC_RANGE);
+	check_store_ranges(&tree);
+	mtree_destroy(&tree);
+
 	mt_init_flags(&tree, MT_FLAGS_ALLOC_RANGE);
 	check_root_expand(&tree);
 	mtree_destroy(&tree);
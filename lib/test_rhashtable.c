@@ -267,6 +267,65 @@ static s64 __init test_rhashtable(struct rhashtable *ht, struct test_obj *array,
 static struct rhashtable ht;
 static struct rhltable rhlt;
 
+/*
+ * Grow a table from its minimum size and time a lookup after every few
+ * insertions, telling apart the ones the deferred worker was rehashing
+ * under.
+ */
+static void __init test_rht_resize_latency(struct test_obj *array,
+					   unsigned int entries)
+{
+	u64 total[2] = {}, max[2] = {}, samples[2] = {};
+	struct rhashtable_params params = test_rht_params;
+	struct bucket_table *tbl;
+	struct test_obj_val key;
+	unsigned int i;
+	bool resizing;
+	u64 start, t;
+	int err;
+
+	params.nelem_hint = 0;
+	err = rhashtable_init(&ht, &params);
+	if (err < 0) {
+		pr_warn("Test failed: Unable to initialize hashtable: %d\n",
+			err);
+		return;
+	}
+
+	memset(array, 0, entries * sizeof(struct test_obj));
+	for (i = 0; i < entries; i++) {
+		array[i].value.id = i;
+		err = insert_retry(&ht, &array[i], params);
+		if (err < 0)
+			break;
+		if (i % 16)
+			continue;
+
+		key.id = get_random_u32_below(i + 1);
+		key.tid = 0;
+		rcu_read_lock();
+		tbl = rcu_dereference(ht.tbl);
+		resizing = rcu_access_pointer(tbl->future_tbl);
+		start = ktime_get_ns();
+		if (!rhashtable_lookup(&ht, &key, params))
+			pr_warn("Test failed: Could not find key %u\n", key.id);
+		t = ktime_get_ns() - start;
+		rcu_read_unlock();
+
+		total[resizing] += t;
+		max[resizing] = max(max[resizing], t);
+		samples[resizing]++;
+	}
+
+	pr_info("  Lookup latency while resizing: avg %llu ns, max %llu ns, %llu samples\n",
+		samples[1] ? div64_u64(total[1], samples[1]) : 0, max[1],
+		samples[1]);
+	pr_info("  Lookup latency otherwise: avg %llu ns, max %llu ns, %llu samples\n",
+		samples[0] ? div64_u64(total[0], samples[0]) : 0, max[0],
+		samples[0]);
+	rhashtable_destroy(&ht);
+}
+
 static int __init test_rhltable(unsigned int entries)
 {
 	struct test_obj_rhl *rhl_test_objects;
@@ -728,6 +787,9 @@ static int __init test_rht_init(void)
 		total_time += time;
 	}
 
+	pr_info("Testing lookup latency during resize\n");
+	test_rht_resize_latency(objs, entries);
+
 	pr_info("test if its possible to exceed max_size %d: %s\n",
 			test_rht_params.max_size, test_rhashtable_max(objs, entries) == 0 ?
 			"no, ok" : "YES, failed");
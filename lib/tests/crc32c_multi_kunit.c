@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * KUnit test for crc32c_multi(), checking it against crc32c().
+ */
+#include <kunit/test.h>
+#include <linux/crc32.h>
+#include <linux/prandom.h>
+
+#define CRC32C_MULTI_TEST_NR	9
+#define CRC32C_MULTI_TEST_LEN	520
+
+static const size_t crc32c_multi_test_lens[] = { 0, 1, 3, 8, 63, 512, 520 };
+
+struct crc32c_multi_test {
+	u8 *bufs[CRC32C_MULTI_TEST_NR];
+	u32 seeds[CRC32C_MULTI_TEST_NR];
+};
+
+static struct crc32c_multi_test *crc32c_multi_test_alloc(struct kunit *test)
+{
+	struct crc32c_multi_test *t;
+	struct rnd_state rng;
+	unsigned int i;
+
+	t = kunit_kzalloc(test, sizeof(*t), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, t);
+
+	prandom_seed_state(&rng, 0x32c);
+	for (i = 0; i < CRC32C_MULTI_TEST_NR; i++) {
+		t->bufs[i] = kunit_kmalloc(test, CRC32C_MULTI_TEST_LEN,
+					   GFP_KERNEL);
+		KUNIT_ASSERT_NOT_NULL(test, t->bufs[i]);
+		prandom_bytes_state(&rng, t->bufs[i], CRC32C_MULTI_TEST_LEN);
+		t->seeds[i] = prandom_u32_state(&rng);
+	}
+	return t;
+}
+
+/* every @nr, including those not a multiple of four, and every length */
+static void check_crc32c_multi(struct kunit *test,
+			       void (*fn)(u32 *crcs, const u8 * const *bufs,
+					  size_t len, unsigned int nr))
+{
+	struct crc32c_multi_test *t = crc32c_multi_test_alloc(test);
+	u32 crcs[CRC32C_MULTI_TEST_NR];
+	unsigned int nr, i, l;
+
+	for (l = 0; l < ARRAY_SIZE(crc32c_multi_test_lens); l++) {
+		size_t len = crc32c_multi_test_lens[l];
+
+		for (nr = 0; nr <= CRC32C_MULTI_TEST_NR; nr++) {
+			memcpy(crcs, t->seeds, sizeof(crcs));
+			fn(crcs, (const u8 * const *)t->bufs, len, nr);
+
+			for (i = 0; i < nr; i++)
+				KUNIT_EXPECT_EQ_MSG(test, crcs[i],
+					crc32c(t->seeds[i], t->bufs[i], len),
+					"nr=%u len=%zu buffer %u", nr, len, i);
+			/* buffers past @nr must be left alone */
+			for (; i < CRC32C_MULTI_TEST_NR; i++)
+				KUNIT_EXPECT_EQ(test, crcs[i], t->seeds[i]);
+		}
+	}
+}
+
+static void crc32c_multi_base_test(struct kunit *test)
+{
+	check_crc32c_multi(test, crc32c_multi_base);
+}
+
+static void crc32c_multi_test(struct kunit *test)
+{
+	check_crc32c_multi(test, crc32c_multi);
+}
+
+static struct kunit_case crc32c_multi_test_cases[] = {
+	KUNIT_CASE(crc32c_multi_base_test),
+	KUNIT_CASE(crc32c_multi_test),
+	{}
+};
+
+static struct kunit_suite crc32c_multi_test_suite = {
+	.name = "crc32c_multi",
+	.test_cases = crc32c_multi_test_cases,
+};
+kunit_test_suite(crc32c_multi_test_suite);
+
+MODULE_DESCRIPTION("KUnit test for crc32c_multi()");
+MODULE_LICENSE("GPL");
@@ -1924,6 +1924,18 @@ static int sysctl_compact_unevictable_allowed __read_mostly = CONFIG_COMPACT_UNE
  * background. It takes values in the range [0, 100].
  */
 static unsigned int __read_mostly sysctl_compaction_proactiveness = 20;
+
+/*
+ * Order whose external fragmentation drives proactive compaction, and the
+ * number of pageblocks the migration scanner may cover in one proactive
+ * pass over a zone. With a batch limit, successive passes resume where the
+ * previous one stopped instead of rescanning the zone, so kcompactd does a
+ * little work every wakeup rather than occasional long passes. 0 means no
+ * limit.
+ */
+static unsigned int __read_mostly sysctl_compaction_proactive_order;
+static unsigned int __read_mostly sysctl_compaction_proactive_batch;
+static unsigned int compaction_order_max = MAX_PAGE_ORDER;
 static int sysctl_extfrag_threshold = 500;
 static int __read_mostly sysctl_compact_memory;
 
@@ -2198,16 +2210,18 @@ static bool kswapd_is_running(pg_data_t *pgdat)
 
 /*
  * A zone's fragmentation score is the external fragmentation wrt to the
- * COMPACTION_HPAGE_ORDER. It returns a value in the range [0, 100].
+ * proactive compaction order, COMPACTION_HPAGE_ORDER by default. It
+ * returns a value in the range [0, 100].
  */
 static unsigned int fragmentation_score_zone(struct zone *zone)
 {
-	return extfrag_for_order(zone, COMPACTION_HPAGE_ORDER);
+	return extfrag_for_order(zone,
+			READ_ONCE(sysctl_compaction_proactive_order));
 }
 
 /*
  * A weighted zone's fragmentation score is the external fragmentation
- * wrt to the COMPACTION_HPAGE_ORDER scaled by the zone's size. It
+ * wrt to the proactive compaction order scaled by the zone's size. It
  * returns a value in the range [0, 100].
  *
  * The scaling factor ensures that proactive compaction focuses on larger
@@ -2298,6 +2312,7 @@ static enum compact_result __compact_finished(struct compact_control *cc)
 	}
 
 	if (cc->proactive_compaction) {
+		unsigned int batch = READ_ONCE(sysctl_compaction_proactive_batch);
 		int score, wmark_low;
 		pg_data_t *pgdat;
 
@@ -2305,6 +2320,10 @@ static enum compact_result __compact_finished(struct compact_control *cc)
 		if (kswapd_is_running(pgdat))
 			return COMPACT_PARTIAL_SKIPPED;
 
+		if (batch && cc->total_migrate_scanned >=
+		    (unsigned long)batch * pageblock_nr_pages)
+			return COMPACT_PARTIAL_SKIPPED;
+
 		score = fragmentation_score_zone(cc->zone);
 		wmark_low = fragmentation_score_wmark(true);
 
@@ -2936,11 +2955,12 @@ static int compact_node(pg_data_t *pgdat, bool proactive)
 {
 	int zoneid;
 	struct zone *zone;
+	bool incremental = proactive &&
+			   READ_ONCE(sysctl_compaction_proactive_batch);
 	struct compact_control cc = {
 		.order = -1,
 		.mode = proactive ? MIGRATE_SYNC_LIGHT : MIGRATE_SYNC,
 		.ignore_skip_hint = true,
-		.whole_zone = true,
 		.gfp_mask = GFP_KERNEL,
 		.proactive_compaction = proactive,
 	};
@@ -2954,6 +2974,8 @@ static int compact_node(pg_data_t *pgdat, bool proactive)
 			return -EINTR;
 
 		cc.zone = zone;
+		/* Incremental passes resume from the cached scanner positions */
+		cc.whole_zone = !incremental;
 
 		compact_zone(&cc, NULL);
 
@@ -3257,9 +3279,12 @@ static int kcompactd(void *p)
 			score = fragmentation_score_node(pgdat);
 			/*
 			 * Defer proactive compaction if the fragmentation
-			 * score did not go down i.e. no progress made.
+			 * score did not go down i.e. no progress made. A
+			 * bounded incremental pass may legitimately leave it
+			 * unchanged, so keep going at the default pace then.
 			 */
-			if (unlikely(score >= prev_score))
+			if (unlikely(score >= prev_score) &&
+			    !READ_ONCE(sysctl_compaction_proactive_batch))
 				timeout =
 				   default_timeout << COMPACT_MAX_DEFER_SHIFT;
 		}
@@ -3342,6 +3367,22 @@ static const struct ctl_table vm_compaction[] = {
 		.extra1		= SYSCTL_ZERO,
 		.extra2		= SYSCTL_ONE_HUNDRED,
 	},
+	{
+		.procname	= "compaction_proactive_order",
+		.data		= &sysctl_compaction_proactive_order,
+		.maxlen		= sizeof(sysctl_compaction_proactive_order),
+		.mode		= 0644,
+		.proc_handler	= proc_douintvec_minmax,
+		.extra1		= SYSCTL_ONE,
+		.extra2		= &compaction_order_max,
+	},
+	{
+		.procname	= "compaction_proactive_batch",
+		.data		= &sysctl_compaction_proactive_batch,
+		.maxlen		= sizeof(sysctl_compaction_proactive_batch),
+		.mode		= 0644,
+		.proc_handler	= proc_douintvec,
+	},
 	{
 		.procname	= "extfrag_threshold",
 		.data		= &sysctl_extfrag_threshold,
@@ -3366,6 +3407,7 @@ static int __init kcompactd_init(void)
 {
 	int nid;
 
+	sysctl_compaction_proactive_order = COMPACTION_HPAGE_ORDER;
 	for_each_node_state(nid, N_MEMORY)
 		kcompactd_run(nid);
 	register_sysctl_init("vm", vm_compaction);
@@ -76,17 +76,6 @@ static void __damon_pa_prepare_access_check(struct damon_region *r)
 	damon_pa_mkold(r->sampling_addr);
 }
 
-static void damon_pa_prepare_access_checks(struct damon_ctx *ctx)
-{
-	struct damon_target *t;
-	struct damon_region *r;
-
-	damon_for_each_target(t, ctx) {
-		damon_for_each_region(r, t)
-			__damon_pa_prepare_access_check(r);
-	}
-}
-
 static bool damon_folio_young_one(struct folio *folio,
 		struct vm_area_struct *vma, unsigned long addr, void *arg)
 {
@@ -170,35 +159,81 @@ static bool damon_pa_young(unsigned long paddr, unsigned long *folio_sz)
 	return accessed;
 }
 
+/* Result of the last checked folio, reused for following regions in it. */
+struct damon_pa_last_check {
+	unsigned long addr;
+	unsigned long folio_sz;
+	bool accessed;
+};
+
 static void __damon_pa_check_access(struct damon_region *r,
-		struct damon_attrs *attrs)
+		struct damon_attrs *attrs, struct damon_pa_last_check *last)
 {
-	static unsigned long last_addr;
-	static unsigned long last_folio_sz = PAGE_SIZE;
-	static bool last_accessed;
-
 	/* If the region is in the last checked page, reuse the result */
-	if (ALIGN_DOWN(last_addr, last_folio_sz) ==
-				ALIGN_DOWN(r->sampling_addr, last_folio_sz)) {
-		damon_update_region_access_rate(r, last_accessed, attrs);
+	if (ALIGN_DOWN(last->addr, last->folio_sz) ==
+				ALIGN_DOWN(r->sampling_addr, last->folio_sz)) {
+		damon_update_region_access_rate(r, last->accessed, attrs);
 		return;
 	}
 
-	last_accessed = damon_pa_young(r->sampling_addr, &last_folio_sz);
-	damon_update_region_access_rate(r, last_accessed, attrs);
+	last->accessed = damon_pa_young(r->sampling_addr, &last->folio_sz);
+	damon_update_region_access_rate(r, last->accessed, attrs);
 
-	last_addr = r->sampling_addr;
+	last->addr = r->sampling_addr;
 }
 
-static unsigned int damon_pa_check_accesses(struct damon_ctx *ctx)
+/*
+ * On large machines a single kdamond cannot do the rmap walks for all
+ * regions within a sampling interval.  Once there are enough regions, the
+ * access checks are split by the node that backs each region and run on
+ * per-node unbound workers, close to the memory they touch.  kdamond
+ * waits for all of them, so the region lists are stable meanwhile.
+ */
+#define DAMON_PA_PARALLEL_MIN_REGIONS	512
+
+struct damon_pa_node_work {
+	struct work_struct work;
+	struct damon_ctx *ctx;
+	int nid;
+	bool prepare;
+	unsigned int max_nr_accesses;
+};
+
+static int damon_pa_region_nid(struct damon_region *r)
 {
+	unsigned long pfn = PHYS_PFN(r->ar.start);
+
+	return pfn_valid(pfn) ? pfn_to_nid(pfn) : NUMA_NO_NODE;
+}
+
+/*
+ * Process the regions backed by @nid, or all of them if @nid is
+ * NUMA_NO_NODE, except those backed by a node in @skip.
+ */
+static unsigned int damon_pa_access_checks(struct damon_ctx *ctx, int nid,
+		const nodemask_t *skip, bool prepare)
+{
+	struct damon_pa_last_check last = { .folio_sz = PAGE_SIZE };
+	unsigned int max_nr_accesses = 0;
 	struct damon_target *t;
 	struct damon_region *r;
-	unsigned int max_nr_accesses = 0;
 
 	damon_for_each_target(t, ctx) {
 		damon_for_each_region(r, t) {
-			__damon_pa_check_access(r, &ctx->attrs);
+			if (nid != NUMA_NO_NODE || skip) {
+				int r_nid = damon_pa_region_nid(r);
+
+				if (nid != NUMA_NO_NODE && r_nid != nid)
+					continue;
+				if (skip && r_nid != NUMA_NO_NODE &&
+				    node_isset(r_nid, *skip))
+					continue;
+			}
+			if (prepare) {
+				__damon_pa_prepare_access_check(r);
+				continue;
+			}
+			__damon_pa_check_access(r, &ctx->attrs, &last);
 			max_nr_accesses = max(r->nr_accesses, max_nr_accesses);
 		}
 	}
@@ -206,6 +241,77 @@ static unsigned int damon_pa_check_accesses(struct damon_ctx *ctx)
 	return max_nr_accesses;
 }
 
+static void damon_pa_node_work_fn(struct work_struct *work)
+{
+	struct damon_pa_node_work *nw = container_of(work,
+			struct damon_pa_node_work, work);
+
+	nw->max_nr_accesses = damon_pa_access_checks(nw->ctx, nw->nid, NULL,
+			nw->prepare);
+}
+
+static bool damon_pa_parallel(struct damon_ctx *ctx)
+{
+	struct damon_target *t;
+	unsigned int nr_regions = 0;
+
+	if (num_node_state(N_MEMORY) < 2)
+		return false;
+	damon_for_each_target(t, ctx)
+		nr_regions += damon_nr_regions(t);
+	return nr_regions >= DAMON_PA_PARALLEL_MIN_REGIONS;
+}
+
+static unsigned int damon_pa_run_access_checks(struct damon_ctx *ctx,
+		bool prepare)
+{
+	struct damon_pa_node_work *works;
+	unsigned int max_nr_accesses = 0;
+	nodemask_t queued = NODE_MASK_NONE;
+	int nid, i, nr_works = 0;
+
+	if (!damon_pa_parallel(ctx))
+		return damon_pa_access_checks(ctx, NUMA_NO_NODE, NULL, prepare);
+
+	works = kcalloc(nr_node_ids, sizeof(*works), GFP_KERNEL);
+	if (!works)
+		return damon_pa_access_checks(ctx, NUMA_NO_NODE, NULL, prepare);
+
+	for_each_node_state(nid, N_MEMORY) {
+		struct damon_pa_node_work *nw = &works[nr_works++];
+
+		INIT_WORK(&nw->work, damon_pa_node_work_fn);
+		nw->ctx = ctx;
+		nw->nid = nid;
+		nw->prepare = prepare;
+		node_set(nid, queued);
+		queue_work_node(nid, system_unbound_wq, &nw->work);
+	}
+
+	/* Regions in holes or on nodes that got memory meanwhile */
+	max_nr_accesses = damon_pa_access_checks(ctx, NUMA_NO_NODE, &queued,
+			prepare);
+
+	for (i = 0; i < nr_works; i++) {
+		flush_work(&works[i].work);
+		max_nr_accesses = max(works[i].max_nr_accesses,
+				max_nr_accesses);
+	}
+	kfree(works);
+
+	return max_nr_accesses;
+}
+
+static void damon_pa_prepare_access_checks(struct damon_ctx *ctx)
+{
+	damon_pa_run_access_checks(ctx, true);
+}
+
+static unsigned int damon_pa_check_accesses(struct damon_ctx *ctx)
+{
+	return damon_pa_run_access_checks(ctx, false);
+}
+
 static bool damos_pa_filter_match(struct damos_filter *filter,
 		struct folio *folio)
 {
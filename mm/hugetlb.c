@@ -3540,23 +3540,58 @@ static void __init hugetlb_hstate_alloc_pages_onenode(struct hstate *h, int nid)
 	string_get_size(huge_page_size(h), 1, STRING_UNITS_2, buf, 32);
 	pr_warn("HugeTLB: allocating %u of page size %s failed node%d.  Only allocated %lu hugepages.\n",
 		h->max_huge_pages_node[nid], buf, nid, i);
-	h->max_huge_pages -= (h->max_huge_pages_node[nid] - i);
 	h->max_huge_pages_node[nid] = i;
 }
 
+static void __init hugetlb_hstate_alloc_pages_node_parallel(unsigned long start,
+							    unsigned long end,
+							    void *arg)
+{
+	struct hstate *h = arg;
+	int nid;
+
+	for (nid = start; nid < end; nid++) {
+		if (node_online(nid) && h->max_huge_pages_node[nid] > 0)
+			hugetlb_hstate_alloc_pages_onenode(h, nid);
+	}
+}
+
 static bool __init hugetlb_hstate_alloc_pages_specific_nodes(struct hstate *h)
 {
+	unsigned long requested = 0, allocated = 0;
 	int i;
-	bool node_specific_alloc = false;
 
-	for_each_online_node(i) {
-		if (h->max_huge_pages_node[i] > 0) {
-			hugetlb_hstate_alloc_pages_onenode(h, i);
-			node_specific_alloc = true;
-		}
+	for_each_online_node(i)
+		requested += h->max_huge_pages_node[i];
+	if (!requested)
+		return false;
+
+	/*
+	 * Gigantic pages come from memblock this early in boot, so only
+	 * buddy allocated pages can be allocated on all nodes at once.
+	 */
+	if (hstate_is_gigantic(h)) {
+		hugetlb_hstate_alloc_pages_node_parallel(0, nr_node_ids, h);
+	} else {
+		struct padata_mt_job job = {
+			.thread_fn	= hugetlb_hstate_alloc_pages_node_parallel,
+			.fn_arg		= h,
+			.start		= 0,
+			.size		= nr_node_ids,
+			.align		= 1,
+			.min_chunk	= 1,
+			.max_threads	= num_node_state(N_MEMORY),
+			.numa_aware	= true,
+		};
+
+		padata_do_multithreaded(&job);
 	}
 
-	return node_specific_alloc;
+	for_each_online_node(i)
+		allocated += h->max_huge_pages_node[i];
+	h->max_huge_pages -= requested - allocated;
+
+	return true;
 }
 
 static void __init hugetlb_hstate_alloc_pages_errcheck(unsigned long allocated, struct hstate *h)
@@ -824,6 +824,9 @@ extern void *memmap_alloc(phys_addr_t size, phys_addr_t align,
 
 void memmap_init_range(unsigned long, int, unsigned long, unsigned long,
 		unsigned long, enum meminit_context, struct vmem_altmap *, int);
+void memmap_init_hotplug_range(unsigned long size, int nid,
+		unsigned long zone, unsigned long start_pfn,
+		struct vmem_altmap *altmap, int migratetype);
 
 #if defined CONFIG_COMPACTION || defined CONFIG_CMA
 
@@ -1285,6 +1288,7 @@ extern struct workqueue_struct *mm_percpu_wq;
 #ifdef CONFIG_ARCH_WANT_BATCHED_UNMAP_TLB_FLUSH
 void try_to_unmap_flush(void);
 void try_to_unmap_flush_dirty(void);
+bool try_to_unmap_flush_dirty_pending(void);
 void flush_tlb_batched_pending(struct mm_struct *mm);
 #else
 static inline void try_to_unmap_flush(void)
@@ -1293,6 +1297,10 @@ static inline void try_to_unmap_flush(void)
 static inline void try_to_unmap_flush_dirty(void)
 {
 }
+static inline bool try_to_unmap_flush_dirty_pending(void)
+{
+	return false;
+}
 static inline void flush_tlb_batched_pending(struct mm_struct *mm)
 {
 }
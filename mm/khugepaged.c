@@ -130,6 +130,46 @@ static struct khugepaged_scan khugepaged_scan = {
 	.mm_head = LIST_HEAD_INIT(khugepaged_scan.mm_head),
 };
 
+/**
+ * struct khugepaged_hint - a PMD range that is worth collapsing soon
+ * @mm: the mm, pinned with mmgrab()
+ * @address: PMD aligned address inside @mm
+ *
+ * Hints are queued by page faults that fell back from a PMD mapping and by
+ * page table walks that found a densely accessed PTE table. khugepaged
+ * handles them before it resumes its linear scan, so hot memory doesn't
+ * have to wait for the scan cursor to come around.
+ */
+struct khugepaged_hint {
+	struct mm_struct *mm;
+	unsigned long address;
+};
+
+/*
+ * Hints are queued from the page fault path, so the queue is lockless: a
+ * hint hashes to one slot, which a producer claims with cmpxchg() from
+ * HINT_FREE to HINT_BUSY, fills in and publishes as HINT_READY. A hint
+ * whose slot is taken is dropped, which also deduplicates hints.
+ */
+enum {
+	HINT_FREE,
+	HINT_BUSY,
+	HINT_READY,
+};
+
+struct khugepaged_hint_slot {
+	atomic_t state;
+	struct khugepaged_hint hint;
+};
+
+#define KHUGEPAGED_HINT_BITS	6
+
+static struct khugepaged_hint_slot khugepaged_hints[1 << KHUGEPAGED_HINT_BITS];
+static bool khugepaged_hints_pending;
+/* set after a huge page allocation failed, see khugepaged_hint_backoff() */
+static bool khugepaged_hints_off;
+static unsigned long khugepaged_hints_expire;
+
 #ifdef CONFIG_SYSFS
 static ssize_t scan_sleep_millisecs_show(struct kobject *kobj,
 					 struct kobj_attribute *attr,
@@ -2363,6 +2403,47 @@ static int hpage_collapse_scan_file(struct mm_struct *mm, unsigned long addr,
 }
 #endif
 
+/*
+ * Collapse the PMD range at @address, which must be inside @vma. May drop
+ * mmap_lock, in which case *@mmap_locked is set to false.
+ */
+static int khugepaged_collapse_range(struct mm_struct *mm,
+				     struct vm_area_struct *vma,
+				     unsigned long address, bool *mmap_locked,
+				     struct collapse_control *cc)
+{
+	int result;
+
+	if (IS_ENABLED(CONFIG_SHMEM) && !vma_is_anonymous(vma)) {
+		struct file *file = get_file(vma->vm_file);
+		pgoff_t pgoff = linear_page_index(vma, address);
+
+		mmap_read_unlock(mm);
+		*mmap_locked = false;
+		result = hpage_collapse_scan_file(mm, address, file, pgoff, cc);
+		fput(file);
+		if (result == SCAN_PTE_MAPPED_HUGEPAGE) {
+			mmap_read_lock(mm);
+			if (hpage_collapse_test_exit_or_disable(mm)) {
+				mmap_read_unlock(mm);
+				return SCAN_ANY_PROCESS;
+			}
+			result = collapse_pte_mapped_thp(mm, address, false);
+			if (result == SCAN_PMD_MAPPED)
+				result = SCAN_SUCCEED;
+			mmap_read_unlock(mm);
+		}
+	} else {
+		result = hpage_collapse_scan_pmd(mm, vma, address, mmap_locked,
+						 cc);
+	}
+
+	if (result == SCAN_SUCCEED)
+		++khugepaged_pages_collapsed;
+
+	return result;
+}
+
 static unsigned int khugepaged_scan_mm_slot(unsigned int pages, int *result,
 					    struct collapse_control *cc)
 	__releases(&khugepaged_mm_lock)
@@ -2437,33 +2518,8 @@ static unsigned int khugepaged_scan_mm_slot(unsigned int pages, int *result,
 			VM_BUG_ON(khugepaged_scan.address < hstart ||
 				  khugepaged_scan.address + HPAGE_PMD_SIZE >
 				  hend);
-			if (IS_ENABLED(CONFIG_SHMEM) && !vma_is_anonymous(vma)) {
-				struct file *file = get_file(vma->vm_file);
-				pgoff_t pgoff = linear_page_index(vma,
-						khugepaged_scan.address);
-
-				mmap_read_unlock(mm);
-				mmap_locked = false;
-				*result = hpage_collapse_scan_file(mm,
-					khugepaged_scan.address, file, pgoff, cc);
-				fput(file);
-				if (*result == SCAN_PTE_MAPPED_HUGEPAGE) {
-					mmap_read_lock(mm);
-					if (hpage_collapse_test_exit_or_disable(mm))
-						goto breakouterloop;
-					*result = collapse_pte_mapped_thp(mm,
-						khugepaged_scan.address, false);
-					if (*result == SCAN_PMD_MAPPED)
-						*result = SCAN_SUCCEED;
-					mmap_read_unlock(mm);
-				}
-			} else {
-				*result = hpage_collapse_scan_pmd(mm, vma,
+			*result = khugepaged_collapse_range(mm, vma,
 					khugepaged_scan.address, &mmap_locked, cc);
-			}
-
-			if (*result == SCAN_SUCCEED)
-				++khugepaged_pages_collapsed;
 
 			/* move to next address */
 			khugepaged_scan.address += HPAGE_PMD_SIZE;
@@ -2514,6 +2570,132 @@ static unsigned int khugepaged_scan_mm_slot(unsigned int pages, int *result,
 	return progress;
 }
 
+/**
+ * khugepaged_hint - ask khugepaged to look at a PMD range soon
+ * @vma: the vma containing @address
+ * @address: any address inside the PMD range
+ *
+ * The hint is dropped if the range is not eligible for a PMD THP, if the mm
+ * isn't registered with khugepaged, or if too many hints are pending.
+ */
+void khugepaged_hint(struct vm_area_struct *vma, unsigned long address)
+{
+	struct mm_struct *mm = vma->vm_mm;
+	unsigned long haddr = address & HPAGE_PMD_MASK;
+	struct khugepaged_hint_slot *slot;
+
+	if (!test_bit(MMF_VM_HUGEPAGE, &mm->flags))
+		return;
+	/* don't cut an allocation failure back-off short */
+	if (READ_ONCE(khugepaged_hints_off))
+		return;
+	if (haddr < vma->vm_start || haddr + HPAGE_PMD_SIZE > vma->vm_end)
+		return;
+	if (!thp_vma_allowable_order(vma, vma->vm_flags, TVA_ENFORCE_SYSFS,
+				     PMD_ORDER))
+		return;
+
+	slot = &khugepaged_hints[hash_long((unsigned long)mm ^ haddr,
+					   KHUGEPAGED_HINT_BITS)];
+	if (atomic_read(&slot->state) != HINT_FREE ||
+	    atomic_cmpxchg(&slot->state, HINT_FREE, HINT_BUSY) != HINT_FREE)
+		return;
+	mmgrab(mm);
+	slot->hint.mm = mm;
+	slot->hint.address = haddr;
+	atomic_set_release(&slot->state, HINT_READY);
+
+	/* pairs with the xchg() in khugepaged_scan_hints() */
+	if (!xchg(&khugepaged_hints_pending, true))
+		wake_up_interruptible(&khugepaged_wait);
+}
+
+static bool khugepaged_has_hints(void)
+{
+	return READ_ONCE(khugepaged_hints_pending);
+}
+
+/*
+ * Stop taking hints for alloc_sleep_millisecs, like the linear scan does
+ * after a huge page allocation failed.
+ */
+static void khugepaged_hint_backoff(void)
+{
+	khugepaged_hints_expire = jiffies +
+		msecs_to_jiffies(khugepaged_alloc_sleep_millisecs);
+	WRITE_ONCE(khugepaged_hints_off, true);
+}
+
+static int khugepaged_collapse_hint(struct khugepaged_hint *hint,
+				    struct collapse_control *cc)
+{
+	struct mm_struct *mm = hint->mm;
+	struct vm_area_struct *vma;
+	bool mmap_locked = true;
+	int result = SCAN_FAIL;
+
+	if (!mmget_not_zero(mm))
+		return SCAN_ANY_PROCESS;
+
+	if (unlikely(!mmap_read_trylock(mm)))
+		goto out;
+
+	if (unlikely(hpage_collapse_test_exit_or_disable(mm)))
+		goto unlock;
+
+	vma = vma_lookup(mm, hint->address);
+	if (!vma || hint->address + HPAGE_PMD_SIZE > vma->vm_end ||
+	    !thp_vma_allowable_order(vma, vma->vm_flags, TVA_ENFORCE_SYSFS,
+				     PMD_ORDER))
+		goto unlock;
+
+	result = khugepaged_collapse_range(mm, vma, hint->address,
+					   &mmap_locked, cc);
+unlock:
+	if (mmap_locked)
+		mmap_read_unlock(mm);
+out:
+	mmput(mm);
+	return result;
+}
+
+/*
+ * Handle all pending hints. They are dropped instead if khugepaged is
+ * stopping or backing off after a failed huge page allocation: the linear
+ * scan will get to them later.
+ */
+static void khugepaged_scan_hints(struct collapse_control *cc)
+{
+	struct khugepaged_hint hint;
+	bool drop;
+	int i;
+
+	if (khugepaged_hints_off &&
+	    !time_before(jiffies, khugepaged_hints_expire))
+		WRITE_ONCE(khugepaged_hints_off, false);
+	drop = kthread_should_stop() || khugepaged_hints_off;
+
+	if (!xchg(&khugepaged_hints_pending, false))
+		return;
+
+	for (i = 0; i < ARRAY_SIZE(khugepaged_hints); i++) {
+		struct khugepaged_hint_slot *slot = &khugepaged_hints[i];
+
+		if (atomic_read_acquire(&slot->state) != HINT_READY)
+			continue;
+		hint = slot->hint;
+		atomic_set_release(&slot->state, HINT_FREE);
+
+		if (!drop && khugepaged_collapse_hint(&hint, cc) ==
+			     SCAN_ALLOC_HUGE_PAGE_FAIL) {
+			khugepaged_hint_backoff();
+			drop = true;
+		}
+		mmdrop(hint.mm);
+		cond_resched();
+	}
+}
+
 static int khugepaged_has_work(void)
 {
 	return !list_empty(&khugepaged_scan.mm_head) && hugepage_pmd_enabled();
@@ -2534,6 +2716,8 @@ static void khugepaged_do_scan(struct collapse_control *cc)
 
 	lru_add_drain_all();
 
+	khugepaged_scan_hints(cc);
+
 	while (true) {
 		cond_resched();
 
@@ -2559,6 +2743,7 @@ static void khugepaged_do_scan(struct collapse_control *cc)
 			 * If fail to allocate the first time, try to sleep for
 			 * a while.  When hit again, cancel the scan.
 			 */
+			khugepaged_hint_backoff();
 			if (!wait)
 				break;
 			wait = false;
@@ -2576,17 +2761,29 @@ static bool khugepaged_should_wakeup(void)
 static void khugepaged_wait_work(void)
 {
 	if (khugepaged_has_work()) {
-		const unsigned long scan_sleep_jiffies =
+		unsigned long scan_sleep_jiffies =
 			msecs_to_jiffies(khugepaged_scan_sleep_millisecs);
+		unsigned long now;
 
 		if (!scan_sleep_jiffies)
 			return;
 
 		khugepaged_sleep_expire = jiffies + scan_sleep_jiffies;
-		wait_event_freezable_timeout(khugepaged_wait,
-					     khugepaged_should_wakeup(),
-					     scan_sleep_jiffies);
-		return;
+		while (true) {
+			wait_event_freezable_timeout(khugepaged_wait,
+						     khugepaged_should_wakeup() ||
+						     khugepaged_has_hints(),
+						     scan_sleep_jiffies);
+			if (khugepaged_should_wakeup())
+				return;
+			/* handle hints without speeding up the linear scan */
+			khugepaged_scan_hints(&khugepaged_collapse_control);
+			now = jiffies;
+			if (kthread_should_stop() ||
+			    !time_before(now, khugepaged_sleep_expire))
+				return;
+			scan_sleep_jiffies = khugepaged_sleep_expire - now;
+		}
 	}
 
 	if (hugepage_pmd_enabled())
@@ -2605,6 +2802,8 @@ static int khugepaged(void *none)
 		khugepaged_wait_work();
 	}
 
+	khugepaged_scan_hints(&khugepaged_collapse_control);
+
 	spin_lock(&khugepaged_mm_lock);
 	mm_slot = khugepaged_scan.mm_slot;
 	khugepaged_scan.mm_slot = NULL;
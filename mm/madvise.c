@@ -794,8 +794,14 @@ static const struct mm_walk_ops madvise_free_walk_ops = {
 	.walk_lock		= PGWALK_RDLOCK,
 };
 
+static const struct mm_walk_ops madvise_free_vma_walk_ops = {
+	.pmd_entry		= madvise_free_pte_range,
+	.walk_lock		= PGWALK_VMA_RDLOCK_VERIFY,
+};
+
 static int madvise_free_single_vma(struct vm_area_struct *vma,
-			unsigned long start_addr, unsigned long end_addr)
+			unsigned long start_addr, unsigned long end_addr,
+			const struct mm_walk_ops *walk_ops)
 {
 	struct mm_struct *mm = vma->vm_mm;
 	struct mmu_notifier_range range;
@@ -820,8 +826,7 @@ static int madvise_free_single_vma(struct vm_area_struct *vma,
 
 	mmu_notifier_invalidate_range_start(&range);
 	tlb_start_vma(&tlb, vma);
-	walk_page_range(vma->vm_mm, range.start, range.end,
-			&madvise_free_walk_ops, &tlb);
+	walk_page_range_vma(vma, range.start, range.end, walk_ops, &tlb);
 	tlb_end_vma(&tlb, vma);
 	mmu_notifier_invalidate_range_end(&range);
 	tlb_finish_mmu(&tlb);
@@ -948,7 +953,8 @@ static long madvise_dontneed_free(struct vm_area_struct *vma,
 	if (behavior == MADV_DONTNEED || behavior == MADV_DONTNEED_LOCKED)
 		return madvise_dontneed_single_vma(vma, start, end);
 	else if (behavior == MADV_FREE)
-		return madvise_free_single_vma(vma, start, end);
+		return madvise_free_single_vma(vma, start, end,
+					       &madvise_free_walk_ops);
 	else
 		return -EINVAL;
 }
@@ -1698,6 +1704,61 @@ static int madvise_do_behavior(struct mm_struct *mm,
 	return error;
 }
 
+/*
+ * MADV_DONTNEED and MADV_FREE of a range within a single anonymous vma only
+ * need that vma to be stable, so try to do them under its per-vma lock and
+ * leave mmap_lock to the operations that change the address space. Returns
+ * false if the caller has to fall back to taking mmap_lock.
+ */
+static bool madvise_try_vma_locked(struct mm_struct *mm, unsigned long start,
+				   size_t len_in, int behavior, int *err)
+{
+	struct vm_area_struct *vma;
+	unsigned long end;
+
+	switch (behavior) {
+	case MADV_DONTNEED:
+	case MADV_DONTNEED_LOCKED:
+	case MADV_FREE:
+		break;
+	default:
+		return false;
+	}
+
+	if (mm != current->mm)
+		return false;
+
+	start = untagged_addr(start);
+	end = start + PAGE_ALIGN(len_in);
+
+	vma = lock_vma_under_rcu(mm, start);
+	if (!vma)
+		return false;
+
+	/*
+	 * userfaultfd_remove() would drop mmap_lock, and other vmas are
+	 * handled by the generic path.
+	 */
+	if (end > vma->vm_end || !vma_is_anonymous(vma) ||
+	    userfaultfd_armed(vma)) {
+		vma_end_read(vma);
+		return false;
+	}
+
+	if (unlikely(!can_modify_vma_madv(vma, behavior)))
+		*err = -EPERM;
+	else if (!madvise_dontneed_free_valid_vma(vma, start, &end, behavior))
+		*err = -EINVAL;
+	else if (behavior == MADV_FREE)
+		*err = madvise_free_single_vma(vma, start, end,
+					       &madvise_free_vma_walk_ops);
+	else
+		*err = madvise_dontneed_single_vma(vma, start, end);
+
+	vma_end_read(vma);
+	return true;
+}
+
 /*
  * The madvise(2) system call.
  *
@@ -1776,6 +1837,8 @@ int do_madvise(struct mm_struct *mm, unsigned long start, size_t len_in, int beh
 
 	if (madvise_should_skip(start, len_in, behavior, &error))
 		return error;
+	if (madvise_try_vma_locked(mm, start, len_in, behavior, &error))
+		return error;
 	error = madvise_lock(mm, behavior);
 	if (error)
 		return error;
@@ -63,6 +63,7 @@
 #include <linux/seq_buf.h>
 #include <linux/sched/isolation.h>
 #include <linux/kmemleak.h>
+#include <linux/random.h>
 #include "internal.h"
 #include <net/sock.h>
 #include <net/ip.h>
@@ -521,6 +522,9 @@ struct memcg_vmstats {
 
 	/* Stats updates since the last flush */
 	atomic64_t		stats_updates;
+
+	/* When the subtree rooted here was last flushed, in jiffies */
+	u64			last_flush;
 };
 
 /*
@@ -537,6 +541,11 @@ struct memcg_vmstats {
  *    (MEMCG_CHARGE_BATCH * nr_cpus) update events. Though this optimization
  *    will let stats be out of sync by atmost (MEMCG_CHARGE_BATCH * nr_cpus) but
  *    only for 2 seconds due to (1).
+ *
+ * 3) Userspace readers of the stat files can be told to accept data up to
+ *    vm.memcg_stats_max_age_ms old. A flush covers the whole subtree, so if
+ *    the memcg or any of its ancestors was flushed within that time, the
+ *    read doesn't flush at all and stays off the rstat lock.
  */
 static void flush_memcg_stats_dwork(struct work_struct *w);
 static DECLARE_DEFERRABLE_WORK(stats_flush_dwork, flush_memcg_stats_dwork);
@@ -544,6 +553,8 @@ static u64 flush_last_time;
 
 #define FLUSH_TIME (2UL*HZ)
 
+static unsigned int sysctl_memcg_stats_max_age_ms;
+
 /*
  * Accessors to ensure that preemption is disabled on PREEMPT_RT because it can
  * not rely on this as part of an acquired spinlock_t lock. These functions are
@@ -604,6 +615,7 @@ static inline void memcg_rstat_updated(struct mem_cgroup *memcg, int val)
 static void __mem_cgroup_flush_stats(struct mem_cgroup *memcg, bool force)
 {
 	bool needs_flush = memcg_vmstats_needs_flush(memcg->vmstats);
+	u64 now;
 
 	trace_memcg_flush_stats(memcg, atomic64_read(&memcg->vmstats->stats_updates),
 		force, needs_flush);
@@ -611,10 +623,12 @@ static void __mem_cgroup_flush_stats(struct mem_cgroup *memcg, bool force)
 	if (!force && !needs_flush)
 		return;
 
+	now = get_jiffies_64();
 	if (mem_cgroup_is_root(memcg))
-		WRITE_ONCE(flush_last_time, jiffies_64);
+		WRITE_ONCE(flush_last_time, now);
 
 	cgroup_rstat_flush(memcg->css.cgroup);
+	WRITE_ONCE(memcg->vmstats->last_flush, now);
 }
 
 /*
@@ -637,6 +651,36 @@ void mem_cgroup_flush_stats(struct mem_cgroup *memcg)
 	__mem_cgroup_flush_stats(memcg, false);
 }
 
+/*
+ * mem_cgroup_flush_stats_user - flush the stats of a subtree for a userspace
+ * reader
+ * @memcg: root of the subtree to flush
+ *
+ * Like mem_cgroup_flush_stats(), but skip the flush if the stats of @memcg
+ * are already no older than vm.memcg_stats_max_age_ms.
+ */
+void mem_cgroup_flush_stats_user(struct mem_cgroup *memcg)
+{
+	unsigned int max_age_ms = READ_ONCE(sysctl_memcg_stats_max_age_ms);
+	u64 now, max_age;
+	struct mem_cgroup *iter;
+
+	if (mem_cgroup_disabled())
+		return;
+
+	if (max_age_ms) {
+		now = get_jiffies_64();
+		max_age = msecs_to_jiffies(max_age_ms);
+		for (iter = memcg; iter; iter = parent_mem_cgroup(iter)) {
+			if (time_before64(now, READ_ONCE(iter->vmstats->last_flush) +
+						max_age))
+				return;
+		}
+	}
+
+	mem_cgroup_flush_stats(memcg);
+}
+
 void mem_cgroup_flush_stats_ratelimited(struct mem_cgroup *memcg)
 {
 	/* Only flush if the periodic flusher is one full cycle late */
@@ -1490,7 +1534,7 @@ static void memcg_stat_format(struct mem_cgroup *memcg, struct seq_buf *s)
 	 *
 	 * Current memory state:
 	 */
-	mem_cgroup_flush_stats(memcg);
+	mem_cgroup_flush_stats_user(memcg);
 
 	for (i = 0; i < ARRAY_SIZE(memory_stats); i++) {
 		u64 size;
@@ -1758,10 +1802,16 @@ void mem_cgroup_print_oom_group(struct mem_cgroup *memcg)
 	pr_cont(" are going to be killed due to memory.oom.group set\n");
 }
 
+/*
+ * A CPU that services many cgroups would keep draining and refilling a
+ * single cached charge, so cache a few memcgs at once.
+ */
+#define NR_MEMCG_STOCK 7
+
 struct memcg_stock_pcp {
 	local_trylock_t stock_lock;
-	struct mem_cgroup *cached; /* this never be root cgroup */
-	unsigned int nr_pages;
+	uint8_t nr_pages[NR_MEMCG_STOCK];
+	struct mem_cgroup *cached[NR_MEMCG_STOCK]; /* never the root cgroup */
 
 	struct obj_cgroup *cached_objcg;
 	struct pglist_data *cached_pgdat;
@@ -1782,13 +1832,20 @@ static struct obj_cgroup *drain_obj_stock(struct memcg_stock_pcp *stock);
 static bool obj_stock_flush_required(struct memcg_stock_pcp *stock,
 				     struct mem_cgroup *root_memcg);
 
+static void memcg_uncharge(struct mem_cgroup *memcg, unsigned int nr_pages)
+{
+	page_counter_uncharge(&memcg->memory, nr_pages);
+	if (do_memsw_account())
+		page_counter_uncharge(&memcg->memsw, nr_pages);
+}
+
 /**
  * consume_stock: Try to consume stocked charge on this cpu.
  * @memcg: memcg to consume from.
  * @nr_pages: how many pages to charge.
  * @gfp_mask: allocation mask.
  *
- * The charges will only happen if @memcg matches the current cpu's memcg
+ * The charges will only happen if @memcg is in the current cpu's memcg
  * stock, and at least @nr_pages are available in that stock.  Failure to
  * service an allocation will refill the stock.
  *
@@ -1801,6 +1858,7 @@ static bool consume_stock(struct mem_cgroup *memcg, unsigned int nr_pages,
 	unsigned int stock_pages;
 	unsigned long flags;
 	bool ret = false;
+	int i;
 
 	if (nr_pages > MEMCG_CHARGE_BATCH)
 		return ret;
@@ -1811,10 +1869,16 @@ static bool consume_stock(struct mem_cgroup *memcg, unsigned int nr_pages,
 		return ret;
 
 	stock = this_cpu_ptr(&memcg_stock);
-	stock_pages = READ_ONCE(stock->nr_pages);
-	if (memcg == READ_ONCE(stock->cached) && stock_pages >= nr_pages) {
-		WRITE_ONCE(stock->nr_pages, stock_pages - nr_pages);
-		ret = true;
+	for (i = 0; i < NR_MEMCG_STOCK; i++) {
+		if (memcg != READ_ONCE(stock->cached[i]))
+			continue;
+
+		stock_pages = READ_ONCE(stock->nr_pages[i]);
+		if (stock_pages >= nr_pages) {
+			WRITE_ONCE(stock->nr_pages[i], stock_pages - nr_pages);
+			ret = true;
+		}
+		break;
 	}
 
 	local_unlock_irqrestore(&memcg_stock.stock_lock, flags);
@@ -1823,26 +1887,31 @@ static bool consume_stock(struct mem_cgroup *memcg, unsigned int nr_pages,
 }
 
 /*
- * Returns stocks cached in percpu and reset cached information.
+ * Returns the stock cached in slot @i of the percpu stock and resets it.
  */
-static void drain_stock(struct memcg_stock_pcp *stock)
+static void drain_stock(struct memcg_stock_pcp *stock, int i)
 {
-	unsigned int stock_pages = READ_ONCE(stock->nr_pages);
-	struct mem_cgroup *old = READ_ONCE(stock->cached);
+	unsigned int stock_pages = READ_ONCE(stock->nr_pages[i]);
+	struct mem_cgroup *old = READ_ONCE(stock->cached[i]);
 
 	if (!old)
 		return;
 
 	if (stock_pages) {
-		page_counter_uncharge(&old->memory, stock_pages);
-		if (do_memsw_account())
-			page_counter_uncharge(&old->memsw, stock_pages);
-
-		WRITE_ONCE(stock->nr_pages, 0);
+		memcg_uncharge(old, stock_pages);
+		WRITE_ONCE(stock->nr_pages[i], 0);
 	}
 
 	css_put(&old->css);
-	WRITE_ONCE(stock->cached, NULL);
+	WRITE_ONCE(stock->cached[i], NULL);
+}
+
+static void drain_stock_fully(struct memcg_stock_pcp *stock)
+{
+	int i;
+
+	for (i = 0; i < NR_MEMCG_STOCK; i++)
+		drain_stock(stock, i);
 }
 
 static void drain_local_stock(struct work_struct *dummy)
@@ -1860,7 +1929,7 @@ static void drain_local_stock(struct work_struct *dummy)
 
 	stock = this_cpu_ptr(&memcg_stock);
 	old = drain_obj_stock(stock);
-	drain_stock(stock);
+	drain_stock_fully(stock);
 	clear_bit(FLUSHING_CACHED_CHARGE, &stock->flags);
 
 	local_unlock_irqrestore(&memcg_stock.stock_lock, flags);
@@ -1870,23 +1939,47 @@ static void drain_local_stock(struct work_struct *dummy)
 /*
  * Cache charges(val) to local per_cpu area.
  * This will be consumed by consume_stock() function, later.
+ * If all slots are taken by other memcgs, a random one is drained to make
+ * room: that needs no bookkeeping on the consume side and doesn't keep
+ * evicting the same memcg when more of them are active than fit.
  */
 static void __refill_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
 {
 	struct memcg_stock_pcp *stock;
+	struct mem_cgroup *cached;
 	unsigned int stock_pages;
+	int i, empty_slot = -1;
 
 	stock = this_cpu_ptr(&memcg_stock);
-	if (READ_ONCE(stock->cached) != memcg) { /* reset if necessary */
-		drain_stock(stock);
-		css_get(&memcg->css);
-		WRITE_ONCE(stock->cached, memcg);
+	for (i = 0; i < NR_MEMCG_STOCK; i++) {
+		cached = READ_ONCE(stock->cached[i]);
+		if (!cached && empty_slot == -1)
+			empty_slot = i;
+		if (cached != memcg)
+			continue;
+
+		stock_pages = READ_ONCE(stock->nr_pages[i]) + nr_pages;
+		if (stock_pages > MEMCG_CHARGE_BATCH) {
+			memcg_uncharge(memcg, stock_pages);
+			stock_pages = 0;
+		}
+		WRITE_ONCE(stock->nr_pages[i], stock_pages);
+		return;
 	}
-	stock_pages = READ_ONCE(stock->nr_pages) + nr_pages;
-	WRITE_ONCE(stock->nr_pages, stock_pages);
 
-	if (stock_pages > MEMCG_CHARGE_BATCH)
-		drain_stock(stock);
+	if (nr_pages > MEMCG_CHARGE_BATCH) {
+		memcg_uncharge(memcg, nr_pages);
+		return;
+	}
+
+	i = empty_slot;
+	if (i == -1) {
+		i = get_random_u32_below(NR_MEMCG_STOCK);
+		drain_stock(stock, i);
+	}
+	css_get(&memcg->css);
+	WRITE_ONCE(stock->cached[i], memcg);
+	WRITE_ONCE(stock->nr_pages[i], nr_pages);
 }
 
 static void refill_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
@@ -1900,9 +1993,7 @@ static void refill_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
 		 */
 		if (mem_cgroup_is_root(memcg))
 			return;
-		page_counter_uncharge(&memcg->memory, nr_pages);
-		if (do_memsw_account())
-			page_counter_uncharge(&memcg->memsw, nr_pages);
+		memcg_uncharge(memcg, nr_pages);
 		return;
 	}
 	__refill_stock(memcg, nr_pages);
@@ -1932,13 +2023,18 @@ void drain_all_stock(struct mem_cgroup *root_memcg)
 		struct memcg_stock_pcp *stock = &per_cpu(memcg_stock, cpu);
 		struct mem_cgroup *memcg;
 		bool flush = false;
+		int i;
 
 		rcu_read_lock();
-		memcg = READ_ONCE(stock->cached);
-		if (memcg && READ_ONCE(stock->nr_pages) &&
-		    mem_cgroup_is_descendant(memcg, root_memcg))
-			flush = true;
-		else if (obj_stock_flush_required(stock, root_memcg))
+		for (i = 0; i < NR_MEMCG_STOCK; i++) {
+			memcg = READ_ONCE(stock->cached[i]);
+			if (memcg && READ_ONCE(stock->nr_pages[i]) &&
+			    mem_cgroup_is_descendant(memcg, root_memcg)) {
+				flush = true;
+				break;
+			}
+		}
+		if (!flush && obj_stock_flush_required(stock, root_memcg))
 			flush = true;
 		rcu_read_unlock();
 
@@ -1967,7 +2063,7 @@ static int memcg_hotplug_cpu_dead(unsigned int cpu)
 	old = drain_obj_stock(stock);
 	local_unlock_irqrestore(&memcg_stock.stock_lock, flags);
 
-	drain_stock(stock);
+	drain_stock_fully(stock);
 	obj_cgroup_put(old);
 
 	return 0;
@@ -1992,7 +2088,7 @@ static unsigned long reclaim_high(struct mem_cgroup *memcg,
 		nr_reclaimed += try_to_free_mem_cgroup_pages(memcg, nr_pages,
 							gfp_mask,
 							MEMCG_RECLAIM_MAY_SWAP,
-							NULL);
+							NULL, 0);
 		psi_memstall_leave(&pflags);
 	} while ((memcg = parent_mem_cgroup(memcg)) &&
 		 !mem_cgroup_is_root(memcg));
@@ -2302,7 +2398,7 @@ static int try_charge_memcg(struct mem_cgroup *memcg, gfp_t gfp_mask,
 
 	psi_memstall_enter(&pflags);
 	nr_reclaimed = try_to_free_mem_cgroup_pages(mem_over_limit, nr_pages,
-						    gfp_mask, reclaim_options, NULL);
+						    gfp_mask, reclaim_options, NULL, 0);
 	psi_memstall_leave(&pflags);
 
 	if (mem_cgroup_margin(mem_over_limit) >= nr_pages)
@@ -4213,7 +4309,7 @@ static ssize_t memory_high_write(struct kernfs_open_file *of,
 		}
 
 		reclaimed = try_to_free_mem_cgroup_pages(memcg, nr_pages - high,
-					GFP_KERNEL, MEMCG_RECLAIM_MAY_SWAP, NULL);
+					GFP_KERNEL, MEMCG_RECLAIM_MAY_SWAP, NULL, 0);
 
 		if (!reclaimed && !nr_retries--)
 			break;
@@ -4262,7 +4358,7 @@ static ssize_t memory_max_write(struct kernfs_open_file *of,
 
 		if (nr_reclaims) {
 			if (!try_to_free_mem_cgroup_pages(memcg, nr_pages - max,
-					GFP_KERNEL, MEMCG_RECLAIM_MAY_SWAP, NULL))
+					GFP_KERNEL, MEMCG_RECLAIM_MAY_SWAP, NULL, 0))
 				nr_reclaims--;
 			continue;
 		}
@@ -4337,7 +4433,7 @@ static int memory_numa_stat_show(struct seq_file *m, void *v)
 	int i;
 	struct mem_cgroup *memcg = mem_cgroup_from_seq(m);
 
-	mem_cgroup_flush_stats(memcg);
+	mem_cgroup_flush_stats_user(memcg);
 
 	for (i = 0; i < ARRAY_SIZE(memory_stats); i++) {
 		int nid;
@@ -4362,6 +4458,15 @@ static int memory_numa_stat_show(struct seq_file *m, void *v)
 }
 #endif
 
+#ifdef CONFIG_LRU_GEN
+static int memory_lru_gen_show(struct seq_file *m, void *v)
+{
+	lru_gen_memcg_show(m, mem_cgroup_from_seq(m));
+
+	return 0;
+}
+#endif
+
 static int memory_oom_group_show(struct seq_file *m, void *v)
 {
 	struct mem_cgroup *memcg = mem_cgroup_from_seq(m);
@@ -4395,11 +4500,13 @@ static ssize_t memory_oom_group_write(struct kernfs_open_file *of,
 
 enum {
 	MEMORY_RECLAIM_SWAPPINESS = 0,
+	MEMORY_RECLAIM_OLDER_THAN,
 	MEMORY_RECLAIM_NULL,
 };
 
 static const match_table_t tokens = {
 	{ MEMORY_RECLAIM_SWAPPINESS, "swappiness=%d"},
+	{ MEMORY_RECLAIM_OLDER_THAN, "older_than=%u"},
 	{ MEMORY_RECLAIM_NULL, NULL },
 };
 
@@ -4410,6 +4517,8 @@ static ssize_t memory_reclaim(struct kernfs_open_file *of, char *buf,
 	unsigned int nr_retries = MAX_RECLAIM_RETRIES;
 	unsigned long nr_to_reclaim, nr_reclaimed = 0;
 	int swappiness = -1;
+	unsigned long min_age = 0;
+	unsigned int older_than;
 	unsigned int reclaim_options;
 	char *old_buf, *start;
 	substring_t args[MAX_OPT_ARGS];
@@ -4433,6 +4542,15 @@ static ssize_t memory_reclaim(struct kernfs_open_file *of, char *buf,
 			if (swappiness < MIN_SWAPPINESS || swappiness > MAX_SWAPPINESS)
 				return -EINVAL;
 			break;
+		case MEMORY_RECLAIM_OLDER_THAN:
+			/* only the multi-gen LRU knows the age of its pages */
+			if (!lru_gen_enabled())
+				return -EINVAL;
+			if (match_uint(&args[0], &older_than) || !older_than ||
+			    older_than > MAX_JIFFY_OFFSET / HZ)
+				return -EINVAL;
+			min_age = (unsigned long)older_than * HZ;
+			break;
 		default:
 			return -EINVAL;
 		}
@@ -4458,7 +4576,8 @@ static ssize_t memory_reclaim(struct kernfs_open_file *of, char *buf,
 		reclaimed = try_to_free_mem_cgroup_pages(memcg,
 					batch_size, GFP_KERNEL,
 					reclaim_options,
-					swappiness == -1 ? NULL : &swappiness);
+					swappiness == -1 ? NULL : &swappiness,
+					min_age);
 
 		if (!reclaimed && !nr_retries--)
 			return -EAGAIN;
@@ -4528,6 +4647,12 @@ static struct cftype memory_files[] = {
 		.name = "numa_stat",
 		.seq_show = memory_numa_stat_show,
 	},
+#endif
+#ifdef CONFIG_LRU_GEN
+	{
+		.name = "lru_gen",
+		.seq_show = memory_lru_gen_show,
+	},
 #endif
 	{
 		.name = "oom.group",
@@ -4974,6 +5099,16 @@ static int __init cgroup_memory(char *s)
 }
 __setup("cgroup.memory=", cgroup_memory);
 
+static const struct ctl_table memcg_sysctl_table[] = {
+	{
+		.procname	= "memcg_stats_max_age_ms",
+		.data		= &sysctl_memcg_stats_max_age_ms,
+		.maxlen		= sizeof(sysctl_memcg_stats_max_age_ms),
+		.mode		= 0644,
+		.proc_handler	= proc_douintvec,
+	}
+};
+
 /*
  * subsys_initcall() for memory controller.
  *
@@ -4993,6 +5128,8 @@ static int __init mem_cgroup_init(void)
 	 * exceed S32_MAX / PAGE_SIZE.
 	 */
 	BUILD_BUG_ON(MEMCG_CHARGE_BATCH > S32_MAX / PAGE_SIZE);
+	/* The stock counts are stored in a byte */
+	BUILD_BUG_ON(MEMCG_CHARGE_BATCH > U8_MAX);
 
 	cpuhp_setup_state_nocalls(CPUHP_MM_MEMCQ_DEAD, "mm/memctrl:dead", NULL,
 				  memcg_hotplug_cpu_dead);
@@ -5001,6 +5138,8 @@ static int __init mem_cgroup_init(void)
 		INIT_WORK(&per_cpu_ptr(&memcg_stock, cpu)->work,
 			  drain_local_stock);
 
+	register_sysctl_init("vm", memcg_sysctl_table);
+
 	return 0;
 }
 subsys_initcall(mem_cgroup_init);
@@ -53,6 +53,7 @@
 #include <linux/memremap.h>
 #include <linux/kmsan.h>
 #include <linux/ksm.h>
+#include <linux/khugepaged.h>
 #include <linux/rmap.h>
 #include <linux/export.h>
 #include <linux/delayacct.h>
@@ -1340,6 +1341,14 @@ vma_needs_copy(struct vm_area_struct *dst_vma, struct vm_area_struct *src_vma)
 	if (src_vma->vm_flags & (VM_PFNMAP | VM_MIXEDMAP))
 		return true;
 
+	/*
+	 * Private anonymous memory has no other source to refault from, so
+	 * its page tables are always copied.  Sharing PTE tables between
+	 * parent and child and unsharing them on the first write fault
+	 * would make fork() O(PMDs), but every page table walker that may
+	 * modify PTEs (zap, mprotect, madvise, reclaim through rmap, ...)
+	 * would then have to unshare first; none of them know how to yet.
+	 */
 	if (src_vma->anon_vma)
 		return true;
 
@@ -6111,6 +6120,8 @@ static vm_fault_t __handle_mm_fault(struct vm_area_struct *vma,
 		ret = create_huge_pmd(&vmf);
 		if (!(ret & VM_FAULT_FALLBACK))
 			return ret;
+		/* let khugepaged retry with its own allocation policy */
+		khugepaged_hint(vma, address);
 	} else {
 		vmf.orig_pmd = pmdp_get_lockless(vmf.pmd);
 
@@ -801,8 +801,8 @@ void move_pfn_range_to_zone(struct zone *zone, unsigned long start_pfn,
 	 * expects the zone spans the pfn range. All the pages in the range
 	 * are reserved so nobody should be touching them so we should be safe
 	 */
-	memmap_init_range(nr_pages, nid, zone_idx(zone), start_pfn, 0,
-			 MEMINIT_HOTPLUG, altmap, migratetype);
+	memmap_init_hotplug_range(nr_pages, nid, zone_idx(zone), start_pfn,
+				  altmap, migratetype);
 
 	set_zone_contiguous(zone);
 }
@@ -716,6 +716,161 @@ unsigned long change_prot_numa(struct vm_area_struct *vma,
 
 	return nr_updated;
 }
+
+#define NUMA_ACCESS_BATCH	16
+
+struct numa_access_sample {
+	int last_cpupid;
+	int nid;
+	int nr_pages;
+	int flags;
+};
+
+struct numa_access_scan {
+	unsigned long nr_sampled;
+	unsigned int nr;
+	struct numa_access_sample samples[NUMA_ACCESS_BATCH];
+};
+
+/*
+ * Record a sampled access to @folio the same way do_numa_page() would for
+ * a hinting fault, except that the folio is never migrated: the sample
+ * only feeds task placement.  Called with the PTL held.
+ */
+static void numa_access_record(struct numa_access_scan *scan,
+			       struct vm_area_struct *vma,
+			       struct folio *folio, int nr_pages)
+{
+	struct numa_access_sample *sample = &scan->samples[scan->nr++];
+	int nid = folio_nid(folio);
+
+	sample->nid = nid;
+	sample->nr_pages = nr_pages;
+	sample->flags = 0;
+
+	if (!(vma->vm_flags & VM_WRITE))
+		sample->flags |= TNF_NO_GROUP;
+	if (folio_maybe_mapped_shared(folio) && (vma->vm_flags & VM_SHARED))
+		sample->flags |= TNF_SHARED;
+	if (nid == numa_node_id())
+		sample->flags |= TNF_FAULT_LOCAL;
+
+	/*
+	 * For memory tiering mode, cpupid of slow memory folios records the
+	 * access time; leave it alone.
+	 */
+	if (folio_use_access_time(folio))
+		sample->last_cpupid = (-1 & LAST_CPUPID_MASK);
+	else
+		sample->last_cpupid = folio_xchg_last_cpupid(folio,
+				cpu_pid_to_cpupid(raw_smp_processor_id(),
+						  current->pid));
+	scan->nr_sampled += nr_pages;
+}
+
+/* task_numa_fault() may allocate and take locks, so it is called here. */
+static void numa_access_flush(struct numa_access_scan *scan)
+{
+	unsigned int i;
+
+	for (i = 0; i < scan->nr; i++) {
+		struct numa_access_sample *sample = &scan->samples[i];
+
+		task_numa_fault(sample->last_cpupid, sample->nid,
+				sample->nr_pages, sample->flags);
+	}
+	scan->nr = 0;
+}
+
+static struct folio *numa_access_folio(struct vm_area_struct *vma,
+				       unsigned long addr, pte_t ptent)
+{
+	struct folio *folio = vm_normal_folio(vma, addr, ptent);
+
+	if (!folio || folio_is_zone_device(folio) || folio_test_ksm(folio))
+		return NULL;
+	return folio;
+}
+
+static int numa_access_pte_range(pmd_t *pmd, unsigned long addr,
+				 unsigned long end, struct mm_walk *walk)
+{
+	struct numa_access_scan *scan = walk->private;
+	struct vm_area_struct *vma = walk->vma;
+	struct folio *folio;
+	pte_t *pte, *mapped_pte;
+	spinlock_t *ptl;
+
+	ptl = pmd_trans_huge_lock(pmd, vma);
+	if (ptl) {
+		pmd_t pmdval = pmdp_get(pmd);
+
+		if (pmd_present(pmdval) && pmd_young(pmdval)) {
+			folio = pmd_folio(pmdval);
+			if (!is_huge_zero_folio(folio) &&
+			    pmdp_test_and_clear_young(vma, addr, pmd))
+				numa_access_record(scan, vma, folio,
+						   folio_nr_pages(folio));
+		}
+		spin_unlock(ptl);
+		numa_access_flush(scan);
+		return 0;
+	}
+
+again:
+	mapped_pte = pte = pte_offset_map_lock(walk->mm, pmd, addr, &ptl);
+	if (!pte) {
+		walk->action = ACTION_AGAIN;
+		return 0;
+	}
+	for (; addr != end; pte++, addr += PAGE_SIZE) {
+		pte_t ptent = ptep_get(pte);
+
+		if (!pte_present(ptent) || !pte_young(ptent))
+			continue;
+		folio = numa_access_folio(vma, addr, ptent);
+		if (!folio)
+			continue;
+		if (!ptep_test_and_clear_young(vma, addr, pte))
+			continue;
+		numa_access_record(scan, vma, folio, 1);
+		if (scan->nr == NUMA_ACCESS_BATCH) {
+			addr += PAGE_SIZE;
+			break;
+		}
+	}
+	pte_unmap_unlock(mapped_pte, ptl);
+	numa_access_flush(scan);
+	if (addr != end) {
+		cond_resched();
+		goto again;
+	}
+	return 0;
+}
+
+static const struct mm_walk_ops numa_access_walk_ops = {
+	.pmd_entry		= numa_access_pte_range,
+	.walk_lock		= PGWALK_RDLOCK,
+};
+
+/*
+ * Alternative to change_prot_numa() selected with PR_SET_NUMA_SCAN_MODE:
+ * instead of making the range inaccessible and waiting for hinting faults,
+ * harvest and clear the accessed bits that the MMU already maintains and
+ * report every young mapping as a sampled access by the scanning task.
+ * Nothing is migrated and no fault is taken, so the cost is a page table
+ * walk; the price is that accesses from other threads of the process are
+ * attributed to the scanning task.
+ */
+unsigned long numa_scan_accessed(struct vm_area_struct *vma,
+			unsigned long addr, unsigned long end)
+{
+	struct numa_access_scan scan = { };
+
+	walk_page_range_vma(vma, addr, end, &numa_access_walk_ops, &scan);
+
+	return scan.nr_sampled;
+}
 #endif /* CONFIG_NUMA_BALANCING */
 
 static int queue_pages_test_walk(unsigned long start, unsigned long end,
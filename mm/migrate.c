@@ -747,7 +747,7 @@ EXPORT_SYMBOL(folio_migrate_flags);
 
 static int __migrate_folio(struct address_space *mapping, struct folio *dst,
 			   struct folio *src, void *src_private,
-			   enum migrate_mode mode)
+			   enum migrate_mode mode, bool copied)
 {
 	int rc, expected_count = folio_expected_refs(mapping, src);
 
@@ -755,9 +755,11 @@ static int __migrate_folio(struct address_space *mapping, struct folio *dst,
 	if (folio_ref_count(src) != expected_count)
 		return -EAGAIN;
 
-	rc = folio_mc_copy(dst, src);
-	if (unlikely(rc))
-		return rc;
+	if (!copied) {
+		rc = folio_mc_copy(dst, src);
+		if (unlikely(rc))
+			return rc;
+	}
 
 	rc = __folio_migrate_mapping(mapping, dst, src, expected_count);
 	if (rc != MIGRATEPAGE_SUCCESS)
@@ -786,7 +788,7 @@ int migrate_folio(struct address_space *mapping, struct folio *dst,
 		  struct folio *src, enum migrate_mode mode)
 {
 	BUG_ON(folio_test_writeback(src));	/* Writeback must be complete */
-	return __migrate_folio(mapping, dst, src, NULL, mode);
+	return __migrate_folio(mapping, dst, src, NULL, mode, false);
 }
 EXPORT_SYMBOL(migrate_folio);
 
@@ -940,7 +942,8 @@ EXPORT_SYMBOL_GPL(buffer_migrate_folio_norefs);
 int filemap_migrate_folio(struct address_space *mapping,
 		struct folio *dst, struct folio *src, enum migrate_mode mode)
 {
-	return __migrate_folio(mapping, dst, src, folio_get_private(src), mode);
+	return __migrate_folio(mapping, dst, src, folio_get_private(src), mode,
+			       false);
 }
 EXPORT_SYMBOL_GPL(filemap_migrate_folio);
 
@@ -1024,7 +1027,7 @@ static int fallback_migrate_folio(struct address_space *mapping,
  *  MIGRATEPAGE_SUCCESS - success
  */
 static int move_to_new_folio(struct folio *dst, struct folio *src,
-				enum migrate_mode mode)
+				enum migrate_mode mode, bool copied)
 {
 	int rc = -EAGAIN;
 	bool is_lru = !__folio_test_movable(src);
@@ -1035,7 +1038,10 @@ static int move_to_new_folio(struct folio *dst, struct folio *src,
 	if (likely(is_lru)) {
 		struct address_space *mapping = folio_mapping(src);
 
-		if (!mapping)
+		if (copied)
+			/* Only for folios migrate_folio() handles, see below */
+			rc = __migrate_folio(mapping, dst, src, NULL, mode, true);
+		else if (!mapping)
 			rc = migrate_folio(mapping, dst, src, mode);
 		else if (mapping_inaccessible(mapping))
 			rc = -EOPNOTSUPP;
@@ -1343,7 +1349,7 @@ static int migrate_folio_unmap(new_folio_t get_new_folio,
 static int migrate_folio_move(free_folio_t put_new_folio, unsigned long private,
 			      struct folio *src, struct folio *dst,
 			      enum migrate_mode mode, enum migrate_reason reason,
-			      struct list_head *ret)
+			      struct list_head *ret, bool copied)
 {
 	int rc;
 	int old_page_state = 0;
@@ -1355,7 +1361,7 @@ static int migrate_folio_move(free_folio_t put_new_folio, unsigned long private,
 	prev = dst->lru.prev;
 	list_del(&dst->lru);
 
-	rc = move_to_new_folio(dst, src, mode);
+	rc = move_to_new_folio(dst, src, mode, copied);
 	if (rc)
 		goto out;
 
@@ -1510,7 +1516,7 @@ static int unmap_and_move_huge_page(new_folio_t get_new_folio,
 	}
 
 	if (!folio_mapped(src))
-		rc = move_to_new_folio(dst, src, mode);
+		rc = move_to_new_folio(dst, src, mode, false);
 
 	if (page_was_mapped)
 		remove_migration_ptes(src,
@@ -1692,7 +1698,7 @@ static void migrate_folios_move(struct list_head *src_folios,
 		struct list_head *ret_folios,
 		struct migrate_pages_stats *stats,
 		int *retry, int *thp_retry, int *nr_failed,
-		int *nr_retry_pages)
+		int *nr_retry_pages, bool copied)
 {
 	struct folio *folio, *folio2, *dst, *dst2;
 	bool is_thp;
@@ -1709,7 +1715,7 @@ static void migrate_folios_move(struct list_head *src_folios,
 
 		rc = migrate_folio_move(put_new_folio, private,
 				folio, dst, mode,
-				reason, ret_folios);
+				reason, ret_folios, copied);
 		/*
 		 * The rules are:
 		 *	Success: folio will be freed
@@ -1737,6 +1743,163 @@ static void migrate_folios_move(struct list_head *src_folios,
 	}
 }
 
+/*
+ * Large folios can be copied by several threads before they are moved, when
+ * a batch has enough of them: a single CPU copying e.g. from slow memory to
+ * DRAM during promotion doesn't come close to the available bandwidth.
+ * vm.migrate_copy_threads is the number of threads, 1 disables it.
+ */
+static unsigned int sysctl_migrate_copy_threads = 1;
+static unsigned int migrate_copy_threads_max = 32;
+/* Don't bother with less than this many pages per thread */
+#define MIGRATE_COPY_MIN_PAGES		512
+
+struct migrate_copy_job {
+	struct work_struct work;
+	struct list_head *src_folios;
+	struct list_head *dst_folios;
+	/* Range of pages to copy, counting through the whole batch */
+	unsigned long start;
+	unsigned long end;
+	int err;
+};
+
+static void migrate_copy_fn(struct work_struct *work)
+{
+	struct migrate_copy_job *job =
+		container_of(work, struct migrate_copy_job, work);
+	struct folio *src, *dst;
+	unsigned long base = 0, i, nr;
+
+	dst = list_first_entry(job->dst_folios, struct folio, lru);
+	list_for_each_entry(src, job->src_folios, lru) {
+		nr = folio_nr_pages(src);
+		for (i = max(job->start, base) - base;
+		     i < nr && base + i < job->end; i++) {
+			if (copy_mc_highpage(folio_page(dst, i),
+					     folio_page(src, i))) {
+				job->err = -EHWPOISON;
+				return;
+			}
+			cond_resched();
+		}
+		base += nr;
+		if (base >= job->end)
+			break;
+		dst = list_next_entry(dst, lru);
+	}
+}
+
+/*
+ * The folios that would be copied by __migrate_folio() anyway, as opposed to
+ * a filesystem's own ->migrate_folio() or movable_operations. A folio with
+ * unexpected references, e.g. a pin someone may still write through, is left
+ * to the usual copy after the refcount check.
+ */
+static bool migrate_folio_can_precopy(struct folio *src)
+{
+	struct address_space *mapping;
+
+	if (!folio_test_large(src) || __folio_test_movable(src))
+		return false;
+	mapping = folio_mapping(src);
+	if (mapping && mapping->a_ops->migrate_folio != migrate_folio)
+		return false;
+	return folio_ref_count(src) == folio_expected_refs(mapping, src);
+}
+
+/*
+ * Copy the large folios of the unmapped batch with multiple threads, and
+ * move them with their destinations to @copied_src and @copied_dst. The
+ * sources are unmapped and locked, and had no unexpected references, so
+ * the copies stay valid for the first attempt to move them; a folio that
+ * has to be retried is copied again. If anything fails, nothing is moved
+ * and the folios are copied one by one as usual.
+ */
+static void migrate_folios_precopy(struct list_head *src_folios,
+		struct list_head *dst_folios, struct list_head *copied_src,
+		struct list_head *copied_dst)
+{
+	unsigned int threads = READ_ONCE(sysctl_migrate_copy_threads);
+	struct folio *folio, *folio2, *dst, *dst2;
+	struct migrate_copy_job *jobs;
+	unsigned long nr_pages = 0;
+	unsigned int i, nr_jobs;
+	int err = 0;
+
+	if (threads <= 1)
+		return;
+
+	list_for_each_entry(folio, src_folios, lru)
+		if (migrate_folio_can_precopy(folio))
+			nr_pages += folio_nr_pages(folio);
+
+	nr_jobs = min_t(unsigned long, threads,
+			nr_pages / MIGRATE_COPY_MIN_PAGES);
+	if (nr_jobs <= 1)
+		return;
+
+	jobs = kcalloc(nr_jobs, sizeof(*jobs), GFP_NOWAIT | __GFP_NOWARN);
+	if (!jobs)
+		return;
+
+	dst = list_first_entry(dst_folios, struct folio, lru);
+	dst2 = list_next_entry(dst, lru);
+	list_for_each_entry_safe(folio, folio2, src_folios, lru) {
+		if (migrate_folio_can_precopy(folio)) {
+			list_move_tail(&folio->lru, copied_src);
+			list_move_tail(&dst->lru, copied_dst);
+		}
+		dst = dst2;
+		dst2 = list_next_entry(dst, lru);
+	}
+
+	for (i = 0; i < nr_jobs; i++) {
+		jobs[i].src_folios = copied_src;
+		jobs[i].dst_folios = copied_dst;
+		jobs[i].start = nr_pages * i / nr_jobs;
+		jobs[i].end = nr_pages * (i + 1) / nr_jobs;
+		INIT_WORK(&jobs[i].work, migrate_copy_fn);
+		if (i)
+			queue_work(system_unbound_wq, &jobs[i].work);
+	}
+
+	/* Do the first share here while the others run */
+	migrate_copy_fn(&jobs[0].work);
+	for (i = 0; i < nr_jobs; i++) {
+		if (i)
+			flush_work(&jobs[i].work);
+		if (jobs[i].err)
+			err = jobs[i].err;
+	}
+	kfree(jobs);
+
+	if (err) {
+		/* Let the normal path deal with the poisoned page */
+		list_splice_init(copied_src, src_folios);
+		list_splice_init(copied_dst, dst_folios);
+	}
+}
+
+static const struct ctl_table migrate_sysctl_table[] = {
+	{
+		.procname	= "migrate_copy_threads",
+		.data		= &sysctl_migrate_copy_threads,
+		.maxlen		= sizeof(sysctl_migrate_copy_threads),
+		.mode		= 0644,
+		.proc_handler	= proc_douintvec_minmax,
+		.extra1		= SYSCTL_ONE,
+		.extra2		= &migrate_copy_threads_max,
+	},
+};
+
+static int __init migrate_sysctl_init(void)
+{
+	register_sysctl_init("vm", migrate_sysctl_table);
+	return 0;
+}
+late_initcall(migrate_sysctl_init);
+
 static void migrate_folios_undo(struct list_head *src_folios,
 		struct list_head *dst_folios,
 		free_folio_t put_new_folio, unsigned long private,
@@ -1786,6 +1949,8 @@ static int migrate_pages_batch(struct list_head *from,
 	int rc, rc_saved = 0, nr_pages;
 	LIST_HEAD(unmap_folios);
 	LIST_HEAD(dst_folios);
+	LIST_HEAD(copied_folios);
+	LIST_HEAD(copied_dst_folios);
 	bool nosplit = (reason == MR_NUMA_MISPLACED);
 
 	VM_WARN_ON_ONCE(mode != MIGRATE_ASYNC &&
@@ -1947,6 +2112,9 @@ static int migrate_pages_batch(struct list_head *from,
 	/* Flush TLBs for all unmapped folios */
 	try_to_unmap_flush();
 
+	migrate_folios_precopy(&unmap_folios, &dst_folios, &copied_folios,
+			       &copied_dst_folios);
+
 	retry = 1;
 	for (pass = 0; pass < nr_pass && retry; pass++) {
 		retry = 0;
@@ -1954,10 +2122,21 @@ static int migrate_pages_batch(struct list_head *from,
 		nr_retry_pages = 0;
 
 		/* Move the unmapped folios */
+		migrate_folios_move(&copied_folios, &copied_dst_folios,
+				put_new_folio, private, mode, reason,
+				ret_folios, stats, &retry, &thp_retry,
+				&nr_failed, &nr_retry_pages, true);
 		migrate_folios_move(&unmap_folios, &dst_folios,
 				put_new_folio, private, mode, reason,
 				ret_folios, stats, &retry, &thp_retry,
-				&nr_failed, &nr_retry_pages);
+				&nr_failed, &nr_retry_pages, false);
+
+		/*
+		 * A precopied folio that failed the refcount check or the
+		 * freeze may have been written to since: copy it again.
+		 */
+		list_splice_tail_init(&copied_folios, &unmap_folios);
+		list_splice_tail_init(&copied_dst_folios, &dst_folios);
 	}
 	nr_failed += retry;
 	stats->nr_thp_failed += thp_retry;
@@ -939,6 +939,78 @@ void __meminit memmap_init_range(unsigned long size, int nid, unsigned long zone
 	}
 }
 
+/*
+ * Memory and device nodes without CPUs, as CXL memory usually is, have their
+ * memmap initialized by whichever CPUs are online.
+ */
+static int __meminit memmap_init_max_threads(int nid)
+{
+	const struct cpumask *cpumask = cpumask_of_node(nid);
+
+	if (cpumask_empty(cpumask))
+		cpumask = cpu_online_mask;
+	return max(cpumask_weight(cpumask), 1U);
+}
+
+struct memmap_init_hotplug_arg {
+	int nid;
+	unsigned long zone;
+	struct vmem_altmap *altmap;
+	int migratetype;
+};
+
+static void __meminit memmap_init_hotplug_chunk(unsigned long start_pfn,
+						unsigned long end_pfn,
+						void *arg)
+{
+	struct memmap_init_hotplug_arg *args = arg;
+
+	memmap_init_range(end_pfn - start_pfn, args->nid, args->zone,
+			  start_pfn, 0, MEMINIT_HOTPLUG, args->altmap,
+			  args->migratetype);
+}
+
+/*
+ * memmap_init_range() for memory being hotplugged, split in pageblock-aligned
+ * chunks over several threads when the range is large.
+ */
+void __meminit memmap_init_hotplug_range(unsigned long size, int nid,
+		unsigned long zone, unsigned long start_pfn,
+		struct vmem_altmap *altmap, int migratetype)
+{
+	struct memmap_init_hotplug_arg args = {
+		.nid		= nid,
+		.zone		= zone,
+		.altmap		= altmap,
+		.migratetype	= migratetype,
+	};
+	struct padata_mt_job job = {
+		.thread_fn   = memmap_init_hotplug_chunk,
+		.fn_arg      = &args,
+		.start       = start_pfn,
+		.size        = size,
+		.align       = pageblock_nr_pages,
+		.min_chunk   = PAGES_PER_SECTION,
+		.max_threads = memmap_init_max_threads(nid),
+		.numa_aware  = false,
+	};
+
+#ifdef CONFIG_ZONE_DEVICE
+	/* only the pages of the altmap are initialized here */
+	if (zone == ZONE_DEVICE) {
+		memmap_init_range(size, nid, zone, start_pfn, 0,
+				  MEMINIT_HOTPLUG, altmap, migratetype);
+		return;
+	}
+#endif
+
+	/* the chunks then leave highest_memmap_pfn alone */
+	if (highest_memmap_pfn < start_pfn + size - 1)
+		highest_memmap_pfn = start_pfn + size - 1;
+
+	padata_do_multithreaded(&job);
+}
+
 static void __init memmap_init_zone_range(struct zone *zone,
 					  unsigned long start_pfn,
 					  unsigned long end_pfn,
@@ -1106,18 +1178,60 @@ static void __ref memmap_init_compound(struct page *head,
 	}
 }
 
+struct memmap_init_device_arg {
+	int nid;
+	struct dev_pagemap *pgmap;
+	struct vmem_altmap *altmap;
+};
+
+static void __ref memmap_init_device_chunk(unsigned long start_pfn,
+					   unsigned long end_pfn, void *arg)
+{
+	struct memmap_init_device_arg *args = arg;
+	struct dev_pagemap *pgmap = args->pgmap;
+	unsigned int pfns_per_compound = pgmap_vmemmap_nr(pgmap);
+	unsigned long pfn;
+
+	for (pfn = start_pfn; pfn < end_pfn; pfn += pfns_per_compound) {
+		struct page *page = pfn_to_page(pfn);
+
+		__init_zone_device_page(page, pfn, ZONE_DEVICE, args->nid,
+					pgmap);
+
+		if (pfns_per_compound == 1)
+			continue;
+
+		memmap_init_compound(page, pfn, ZONE_DEVICE, args->nid, pgmap,
+				     compound_nr_pages(args->altmap, pgmap));
+	}
+}
+
 void __ref memmap_init_zone_device(struct zone *zone,
 				   unsigned long start_pfn,
 				   unsigned long nr_pages,
 				   struct dev_pagemap *pgmap)
 {
-	unsigned long pfn, end_pfn = start_pfn + nr_pages;
+	unsigned long end_pfn = start_pfn + nr_pages;
 	struct pglist_data *pgdat = zone->zone_pgdat;
 	struct vmem_altmap *altmap = pgmap_altmap(pgmap);
 	unsigned int pfns_per_compound = pgmap_vmemmap_nr(pgmap);
 	unsigned long zone_idx = zone_idx(zone);
 	unsigned long start = jiffies;
 	int nid = pgdat->node_id;
+	struct memmap_init_device_arg args = {
+		.nid	= nid,
+		.pgmap	= pgmap,
+		.altmap	= altmap,
+	};
+	struct padata_mt_job job = {
+		.thread_fn   = memmap_init_device_chunk,
+		.fn_arg      = &args,
+		.align       = max_t(unsigned long, pfns_per_compound,
+				     PAGES_PER_SECTION),
+		.min_chunk   = PAGES_PER_SECTION,
+		.max_threads = memmap_init_max_threads(nid),
+		.numa_aware  = false,
+	};
 
 	if (WARN_ON_ONCE(!pgmap || zone_idx != ZONE_DEVICE))
 		return;
@@ -1132,16 +1246,13 @@ void __ref memmap_init_zone_device(struct zone *zone,
 		nr_pages = end_pfn - start_pfn;
 	}
 
-	for (pfn = start_pfn; pfn < end_pfn; pfn += pfns_per_compound) {
-		struct page *page = pfn_to_page(pfn);
-
-		__init_zone_device_page(page, pfn, zone_idx, nid, pgmap);
-
-		if (pfns_per_compound == 1)
-			continue;
-
-		memmap_init_compound(page, pfn, zone_idx, nid, pgmap,
-				     compound_nr_pages(altmap, pgmap));
+	/* chunks must not split compound pages */
+	if (IS_ALIGNED(start_pfn, pfns_per_compound)) {
+		job.start = start_pfn;
+		job.size = nr_pages;
+		padata_do_multithreaded(&job);
+	} else {
+		memmap_init_device_chunk(start_pfn, end_pfn, &args);
 	}
 
 	pr_debug("%s initialised %lu pages in %ums\n", __func__,
@@ -890,6 +890,23 @@ static bool vrm_implies_new_addr(struct vma_remap_struct *vrm)
 	return vrm->flags & (MREMAP_FIXED | MREMAP_DONTUNMAP);
 }
 
+/*
+ * Only private anonymous mappings large enough to contain a PMD are worth
+ * aligning: file and shared mappings have their own placement constraints.
+ */
+static bool vrm_should_align(struct vma_remap_struct *vrm)
+{
+	struct vm_area_struct *vma = vrm->vma;
+
+	if (vma->vm_file || (vma->vm_flags & VM_MAYSHARE))
+		return false;
+	if (is_vm_hugetlb_page(vma))
+		return false;
+	if (!arch_supports_page_table_move())
+		return false;
+	return vrm->new_len >= PMD_SIZE;
+}
+
 /*
  * Find an unmapped area for the requested vrm->new_addr.
  *
@@ -915,6 +932,22 @@ static unsigned long vrm_set_new_addr(struct vma_remap_struct *vrm)
 	if (vma->vm_flags & VM_MAYSHARE)
 		map_flags |= MAP_SHARED;
 
+	if (!new_addr && vrm_should_align(vrm)) {
+		/*
+		 * Place the destination at the same offset within a PMD as
+		 * the source, so that move_page_tables() can move whole PTE
+		 * tables for everything but the unaligned head and tail
+		 * instead of moving each PTE.  Searching for an extra PMD
+		 * worth of space guarantees such an address fits.
+		 */
+		res = get_unmapped_area(NULL, 0, vrm->new_len + PMD_SIZE, 0,
+					map_flags);
+		if (!IS_ERR_VALUE(res)) {
+			vrm->new_addr = res + ((vrm->addr - res) & ~PMD_MASK);
+			return 0;
+		}
+	}
+
 	res = get_unmapped_area(vma->vm_file, new_addr, vrm->new_len, pgoff,
 				map_flags);
 	if (IS_ERR_VALUE(res))
@@ -510,17 +510,25 @@ static void bad_page(struct page *page, const char *reason)
 	add_taint(TAINT_BAD_PAGE, LOCKDEP_NOW_UNRELIABLE);
 }
 
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+/* mTHP orders cached on the PCP lists, see vm.percpu_pagelist_mthp_orders */
+static unsigned int pcp_mthp_orders __read_mostly;
+#endif
+
 static inline unsigned int order_to_pindex(int migratetype, int order)
 {
 
 #ifdef CONFIG_TRANSPARENT_HUGEPAGE
 	bool movable;
 	if (order > PAGE_ALLOC_COSTLY_ORDER) {
-		VM_BUG_ON(order != HPAGE_PMD_ORDER);
-
 		movable = migratetype == MIGRATE_MOVABLE;
 
-		return NR_LOWORDER_PCP_LISTS + movable;
+		if (order == HPAGE_PMD_ORDER)
+			return NR_LOWORDER_PCP_LISTS + NR_PCP_MTHP + movable;
+
+		VM_BUG_ON(order > PCP_MTHP_MAX_ORDER);
+		return NR_LOWORDER_PCP_LISTS +
+			2 * (order - PAGE_ALLOC_COSTLY_ORDER - 1) + movable;
 	}
 #else
 	VM_BUG_ON(order > PAGE_ALLOC_COSTLY_ORDER);
@@ -534,8 +542,11 @@ static inline int pindex_to_order(unsigned int pindex)
 	int order = pindex / MIGRATE_PCPTYPES;
 
 #ifdef CONFIG_TRANSPARENT_HUGEPAGE
-	if (pindex >= NR_LOWORDER_PCP_LISTS)
+	if (pindex >= NR_LOWORDER_PCP_LISTS + NR_PCP_MTHP)
 		order = HPAGE_PMD_ORDER;
+	else if (pindex >= NR_LOWORDER_PCP_LISTS)
+		order = PAGE_ALLOC_COSTLY_ORDER + 1 +
+			(pindex - NR_LOWORDER_PCP_LISTS) / 2;
 #else
 	VM_BUG_ON(order > PAGE_ALLOC_COSTLY_ORDER);
 #endif
@@ -550,6 +561,9 @@ static inline bool pcp_allowed_order(unsigned int order)
 #ifdef CONFIG_TRANSPARENT_HUGEPAGE
 	if (order == HPAGE_PMD_ORDER)
 		return true;
+	if (order <= PCP_MTHP_MAX_ORDER &&
+	    (READ_ONCE(pcp_mthp_orders) & BIT(order)))
+		return true;
 #endif
 	return false;
 }
@@ -6415,6 +6429,46 @@ static int percpu_pagelist_high_fraction_sysctl_handler(const struct ctl_table *
 	return ret;
 }
 
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+/*
+ * percpu_pagelist_mthp_orders - bitmask of the orders between
+ * PAGE_ALLOC_COSTLY_ORDER and PCP_MTHP_MAX_ORDER that are cached on the per
+ * cpu pagelists, so that mTHP allocations of those sizes don't need the zone
+ * lock for every allocation and free.
+ */
+static int percpu_pagelist_mthp_orders_sysctl_handler(const struct ctl_table *table,
+		int write, void *buffer, size_t *length, loff_t *ppos)
+{
+	unsigned int valid = GENMASK(PCP_MTHP_MAX_ORDER,
+				     PAGE_ALLOC_COSTLY_ORDER + 1);
+	unsigned int old, orders;
+	struct ctl_table t = *table;
+	int ret;
+
+	mutex_lock(&pcp_batch_high_lock);
+	orders = old = pcp_mthp_orders;
+	t.data = &orders;
+
+	ret = proc_douintvec(&t, write, buffer, length, ppos);
+	if (!write || ret < 0)
+		goto out;
+
+	if ((orders & ~valid) || (orders & ~(BIT(HPAGE_PMD_ORDER) - 1))) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	WRITE_ONCE(pcp_mthp_orders, orders);
+
+	/* Give back the pages of orders that are no longer cached */
+	if (old & ~orders)
+		drain_all_pages(NULL);
+out:
+	mutex_unlock(&pcp_batch_high_lock);
+	return ret;
+}
+#endif
+
 static const struct ctl_table page_alloc_sysctl_table[] = {
 	{
 		.procname	= "min_free_kbytes",
@@ -6458,6 +6512,15 @@ static const struct ctl_table page_alloc_sysctl_table[] = {
 		.proc_handler	= percpu_pagelist_high_fraction_sysctl_handler,
 		.extra1		= SYSCTL_ZERO,
 	},
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+	{
+		.procname	= "percpu_pagelist_mthp_orders",
+		.data		= &pcp_mthp_orders,
+		.maxlen		= sizeof(pcp_mthp_orders),
+		.mode		= 0644,
+		.proc_handler	= percpu_pagelist_mthp_orders_sysctl_handler,
+	},
+#endif
 	{
 		.procname	= "lowmem_reserve_ratio",
 		.data		= &sysctl_lowmem_reserve_ratio,
@@ -48,12 +48,15 @@ MODULE_PARM_DESC(page_reporting_order, "Set page reporting order");
 EXPORT_SYMBOL_GPL(page_reporting_order);
 
 #define PAGE_REPORTING_DELAY	(2 * HZ)
+/* Pages already waiting to be reported are not worth batching up for. */
+#define PAGE_REPORTING_BACKLOG_DELAY	(HZ / 10)
 static struct page_reporting_dev_info __rcu *pr_dev_info __read_mostly;
 
 enum {
 	PAGE_REPORTING_IDLE = 0,
 	PAGE_REPORTING_REQUESTED,
-	PAGE_REPORTING_ACTIVE
+	PAGE_REPORTING_ACTIVE,
+	PAGE_REPORTING_BACKLOG
 };
 
 /* request page reporting */
@@ -62,9 +65,13 @@ __page_reporting_request(struct page_reporting_dev_info *prdev)
 {
 	unsigned int state;
 
-	/* Check to see if we are in desired state */
+	/*
+	 * Check to see if we are in desired state. A pass that left a
+	 * backlog behind is followed by another one anyway, and sooner.
+	 */
 	state = atomic_read(&prdev->state);
-	if (state == PAGE_REPORTING_REQUESTED)
+	if (state == PAGE_REPORTING_REQUESTED ||
+	    state == PAGE_REPORTING_BACKLOG)
 		return;
 
 	/*
@@ -171,8 +178,10 @@ page_reporting_cycle(struct page_reporting_dev_info *prdev, struct zone *zone,
 	 * The current value used allows us enough calls to process over a
 	 * sixteenth of the current list plus one additional call to handle
 	 * any pages that may have already been present from the previous
-	 * list processed. This should result in us reporting all pages on
-	 * an idle system in about 30 seconds.
+	 * list processed. Since a pass that runs out of budget is followed
+	 * by the next one after PAGE_REPORTING_BACKLOG_DELAY, this should
+	 * result in us reporting all pages on an idle system in a couple of
+	 * seconds.
 	 *
 	 * The division here should be cheap since PAGE_REPORTING_CAPACITY
 	 * should always be a power of 2.
@@ -187,11 +196,11 @@ page_reporting_cycle(struct page_reporting_dev_info *prdev, struct zone *zone,
 
 		/*
 		 * If we fully consumed our budget then update our
-		 * state to indicate that we are requesting additional
-		 * processing and exit this list.
+		 * state to indicate that there are unreported pages
+		 * left and exit this list.
 		 */
 		if (budget < 0) {
-			atomic_set(&prdev->state, PAGE_REPORTING_REQUESTED);
+			atomic_set(&prdev->state, PAGE_REPORTING_BACKLOG);
 			next = page;
 			break;
 		}
@@ -339,11 +348,15 @@ static void page_reporting_process(struct work_struct *work)
 	/*
 	 * If the state has reverted back to requested then there may be
 	 * additional pages to be processed. We will defer for 2s to allow
-	 * more pages to accumulate.
+	 * more pages to accumulate. If we left pages behind because we ran
+	 * out of budget, they are already there, so come back quickly.
 	 */
 	state = atomic_cmpxchg(&prdev->state, state, PAGE_REPORTING_IDLE);
 	if (state == PAGE_REPORTING_REQUESTED)
 		schedule_delayed_work(&prdev->work, PAGE_REPORTING_DELAY);
+	else if (state == PAGE_REPORTING_BACKLOG)
+		schedule_delayed_work(&prdev->work,
+				      PAGE_REPORTING_BACKLOG_DELAY);
 }
 
 static DEFINE_MUTEX(page_reporting_mutex);
@@ -1712,6 +1712,46 @@ static void pcpu_alloc_tag_free_hook(struct pcpu_chunk *chunk, int off, size_t s
 }
 #endif
 
+/*
+ * Find and allocate an area for @bits in the normal chunks, only from
+ * populated pages if @populated_only.  Chunks that cannot fit the request
+ * are moved out of the way if @move_failed.  Must be called with pcpu_lock
+ * held.  Returns the chunk with the offset of the area in @offp, or NULL.
+ */
+static struct pcpu_chunk *pcpu_alloc_normal_area(size_t size, int bits,
+						 int bit_align,
+						 bool populated_only,
+						 bool move_failed, int *offp)
+{
+	struct pcpu_chunk *chunk, *next;
+	int slot, off;
+
+	lockdep_assert_held(&pcpu_lock);
+
+	for (slot = pcpu_size_to_slot(size); slot <= pcpu_free_slot; slot++) {
+		list_for_each_entry_safe(chunk, next, &pcpu_chunk_lists[slot],
+					 list) {
+			off = pcpu_find_block_fit(chunk, bits, bit_align,
+						  populated_only);
+			if (off < 0) {
+				if (move_failed &&
+				    slot < PCPU_SLOT_FAIL_THRESHOLD)
+					pcpu_chunk_move(chunk, 0);
+				continue;
+			}
+
+			off = pcpu_alloc_area(chunk, bits, bit_align, off);
+			if (off >= 0) {
+				pcpu_reintegrate_chunk(chunk);
+				*offp = off;
+				return chunk;
+			}
+		}
+	}
+
+	return NULL;
+}
+
 /**
  * pcpu_alloc - the percpu allocator
  * @size: size of area to allocate in bytes
@@ -1735,9 +1775,10 @@ void __percpu *pcpu_alloc_noprof(size_t size, size_t align, bool reserved,
 	bool do_warn;
 	struct obj_cgroup *objcg = NULL;
 	static int warn_limit = 10;
-	struct pcpu_chunk *chunk, *next;
+	bool mutex_held = false;
+	struct pcpu_chunk *chunk;
 	const char *err;
-	int slot, off, cpu, ret;
+	int off, cpu, ret;
 	unsigned long flags;
 	void __percpu *ptr;
 	size_t bits, bit_align;
@@ -1771,6 +1812,22 @@ void __percpu *pcpu_alloc_noprof(size_t size, size_t align, bool reserved,
 	if (unlikely(!pcpu_memcg_pre_alloc_hook(size, gfp, &objcg)))
 		return NULL;
 
+	if (!is_atomic && !reserved) {
+		/*
+		 * pcpu_balance_workfn() keeps a pool of populated free pages
+		 * around, and most small allocations fit into it.  Try that
+		 * first, exactly like an atomic allocation would, so that
+		 * they don't serialize on pcpu_alloc_mutex behind allocations
+		 * which need to populate or create chunks.
+		 */
+		spin_lock_irqsave(&pcpu_lock, flags);
+		chunk = pcpu_alloc_normal_area(size, bits, bit_align, true,
+					       false, &off);
+		if (chunk)
+			goto area_found;
+		spin_unlock_irqrestore(&pcpu_lock, flags);
+	}
+
 	if (!is_atomic) {
 		/*
 		 * pcpu_balance_workfn() allocates memory under this mutex,
@@ -1783,6 +1840,7 @@ void __percpu *pcpu_alloc_noprof(size_t size, size_t align, bool reserved,
 			pcpu_memcg_post_alloc_hook(objcg, NULL, 0, size);
 			return NULL;
 		}
+		mutex_held = true;
 	}
 
 	spin_lock_irqsave(&pcpu_lock, flags);
@@ -1807,24 +1865,10 @@ void __percpu *pcpu_alloc_noprof(size_t size, size_t align, bool reserved,
 
 restart:
 	/* search through normal chunks */
-	for (slot = pcpu_size_to_slot(size); slot <= pcpu_free_slot; slot++) {
-		list_for_each_entry_safe(chunk, next, &pcpu_chunk_lists[slot],
-					 list) {
-			off = pcpu_find_block_fit(chunk, bits, bit_align,
-						  is_atomic);
-			if (off < 0) {
-				if (slot < PCPU_SLOT_FAIL_THRESHOLD)
-					pcpu_chunk_move(chunk, 0);
-				continue;
-			}
-
-			off = pcpu_alloc_area(chunk, bits, bit_align, off);
-			if (off >= 0) {
-				pcpu_reintegrate_chunk(chunk);
-				goto area_found;
-			}
-		}
-	}
+	chunk = pcpu_alloc_normal_area(size, bits, bit_align, is_atomic, true,
+				       &off);
+	if (chunk)
+		goto area_found;
 
 	spin_unlock_irqrestore(&pcpu_lock, flags);
 
@@ -1858,7 +1902,7 @@ void __percpu *pcpu_alloc_noprof(size_t size, size_t align, bool reserved,
 	spin_unlock_irqrestore(&pcpu_lock, flags);
 
 	/* populate if not all pages are already there */
-	if (!is_atomic) {
+	if (mutex_held) {
 		unsigned int page_end, rs, re;
 
 		rs = PFN_DOWN(off);
@@ -432,6 +432,13 @@ static unsigned long get_next_ra_size(struct file_ra_state *ra,
  *
  * The code ramps up the readahead size aggressively at first, but slow down as
  * it approaches max_readhead.
+ *
+ * Small reads that are not sequential, but always the same distance apart
+ * (e.g. reading one column out of every row group of a file), are tracked
+ * in stride and stride_hits. Once the stride repeated, the next chunks
+ * along it are read ahead, each with its first folio marked PG_readahead.
+ * While following a stride, start is the last chunk read and size the
+ * chunk size; hitting a marked chunk reads the next one past start.
  */
 
 static inline int ra_alloc_folio(struct readahead_control *ractl, pgoff_t index,
@@ -548,6 +555,74 @@ static unsigned long ractl_max_pages(struct readahead_control *ractl,
 	return max_pages;
 }
 
+/* Consecutive reads at the same stride before it is followed */
+#define RA_STRIDE_HITS	2
+
+/*
+ * Check whether a small read at @index, after a read ending at @prev_index,
+ * continues a strided stream.
+ */
+static bool ra_stride_detect(struct file_ra_state *ra, pgoff_t index,
+		pgoff_t prev_index, unsigned long req_count)
+{
+	unsigned long stride;
+
+	/* Only forward strides, measured between the starts of the reads */
+	if (index <= prev_index) {
+		ra->stride_hits = 0;
+		return false;
+	}
+
+	stride = index - prev_index + req_count - 1;
+	if (stride > UINT_MAX) {
+		ra->stride_hits = 0;
+		return false;
+	}
+
+	if (stride != ra->stride) {
+		ra->stride = stride;
+		ra->stride_hits = 1;
+		return false;
+	}
+
+	if (ra->stride_hits < RA_STRIDE_HITS)
+		ra->stride_hits++;
+	return ra->stride_hits >= RA_STRIDE_HITS;
+}
+
+/*
+ * Read one chunk of a strided stream and mark its first folio, so that the
+ * reader reaching it keeps the stream going from page_cache_async_ra().
+ */
+static void ra_stride_chunk(struct readahead_control *ractl, pgoff_t index,
+		unsigned long size)
+{
+	ractl->_index = index;
+	do_page_cache_ra(ractl, size, size);
+}
+
+/*
+ * Read the request at @index and as many chunks along the stride as fit in
+ * the readahead window, and make the last of them the next place to start.
+ */
+static void page_cache_stride_ra(struct readahead_control *ractl,
+		unsigned long req_count, unsigned long max_pages)
+{
+	struct file_ra_state *ra = ractl->ra;
+	pgoff_t index = readahead_index(ractl);
+	unsigned long i, nr;
+
+	do_page_cache_ra(ractl, req_count, 0);
+
+	nr = max(max_pages / req_count, 1UL);
+	for (i = 1; i <= nr; i++)
+		ra_stride_chunk(ractl, index + i * ra->stride, req_count);
+
+	ra->start = index + nr * ra->stride;
+	ra->size = req_count;
+	ra->async_size = req_count;
+}
+
 void page_cache_sync_ra(struct readahead_control *ractl,
 		unsigned long req_count)
 {
@@ -601,10 +676,13 @@ void page_cache_sync_ra(struct readahead_control *ractl,
 	contig_count = index - miss - 1;
 	/*
 	 * Standalone, small random read. Read as is, and do not pollute the
-	 * readahead state.
+	 * readahead state, unless the reads are regularly strided.
 	 */
 	if (contig_count <= req_count) {
-		do_page_cache_ra(ractl, req_count, 0);
+		if (ra_stride_detect(ra, index, prev_index, req_count))
+			page_cache_stride_ra(ractl, req_count, max_pages);
+		else
+			do_page_cache_ra(ractl, req_count, 0);
 		return;
 	}
 	/*
@@ -617,6 +695,7 @@ void page_cache_sync_ra(struct readahead_control *ractl,
 	ra->size = min(contig_count + req_count, max_pages);
 	ra->async_size = 1;
 readit:
+	ra->stride_hits = 0;
 	ractl->_index = ra->start;
 	page_cache_ra_order(ractl, ra, 0);
 }
@@ -646,6 +725,17 @@ void page_cache_async_ra(struct readahead_control *ractl,
 	if (blk_cgroup_congested())
 		return;
 
+	/*
+	 * A chunk of a strided stream: read the next chunk past the last one,
+	 * so the stream stays the same number of chunks ahead of the reader.
+	 */
+	if (ra->stride_hits >= RA_STRIDE_HITS && index <= ra->start &&
+	    (ra->start - index) % ra->stride == 0) {
+		ra->start += ra->stride;
+		ra_stride_chunk(ractl, ra->start, ra->size);
+		return;
+	}
+
 	max_pages = ractl_max_pages(ractl, req_count);
 	/*
 	 * It's the expected callback index, assume sequential access.
@@ -683,6 +773,7 @@ void page_cache_async_ra(struct readahead_control *ractl,
 	ra->size = get_next_ra_size(ra, max_pages);
 	ra->async_size = ra->size;
 readit:
+	ra->stride_hits = 0;
 	ractl->_index = ra->start;
 	page_cache_ra_order(ractl, ra, order);
 }
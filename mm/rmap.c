@@ -661,6 +661,12 @@ void try_to_unmap_flush_dirty(void)
 		try_to_unmap_flush();
 }
 
+/* Whether try_to_unmap_flush_dirty() would have to flush right now */
+bool try_to_unmap_flush_dirty_pending(void)
+{
+	return current->tlb_ubc.writable;
+}
+
 /*
  * Bits 0-14 of mm->tlb_flush_batched record pending generations.
  * Bits 16-30 of mm->tlb_flush_batched bit record flushed generations.
@@ -1768,8 +1768,15 @@ unsigned long shmem_allowable_huge_orders(struct inode *inode,
 
 	global_orders = shmem_huge_global_enabled(inode, index, write_end,
 						  shmem_huge_force, vma, vm_flags);
-	/* Tmpfs huge pages allocation */
-	if (!vma || !vma_is_anon_shmem(vma))
+	/*
+	 * Tmpfs huge pages allocation.  Without a vma (fallocate, write, read
+	 * through the fd), an inode on the internal mount is a memfd or a
+	 * shared anonymous mapping, and takes the same per-size mTHP controls
+	 * it would get at fault time, so that it is populated with the folio
+	 * sizes its mappings will later fault in.
+	 */
+	if (vma ? !vma_is_anon_shmem(vma) :
+	    IS_ERR_OR_NULL(shm_mnt) || inode->i_sb != shm_mnt->mnt_sb)
 		return global_orders;
 
 	/*
@@ -1787,7 +1794,8 @@ unsigned long shmem_allowable_huge_orders(struct inode *inode,
 		return READ_ONCE(huge_shmem_orders_inherit);
 
 	/* Allow mTHP that will be fully within i_size. */
-	mask |= shmem_get_orders_within_size(inode, within_size_orders, index, 0);
+	mask |= shmem_get_orders_within_size(inode, within_size_orders, index,
+					     write_end);
 
 	if (vm_flags & VM_HUGEPAGE)
 		mask |= READ_ONCE(huge_shmem_orders_madvise);
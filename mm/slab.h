@@ -258,11 +258,15 @@ struct kmem_cache_order_objects {
 struct kmem_cache {
 #ifndef CONFIG_SLUB_TINY
 	struct kmem_cache_cpu __percpu *cpu_slab;
+	struct slub_percpu_sheaves __percpu *cpu_sheaves;
 #endif
 	/* Used for retrieving partial slabs, etc. */
 	slab_flags_t flags;
 	unsigned long min_partial;
 	unsigned int size;		/* Object size including metadata */
+#ifndef CONFIG_SLUB_TINY
+	unsigned int sheaf_capacity;	/* Objects per percpu sheaf, 0 if none */
+#endif
 	unsigned int object_size;	/* Object size without metadata */
 	struct reciprocal_value reciprocal_size;
 	unsigned int offset;		/* Free pointer offset */
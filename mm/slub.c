@@ -372,6 +372,8 @@ enum stat_item {
 	CPU_PARTIAL_FREE,	/* Refill cpu partial on free */
 	CPU_PARTIAL_NODE,	/* Refill cpu partial from node partial */
 	CPU_PARTIAL_DRAIN,	/* Drain cpu partial to node partial */
+	ALLOC_PCS,		/* Allocation from percpu sheaf */
+	FREE_PCS,		/* Free to percpu sheaf */
 	NR_SLUB_STAT_ITEMS
 };
 
@@ -418,6 +420,37 @@ void stat_add(const struct kmem_cache *s, enum stat_item si, int v)
 #endif
 }
 
+#ifndef CONFIG_SLUB_TINY
+/*
+ * A sheaf is an array of free object pointers of a cache that opted in via
+ * kmem_cache_args.sheaf_capacity. Each cpu has a main and an optional spare
+ * sheaf, and each node keeps a barn of full and empty sheaves to exchange
+ * with, so that most allocations and frees are a simple array operation.
+ */
+struct slab_sheaf {
+	struct list_head barn_list;
+	unsigned int size;
+	void *objects[];
+};
+
+struct slub_percpu_sheaves {
+	local_trylock_t lock;
+	struct slab_sheaf *main;	/* never NULL once initialized */
+	struct slab_sheaf *spare;	/* empty or full, may be NULL */
+};
+
+#define MAX_FULL_SHEAVES	10
+#define MAX_EMPTY_SHEAVES	10
+
+struct node_barn {
+	spinlock_t lock;
+	struct list_head sheaves_full;
+	struct list_head sheaves_empty;
+	unsigned int nr_full;
+	unsigned int nr_empty;
+};
+#endif /* CONFIG_SLUB_TINY */
+
 /*
  * The slab lists for all objects.
  */
@@ -430,6 +463,9 @@ struct kmem_cache_node {
 	atomic_long_t total_objects;
 	struct list_head full;
 #endif
+#ifndef CONFIG_SLUB_TINY
+	struct node_barn *barn;		/* NULL unless the cache has sheaves */
+#endif
 };
 
 static inline struct kmem_cache_node *get_node(struct kmem_cache *s, int node)
@@ -3284,6 +3320,315 @@ static inline void put_partials_cpu(struct kmem_cache *s,
 
 #endif	/* CONFIG_SLUB_CPU_PARTIAL */
 
+static void __kmem_cache_free_bulk(struct kmem_cache *s, size_t size, void **p);
+
+static inline bool cache_has_sheaves(struct kmem_cache *s)
+{
+	return s->cpu_sheaves;
+}
+
+static struct slab_sheaf *alloc_empty_sheaf(struct kmem_cache *s, gfp_t gfp)
+{
+	return kzalloc(struct_size_t(struct slab_sheaf, objects,
+				     s->sheaf_capacity), gfp);
+}
+
+static void sheaf_flush(struct kmem_cache *s, struct slab_sheaf *sheaf)
+{
+	/* the objects went through the free hooks already */
+	__kmem_cache_free_bulk(s, sheaf->size, &sheaf->objects[0]);
+	sheaf->size = 0;
+}
+
+static inline struct node_barn *get_barn(struct kmem_cache *s)
+{
+	struct kmem_cache_node *n = get_node(s, numa_mem_id());
+
+	return n ? n->barn : NULL;
+}
+
+static void barn_init(struct node_barn *barn)
+{
+	spin_lock_init(&barn->lock);
+	INIT_LIST_HEAD(&barn->sheaves_full);
+	INIT_LIST_HEAD(&barn->sheaves_empty);
+	barn->nr_full = 0;
+	barn->nr_empty = 0;
+}
+
+/* Give all sheaves in the barn back, flushing the full ones to their slabs */
+static void barn_shrink(struct kmem_cache *s, struct node_barn *barn)
+{
+	struct slab_sheaf *sheaf, *tmp;
+	unsigned long flags;
+	LIST_HEAD(full);
+	LIST_HEAD(empty);
+
+	spin_lock_irqsave(&barn->lock, flags);
+	list_splice_init(&barn->sheaves_full, &full);
+	barn->nr_full = 0;
+	list_splice_init(&barn->sheaves_empty, &empty);
+	barn->nr_empty = 0;
+	spin_unlock_irqrestore(&barn->lock, flags);
+
+	list_for_each_entry_safe(sheaf, tmp, &full, barn_list) {
+		sheaf_flush(s, sheaf);
+		kfree(sheaf);
+	}
+	list_for_each_entry_safe(sheaf, tmp, &empty, barn_list)
+		kfree(sheaf);
+}
+
+static void flush_all_barns(struct kmem_cache *s)
+{
+	struct kmem_cache_node *n;
+	int node;
+
+	if (!cache_has_sheaves(s))
+		return;
+
+	for_each_kmem_cache_node(s, node, n) {
+		if (n->barn)
+			barn_shrink(s, n->barn);
+	}
+}
+
+/* Flush the sheaves of the current cpu. Called with migration disabled. */
+static void pcs_flush(struct kmem_cache *s)
+{
+	struct slub_percpu_sheaves *pcs;
+	struct slab_sheaf *spare;
+
+	local_lock(&s->cpu_sheaves->lock);
+	pcs = this_cpu_ptr(s->cpu_sheaves);
+
+	spare = pcs->spare;
+	pcs->spare = NULL;
+	sheaf_flush(s, pcs->main);
+
+	local_unlock(&s->cpu_sheaves->lock);
+
+	if (spare) {
+		sheaf_flush(s, spare);
+		kfree(spare);
+	}
+}
+
+/* Flush the sheaves of a cpu that is dead and cannot race with us */
+static void __pcs_flush_cpu(struct kmem_cache *s, int cpu)
+{
+	struct slub_percpu_sheaves *pcs = per_cpu_ptr(s->cpu_sheaves, cpu);
+
+	if (pcs->spare) {
+		sheaf_flush(s, pcs->spare);
+		kfree(pcs->spare);
+		pcs->spare = NULL;
+	}
+	sheaf_flush(s, pcs->main);
+}
+
+static bool pcs_has_objects(struct kmem_cache *s, int cpu)
+{
+	struct slub_percpu_sheaves *pcs;
+
+	if (!cache_has_sheaves(s))
+		return false;
+
+	pcs = per_cpu_ptr(s->cpu_sheaves, cpu);
+	return pcs->main->size || pcs->spare;
+}
+
+/*
+ * The main sheaf is empty. Make a non-empty spare the main sheaf, or trade
+ * the empty main sheaf for a full one from the barn. Returns false if there
+ * are no objects to be had without going to the slabs.
+ */
+static bool pcs_replace_empty_main(struct kmem_cache *s,
+				   struct slub_percpu_sheaves *pcs)
+{
+	struct slab_sheaf *full = NULL, *to_free = NULL;
+	struct node_barn *barn;
+	unsigned long flags;
+
+	if (pcs->spare && pcs->spare->size) {
+		swap(pcs->main, pcs->spare);
+		return true;
+	}
+
+	barn = get_barn(s);
+	if (!barn || !data_race(barn->nr_full))
+		return false;
+
+	spin_lock_irqsave(&barn->lock, flags);
+	if (barn->nr_full) {
+		full = list_first_entry(&barn->sheaves_full, struct slab_sheaf,
+					barn_list);
+		list_del(&full->barn_list);
+		barn->nr_full--;
+
+		if (!pcs->spare) {
+			pcs->spare = pcs->main;
+		} else if (barn->nr_empty < MAX_EMPTY_SHEAVES) {
+			list_add(&pcs->main->barn_list, &barn->sheaves_empty);
+			barn->nr_empty++;
+		} else {
+			to_free = pcs->main;
+		}
+		pcs->main = full;
+	}
+	spin_unlock_irqrestore(&barn->lock, flags);
+
+	kfree(to_free);
+	return full;
+}
+
+static __fastpath_inline void *alloc_from_pcs(struct kmem_cache *s)
+{
+	struct slub_percpu_sheaves *pcs;
+	void *object;
+
+	if (!local_trylock(&s->cpu_sheaves->lock))
+		return NULL;
+
+	pcs = this_cpu_ptr(s->cpu_sheaves);
+
+	if (unlikely(!pcs->main->size) && !pcs_replace_empty_main(s, pcs)) {
+		local_unlock(&s->cpu_sheaves->lock);
+		return NULL;
+	}
+
+	object = pcs->main->objects[--pcs->main->size];
+
+	local_unlock(&s->cpu_sheaves->lock);
+
+	stat(s, ALLOC_PCS);
+	return object;
+}
+
+/*
+ * The main sheaf is full. Make an empty spare the main sheaf, or park the
+ * full main sheaf in the barn in exchange for an empty one. If the barn is
+ * already holding enough full sheaves, flush the main sheaf to the slabs.
+ */
+static void pcs_replace_full_main(struct kmem_cache *s,
+				  struct slub_percpu_sheaves *pcs)
+{
+	struct slab_sheaf *empty = NULL;
+	struct node_barn *barn;
+	unsigned long flags;
+	bool parked = false;
+
+	if (pcs->spare && !pcs->spare->size) {
+		swap(pcs->main, pcs->spare);
+		return;
+	}
+
+	barn = get_barn(s);
+	if (!barn || data_race(barn->nr_full) >= MAX_FULL_SHEAVES)
+		goto flush;
+
+	if (!data_race(barn->nr_empty)) {
+		empty = alloc_empty_sheaf(s, GFP_NOWAIT | __GFP_NOWARN);
+		if (empty && !pcs->spare) {
+			pcs->spare = pcs->main;
+			pcs->main = empty;
+			return;
+		}
+	}
+
+	spin_lock_irqsave(&barn->lock, flags);
+	if (barn->nr_full < MAX_FULL_SHEAVES && (empty || barn->nr_empty)) {
+		if (!empty) {
+			empty = list_first_entry(&barn->sheaves_empty,
+						 struct slab_sheaf, barn_list);
+			list_del(&empty->barn_list);
+			barn->nr_empty--;
+		}
+		list_add(&pcs->main->barn_list, &barn->sheaves_full);
+		barn->nr_full++;
+		pcs->main = empty;
+		parked = true;
+	}
+	spin_unlock_irqrestore(&barn->lock, flags);
+
+	if (parked)
+		return;
+
+	kfree(empty);
+flush:
+	sheaf_flush(s, pcs->main);
+}
+
+static __fastpath_inline bool free_to_pcs(struct kmem_cache *s, void *object)
+{
+	struct slub_percpu_sheaves *pcs;
+
+	if (!local_trylock(&s->cpu_sheaves->lock))
+		return false;
+
+	pcs = this_cpu_ptr(s->cpu_sheaves);
+
+	if (unlikely(pcs->main->size == s->sheaf_capacity))
+		pcs_replace_full_main(s, pcs);
+
+	pcs->main->objects[pcs->main->size++] = object;
+
+	local_unlock(&s->cpu_sheaves->lock);
+
+	stat(s, FREE_PCS);
+	return true;
+}
+
+static int init_percpu_sheaves(struct kmem_cache *s, unsigned int capacity)
+{
+	struct kmem_cache_node *n;
+	int cpu, node;
+
+	s->sheaf_capacity = capacity;
+	s->cpu_sheaves = alloc_percpu(struct slub_percpu_sheaves);
+	if (!s->cpu_sheaves)
+		return 0;
+
+	for_each_possible_cpu(cpu) {
+		struct slub_percpu_sheaves *pcs;
+
+		pcs = per_cpu_ptr(s->cpu_sheaves, cpu);
+		local_trylock_init(&pcs->lock);
+		pcs->main = alloc_empty_sheaf(s, GFP_KERNEL);
+		if (!pcs->main)
+			return 0;
+	}
+
+	for_each_kmem_cache_node(s, node, n) {
+		struct node_barn *barn;
+
+		barn = kmalloc_node(sizeof(*barn), GFP_KERNEL, node);
+		if (!barn)
+			return 0;
+		barn_init(barn);
+		n->barn = barn;
+	}
+
+	return 1;
+}
+
+static void free_percpu_sheaves(struct kmem_cache *s)
+{
+	int cpu;
+
+	if (!s->cpu_sheaves)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		struct slub_percpu_sheaves *pcs = per_cpu_ptr(s->cpu_sheaves, cpu);
+
+		kfree(pcs->main);
+		kfree(pcs->spare);
+	}
+	free_percpu(s->cpu_sheaves);
+	s->cpu_sheaves = NULL;
+}
+
 static inline void flush_slab(struct kmem_cache *s, struct kmem_cache_cpu *c)
 {
 	unsigned long flags;
@@ -3351,13 +3696,16 @@ static void flush_cpu_slab(struct work_struct *w)
 		flush_slab(s, c);
 
 	put_partials(s);
+
+	if (cache_has_sheaves(s))
+		pcs_flush(s);
 }
 
 static bool has_cpu_slab(int cpu, struct kmem_cache *s)
 {
 	struct kmem_cache_cpu *c = per_cpu_ptr(s->cpu_slab, cpu);
 
-	return c->slab || slub_percpu_partial(c);
+	return c->slab || slub_percpu_partial(c) || pcs_has_objects(s, cpu);
 }
 
 static DEFINE_MUTEX(flush_lock);
@@ -3391,6 +3739,8 @@ static void flush_all_cpus_locked(struct kmem_cache *s)
 	}
 
 	mutex_unlock(&flush_lock);
+
+	flush_all_barns(s);
 }
 
 static void flush_all(struct kmem_cache *s)
@@ -3409,8 +3759,11 @@ static int slub_cpu_dead(unsigned int cpu)
 	struct kmem_cache *s;
 
 	mutex_lock(&slab_mutex);
-	list_for_each_entry(s, &slab_caches, list)
+	list_for_each_entry(s, &slab_caches, list) {
 		__flush_cpu_slab(s, cpu);
+		if (cache_has_sheaves(s))
+			__pcs_flush_cpu(s, cpu);
+	}
 	mutex_unlock(&slab_mutex);
 	return 0;
 }
@@ -3420,6 +3773,12 @@ static inline void flush_all_cpus_locked(struct kmem_cache *s) { }
 static inline void flush_all(struct kmem_cache *s) { }
 static inline void __flush_cpu_slab(struct kmem_cache *s, int cpu) { }
 static inline int slub_cpu_dead(unsigned int cpu) { return 0; }
+static inline bool cache_has_sheaves(struct kmem_cache *s) { return false; }
+static inline void *alloc_from_pcs(struct kmem_cache *s) { return NULL; }
+static inline bool free_to_pcs(struct kmem_cache *s, void *object)
+{
+	return false;
+}
 #endif /* CONFIG_SLUB_TINY */
 
 /*
@@ -4195,7 +4554,11 @@ static __fastpath_inline void *slab_alloc_node(struct kmem_cache *s, struct list
 	if (unlikely(object))
 		goto out;
 
-	object = __slab_alloc_node(s, gfpflags, node, addr, orig_size);
+	if (cache_has_sheaves(s) && node == NUMA_NO_NODE)
+		object = alloc_from_pcs(s);
+
+	if (!object)
+		object = __slab_alloc_node(s, gfpflags, node, addr, orig_size);
 
 	maybe_wipe_obj_freeptr(s, object);
 	init = slab_want_init_on_alloc(gfpflags, s);
@@ -4653,8 +5016,18 @@ void slab_free(struct kmem_cache *s, struct slab *slab, void *object,
 	memcg_slab_free_hook(s, slab, &object, 1);
 	alloc_tagging_slab_free_hook(s, slab, &object, 1);
 
-	if (likely(slab_free_hook(s, object, slab_want_init_on_free(s), false)))
-		do_slab_free(s, slab, object, object, 1, addr);
+	if (unlikely(!slab_free_hook(s, object, slab_want_init_on_free(s), false)))
+		return;
+
+	/*
+	 * Objects from pfmemalloc slabs go back to their slab, where only
+	 * allocations allowed to use the reserves can find them.
+	 */
+	if (cache_has_sheaves(s) && slab_nid(slab) == numa_mem_id() &&
+	    likely(!slab_test_pfmemalloc(slab)) && free_to_pcs(s, object))
+		return;
+
+	do_slab_free(s, slab, object, object, 1, addr);
 }
 
 #ifdef CONFIG_MEMCG
@@ -5534,6 +5907,9 @@ init_kmem_cache_node(struct kmem_cache_node *n)
 	atomic_long_set(&n->total_objects, 0);
 	INIT_LIST_HEAD(&n->full);
 #endif
+#ifndef CONFIG_SLUB_TINY
+	n->barn = NULL;
+#endif
 }
 
 #ifndef CONFIG_SLUB_TINY
@@ -5615,6 +5991,9 @@ static void free_kmem_cache_nodes(struct kmem_cache *s)
 	struct kmem_cache_node *n;
 
 	for_each_kmem_cache_node(s, node, n) {
+#ifndef CONFIG_SLUB_TINY
+		kfree(n->barn);
+#endif
 		s->node[node] = NULL;
 		kmem_cache_free(kmem_cache_node, n);
 	}
@@ -5624,6 +6003,7 @@ void __kmem_cache_release(struct kmem_cache *s)
 {
 	cache_random_seq_destroy(s);
 #ifndef CONFIG_SLUB_TINY
+	free_percpu_sheaves(s);
 	free_percpu(s->cpu_slab);
 #endif
 	free_kmem_cache_nodes(s);
@@ -6471,6 +6851,12 @@ int do_kmem_cache_create(struct kmem_cache *s, const char *name,
 	if (!alloc_kmem_cache_cpus(s))
 		goto out;
 
+#ifndef CONFIG_SLUB_TINY
+	if (args->sheaf_capacity && slab_state >= UP && !kmem_cache_debug(s) &&
+	    !init_percpu_sheaves(s, args->sheaf_capacity))
+		goto out;
+#endif
+
 	err = 0;
 
 	/* Mutex is not taken during early boot */
@@ -7296,6 +7682,8 @@ STAT_ATTR(CPU_PARTIAL_ALLOC, cpu_partial_alloc);
 STAT_ATTR(CPU_PARTIAL_FREE, cpu_partial_free);
 STAT_ATTR(CPU_PARTIAL_NODE, cpu_partial_node);
 STAT_ATTR(CPU_PARTIAL_DRAIN, cpu_partial_drain);
+STAT_ATTR(ALLOC_PCS, alloc_cpu_sheaf);
+STAT_ATTR(FREE_PCS, free_cpu_sheaf);
 #endif	/* CONFIG_SLUB_STATS */
 
 #ifdef CONFIG_KFENCE
@@ -7383,6 +7771,8 @@ static struct attribute *slab_attrs[] = {
 	&cpu_partial_free_attr.attr,
 	&cpu_partial_node_attr.attr,
 	&cpu_partial_drain_attr.attr,
+	&alloc_cpu_sheaf_attr.attr,
+	&free_cpu_sheaf_attr.attr,
 #endif
 #ifdef CONFIG_FAILSLAB
 	&failslab_attr.attr,
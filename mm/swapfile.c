@@ -825,53 +825,90 @@ static unsigned int alloc_swap_scan_cluster(struct swap_info_struct *si,
 	return found;
 }
 
+/*
+ * Drop the swap cache of every cache-only slot in the cluster, so the slots
+ * can be reused. Called with ci->lock held, which may be dropped and retaken.
+ */
+static void swap_reclaim_cluster(struct swap_info_struct *si,
+				 struct swap_cluster_info *ci)
+{
+	unsigned long offset = cluster_offset(si, ci);
+	unsigned long end = min(si->max, offset + SWAPFILE_CLUSTER);
+	unsigned char *map = si->swap_map;
+	int nr_reclaim;
+
+	while (offset < end) {
+		if (READ_ONCE(map[offset]) == SWAP_HAS_CACHE) {
+			spin_unlock(&ci->lock);
+			nr_reclaim = __try_to_reclaim_swap(si, offset,
+							   TTRS_ANYWAY);
+			spin_lock(&ci->lock);
+			if (nr_reclaim) {
+				offset += abs(nr_reclaim);
+				continue;
+			}
+		}
+		offset++;
+	}
+
+	/* in case no swap cache is reclaimed */
+	if (ci->flags == CLUSTER_FLAG_NONE)
+		relocate_cluster(si, ci);
+}
+
 static void swap_reclaim_full_clusters(struct swap_info_struct *si, bool force)
 {
 	long to_scan = 1;
-	unsigned long offset, end;
 	struct swap_cluster_info *ci;
-	unsigned char *map = si->swap_map;
-	int nr_reclaim;
 
 	if (force)
 		to_scan = swap_usage_in_pages(si) / SWAPFILE_CLUSTER;
 
 	while ((ci = isolate_lock_cluster(si, &si->full_clusters))) {
-		offset = cluster_offset(si, ci);
-		end = min(si->max, offset + SWAPFILE_CLUSTER);
 		to_scan--;
-
-		while (offset < end) {
-			if (READ_ONCE(map[offset]) == SWAP_HAS_CACHE) {
-				spin_unlock(&ci->lock);
-				nr_reclaim = __try_to_reclaim_swap(si, offset,
-								   TTRS_ANYWAY);
-				spin_lock(&ci->lock);
-				if (nr_reclaim) {
-					offset += abs(nr_reclaim);
-					continue;
-				}
-			}
-			offset++;
-		}
-
-		/* in case no swap cache is reclaimed */
-		if (ci->flags == CLUSTER_FLAG_NONE)
-			relocate_cluster(si, ci);
-
+		swap_reclaim_cluster(si, ci);
 		unlock_cluster(ci);
 		if (to_scan <= 0)
 			break;
 	}
 }
 
+/*
+ * Large order allocation failed because no cluster of that order had room
+ * and there was no free cluster left. Fragmented clusters are often pinned
+ * only by swap cache of folios that were already swapped in, so reclaim
+ * those slots to turn fragmented clusters back into free ones. Each list is
+ * rotated at most once.
+ */
+static void swap_reclaim_frag_clusters(struct swap_info_struct *si, int order)
+{
+	struct swap_cluster_info *ci;
+	long to_scan;
+
+	to_scan = atomic_long_read(&si->frag_cluster_nr[order]);
+	while (to_scan-- > 0 &&
+	       (ci = isolate_lock_cluster(si, &si->frag_clusters[order]))) {
+		atomic_long_dec(&si->frag_cluster_nr[order]);
+		swap_reclaim_cluster(si, ci);
+		unlock_cluster(ci);
+		cond_resched();
+	}
+}
+
 static void swap_reclaim_work(struct work_struct *work)
 {
 	struct swap_info_struct *si;
+	int order;
 
 	si = container_of(work, struct swap_info_struct, reclaim_work);
 
-	swap_reclaim_full_clusters(si, true);
+	for (order = SWAP_NR_ORDERS - 1; order > 0; order--) {
+		if (test_and_clear_bit(order, &si->frag_reclaim_orders))
+			swap_reclaim_frag_clusters(si, order);
+	}
+
+	if (vm_swap_full())
+		swap_reclaim_full_clusters(si, true);
 }
 
 /*
@@ -963,8 +1000,16 @@ static unsigned long cluster_alloc_swap_entry(struct swap_info_struct *si, int o
 	if ((si->flags & SWP_PAGE_DISCARD) && swap_do_scheduled_discard(si))
 		goto new_cluster;
 
-	if (order)
+	if (order) {
+		/*
+		 * Let the reclaim worker compact the fragmented clusters
+		 * so following allocations of this order don't have to
+		 * split the folio.
+		 */
+		if (!test_and_set_bit(order, &si->frag_reclaim_orders))
+			schedule_work(&si->reclaim_work);
 		goto done;
+	}
 
 	/* Order 0 stealing from higher order */
 	for (int o = 1; o < SWAP_NR_ORDERS; o++) {
@@ -1211,9 +1256,9 @@ static bool swap_alloc_fast(swp_entry_t *entry,
 static bool swap_alloc_slow(swp_entry_t *entry,
 			    int order)
 {
-	int node;
+	int node, tried = 0;
 	unsigned long offset;
-	struct swap_info_struct *si, *next;
+	struct swap_info_struct *si, *next, *first = NULL;
 
 	node = numa_node_id();
 	spin_lock(&swap_avail_lock);
@@ -1229,11 +1274,30 @@ static bool swap_alloc_slow(swp_entry_t *entry,
 				*entry = swp_entry(si->type, offset);
 				return true;
 			}
-			if (order)
-				return false;
 		}
 
 		spin_lock(&swap_avail_lock);
+		if (order) {
+			/*
+			 * Large allocations won't fall through to lower
+			 * priority devices, but the devices sharing this
+			 * priority are striped at cluster granularity: try
+			 * each of them once before giving up and letting the
+			 * caller split the folio.
+			 */
+			if (!first)
+				first = si;
+			if (plist_head_empty(&swap_avail_heads[node]) ||
+			    ++tried >= nr_swapfiles)
+				break;
+			next = plist_first_entry(&swap_avail_heads[node],
+						 struct swap_info_struct,
+						 avail_lists[node]);
+			if (next == first || next->prio != si->prio)
+				break;
+			goto start_over;
+		}
+
 		/*
 		 * if we got here, it's likely that si was almost full before,
 		 * and since scan_swap_map_slots() can drop the si->lock,
@@ -3224,6 +3288,7 @@ static struct swap_cluster_info *setup_clusters(struct swap_info_struct *si,
 		INIT_LIST_HEAD(&si->frag_clusters[i]);
 		atomic_long_set(&si->frag_cluster_nr[i], 0);
 	}
+	si->frag_reclaim_orders = 0;
 
 	/*
 	 * Reduce false cache line sharing between cluster_info and
@@ -857,11 +857,13 @@ struct rb_list {
 };
 
 /*
- * A fast size storage contains VAs up to 1M size. A pool consists
- * of linked between each other ready to go VAs of certain sizes.
- * An index in the pool-array corresponds to number of pages + 1.
+ * A fast size storage contains VAs up to 1M size, or 2M plus a guard
+ * page with 4K pages, so that BPF programs and large kvmalloc()
+ * fallbacks are covered as well. A pool consists of linked between
+ * each other ready to go VAs of certain sizes. An index in the
+ * pool-array corresponds to number of pages + 1.
  */
-#define MAX_VA_SIZE_PAGES 256
+#define MAX_VA_SIZE_PAGES MAX(256, SZ_2M / PAGE_SIZE + 1)
 
 struct vmap_pool {
 	struct list_head head;
@@ -2128,10 +2130,15 @@ reclaim_list_global(struct list_head *head)
 	spin_unlock(&free_vmap_area_lock);
 }
 
+/*
+ * Decay the pools of a node, the released VAs are put to @decay_list
+ * so that the caller can return them to the global heap together with
+ * other ones.
+ */
 static void
-decay_va_pool_node(struct vmap_node *vn, bool full_decay)
+decay_va_pool_node(struct vmap_node *vn, bool full_decay,
+		struct list_head *decay_list)
 {
-	LIST_HEAD(decay_list);
 	struct rb_root decay_root = RB_ROOT;
 	struct vmap_area *va, *nva;
 	unsigned long n_decay;
@@ -2156,7 +2163,7 @@ decay_va_pool_node(struct vmap_node *vn, bool full_decay)
 
 		list_for_each_entry_safe(va, nva, &tmp_list, list) {
 			list_del_init(&va->list);
-			merge_or_add_vmap_area(va, &decay_root, &decay_list);
+			merge_or_add_vmap_area(va, &decay_root, decay_list);
 
 			if (!full_decay) {
 				WRITE_ONCE(vn->pool[i].len, vn->pool[i].len - 1);
@@ -2178,8 +2185,6 @@ decay_va_pool_node(struct vmap_node *vn, bool full_decay)
 			spin_unlock(&vn->pool_lock);
 		}
 	}
-
-	reclaim_list_global(&decay_list);
 }
 
 static void
@@ -2212,6 +2217,13 @@ static void purge_vmap_node(struct work_struct *work)
 	if (IS_ENABLED(CONFIG_KASAN_VMALLOC))
 		kasan_release_vmalloc_node(vn);
 
+	/*
+	 * Decay the pools before they get populated with the purged
+	 * areas. It is done here, so it runs in parallel for nodes
+	 * which are handled by helpers.
+	 */
+	decay_va_pool_node(vn, vn->skip_populate, &local_list);
+
 	vn->nr_purged = 0;
 
 	list_for_each_entry_safe(va, n_va, &vn->purge_list, list) {
@@ -2260,10 +2272,15 @@ static bool __purge_vmap_area_lazy(unsigned long start, unsigned long end,
 
 		INIT_LIST_HEAD(&vn->purge_list);
 		vn->skip_populate = full_pool_decay;
-		decay_va_pool_node(vn, full_pool_decay);
 
-		if (RB_EMPTY_ROOT(&vn->lazy.root))
+		/* Nodes with lazy areas decay their pools in purge_vmap_node(). */
+		if (RB_EMPTY_ROOT(&vn->lazy.root)) {
+			LIST_HEAD(decay_list);
+
+			decay_va_pool_node(vn, full_pool_decay, &decay_list);
+			reclaim_list_global(&decay_list);
 			continue;
+		}
 
 		spin_lock(&vn->lazy.lock);
 		WRITE_ONCE(vn->lazy.root.rb_node, NULL);
@@ -5158,11 +5175,13 @@ vmap_node_shrink_count(struct shrinker *shrink, struct shrink_control *sc)
 static unsigned long
 vmap_node_shrink_scan(struct shrinker *shrink, struct shrink_control *sc)
 {
+	LIST_HEAD(decay_list);
 	int i;
 
 	for (i = 0; i < nr_vmap_nodes; i++)
-		decay_va_pool_node(&vmap_nodes[i], true);
+		decay_va_pool_node(&vmap_nodes[i], true, &decay_list);
 
+	reclaim_list_global(&decay_list);
 	return SHRINK_STOP;
 }
 
@@ -96,6 +96,9 @@ struct scan_control {
 #ifdef CONFIG_MEMCG
 	/* Swappiness value for proactive reclaim. Always use sc_swappiness()! */
 	int *proactive_swappiness;
+
+	/* Only reclaim generations older than this (jiffies), for MGLRU */
+	unsigned long proactive_min_age;
 #endif
 
 	/* Can active folios be deactivated as part of reclaim? */
@@ -1101,9 +1104,11 @@ static unsigned int shrink_folio_list(struct list_head *folio_list,
 	struct folio_batch free_folios;
 	LIST_HEAD(ret_folios);
 	LIST_HEAD(demote_folios);
+	LIST_HEAD(pageout_folios);
 	unsigned int nr_reclaimed = 0, nr_demoted = 0;
-	unsigned int pgactivate = 0;
+	unsigned int pgactivate = 0, nr_deferred = 0;
 	bool do_demote_pass;
+	bool defer_pageout = true, pageout_pass = false;
 	struct swap_iocb *plug = NULL;
 
 	folio_batch_init(&free_folios);
@@ -1112,7 +1117,8 @@ static unsigned int shrink_folio_list(struct list_head *folio_list,
 	do_demote_pass = can_demote(pgdat->node_id, sc);
 
 retry:
-	while (!list_empty(folio_list)) {
+	while (!list_empty(folio_list) ||
+	       (pageout_pass && !list_empty(&pageout_folios))) {
 		struct address_space *mapping;
 		struct folio *folio;
 		enum folio_references references = FOLIOREF_RECLAIM;
@@ -1121,6 +1127,18 @@ static unsigned int shrink_folio_list(struct list_head *folio_list,
 
 		cond_resched();
 
+		/*
+		 * Deferred folios are still locked, unmapped and were found
+		 * ready for pageout by the first pass.
+		 */
+		if (pageout_pass && !list_empty(&pageout_folios)) {
+			folio = lru_to_folio(&pageout_folios);
+			list_del(&folio->lru);
+			nr_pages = folio_nr_pages(folio);
+			mapping = folio_mapping(folio);
+			goto write_folio;
+		}
+
 		folio = lru_to_folio(folio_list);
 		list_del(&folio->lru);
 
@@ -1428,10 +1446,20 @@ static unsigned int shrink_folio_list(struct list_head *folio_list,
 				goto keep_locked;
 
 			/*
-			 * Folio is dirty. Flush the TLB if a writable entry
-			 * potentially exists to avoid CPU writes after I/O
-			 * starts and then write it out here.
+			 * Folio is dirty. The TLB must be flushed if a writable
+			 * entry potentially exists to avoid CPU writes after I/O
+			 * starts. Rather than flushing for every dirty folio,
+			 * which means IPIs to every cpu the unmapped mms ran on,
+			 * hold on to the folio and write it out after a single
+			 * flush for the whole batch.
 			 */
+			if (defer_pageout && nr_deferred < SWAP_CLUSTER_MAX &&
+			    try_to_unmap_flush_dirty_pending()) {
+				list_add(&folio->lru, &pageout_folios);
+				nr_deferred++;
+				continue;
+			}
+write_folio:
 			try_to_unmap_flush_dirty();
 			switch (pageout(folio, mapping, &plug, folio_list)) {
 			case PAGE_KEEP:
@@ -1583,6 +1611,14 @@ static unsigned int shrink_folio_list(struct list_head *folio_list,
 	}
 	/* 'folio_list' is always empty here */
 
+	/* Write out the deferred dirty folios after one TLB flush */
+	if (!pageout_pass && !list_empty(&pageout_folios)) {
+		try_to_unmap_flush_dirty();
+		defer_pageout = false;
+		pageout_pass = true;
+		goto retry;
+	}
+
 	/* Migrate folios selected for demotion */
 	nr_demoted = demote_folio_list(&demote_folios, pgdat);
 	nr_reclaimed += nr_demoted;
@@ -3566,6 +3602,10 @@ static bool walk_pte_range(pmd_t *pmd, unsigned long start, unsigned long end,
 	arch_leave_lazy_mmu_mode();
 	pte_unmap_unlock(pte, ptl);
 
+	/* a densely accessed PTE table is a good candidate for a PMD THP */
+	if (young > PTRS_PER_PTE / 2)
+		khugepaged_hint(args->vma, start);
+
 	return suitable_to_scan(total, young);
 }
 
@@ -4410,6 +4450,50 @@ void lru_gen_soft_reclaim(struct mem_cgroup *memcg, int nid)
 		lru_gen_rotate_memcg(lruvec, MEMCG_LRU_HEAD);
 }
 
+/*
+ * Show the generations of each node of this memcg, from the oldest to the
+ * youngest: sequence number, age in milliseconds, and the number of anon
+ * and file pages. Only reads the counters kept for eviction anyway.
+ */
+void lru_gen_memcg_show(struct seq_file *m, struct mem_cgroup *memcg)
+{
+	int nid;
+
+	if (!lru_gen_enabled())
+		return;
+
+	for_each_node_state(nid, N_MEMORY) {
+		unsigned long seq;
+		struct lruvec *lruvec = get_lruvec(memcg, nid);
+		struct lru_gen_folio *lrugen = &lruvec->lrugen;
+		DEFINE_MAX_SEQ(lruvec);
+		DEFINE_MIN_SEQ(lruvec);
+
+		seq_printf(m, "node %d\n", nid);
+
+		for (seq = min(min_seq[LRU_GEN_ANON], min_seq[LRU_GEN_FILE]);
+		     seq <= max_seq; seq++) {
+			int type, zone;
+			int gen = lru_gen_from_seq(seq);
+			unsigned long birth = READ_ONCE(lrugen->timestamps[gen]);
+
+			seq_printf(m, "%lu %u", seq, jiffies_to_msecs(jiffies - birth));
+
+			for (type = 0; type < ANON_AND_FILE; type++) {
+				unsigned long size = 0;
+
+				if (seq >= min_seq[type]) {
+					for (zone = 0; zone < MAX_NR_ZONES; zone++)
+						size += max(READ_ONCE(lrugen->nr_pages[gen][type][zone]), 0L);
+				}
+				seq_printf(m, " %lu", size);
+			}
+
+			seq_putc(m, '\n');
+		}
+	}
+}
+
 #endif /* CONFIG_MEMCG */
 
 /******************************************************************************
@@ -4843,6 +4927,42 @@ static bool should_abort_scan(struct lruvec *lruvec, struct scan_control *sc)
 	return true;
 }
 
+/*
+ * For proactive reclaim with a minimum age, restrict eviction to the types
+ * whose oldest generation is older than that age. Returns -1 if there is no
+ * such type.
+ */
+static int get_swappiness_by_age(struct lruvec *lruvec, struct scan_control *sc,
+				 int swappiness)
+{
+#ifdef CONFIG_MEMCG
+	int type;
+	bool old[ANON_AND_FILE] = {};
+	struct lru_gen_folio *lrugen = &lruvec->lrugen;
+	DEFINE_MIN_SEQ(lruvec);
+
+	if (!sc->proactive || !sc->proactive_min_age)
+		return swappiness;
+
+	for_each_evictable_type(type, swappiness) {
+		int gen = lru_gen_from_seq(min_seq[type]);
+		unsigned long birth = READ_ONCE(lrugen->timestamps[gen]);
+
+		old[type] = time_is_before_jiffies(birth + sc->proactive_min_age);
+	}
+
+	if (old[LRU_GEN_ANON] && old[LRU_GEN_FILE])
+		return swappiness;
+	if (old[LRU_GEN_ANON])
+		return MAX_SWAPPINESS + 1;
+	if (old[LRU_GEN_FILE])
+		return MIN_SWAPPINESS;
+	return -1;
+#else
+	return swappiness;
+#endif
+}
+
 static bool try_to_shrink_lruvec(struct lruvec *lruvec, struct scan_control *sc)
 {
 	long nr_to_scan;
@@ -4851,12 +4971,18 @@ static bool try_to_shrink_lruvec(struct lruvec *lruvec, struct scan_control *sc)
 
 	while (true) {
 		int delta;
+		int age_swappiness = get_swappiness_by_age(lruvec, sc, swappiness);
+
+		if (age_swappiness < 0) {
+			nr_to_scan = -1;
+			break;
+		}
 
-		nr_to_scan = get_nr_to_scan(lruvec, sc, swappiness);
+		nr_to_scan = get_nr_to_scan(lruvec, sc, age_swappiness);
 		if (nr_to_scan <= 0)
 			break;
 
-		delta = evict_folios(lruvec, sc, swappiness);
+		delta = evict_folios(lruvec, sc, age_swappiness);
 		if (!delta)
 			break;
 
@@ -6633,13 +6759,14 @@ unsigned long try_to_free_mem_cgroup_pages(struct mem_cgroup *memcg,
 					   unsigned long nr_pages,
 					   gfp_t gfp_mask,
 					   unsigned int reclaim_options,
-					   int *swappiness)
+					   int *swappiness, unsigned long min_age)
 {
 	unsigned long nr_reclaimed;
 	unsigned int noreclaim_flag;
 	struct scan_control sc = {
 		.nr_to_reclaim = max(nr_pages, SWAP_CLUSTER_MAX),
 		.proactive_swappiness = swappiness,
+		.proactive_min_age = min_age,
 		.gfp_mask = (current_gfp_context(gfp_mask) & GFP_RECLAIM_MASK) |
 				(GFP_HIGHUSER_MOVABLE & ~GFP_RECLAIM_MASK),
 		.reclaim_idx = MAX_NR_ZONES - 1,
@@ -129,6 +129,16 @@ static bool zswap_shrinker_enabled = IS_ENABLED(
 		CONFIG_ZSWAP_SHRINKER_DEFAULT_ON);
 module_param_named(shrinker_enabled, zswap_shrinker_enabled, bool, 0644);
 
+/*
+ * Pages of a large folio a synchronous compressor works on at once, spread
+ * over several CPUs by the crypto API. Each one costs every CPU another
+ * request and two pages of buffer, and the CPU time is spent by kworkers
+ * instead of being charged to the reclaiming task. Takes effect for pools
+ * created afterwards.
+ */
+static unsigned int zswap_sync_batch_size = 1;
+module_param_named(sync_batch_size, zswap_sync_batch_size, uint, 0644);
+
 bool zswap_is_enabled(void)
 {
 	return zswap_enabled;
@@ -143,11 +153,22 @@ bool zswap_never_enabled(void)
 * data structures
 **********************************/
 
+/*
+ * Maximum number of pages of a large folio compressed in one chained acomp
+ * request. Asynchronous (hardware) compressors work on the batch at once,
+ * the crypto API spreads the batch of a synchronous one, which is limited
+ * by zswap_sync_batch_size, over several CPUs.
+ */
+#define ZSWAP_MAX_BATCH_SIZE 8U
+
 struct crypto_acomp_ctx {
 	struct crypto_acomp *acomp;
-	struct acomp_req *req;
+	struct acomp_req *reqs[ZSWAP_MAX_BATCH_SIZE];
+	u8 *buffers[ZSWAP_MAX_BATCH_SIZE];
+	struct scatterlist input[ZSWAP_MAX_BATCH_SIZE];
+	struct scatterlist output[ZSWAP_MAX_BATCH_SIZE];
+	unsigned int nr_reqs;
 	struct crypto_wait wait;
-	u8 *buffer;
 	struct mutex mutex;
 	bool is_sleepable;
 };
@@ -818,21 +839,30 @@ static void zswap_entry_free(struct zswap_entry *entry)
 /*********************************
 * compressed storage functions
 **********************************/
+static void zswap_cpu_comp_free(struct crypto_acomp *acomp,
+				struct acomp_req **reqs, u8 **buffers)
+{
+	unsigned int i;
+
+	for (i = 0; i < ZSWAP_MAX_BATCH_SIZE; i++) {
+		if (!IS_ERR_OR_NULL(reqs[i]))
+			acomp_request_free(reqs[i]);
+		kfree(buffers[i]);
+	}
+	if (!IS_ERR_OR_NULL(acomp))
+		crypto_free_acomp(acomp);
+}
+
 static int zswap_cpu_comp_prepare(unsigned int cpu, struct hlist_node *node)
 {
 	struct zswap_pool *pool = hlist_entry(node, struct zswap_pool, node);
 	struct crypto_acomp_ctx *acomp_ctx = per_cpu_ptr(pool->acomp_ctx, cpu);
+	struct acomp_req *reqs[ZSWAP_MAX_BATCH_SIZE] = {};
+	u8 *buffers[ZSWAP_MAX_BATCH_SIZE] = {};
 	struct crypto_acomp *acomp = NULL;
-	struct acomp_req *req = NULL;
-	u8 *buffer = NULL;
+	unsigned int i, nr_reqs;
 	int ret;
 
-	buffer = kmalloc_node(PAGE_SIZE * 2, GFP_KERNEL, cpu_to_node(cpu));
-	if (!buffer) {
-		ret = -ENOMEM;
-		goto fail;
-	}
-
 	acomp = crypto_alloc_acomp_node(pool->tfm_name, 0, 0, cpu_to_node(cpu));
 	if (IS_ERR(acomp)) {
 		pr_err("could not alloc crypto acomp %s : %ld\n",
@@ -841,12 +871,25 @@ static int zswap_cpu_comp_prepare(unsigned int cpu, struct hlist_node *node)
 		goto fail;
 	}
 
-	req = acomp_request_alloc(acomp);
-	if (!req) {
-		pr_err("could not alloc crypto acomp_request %s\n",
-		       pool->tfm_name);
-		ret = -ENOMEM;
-		goto fail;
+	nr_reqs = ZSWAP_MAX_BATCH_SIZE;
+	if (!acomp_is_async(acomp))
+		nr_reqs = clamp(READ_ONCE(zswap_sync_batch_size), 1U,
+				min(nr_reqs, num_possible_cpus()));
+	for (i = 0; i < nr_reqs; i++) {
+		buffers[i] = kmalloc_node(PAGE_SIZE * 2, GFP_KERNEL,
+					  cpu_to_node(cpu));
+		if (!buffers[i]) {
+			ret = -ENOMEM;
+			goto fail;
+		}
+
+		reqs[i] = acomp_request_alloc(acomp);
+		if (!reqs[i]) {
+			pr_err("could not alloc crypto acomp_request %s\n",
+			       pool->tfm_name);
+			ret = -ENOMEM;
+			goto fail;
+		}
 	}
 
 	/*
@@ -861,21 +904,26 @@ static int zswap_cpu_comp_prepare(unsigned int cpu, struct hlist_node *node)
 	 * if the backend of acomp is async zip, crypto_req_done() will wakeup
 	 * crypto_wait_req(); if the backend of acomp is scomp, the callback
 	 * won't be called, crypto_wait_req() will return without blocking.
+	 * Chained requests are completed through the first one. Only those,
+	 * which zswap_compress() issues with nothing but the mutex held, are
+	 * affected by CRYPTO_TFM_REQ_MAY_SLEEP.
 	 */
-	acomp_request_set_callback(req, CRYPTO_TFM_REQ_MAY_BACKLOG,
-				   crypto_req_done, &acomp_ctx->wait);
+	for (i = 0; i < nr_reqs; i++) {
+		acomp_request_set_callback(reqs[i], CRYPTO_TFM_REQ_MAY_BACKLOG |
+						    CRYPTO_TFM_REQ_MAY_SLEEP,
+					   crypto_req_done, &acomp_ctx->wait);
+		acomp_ctx->reqs[i] = reqs[i];
+		acomp_ctx->buffers[i] = buffers[i];
+	}
 
-	acomp_ctx->buffer = buffer;
 	acomp_ctx->acomp = acomp;
 	acomp_ctx->is_sleepable = acomp_is_async(acomp);
-	acomp_ctx->req = req;
+	acomp_ctx->nr_reqs = nr_reqs;
 	mutex_unlock(&acomp_ctx->mutex);
 	return 0;
 
 fail:
-	if (acomp)
-		crypto_free_acomp(acomp);
-	kfree(buffer);
+	zswap_cpu_comp_free(acomp, reqs, buffers);
 	return ret;
 }
 
@@ -883,31 +931,31 @@ static int zswap_cpu_comp_dead(unsigned int cpu, struct hlist_node *node)
 {
 	struct zswap_pool *pool = hlist_entry(node, struct zswap_pool, node);
 	struct crypto_acomp_ctx *acomp_ctx = per_cpu_ptr(pool->acomp_ctx, cpu);
-	struct acomp_req *req;
+	struct acomp_req *reqs[ZSWAP_MAX_BATCH_SIZE];
+	u8 *buffers[ZSWAP_MAX_BATCH_SIZE];
 	struct crypto_acomp *acomp;
-	u8 *buffer;
+	unsigned int i;
 
 	if (IS_ERR_OR_NULL(acomp_ctx))
 		return 0;
 
 	mutex_lock(&acomp_ctx->mutex);
-	req = acomp_ctx->req;
+	for (i = 0; i < ZSWAP_MAX_BATCH_SIZE; i++) {
+		reqs[i] = acomp_ctx->reqs[i];
+		buffers[i] = acomp_ctx->buffers[i];
+		acomp_ctx->reqs[i] = NULL;
+		acomp_ctx->buffers[i] = NULL;
+	}
 	acomp = acomp_ctx->acomp;
-	buffer = acomp_ctx->buffer;
-	acomp_ctx->req = NULL;
 	acomp_ctx->acomp = NULL;
-	acomp_ctx->buffer = NULL;
+	acomp_ctx->nr_reqs = 0;
 	mutex_unlock(&acomp_ctx->mutex);
 
 	/*
 	 * Do the actual freeing after releasing the mutex to avoid subtle
 	 * locking dependencies causing deadlocks.
 	 */
-	if (!IS_ERR_OR_NULL(req))
-		acomp_request_free(req);
-	if (!IS_ERR_OR_NULL(acomp))
-		crypto_free_acomp(acomp);
-	kfree(buffer);
+	zswap_cpu_comp_free(acomp, reqs, buffers);
 
 	return 0;
 }
@@ -919,13 +967,13 @@ static struct crypto_acomp_ctx *acomp_ctx_get_cpu_lock(struct zswap_pool *pool)
 	for (;;) {
 		acomp_ctx = raw_cpu_ptr(pool->acomp_ctx);
 		mutex_lock(&acomp_ctx->mutex);
-		if (likely(acomp_ctx->req))
+		if (likely(acomp_ctx->reqs[0]))
 			return acomp_ctx;
 		/*
 		 * It is possible that we were migrated to a different CPU after
 		 * getting the per-CPU ctx but before the mutex was acquired. If
 		 * the old CPU got offlined, zswap_cpu_comp_dead() could have
-		 * already freed ctx->req (among other things) and set it to
+		 * already freed ctx->reqs (among other things) and set them to
 		 * NULL. Just try again on the new CPU that we ended up on.
 		 */
 		mutex_unlock(&acomp_ctx->mutex);
@@ -937,57 +985,92 @@ static void acomp_ctx_put_unlock(struct crypto_acomp_ctx *acomp_ctx)
 	mutex_unlock(&acomp_ctx->mutex);
 }
 
-static bool zswap_compress(struct page *page, struct zswap_entry *entry,
-			   struct zswap_pool *pool)
+/*
+ * Compress @nr pages of @folio starting at @index into @entries, and store
+ * them in the zpool. Up to acomp_ctx->nr_reqs pages are chained into one
+ * request, so that hardware, or several CPUs for a synchronous compressor,
+ * can compress them in parallel. Either all the entries get a handle, or
+ * none of them do.
+ */
+static bool zswap_compress(struct folio *folio, long index, unsigned int nr,
+			   struct zswap_entry **entries, struct zswap_pool *pool)
 {
 	struct crypto_acomp_ctx *acomp_ctx;
-	struct scatterlist input, output;
 	int comp_ret = 0, alloc_ret = 0;
-	unsigned int dlen = PAGE_SIZE;
+	unsigned int i, j, batch, dlen, stored = 0;
+	struct zpool *zpool = pool->zpool;
 	unsigned long handle;
-	struct zpool *zpool;
+	struct acomp_req *req;
 	gfp_t gfp;
-	u8 *dst;
 
 	acomp_ctx = acomp_ctx_get_cpu_lock(pool);
-	dst = acomp_ctx->buffer;
-	sg_init_table(&input, 1);
-	sg_set_page(&input, page, PAGE_SIZE, 0);
+	gfp = GFP_NOWAIT | __GFP_NORETRY | __GFP_HIGHMEM | __GFP_MOVABLE;
 
-	/*
-	 * We need PAGE_SIZE * 2 here since there maybe over-compression case,
-	 * and hardware-accelerators may won't check the dst buffer size, so
-	 * giving the dst buffer with enough length to avoid buffer overflow.
-	 */
-	sg_init_one(&output, dst, PAGE_SIZE * 2);
-	acomp_request_set_params(acomp_ctx->req, &input, &output, PAGE_SIZE, dlen);
+	for (i = 0; i < nr; i += batch) {
+		batch = min(nr - i, acomp_ctx->nr_reqs);
 
-	/*
-	 * it maybe looks a little bit silly that we send an asynchronous request,
-	 * then wait for its completion synchronously. This makes the process look
-	 * synchronous in fact.
-	 * Theoretically, acomp supports users send multiple acomp requests in one
-	 * acomp instance, then get those requests done simultaneously. but in this
-	 * case, zswap actually does store and load page by page, there is no
-	 * existing method to send the second page before the first page is done
-	 * in one thread doing zwap.
-	 * but in different threads running on different cpu, we have different
-	 * acomp instance, so multiple threads can do (de)compression in parallel.
-	 */
-	comp_ret = crypto_wait_req(crypto_acomp_compress(acomp_ctx->req), &acomp_ctx->wait);
-	dlen = acomp_ctx->req->dlen;
-	if (comp_ret)
-		goto unlock;
+		for (j = 0; j < batch; j++) {
+			req = acomp_ctx->reqs[j];
+			sg_init_table(&acomp_ctx->input[j], 1);
+			sg_set_page(&acomp_ctx->input[j],
+				    folio_page(folio, index + i + j), PAGE_SIZE, 0);
 
-	zpool = pool->zpool;
-	gfp = GFP_NOWAIT | __GFP_NORETRY | __GFP_HIGHMEM | __GFP_MOVABLE;
-	alloc_ret = zpool_malloc(zpool, dlen, gfp, &handle);
-	if (alloc_ret)
-		goto unlock;
+			/*
+			 * We need PAGE_SIZE * 2 here since there maybe
+			 * over-compression case, and hardware-accelerators may
+			 * won't check the dst buffer size, so giving the dst
+			 * buffer with enough length to avoid buffer overflow.
+			 */
+			sg_init_one(&acomp_ctx->output[j], acomp_ctx->buffers[j],
+				    PAGE_SIZE * 2);
+			acomp_request_set_params(req, &acomp_ctx->input[j],
+						 &acomp_ctx->output[j],
+						 PAGE_SIZE, PAGE_SIZE);
+			if (j)
+				acomp_request_chain(req, acomp_ctx->reqs[0]);
+		}
 
-	zpool_obj_write(zpool, handle, dst, dlen);
-	entry->handle = handle;
-	entry->length = dlen;
+		/*
+		 * it maybe looks a little bit silly that we send an asynchronous
+		 * request, then wait for its completion synchronously. This
+		 * makes the process look synchronous in fact.
+		 * Chained requests are processed and completed as one, so a
+		 * compressor that can work on several pages at once gets the
+		 * whole batch; the result of each page is left in its own
+		 * request. In different threads running on different cpu, we
+		 * have different acomp instance, so multiple threads can do
+		 * (de)compression in parallel.
+		 */
+		req = acomp_ctx->reqs[0];
+		comp_ret = crypto_wait_req(crypto_acomp_compress(req),
+					   &acomp_ctx->wait);
+		if (batch > 1) {
+			/* Unchain the requests again for the next user */
+			acomp_request_set_callback(req,
+						   CRYPTO_TFM_REQ_MAY_BACKLOG |
+						   CRYPTO_TFM_REQ_MAY_SLEEP,
+						   crypto_req_done,
+						   &acomp_ctx->wait);
+		}
+
+		for (j = 0; j < batch; j++) {
+			req = acomp_ctx->reqs[j];
+			if (batch > 1)
+				comp_ret = req->base.err;
+			if (comp_ret)
+				goto unlock;
+
+			dlen = req->dlen;
+			alloc_ret = zpool_malloc(zpool, dlen, gfp, &handle);
+			if (alloc_ret)
+				goto unlock;
+
+			zpool_obj_write(zpool, handle, acomp_ctx->buffers[j], dlen);
+			entries[i + j]->handle = handle;
+			entries[i + j]->length = dlen;
+			stored++;
+		}
+	}
 
 unlock:
 	if (comp_ret == -ENOSPC || alloc_ret == -ENOSPC)
@@ -998,7 +1081,14 @@ static bool zswap_compress(struct page *page, struct zswap_entry *entry,
 		zswap_reject_alloc_fail++;
 
 	acomp_ctx_put_unlock(acomp_ctx);
-	return comp_ret == 0 && alloc_ret == 0;
+
+	if (comp_ret || alloc_ret) {
+		/* Free the handles of the pages stored before the failure */
+		while (stored--)
+			zpool_free(zpool, entries[stored]->handle);
+		return false;
+	}
+	return true;
 }
 
 static bool zswap_decompress(struct zswap_entry *entry, struct folio *folio)
@@ -1010,27 +1100,27 @@ static bool zswap_decompress(struct zswap_entry *entry, struct folio *folio)
 	u8 *src, *obj;
 
 	acomp_ctx = acomp_ctx_get_cpu_lock(entry->pool);
-	obj = zpool_obj_read_begin(zpool, entry->handle, acomp_ctx->buffer);
+	obj = zpool_obj_read_begin(zpool, entry->handle, acomp_ctx->buffers[0]);
 
 	/*
 	 * zpool_obj_read_begin() might return a kmap address of highmem when
-	 * acomp_ctx->buffer is not used.  However, sg_init_one() does not
-	 * handle highmem addresses, so copy the object to acomp_ctx->buffer.
+	 * acomp_ctx->buffers[0] is not used.  However, sg_init_one() does not
+	 * handle highmem addresses, so copy the object to acomp_ctx->buffers[0].
 	 */
 	if (virt_addr_valid(obj)) {
 		src = obj;
 	} else {
-		WARN_ON_ONCE(obj == acomp_ctx->buffer);
-		memcpy(acomp_ctx->buffer, obj, entry->length);
-		src = acomp_ctx->buffer;
+		WARN_ON_ONCE(obj == acomp_ctx->buffers[0]);
+		memcpy(acomp_ctx->buffers[0], obj, entry->length);
+		src = acomp_ctx->buffers[0];
 	}
 
 	sg_init_one(&input, src, entry->length);
 	sg_init_table(&output, 1);
 	sg_set_folio(&output, folio, PAGE_SIZE, 0);
-	acomp_request_set_params(acomp_ctx->req, &input, &output, entry->length, PAGE_SIZE);
-	decomp_ret = crypto_wait_req(crypto_acomp_decompress(acomp_ctx->req), &acomp_ctx->wait);
-	dlen = acomp_ctx->req->dlen;
+	acomp_request_set_params(acomp_ctx->reqs[0], &input, &output, entry->length, PAGE_SIZE);
+	decomp_ret = crypto_wait_req(crypto_acomp_decompress(acomp_ctx->reqs[0]), &acomp_ctx->wait);
+	dlen = acomp_ctx->reqs[0]->dlen;
 
 	zpool_obj_read_end(zpool, entry->handle, obj);
 	acomp_ctx_put_unlock(acomp_ctx);
@@ -1478,81 +1568,104 @@ static void shrink_worker(struct work_struct *w)
 * main API
 **********************************/
 
-static bool zswap_store_page(struct page *page,
-			     struct obj_cgroup *objcg,
-			     struct zswap_pool *pool)
+/*
+ * Store @nr pages of @folio starting at @index. The pages are compressed in
+ * one batch; the entries are then inserted into the tree one by one. If
+ * that fails for a page, the pages before it are left in the tree for the
+ * caller to invalidate.
+ */
+static bool zswap_store_pages(struct folio *folio, long index, unsigned int nr,
+			      struct obj_cgroup *objcg,
+			      struct zswap_pool *pool)
 {
-	swp_entry_t page_swpentry = page_swap_entry(page);
+	struct zswap_entry *entries[ZSWAP_MAX_BATCH_SIZE];
+	int nid = folio_nid(folio);
 	struct zswap_entry *entry, *old;
-
-	/* allocate entry */
-	entry = zswap_entry_cache_alloc(GFP_KERNEL, page_to_nid(page));
-	if (!entry) {
-		zswap_reject_kmemcache_fail++;
-		return false;
+	unsigned int i, nr_alloc;
+
+	/* allocate entries */
+	for (nr_alloc = 0; nr_alloc < nr; nr_alloc++) {
+		entries[nr_alloc] = zswap_entry_cache_alloc(GFP_KERNEL, nid);
+		if (!entries[nr_alloc]) {
+			zswap_reject_kmemcache_fail++;
+			goto free_entries;
+		}
 	}
 
-	if (!zswap_compress(page, entry, pool))
-		goto compress_failed;
+	if (!zswap_compress(folio, index, nr, entries, pool))
+		goto free_entries;
 
-	old = xa_store(swap_zswap_tree(page_swpentry),
-		       swp_offset(page_swpentry),
-		       entry, GFP_KERNEL);
-	if (xa_is_err(old)) {
-		int err = xa_err(old);
+	for (i = 0; i < nr; i++) {
+		struct page *page = folio_page(folio, index + i);
+		swp_entry_t page_swpentry = page_swap_entry(page);
 
-		WARN_ONCE(err != -ENOMEM, "unexpected xarray error: %d\n", err);
-		zswap_reject_alloc_fail++;
-		goto store_failed;
-	}
+		entry = entries[i];
+		old = xa_store(swap_zswap_tree(page_swpentry),
+			       swp_offset(page_swpentry),
+			       entry, GFP_KERNEL);
+		if (xa_is_err(old)) {
+			int err = xa_err(old);
 
-	/*
-	 * We may have had an existing entry that became stale when
-	 * the folio was redirtied and now the new version is being
-	 * swapped out. Get rid of the old.
-	 */
-	if (old)
-		zswap_entry_free(old);
+			WARN_ONCE(err != -ENOMEM, "unexpected xarray error: %d\n", err);
+			zswap_reject_alloc_fail++;
+			goto store_failed;
+		}
 
-	/*
-	 * The entry is successfully compressed and stored in the tree, there is
-	 * no further possibility of failure. Grab refs to the pool and objcg,
-	 * charge zswap memory, and increment zswap_stored_pages.
-	 * The opposite actions will be performed by zswap_entry_free()
-	 * when the entry is removed from the tree.
-	 */
-	zswap_pool_get(pool);
-	if (objcg) {
-		obj_cgroup_get(objcg);
-		obj_cgroup_charge_zswap(objcg, entry->length);
-	}
-	atomic_long_inc(&zswap_stored_pages);
+		/*
+		 * We may have had an existing entry that became stale when
+		 * the folio was redirtied and now the new version is being
+		 * swapped out. Get rid of the old.
+		 */
+		if (old)
+			zswap_entry_free(old);
 
-	/*
-	 * We finish initializing the entry while it's already in xarray.
-	 * This is safe because:
-	 *
-	 * 1. Concurrent stores and invalidations are excluded by folio lock.
-	 *
-	 * 2. Writeback is excluded by the entry not being on the LRU yet.
-	 *    The publishing order matters to prevent writeback from seeing
-	 *    an incoherent entry.
-	 */
-	entry->pool = pool;
-	entry->swpentry = page_swpentry;
-	entry->objcg = objcg;
-	entry->referenced = true;
-	if (entry->length) {
-		INIT_LIST_HEAD(&entry->lru);
-		zswap_lru_add(&zswap_list_lru, entry);
+		/*
+		 * The entry is successfully compressed and stored in the tree,
+		 * there is no further possibility of failure. Grab refs to the
+		 * pool and objcg, charge zswap memory, and increment
+		 * zswap_stored_pages. The opposite actions will be performed
+		 * by zswap_entry_free() when the entry is removed from the tree.
+		 */
+		zswap_pool_get(pool);
+		if (objcg) {
+			obj_cgroup_get(objcg);
+			obj_cgroup_charge_zswap(objcg, entry->length);
+		}
+		atomic_long_inc(&zswap_stored_pages);
+
+		/*
+		 * We finish initializing the entry while it's already in xarray.
+		 * This is safe because:
+		 *
+		 * 1. Concurrent stores and invalidations are excluded by folio lock.
+		 *
+		 * 2. Writeback is excluded by the entry not being on the LRU yet.
+		 *    The publishing order matters to prevent writeback from seeing
+		 *    an incoherent entry.
+		 */
+		entry->pool = pool;
+		entry->swpentry = page_swpentry;
+		entry->objcg = objcg;
+		entry->referenced = true;
+		if (entry->length) {
+			INIT_LIST_HEAD(&entry->lru);
+			zswap_lru_add(&zswap_list_lru, entry);
+		}
 	}
 
 	return true;
 
 store_failed:
-	zpool_free(pool->zpool, entry->handle);
-compress_failed:
-	zswap_entry_cache_free(entry);
+	/* The entries already in the tree are freed by the caller */
+	for (; i < nr; i++) {
+		zpool_free(pool->zpool, entries[i]->handle);
+		zswap_entry_cache_free(entries[i]);
+	}
+	return false;
+
+free_entries:
+	while (nr_alloc)
+		zswap_entry_cache_free(entries[--nr_alloc]);
 	return false;
 }
 
@@ -1598,10 +1711,11 @@ bool zswap_store(struct folio *folio)
 		mem_cgroup_put(memcg);
 	}
 
-	for (index = 0; index < nr_pages; ++index) {
-		struct page *page = folio_page(folio, index);
+	for (index = 0; index < nr_pages; index += ZSWAP_MAX_BATCH_SIZE) {
+		unsigned int nr = min_t(long, nr_pages - index,
+					ZSWAP_MAX_BATCH_SIZE);
 
-		if (!zswap_store_page(page, objcg, pool))
+		if (!zswap_store_pages(folio, index, nr, objcg, pool))
 			goto put_pool;
 	}
 
@@ -3392,6 +3392,22 @@ void dev_kfree_skb_any_reason(struct sk_buff *skb, enum skb_drop_reason reason)
 }
 EXPORT_SYMBOL(dev_kfree_skb_any_reason);
 
+void dev_consume_skb_list_any(struct sk_buff *segs)
+{
+	if (in_hardirq() || irqs_disabled()) {
+		while (segs) {
+			struct sk_buff *next = segs->next;
+
+			dev_consume_skb_irq(segs);
+			segs = next;
+		}
+		return;
+	}
+
+	kfree_skb_list_reason(segs, SKB_CONSUMED);
+}
+EXPORT_SYMBOL(dev_consume_skb_list_any);
+
 
 /**
  * netif_device_detach - mark device as removed
@@ -3992,8 +4008,9 @@ static inline int __dev_xmit_skb(struct sk_buff *skb, struct Qdisc *q,
 				 struct netdev_queue *txq)
 {
 	spinlock_t *root_lock = qdisc_lock(q);
-	struct sk_buff *to_free = NULL;
-	bool contended;
+	struct llist_node *ll_list, *first_n;
+	struct sk_buff *next, *to_free = NULL;
+	unsigned long defer_count = 0;
 	int rc;
 
 	qdisc_calculate_pkt_len(skb, q);
@@ -4037,53 +4054,78 @@ static inline int __dev_xmit_skb(struct sk_buff *skb, struct Qdisc *q,
 		kfree_skb_reason(skb, SKB_DROP_REASON_TC_RECLASSIFY_LOOP);
 		return NET_XMIT_DROP;
 	}
+
 	/*
-	 * Heuristic to force contended enqueues to serialize on a
-	 * separate lock before trying to get qdisc main lock.
-	 * This permits qdisc->running owner to get the lock more
-	 * often and dequeue packets faster.
-	 * On PREEMPT_RT it is possible to preempt the qdisc owner during xmit
-	 * and then other tasks will only enqueue packets. The packets will be
-	 * sent after the qdisc owner is scheduled again. To prevent this
-	 * scenario the task always serialize on the lock.
+	 * Stage the skb on q->defer_list instead of queueing up on the root
+	 * lock.  Only the CPU that finds the list empty takes the lock, and
+	 * it enqueues everything staged meanwhile in one go, so the other
+	 * CPUs return right away and the lock is taken once per batch.
+	 * This is an open coded llist_add(), bounded by the qdisc limit;
+	 * defer_count is only bumped for a non-empty list, at most once.
 	 */
-	contended = qdisc_is_running(q) || IS_ENABLED(CONFIG_PREEMPT_RT);
-	if (unlikely(contended))
-		spin_lock(&q->busylock);
+	first_n = READ_ONCE(q->defer_list.first);
+	do {
+		if (first_n && !defer_count) {
+			defer_count = atomic_long_inc_return(&q->defer_count);
+			if (unlikely(defer_count >
+				     max_t(u32, READ_ONCE(q->limit),
+					   READ_ONCE(dev->tx_queue_len)))) {
+				kfree_skb_reason(skb, SKB_DROP_REASON_QDISC_DROP);
+				return NET_XMIT_DROP;
+			}
+		}
+		skb->ll_node.next = first_n;
+	} while (!try_cmpxchg(&q->defer_list.first, &first_n, &skb->ll_node));
+
+	/* The CPU that staged the first skb will enqueue ours, too. */
+	if (first_n)
+		return NET_XMIT_SUCCESS;
 
 	spin_lock(root_lock);
+
+	ll_list = llist_del_all(&q->defer_list);
+	/* Not atomic with llist_del_all(), so the list may slightly exceed
+	 * its bound; that only matters for how early we start dropping.
+	 */
+	atomic_long_set(&q->defer_count, 0);
+	ll_list = llist_reverse_order(ll_list);
+
 	if (unlikely(test_bit(__QDISC_STATE_DEACTIVATED, &q->state))) {
-		__qdisc_drop(skb, &to_free);
+		llist_for_each_entry_safe(skb, next, ll_list, ll_node)
+			__qdisc_drop(skb, &to_free);
 		rc = NET_XMIT_DROP;
 	} else if ((q->flags & TCQ_F_CAN_BYPASS) && !qdisc_qlen(q) &&
-		   qdisc_run_begin(q)) {
+		   !llist_next(ll_list) && qdisc_run_begin(q)) {
 		/*
 		 * This is a work-conserving queue; there are no old skbs
 		 * waiting to be sent out; and the qdisc is not running -
 		 * xmit the skb directly.
 		 */
-
+		skb = llist_entry(ll_list, struct sk_buff, ll_node);
 		qdisc_bstats_update(q, skb);
 
-		if (sch_direct_xmit(skb, q, dev, txq, root_lock, true)) {
-			if (unlikely(contended)) {
-				spin_unlock(&q->busylock);
-				contended = false;
-			}
+		if (sch_direct_xmit(skb, q, dev, txq, root_lock, true))
 			__qdisc_run(q);
-		}
 
 		qdisc_run_end(q);
 		rc = NET_XMIT_SUCCESS;
 	} else {
+		int count = 0;
+
 		WRITE_ONCE(q->owner, smp_processor_id());
-		rc = dev_qdisc_enqueue(skb, q, &to_free, txq);
+		llist_for_each_entry_safe(skb, next, ll_list, ll_node) {
+			if (next) {
+				prefetch(next);
+				skb_mark_not_on_list(skb);
+			}
+			rc = dev_qdisc_enqueue(skb, q, &to_free, txq);
+			count++;
+		}
 		WRITE_ONCE(q->owner, -1);
+		/* rc belongs to the last skb, which is ours only if alone */
+		if (count != 1)
+			rc = NET_XMIT_SUCCESS;
 		if (qdisc_run_begin(q)) {
-			if (unlikely(contended)) {
-				spin_unlock(&q->busylock);
-				contended = false;
-			}
 			__qdisc_run(q);
 			qdisc_run_end(q);
 		}
@@ -4092,8 +4134,6 @@ static inline int __dev_xmit_skb(struct sk_buff *skb, struct Qdisc *q,
 	if (unlikely(to_free))
 		kfree_skb_list_reason(to_free,
 				      tcf_get_drop_reason(to_free));
-	if (unlikely(contended))
-		spin_unlock(&q->busylock);
 	return rc;
 }
 
@@ -4658,7 +4698,14 @@ int __dev_queue_xmit(struct sk_buff *skb, struct net_device *sb_dev)
 }
 EXPORT_SYMBOL(__dev_queue_xmit);
 
-int __dev_direct_xmit(struct sk_buff *skb, u16 queue_id)
+/**
+ * __dev_direct_xmit - transmit a buffer on a given queue, bypassing qdiscs
+ * @skb: buffer to transmit
+ * @queue_id: tx queue to use
+ * @more: the caller will send another buffer on @queue_id right away and
+ *	the driver may defer its doorbell until then
+ */
+int __dev_direct_xmit(struct sk_buff *skb, u16 queue_id, bool more)
 {
 	struct net_device *dev = skb->dev;
 	struct sk_buff *orig_skb = skb;
@@ -4682,7 +4729,7 @@ int __dev_direct_xmit(struct sk_buff *skb, u16 queue_id)
 	dev_xmit_recursion_inc();
 	HARD_TX_LOCK(dev, txq, smp_processor_id());
 	if (!netif_xmit_frozen_or_drv_stopped(txq))
-		ret = netdev_start_xmit(skb, dev, txq, false);
+		ret = netdev_start_xmit(skb, dev, txq, more);
 	HARD_TX_UNLOCK(dev, txq);
 	dev_xmit_recursion_dec();
 
@@ -4798,6 +4845,52 @@ set_rps_cpu(struct net_device *dev, struct sk_buff *skb,
 	return rflow;
 }
 
+/*
+ * Load-aware RPS, enabled by net.core.rps_balance_backlog on queues that
+ * have an rps_flow_cnt table.  A flow stays on the CPU recorded in its
+ * flow table entry.  Once that CPU has more than @limit packets in its
+ * backlog, the flow tries one other CPU of the map picked at random and
+ * moves there if its backlog is shorter.  As with RFS, a flow only moves
+ * when all of its packets queued on the old CPU have been dequeued.
+ */
+static u32 rps_balance_cpu(struct rps_dev_flow_table *flow_table,
+			   const struct rps_map *map, u32 hash, u32 tcpu,
+			   int limit, struct rps_dev_flow **rflowp)
+{
+	struct rps_dev_flow *rflow;
+	unsigned int qlen;
+	u32 cpu, alt, head;
+
+	rflow = &flow_table->flows[rfs_slot(hash, flow_table)];
+	*rflowp = rflow;
+
+	cpu = READ_ONCE(rflow->cpu);
+	if (cpu >= nr_cpu_ids || !cpu_online(cpu)) {
+		cpu = tcpu;
+		goto set_cpu;
+	}
+
+	qlen = skb_queue_len_lockless(&per_cpu(softnet_data, cpu).input_pkt_queue);
+	if (qlen <= limit)
+		return cpu;
+
+	head = READ_ONCE(per_cpu(softnet_data, cpu).input_queue_head);
+	if ((int)(head - READ_ONCE(rflow->last_qtail)) < 0)
+		return cpu;
+
+	alt = map->cpus[get_random_u32_below(map->len)];
+	if (alt == cpu || !cpu_online(alt) ||
+	    skb_queue_len_lockless(&per_cpu(softnet_data, alt).input_pkt_queue) >= qlen)
+		return cpu;
+	cpu = alt;
+
+set_cpu:
+	head = READ_ONCE(per_cpu(softnet_data, cpu).input_queue_head);
+	rps_input_queue_tail_save(&rflow->last_qtail, head);
+	WRITE_ONCE(rflow->cpu, cpu);
+	return cpu;
+}
+
 /*
  * get_rps_cpu is called from netif_receive_skb and returns the target
  * CPU from the RPS map of the receiving queue for a given skb.
@@ -4889,7 +4982,12 @@ static int get_rps_cpu(struct net_device *dev, struct sk_buff *skb,
 try_rps:
 
 	if (map) {
+		int limit = READ_ONCE(net_hotdata.rps_balance_backlog);
+
 		tcpu = map->cpus[reciprocal_scale(hash, map->len)];
+		if (limit && flow_table)
+			tcpu = rps_balance_cpu(flow_table, map, hash, tcpu,
+					       limit, rflowp);
 		if (cpu_online(tcpu)) {
 			cpu = tcpu;
 			goto done;
@@ -5446,6 +5446,7 @@ static int sol_tcp_sockopt(struct sock *sk, int optname,
 	case TCP_NOTSENT_LOWAT:
 	case TCP_SAVE_SYN:
 	case TCP_RTO_MAX_MS:
+	case TCP_ACK_COALESCE_SEGS:
 		if (*optlen != sizeof(int))
 			return -EINVAL;
 		break;
@@ -1019,6 +1019,38 @@ static bool skb_pp_recycle(struct sk_buff *skb, void *data)
 	return napi_pp_put_page(page_to_netmem(virt_to_page(data)));
 }
 
+#define SKB_PP_FRAG_BULK	16
+
+/* Release the frags of a page_pool skb in bulk.  When the skb is freed
+ * away from the pool's NAPI context, the frags go back through the pool's
+ * ptr_ring, and the bulk API takes its producer lock once per pool rather
+ * than once per frag.
+ */
+static void skb_pp_frags_unref(struct skb_shared_info *shinfo)
+{
+	netmem_ref bulk[SKB_PP_FRAG_BULK];
+	u32 count = 0;
+	int i;
+
+	for (i = 0; i < shinfo->nr_frags; i++) {
+		netmem_ref netmem = skb_frag_netmem(&shinfo->frags[i]);
+
+		if (unlikely(!is_pp_netmem(netmem_compound_head(netmem)))) {
+			put_page(netmem_to_page(netmem));
+			continue;
+		}
+
+		bulk[count++] = netmem;
+		if (count == ARRAY_SIZE(bulk)) {
+			page_pool_put_netmem_bulk(bulk, count);
+			count = 0;
+		}
+	}
+
+	if (count)
+		page_pool_put_netmem_bulk(bulk, count);
+}
+
 /**
  * skb_pp_frag_ref() - Increase fragment references of a page pool aware skb
  * @skb:	page pool aware skb
@@ -1087,8 +1119,13 @@ static void skb_release_data(struct sk_buff *skb, enum skb_drop_reason reason)
 			goto free_head;
 	}
 
-	for (i = 0; i < shinfo->nr_frags; i++)
-		__skb_frag_unref(&shinfo->frags[i], skb->pp_recycle);
+	if (IS_ENABLED(CONFIG_PAGE_POOL) && skb->pp_recycle &&
+	    shinfo->nr_frags > 1) {
+		skb_pp_frags_unref(shinfo);
+	} else {
+		for (i = 0; i < shinfo->nr_frags; i++)
+			__skb_frag_unref(&shinfo->frags[i], skb->pp_recycle);
+	}
 
 free_head:
 	if (shinfo->frag_list)
@@ -515,7 +515,8 @@ static struct sk_msg *alloc_sk_msg(gfp_t gfp)
 }
 
 static struct sk_msg *sk_psock_create_ingress_msg(struct sock *sk,
-						  struct sk_buff *skb)
+						  struct sk_buff *skb,
+						  gfp_t gfp)
 {
 	if (atomic_read(&sk->sk_rmem_alloc) > sk->sk_rcvbuf)
 		return NULL;
@@ -523,7 +524,7 @@ static struct sk_msg *sk_psock_create_ingress_msg(struct sock *sk,
 	if (!sk_rmem_schedule(sk, skb, skb->truesize))
 		return NULL;
 
-	return alloc_sk_msg(GFP_KERNEL);
+	return alloc_sk_msg(gfp);
 }
 
 static int sk_psock_skb_ingress_enqueue(struct sk_buff *skb,
@@ -567,7 +568,7 @@ static int sk_psock_skb_ingress_self(struct sk_psock *psock, struct sk_buff *skb
 				     u32 off, u32 len);
 
 static int sk_psock_skb_ingress(struct sk_psock *psock, struct sk_buff *skb,
-				u32 off, u32 len)
+				u32 off, u32 len, gfp_t gfp)
 {
 	struct sock *sk = psock->sk;
 	struct sk_msg *msg;
@@ -579,7 +580,7 @@ static int sk_psock_skb_ingress(struct sk_psock *psock, struct sk_buff *skb,
 	 */
 	if (unlikely(skb->sk == sk))
 		return sk_psock_skb_ingress_self(psock, skb, off, len);
-	msg = sk_psock_create_ingress_msg(sk, skb);
+	msg = sk_psock_create_ingress_msg(sk, skb, gfp);
 	if (!msg)
 		return -EAGAIN;
 
@@ -627,12 +628,24 @@ static int sk_psock_handle_skb(struct sk_psock *psock, struct sk_buff *skb,
 		return skb_send_sock(psock->sk, skb, off, len);
 	}
 	skb_get(skb);
-	err = sk_psock_skb_ingress(psock, skb, off, len);
+	err = sk_psock_skb_ingress(psock, skb, off, len, GFP_KERNEL);
 	if (err < 0)
 		kfree_skb(skb);
 	return err;
 }
 
+static void sk_psock_skb_range(struct sk_buff *skb, u32 *off, u32 *len)
+{
+	*off = 0;
+	*len = skb->len;
+	if (skb_bpf_strparser(skb)) {
+		struct strp_msg *stm = strp_msg(skb);
+
+		*off = stm->offset;
+		*len = stm->full_len;
+	}
+}
+
 static void sk_psock_skb_state(struct sk_psock *psock,
 			       struct sk_psock_work_state *state,
 			       int len, int off)
@@ -662,14 +675,7 @@ static void sk_psock_backlog(struct work_struct *work)
 	}
 
 	while ((skb = skb_peek(&psock->ingress_skb))) {
-		len = skb->len;
-		off = 0;
-		if (skb_bpf_strparser(skb)) {
-			struct strp_msg *stm = strp_msg(skb);
-
-			off = stm->offset;
-			len = stm->full_len;
-		}
+		sk_psock_skb_range(skb, &off, &len);
 		ingress = skb_bpf_ingress(skb);
 		skb_bpf_redirect_clear(skb);
 		do {
@@ -909,10 +915,39 @@ int sk_psock_msg_verdict(struct sock *sk, struct sk_psock *psock,
 }
 EXPORT_SYMBOL_GPL(sk_psock_msg_verdict);
 
+/* Deliver an skb redirected to the ingress of another socket right away
+ * instead of through that socket's backlog work.  The target's memory
+ * accounting is serialized by its socket lock, so this is only done when
+ * the lock can be taken without waiting and is not owned by a user.
+ */
+static int sk_psock_skb_ingress_direct(struct sk_psock *psock,
+				       struct sk_buff *skb)
+{
+	unsigned long sk_redir = skb->_sk_redir;
+	struct sock *sk = psock->sk;
+	int err = -EAGAIN;
+	u32 off, len;
+
+	if (!spin_trylock_bh(&sk->sk_lock.slock))
+		return err;
+	if (!sock_owned_by_user(sk) && !sock_flag(sk, SOCK_DEAD)) {
+		sk_psock_skb_range(skb, &off, &len);
+		/* as sk_psock_backlog() does, restored for it on failure */
+		skb_bpf_redirect_clear(skb);
+		err = sk_psock_skb_ingress(psock, skb, off, len, GFP_ATOMIC);
+		if (err < 0)
+			skb->_sk_redir = sk_redir;
+	}
+	spin_unlock_bh(&sk->sk_lock.slock);
+
+	return err;
+}
+
 static int sk_psock_skb_redirect(struct sk_psock *from, struct sk_buff *skb)
 {
 	struct sk_psock *psock_other;
 	struct sock *sk_other;
+	bool direct;
 
 	sk_other = skb_bpf_redirect_fetch(skb);
 	/* This error is a buggy BPF program, it returned a redirect
@@ -941,9 +976,27 @@ static int sk_psock_skb_redirect(struct sk_psock *from, struct sk_buff *skb)
 		return -EIO;
 	}
 
-	skb_queue_tail(&psock_other->ingress_skb, skb);
-	schedule_delayed_work(&psock_other->work, 0);
+	/* Nothing queued means nothing this skb could overtake */
+	direct = skb_bpf_ingress(skb) &&
+		 skb_queue_empty(&psock_other->ingress_skb);
+	if (!direct) {
+		skb_queue_tail(&psock_other->ingress_skb, skb);
+		schedule_delayed_work(&psock_other->work, 0);
+	}
 	spin_unlock_bh(&psock_other->ingress_lock);
+
+	if (direct && sk_psock_skb_ingress_direct(psock_other, skb) < 0) {
+		spin_lock_bh(&psock_other->ingress_lock);
+		if (!sk_psock_test_state(psock_other, SK_PSOCK_TX_ENABLED)) {
+			spin_unlock_bh(&psock_other->ingress_lock);
+			skb_bpf_redirect_clear(skb);
+			sock_drop(from->sk, skb);
+			return -EIO;
+		}
+		skb_queue_tail(&psock_other->ingress_skb, skb);
+		schedule_delayed_work(&psock_other->work, 0);
+		spin_unlock_bh(&psock_other->ingress_lock);
+	}
 	return 0;
 }
 
@@ -1006,14 +1059,7 @@ static int sk_psock_verdict_apply(struct sk_psock *psock, struct sk_buff *skb,
 		 * retrying later from workqueue.
 		 */
 		if (skb_queue_empty(&psock->ingress_skb)) {
-			len = skb->len;
-			off = 0;
-			if (skb_bpf_strparser(skb)) {
-				struct strp_msg *stm = strp_msg(skb);
-
-				off = stm->offset;
-				len = stm->full_len;
-			}
+			sk_psock_skb_range(skb, &off, &len);
 			err = sk_psock_skb_ingress_self(psock, skb, off, len);
 		}
 		if (err < 0) {
@@ -772,13 +772,20 @@ EXPORT_SYMBOL(inet_csk_init_xmit_timers);
 void inet_csk_clear_xmit_timers(struct sock *sk)
 {
 	struct inet_connection_sock *icsk = inet_csk(sk);
+	struct timer_list *timers[] = {
+		&icsk->icsk_retransmit_timer,
+		&icsk->icsk_delack_timer,
+		&sk->sk_timer,
+	};
+	unsigned int stopped;
 
 	smp_store_release(&icsk->icsk_pending, 0);
 	smp_store_release(&icsk->icsk_ack.pending, 0);
 
-	sk_stop_timer(sk, &icsk->icsk_retransmit_timer);
-	sk_stop_timer(sk, &icsk->icsk_delack_timer);
-	sk_stop_timer(sk, &sk->sk_timer);
+	/* each pending timer holds a reference, see sk_stop_timer() */
+	stopped = timer_delete_many(timers, ARRAY_SIZE(timers));
+	while (stopped--)
+		__sock_put(sk);
 }
 EXPORT_SYMBOL(inet_csk_clear_xmit_timers);
 
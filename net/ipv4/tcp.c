@@ -3849,6 +3849,11 @@ int do_tcp_setsockopt(struct sock *sk, int level, int optname,
 		WRITE_ONCE(inet_csk(sk)->icsk_delack_max, delack_max);
 		return 0;
 	}
+	case TCP_ACK_COALESCE_SEGS:
+		if (val < 0 || val > TCP_ACK_COALESCE_MAX)
+			return -EINVAL;
+		WRITE_ONCE(tcp_sk(sk)->ack_coalesce_segs, val);
+		return 0;
 	}
 
 	sockopt_lock_sock(sk);
@@ -4694,6 +4699,9 @@ int do_tcp_getsockopt(struct sock *sk, int level,
 	case TCP_DELACK_MAX_US:
 		val = jiffies_to_usecs(READ_ONCE(inet_csk(sk)->icsk_delack_max));
 		break;
+	case TCP_ACK_COALESCE_SEGS:
+		val = READ_ONCE(tp->ack_coalesce_segs);
+		break;
 	default:
 		return -ENOPROTOOPT;
 	}
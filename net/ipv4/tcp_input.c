@@ -5772,6 +5772,24 @@ static inline void tcp_data_snd_check(struct sock *sk)
 	tcp_check_space(sk);
 }
 
+/* Unacknowledged data beyond which an ACK is sent right away.  By default
+ * that is one full frame, TCP_ACK_COALESCE_SEGS raises it for flows where
+ * pure ACKs are a large share of the packets.  Never sit on more than a
+ * quarter of the window, so that the sender is neither window limited
+ * nor slowed down in growing cwnd.
+ */
+static u32 tcp_ack_coalesce_bytes(const struct sock *sk)
+{
+	const struct tcp_sock *tp = tcp_sk(sk);
+	u32 mss = inet_csk(sk)->icsk_ack.rcv_mss;
+	u32 segs = READ_ONCE(tp->ack_coalesce_segs);
+
+	if (likely(segs <= 1))
+		return mss;
+
+	return max(mss, min(segs * mss, tp->rcv_wnd >> 2));
+}
+
 /*
  * Check if sending an ack is needed.
  */
@@ -5780,8 +5798,8 @@ static void __tcp_ack_snd_check(struct sock *sk, int ofo_possible)
 	struct tcp_sock *tp = tcp_sk(sk);
 	unsigned long rtt, delay;
 
-	    /* More than one full frame received... */
-	if (((tp->rcv_nxt - tp->rcv_wup) > inet_csk(sk)->icsk_ack.rcv_mss &&
+	    /* More than one full frame (or TCP_ACK_COALESCE_SEGS) received... */
+	if (((tp->rcv_nxt - tp->rcv_wup) > tcp_ack_coalesce_bytes(sk) &&
 	     /* ... and right edge of window advances far enough.
 	      * (tcp_recvmsg() will send ACK otherwise).
 	      * If application uses SO_RCVLOWAT, we want send ack now if
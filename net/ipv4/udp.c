@@ -133,11 +133,6 @@ EXPORT_PER_CPU_SYMBOL_GPL(udp_memory_per_cpu_fw_alloc);
 #define MAX_UDP_PORTS 65536
 #define PORTS_PER_CHAIN (MAX_UDP_PORTS / UDP_HTABLE_SIZE_MIN_PERNET)
 
-static struct udp_table *udp_get_table_prot(struct sock *sk)
-{
-	return sk->sk_prot->h.udp_table ? : sock_net(sk)->ipv4.udp_table;
-}
-
 static int udp_lib_lport_inuse(struct net *net, __u16 num,
 			       const struct udp_hslot *hslot,
 			       unsigned long *bitmap,
@@ -343,6 +338,7 @@ int udp_lib_get_port(struct sock *sk, unsigned short snum,
 					   &hslot2->head);
 		hslot2->count++;
 		spin_unlock(&hslot2->lock);
+		udp_table_changed(udptable, sk);
 	}
 
 	error = 0;
@@ -754,6 +750,113 @@ static inline struct sock *__udp4_lib_lookup_skb(struct sk_buff *skb,
 				 inet_sdif(skb), udptable, skb);
 }
 
+/*
+ * Receive-side cache of recent unicast lookups, per CPU.  Packets of one
+ * flow tend to arrive in bursts on the same CPU (a NAPI batch, or the
+ * segments GRO could not merge), and for a handful of heavy flows this
+ * saves the hashing and the chain walks of __udp4_lib_lookup() for most
+ * of them.  An entry stays valid as long as the generation of its local
+ * port's slot does not change, i.e. no socket on a port hashing there got
+ * (un)hashed, rehashed, connected or disconnected.  UDP sockets are freed
+ * after a grace period, and we run under rcu_read_lock().  Sockets that a
+ * reuseport BPF program or a BPF sk_lookup program steer are never cached,
+ * their choice may depend on more than the four-tuple.
+ */
+#define UDP_RCV_CACHE_SIZE	4
+
+struct udp_rcv_cache_entry {
+	const struct net	*net;
+	const struct udp_table	*table;
+	struct sock		*sk;
+	__be32			saddr;
+	__be32			daddr;
+	__be16			sport;
+	__be16			dport;
+	int			dif;
+	int			sdif;
+	unsigned int		gen;
+};
+
+struct udp_rcv_cache {
+	struct udp_rcv_cache_entry entry[UDP_RCV_CACHE_SIZE];
+};
+
+static DEFINE_PER_CPU(struct udp_rcv_cache, udp_rcv_cache);
+
+static bool udp_rcv_cacheable(struct sock *sk)
+{
+	struct sock_reuseport *reuse;
+
+	if (!sock_flag(sk, SOCK_RCU_FREE))
+		return false;
+
+	reuse = rcu_dereference(sk->sk_reuseport_cb);
+	return !reuse || !rcu_access_pointer(reuse->prog);
+}
+
+/*
+ * A new table could be allocated at the same address and reach the same
+ * generation, drop everything cached for one about to be freed.  No packet
+ * can be received in its netns anymore.
+ */
+static void __net_exit udp_rcv_cache_purge(const struct udp_table *udptable)
+{
+	int cpu, i;
+
+	for_each_possible_cpu(cpu) {
+		struct udp_rcv_cache *cache = per_cpu_ptr(&udp_rcv_cache, cpu);
+
+		for (i = 0; i < UDP_RCV_CACHE_SIZE; i++) {
+			if (cache->entry[i].table == udptable)
+				WRITE_ONCE(cache->entry[i].sk, NULL);
+		}
+	}
+}
+
+static struct sock *udp4_lib_lookup_skb_cached(struct sk_buff *skb,
+					       __be16 sport, __be16 dport,
+					       struct udp_table *udptable)
+{
+	const struct iphdr *iph = ip_hdr(skb);
+	struct net *net = dev_net(skb->dev);
+	int dif = inet_iif(skb), sdif = inet_sdif(skb);
+	struct udp_rcv_cache_entry *e;
+	unsigned int gen, idx, slot;
+	struct sock *sk;
+
+	if (static_branch_unlikely(&bpf_sk_lookup_enabled))
+		return __udp4_lib_lookup_skb(skb, sport, dport, udptable);
+
+	idx = (__force u32)(iph->saddr ^ sport) % UDP_RCV_CACHE_SIZE;
+	e = &this_cpu_ptr(&udp_rcv_cache)->entry[idx];
+	slot = udp_hashfn(net, ntohs(dport), udptable->mask);
+	gen = atomic_read_acquire(&udptable->lookup_gen[slot]);
+
+	if (e->sk && e->gen == gen && e->table == udptable && e->net == net &&
+	    e->saddr == iph->saddr && e->daddr == iph->daddr &&
+	    e->sport == sport && e->dport == dport &&
+	    e->dif == dif && e->sdif == sdif && udp_rcv_cacheable(e->sk))
+		return e->sk;
+
+	sk = __udp4_lib_lookup_skb(skb, sport, dport, udptable);
+	if (!sk || !udp_rcv_cacheable(sk)) {
+		e->sk = NULL;
+		return sk;
+	}
+
+	e->net = net;
+	e->table = udptable;
+	e->sk = sk;
+	e->saddr = iph->saddr;
+	e->daddr = iph->daddr;
+	e->sport = sport;
+	e->dport = dport;
+	e->dif = dif;
+	e->sdif = sdif;
+	e->gen = gen;
+	return sk;
+}
+
 struct sock *udp4_lib_lookup_skb(const struct sk_buff *skb,
 				 __be16 sport, __be16 dport)
 {
@@ -1921,8 +2024,29 @@ int udp_ioctl(struct sock *sk, int cmd, int *karg)
 }
 EXPORT_IPV6_MOD(udp_ioctl);
 
-struct sk_buff *__skb_recv_udp(struct sock *sk, unsigned int flags,
-			       int *off, int *err)
+/* Upper bound on the datagrams a recvmmsg() call dequeues at once */
+#define UDP_RECV_BATCH	16
+
+/* Move up to @room more datagrams to @batch, with reader_queue locked */
+static void udp_recv_fill_batch(struct sock *sk, struct sk_buff_head *queue,
+				struct sk_buff_head *batch, unsigned int room,
+				bool rx_queue_lock_held)
+{
+	unsigned int total = 0;
+	struct sk_buff *skb;
+
+	while (room-- && (skb = __skb_dequeue(queue))) {
+		total += udp_skb_truesize(skb);
+		__skb_queue_tail(batch, skb);
+	}
+	if (total)
+		udp_rmem_release(sk, total, 1, rx_queue_lock_held);
+}
+
+static struct sk_buff *__udp_recv_skbs(struct sock *sk, unsigned int flags,
+				       int *off, int *err,
+				       struct sk_buff_head *batch,
+				       unsigned int room)
 {
 	struct sk_buff_head *sk_queue = &sk->sk_receive_queue;
 	struct sk_buff_head *queue;
@@ -1945,8 +2069,13 @@ struct sk_buff *__skb_recv_udp(struct sock *sk, unsigned int flags,
 			skb = __skb_try_recv_from_queue(sk, queue, flags, off,
 							err, &last);
 			if (skb) {
-				if (!(flags & MSG_PEEK))
+				if (!(flags & MSG_PEEK)) {
 					udp_skb_destructor(sk, skb);
+					if (batch)
+						udp_recv_fill_batch(sk, queue,
+								    batch, room,
+								    false);
+				}
 				spin_unlock_bh(&queue->lock);
 				return skb;
 			}
@@ -1966,8 +2095,12 @@ struct sk_buff *__skb_recv_udp(struct sock *sk, unsigned int flags,
 
 			skb = __skb_try_recv_from_queue(sk, queue, flags, off,
 							err, &last);
-			if (skb && !(flags & MSG_PEEK))
+			if (skb && !(flags & MSG_PEEK)) {
 				udp_skb_dtor_locked(sk, skb);
+				if (batch)
+					udp_recv_fill_batch(sk, queue, batch,
+							    room, true);
+			}
 			spin_unlock(&sk_queue->lock);
 			spin_unlock_bh(&queue->lock);
 			if (skb)
@@ -1989,8 +2122,99 @@ struct sk_buff *__skb_recv_udp(struct sock *sk, unsigned int flags,
 	*err = error;
 	return NULL;
 }
+
+struct sk_buff *__skb_recv_udp(struct sock *sk, unsigned int flags,
+			       int *off, int *err)
+{
+	return __udp_recv_skbs(sk, flags, off, err, NULL, 0);
+}
 EXPORT_SYMBOL(__skb_recv_udp);
 
+/**
+ * udp_recvmsg_skb - dequeue the next datagram for a recvmsg() call
+ * @sk: socket
+ * @msg: message the datagram will be copied to
+ * @flags: MSG\_ flags
+ * @off: peek offset, as for __skb_recv_udp()
+ * @err: error code returned
+ *
+ * Within recvmmsg() (MSG_BATCH) the datagrams for the following entries
+ * are dequeued together with the first one, under a single reader_queue
+ * lock and with a single forward memory release, and handed out from
+ * @msg->msg_batch on the next calls.
+ */
+struct sk_buff *udp_recvmsg_skb(struct sock *sk, struct msghdr *msg,
+				unsigned int flags, int *off, int *err)
+{
+	struct sk_buff *skb;
+
+	if (!(flags & MSG_BATCH) || (flags & MSG_PEEK))
+		return __skb_recv_udp(sk, flags, off, err);
+
+	skb = __skb_dequeue(msg->msg_batch);
+	if (skb)
+		return skb;
+
+	/*
+	 * The peek offset is kept against the reader_queue contents, so
+	 * don't hide datagrams from concurrent peekers in the batch.
+	 */
+	if (unlikely(READ_ONCE(udp_sk(sk)->peeking_with_offset)))
+		return __skb_recv_udp(sk, flags, off, err);
+
+	return __udp_recv_skbs(sk, flags, off, err, msg->msg_batch,
+			       min_t(unsigned int, msg->msg_batch_room,
+				     UDP_RECV_BATCH - 1));
+}
+EXPORT_IPV6_MOD(udp_recvmsg_skb);
+
+/**
+ * udp_recvmsg_unbatch - put back datagrams recvmmsg() didn't hand out
+ * @sk: socket
+ * @batch: the datagrams left over in recvmmsg()'s msg_batch list
+ *
+ * The datagrams go back to the head of the reader_queue, in order, and
+ * are charged to the socket again. Should the memory no longer be
+ * available, they are dropped instead.
+ */
+void udp_recvmsg_unbatch(struct sock *sk, struct sk_buff_head *batch)
+{
+	struct udp_sock *up = udp_sk(sk);
+	struct sk_buff_head *queue = &up->reader_queue;
+	unsigned int total = 0, deficit;
+	struct sk_buff *skb;
+
+	skb_queue_walk(batch, skb)
+		total += udp_skb_truesize(skb);
+
+	spin_lock_bh(&queue->lock);
+	/* undo what udp_rmem_release() only deferred first */
+	deficit = min(total, up->forward_deficit);
+	up->forward_deficit -= deficit;
+	total -= deficit;
+
+	if (total) {
+		spin_lock(&sk->sk_receive_queue.lock);
+		if (udp_rmem_schedule(sk, total)) {
+			spin_unlock(&sk->sk_receive_queue.lock);
+			up->forward_deficit += deficit;
+			spin_unlock_bh(&queue->lock);
+			atomic_add(skb_queue_len(batch), &sk->sk_drops);
+			__skb_queue_purge(batch);
+			return;
+		}
+		sk_forward_alloc_add(sk, -total);
+		atomic_add(total, &sk->sk_rmem_alloc);
+		spin_unlock(&sk->sk_receive_queue.lock);
+	}
+	skb_queue_splice_init(batch, queue);
+	spin_unlock_bh(&queue->lock);
+
+	/* another reader may have gone to sleep while we held them */
+	sk->sk_data_ready(sk);
+}
+EXPORT_IPV6_MOD(udp_recvmsg_unbatch);
+
 int udp_read_skb(struct sock *sk, skb_read_actor_t recv_actor)
 {
 	struct sk_buff *skb;
@@ -2038,7 +2262,7 @@ int udp_recvmsg(struct sock *sk, struct msghdr *msg, size_t len, int flags,
 
 try_again:
 	off = sk_peek_offset(sk, flags);
-	skb = __skb_recv_udp(sk, flags, &off, &err);
+	skb = udp_recvmsg_skb(sk, msg, flags, &off, &err);
 	if (!skb)
 		return err;
 
@@ -2150,8 +2374,10 @@ static int udp_connect(struct sock *sk, struct sockaddr *uaddr, int addr_len)
 
 	lock_sock(sk);
 	res = __ip4_datagram_connect(sk, uaddr, addr_len);
-	if (!res)
+	if (!res) {
 		udp4_hash4(sk);
+		udp_table_changed(udp_get_table_prot(sk), sk);
+	}
 	release_sock(sk);
 	return res;
 }
@@ -2179,6 +2405,8 @@ int __udp_disconnect(struct sock *sk, int flags)
 		sk->sk_prot->unhash(sk);
 		inet->inet_sport = 0;
 	}
+	if (sk_hashed(sk))
+		udp_table_changed(udp_get_table_prot(sk), sk);
 	sk_dst_reset(sk);
 	return 0;
 }
@@ -2217,6 +2445,7 @@ void udp_lib_unhash(struct sock *sk)
 			spin_unlock(&hslot2->lock);
 
 			udp_unhash4(udptable, sk);
+			udp_table_changed(udptable, sk);
 		}
 		spin_unlock_bh(&hslot->lock);
 	}
@@ -2283,6 +2512,7 @@ void udp_lib_rehash(struct sock *sk, u16 newhash, u16 newhash4)
 
 			spin_unlock_bh(&hslot->lock);
 		}
+		udp_table_changed(udptable, sk);
 	}
 }
 EXPORT_IPV6_MOD(udp_lib_rehash);
@@ -2694,7 +2924,7 @@ int __udp4_lib_rcv(struct sk_buff *skb, struct udp_table *udptable,
 		return __udp4_lib_mcast_deliver(net, skb, uh,
 						saddr, daddr, udptable, proto);
 
-	sk = __udp4_lib_lookup_skb(skb, uh->source, uh->dest, udptable);
+	sk = udp4_lib_lookup_skb_cached(skb, uh->source, uh->dest, udptable);
 	if (sk)
 		return udp_unicast_rcv_skb(sk, skb, uh);
 no_sk:
@@ -3675,12 +3905,24 @@ static int __init set_uhash_entries(char *str)
 }
 __setup("uhash_entries=", set_uhash_entries);
 
+/* The generations follow the last of the hash tables, in the same area. */
+static void udp_table_gen_init(struct udp_table *table)
+{
+	unsigned int i;
+
+	table->lookup_gen = (void *)table->hash2 + (table->mask + 1) *
+			    (sizeof(struct udp_hslot_main) +
+			     udp_hash4_slot_size());
+	for (i = 0; i <= table->mask; i++)
+		atomic_set(&table->lookup_gen[i], 0);
+}
+
 void __init udp_table_init(struct udp_table *table, const char *name)
 {
 	unsigned int i, slot_size;
 
 	slot_size = sizeof(struct udp_hslot) + sizeof(struct udp_hslot_main) +
-		    udp_hash4_slot_size();
+		    udp_hash4_slot_size() + sizeof(atomic_t);
 	table->hash = alloc_large_system_hash(name,
 					      slot_size,
 					      uhash_entries,
@@ -3703,6 +3945,7 @@ void __init udp_table_init(struct udp_table *table, const char *name)
 		spin_lock_init(&table->hash2[i].hslot.lock);
 	}
 	udp_table_hash4_init(table);
+	udp_table_gen_init(table);
 }
 
 u32 udp_flow_hashrnd(void)
@@ -3736,7 +3979,7 @@ static struct udp_table __net_init *udp_pernet_table_alloc(unsigned int hash_ent
 		goto out;
 
 	slot_size = sizeof(struct udp_hslot) + sizeof(struct udp_hslot_main) +
-		    udp_hash4_slot_size();
+		    udp_hash4_slot_size() + sizeof(atomic_t);
 	udptable->hash = vmalloc_huge(hash_entries * slot_size,
 				      GFP_KERNEL_ACCOUNT);
 	if (!udptable->hash)
@@ -3756,6 +3999,7 @@ static struct udp_table __net_init *udp_pernet_table_alloc(unsigned int hash_ent
 		spin_lock_init(&udptable->hash2[i].hslot.lock);
 	}
 	udp_table_hash4_init(udptable);
+	udp_table_gen_init(udptable);
 
 	return udptable;
 
@@ -3772,6 +4016,7 @@ static void __net_exit udp_pernet_table_free(struct net *net)
 	if (udptable == &udp_table)
 		return;
 
+	udp_rcv_cache_purge(udptable);
 	kvfree(udptable->hash);
 	kfree(udptable);
 }
@@ -487,8 +487,12 @@ static struct sk_buff *udp_gro_receive_segment(struct list_head *head,
 	int ret = 0;
 	int flush;
 
-	/* requires non zero csum, for symmetry with GSO */
-	if (!uh->check) {
+	/* requires non zero csum, for symmetry with GSO.  Fraglist GRO keeps
+	 * the original packets and never recomputes their checksum, so it can
+	 * also take the zero-checksum IPv4 packets most UDP tunnels send.
+	 */
+	if (!uh->check &&
+	    (!NAPI_GRO_CB(skb)->is_flist || NAPI_GRO_CB(skb)->is_ipv6)) {
 		NAPI_GRO_CB(skb)->flush = 1;
 		return NULL;
 	}
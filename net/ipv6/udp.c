@@ -483,7 +483,7 @@ int udpv6_recvmsg(struct sock *sk, struct msghdr *msg, size_t len,
 
 try_again:
 	off = sk_peek_offset(sk, flags);
-	skb = __skb_recv_udp(sk, flags, &off, &err);
+	skb = udp_recvmsg_skb(sk, msg, flags, &off, &err);
 	if (!skb)
 		return err;
 
@@ -1308,8 +1308,10 @@ static int udpv6_connect(struct sock *sk, struct sockaddr *uaddr, int addr_len)
 
 	lock_sock(sk);
 	res = __ip6_datagram_connect(sk, uaddr, addr_len);
-	if (!res)
+	if (!res) {
 		udp6_hash4(sk);
+		udp_table_changed(udp_get_table_prot(sk), sk);
+	}
 	release_sock(sk);
 	return res;
 }
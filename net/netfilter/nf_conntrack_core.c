@@ -800,6 +800,95 @@ __nf_conntrack_find_get(struct net *net, const struct nf_conntrack_zone *zone,
 	return h;
 }
 
+/*
+ * Per-cpu cache of established conntracks, looked up before the hash table
+ * in resolve_normal_ct().  Each slot holds a reference on its conntrack,
+ * so the entry cannot be freed and recycled under us; dying or expired
+ * entries are dropped when hit, by the gc worker and whenever the table
+ * is cleaned up.  Slots are only ever changed with xchg()/cmpxchg(), as
+ * the output path may run preemptible and purging works on remote cpus.
+ */
+#define NF_CT_PCPU_CACHE_SIZE	8
+
+struct nf_ct_pcpu_cache {
+	struct nf_conntrack_tuple_hash *h[NF_CT_PCPU_CACHE_SIZE];
+};
+
+static DEFINE_PER_CPU(struct nf_ct_pcpu_cache, nf_ct_pcpu_cache);
+
+static struct nf_conntrack_tuple_hash **nf_ct_pcpu_cache_slot(u32 hash)
+{
+	return &raw_cpu_ptr(&nf_ct_pcpu_cache)->h[hash &
+					(NF_CT_PCPU_CACHE_SIZE - 1)];
+}
+
+static void nf_ct_pcpu_cache_evict(struct nf_conntrack_tuple_hash **slot,
+				   struct nf_conntrack_tuple_hash *h)
+{
+	if (cmpxchg(slot, h, NULL) == h)
+		nf_ct_put(nf_ct_tuplehash_to_ctrack(h));
+}
+
+static struct nf_conntrack_tuple_hash *
+nf_ct_pcpu_cache_find_get(struct net *net, const struct nf_conntrack_zone *zone,
+			  const struct nf_conntrack_tuple *tuple, u32 hash)
+{
+	struct nf_conntrack_tuple_hash **slot = nf_ct_pcpu_cache_slot(hash);
+	struct nf_conntrack_tuple_hash *h = READ_ONCE(*slot);
+	struct nf_conn *ct;
+
+	if (!h)
+		return NULL;
+
+	/* The slot reference may be dropped by a concurrent purge. */
+	ct = nf_ct_tuplehash_to_ctrack(h);
+	if (unlikely(!refcount_inc_not_zero(&ct->ct_general.use)))
+		return NULL;
+	smp_acquire__after_ctrl_dep();
+
+	if (unlikely(nf_ct_is_dying(ct) || nf_ct_is_expired(ct))) {
+		nf_ct_pcpu_cache_evict(slot, h);
+		goto out_put;
+	}
+	if (likely(nf_ct_key_equal(h, tuple, zone, net)))
+		return h;
+out_put:
+	nf_ct_put(ct);
+	return NULL;
+}
+
+static void nf_ct_pcpu_cache_add(struct nf_conntrack_tuple_hash *h, u32 hash)
+{
+	struct nf_conntrack_tuple_hash *old;
+
+	nf_conntrack_get(&nf_ct_tuplehash_to_ctrack(h)->ct_general);
+	old = xchg(nf_ct_pcpu_cache_slot(hash), h);
+	if (old)
+		nf_ct_put(nf_ct_tuplehash_to_ctrack(old));
+}
+
+/* Drop the cached entries that are dying, or all of them. */
+static void nf_ct_pcpu_cache_purge(bool all)
+{
+	int cpu, i;
+
+	for_each_possible_cpu(cpu) {
+		struct nf_ct_pcpu_cache *cache = per_cpu_ptr(&nf_ct_pcpu_cache,
+							     cpu);
+
+		for (i = 0; i < NF_CT_PCPU_CACHE_SIZE; i++) {
+			struct nf_conntrack_tuple_hash *h;
+
+			rcu_read_lock();
+			h = READ_ONCE(cache->h[i]);
+			if (h && (all ||
+				  nf_ct_is_dying(nf_ct_tuplehash_to_ctrack(h))))
+				nf_ct_pcpu_cache_evict(&cache->h[i], h);
+			rcu_read_unlock();
+		}
+	}
+}
+
 struct nf_conntrack_tuple_hash *
 nf_conntrack_find_get(struct net *net, const struct nf_conntrack_zone *zone,
 		      const struct nf_conntrack_tuple *tuple)
@@ -1615,6 +1704,7 @@ static void gc_worker(struct work_struct *work)
 	} while (i < hashsz);
 
 	gc_work->next_bucket = 0;
+	nf_ct_pcpu_cache_purge(false);
 
 	next_run = clamp(next_run, GC_SCAN_INTERVAL_MIN, GC_SCAN_INTERVAL_MAX);
 
@@ -1855,6 +1945,7 @@ resolve_normal_ct(struct nf_conn *tmpl,
 	enum ip_conntrack_info ctinfo;
 	struct nf_conntrack_zone tmp;
 	u32 hash, zone_id, rid;
+	bool cached = false;
 	struct nf_conn *ct;
 
 	if (!nf_ct_get_tuple(skb, skb_network_offset(skb),
@@ -1867,6 +1958,11 @@ resolve_normal_ct(struct nf_conn *tmpl,
 
 	zone_id = nf_ct_zone_id(zone, IP_CT_DIR_ORIGINAL);
 	hash = hash_conntrack_raw(&tuple, zone_id, state->net);
+	h = nf_ct_pcpu_cache_find_get(state->net, zone, &tuple, hash);
+	if (h) {
+		cached = true;
+		goto found;
+	}
 	h = __nf_conntrack_find_get(state->net, zone, &tuple, hash);
 
 	if (!h) {
@@ -1886,6 +1982,7 @@ resolve_normal_ct(struct nf_conn *tmpl,
 		if (IS_ERR(h))
 			return PTR_ERR(h);
 	}
+found:
 	ct = nf_ct_tuplehash_to_ctrack(h);
 
 	/* It exists; we have (non-exclusive) reference. */
@@ -1902,6 +1999,10 @@ resolve_normal_ct(struct nf_conn *tmpl,
 		else
 			ctinfo = IP_CT_NEW;
 	}
+	/* Only established flows are worth a cache slot. */
+	if (!cached && (ctinfo == IP_CT_ESTABLISHED ||
+			ctinfo == IP_CT_ESTABLISHED_REPLY))
+		nf_ct_pcpu_cache_add(h, hash);
 	nf_ct_set(skb, ct, ctinfo);
 	return 0;
 }
@@ -2363,6 +2464,8 @@ static void nf_ct_iterate_cleanup(int (*iter)(struct nf_conn *i, void *data),
 		cond_resched();
 	}
 	mutex_unlock(&nf_conntrack_mutex);
+
+	nf_ct_pcpu_cache_purge(false);
 }
 
 void nf_ct_iterate_cleanup_net(int (*iter)(struct nf_conn *i, void *data),
@@ -2450,6 +2553,7 @@ void nf_conntrack_cleanup_end(void)
 {
 	RCU_INIT_POINTER(nf_ct_hook, NULL);
 	cancel_delayed_work_sync(&conntrack_gc_work.dwork);
+	nf_ct_pcpu_cache_purge(true);
 	kvfree(nf_conntrack_hash);
 
 	nf_conntrack_proto_fini();
@@ -45,6 +45,10 @@ bool nft_set_do_lookup(const struct net *net, const struct nft_set *set,
 	if (set->ops == &nft_set_pipapo_avx2_type.ops)
 		return nft_pipapo_avx2_lookup(net, set, key, ext);
 #endif
+#if defined(CONFIG_ARM64) && defined(CONFIG_KERNEL_MODE_NEON)
+	if (set->ops == &nft_set_pipapo_neon_type.ops)
+		return nft_pipapo_neon_lookup(net, set, key, ext);
+#endif
 
 	if (set->ops == &nft_set_rbtree_type.ops)
 		return nft_rbtree_lookup(net, set, key, ext);
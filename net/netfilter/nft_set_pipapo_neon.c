@@ -0,0 +1,178 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+/* PIPAPO: PIle PAcket POlicies: NEON packet lookup routines
+ *
+ * The algorithm is the one of the generic lookup in nft_set_pipapo.c, see
+ * DOC: Theory of Operation there.  Only the intersection of lookup table
+ * buckets, which dominates lookup time for large interval sets, is done
+ * with NEON, see nft_set_pipapo_neon_inner.c.
+ */
+
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/module.h>
+#include <linux/netlink.h>
+#include <linux/netfilter.h>
+#include <linux/netfilter/nf_tables.h>
+#include <net/netfilter/nf_tables_core.h>
+#include <uapi/linux/netfilter/nf_tables.h>
+#include <linux/bitmap.h>
+#include <linux/bitops.h>
+
+#include <asm/neon.h>
+#include <asm/simd.h>
+
+#include "nft_set_pipapo_neon.h"
+#include "nft_set_pipapo.h"
+
+/* Each field has at most 4-bit groups over NFT_PIPAPO_MAX_BYTES */
+#define NFT_PIPAPO_NEON_MAX_GROUPS	(NFT_PIPAPO_MAX_BYTES * 2)
+
+/**
+ * nft_pipapo_neon_and_field() - Intersect buckets selected by packet data
+ * @f:		Field including lookup table
+ * @dst:	Area to store result
+ * @data:	Input data selecting table buckets
+ */
+static void nft_pipapo_neon_and_field(const struct nft_pipapo_field *f,
+				      unsigned long *dst, const u8 *data)
+{
+	const unsigned long *rows[NFT_PIPAPO_NEON_MAX_GROUPS];
+	unsigned long *lt = NFT_PIPAPO_LT_ALIGN(f->lt);
+	unsigned int stride = f->bsize * NFT_PIPAPO_BUCKETS(f->bb);
+	int group;
+
+	for (group = 0; group < f->groups; group++, lt += stride) {
+		u8 v;
+
+		if (f->bb == 8)
+			v = data[group];
+		else if (group % 2)
+			v = data[group / 2] & 0x0f;
+		else
+			v = data[group / 2] >> 4;
+
+		rows[group] = lt + v * f->bsize;
+	}
+	NFT_PIPAPO_GROUP_BITS_ARE_8_OR_4;
+
+	nft_pipapo_neon_and(dst, rows, f->groups, f->bsize);
+}
+
+/**
+ * nft_pipapo_neon_estimate() - Set size, space and lookup complexity
+ * @desc:	Set description, element count and field description used
+ * @features:	Flags: NFT_SET_INTERVAL needs to be there
+ * @est:	Storage for estimation data
+ *
+ * Return: true if set is compatible and NEON available, false otherwise.
+ */
+bool nft_pipapo_neon_estimate(const struct nft_set_desc *desc, u32 features,
+			      struct nft_set_estimate *est)
+{
+	if (!(features & NFT_SET_INTERVAL) ||
+	    desc->field_count < NFT_PIPAPO_MIN_FIELDS)
+		return false;
+
+	if (!cpu_has_neon())
+		return false;
+
+	est->size = pipapo_estimate_size(desc);
+	if (!est->size)
+		return false;
+
+	est->lookup = NFT_SET_CLASS_O_LOG_N;
+
+	est->space = NFT_SET_CLASS_O_N;
+
+	return true;
+}
+
+/**
+ * nft_pipapo_neon_lookup() - Lookup function for NEON implementation
+ * @net:	Network namespace
+ * @set:	nftables API set representation
+ * @key:	nftables API element representation containing key data
+ * @ext:	nftables API extension pointer, filled with matching reference
+ *
+ * Falls back to the generic implementation if NEON can't be used in the
+ * current context.
+ *
+ * Return: true on match, false otherwise.
+ */
+bool nft_pipapo_neon_lookup(const struct net *net, const struct nft_set *set,
+			    const u32 *key, const struct nft_set_ext **ext)
+{
+	struct nft_pipapo *priv = nft_set_priv(set);
+	struct nft_pipapo_scratch *scratch;
+	unsigned long *res_map, *fill_map;
+	u8 genmask = nft_genmask_cur(net);
+	const struct nft_pipapo_match *m;
+	const struct nft_pipapo_field *f;
+	const u8 *rp = (const u8 *)key;
+	bool map_index, ret = false;
+	int i;
+
+	if (unlikely(!may_use_simd()))
+		return nft_pipapo_lookup(net, set, key, ext);
+
+	local_bh_disable();
+
+	m = rcu_dereference(priv->match);
+
+	if (unlikely(!m || !*raw_cpu_ptr(m->scratch))) {
+		local_bh_enable();
+		return false;
+	}
+
+	scratch = *raw_cpu_ptr(m->scratch);
+
+	map_index = scratch->map_index;
+
+	res_map  = scratch->map + (map_index ? m->bsize_max : 0);
+	fill_map = scratch->map + (map_index ? 0 : m->bsize_max);
+
+	pipapo_resmap_init(m, res_map);
+
+	kernel_neon_begin();
+
+	nft_pipapo_for_each_field(f, i, m) {
+		bool last = i == m->field_count - 1;
+		int b;
+
+		nft_pipapo_neon_and_field(f, res_map, rp);
+
+		rp += f->groups / NFT_PIPAPO_GROUPS_PER_BYTE(f);
+
+next_match:
+		b = pipapo_refill(res_map, f->bsize, f->rules, fill_map, f->mt,
+				  last);
+		if (b < 0)
+			break;
+
+		if (last) {
+			*ext = &f->mt[b].e->ext;
+			if (unlikely(nft_set_elem_expired(*ext) ||
+				     !nft_set_elem_active(*ext, genmask)))
+				goto next_match;
+
+			/* As in nft_pipapo_lookup(), the inactive bitmap is
+			 * clean and can be reused for the next packet.
+			 */
+			ret = true;
+			break;
+		}
+
+		map_index = !map_index;
+		swap(res_map, fill_map);
+
+		rp += NFT_PIPAPO_GROUPS_PADDING(f);
+	}
+
+	kernel_neon_end();
+
+	scratch->map_index = map_index;
+	local_bh_enable();
+
+	return ret;
+}
@@ -0,0 +1,19 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef _NFT_SET_PIPAPO_NEON_H
+#define _NFT_SET_PIPAPO_NEON_H
+
+#if defined(CONFIG_ARM64) && defined(CONFIG_KERNEL_MODE_NEON)
+#include <linux/types.h>
+
+struct nft_set_desc;
+struct nft_set_estimate;
+
+bool nft_pipapo_neon_estimate(const struct nft_set_desc *desc, u32 features,
+			      struct nft_set_estimate *est);
+
+/* in nft_set_pipapo_neon_inner.c, call between kernel_neon_{begin,end}() */
+void nft_pipapo_neon_and(unsigned long *dst, const unsigned long **rows,
+			 unsigned int groups, unsigned int bsize);
+#endif /* defined(CONFIG_ARM64) && defined(CONFIG_KERNEL_MODE_NEON) */
+
+#endif /* _NFT_SET_PIPAPO_NEON_H */
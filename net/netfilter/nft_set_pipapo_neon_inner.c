@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+/* PIPAPO: PIle PAcket POlicies: NEON bucket intersection
+ *
+ * Built with FP/SIMD code generation enabled: only to be called between
+ * kernel_neon_begin() and kernel_neon_end().
+ */
+
+#include <linux/types.h>
+#include <asm/neon-intrinsics.h>
+
+#include "nft_set_pipapo_neon.h"
+
+/**
+ * nft_pipapo_neon_and() - AND lookup table buckets of all groups into dst
+ * @dst:	Result bitmap, @bsize longs, updated in place
+ * @rows:	Selected bucket of each group, @bsize longs each
+ * @groups:	Number of groups in the field
+ * @bsize:	Bucket size in longs
+ *
+ * The result is kept in a register across all groups, so that each 128-bit
+ * chunk of @dst is loaded and stored once per field rather than once per
+ * group, as __bitmap_and() in the generic implementation does.
+ */
+void nft_pipapo_neon_and(unsigned long *dst, const unsigned long **rows,
+			 unsigned int groups, unsigned int bsize)
+{
+	unsigned int i, g;
+
+	for (i = 0; i + 2 <= bsize; i += 2) {
+		uint64x2_t acc = vld1q_u64((const u64 *)dst + i);
+
+		for (g = 0; g < groups; g++)
+			acc = vandq_u64(acc, vld1q_u64((const u64 *)rows[g] + i));
+
+		vst1q_u64((u64 *)dst + i, acc);
+	}
+
+	if (i < bsize) {
+		unsigned long acc = dst[i];
+
+		for (g = 0; g < groups; g++)
+			acc &= rows[g][i];
+
+		dst[i] = acc;
+	}
+}
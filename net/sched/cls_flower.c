@@ -113,10 +113,20 @@ struct fl_flow_tmplt {
 	struct tcf_chain *chain;
 };
 
+/* Union of the dissectors and ranges of all masks of a classifier instance,
+ * so that a packet only needs to be dissected once per classification.
+ */
+struct fl_flow_dissect {
+	struct flow_dissector dissector;
+	struct fl_flow_mask_range range;
+	struct rcu_head rcu;
+};
+
 struct cls_fl_head {
 	struct rhashtable ht;
 	spinlock_t masks_lock; /* Protect masks list */
 	struct list_head masks;
+	struct fl_flow_dissect __rcu *dissect;
 	struct list_head hw_filters;
 	struct rcu_work rwork;
 	struct idr handle_idr;
@@ -215,12 +225,6 @@ static bool fl_mask_fits_tmplt(struct fl_flow_tmplt *tmplt,
 	return true;
 }
 
-static void fl_clear_masked_range(struct fl_flow_key *key,
-				  struct fl_flow_mask *mask)
-{
-	memset(fl_key_get_start(key, mask), 0, fl_mask_range(mask));
-}
-
 static bool fl_range_port_dst_cmp(struct cls_fl_filter *filter,
 				  struct fl_flow_key *key,
 				  struct fl_flow_key *mkey)
@@ -321,34 +325,67 @@ static u16 fl_ct_info_to_flower_map[] = {
 					TCA_FLOWER_KEY_CT_FLAGS_NEW,
 };
 
+static void fl_dissect(struct sk_buff *skb, struct flow_dissector *dissector,
+		       const struct fl_flow_mask_range *range,
+		       struct fl_flow_key *skb_key)
+{
+	bool post_ct = tc_skb_cb(skb)->post_ct;
+	u16 zone = tc_skb_cb(skb)->zone;
+
+	flow_dissector_init_keys(&skb_key->control, &skb_key->basic);
+	memset((u8 *)skb_key + range->start, 0, range->end - range->start);
+
+	skb_flow_dissect_meta(skb, dissector, skb_key);
+	/* skb_flow_dissect() does not set n_proto in case an unknown
+	 * protocol, so do it rather here.
+	 */
+	skb_key->basic.n_proto = skb_protocol(skb, false);
+	skb_flow_dissect_tunnel_info(skb, dissector, skb_key);
+	skb_flow_dissect_ct(skb, dissector, skb_key,
+			    fl_ct_info_to_flower_map,
+			    ARRAY_SIZE(fl_ct_info_to_flower_map),
+			    post_ct, zone);
+	skb_flow_dissect_hash(skb, dissector, skb_key);
+	skb_flow_dissect(skb, dissector, skb_key,
+			 FLOW_DISSECTOR_F_STOP_BEFORE_ENCAP);
+}
+
+static bool fl_dissect_covers(const struct fl_flow_dissect *dissect,
+			      const struct fl_flow_mask *mask)
+{
+	return !(mask->dissector.used_keys & ~dissect->dissector.used_keys) &&
+	       mask->range.start >= dissect->range.start &&
+	       mask->range.end <= dissect->range.end;
+}
+
 TC_INDIRECT_SCOPE int fl_classify(struct sk_buff *skb,
 				  const struct tcf_proto *tp,
 				  struct tcf_result *res)
 {
 	struct cls_fl_head *head = rcu_dereference_bh(tp->root);
-	bool post_ct = tc_skb_cb(skb)->post_ct;
-	u16 zone = tc_skb_cb(skb)->zone;
+	struct fl_flow_dissect *dissect;
 	struct fl_flow_key skb_key;
 	struct fl_flow_mask *mask;
 	struct cls_fl_filter *f;
 
-	list_for_each_entry_rcu(mask, &head->masks, list) {
-		flow_dissector_init_keys(&skb_key.control, &skb_key.basic);
-		fl_clear_masked_range(&skb_key, mask);
+	/* All masks share the fl_flow_key layout and each lookup only looks
+	 * at the bits its own mask covers, so the key dissected with the
+	 * union of the masks' dissectors is valid for every one of them.
+	 */
+	dissect = rcu_dereference_bh(head->dissect);
+	if (dissect)
+		fl_dissect(skb, &dissect->dissector, &dissect->range, &skb_key);
 
-		skb_flow_dissect_meta(skb, &mask->dissector, &skb_key);
-		/* skb_flow_dissect() does not set n_proto in case an unknown
-		 * protocol, so do it rather here.
+	list_for_each_entry_rcu(mask, &head->masks, list) {
+		/* A mask added after we loaded the union isn't covered by it.
+		 * Dissecting for it clears its range, so stay per mask from
+		 * there on.
 		 */
-		skb_key.basic.n_proto = skb_protocol(skb, false);
-		skb_flow_dissect_tunnel_info(skb, &mask->dissector, &skb_key);
-		skb_flow_dissect_ct(skb, &mask->dissector, &skb_key,
-				    fl_ct_info_to_flower_map,
-				    ARRAY_SIZE(fl_ct_info_to_flower_map),
-				    post_ct, zone);
-		skb_flow_dissect_hash(skb, &mask->dissector, &skb_key);
-		skb_flow_dissect(skb, &mask->dissector, &skb_key,
-				 FLOW_DISSECTOR_F_STOP_BEFORE_ENCAP);
+		if (dissect && !fl_dissect_covers(dissect, mask))
+			dissect = NULL;
+		if (!dissect)
+			fl_dissect(skb, &mask->dissector, &mask->range,
+				   &skb_key);
 
 		f = fl_mask_lookup(mask, &skb_key);
 		if (f && !tc_skip_sw(f->flags)) {
@@ -402,6 +439,58 @@ static void fl_uninit_mask_free_work(struct work_struct *work)
 	fl_mask_free(mask, false);
 }
 
+/* Rebuild the union dissector of @head from its masks plus @newmask, which
+ * is about to be added to the list.  The union is published before a new
+ * mask becomes visible and after a removed one is gone, but a reader may
+ * still pair an older union with a newer mask, so fl_classify() checks
+ * that each mask is covered.  If the union cannot be allocated,
+ * classification falls back to dissecting once per mask.
+ */
+static void fl_dissect_add_mask(struct fl_flow_dissect *dissect,
+				const struct fl_flow_mask *mask)
+{
+	int key;
+
+	dissect->dissector.used_keys |= mask->dissector.used_keys;
+	for (key = 0; key < FLOW_DISSECTOR_KEY_MAX; key++) {
+		if (dissector_uses_key(&mask->dissector, key))
+			dissect->dissector.offset[key] =
+				mask->dissector.offset[key];
+	}
+	dissect->range.start = min(dissect->range.start, mask->range.start);
+	dissect->range.end = max(dissect->range.end, mask->range.end);
+}
+
+static void fl_update_dissect(struct cls_fl_head *head,
+			      struct fl_flow_mask *newmask)
+{
+	struct fl_flow_dissect *old, *new = NULL;
+	struct fl_flow_mask *mask;
+
+	lockdep_assert_held(&head->masks_lock);
+	old = rcu_dereference_protected(head->dissect,
+					lockdep_is_held(&head->masks_lock));
+
+	if (newmask || !list_empty(&head->masks)) {
+		new = kzalloc(sizeof(*new), GFP_ATOMIC);
+		/* A stale union still covers all remaining masks. */
+		if (!new && !newmask)
+			return;
+	}
+
+	if (new) {
+		new->range.start = sizeof(struct fl_flow_key);
+		list_for_each_entry(mask, &head->masks, list)
+			fl_dissect_add_mask(new, mask);
+		if (newmask)
+			fl_dissect_add_mask(new, newmask);
+	}
+
+	rcu_assign_pointer(head->dissect, new);
+	if (old)
+		kfree_rcu(old, rcu);
+}
+
 static bool fl_mask_put(struct cls_fl_head *head, struct fl_flow_mask *mask)
 {
 	if (!refcount_dec_and_test(&mask->refcnt))
@@ -411,6 +500,7 @@ static bool fl_mask_put(struct cls_fl_head *head, struct fl_flow_mask *mask)
 
 	spin_lock(&head->masks_lock);
 	list_del_rcu(&mask->list);
+	fl_update_dissect(head, NULL);
 	spin_unlock(&head->masks_lock);
 
 	tcf_queue_work(&mask->rwork, fl_mask_free_work);
@@ -592,6 +682,7 @@ static void fl_destroy_sleepable(struct work_struct *work)
 						rwork);
 
 	rhashtable_destroy(&head->ht);
+	kfree(rcu_dereference_protected(head->dissect, 1));
 	kfree(head);
 	module_put(THIS_MODULE);
 }
@@ -2264,6 +2355,7 @@ static struct fl_flow_mask *fl_create_new_mask(struct cls_fl_head *head,
 		goto errout_destroy;
 
 	spin_lock(&head->masks_lock);
+	fl_update_dissect(head, newmask);
 	list_add_tail_rcu(&newmask->list, &head->masks);
 	spin_unlock(&head->masks_lock);
 
@@ -98,6 +98,7 @@
 #include <net/cls_cgroup.h>
 
 #include <net/sock.h>
+#include <net/udp.h>
 #include <linux/netfilter.h>
 
 #include <linux/if_tun.h>
@@ -2225,6 +2226,7 @@ int __sys_recvfrom(int fd, void __user *ubuf, size_t size, unsigned int flags,
 	if (unlikely(!sock))
 		return -ENOTSOCK;
 
+	flags &= ~MSG_BATCH;
 	if (sock->file->f_flags & O_NONBLOCK)
 		flags |= MSG_DONTWAIT;
 	err = sock_recvmsg(sock, &msg, flags);
@@ -2858,7 +2860,7 @@ long __sys_recvmsg(int fd, struct user_msghdr __user *msg, unsigned int flags,
 	if (unlikely(!sock))
 		return -ENOTSOCK;
 
-	return ___sys_recvmsg(sock, msg, &msg_sys, flags, 0);
+	return ___sys_recvmsg(sock, msg, &msg_sys, flags & ~MSG_BATCH, 0);
 }
 
 SYSCALL_DEFINE3(recvmsg, int, fd, struct user_msghdr __user *, msg,
@@ -2880,6 +2882,7 @@ static int do_recvmmsg(int fd, struct mmsghdr __user *mmsg,
 	struct mmsghdr __user *entry;
 	struct compat_mmsghdr __user *compat_entry;
 	struct msghdr msg_sys;
+	struct sk_buff_head batch;
 	struct timespec64 end_time;
 	struct timespec64 timeout64;
 
@@ -2907,7 +2910,20 @@ static int do_recvmmsg(int fd, struct mmsghdr __user *mmsg,
 	entry = mmsg;
 	compat_entry = (struct compat_mmsghdr __user *)mmsg;
 
+	/*
+	 * Let the protocol dequeue several datagrams at once and hand them
+	 * out to the following entries from msg_sys.msg_batch. Only UDP
+	 * knows about it; other protocols may reject unknown flags.
+	 */
+	__skb_queue_head_init(&batch);
+	flags &= ~MSG_BATCH;
+	if (vlen > 1 && sk_is_udp(sock->sk))
+		flags |= MSG_BATCH;
+
 	while (datagrams < vlen) {
+		msg_sys.msg_batch = &batch;
+		msg_sys.msg_batch_room = vlen - datagrams - 1;
+
 		/*
 		 * No need to ask LSM for more than the first datagram.
 		 */
@@ -2943,11 +2959,13 @@ static int do_recvmmsg(int fd, struct mmsghdr __user *mmsg,
 			*timeout = timespec64_sub(end_time, timeout64);
 			if (timeout->tv_sec < 0) {
 				timeout->tv_sec = timeout->tv_nsec = 0;
-				break;
+				if (skb_queue_empty(&batch))
+					break;
 			}
 
 			/* Timeout, return less than vlen datagrams */
-			if (timeout->tv_nsec == 0 && timeout->tv_sec == 0)
+			if (timeout->tv_nsec == 0 && timeout->tv_sec == 0 &&
+			    skb_queue_empty(&batch))
 				break;
 		}
 
@@ -2957,6 +2975,10 @@ static int do_recvmmsg(int fd, struct mmsghdr __user *mmsg,
 		cond_resched();
 	}
 
+	/* Datagrams already dequeued for entries we could not fill */
+	if (IS_ENABLED(CONFIG_INET) && unlikely(!skb_queue_empty(&batch)))
+		udp_recvmsg_unbatch(sock->sk, &batch);
+
 	if (err == 0)
 		return datagrams;
 
@@ -38,12 +38,13 @@
 
 static void svc_unregister(const struct svc_serv *serv, struct net *net);
 
-#define SVC_POOL_DEFAULT	SVC_POOL_GLOBAL
+#define SVC_POOL_DEFAULT	SVC_POOL_NUMA
 
 /*
  * Mode for mapping cpus to pools.
  */
 enum {
+	SVC_POOL_NUMA = -2,	/* pernode on NUMA machines, else global */
 	SVC_POOL_AUTO = -1,	/* choose one of the others */
 	SVC_POOL_GLOBAL,	/* no mapping, just a single global pool
 				 * (legacy & UP mode) */
@@ -82,6 +83,8 @@ __param_set_pool_mode(const char *val, struct svc_pool_map *m)
 	err = 0;
 	if (!strncmp(val, "auto", 4))
 		mode = SVC_POOL_AUTO;
+	else if (!strncmp(val, "numa", 4))
+		mode = SVC_POOL_NUMA;
 	else if (!strncmp(val, "global", 6))
 		mode = SVC_POOL_GLOBAL;
 	else if (!strncmp(val, "percpu", 6))
@@ -133,6 +136,8 @@ sunrpc_get_pool_mode(char *buf, size_t size)
 
 	switch (m->mode)
 	{
+	case SVC_POOL_NUMA:
+		return snprintf(buf, size, "numa");
 	case SVC_POOL_AUTO:
 		return snprintf(buf, size, "auto");
 	case SVC_POOL_GLOBAL:
@@ -301,6 +306,9 @@ svc_pool_map_get(void)
 
 	if (m->mode == SVC_POOL_AUTO)
 		m->mode = svc_pool_map_choose_mode();
+	else if (m->mode == SVC_POOL_NUMA)
+		m->mode = nr_online_nodes > 1 ? SVC_POOL_PERNODE :
+						SVC_POOL_GLOBAL;
 
 	switch (m->mode) {
 	case SVC_POOL_PERCPU:
@@ -392,7 +400,9 @@ svc_pool_map_set_cpumask(struct task_struct *task, unsigned int pidx)
  *
  * Use the active CPU and the svc_pool_map's mode setting to
  * select the svc thread pool to use. Once initialized, the
- * svc_pool_map does not change.
+ * svc_pool_map does not change. A pool without threads is
+ * skipped in favour of the next one that has some, so that
+ * work is not stranded when there are fewer threads than pools.
  *
  * Return value:
  *   A pointer to an svc_pool
@@ -401,7 +411,8 @@ struct svc_pool *svc_pool_for_cpu(struct svc_serv *serv)
 {
 	struct svc_pool_map *m = &svc_pool_map;
 	int cpu = raw_smp_processor_id();
-	unsigned int pidx = 0;
+	unsigned int pidx = 0, i;
+	struct svc_pool *pool;
 
 	if (serv->sv_nrpools <= 1)
 		return serv->sv_pools;
@@ -415,6 +426,11 @@ struct svc_pool *svc_pool_for_cpu(struct svc_serv *serv)
 		break;
 	}
 
+	for (i = 0; i < serv->sv_nrpools; i++) {
+		pool = &serv->sv_pools[(pidx + i) % serv->sv_nrpools];
+		if (READ_ONCE(pool->sp_nrthreads))
+			return pool;
+	}
 	return &serv->sv_pools[pidx % serv->sv_nrpools];
 }
 
@@ -530,6 +530,19 @@ static int tls_encrypt_async_wait(struct tls_sw_context_tx *ctx)
 	return ctx->async_wait.err;
 }
 
+/* Transmit if any encryptions have completed.  tls_encrypt_done() only
+ * schedules tx_work, which cannot get the socket while we hold it.
+ */
+static void tls_tx_completed_records(struct sock *sk, int flags)
+{
+	struct tls_sw_context_tx *ctx = tls_sw_ctx_tx(tls_get_ctx(sk));
+
+	if (test_and_clear_bit(BIT_TX_SCHEDULED, &ctx->tx_bitmask)) {
+		cancel_delayed_work(&ctx->tx_work.work);
+		tls_tx_records(sk, flags);
+	}
+}
+
 static int tls_do_encryption(struct sock *sk,
 			     struct tls_context *tls_ctx,
 			     struct tls_sw_context_tx *ctx,
@@ -1180,6 +1193,13 @@ static int tls_sw_sendmsg_locked(struct sock *sk, struct msghdr *msg,
 					goto send_end;
 				}
 			}
+
+			/* With async crypto, send the records that are ready
+			 * while the rest of a large write is still encrypting,
+			 * rather than after all of it has been submitted.
+			 */
+			if (num_async && msg_data_left(msg))
+				tls_tx_completed_records(sk, msg->msg_flags);
 		}
 
 		continue;
@@ -1212,11 +1232,7 @@ static int tls_sw_sendmsg_locked(struct sock *sk, struct msghdr *msg,
 		}
 	}
 
-	/* Transmit if any encryptions have completed */
-	if (test_and_clear_bit(BIT_TX_SCHEDULED, &ctx->tx_bitmask)) {
-		cancel_delayed_work(&ctx->tx_work.work);
-		tls_tx_records(sk, msg->msg_flags);
-	}
+	tls_tx_completed_records(sk, msg->msg_flags);
 
 send_end:
 	ret = sk_stream_error(sk, msg->msg_flags, ret);
@@ -1293,11 +1309,7 @@ void tls_sw_splice_eof(struct socket *sock)
 	if (tls_encrypt_async_wait(ctx))
 		goto unlock;
 
-	/* Transmit if any encryptions have completed */
-	if (test_and_clear_bit(BIT_TX_SCHEDULED, &ctx->tx_bitmask)) {
-		cancel_delayed_work(&ctx->tx_work.work);
-		tls_tx_records(sk, 0);
-	}
+	tls_tx_completed_records(sk, 0);
 
 unlock:
 	release_sock(sk);
@@ -85,6 +85,7 @@
 #include <linux/file.h>
 #include <linux/filter.h>
 #include <linux/fs.h>
+#include <linux/in.h>
 #include <linux/init.h>
 #include <linux/kernel.h>
 #include <linux/mount.h>
@@ -634,6 +635,8 @@ static void unix_sock_destructor(struct sock *sk)
 	struct unix_sock *u = unix_sk(sk);
 
 	skb_queue_purge_reason(&sk->sk_receive_queue, SKB_DROP_REASON_SOCKET_CLOSE);
+	/* MSG_ZEROCOPY completions nobody read */
+	skb_queue_purge(&sk->sk_error_queue);
 
 	DEBUG_NET_WARN_ON_ONCE(refcount_read(&sk->sk_wmem_alloc));
 	DEBUG_NET_WARN_ON_ONCE(!sk_unhashed(sk));
@@ -2229,6 +2232,7 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 			       size_t len)
 {
 	struct sock *sk = sock->sk;
+	struct ubuf_info *uarg = NULL;
 	struct sk_buff *skb = NULL;
 	struct sock *other = NULL;
 	struct scm_cookie scm;
@@ -2241,6 +2245,16 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 
 	wait_for_unix_gc(scm.fp);
 
+	if ((msg->msg_flags & MSG_ZEROCOPY) && len &&
+	    !(msg->msg_flags & MSG_SPLICE_PAGES) &&
+	    sock_flag(sk, SOCK_ZEROCOPY)) {
+		uarg = msg_zerocopy_realloc(sk, len, NULL);
+		if (!uarg) {
+			err = -ENOBUFS;
+			goto out_err;
+		}
+	}
+
 	if (msg->msg_flags & MSG_OOB) {
 		err = -EOPNOTSUPP;
 #if IS_ENABLED(CONFIG_AF_UNIX_OOB)
@@ -2273,6 +2287,11 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 			skb = sock_alloc_send_pskb(sk, 0, 0,
 						   msg->msg_flags & MSG_DONTWAIT,
 						   &err, 0);
+		} else if (uarg) {
+			size = min_t(int, size, (READ_ONCE(sk->sk_sndbuf) >> 1) - 64);
+			skb = sock_alloc_send_pskb(sk, 0, 0,
+						   msg->msg_flags & MSG_DONTWAIT,
+						   &err, 0);
 		} else {
 			/* Keep two messages in the pipe so it schedules better */
 			size = min_t(int, size, (READ_ONCE(sk->sk_sndbuf) >> 1) - 64);
@@ -2307,6 +2326,18 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 
 			size = err;
 			refcount_add(size, &sk->sk_wmem_alloc);
+		} else if (uarg) {
+			/* The user pages are referenced, not copied, until the
+			 * receiver has consumed the skb.  They are charged to
+			 * sk_wmem_alloc through the skb truesize.
+			 */
+			err = __zerocopy_sg_from_iter(msg, NULL, skb,
+						      &msg->msg_iter, size);
+			if (err && !(err == -EMSGSIZE && skb->len))
+				goto out_free;
+
+			size = skb->len;
+			skb_zcopy_set(skb, uarg, NULL);
 		} else {
 			skb_put(skb, size - data_len);
 			skb->data_len = data_len;
@@ -2340,6 +2371,7 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 #endif
 
 	scm_destroy(&scm);
+	net_zcopy_put(uarg);
 
 	return sent;
 
@@ -2353,6 +2385,10 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 	consume_skb(skb);
 out_err:
 	scm_destroy(&scm);
+	if (sent)
+		net_zcopy_put(uarg);
+	else
+		net_zcopy_put_abort(uarg, true);
 	return sent ? : err;
 }
 
@@ -2971,11 +3007,17 @@ static int unix_stream_recvmsg(struct socket *sock, struct msghdr *msg,
 		.size = size,
 		.flags = flags
 	};
-
 #ifdef CONFIG_BPF_SYSCALL
 	struct sock *sk = sock->sk;
 	const struct proto *prot = READ_ONCE(sk->sk_prot);
+#endif
+
+	/* MSG_ZEROCOPY completions of this socket's own sends */
+	if (unlikely(flags & MSG_ERRQUEUE))
+		return sock_recv_errqueue(sock->sk, msg, size, SOL_IP,
+					  IP_RECVERR);
 
+#ifdef CONFIG_BPF_SYSCALL
 	if (prot != &unix_stream_proto)
 		return prot->recvmsg(sk, msg, size, flags, NULL);
 #endif
@@ -2986,6 +3028,12 @@ static int unix_stream_splice_actor(struct sk_buff *skb,
 				    int skip, int chunk,
 				    struct unix_stream_read_state *state)
 {
+	/* Pages spliced into a pipe outlive the skb, so MSG_ZEROCOPY pages
+	 * the sender may reuse after its completion are copied first.
+	 */
+	if (skb_orphan_frags_rx(skb, GFP_KERNEL))
+		return -ENOMEM;
+
 	return skb_splice_bits(skb, state->socket->sk,
 			       UNIXCB(skb).consumed + skip,
 			       state->pipe, chunk, state->splice_flags);
@@ -775,10 +775,32 @@ static struct sk_buff *xsk_build_skb(struct xdp_sock *xs,
 	return ERR_PTR(err);
 }
 
+static int xsk_direct_xmit(struct xdp_sock *xs, struct sk_buff *skb, bool more)
+{
+	int err;
+
+	err = __dev_direct_xmit(skb, xs->queue_id, more);
+	if  (err == NETDEV_TX_BUSY) {
+		/* Tell user-space to retry the send */
+		xskq_cons_cancel_n(xs->tx, xsk_get_num_desc(skb));
+		xsk_consume_skb(skb);
+		return -EAGAIN;
+	}
+
+	/* Ignore NET_XMIT_CN as packet might have been sent */
+	if (err == NET_XMIT_DROP) {
+		/* SKB completed but not sent */
+		return -EBUSY;
+	}
+
+	return 0;
+}
+
 static int __xsk_generic_xmit(struct sock *sk)
 {
 	struct xdp_sock *xs = xdp_sk(sk);
 	u32 max_batch = TX_BATCH_SIZE;
+	struct sk_buff *pending = NULL;
 	bool sent_frame = false;
 	struct xdp_desc desc;
 	struct sk_buff *skb;
@@ -801,6 +823,19 @@ static int __xsk_generic_xmit(struct sock *sk)
 			goto out;
 		}
 
+		/* Descriptors released after the pending skb must all belong
+		 * to the next complete packet, so that a busy queue can hand
+		 * both back to user-space.  Flush it before a multi-buffer
+		 * packet is started.
+		 */
+		if (pending && !xs->skb && xp_mb_desc(&desc)) {
+			err = xsk_direct_xmit(xs, pending, false);
+			pending = NULL;
+			if (err)
+				goto out;
+			sent_frame = true;
+		}
+
 		/* This is the backpressure mechanism for the Tx path.
 		 * Reserve space in the completion queue and only proceed
 		 * if there is space in it. This avoids having to implement
@@ -827,26 +862,37 @@ static int __xsk_generic_xmit(struct sock *sk)
 			xs->skb = skb;
 			continue;
 		}
+		xs->skb = NULL;
 
-		err = __dev_direct_xmit(skb, xs->queue_id);
-		if  (err == NETDEV_TX_BUSY) {
-			/* Tell user-space to retry the send */
-			xskq_cons_cancel_n(xs->tx, xsk_get_num_desc(skb));
-			xsk_consume_skb(skb);
-			err = -EAGAIN;
-			goto out;
+		/* Hold each packet back until the next one is built, so that
+		 * the driver can batch its doorbell over both.  The last one
+		 * is sent without xmit_more below.
+		 */
+		if (pending) {
+			err = xsk_direct_xmit(xs, pending, true);
+			if (err == -EAGAIN) {
+				/* pending is gone, retry this one after it */
+				xskq_cons_cancel_n(xs->tx, xsk_get_num_desc(skb));
+				xsk_consume_skb(skb);
+				pending = NULL;
+				goto out;
+			}
+			pending = skb;
+			if (err)
+				goto out;
+			sent_frame = true;
+		} else {
+			pending = skb;
 		}
+	}
 
-		/* Ignore NET_XMIT_CN as packet might have been sent */
-		if (err == NET_XMIT_DROP) {
-			/* SKB completed but not sent */
-			err = -EBUSY;
-			xs->skb = NULL;
+	/* Send the last packet before releasing what is left in the ring */
+	if (pending) {
+		err = xsk_direct_xmit(xs, pending, false);
+		pending = NULL;
+		if (err)
 			goto out;
-		}
-
 		sent_frame = true;
-		xs->skb = NULL;
 	}
 
 	if (xskq_has_descs(xs->tx)) {
@@ -856,6 +902,15 @@ static int __xsk_generic_xmit(struct sock *sk)
 	}
 
 out:
+	if (pending) {
+		int ret = xsk_direct_xmit(xs, pending, false);
+
+		if (ret)
+			err = ret;
+		else
+			sent_frame = true;
+	}
+
 	if (sent_frame)
 		if (xsk_tx_writeable(xs))
 			sk->sk_write_space(sk);
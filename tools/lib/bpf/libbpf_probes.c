@@ -346,6 +346,7 @@ static int probe_map_create(enum bpf_map_type map_type)
 		opts.map_flags	= BPF_F_MMAPABLE;
 		break;
 	case BPF_MAP_TYPE_HASH:
+	case BPF_MAP_TYPE_FLAT_HASH:
 	case BPF_MAP_TYPE_ARRAY:
 	case BPF_MAP_TYPE_PROG_ARRAY:
 	case BPF_MAP_TYPE_PERF_EVENT_ARRAY:
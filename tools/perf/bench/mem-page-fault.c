@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * mem-page-fault.c
+ *
+ * page-fault: Benchmark for anonymous page faults
+ *
+ * Each loop maps a fresh anonymous region, writes one byte to each of its
+ * pages and unmaps it again, so every write takes a fault that allocates,
+ * zeroes and maps a page.
+ */
+#include <subcmd/parse-options.h>
+#include "../util/string2.h"
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <linux/time64.h>
+
+static const char	*size_str	= "64MB";
+static int		nr_loops	= 16;
+static bool		use_thp;
+
+static const struct option options[] = {
+	OPT_STRING('s', "size", &size_str, "64MB",
+		    "Specify the size of the region faulted in per loop. "
+		    "Available units: B, KB, MB, GB and TB (case insensitive)"),
+
+	OPT_INTEGER('l', "nr_loops", &nr_loops,
+		    "Specify the number of loops to run. (default: 16)"),
+
+	OPT_BOOLEAN('H', "thp", &use_thp,
+		    "Ask for transparent hugepages with MADV_HUGEPAGE"),
+
+	OPT_END()
+};
+
+static const char * const bench_mem_page_fault_usage[] = {
+	"perf bench mem page-fault <options>",
+	NULL
+};
+
+int bench_mem_page_fault(int argc, const char **argv)
+{
+	struct timeval start, stop, diff, runtime = { 0, 0 };
+	size_t size, page_size = sysconf(_SC_PAGESIZE);
+	unsigned long long nr_faults, result_usec;
+	int i;
+
+	argc = parse_options(argc, argv, options, bench_mem_page_fault_usage, 0);
+
+	size = (size_t)perf_atoll((char *)size_str);
+	if ((s64)size <= 0 || size < page_size) {
+		fprintf(stderr, "Invalid size:%s\n", size_str);
+		return 1;
+	}
+	if (nr_loops <= 0) {
+		fprintf(stderr, "Invalid number of loops:%d\n", nr_loops);
+		return 1;
+	}
+
+	for (i = 0; i < nr_loops; i++) {
+		char *buf, *p;
+
+		buf = mmap(NULL, size, PROT_READ | PROT_WRITE,
+			   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (buf == MAP_FAILED) {
+			printf("# mmap of %s failed - maybe size is too large?\n",
+			       size_str);
+			return 1;
+		}
+		if (use_thp && madvise(buf, size, MADV_HUGEPAGE))
+			fprintf(stderr, "madvise(MADV_HUGEPAGE) failed\n");
+
+		/* only the faults are timed, not the mmap() and munmap() */
+		gettimeofday(&start, NULL);
+		for (p = buf; p < buf + size; p += page_size)
+			*(volatile char *)p = 1;
+		gettimeofday(&stop, NULL);
+
+		timersub(&stop, &start, &diff);
+		timeradd(&runtime, &diff, &runtime);
+		munmap(buf, size);
+	}
+
+	nr_faults = (unsigned long long)(size / page_size) * nr_loops;
+	result_usec = runtime.tv_sec * USEC_PER_SEC + runtime.tv_usec;
+
+	switch (bench_format) {
+	case BENCH_FORMAT_DEFAULT:
+		printf("# Touched %'llu pages in %d loops of %s%s\n\n",
+		       nr_faults, nr_loops, size_str,
+		       use_thp ? " with MADV_HUGEPAGE" : "");
+
+		printf(" %14s: %lu.%03lu [sec]\n\n", "Total time",
+		       (unsigned long) runtime.tv_sec,
+		       (unsigned long) (runtime.tv_usec / USEC_PER_MSEC));
+
+		printf(" %14lf usecs/page\n",
+		       (double)result_usec / (double)nr_faults);
+		printf(" %'14llu pages/sec\n",
+		       result_usec ? nr_faults * USEC_PER_SEC / result_usec : 0);
+		break;
+
+	case BENCH_FORMAT_SIMPLE:
+		printf("%lu.%03lu\n",
+		       (unsigned long) runtime.tv_sec,
+		       (unsigned long) (runtime.tv_usec / USEC_PER_MSEC));
+		break;
+
+	default:
+		/* reaching here is something disaster */
+		fprintf(stderr, "Unknown format:%d\n", bench_format);
+		exit(1);
+		break;
+	}
+
+	return 0;
+}
@@ -18,11 +18,13 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <linux/bpf.h>
+#include <linux/btf.h>
 
 #include <bpf/bpf.h>
 #include <bpf/libbpf.h>
 
 #include "bpf_util.h"
+#include "test_btf.h"
 #include "test_maps.h"
 #include "testing_helpers.h"
 
@@ -354,6 +356,206 @@ static void test_hashmap_zero_seed(void)
 	close(second);
 }
 
+static void test_flat_hashmap(void)
+{
+	long long key, next_key, first_key, value;
+	int fd, i, round, max_entries = 1000;
+	struct bpf_map_create_opts opts = {
+		.sz = sizeof(opts),
+		.map_flags = BPF_F_NO_PREALLOC,
+	};
+
+	/* The table is always preallocated. */
+	fd = bpf_map_create(BPF_MAP_TYPE_FLAT_HASH, NULL, sizeof(key),
+			    sizeof(value), 2, &opts);
+	assert(fd < 0 && errno == EINVAL);
+
+	fd = bpf_map_create(BPF_MAP_TYPE_FLAT_HASH, NULL, sizeof(key),
+			    sizeof(value), 2, NULL);
+	if (fd < 0) {
+		printf("Failed to create flat hashmap '%s'!\n", strerror(errno));
+		exit(1);
+	}
+
+	key = 1;
+	value = 1234;
+	/* Insert key=1 element. */
+	assert(bpf_map_update_elem(fd, &key, &value, BPF_ANY) == 0);
+
+	value = 0;
+	/* key=1 already exists. */
+	assert(bpf_map_update_elem(fd, &key, &value, BPF_NOEXIST) < 0 &&
+	       errno == EEXIST);
+
+	/* -1 is an invalid flag. */
+	assert(bpf_map_update_elem(fd, &key, &value, -1) < 0 &&
+	       errno == EINVAL);
+
+	/* Check that key=1 can be found. */
+	assert(bpf_map_lookup_elem(fd, &key, &value) == 0 && value == 1234);
+
+	/* Values are updated in place. */
+	value = 4321;
+	assert(bpf_map_update_elem(fd, &key, &value, BPF_EXIST) == 0);
+	assert(bpf_map_lookup_elem(fd, &key, &value) == 0 && value == 4321);
+
+	key = 2;
+	value = 1234;
+	/* Insert key=2 element, then delete it. */
+	assert(bpf_map_update_elem(fd, &key, &value, BPF_ANY) == 0);
+	assert(bpf_map_lookup_elem(fd, &key, &value) == 0 && value == 1234);
+	assert(bpf_map_delete_elem(fd, &key) == 0);
+
+	/* Check that key=2 is not found. */
+	assert(bpf_map_lookup_elem(fd, &key, &value) < 0 && errno == ENOENT);
+	assert(bpf_map_delete_elem(fd, &key) < 0 && errno == ENOENT);
+
+	/* key=2 is not there. */
+	assert(bpf_map_update_elem(fd, &key, &value, BPF_EXIST) < 0 &&
+	       errno == ENOENT);
+
+	/* Insert key=2 element. */
+	assert(bpf_map_update_elem(fd, &key, &value, BPF_NOEXIST) == 0);
+
+	/* The map is full, key=0 cannot be inserted... */
+	key = 0;
+	assert(bpf_map_update_elem(fd, &key, &value, BPF_ANY) < 0 &&
+	       errno == E2BIG);
+
+	/* ...but existing elements can still be updated. */
+	key = 1;
+	assert(bpf_map_update_elem(fd, &key, &value, BPF_ANY) == 0);
+
+	/* Iterate over two elements. */
+	assert(bpf_map_get_next_key(fd, NULL, &first_key) == 0 &&
+	       (first_key == 1 || first_key == 2));
+	assert(bpf_map_get_next_key(fd, &first_key, &next_key) == 0 &&
+	       (next_key == 1 || next_key == 2) &&
+	       (next_key != first_key));
+	assert(bpf_map_get_next_key(fd, &next_key, &next_key) < 0 &&
+	       errno == ENOENT);
+
+	/* Delete both elements, check that the map is empty. */
+	key = 1;
+	assert(bpf_map_delete_elem(fd, &key) == 0);
+	key = 2;
+	assert(bpf_map_delete_elem(fd, &key) == 0);
+	assert(bpf_map_get_next_key(fd, NULL, &next_key) < 0 &&
+	       errno == ENOENT);
+
+	close(fd);
+
+	/*
+	 * Fill the map and empty it again with ever new keys, so that
+	 * deleted slots pile up.  Present keys must stay reachable and
+	 * missing ones must keep missing.
+	 */
+	fd = bpf_map_create(BPF_MAP_TYPE_FLAT_HASH, NULL, sizeof(key),
+			    sizeof(value), max_entries, NULL);
+	assert(fd >= 0);
+
+	for (round = 0; round < 16; round++) {
+		for (i = 0; i < max_entries; i++) {
+			key = (long long)round * max_entries + i;
+			value = key;
+			assert(bpf_map_update_elem(fd, &key, &value,
+						   BPF_NOEXIST) == 0);
+		}
+
+		key = -1;
+		assert(bpf_map_update_elem(fd, &key, &value, BPF_NOEXIST) < 0 &&
+		       errno == E2BIG);
+
+		for (i = 0; i < max_entries; i++) {
+			key = (long long)round * max_entries + i;
+			assert(bpf_map_lookup_elem(fd, &key, &value) == 0 &&
+			       value == key);
+		}
+
+		for (i = 0; bpf_map_get_next_key(fd, !i ? NULL : &key,
+						 &next_key) == 0; i++)
+			key = next_key;
+		assert(i == max_entries);
+
+		for (i = 0; i < max_entries; i++) {
+			key = (long long)round * max_entries + i;
+			assert(bpf_map_delete_elem(fd, &key) == 0);
+			assert(bpf_map_lookup_elem(fd, &key, &value) < 0 &&
+			       errno == ENOENT);
+		}
+	}
+
+	assert(bpf_map_get_next_key(fd, NULL, &next_key) < 0 &&
+	       errno == ENOENT);
+	close(fd);
+}
+
+/* struct bpf_spin_lock {
+ *   int val;
+ * };
+ * struct val {
+ *   int cnt;
+ *   struct bpf_spin_lock l;
+ * };
+ */
+static const char flat_hash_btf_str_sec[] = "\0bpf_spin_lock\0val\0cnt\0l";
+static __u32 flat_hash_btf_raw_types[] = {
+	/* int */
+	BTF_TYPE_INT_ENC(0, BTF_INT_SIGNED, 0, 32, 4),  /* [1] */
+	/* struct bpf_spin_lock */                      /* [2] */
+	BTF_TYPE_ENC(1, BTF_INFO_ENC(BTF_KIND_STRUCT, 0, 1), 4),
+	BTF_MEMBER_ENC(15, 1, 0), /* int val; */
+	/* struct val */                                /* [3] */
+	BTF_TYPE_ENC(15, BTF_INFO_ENC(BTF_KIND_STRUCT, 0, 2), 8),
+	BTF_MEMBER_ENC(19, 1, 0), /* int cnt; */
+	BTF_MEMBER_ENC(23, 2, 32),/* struct bpf_spin_lock l; */
+};
+
+static void test_flat_hashmap_btf(void)
+{
+	struct btf_header hdr = {
+		.magic = BTF_MAGIC,
+		.version = BTF_VERSION,
+		.hdr_len = sizeof(struct btf_header),
+		.type_len = sizeof(flat_hash_btf_raw_types),
+		.str_off = sizeof(flat_hash_btf_raw_types),
+		.str_len = sizeof(flat_hash_btf_str_sec),
+	};
+	struct bpf_map_create_opts opts = {
+		.sz = sizeof(opts),
+		.btf_key_type_id = 1,
+		.btf_value_type_id = 3,
+	};
+	char raw_btf[sizeof(hdr) + sizeof(flat_hash_btf_raw_types) +
+		     sizeof(flat_hash_btf_str_sec)];
+	int btf_fd, fd;
+
+	memcpy(raw_btf, &hdr, sizeof(hdr));
+	memcpy(raw_btf + sizeof(hdr), flat_hash_btf_raw_types,
+	       sizeof(flat_hash_btf_raw_types));
+	memcpy(raw_btf + sizeof(hdr) + sizeof(flat_hash_btf_raw_types),
+	       flat_hash_btf_str_sec, sizeof(flat_hash_btf_str_sec));
+
+	btf_fd = bpf_btf_load(raw_btf, sizeof(raw_btf), NULL);
+	if (btf_fd < 0) {
+		printf("Failed to load BTF spec: '%s'\n", strerror(errno));
+		exit(1);
+	}
+	opts.btf_fd = btf_fd;
+
+	/* The value type is fine for a plain hash map... */
+	fd = bpf_map_create(BPF_MAP_TYPE_HASH, NULL, sizeof(int), 8, 1, &opts);
+	assert(fd >= 0);
+	close(fd);
+
+	/* ...but flat hash maps copy values locklessly: no special fields. */
+	fd = bpf_map_create(BPF_MAP_TYPE_FLAT_HASH, NULL, sizeof(int), 8, 1,
+			    &opts);
+	assert(fd < 0 && errno == EOPNOTSUPP);
+
+	close(btf_fd);
+}
+
 static void test_arraymap(unsigned int task, void *data)
 {
 	int key, next_key, fd;
@@ -1927,6 +2129,9 @@ int main(void)
 	map_opts.map_flags = BPF_F_NO_PREALLOC;
 	run_all_tests();
 
+	test_flat_hashmap();
+	test_flat_hashmap_btf();
+
 #define DEFINE_TEST(name) test_##name();
 #include <map_tests/tests.h>
 #undef DEFINE_TEST